@@ -12,6 +12,7 @@ mkdir -p "${BUILD_DIR}/obj"
 ENABLE_RINETD=1
 ENABLE_SQLITE3=1
 ENABLE_MEMKV=1
+ENABLE_DISKV=1
 
 # 添加条件编译宏定义
 if [ "${ENABLE_RINETD}" = "1" ]; then
@@ -26,12 +27,16 @@ if [ "${ENABLE_SQLITE3}" = "1" ]; then
     export CFLAGS="${CFLAGS} -DDEV_SQLITE3"
 fi
 
+if [ "${ENABLE_DISKV}" = "1" ]; then
+    export CFLAGS="${CFLAGS} -DDEV_DISKV"
+fi
+
 # 清理旧的可执行文件
 echo "remove ${BUILD_DIR}/ppdb_latest.exe"
 rm -f "${BUILD_DIR}/ppdb_latest.exe"
 rm -f "${PPDB_DIR}/ppdb_latest.exe"
 
-if [ "${ENABLE_MEMKV}" = "1" ] || [ "${ENABLE_SQLITE3}" = "1" ]; then
+if [ "${ENABLE_MEMKV}" = "1" ] || [ "${ENABLE_SQLITE3}" = "1" ] || [ "${ENABLE_DISKV}" = "1" ]; then
     echo "Building sqlite3..."
     sh "$(dirname "$0")/build_sqlite3.sh"
     if [ $? -ne 0 ]; then
@@ -82,10 +87,20 @@ fi
 
 if [ "${ENABLE_MEMKV}" = "1" ]; then
     SOURCES+=("${SRC_DIR}/internal/peer/peer_memkv.c")
+    SOURCES+=("${SRC_DIR}/internal/peer/peer_memkv_store.c")
+    SOURCES+=("${SRC_DIR}/internal/peer/peer_memkv_slabs.c")
+    SOURCES+=("${SRC_DIR}/internal/peer/peer_memkv_hotkeys.c")
+    SOURCES+=("${SRC_DIR}/internal/peer/peer_memkv_proto.c")
 fi
 
 if [ "${ENABLE_SQLITE3}" = "1" ]; then
     SOURCES+=("${SRC_DIR}/internal/peer/peer_sqlite3.c")
+    SOURCES+=("${SRC_DIR}/internal/peer/peer_sqlite3_proto.c")
+fi
+
+if [ "${ENABLE_DISKV}" = "1" ]; then
+    SOURCES+=("${SRC_DIR}/internal/peer/peer_diskv.c")
+    SOURCES+=("${SRC_DIR}/internal/peer/peer_diskv_resp.c")
 fi
 
 # 然后添加其他源文件
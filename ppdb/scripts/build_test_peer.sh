@@ -0,0 +1,178 @@
+#!/bin/bash
+
+# 记录开始时间
+START_TIME=$(date +%s.%N)
+
+# 设置颜色输出
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+YELLOW='\033[1;33m'
+NC='\033[0m'
+
+# 错误处理函数
+handle_error() {
+    local exit_code=$1
+    local error_message=$2
+    if [ $exit_code -ne 0 ]; then
+        echo -e "${RED}Error: $error_message${NC}"
+        exit $exit_code
+    fi
+}
+
+# 加载环境变量和通用函数
+source "$(dirname "$0")/build_env.sh"
+handle_error $? "Failed to load build environment"
+
+# 依赖 infra 库
+if [ ! -f "${BUILD_DIR}/infra/libinfra.a" ]; then
+    echo -e "${YELLOW}libinfra.a not found, building infra...${NC}"
+    sh "$(dirname "$0")/build_infra.sh"
+    handle_error $? "Failed to build infra"
+fi
+
+# 创建构建目录
+PEER_TEST_DIR="${BUILD_DIR}/test/peer"
+mkdir -p "${PEER_TEST_DIR}"
+handle_error $? "Failed to create test/peer directory"
+
+INCLUDES="-I${PPDB_DIR} -I${PPDB_DIR}/include -I${PPDB_DIR}/src"
+
+# 编译 memkv 协议解析器
+echo -e "${GREEN}Building memkv protocol parser...${NC}"
+${CC} ${CFLAGS} ${INCLUDES} \
+    -c "${PPDB_DIR}/src/internal/peer/peer_memkv_proto.c" \
+    -o "${PEER_TEST_DIR}/peer_memkv_proto.o"
+handle_error $? "Failed to compile peer_memkv_proto"
+
+# 编译 memkv 原生存储
+echo -e "${GREEN}Building memkv store...${NC}"
+for src in peer_memkv_store peer_memkv_slabs peer_memkv_hotkeys; do
+    ${CC} ${CFLAGS} ${INCLUDES} \
+        -c "${PPDB_DIR}/src/internal/peer/${src}.c" \
+        -o "${PEER_TEST_DIR}/${src}.o"
+    handle_error $? "Failed to compile ${src}"
+done
+
+# 编译 diskv 协议解析器
+echo -e "${GREEN}Building diskv RESP parser...${NC}"
+${CC} ${CFLAGS} ${INCLUDES} \
+    -c "${PPDB_DIR}/src/internal/peer/peer_diskv_resp.c" \
+    -o "${PEER_TEST_DIR}/peer_diskv_resp.o"
+handle_error $? "Failed to compile peer_diskv_resp"
+
+# 编译 sqlite3 服务协议编解码
+echo -e "${GREEN}Building sqlite3 protocol codec...${NC}"
+${CC} ${CFLAGS} ${INCLUDES} \
+    -c "${PPDB_DIR}/src/internal/peer/peer_sqlite3_proto.c" \
+    -o "${PEER_TEST_DIR}/peer_sqlite3_proto.o"
+handle_error $? "Failed to compile peer_sqlite3_proto"
+
+# 编译测试框架
+${CC} ${CFLAGS} ${INCLUDES} \
+    -c "${PPDB_DIR}/test/white/framework/test_framework.c" \
+    -o "${PEER_TEST_DIR}/test_framework.o"
+handle_error $? "Failed to compile test framework"
+
+# 编译并链接协议测试
+echo -e "${GREEN}Building memkv protocol test...${NC}"
+${CC} ${CFLAGS} ${INCLUDES} \
+    -o "${PEER_TEST_DIR}/test_memkv_proto" \
+    "${PPDB_DIR}/test/peer/test_memkv_proto.c" \
+    "${PEER_TEST_DIR}/peer_memkv_proto.o" \
+    "${PEER_TEST_DIR}/test_framework.o" \
+    "${BUILD_DIR}/infra/libinfra.a" \
+    ${LDFLAGS}
+handle_error $? "Failed to link memkv protocol test"
+
+# 编译并链接存储测试
+echo -e "${GREEN}Building memkv store test...${NC}"
+${CC} ${CFLAGS} ${INCLUDES} \
+    -o "${PEER_TEST_DIR}/test_memkv_store" \
+    "${PPDB_DIR}/test/peer/test_memkv_store.c" \
+    "${PEER_TEST_DIR}/peer_memkv_store.o" \
+    "${PEER_TEST_DIR}/peer_memkv_slabs.o" \
+    "${PEER_TEST_DIR}/test_framework.o" \
+    "${BUILD_DIR}/infra/libinfra.a" \
+    ${LDFLAGS}
+handle_error $? "Failed to link memkv store test"
+
+# 编译并链接热点 key 测试
+echo -e "${GREEN}Building memkv hotkeys test...${NC}"
+${CC} ${CFLAGS} ${INCLUDES} \
+    -o "${PEER_TEST_DIR}/test_memkv_hotkeys" \
+    "${PPDB_DIR}/test/peer/test_memkv_hotkeys.c" \
+    "${PEER_TEST_DIR}/peer_memkv_hotkeys.o" \
+    "${PEER_TEST_DIR}/peer_memkv_store.o" \
+    "${PEER_TEST_DIR}/peer_memkv_slabs.o" \
+    "${PEER_TEST_DIR}/test_framework.o" \
+    "${BUILD_DIR}/infra/libinfra.a" \
+    ${LDFLAGS}
+handle_error $? "Failed to link memkv hotkeys test"
+
+# 编译并链接 diskv 协议测试
+echo -e "${GREEN}Building diskv RESP test...${NC}"
+${CC} ${CFLAGS} ${INCLUDES} \
+    -o "${PEER_TEST_DIR}/test_diskv_resp" \
+    "${PPDB_DIR}/test/peer/test_diskv_resp.c" \
+    "${PEER_TEST_DIR}/peer_diskv_resp.o" \
+    "${PEER_TEST_DIR}/test_framework.o" \
+    "${BUILD_DIR}/infra/libinfra.a" \
+    ${LDFLAGS}
+handle_error $? "Failed to link diskv RESP test"
+
+# 编译并链接 sqlite3 协议测试
+echo -e "${GREEN}Building sqlite3 protocol test...${NC}"
+${CC} ${CFLAGS} ${INCLUDES} \
+    -o "${PEER_TEST_DIR}/test_sqlite3_proto" \
+    "${PPDB_DIR}/test/peer/test_sqlite3_proto.c" \
+    "${PEER_TEST_DIR}/peer_sqlite3_proto.o" \
+    "${PEER_TEST_DIR}/test_framework.o" \
+    "${BUILD_DIR}/infra/libinfra.a" \
+    ${LDFLAGS}
+handle_error $? "Failed to link sqlite3 protocol test"
+
+# 编译并链接协议解析基准
+echo -e "${GREEN}Building memkv protocol benchmark...${NC}"
+${CC} ${CFLAGS} ${INCLUDES} \
+    -o "${PEER_TEST_DIR}/bench_memkv_proto" \
+    "${PPDB_DIR}/test/peer/bench_memkv_proto.c" \
+    "${PEER_TEST_DIR}/peer_memkv_proto.o" \
+    "${BUILD_DIR}/infra/libinfra.a" \
+    ${LDFLAGS}
+handle_error $? "Failed to link memkv protocol benchmark"
+
+# 运行测试
+echo -e "${GREEN}Running memkv protocol tests...${NC}"
+"${PEER_TEST_DIR}/test_memkv_proto"
+handle_error $? "memkv protocol tests failed"
+
+echo -e "${GREEN}Running memkv store tests...${NC}"
+"${PEER_TEST_DIR}/test_memkv_store"
+handle_error $? "memkv store tests failed"
+
+echo -e "${GREEN}Running memkv hotkeys tests...${NC}"
+"${PEER_TEST_DIR}/test_memkv_hotkeys"
+handle_error $? "memkv hotkeys tests failed"
+
+echo -e "${GREEN}Running diskv RESP tests...${NC}"
+"${PEER_TEST_DIR}/test_diskv_resp"
+handle_error $? "diskv RESP tests failed"
+
+echo -e "${GREEN}Running sqlite3 protocol tests...${NC}"
+"${PEER_TEST_DIR}/test_sqlite3_proto"
+handle_error $? "sqlite3 protocol tests failed"
+
+# 运行基准 (传入 bench 参数时)
+if [ "$1" = "bench" ]; then
+    shift
+    echo -e "${GREEN}Running memkv protocol benchmark...${NC}"
+    "${PEER_TEST_DIR}/bench_memkv_proto" "$@"
+    handle_error $? "memkv protocol benchmark failed"
+fi
+
+# 计算并显示总耗时
+END_TIME=$(date +%s.%N)
+DURATION=$(echo "$END_TIME - $START_TIME" | bc)
+echo -e "${GREEN}All tests completed successfully in ${DURATION} seconds.${NC}"
+
+exit 0
@@ -250,11 +250,37 @@ ${CC} ${CFLAGS} \
     ${LDFLAGS}
 handle_error $? "Failed to link poly_db test"
 
+# 编译并链接批量导入基准
+echo -e "${GREEN}Building poly_db bulk benchmark...${NC}"
+${CC} ${CFLAGS} \
+    -I"${PPDB_DIR}" \
+    -I"${PPDB_DIR}/include" \
+    -I"${PPDB_DIR}/src" \
+    -o "${BUILD_DIR}/test/black/poly/bench_poly_db_bulk" \
+    "${PPDB_DIR}/test/poly/bench_poly_db_bulk.c" \
+    "${BUILD_DIR}/test/black/poly/poly_db.o" \
+    "${BUILD_DIR}/test/black/poly/infra_memory.o" \
+    "${BUILD_DIR}/test/black/poly/infra_sync.o" \
+    "${BUILD_DIR}/test/black/poly/infra_platform.o" \
+    "${BUILD_DIR}/infra/libinfra.a" \
+    "${BUILD_DIR}/vendor/sqlite3/sqlite3.o" \
+    -ldl -lpthread -lm \
+    ${LDFLAGS}
+handle_error $? "Failed to link poly_db bulk benchmark"
+
 # 运行测试
 echo -e "${GREEN}Running poly_db tests...${NC}"
 "$TEST_DB_BIN"
 handle_error $? "poly_db tests failed"
 
+# 运行基准 (传入 bench 参数时)
+if [ "$1" = "bench" ]; then
+    shift
+    echo -e "${GREEN}Running poly_db bulk benchmark...${NC}"
+    "${BUILD_DIR}/test/black/poly/bench_poly_db_bulk" "$@"
+    handle_error $? "poly_db bulk benchmark failed"
+fi
+
 # 计算并显示总耗时
 END_TIME=$(date +%s.%N)
 DURATION=$(echo "$END_TIME - $START_TIME" | bc)
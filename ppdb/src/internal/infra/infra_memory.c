@@ -402,22 +402,19 @@ void* infra_realloc(void* ptr, size_t size) {
     }
 
     infra_mutex_lock(g_memory.mutex);
-    void* new_ptr = allocate_memory(size);
-    if (new_ptr) {
-        // Get original block size
-        size_t old_size;
-        if (g_memory.config.use_memory_pool) {
+    void* new_ptr = NULL;
+    if (g_memory.config.use_memory_pool) {
+        new_ptr = allocate_memory(size);
+        if (new_ptr) {
+            // Copy up to the original block size
             memory_block_t* block = get_block_header(ptr);
-            old_size = block->size;
-        } else {
-            // For system allocator, we can't get original size
-            // Use new size as copy size
-            old_size = size;
+            size_t old_size = block->size;
+            memcpy(new_ptr, ptr, (old_size < size) ? old_size : size);
+            free_memory(ptr);
         }
-
-        // Copy data
-        memcpy(new_ptr, ptr, (old_size < size) ? old_size : size);
-        free_memory(ptr);
+    } else {
+        // System allocator doesn't expose the original size, let realloc copy
+        new_ptr = realloc(ptr, size);
     }
     infra_mutex_unlock(g_memory.mutex);
 
@@ -162,6 +162,33 @@ infra_error_t infra_net_send(infra_socket_t sock, const void* data, size_t size,
     return INFRA_OK;
 }
 
+infra_error_t infra_net_sendv(infra_socket_t sock, const struct iovec* iov, int iovcnt, size_t* sent) {
+    if (sock < 0 || !iov || iovcnt <= 0 || !sent) {
+        return INFRA_ERROR_INVALID_PARAM;
+    }
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = (struct iovec*)iov;
+    msg.msg_iovlen = iovcnt;
+
+    ssize_t ret;
+    do {
+        ret = sendmsg(sock, &msg, MSG_NOSIGNAL);
+    } while (ret < 0 && errno == EINTR);
+
+    if (ret < 0) {
+        *sent = 0;
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return INFRA_ERROR_WOULD_BLOCK;
+        }
+        return INFRA_ERROR_IO;
+    }
+
+    *sent = (size_t)ret;
+    return INFRA_OK;
+}
+
 infra_error_t infra_net_recv(infra_socket_t sock, void* buffer, size_t size, size_t* received) {
     if (sock < 0 || !buffer || !received) {
         return INFRA_ERROR_INVALID_PARAM;
@@ -16,6 +16,9 @@
 // 套接字句柄
 typedef intptr_t infra_socket_t;
 
+// 聚集 I/O 向量 (系统 struct iovec)
+struct iovec;
+
 // 网络地址
 typedef struct {
     char ip[64];
@@ -55,6 +58,9 @@ infra_error_t infra_net_connect(const infra_net_addr_t* addr, infra_socket_t* so
 // 发送数据
 infra_error_t infra_net_send(infra_socket_t sock, const void* data, size_t size, size_t* sent);
 
+// 聚集发送 (writev), 非阻塞套接字缓冲区满时返回 INFRA_ERROR_WOULD_BLOCK
+infra_error_t infra_net_sendv(infra_socket_t sock, const struct iovec* iov, int iovcnt, size_t* sent);
+
 // 接收数据
 infra_error_t infra_net_recv(infra_socket_t sock, void* buffer, size_t size, size_t* received);
 
@@ -59,8 +59,13 @@ static void* worker_thread(void* arg) {
         // Get task
         infra_mutex_lock(pool->mutex);
         
-        while (pool->task_head == NULL && !pool->shutting_down) {
+        while (pool->task_head == NULL && !pool->shutting_down && pool->running) {
             // Wait for task or shutdown signal
+            // idle_timeout 为 0 表示空闲线程不退出, 一直阻塞等待, 不能按 0 超时空转
+            if (pool->idle_timeout == 0) {
+                infra_cond_wait(pool->not_empty, pool->mutex);
+                continue;
+            }
             infra_error_t err = infra_cond_timedwait(pool->not_empty, pool->mutex, pool->idle_timeout);
             if (err == INFRA_ERROR_TIMEOUT) {
                 // Timeout, exit if over minimum threads
@@ -176,8 +181,10 @@ infra_error_t infra_thread_pool_create(const infra_thread_pool_config_t* config,
         err = infra_thread_create(&p->threads[i], worker_thread, p);
         if (err != INFRA_OK) {
             // Clean up on error
+            infra_mutex_lock(p->mutex);
             p->running = false;
             infra_cond_broadcast(p->not_empty);
+            infra_mutex_unlock(p->mutex);
             for (size_t j = 0; j < i; j++) {
                 infra_thread_join(p->threads[j]);
             }
@@ -268,9 +275,10 @@ infra_error_t infra_thread_pool_submit(infra_thread_pool_t* pool, infra_thread_f
     // Signal waiting thread
     infra_cond_signal(pool->not_empty);
 
-    // Create new thread if needed
-    if (pool->thread_count < pool->max_threads && 
-        pool->task_count > pool->thread_count) {
+    // Create new thread if needed: 排队的任务多于空闲线程时才扩充,
+    // 长时间运行的任务 (例如每个连接一个任务) 占住的线程不算空闲
+    if (pool->thread_count < pool->max_threads &&
+        pool->task_count > pool->thread_count - pool->active_count) {
         infra_thread_t thread;
         infra_error_t err = infra_thread_create(&thread, worker_thread, pool);
         if (err == INFRA_OK) {
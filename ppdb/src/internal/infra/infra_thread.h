@@ -30,7 +30,7 @@ typedef struct {
     size_t min_threads;     // Minimum number of threads
     size_t max_threads;     // Maximum number of threads
     size_t queue_size;      // Task queue size
-    uint32_t idle_timeout;  // Idle thread timeout (ms)
+    uint32_t idle_timeout;  // Idle thread timeout (ms), 0 = idle threads block until work arrives
 } infra_thread_pool_config_t;
 
 // Thread pool handle
@@ -0,0 +1,2341 @@
+#include "internal/infra/infra_core.h"
+#include "internal/infra/infra_error.h"
+#include "internal/infra/infra_net.h"
+#include "internal/infra/infra_sync.h"
+#include "internal/infra/infra_log.h"
+#include "internal/infra/infra_thread.h"
+#include "internal/infra/infra_platform.h"
+#include "internal/poly/poly_db.h"
+#include "internal/poly/poly_poll.h"
+#include "internal/poly/poly_cmdline.h"
+#include "internal/peer/peer_service.h"
+#include "internal/peer/peer_diskv.h"
+#include "internal/peer/peer_diskv_resp.h"
+#include <netinet/tcp.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <stdarg.h>
+
+//-----------------------------------------------------------------------------
+// Constants
+//-----------------------------------------------------------------------------
+
+#define DISKV_VERSION "1.0.0"
+#define DISKV_DEFAULT_PORT 6379
+#define DISKV_MAX_THREADS 32
+
+#define DISKV_REACTOR_MAX_EVENTS 256
+#define DISKV_REACTOR_TICK_MS 1000
+
+static const char* const ERR_WRONGTYPE =
+    "WRONGTYPE Operation against a key holding the wrong kind of value";
+static const char* const ERR_NOT_INTEGER = "ERR value is not an integer or out of range";
+static const char* const ERR_SYNTAX = "ERR syntax error";
+static const char* const ERR_STORAGE = "ERR storage error";
+static const char* const ERR_ROLLED_BACK = "ERR storage commit failed, command rolled back";
+
+//-----------------------------------------------------------------------------
+// Forward Declarations
+//-----------------------------------------------------------------------------
+
+static void diskv_conn_destroy(diskv_conn_t* conn);
+static void handle_accept(void* args);
+
+//-----------------------------------------------------------------------------
+// Global Variables
+//-----------------------------------------------------------------------------
+
+// Global service instance
+peer_service_t g_diskv_service = {
+    .config = {
+        .name = "diskv",
+        .user_data = NULL
+    },
+    .state = PEER_SERVICE_STATE_INIT,
+    .init = diskv_init,
+    .cleanup = diskv_cleanup,
+    .start = diskv_start,
+    .stop = diskv_stop,
+    .cmd_handler = diskv_cmd_handler,
+    .apply_config = diskv_apply_config
+};
+
+// 获取服务状态的辅助函数
+static inline diskv_state_t* get_state(void) {
+    return (diskv_state_t*)g_diskv_service.config.user_data;
+}
+
+static const char* engine_name(diskv_engine_t engine) {
+    switch (engine) {
+        case DISKV_ENGINE_SQLITE: return "sqlite";
+        default: return "unknown";
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Database
+//-----------------------------------------------------------------------------
+
+// 每个 key 一行, 记录类型和过期时间 (毫秒时间戳, 0 表示不过期);
+// string 的 value 存在本行, hash 和 list 的元素各自一张表.
+// list 的元素按 seq 连续编号, 范围为 [lhead, ltail)
+static const char* const DISKV_SCHEMA =
+    "CREATE TABLE IF NOT EXISTS diskv_keys ("
+    "  key BLOB PRIMARY KEY,"
+    "  type INTEGER NOT NULL,"
+    "  value BLOB,"
+    "  expiry INTEGER NOT NULL DEFAULT 0,"
+    "  lhead INTEGER NOT NULL DEFAULT 0,"
+    "  ltail INTEGER NOT NULL DEFAULT 0"
+    ");"
+    "CREATE INDEX IF NOT EXISTS diskv_keys_expiry ON diskv_keys(expiry) WHERE expiry > 0;"
+    "CREATE TABLE IF NOT EXISTS diskv_hash ("
+    "  key BLOB NOT NULL,"
+    "  field BLOB NOT NULL,"
+    "  value BLOB,"
+    "  PRIMARY KEY (key, field)"
+    ") WITHOUT ROWID;"
+    "CREATE TABLE IF NOT EXISTS diskv_list ("
+    "  key BLOB NOT NULL,"
+    "  seq INTEGER NOT NULL,"
+    "  value BLOB,"
+    "  PRIMARY KEY (key, seq)"
+    ") WITHOUT ROWID;";
+
+static const char* const KEY_SQL_META =
+    "SELECT type, expiry, lhead, ltail FROM diskv_keys WHERE key = ?1";
+static const char* const KEY_SQL_GET =
+    "SELECT type, expiry, value FROM diskv_keys WHERE key = ?1";
+static const char* const KEY_SQL_DELETE = "DELETE FROM diskv_keys WHERE key = ?1";
+static const char* const KEY_SQL_EXPIRE = "UPDATE diskv_keys SET expiry = ?2 WHERE key = ?1";
+static const char* const STR_SQL_SET =
+    "INSERT OR REPLACE INTO diskv_keys (key, type, value, expiry) VALUES (?1, 0, ?2, ?3)";
+static const char* const STR_SQL_UPDATE = "UPDATE diskv_keys SET value = ?2 WHERE key = ?1";
+static const char* const HASH_SQL_CREATE =
+    "INSERT INTO diskv_keys (key, type) VALUES (?1, 1)";
+static const char* const HASH_SQL_GET =
+    "SELECT k.type, k.expiry, h.field IS NOT NULL, h.value FROM diskv_keys k "
+    "LEFT JOIN diskv_hash h ON h.key = k.key AND h.field = ?2 WHERE k.key = ?1";
+static const char* const HASH_SQL_UPDATE =
+    "UPDATE diskv_hash SET value = ?3 WHERE key = ?1 AND field = ?2";
+static const char* const HASH_SQL_INSERT =
+    "INSERT INTO diskv_hash (key, field, value) VALUES (?1, ?2, ?3)";
+static const char* const HASH_SQL_DELETE = "DELETE FROM diskv_hash WHERE key = ?1";
+static const char* const LIST_SQL_CREATE =
+    "INSERT INTO diskv_keys (key, type) VALUES (?1, 2)";
+static const char* const LIST_SQL_BOUNDS =
+    "UPDATE diskv_keys SET lhead = ?2, ltail = ?3 WHERE key = ?1";
+static const char* const LIST_SQL_INSERT =
+    "INSERT INTO diskv_list (key, seq, value) VALUES (?1, ?2, ?3)";
+static const char* const LIST_SQL_RANGE =
+    "SELECT seq, value FROM diskv_list WHERE key = ?1 AND seq BETWEEN ?2 AND ?3 ORDER BY seq";
+static const char* const LIST_SQL_DELETE = "DELETE FROM diskv_list WHERE key = ?1";
+
+// 过期回收: 同一事务内三条语句选中的是同一批 key
+#define DISKV_EXPIRED_KEYS \
+    "(SELECT key FROM diskv_keys WHERE expiry > 0 AND expiry <= ?1 ORDER BY expiry LIMIT ?2)"
+static const char* const EXPIRE_SQL_HASH = "DELETE FROM diskv_hash WHERE key IN " DISKV_EXPIRED_KEYS;
+static const char* const EXPIRE_SQL_LIST = "DELETE FROM diskv_list WHERE key IN " DISKV_EXPIRED_KEYS;
+static const char* const EXPIRE_SQL_KEYS = "DELETE FROM diskv_keys WHERE key IN " DISKV_EXPIRED_KEYS;
+
+// key 的元数据
+typedef struct diskv_meta {
+    diskv_type_t type;
+    int64_t expiry;
+    int64_t head;                // list: 第一个元素的 seq
+    int64_t tail;                // list: 最后一个元素的 seq + 1
+} diskv_meta_t;
+
+static infra_error_t db_open(poly_db_t** db, const char* path) {
+    INFRA_LOG_INFO("Opening database: %s", path);
+
+    poly_db_config_t config = {
+        .type = POLY_DB_TYPE_SQLITE,
+        .url = path,
+        .max_memory = 0,  // 不限制内存
+        .read_only = false,
+        .plugin_path = NULL,
+        .allow_fallback = false
+    };
+
+    infra_error_t err = poly_db_open(&config, db);
+    if (err != INFRA_OK) {
+        INFRA_LOG_ERROR("Failed to open database: %d", err);
+        return err;
+    }
+
+    // WAL 和 synchronous=FULL 由组提交的 writer 设置 (durable), 提交返回时日志已落盘
+    err = poly_db_exec(*db, DISKV_SCHEMA);
+    if (err != INFRA_OK) {
+        INFRA_LOG_ERROR("Failed to initialize database: %d", err);
+        poly_db_close(*db);
+        *db = NULL;
+        return err;
+    }
+
+    INFRA_LOG_INFO("Database connection established");
+    return INFRA_OK;
+}
+
+// poly_db 没有整数绑定, 数值按文本绑定, 由列的 INTEGER 亲和性转换.
+// buf 至少 24 字节, 在 step 之前保持有效
+static infra_error_t bind_i64(poly_db_stmt_t* stmt, int index, int64_t value, char* buf) {
+    int len = snprintf(buf, 24, "%lld", (long long)value);
+    return poly_db_bind_text(stmt, index, buf, (size_t)len);
+}
+
+// 取整数列, NULL (包括没有结果行) 时返回 false
+static bool column_i64(poly_db_stmt_t* stmt, int col, int64_t* value) {
+    char* text = NULL;
+    if (poly_db_column_text(stmt, col, &text) != INFRA_OK) {
+        return false;
+    }
+    *value = strtoll(text, NULL, 10);
+    infra_free(text);
+    return true;
+}
+
+// 准备语句并把 key 绑定为 ?1
+static infra_error_t db_prepare_key(poly_db_t* db, const char* sql, diskv_span_t key,
+                                    poly_db_stmt_t** stmt) {
+    infra_error_t err = poly_db_prepare(db, sql, stmt);
+    if (err != INFRA_OK) {
+        return err;
+    }
+    err = poly_db_bind_blob(*stmt, 1, key.ptr, key.len);
+    if (err != INFRA_OK) {
+        poly_db_stmt_finalize(*stmt);
+    }
+    return err;
+}
+
+// 只以 key 为参数的写语句
+static infra_error_t db_exec_key(poly_db_t* db, const char* sql, diskv_span_t key) {
+    poly_db_stmt_t* stmt = NULL;
+    infra_error_t err = db_prepare_key(db, sql, key, &stmt);
+    if (err != INFRA_OK) {
+        return err;
+    }
+    err = poly_db_stmt_step(stmt);
+    poly_db_stmt_finalize(stmt);
+    return err;
+}
+
+// 读取 key 的元数据. 不存在或已过期返回 INFRA_ERROR_NOT_FOUND;
+// 已过期时 *stale 为 true, 行还在, 写入前要先清除
+static infra_error_t key_lookup(poly_db_t* db, diskv_span_t key, int64_t now,
+                                diskv_meta_t* meta, bool* stale) {
+    *stale = false;
+    poly_db_stmt_t* stmt = NULL;
+    infra_error_t err = db_prepare_key(db, KEY_SQL_META, key, &stmt);
+    if (err != INFRA_OK) {
+        return err;
+    }
+    err = poly_db_stmt_step(stmt);
+    if (err != INFRA_OK) {
+        poly_db_stmt_finalize(stmt);
+        return err;
+    }
+
+    int64_t type = 0;
+    if (!column_i64(stmt, 0, &type)) {
+        poly_db_stmt_finalize(stmt);
+        return INFRA_ERROR_NOT_FOUND;
+    }
+    meta->type = (diskv_type_t)type;
+    meta->expiry = 0;
+    meta->head = 0;
+    meta->tail = 0;
+    column_i64(stmt, 1, &meta->expiry);
+    column_i64(stmt, 2, &meta->head);
+    column_i64(stmt, 3, &meta->tail);
+    poly_db_stmt_finalize(stmt);
+
+    if (meta->expiry > 0 && meta->expiry <= now) {
+        *stale = true;
+        return INFRA_ERROR_NOT_FOUND;
+    }
+    return INFRA_OK;
+}
+
+// 删除 key 及其 hash/list 元素
+static infra_error_t key_purge(poly_db_t* db, diskv_span_t key, diskv_type_t type) {
+    infra_error_t err = INFRA_OK;
+    if (type == DISKV_TYPE_HASH) {
+        err = db_exec_key(db, HASH_SQL_DELETE, key);
+    } else if (type == DISKV_TYPE_LIST) {
+        err = db_exec_key(db, LIST_SQL_DELETE, key);
+    }
+    if (err == INFRA_OK) {
+        err = db_exec_key(db, KEY_SQL_DELETE, key);
+    }
+    return err;
+}
+
+// 写 hash/list 之前: 清除已过期的旧值, 已存在时检查类型.
+// 成功时 *exists 表示 key 仍然存在 (meta 有效)
+static infra_error_t key_for_write(poly_db_t* db, diskv_span_t key, diskv_type_t type, int64_t now,
+                                   diskv_meta_t* meta, bool* exists) {
+    bool stale = false;
+    infra_error_t err = key_lookup(db, key, now, meta, &stale);
+    *exists = err == INFRA_OK;
+    if (err == INFRA_ERROR_NOT_FOUND) {
+        return stale ? key_purge(db, key, meta->type) : INFRA_OK;
+    }
+    if (err == INFRA_OK && meta->type != type) {
+        return INFRA_ERROR_INVALID_TYPE;
+    }
+    return err;
+}
+
+// 执行 KEY_SQL_GET, 命中 string 时 *stmt 停在结果行上 (value 为第 2 列), 由调用者 finalize.
+// 不存在或已过期返回 INFRA_ERROR_NOT_FOUND, *stale 同 key_lookup
+static infra_error_t string_fetch(poly_db_t* db, diskv_span_t key, int64_t now,
+                                  poly_db_stmt_t** stmt, bool* stale) {
+    *stale = false;
+    infra_error_t err = db_prepare_key(db, KEY_SQL_GET, key, stmt);
+    if (err != INFRA_OK) {
+        return err;
+    }
+    err = poly_db_stmt_step(*stmt);
+
+    int64_t type = 0;
+    int64_t expiry = 0;
+    if (err == INFRA_OK && !column_i64(*stmt, 0, &type)) {
+        err = INFRA_ERROR_NOT_FOUND;
+    } else if (err == INFRA_OK) {
+        column_i64(*stmt, 1, &expiry);
+        if (expiry > 0 && expiry <= now) {
+            *stale = true;
+            err = INFRA_ERROR_NOT_FOUND;
+        } else if (type != DISKV_TYPE_STRING) {
+            err = INFRA_ERROR_INVALID_TYPE;
+        }
+    }
+    if (err != INFRA_OK) {
+        poly_db_stmt_finalize(*stmt);
+        *stmt = NULL;
+    }
+    return err;
+}
+
+// 写入 string, 替换同名 key 的旧值 (调用者已清除其他类型的元素)
+static infra_error_t string_set(poly_db_t* db, diskv_span_t key, diskv_span_t value, int64_t expiry) {
+    poly_db_stmt_t* stmt = NULL;
+    infra_error_t err = db_prepare_key(db, STR_SQL_SET, key, &stmt);
+    if (err != INFRA_OK) {
+        return err;
+    }
+    char num[24];
+    // 空 value 也要绑定为零长度 BLOB 而不是 NULL
+    err = poly_db_bind_blob(stmt, 2, value.ptr ? value.ptr : "", value.len);
+    if (err == INFRA_OK) {
+        err = bind_i64(stmt, 3, expiry, num);
+    }
+    if (err == INFRA_OK) {
+        err = poly_db_stmt_step(stmt);
+    }
+    poly_db_stmt_finalize(stmt);
+    return err;
+}
+
+//-----------------------------------------------------------------------------
+// Output
+//-----------------------------------------------------------------------------
+
+// 在 out_buf 末尾预留 len 字节, 由调用者写入后增加 out_len
+static char* conn_out_reserve(diskv_conn_t* conn, size_t len) {
+    if (conn->out_len + len > conn->out_cap) {
+        size_t cap = conn->out_cap ? conn->out_cap : DISKV_CONN_OUT_INIT;
+        while (cap < conn->out_len + len) {
+            cap *= 2;
+        }
+        char* buf = infra_realloc(conn->out_buf, cap);
+        if (!buf) {
+            conn->should_close = true;
+            return NULL;
+        }
+        conn->out_buf = buf;
+        conn->out_cap = cap;
+    }
+    return conn->out_buf + conn->out_len;
+}
+
+static void conn_out_raw(diskv_conn_t* conn, const char* data, size_t len) {
+    char* dst = conn_out_reserve(conn, len);
+    if (dst) {
+        memcpy(dst, data, len);
+        conn->out_len += len;
+    }
+}
+
+static void conn_out_header(diskv_conn_t* conn, char type, int64_t n) {
+    char* dst = conn_out_reserve(conn, 32);
+    if (dst) {
+        conn->out_len += diskv_resp_header(dst, type, n);
+    }
+}
+
+static void conn_out_status(diskv_conn_t* conn, const char* status) {
+    conn_out_raw(conn, "+", 1);
+    conn_out_raw(conn, status, strlen(status));
+    conn_out_raw(conn, "\r\n", 2);
+}
+
+// 错误响应, msg 以错误码开头 (ERR, WRONGTYPE 等)
+static void conn_out_error(diskv_conn_t* conn, const char* fmt, ...) {
+    char* dst = conn_out_reserve(conn, 512);
+    if (!dst) {
+        return;
+    }
+    dst[0] = '-';
+    va_list args;
+    va_start(args, fmt);
+    int len = vsnprintf(dst + 1, 509, fmt, args);
+    va_end(args);
+    if (len < 0) {
+        len = 0;
+    } else if (len > 508) {
+        len = 508;
+    }
+    // 错误信息中不能有换行
+    for (int i = 1; i <= len; i++) {
+        if (dst[i] == '\r' || dst[i] == '\n') {
+            dst[i] = ' ';
+        }
+    }
+    dst[len + 1] = '\r';
+    dst[len + 2] = '\n';
+    conn->out_len += (size_t)len + 3;
+}
+
+static void conn_out_int(diskv_conn_t* conn, int64_t value) {
+    conn_out_header(conn, ':', value);
+}
+
+static void conn_out_bulk(diskv_conn_t* conn, const char* data, size_t len) {
+    conn_out_header(conn, '$', (int64_t)len);
+    conn_out_raw(conn, data, len);
+    conn_out_raw(conn, "\r\n", 2);
+}
+
+static void conn_out_bulk_cstr(diskv_conn_t* conn, const char* str) {
+    conn_out_bulk(conn, str, strlen(str));
+}
+
+static void conn_out_null(diskv_conn_t* conn) {
+    if (conn->proto >= 3) {
+        conn_out_raw(conn, "_\r\n", 3);
+    } else {
+        conn_out_raw(conn, "$-1\r\n", 5);
+    }
+}
+
+// RESP3 的 map, RESP2 下展开为 2n 个元素的数组
+static void conn_out_map(diskv_conn_t* conn, int64_t pairs) {
+    if (conn->proto >= 3) {
+        conn_out_header(conn, '%', pairs);
+    } else {
+        conn_out_header(conn, '*', pairs * 2);
+    }
+}
+
+// 把结果列的 BLOB 直接分块读入输出缓冲区, 作为 bulk string 输出
+static infra_error_t conn_out_column(diskv_conn_t* conn, poly_db_stmt_t* stmt, int col) {
+    size_t size = 0;
+    infra_error_t err = poly_db_column_blob_size(stmt, col, &size);
+    if (err != INFRA_OK) {
+        return err;
+    }
+
+    size_t mark = conn->out_len;
+    conn_out_header(conn, '$', (int64_t)size);
+    char* dst = conn_out_reserve(conn, size + 2);
+    if (!dst) {
+        return INFRA_ERROR_NO_MEMORY;
+    }
+
+    size_t offset = 0;
+    while (offset < size) {
+        size_t n = 0;
+        err = poly_db_column_blob_chunk(stmt, col, dst + offset, size - offset, offset, &n);
+        if (err != INFRA_OK || n == 0) {
+            // 撤销写了一半的响应
+            conn->out_len = mark;
+            return err != INFRA_OK ? err : INFRA_ERROR_IO;
+        }
+        offset += n;
+    }
+    dst[size] = '\r';
+    dst[size + 1] = '\n';
+    conn->out_len += size + 2;
+    return INFRA_OK;
+}
+
+// 尽量发送待发送的响应, 全部发完返回 INFRA_OK, 套接字写满返回 INFRA_ERROR_WOULD_BLOCK
+static infra_error_t conn_flush(diskv_conn_t* conn) {
+    while (conn->out_sent < conn->out_len) {
+        // infra_net_send 不区分套接字写满, 用 sendv 得到 INFRA_ERROR_WOULD_BLOCK
+        struct iovec iov = {conn->out_buf + conn->out_sent, conn->out_len - conn->out_sent};
+        size_t sent = 0;
+        infra_error_t err = infra_net_sendv(conn->sock, &iov, 1, &sent);
+        if (err != INFRA_OK) {
+            if (err != INFRA_ERROR_WOULD_BLOCK) {
+                INFRA_LOG_ERROR("Failed to send to %s: %d", conn->client_addr, err);
+            }
+            return err;
+        }
+        conn->out_sent += sent;
+    }
+
+    conn->out_len = 0;
+    conn->out_sent = 0;
+    // 大响应发完后释放, 空闲连接只占用少量内存
+    if (conn->out_cap > DISKV_CONN_OUT_INIT) {
+        infra_free(conn->out_buf);
+        conn->out_buf = NULL;
+        conn->out_cap = 0;
+    }
+    return INFRA_OK;
+}
+
+//-----------------------------------------------------------------------------
+// Storage
+//-----------------------------------------------------------------------------
+
+// 独占写句柄并开启一个 savepoint, 句柄已处于 writer 的事务中. 失败时返回 NULL
+static poly_db_t* storage_begin(diskv_state_t* state) {
+    poly_db_t* db = poly_db_writer_begin(state->writer);
+    if (db && poly_db_exec(db, "SAVEPOINT diskv_op") != INFRA_OK) {
+        poly_db_writer_end(state->writer);
+        db = NULL;
+    }
+    return db;
+}
+
+// 释放写句柄, failed 时先撤销 savepoint 之后的修改, 同一事务里的其他写入不受影响.
+// 返回结果依赖的事务编号, 0 表示不依赖未提交的数据
+static uint64_t storage_end(diskv_state_t* state, bool failed) {
+    if (failed) {
+        poly_db_exec(state->db, "ROLLBACK TO diskv_op");
+    }
+    poly_db_exec(state->db, "RELEASE diskv_op");
+    return poly_db_writer_end(state->writer);
+}
+
+// 命令第一次访问存储时独占写句柄, 命令结束时由 cmd_db_end 释放.
+// 失败时回复错误并返回 NULL
+static poly_db_t* cmd_db(diskv_conn_t* conn) {
+    diskv_reactor_t* reactor = conn->reactor;
+    if (!reactor->db_held) {
+        poly_db_t* db = storage_begin(get_state());
+        if (!db) {
+            INFRA_LOG_ERROR("Failed to begin command for %s", conn->client_addr);
+            conn_out_error(conn, "%s", ERR_STORAGE);
+            return NULL;
+        }
+        reactor->db_held = true;
+        reactor->cmd_failed = false;
+    }
+    return get_state()->db;
+}
+
+// 命令执行到一半时存储出错: 结束时撤销这条命令的全部修改, 保证命令的原子性
+static void cmd_fail(diskv_conn_t* conn, infra_error_t err) {
+    INFRA_LOG_ERROR("Storage error for %s: %d", conn->client_addr, err);
+    conn->reactor->cmd_failed = true;
+    conn_out_error(conn, "%s", ERR_STORAGE);
+}
+
+// 释放命令持有的写句柄, 记下响应依赖的事务, 事务提交后才发送
+static void cmd_db_end(diskv_conn_t* conn) {
+    diskv_reactor_t* reactor = conn->reactor;
+    if (!reactor->db_held) {
+        return;
+    }
+    uint64_t ticket = storage_end(get_state(), reactor->cmd_failed);
+    if (ticket) {
+        if (!conn->commit_first) {
+            conn->commit_first = ticket;
+        }
+        conn->commit_last = ticket;
+    }
+    reactor->db_held = false;
+    reactor->cmd_failed = false;
+}
+
+// 提交失败: 本批已排队的响应换成同样条数的错误响应
+static void batch_discard_replies(diskv_conn_t* conn) {
+    conn->out_len = conn->batch_mark;
+    for (int i = 0; i < conn->batch_cmds; i++) {
+        conn_out_error(conn, "%s", ERR_ROLLED_BACK);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Commands
+//-----------------------------------------------------------------------------
+
+typedef void (*diskv_cmd_fn)(diskv_conn_t* conn, const diskv_command_t* cmd);
+
+typedef struct diskv_cmd_def {
+    const char* name;
+    int arity;                   // 参数个数 (含命令名), 负数表示至少 -arity 个
+    diskv_cmd_fn fn;
+} diskv_cmd_def_t;
+
+static int64_t now_ms(void) {
+    return (int64_t)infra_time_now();
+}
+
+// 存储层错误转为响应: 类型不符回复 WRONGTYPE, 其他错误回滚这条命令
+static void reply_storage_error(diskv_conn_t* conn, infra_error_t err) {
+    if (err == INFRA_ERROR_INVALID_TYPE) {
+        conn_out_error(conn, "%s", ERR_WRONGTYPE);
+    } else {
+        cmd_fail(conn, err);
+    }
+}
+
+static void cmd_ping(diskv_conn_t* conn, const diskv_command_t* cmd) {
+    if (cmd->argc > 2) {
+        conn_out_error(conn, "ERR wrong number of arguments for 'ping' command");
+    } else if (cmd->argc == 2) {
+        conn_out_bulk(conn, cmd->argv[1].ptr, cmd->argv[1].len);
+    } else {
+        conn_out_status(conn, "PONG");
+    }
+}
+
+static void cmd_echo(diskv_conn_t* conn, const diskv_command_t* cmd) {
+    conn_out_bulk(conn, cmd->argv[1].ptr, cmd->argv[1].len);
+}
+
+static void cmd_quit(diskv_conn_t* conn, const diskv_command_t* cmd) {
+    (void)cmd;
+    conn_out_status(conn, "OK");
+    conn->should_close = true;
+}
+
+// 只有 0 号库
+static void cmd_select(diskv_conn_t* conn, const diskv_command_t* cmd) {
+    int64_t db = 0;
+    if (!diskv_span_to_i64(cmd->argv[1], &db)) {
+        conn_out_error(conn, "%s", ERR_NOT_INTEGER);
+    } else if (db != 0) {
+        conn_out_error(conn, "ERR DB index is out of range");
+    } else {
+        conn_out_status(conn, "OK");
+    }
+}
+
+// 客户端只用来获取命令提示, 返回空表即可
+static void cmd_command(diskv_conn_t* conn, const diskv_command_t* cmd) {
+    (void)cmd;
+    conn_out_header(conn, '*', 0);
+}
+
+// HELLO [protover [AUTH user pass] [SETNAME name]]: 切换 RESP 版本, 返回服务信息.
+// 服务没有认证, AUTH 和 SETNAME 只检查格式
+static void cmd_hello(diskv_conn_t* conn, const diskv_command_t* cmd) {
+    int proto = conn->proto;
+    if (cmd->argc >= 2) {
+        int64_t ver = 0;
+        if (!diskv_span_to_i64(cmd->argv[1], &ver)) {
+            conn_out_error(conn, "ERR Protocol version is not an integer or out of range");
+            return;
+        }
+        if (ver != 2 && ver != 3) {
+            conn_out_error(conn, "NOPROTO unsupported protocol version");
+            return;
+        }
+        proto = (int)ver;
+    }
+    for (int i = 2; i < cmd->argc; i++) {
+        if (diskv_span_equals_nocase(cmd->argv[i], "AUTH") && i + 2 < cmd->argc) {
+            i += 2;
+        } else if (diskv_span_equals_nocase(cmd->argv[i], "SETNAME") && i + 1 < cmd->argc) {
+            i += 1;
+        } else {
+            conn_out_error(conn, "%s", ERR_SYNTAX);
+            return;
+        }
+    }
+
+    // 响应按新版本编码
+    conn->proto = proto;
+    conn_out_map(conn, 7);
+    conn_out_bulk_cstr(conn, "server");
+    conn_out_bulk_cstr(conn, "ppdb");
+    conn_out_bulk_cstr(conn, "version");
+    conn_out_bulk_cstr(conn, DISKV_VERSION);
+    conn_out_bulk_cstr(conn, "proto");
+    conn_out_int(conn, proto);
+    conn_out_bulk_cstr(conn, "id");
+    conn_out_int(conn, (int64_t)conn->id);
+    conn_out_bulk_cstr(conn, "mode");
+    conn_out_bulk_cstr(conn, "standalone");
+    conn_out_bulk_cstr(conn, "role");
+    conn_out_bulk_cstr(conn, "master");
+    conn_out_bulk_cstr(conn, "modules");
+    conn_out_header(conn, '*', 0);
+}
+
+static void cmd_get(diskv_conn_t* conn, const diskv_command_t* cmd) {
+    poly_db_t* db = cmd_db(conn);
+    if (!db) {
+        return;
+    }
+
+    poly_db_stmt_t* stmt = NULL;
+    bool stale = false;
+    infra_error_t err = string_fetch(db, cmd->argv[1], now_ms(), &stmt, &stale);
+    if (err == INFRA_ERROR_NOT_FOUND) {
+        conn_out_null(conn);
+        return;
+    }
+    if (err == INFRA_OK) {
+        err = conn_out_column(conn, stmt, 2);
+        poly_db_stmt_finalize(stmt);
+    }
+    if (err != INFRA_OK) {
+        reply_storage_error(conn, err);
+    }
+}
+
+// MGET key...: 不存在或不是 string 的 key 返回 null
+static void cmd_mget(diskv_conn_t* conn, const diskv_command_t* cmd) {
+    poly_db_t* db = cmd_db(conn);
+    if (!db) {
+        return;
+    }
+
+    int64_t now = now_ms();
+    size_t mark = conn->out_len;
+    conn_out_header(conn, '*', cmd->argc - 1);
+    for (int i = 1; i < cmd->argc; i++) {
+        poly_db_stmt_t* stmt = NULL;
+        bool stale = false;
+        infra_error_t err = string_fetch(db, cmd->argv[i], now, &stmt, &stale);
+        if (err == INFRA_OK) {
+            err = conn_out_column(conn, stmt, 2);
+            poly_db_stmt_finalize(stmt);
+        } else if (err == INFRA_ERROR_NOT_FOUND || err == INFRA_ERROR_INVALID_TYPE) {
+            conn_out_null(conn);
+            err = INFRA_OK;
+        }
+        if (err != INFRA_OK) {
+            conn->out_len = mark;
+            cmd_fail(conn, err);
+            return;
+        }
+    }
+}
+
+// 按新值的类型准备写入 string: 清除已过期的旧值和其他类型的元素.
+// *exists 表示写入前 key 是否存在 (任意类型)
+static infra_error_t string_prepare(poly_db_t* db, diskv_span_t key, int64_t now,
+                                    diskv_meta_t* meta, bool* exists) {
+    bool stale = false;
+    infra_error_t err = key_lookup(db, key, now, meta, &stale);
+    *exists = err == INFRA_OK;
+    if (err == INFRA_ERROR_NOT_FOUND) {
+        return stale ? key_purge(db, key, meta->type) : INFRA_OK;
+    }
+    if (err == INFRA_OK && meta->type != DISKV_TYPE_STRING) {
+        return key_purge(db, key, meta->type);
+    }
+    return err;
+}
+
+// SET key value [EX s | PX ms | EXAT ts | PXAT ts | KEEPTTL] [NX | XX]
+static void cmd_set(diskv_conn_t* conn, const diskv_command_t* cmd) {
+    bool nx = false;
+    bool xx = false;
+    bool keepttl = false;
+    bool has_expire = false;
+    int64_t now = now_ms();
+    int64_t expiry = 0;
+
+    for (int i = 3; i < cmd->argc; i++) {
+        diskv_span_t opt = cmd->argv[i];
+        if (diskv_span_equals_nocase(opt, "NX") && !xx) {
+            nx = true;
+        } else if (diskv_span_equals_nocase(opt, "XX") && !nx) {
+            xx = true;
+        } else if (diskv_span_equals_nocase(opt, "KEEPTTL") && !has_expire) {
+            keepttl = true;
+        } else if ((diskv_span_equals_nocase(opt, "EX") || diskv_span_equals_nocase(opt, "PX") ||
+                    diskv_span_equals_nocase(opt, "EXAT") || diskv_span_equals_nocase(opt, "PXAT")) &&
+                   !has_expire && !keepttl && i + 1 < cmd->argc) {
+            int64_t n = 0;
+            if (!diskv_span_to_i64(cmd->argv[++i], &n)) {
+                conn_out_error(conn, "%s", ERR_NOT_INTEGER);
+                return;
+            }
+            bool seconds = opt.ptr[0] == 'E' || opt.ptr[0] == 'e';
+            bool absolute = opt.len == 4;
+            if (n <= 0 || (seconds && n > INT64_MAX / 1000)) {
+                conn_out_error(conn, "ERR invalid expire time in 'set' command");
+                return;
+            }
+            expiry = seconds ? n * 1000 : n;
+            if (!absolute) {
+                if (expiry > INT64_MAX - now) {
+                    conn_out_error(conn, "ERR invalid expire time in 'set' command");
+                    return;
+                }
+                expiry += now;
+            }
+            has_expire = true;
+        } else {
+            conn_out_error(conn, "%s", ERR_SYNTAX);
+            return;
+        }
+    }
+
+    poly_db_t* db = cmd_db(conn);
+    if (!db) {
+        return;
+    }
+
+    diskv_meta_t meta;
+    bool exists = false;
+    infra_error_t err = INFRA_OK;
+    if (nx || xx || keepttl) {
+        // 条件写入先看 key 是否存在, 不满足条件时不改动任何数据
+        bool stale = false;
+        err = key_lookup(db, cmd->argv[1], now, &meta, &stale);
+        exists = err == INFRA_OK;
+        if (err == INFRA_ERROR_NOT_FOUND) {
+            err = INFRA_OK;
+        }
+        if (err == INFRA_OK && ((nx && exists) || (xx && !exists))) {
+            conn_out_null(conn);
+            return;
+        }
+    }
+    if (err == INFRA_OK) {
+        err = string_prepare(db, cmd->argv[1], now, &meta, &exists);
+    }
+    if (err == INFRA_OK) {
+        if (keepttl && exists) {
+            expiry = meta.expiry;
+        }
+        err = string_set(db, cmd->argv[1], cmd->argv[2], expiry);
+    }
+    if (err != INFRA_OK) {
+        reply_storage_error(conn, err);
+        return;
+    }
+    conn_out_status(conn, "OK");
+}
+
+// MSET key value [key value ...]
+static void cmd_mset(diskv_conn_t* conn, const diskv_command_t* cmd) {
+    if (cmd->argc % 2 != 1) {
+        conn_out_error(conn, "ERR wrong number of arguments for 'mset' command");
+        return;
+    }
+    poly_db_t* db = cmd_db(conn);
+    if (!db) {
+        return;
+    }
+
+    int64_t now = now_ms();
+    for (int i = 1; i < cmd->argc; i += 2) {
+        diskv_meta_t meta;
+        bool exists = false;
+        infra_error_t err = string_prepare(db, cmd->argv[i], now, &meta, &exists);
+        if (err == INFRA_OK) {
+            err = string_set(db, cmd->argv[i], cmd->argv[i + 1], 0);
+        }
+        if (err != INFRA_OK) {
+            cmd_fail(conn, err);
+            return;
+        }
+    }
+    conn_out_status(conn, "OK");
+}
+
+// DEL key...: 返回删除的 key 数
+static void cmd_del(diskv_conn_t* conn, const diskv_command_t* cmd) {
+    poly_db_t* db = cmd_db(conn);
+    if (!db) {
+        return;
+    }
+
+    int64_t now = now_ms();
+    int64_t deleted = 0;
+    for (int i = 1; i < cmd->argc; i++) {
+        diskv_meta_t meta;
+        bool stale = false;
+        infra_error_t err = key_lookup(db, cmd->argv[i], now, &meta, &stale);
+        if (err == INFRA_OK || stale) {
+            infra_error_t purge_err = key_purge(db, cmd->argv[i], meta.type);
+            if (purge_err != INFRA_OK) {
+                cmd_fail(conn, purge_err);
+                return;
+            }
+            if (err == INFRA_OK) {
+                deleted++;
+            }
+        } else if (err != INFRA_ERROR_NOT_FOUND) {
+            cmd_fail(conn, err);
+            return;
+        }
+    }
+    conn_out_int(conn, deleted);
+}
+
+// EXPIRE key seconds / PEXPIRE key ms: 不存在返回 0, 过期时间已过的直接删除
+static void cmd_expire(diskv_conn_t* conn, const diskv_command_t* cmd) {
+    bool seconds = diskv_span_equals_nocase(cmd->argv[0], "EXPIRE");
+    int64_t n = 0;
+    if (!diskv_span_to_i64(cmd->argv[2], &n)) {
+        conn_out_error(conn, "%s", ERR_NOT_INTEGER);
+        return;
+    }
+    int64_t now = now_ms();
+    if ((seconds && (n > INT64_MAX / 1000 || n < INT64_MIN / 1000)) ||
+        (seconds ? n * 1000 : n) > INT64_MAX - now) {
+        conn_out_error(conn, "ERR invalid expire time in '%s' command", seconds ? "expire" : "pexpire");
+        return;
+    }
+    int64_t expiry = now + (seconds ? n * 1000 : n);
+
+    poly_db_t* db = cmd_db(conn);
+    if (!db) {
+        return;
+    }
+
+    diskv_meta_t meta;
+    bool stale = false;
+    infra_error_t err = key_lookup(db, cmd->argv[1], now, &meta, &stale);
+    if (err == INFRA_ERROR_NOT_FOUND) {
+        conn_out_int(conn, 0);
+        return;
+    }
+    if (err == INFRA_OK) {
+        if (expiry <= now) {
+            err = key_purge(db, cmd->argv[1], meta.type);
+        } else {
+            poly_db_stmt_t* stmt = NULL;
+            err = db_prepare_key(db, KEY_SQL_EXPIRE, cmd->argv[1], &stmt);
+            if (err == INFRA_OK) {
+                char num[24];
+                err = bind_i64(stmt, 2, expiry, num);
+                if (err == INFRA_OK) {
+                    err = poly_db_stmt_step(stmt);
+                }
+                poly_db_stmt_finalize(stmt);
+            }
+        }
+    }
+    if (err != INFRA_OK) {
+        cmd_fail(conn, err);
+        return;
+    }
+    conn_out_int(conn, 1);
+}
+
+// TTL/PTTL: 不存在返回 -2, 不过期返回 -1
+static void cmd_ttl(diskv_conn_t* conn, const diskv_command_t* cmd) {
+    poly_db_t* db = cmd_db(conn);
+    if (!db) {
+        return;
+    }
+
+    int64_t now = now_ms();
+    diskv_meta_t meta;
+    bool stale = false;
+    infra_error_t err = key_lookup(db, cmd->argv[1], now, &meta, &stale);
+    if (err == INFRA_ERROR_NOT_FOUND) {
+        conn_out_int(conn, -2);
+    } else if (err != INFRA_OK) {
+        cmd_fail(conn, err);
+    } else if (meta.expiry == 0) {
+        conn_out_int(conn, -1);
+    } else if (diskv_span_equals_nocase(cmd->argv[0], "PTTL")) {
+        conn_out_int(conn, meta.expiry - now);
+    } else {
+        conn_out_int(conn, (meta.expiry - now + 500) / 1000);
+    }
+}
+
+// INCR/DECR/INCRBY/DECRBY: 不存在时从 0 开始, 保留原有的过期时间
+static void cmd_incr(diskv_conn_t* conn, const diskv_command_t* cmd) {
+    bool decr = cmd->argv[0].ptr[0] == 'D' || cmd->argv[0].ptr[0] == 'd';
+    int64_t delta = 1;
+    if (cmd->argc == 3 && !diskv_span_to_i64(cmd->argv[2], &delta)) {
+        conn_out_error(conn, "%s", ERR_NOT_INTEGER);
+        return;
+    }
+    if (decr) {
+        if (delta == INT64_MIN) {
+            conn_out_error(conn, "ERR decrement would overflow");
+            return;
+        }
+        delta = -delta;
+    }
+
+    poly_db_t* db = cmd_db(conn);
+    if (!db) {
+        return;
+    }
+
+    diskv_span_t key = cmd->argv[1];
+    poly_db_stmt_t* stmt = NULL;
+    bool stale = false;
+    int64_t value = 0;
+    infra_error_t err = string_fetch(db, key, now_ms(), &stmt, &stale);
+    bool exists = err == INFRA_OK;
+    if (exists) {
+        char buf[24];
+        size_t size = 0;
+        size_t n = 0;
+        bool numeric = poly_db_column_blob_size(stmt, 2, &size) == INFRA_OK &&
+                       size > 0 && size < sizeof(buf) &&
+                       poly_db_column_blob_chunk(stmt, 2, buf, size, 0, &n) == INFRA_OK && n == size;
+        poly_db_stmt_finalize(stmt);
+        diskv_span_t text = {buf, size};
+        if (!numeric || !diskv_span_to_i64(text, &value)) {
+            conn_out_error(conn, "%s", ERR_NOT_INTEGER);
+            return;
+        }
+    } else if (err == INFRA_ERROR_NOT_FOUND) {
+        // 已过期的旧值可能是 hash/list, 连同元素一起清除
+        diskv_meta_t meta;
+        bool exists_any = false;
+        err = stale ? string_prepare(db, key, now_ms(), &meta, &exists_any) : INFRA_OK;
+    }
+    if (err != INFRA_OK && !exists) {
+        reply_storage_error(conn, err);
+        return;
+    }
+
+    if ((delta > 0 && value > INT64_MAX - delta) || (delta < 0 && value < INT64_MIN - delta)) {
+        conn_out_error(conn, "ERR increment or decrement would overflow");
+        return;
+    }
+    value += delta;
+
+    char num[24];
+    diskv_span_t text = {num, (size_t)snprintf(num, sizeof(num), "%lld", (long long)value)};
+    if (exists) {
+        err = db_prepare_key(db, STR_SQL_UPDATE, key, &stmt);
+        if (err == INFRA_OK) {
+            err = poly_db_bind_blob(stmt, 2, text.ptr, text.len);
+            if (err == INFRA_OK) {
+                err = poly_db_stmt_step(stmt);
+            }
+            poly_db_stmt_finalize(stmt);
+        }
+    } else {
+        err = string_set(db, key, text, 0);
+    }
+    if (err != INFRA_OK) {
+        cmd_fail(conn, err);
+        return;
+    }
+    conn_out_int(conn, value);
+}
+
+// HSET key field value [field value ...]: 返回新增的 field 数
+static void cmd_hset(diskv_conn_t* conn, const diskv_command_t* cmd) {
+    if (cmd->argc % 2 != 0) {
+        conn_out_error(conn, "ERR wrong number of arguments for 'hset' command");
+        return;
+    }
+    poly_db_t* db = cmd_db(conn);
+    if (!db) {
+        return;
+    }
+
+    diskv_span_t key = cmd->argv[1];
+    diskv_meta_t meta;
+    bool exists = false;
+    infra_error_t err = key_for_write(db, key, DISKV_TYPE_HASH, now_ms(), &meta, &exists);
+    if (err == INFRA_OK && !exists) {
+        err = db_exec_key(db, HASH_SQL_CREATE, key);
+    }
+    if (err != INFRA_OK) {
+        reply_storage_error(conn, err);
+        return;
+    }
+
+    int64_t added = 0;
+    for (int i = 2; i < cmd->argc && err == INFRA_OK; i += 2) {
+        // 先改已有的 field, 没有改到再插入, 据此统计新增数
+        for (int pass = 0; pass < 2; pass++) {
+            poly_db_stmt_t* stmt = NULL;
+            err = db_prepare_key(db, pass == 0 ? HASH_SQL_UPDATE : HASH_SQL_INSERT, key, &stmt);
+            if (err != INFRA_OK) {
+                break;
+            }
+            err = poly_db_bind_blob(stmt, 2, cmd->argv[i].ptr, cmd->argv[i].len);
+            if (err == INFRA_OK) {
+                err = poly_db_bind_blob(stmt, 3, cmd->argv[i + 1].ptr, cmd->argv[i + 1].len);
+            }
+            if (err == INFRA_OK) {
+                err = poly_db_stmt_step(stmt);
+            }
+            poly_db_stmt_finalize(stmt);
+
+            uint64_t changes = 0;
+            if (err == INFRA_OK) {
+                err = poly_db_changes(db, &changes);
+            }
+            if (err != INFRA_OK || changes > 0) {
+                added += pass;
+                break;
+            }
+        }
+    }
+    if (err != INFRA_OK) {
+        cmd_fail(conn, err);
+        return;
+    }
+    conn_out_int(conn, added);
+}
+
+// HGET key field
+static void cmd_hget(diskv_conn_t* conn, const diskv_command_t* cmd) {
+    poly_db_t* db = cmd_db(conn);
+    if (!db) {
+        return;
+    }
+
+    poly_db_stmt_t* stmt = NULL;
+    infra_error_t err = db_prepare_key(db, HASH_SQL_GET, cmd->argv[1], &stmt);
+    if (err == INFRA_OK) {
+        err = poly_db_bind_blob(stmt, 2, cmd->argv[2].ptr, cmd->argv[2].len);
+        if (err == INFRA_OK) {
+            err = poly_db_stmt_step(stmt);
+        }
+
+        int64_t type = 0;
+        int64_t expiry = 0;
+        int64_t found = 0;
+        if (err == INFRA_OK && column_i64(stmt, 0, &type)) {
+            column_i64(stmt, 1, &expiry);
+            column_i64(stmt, 2, &found);
+            if (expiry > 0 && expiry <= now_ms()) {
+                found = 0;
+            } else if (type != DISKV_TYPE_HASH) {
+                err = INFRA_ERROR_INVALID_TYPE;
+            }
+        }
+        if (err == INFRA_OK) {
+            if (found) {
+                err = conn_out_column(conn, stmt, 3);
+            } else {
+                conn_out_null(conn);
+            }
+        }
+        poly_db_stmt_finalize(stmt);
+    }
+    if (err != INFRA_OK) {
+        reply_storage_error(conn, err);
+    }
+}
+
+// LPUSH/RPUSH key element...: 返回 list 的新长度
+static void cmd_push(diskv_conn_t* conn, const diskv_command_t* cmd) {
+    bool left = cmd->argv[0].ptr[0] == 'L' || cmd->argv[0].ptr[0] == 'l';
+    poly_db_t* db = cmd_db(conn);
+    if (!db) {
+        return;
+    }
+
+    diskv_span_t key = cmd->argv[1];
+    diskv_meta_t meta;
+    bool exists = false;
+    infra_error_t err = key_for_write(db, key, DISKV_TYPE_LIST, now_ms(), &meta, &exists);
+    if (err == INFRA_OK && !exists) {
+        meta.head = 0;
+        meta.tail = 0;
+        err = db_exec_key(db, LIST_SQL_CREATE, key);
+    }
+    if (err != INFRA_OK) {
+        reply_storage_error(conn, err);
+        return;
+    }
+
+    for (int i = 2; i < cmd->argc && err == INFRA_OK; i++) {
+        int64_t seq = left ? meta.head - 1 : meta.tail;
+        poly_db_stmt_t* stmt = NULL;
+        err = db_prepare_key(db, LIST_SQL_INSERT, key, &stmt);
+        if (err != INFRA_OK) {
+            break;
+        }
+        char num[24];
+        err = bind_i64(stmt, 2, seq, num);
+        if (err == INFRA_OK) {
+            err = poly_db_bind_blob(stmt, 3, cmd->argv[i].ptr, cmd->argv[i].len);
+        }
+        if (err == INFRA_OK) {
+            err = poly_db_stmt_step(stmt);
+        }
+        poly_db_stmt_finalize(stmt);
+        if (left) {
+            meta.head = seq;
+        } else {
+            meta.tail = seq + 1;
+        }
+    }
+
+    if (err == INFRA_OK) {
+        poly_db_stmt_t* stmt = NULL;
+        err = db_prepare_key(db, LIST_SQL_BOUNDS, key, &stmt);
+        if (err == INFRA_OK) {
+            char nums[2][24];
+            err = bind_i64(stmt, 2, meta.head, nums[0]);
+            if (err == INFRA_OK) {
+                err = bind_i64(stmt, 3, meta.tail, nums[1]);
+            }
+            if (err == INFRA_OK) {
+                err = poly_db_stmt_step(stmt);
+            }
+            poly_db_stmt_finalize(stmt);
+        }
+    }
+    if (err != INFRA_OK) {
+        cmd_fail(conn, err);
+        return;
+    }
+    conn_out_int(conn, meta.tail - meta.head);
+}
+
+// LRANGE key start stop: 下标含两端, 负数从尾部倒数
+static void cmd_lrange(diskv_conn_t* conn, const diskv_command_t* cmd) {
+    int64_t start = 0;
+    int64_t stop = 0;
+    if (!diskv_span_to_i64(cmd->argv[2], &start) || !diskv_span_to_i64(cmd->argv[3], &stop)) {
+        conn_out_error(conn, "%s", ERR_NOT_INTEGER);
+        return;
+    }
+    poly_db_t* db = cmd_db(conn);
+    if (!db) {
+        return;
+    }
+
+    diskv_meta_t meta;
+    bool stale = false;
+    infra_error_t err = key_lookup(db, cmd->argv[1], now_ms(), &meta, &stale);
+    if (err == INFRA_ERROR_NOT_FOUND) {
+        conn_out_header(conn, '*', 0);
+        return;
+    }
+    if (err == INFRA_OK && meta.type != DISKV_TYPE_LIST) {
+        err = INFRA_ERROR_INVALID_TYPE;
+    }
+    if (err != INFRA_OK) {
+        reply_storage_error(conn, err);
+        return;
+    }
+
+    int64_t len = meta.tail - meta.head;
+    if (start < 0) start += len;
+    if (stop < 0) stop += len;
+    if (start < 0) start = 0;
+    if (stop >= len) stop = len - 1;
+    if (start > stop) {
+        conn_out_header(conn, '*', 0);
+        return;
+    }
+
+    poly_db_stmt_t* stmt = NULL;
+    err = db_prepare_key(db, LIST_SQL_RANGE, cmd->argv[1], &stmt);
+    if (err != INFRA_OK) {
+        cmd_fail(conn, err);
+        return;
+    }
+    char nums[2][24];
+    err = bind_i64(stmt, 2, meta.head + start, nums[0]);
+    if (err == INFRA_OK) {
+        err = bind_i64(stmt, 3, meta.head + stop, nums[1]);
+    }
+
+    // 元素先写入输出缓冲区, 数出个数后再把数组头插到前面
+    size_t mark = conn->out_len;
+    int64_t count = 0;
+    while (err == INFRA_OK) {
+        err = poly_db_stmt_step(stmt);
+        int64_t seq = 0;
+        if (err != INFRA_OK || !column_i64(stmt, 0, &seq)) {
+            break;
+        }
+        err = conn_out_column(conn, stmt, 1);
+        count++;
+    }
+    poly_db_stmt_finalize(stmt);
+    if (err != INFRA_OK || conn->should_close) {
+        conn->out_len = mark;
+        cmd_fail(conn, err != INFRA_OK ? err : INFRA_ERROR_NO_MEMORY);
+        return;
+    }
+
+    char header[32];
+    size_t hlen = diskv_resp_header(header, '*', count);
+    if (!conn_out_reserve(conn, hlen)) {
+        conn->out_len = mark;
+        return;
+    }
+    memmove(conn->out_buf + mark + hlen, conn->out_buf + mark, conn->out_len - mark);
+    memcpy(conn->out_buf + mark, header, hlen);
+    conn->out_len += hlen;
+}
+
+static void cmd_flushdb(diskv_conn_t* conn, const diskv_command_t* cmd) {
+    (void)cmd;
+    poly_db_t* db = cmd_db(conn);
+    if (!db) {
+        return;
+    }
+    infra_error_t err = poly_db_exec(db, "DELETE FROM diskv_hash; DELETE FROM diskv_list; "
+                                         "DELETE FROM diskv_keys;");
+    if (err != INFRA_OK) {
+        cmd_fail(conn, err);
+        return;
+    }
+    conn_out_status(conn, "OK");
+}
+
+static const diskv_cmd_def_t g_diskv_commands[] = {
+    {"GET", 2, cmd_get},
+    {"SET", -3, cmd_set},
+    {"DEL", -2, cmd_del},
+    {"MGET", -2, cmd_mget},
+    {"MSET", -3, cmd_mset},
+    {"EXPIRE", 3, cmd_expire},
+    {"PEXPIRE", 3, cmd_expire},
+    {"TTL", 2, cmd_ttl},
+    {"PTTL", 2, cmd_ttl},
+    {"INCR", 2, cmd_incr},
+    {"DECR", 2, cmd_incr},
+    {"INCRBY", 3, cmd_incr},
+    {"DECRBY", 3, cmd_incr},
+    {"HSET", -4, cmd_hset},
+    {"HGET", 3, cmd_hget},
+    {"LPUSH", -3, cmd_push},
+    {"RPUSH", -3, cmd_push},
+    {"LRANGE", 4, cmd_lrange},
+    {"FLUSHDB", -1, cmd_flushdb},
+    {"FLUSHALL", -1, cmd_flushdb},
+    {"PING", -1, cmd_ping},
+    {"ECHO", 2, cmd_echo},
+    {"QUIT", -1, cmd_quit},
+    {"SELECT", 2, cmd_select},
+    {"HELLO", -1, cmd_hello},
+    {"COMMAND", -1, cmd_command}
+};
+
+// 执行一条解析好的命令, 恰好输出一条响应
+static void handle_command(diskv_conn_t* conn, const diskv_command_t* cmd) {
+    conn->reactor->stats.total_commands++;
+
+    for (size_t i = 0; i < sizeof(g_diskv_commands) / sizeof(g_diskv_commands[0]); i++) {
+        const diskv_cmd_def_t* def = &g_diskv_commands[i];
+        if (!diskv_span_equals_nocase(cmd->argv[0], def->name)) {
+            continue;
+        }
+        if ((def->arity > 0 && cmd->argc != def->arity) ||
+            (def->arity < 0 && cmd->argc < -def->arity)) {
+            conn_out_error(conn, "ERR wrong number of arguments for '%.*s' command",
+                           (int)(cmd->argv[0].len > 64 ? 64 : cmd->argv[0].len), cmd->argv[0].ptr);
+            return;
+        }
+        def->fn(conn, cmd);
+        cmd_db_end(conn);
+        return;
+    }
+
+    conn_out_error(conn, "ERR unknown command '%.*s'",
+                   (int)(cmd->argv[0].len > 64 ? 64 : cmd->argv[0].len), cmd->argv[0].ptr);
+}
+
+//-----------------------------------------------------------------------------
+// Receive
+//-----------------------------------------------------------------------------
+
+// 接收缓冲区放不下当前命令时扩大, 已知命令长度时一次扩到位; 已到上限返回 false
+static bool conn_rx_grow(diskv_conn_t* conn) {
+    if (conn->rx_cap >= DISKV_CONN_RX_MAX) {
+        return false;
+    }
+    size_t cap = conn->rx_cap * 2;
+    if (cap < conn->parser.need) {
+        cap = conn->parser.need;
+    }
+    if (cap > DISKV_CONN_RX_MAX) {
+        cap = DISKV_CONN_RX_MAX;
+    }
+    char* buf = infra_realloc(conn->rx_buf, cap);
+    if (!buf) {
+        return false;
+    }
+    conn->rx_buf = buf;
+    conn->rx_cap = cap;
+    return true;
+}
+
+// 积压处理完后收缩回初始大小, 空闲连接只占用少量内存
+static void conn_rx_shrink(diskv_conn_t* conn) {
+    if (conn->rx_len > 0 || conn->rx_cap <= DISKV_CONN_RX_INIT) {
+        return;
+    }
+    char* buf = infra_malloc(DISKV_CONN_RX_INIT);
+    if (buf) {
+        infra_free(conn->rx_buf);
+        conn->rx_buf = buf;
+        conn->rx_cap = DISKV_CONN_RX_INIT;
+    }
+}
+
+// 逐条解析并执行 rx_buf 中的命令 (pipeline), 命令直接引用 rx_buf 中的数据.
+// 响应先进入输出缓冲区, 本批提交后才发送; 积压过多时暂停, 剩余命令等发完后继续处理
+static void conn_process(diskv_conn_t* conn) {
+    size_t pos = 0;
+    while (pos < conn->rx_len && !conn->should_close &&
+           conn->out_len - conn->out_sent < DISKV_OUT_HIGH_WATER) {
+        diskv_command_t cmd;
+        size_t consumed = 0;
+        infra_error_t err = diskv_resp_parse(&conn->parser, conn->rx_buf + pos, conn->rx_len - pos,
+                                             &cmd, &consumed);
+        if (err == INFRA_ERROR_WOULD_BLOCK) {
+            break;
+        }
+        if (err != INFRA_OK) {
+            // 协议错误后无法找到下一条命令的起点, 回复后关闭
+            conn_out_error(conn, "ERR %s", cmd.error ? cmd.error : "Protocol error");
+            conn->batch_cmds++;
+            conn->should_close = true;
+            break;
+        }
+
+        pos += consumed;
+        if (cmd.argc > 0) {
+            handle_command(conn, &cmd);
+            conn->batch_cmds++;
+        }
+    }
+
+    if (pos > 0) {
+        conn->rx_len -= pos;
+        if (conn->rx_len > 0) {
+            memmove(conn->rx_buf, conn->rx_buf + pos, conn->rx_len);
+        }
+    }
+    conn_rx_shrink(conn);
+}
+
+static void handle_read(diskv_conn_t* conn) {
+    if (conn->rx_len == conn->rx_cap && !conn_rx_grow(conn)) {
+        INFRA_LOG_ERROR("Receive buffer full for %s", conn->client_addr);
+        conn_out_error(conn, "ERR Protocol error: request too big");
+        conn->batch_cmds++;
+        conn->should_close = true;
+        return;
+    }
+
+    size_t received = 0;
+    infra_error_t err = infra_net_recv(conn->sock, conn->rx_buf + conn->rx_len,
+                                       conn->rx_cap - conn->rx_len, &received);
+    if (err == INFRA_ERROR_WOULD_BLOCK) {
+        return;
+    }
+    if (err != INFRA_OK) {
+        INFRA_LOG_ERROR("Failed to receive data from %s: %d", conn->client_addr, err);
+        conn->should_close = true;
+        return;
+    }
+    if (received == 0) {
+        // 客户端关闭了连接
+        INFRA_LOG_INFO("Client %s closed connection", conn->client_addr);
+        conn->should_close = true;
+        return;
+    }
+
+    conn->rx_len += received;
+    conn_process(conn);
+}
+
+//-----------------------------------------------------------------------------
+// Reactor
+//-----------------------------------------------------------------------------
+
+static void reactor_link_conn(diskv_reactor_t* reactor, diskv_conn_t* conn) {
+    conn->prev = NULL;
+    conn->next = reactor->conn_head;
+    if (reactor->conn_head) {
+        reactor->conn_head->prev = conn;
+    }
+    reactor->conn_head = conn;
+    if (!reactor->conn_tail) {
+        reactor->conn_tail = conn;
+    }
+    reactor->conn_count++;
+}
+
+static void reactor_unlink_conn(diskv_reactor_t* reactor, diskv_conn_t* conn) {
+    if (conn->prev) {
+        conn->prev->next = conn->next;
+    } else {
+        reactor->conn_head = conn->next;
+    }
+    if (conn->next) {
+        conn->next->prev = conn->prev;
+    } else {
+        reactor->conn_tail = conn->prev;
+    }
+    conn->prev = conn->next = NULL;
+    reactor->conn_count--;
+}
+
+// 活跃的连接移到链表头部, 超时扫描只需从尾部开始
+static void reactor_touch_conn(diskv_reactor_t* reactor, diskv_conn_t* conn) {
+    conn->last_active_time = time(NULL);
+    if (reactor->conn_head == conn) {
+        return;
+    }
+    reactor_unlink_conn(reactor, conn);
+    reactor_link_conn(reactor, conn);
+}
+
+// 发送响应; 发不完时改为只等待可写, 暂停读取作为背压, 发完后恢复读取
+static infra_error_t reactor_flush_conn(diskv_reactor_t* reactor, diskv_conn_t* conn) {
+    infra_error_t err = conn_flush(conn);
+    if (err == INFRA_OK) {
+        if (conn->want_write) {
+            if (poly_poll_loop_modify(reactor->loop, conn->sock, POLY_POLL_READ, conn) != INFRA_OK) {
+                conn->should_close = true;
+                return INFRA_ERROR_IO;
+            }
+            conn->want_write = false;
+        }
+        return INFRA_OK;
+    }
+
+    if (err == INFRA_ERROR_WOULD_BLOCK) {
+        if (!conn->want_write) {
+            if (poly_poll_loop_modify(reactor->loop, conn->sock, POLY_POLL_WRITE, conn) != INFRA_OK) {
+                conn->should_close = true;
+                return INFRA_ERROR_IO;
+            }
+            conn->want_write = true;
+        }
+        return err;
+    }
+
+    conn->should_close = true;
+    return err;
+}
+
+static void reactor_close_conn(diskv_reactor_t* reactor, diskv_conn_t* conn) {
+    if (conn->held) {
+        // 等待提交时被关闭 (空闲超时, 服务停止), 依赖未提交事务的响应不再发送
+        diskv_conn_t** link = &reactor->held;
+        while (*link != conn) {
+            link = &(*link)->held_next;
+        }
+        *link = conn->held_next;
+        conn->held = false;
+        conn->out_len = conn->batch_mark;
+    }
+    // 尽量把已排队的响应 (如 QUIT, 协议错误) 发出去, 不等待
+    if (conn->out_sent < conn->out_len) {
+        conn_flush(conn);
+    }
+    poly_poll_loop_remove(reactor->loop, conn->sock);
+    reactor_unlink_conn(reactor, conn);
+    diskv_conn_destroy(conn);
+}
+
+// 响应依赖的事务尚未提交: 暂停读写, 提交后由 reactor_release_held 继续
+static void reactor_hold_conn(diskv_reactor_t* reactor, diskv_conn_t* conn) {
+    if (poly_poll_loop_modify(reactor->loop, conn->sock, 0, conn) != INFRA_OK) {
+        conn->out_len = conn->batch_mark;
+        conn->should_close = true;
+        return;
+    }
+    conn->want_write = false;
+    conn->held = true;
+    conn->held_next = reactor->held;
+    reactor->held = conn;
+}
+
+// 本批处理完的连接: 依赖的事务已提交时发送响应, 提交失败时换成错误响应,
+// 尚未提交时挂起等待. 连接被关闭时返回 false
+static bool reactor_finish_conn(diskv_reactor_t* reactor, diskv_conn_t* conn) {
+    if (conn->commit_last) {
+        infra_error_t err = poly_db_writer_check(get_state()->writer,
+                                                 conn->commit_first, conn->commit_last);
+        if (err == INFRA_ERROR_WOULD_BLOCK) {
+            reactor_hold_conn(reactor, conn);
+            if (conn->held) {
+                reactor_touch_conn(reactor, conn);
+                return true;
+            }
+        } else if (err != INFRA_OK) {
+            batch_discard_replies(conn);
+        }
+        conn->commit_first = 0;
+        conn->commit_last = 0;
+    }
+
+    if (!conn->should_close) {
+        reactor_flush_conn(reactor, conn);
+    }
+    if (conn->should_close) {
+        reactor_close_conn(reactor, conn);
+        return false;
+    }
+    reactor_touch_conn(reactor, conn);
+    return true;
+}
+
+// 事务提交后恢复等待的连接: 发送响应, 继续处理已收到的命令
+static void reactor_release_held(diskv_reactor_t* reactor) {
+    diskv_state_t* state = get_state();
+    diskv_conn_t* conn = reactor->held;
+    reactor->held = NULL;
+
+    while (conn) {
+        diskv_conn_t* next = conn->held_next;
+        if (poly_db_writer_check(state->writer, conn->commit_first, conn->commit_last) ==
+            INFRA_ERROR_WOULD_BLOCK) {
+            conn->held_next = reactor->held;
+            reactor->held = conn;
+            conn = next;
+            continue;
+        }
+
+        conn->held = false;
+        conn->held_next = NULL;
+        if (!conn->should_close &&
+            poly_poll_loop_modify(reactor->loop, conn->sock, POLY_POLL_READ, conn) != INFRA_OK) {
+            conn->should_close = true;
+        }
+        if (reactor_finish_conn(reactor, conn) && !conn->held && !conn->want_write &&
+            conn->rx_len > 0) {
+            conn->batch_mark = conn->out_len;
+            conn->batch_cmds = 0;
+            conn_process(conn);
+            reactor_finish_conn(reactor, conn);
+        }
+        conn = next;
+    }
+}
+
+// 注册 accept 线程投递过来的新连接
+static void reactor_register_pending(diskv_reactor_t* reactor) {
+    infra_mutex_lock(reactor->pending_mutex);
+    diskv_conn_t* conn = reactor->pending;
+    reactor->pending = NULL;
+    infra_mutex_unlock(reactor->pending_mutex);
+
+    while (conn) {
+        diskv_conn_t* next = conn->next;
+        conn->next = NULL;
+
+        infra_error_t err = poly_poll_loop_add(reactor->loop, conn->sock, POLY_POLL_READ, conn);
+        if (err != INFRA_OK) {
+            INFRA_LOG_ERROR("Failed to register connection %s: %d", conn->client_addr, err);
+            diskv_conn_destroy(conn);
+            conn = next;
+            continue;
+        }
+
+        conn->reactor = reactor;
+        conn->last_active_time = time(NULL);
+        reactor->stats.total_connections++;
+        reactor_link_conn(reactor, conn);
+        INFRA_LOG_INFO("New client connection from %s (reactor %d)", conn->client_addr, reactor->id);
+        conn = next;
+    }
+}
+
+// 关闭空闲超时的连接
+static void reactor_sweep_idle(diskv_reactor_t* reactor) {
+    time_t now = time(NULL);
+    while (reactor->conn_tail &&
+           now - reactor->conn_tail->last_active_time > DISKV_CONN_IDLE_TIMEOUT) {
+        diskv_conn_t* conn = reactor->conn_tail;
+        INFRA_LOG_INFO("Connection timeout for %s", conn->client_addr);
+        reactor_close_conn(reactor, conn);
+    }
+}
+
+// 删除一批已过期的 key 及其元素, 随组提交的事务提交
+static void reactor_expire_cycle(diskv_reactor_t* reactor) {
+    diskv_state_t* state = get_state();
+    const char* const sqls[] = {EXPIRE_SQL_HASH, EXPIRE_SQL_LIST, EXPIRE_SQL_KEYS};
+    char nums[2][24];
+    uint64_t changes = 0;
+
+    poly_db_t* db = storage_begin(state);
+    if (!db) {
+        INFRA_LOG_ERROR("Expire cycle failed to acquire storage");
+        return;
+    }
+    infra_error_t err = INFRA_OK;
+    for (int i = 0; i < 3 && err == INFRA_OK; i++) {
+        poly_db_stmt_t* stmt = NULL;
+        err = poly_db_prepare(db, sqls[i], &stmt);
+        if (err != INFRA_OK) {
+            break;
+        }
+        err = bind_i64(stmt, 1, now_ms(), nums[0]);
+        if (err == INFRA_OK) {
+            err = bind_i64(stmt, 2, DISKV_EXPIRE_BATCH, nums[1]);
+        }
+        if (err == INFRA_OK) {
+            err = poly_db_stmt_step(stmt);
+        }
+        poly_db_stmt_finalize(stmt);
+        if (err == INFRA_OK && i == 2) {
+            err = poly_db_changes(db, &changes);
+        }
+    }
+    if (err != INFRA_OK) {
+        INFRA_LOG_ERROR("Expire cycle failed: %d", err);
+        changes = 0;
+    }
+    // 没有响应依赖回收的结果, 不等待提交
+    storage_end(state, err != INFRA_OK);
+
+    reactor->stats.expired_keys += changes;
+}
+
+static void* reactor_thread(void* arg) {
+    diskv_reactor_t* reactor = (diskv_reactor_t*)arg;
+    poly_poll_event_t events[DISKV_REACTOR_MAX_EVENTS];
+    diskv_conn_t* batch[DISKV_REACTOR_MAX_EVENTS];
+    uint64_t last_sweep = infra_time_ms();
+
+    INFRA_LOG_DEBUG("Reactor %d started (%s)", reactor->id, poly_poll_loop_backend(reactor->loop));
+
+    while (reactor->running) {
+        int count = 0;
+        infra_error_t err = poly_poll_loop_wait(reactor->loop, events,
+                                                DISKV_REACTOR_MAX_EVENTS,
+                                                DISKV_REACTOR_TICK_MS, &count);
+        if (err != INFRA_OK) {
+            INFRA_LOG_ERROR("Reactor %d wait failed: %d", reactor->id, err);
+            infra_sleep(10);
+            continue;
+        }
+
+        reactor_register_pending(reactor);
+        reactor_release_held(reactor);
+
+        int batch_count = 0;
+        for (int i = 0; i < count; i++) {
+            diskv_conn_t* conn = (diskv_conn_t*)events[i].user_data;
+            if (!conn || conn->should_close || conn->held) {
+                continue;
+            }
+
+            conn->batch_mark = conn->out_len;
+            conn->batch_cmds = 0;
+            batch[batch_count++] = conn;
+            if (conn->want_write) {
+                // 输出积压期间只关注可写, 之前批次的响应发完后继续处理已收到的命令
+                if (events[i].events & (POLY_POLL_WRITE | POLY_POLL_ERROR)) {
+                    if (reactor_flush_conn(reactor, conn) == INFRA_OK && conn->rx_len > 0) {
+                        conn->batch_mark = conn->out_len;
+                        conn_process(conn);
+                    }
+                }
+            } else if (events[i].events & (POLY_POLL_READ | POLY_POLL_ERROR)) {
+                handle_read(conn);
+            }
+        }
+
+        // 依赖的事务提交 (synchronous=FULL, 已落盘) 后才发送响应
+        for (int i = 0; i < batch_count; i++) {
+            reactor_finish_conn(reactor, batch[i]);
+        }
+
+        uint64_t now = infra_time_ms();
+        if (now - last_sweep >= DISKV_REACTOR_TICK_MS) {
+            reactor_sweep_idle(reactor);
+            // 过期 key 由 0 号 reactor 回收, 读路径只跳过不删除
+            if (reactor->id == 0) {
+                reactor_expire_cycle(reactor);
+            }
+            last_sweep = now;
+        }
+    }
+
+    // 关闭剩余连接
+    reactor_register_pending(reactor);
+    while (reactor->conn_head) {
+        reactor_close_conn(reactor, reactor->conn_head);
+    }
+
+    INFRA_LOG_DEBUG("Reactor %d stopped", reactor->id);
+    return NULL;
+}
+
+static int reactor_configured_count(const diskv_state_t* state) {
+    if (state->threads > 0) {
+        return state->threads;
+    }
+    // 存储只有一个写句柄, reactor 只负责收发和解析, 不需要太多
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    if (n < 1) n = 1;
+    if (n > 4) n = 4;
+    return (int)n;
+}
+
+// 停止 reactor 线程, 事件循环留到 reactors_stop 再销毁 (提交回调还会唤醒它们)
+static void reactors_join(diskv_state_t* state) {
+    if (!state->reactors) {
+        return;
+    }
+
+    for (int i = 0; i < state->reactor_count; i++) {
+        diskv_reactor_t* reactor = &state->reactors[i];
+        if (reactor->thread) {
+            reactor->running = false;
+            poly_poll_loop_wakeup(reactor->loop);
+        }
+    }
+    for (int i = 0; i < state->reactor_count; i++) {
+        diskv_reactor_t* reactor = &state->reactors[i];
+        if (reactor->thread) {
+            infra_thread_join(reactor->thread);
+            reactor->thread = NULL;
+        }
+    }
+}
+
+static void reactors_stop(diskv_state_t* state) {
+    if (!state->reactors) {
+        return;
+    }
+
+    reactors_join(state);
+
+    for (int i = 0; i < state->reactor_count; i++) {
+        diskv_reactor_t* reactor = &state->reactors[i];
+        if (reactor->loop) {
+            poly_poll_loop_destroy(reactor->loop);
+        }
+        if (reactor->pending_mutex) {
+            infra_mutex_destroy(reactor->pending_mutex);
+        }
+    }
+
+    infra_free(state->reactors);
+    state->reactors = NULL;
+    state->reactor_count = 0;
+}
+
+static infra_error_t reactors_start(diskv_state_t* state) {
+    int count = reactor_configured_count(state);
+
+    state->reactors = infra_malloc(count * sizeof(diskv_reactor_t));
+    if (!state->reactors) {
+        return INFRA_ERROR_NO_MEMORY;
+    }
+    memset(state->reactors, 0, count * sizeof(diskv_reactor_t));
+    state->reactor_count = count;
+    state->next_reactor = 0;
+
+    for (int i = 0; i < count; i++) {
+        diskv_reactor_t* reactor = &state->reactors[i];
+        reactor->id = i;
+        reactor->running = true;
+
+        infra_error_t err = infra_mutex_create(&reactor->pending_mutex);
+        if (err == INFRA_OK) {
+            err = poly_poll_loop_create(&reactor->loop);
+        }
+        if (err == INFRA_OK) {
+            err = infra_thread_create(&reactor->thread, reactor_thread, reactor);
+        }
+        if (err != INFRA_OK) {
+            INFRA_LOG_ERROR("Failed to start reactor %d: %d", i, err);
+            reactors_stop(state);
+            return err;
+        }
+    }
+
+    INFRA_LOG_INFO("Started %d reactor threads (%s)", count,
+                   poly_poll_loop_backend(state->reactors[0].loop));
+    return INFRA_OK;
+}
+
+// 把新连接交给一个 reactor (轮询分配)
+static infra_error_t reactor_dispatch(diskv_state_t* state, diskv_conn_t* conn) {
+    if (!state->reactors || state->reactor_count <= 0) {
+        return INFRA_ERROR_INVALID_STATE;
+    }
+
+    uint32_t idx = __atomic_fetch_add(&state->next_reactor, 1, __ATOMIC_RELAXED);
+    diskv_reactor_t* reactor = &state->reactors[idx % (uint32_t)state->reactor_count];
+
+    infra_mutex_lock(reactor->pending_mutex);
+    conn->next = reactor->pending;
+    reactor->pending = conn;
+    infra_mutex_unlock(reactor->pending_mutex);
+
+    return poly_poll_loop_wakeup(reactor->loop);
+}
+
+//-----------------------------------------------------------------------------
+// Service Interface Implementation
+//-----------------------------------------------------------------------------
+
+infra_error_t diskv_init(void) {
+    INFRA_LOG_INFO("Initializing DisKV service...");
+
+    if (get_state()) {
+        INFRA_LOG_INFO("DisKV service already initialized");
+        return INFRA_OK;
+    }
+
+    if (g_diskv_service.state != PEER_SERVICE_STATE_INIT &&
+        g_diskv_service.state != PEER_SERVICE_STATE_STOPPED) {
+        INFRA_LOG_ERROR("Invalid service state: %d", g_diskv_service.state);
+        return INFRA_ERROR_INVALID_STATE;
+    }
+
+    diskv_state_t* state = (diskv_state_t*)infra_malloc(sizeof(diskv_state_t));
+    if (!state) {
+        INFRA_LOG_ERROR("Failed to allocate service state");
+        return INFRA_ERROR_NO_MEMORY;
+    }
+
+    memset(state, 0, sizeof(diskv_state_t));
+    state->port = DISKV_DEFAULT_PORT;
+    strncpy(state->host, "127.0.0.1", sizeof(state->host) - 1);
+    strncpy(state->db_path, "./diskv.db", sizeof(state->db_path) - 1);
+    state->engine = DISKV_ENGINE_SQLITE;
+
+    g_diskv_service.config.user_data = state;
+    g_diskv_service.state = PEER_SERVICE_STATE_READY;
+
+    INFRA_LOG_INFO("DisKV service initialized successfully");
+    return INFRA_OK;
+}
+
+infra_error_t diskv_cleanup(void) {
+    if (g_diskv_service.state == PEER_SERVICE_STATE_RUNNING) {
+        return INFRA_ERROR_INVALID_STATE;
+    }
+
+    diskv_state_t* state = get_state();
+    if (!state) {
+        return INFRA_OK;  // 已经清理
+    }
+
+    infra_free(state);
+    g_diskv_service.config.user_data = NULL;
+    g_diskv_service.state = PEER_SERVICE_STATE_INIT;
+    return INFRA_OK;
+}
+
+// 提交剩余写入; 提交回调会唤醒 reactor 的事件循环, 须在其销毁前调用
+static void storage_close(diskv_state_t* state) {
+    if (state->writer) {
+        poly_db_writer_destroy(state->writer);
+        state->writer = NULL;
+    }
+    if (state->db) {
+        poly_db_close(state->db);
+        state->db = NULL;
+    }
+}
+
+// 每次提交后唤醒所有 reactor, 发送等待该事务的响应
+static void storage_on_commit(void* arg) {
+    diskv_state_t* state = (diskv_state_t*)arg;
+    for (int i = 0; i < state->reactor_count; i++) {
+        if (state->reactors[i].loop) {
+            poly_poll_loop_wakeup(state->reactors[i].loop);
+        }
+    }
+}
+
+// 打开唯一的写句柄并交给组提交的 writer, 以持久化模式提交
+static infra_error_t storage_open(diskv_state_t* state) {
+    infra_error_t err = db_open(&state->db, state->db_path);
+    if (err == INFRA_OK) {
+        poly_db_writer_config_t config = {
+            .max_delay_ms = DISKV_COMMIT_DELAY_MS,
+            .max_ops = DISKV_COMMIT_MAX_OPS,
+            .durable = true,
+            .on_commit = storage_on_commit,
+            .on_commit_arg = state
+        };
+        err = poly_db_writer_create(state->db, &config, &state->writer);
+    }
+    if (err != INFRA_OK) {
+        storage_close(state);
+    }
+    return err;
+}
+
+infra_error_t diskv_start(void) {
+    diskv_state_t* state = get_state();
+    if (!state) {
+        INFRA_LOG_ERROR("Service not initialized");
+        return INFRA_ERROR_NOT_INITIALIZED;
+    }
+
+    // 打开存储
+    if (!state->db) {
+        infra_error_t err = storage_open(state);
+        if (err != INFRA_OK) {
+            INFRA_LOG_ERROR("Failed to open storage: %d", err);
+            return err;
+        }
+    }
+
+    // 线程池只负责把新连接交给 reactor
+    if (!state->ctx) {
+        state->ctx = infra_malloc(sizeof(poly_poll_context_t));
+        if (!state->ctx) {
+            INFRA_LOG_ERROR("Failed to allocate polling context");
+            return INFRA_ERROR_NO_MEMORY;
+        }
+        memset(state->ctx, 0, sizeof(poly_poll_context_t));
+
+        poly_poll_config_t config = {
+            .min_threads = 1,
+            .max_threads = 2,
+            .queue_size = 4096,
+            .max_listeners = 1,
+            .read_buffer_size = DISKV_CONN_RX_INIT
+        };
+
+        infra_error_t err = poly_poll_init(state->ctx, &config);
+        if (err != INFRA_OK) {
+            INFRA_LOG_ERROR("Failed to initialize polling context: %d", err);
+            infra_free(state->ctx);
+            state->ctx = NULL;
+            return err;
+        }
+    }
+
+    INFRA_LOG_INFO("Adding listener on %s:%d", state->host, state->port);
+
+    poly_poll_listener_t listener = {0};
+    strncpy(listener.bind_addr, state->host, sizeof(listener.bind_addr) - 1);
+    listener.bind_port = state->port;
+
+    infra_error_t err = poly_poll_add_listener(state->ctx, &listener);
+    if (err != INFRA_OK) {
+        INFRA_LOG_ERROR("Failed to add listener: %d", err);
+        return err;
+    }
+
+    err = reactors_start(state);
+    if (err != INFRA_OK) {
+        INFRA_LOG_ERROR("Failed to start reactors: %d", err);
+        return err;
+    }
+
+    poly_poll_set_handler(state->ctx, handle_accept);
+
+    state->running = true;
+    state->start_time = time(NULL);
+    g_diskv_service.state = PEER_SERVICE_STATE_RUNNING;
+
+    // 启动轮询 (阻塞直到 diskv_stop)
+    err = poly_poll_start(state->ctx);
+    if (err != INFRA_OK) {
+        INFRA_LOG_ERROR("Failed to start polling: %d", err);
+        state->running = false;
+        reactors_join(state);
+        storage_close(state);
+        reactors_stop(state);
+        g_diskv_service.state = PEER_SERVICE_STATE_STOPPED;
+        return err;
+    }
+
+    return INFRA_OK;
+}
+
+infra_error_t diskv_stop(void) {
+    if (g_diskv_service.state != PEER_SERVICE_STATE_RUNNING) {
+        return INFRA_ERROR_INVALID_STATE;
+    }
+
+    diskv_state_t* state = get_state();
+    if (!state) {
+        return INFRA_ERROR_INVALID_STATE;
+    }
+
+    if (!state->running) {
+        return INFRA_OK;
+    }
+
+    state->running = false;
+
+    if (state->ctx) {
+        poly_poll_stop(state->ctx);
+        poly_poll_cleanup(state->ctx);
+        infra_free(state->ctx);
+        state->ctx = NULL;
+    }
+
+    reactors_join(state);
+    storage_close(state);
+    reactors_stop(state);
+
+    g_diskv_service.state = PEER_SERVICE_STATE_STOPPED;
+    return INFRA_OK;
+}
+
+infra_error_t diskv_cmd_handler(const char* cmd, char* response, size_t size) {
+    if (!cmd || !response || size == 0) {
+        return INFRA_ERROR_INVALID_PARAM;
+    }
+
+    diskv_state_t* state = get_state();
+
+    if (strcmp(cmd, "status") == 0) {
+        const char* state_str = "unknown";
+        switch (g_diskv_service.state) {
+            case PEER_SERVICE_STATE_INIT: state_str = "initialized"; break;
+            case PEER_SERVICE_STATE_READY: state_str = "ready"; break;
+            case PEER_SERVICE_STATE_RUNNING: state_str = "running"; break;
+            case PEER_SERVICE_STATE_STOPPED: state_str = "stopped"; break;
+        }
+        size_t connections = 0;
+        diskv_stats_t total = {0};
+        poly_db_writer_stats_t commit_stats = {0};
+        if (state && state->writer) {
+            poly_db_writer_get_stats(state->writer, &commit_stats);
+        }
+        if (state && state->reactors) {
+            for (int i = 0; i < state->reactor_count; i++) {
+                const diskv_reactor_t* reactor = &state->reactors[i];
+                connections += reactor->conn_count;
+                total.total_commands += reactor->stats.total_commands;
+                total.expired_keys += reactor->stats.expired_keys;
+            }
+        }
+        snprintf(response, size, "DisKV Service Status:\n"
+                "State: %s\n"
+                "Port: %d\n"
+                "Engine: %s\n"
+                "DB Path: %s\n"
+                "Reactors: %d\n"
+                "Connections: %zu\n"
+                "Commands: %lu\n"
+                "Commits: %lu (%lu ops, %lu failed)\n"
+                "Expired Keys: %lu\n",
+                state_str,
+                state ? state->port : DISKV_DEFAULT_PORT,
+                state ? engine_name(state->engine) : "none",
+                state ? state->db_path : "none",
+                state ? state->reactor_count : 0,
+                connections,
+                (unsigned long)total.total_commands,
+                (unsigned long)commit_stats.commits,
+                (unsigned long)commit_stats.ops,
+                (unsigned long)commit_stats.failures,
+                (unsigned long)total.expired_keys);
+        return INFRA_OK;
+    }
+    else if (strcmp(cmd, "start") == 0) {
+        infra_error_t err = diskv_start();
+        snprintf(response, size, err == INFRA_OK ?
+                "DisKV service started\n" : "Failed to start DisKV service: %d\n", err);
+        return err;
+    }
+    else if (strcmp(cmd, "stop") == 0) {
+        infra_error_t err = diskv_stop();
+        snprintf(response, size, err == INFRA_OK ?
+                "DisKV service stopped\n" : "Failed to stop DisKV service: %d\n", err);
+        return err;
+    }
+
+    snprintf(response, size, "Unknown command: %s", cmd);
+    return INFRA_ERROR_NOT_FOUND;
+}
+
+// backend 形如 "<engine>:<path>", 没有前缀时整个作为路径.
+// 目前只有 SQLite 引擎, 其他引擎回退到 SQLite
+static infra_error_t apply_backend(diskv_state_t* state, const char* backend) {
+    const char* path = backend;
+    const char* colon = strchr(backend, ':');
+    if (colon && colon != backend && strncmp(backend, "file:", 5) != 0) {
+        size_t len = (size_t)(colon - backend);
+        if (len != 6 || strncmp(backend, "sqlite", 6) != 0) {
+            INFRA_LOG_WARN("Storage engine %.*s not available, falling back to sqlite",
+                           (int)len, backend);
+        }
+        path = colon + 1;
+    }
+    if (!*path) {
+        INFRA_LOG_ERROR("Empty database path in backend: %s", backend);
+        return INFRA_ERROR_INVALID_PARAM;
+    }
+
+    state->engine = DISKV_ENGINE_SQLITE;
+    strncpy(state->db_path, path, sizeof(state->db_path) - 1);
+    state->db_path[sizeof(state->db_path) - 1] = '\0';
+    return INFRA_OK;
+}
+
+infra_error_t diskv_apply_config(const poly_service_config_t* config) {
+    if (!config) {
+        INFRA_LOG_ERROR("Invalid configuration");
+        return INFRA_ERROR_INVALID_PARAM;
+    }
+
+    diskv_state_t* state = get_state();
+    if (!state) {
+        INFRA_LOG_ERROR("Service state not initialized");
+        return INFRA_ERROR_INVALID_STATE;
+    }
+
+    if (g_diskv_service.state != PEER_SERVICE_STATE_READY) {
+        INFRA_LOG_ERROR("Service in invalid state: %d", g_diskv_service.state);
+        return INFRA_ERROR_INVALID_STATE;
+    }
+
+    if (config->listen_host[0]) {
+        strncpy(state->host, config->listen_host, sizeof(state->host) - 1);
+        state->host[sizeof(state->host) - 1] = '\0';
+    }
+    state->port = config->listen_port > 0 ? config->listen_port : DISKV_DEFAULT_PORT;
+
+    if (config->backend[0]) {
+        infra_error_t err = apply_backend(state, config->backend);
+        if (err != INFRA_OK) {
+            return err;
+        }
+    }
+
+    if (config->threads > 0) {
+        if (config->threads > DISKV_MAX_THREADS) {
+            INFRA_LOG_ERROR("Too many threads: %d (max %d)", config->threads, DISKV_MAX_THREADS);
+            return INFRA_ERROR_INVALID_PARAM;
+        }
+        state->threads = config->threads;
+    }
+
+    INFRA_LOG_INFO("Applied configuration - host: %s, port: %d, engine: %s, db_path: %s, threads: %d",
+        state->host, state->port, engine_name(state->engine), state->db_path,
+        reactor_configured_count(state));
+    return INFRA_OK;
+}
+
+peer_service_t* peer_diskv_get_service(void) {
+    return &g_diskv_service;
+}
+
+//-----------------------------------------------------------------------------
+// Connections
+//-----------------------------------------------------------------------------
+
+static void diskv_conn_destroy(diskv_conn_t* conn) {
+    if (!conn) {
+        return;
+    }
+    if (conn->sock > 0) {
+        infra_net_close(conn->sock);
+        conn->sock = 0;
+    }
+    if (conn->rx_buf) {
+        infra_free(conn->rx_buf);
+    }
+    if (conn->out_buf) {
+        infra_free(conn->out_buf);
+    }
+    diskv_resp_parser_destroy(&conn->parser);
+    infra_free(conn);
+}
+
+static diskv_conn_t* diskv_conn_create(infra_socket_t sock) {
+    diskv_state_t* state = get_state();
+    diskv_conn_t* conn = (diskv_conn_t*)infra_malloc(sizeof(diskv_conn_t));
+    if (!conn) {
+        INFRA_LOG_ERROR("Failed to allocate connection state");
+        return NULL;
+    }
+    memset(conn, 0, sizeof(diskv_conn_t));
+
+    conn->rx_buf = (char*)infra_malloc(DISKV_CONN_RX_INIT);
+    if (!conn->rx_buf) {
+        INFRA_LOG_ERROR("Failed to allocate receive buffer");
+        infra_free(conn);
+        return NULL;
+    }
+    conn->rx_cap = DISKV_CONN_RX_INIT;
+    conn->sock = sock;
+    conn->proto = 2;
+    conn->id = __atomic_add_fetch(&state->next_client_id, 1, __ATOMIC_RELAXED);
+    conn->last_active_time = time(NULL);
+    diskv_resp_parser_init(&conn->parser);
+
+    struct sockaddr_in addr;
+    socklen_t addr_len = sizeof(addr);
+    if (getpeername(sock, (struct sockaddr*)&addr, &addr_len) == 0) {
+        snprintf(conn->client_addr, sizeof(conn->client_addr), "%s:%d",
+                inet_ntoa(addr.sin_addr), ntohs(addr.sin_port));
+    } else {
+        strncpy(conn->client_addr, "unknown", sizeof(conn->client_addr) - 1);
+    }
+
+    if (setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &(int){1}, sizeof(int)) < 0) {
+        INFRA_LOG_WARN("Failed to set TCP_NODELAY");
+    }
+    if (setsockopt(sock, SOL_SOCKET, SO_KEEPALIVE, &(int){1}, sizeof(int)) < 0) {
+        INFRA_LOG_WARN("Failed to set SO_KEEPALIVE");
+    }
+
+    if (infra_net_set_nonblock(sock, true) != INFRA_OK) {
+        INFRA_LOG_ERROR("Failed to set non-blocking mode");
+        conn->sock = 0;
+        diskv_conn_destroy(conn);
+        return NULL;
+    }
+    return conn;
+}
+
+static void handle_accept(void* args) {
+    poly_poll_handler_args_t* handler_args = (poly_poll_handler_args_t*)args;
+    if (!handler_args) {
+        INFRA_LOG_ERROR("Invalid handler args");
+        return;
+    }
+
+    infra_socket_t client = handler_args->client;
+    infra_free(handler_args);
+    if (client <= 0) {
+        INFRA_LOG_ERROR("Invalid client socket");
+        return;
+    }
+
+    diskv_state_t* state = get_state();
+    if (!state || !state->running) {
+        infra_net_close(client);
+        return;
+    }
+
+    diskv_conn_t* conn = diskv_conn_create(client);
+    if (!conn) {
+        INFRA_LOG_ERROR("Failed to create connection");
+        infra_net_close(client);
+        return;
+    }
+
+    // 交给 reactor 线程处理, 本线程立即返回
+    infra_error_t err = reactor_dispatch(state, conn);
+    if (err != INFRA_OK) {
+        INFRA_LOG_ERROR("Failed to dispatch connection: %d", err);
+        diskv_conn_destroy(conn);
+    }
+}
@@ -0,0 +1,137 @@
+#ifndef PEER_DISKV_H_
+#define PEER_DISKV_H_
+
+#include "internal/peer/peer_service.h"
+#include "internal/infra/infra_net.h"
+#include "internal/infra/infra_core.h"
+#include "internal/infra/infra_error.h"
+#include "internal/poly/poly_db.h"
+#include "internal/poly/poly_poll.h"
+#include "internal/peer/peer_diskv_resp.h"
+
+//-----------------------------------------------------------------------------
+// DisKV: Redis 协议的持久化 KV 服务
+//
+// 数据落在 poly_db 上 (SQLite, WAL 模式), 容量不受内存限制. 连接由若干 reactor
+// 线程管理, 协议解析和收发都在 reactor 中完成; 存储只有一个写句柄, 由
+// poly_db_writer 做组提交: 每条命令只在执行期间独占句柄, 各连接的命令攒在同一个
+// 事务里由提交线程提交, 事务提交 (synchronous=FULL, 已落盘) 后才发送依赖它的响应.
+//-----------------------------------------------------------------------------
+
+// 接收缓冲区初始大小, 放不下一条命令时成倍扩大, 处理完积压后收缩回来
+#define DISKV_CONN_RX_INIT (16 * 1024)
+// 接收缓冲区上限: 一条命令的全部参数要能放下
+#define DISKV_CONN_RX_MAX (DISKV_RESP_MAX_BULK + DISKV_RESP_MAX_INLINE)
+// 输出缓冲区初始大小
+#define DISKV_CONN_OUT_INIT (16 * 1024)
+// 待发送数据超过该值时暂停解析, 等客户端读走
+#define DISKV_OUT_HIGH_WATER (4 * 1024 * 1024)
+
+// 空闲连接超时(秒)
+#define DISKV_CONN_IDLE_TIMEOUT 300
+
+// 过期 key 回收: 每个 tick 每条 DELETE 最多删除的 key 数
+#define DISKV_EXPIRE_BATCH 128
+
+// 组提交: 第一条修改后最多等待的毫秒数, 以及一个事务最多攒的修改行数
+#define DISKV_COMMIT_DELAY_MS 2
+#define DISKV_COMMIT_MAX_OPS 1024
+
+// value 类型, 存在 diskv_keys.type 列
+typedef enum {
+    DISKV_TYPE_STRING = 0,
+    DISKV_TYPE_HASH = 1,
+    DISKV_TYPE_LIST = 2
+} diskv_type_t;
+
+// 存储引擎
+typedef enum {
+    DISKV_ENGINE_SQLITE = 0      // poly_db SQLite (WAL + group commit)
+} diskv_engine_t;
+
+struct diskv_reactor;
+
+// 连接状态结构
+typedef struct diskv_conn {
+    infra_socket_t sock;          // 客户端socket
+    uint64_t id;                  // 连接编号 (HELLO 返回)
+    char client_addr[64];         // 客户端地址
+    char* rx_buf;                 // 接收缓冲区
+    size_t rx_len;               // 接收缓冲区中的数据长度
+    size_t rx_cap;               // 接收缓冲区大小
+    char* out_buf;               // 待发送的响应
+    size_t out_len;
+    size_t out_cap;
+    size_t out_sent;             // 已发送的字节数
+    size_t batch_mark;           // 本批第一条响应在 out_buf 中的位置
+    int batch_cmds;              // 本批执行的命令数, 提交失败时逐条改为错误响应
+    uint64_t commit_first;       // 本批响应依赖的事务编号范围, 0 表示不依赖
+    uint64_t commit_last;
+    bool held;                   // 响应等待事务提交, 暂停读取
+    struct diskv_conn* held_next; // reactor 的等待提交链表
+    int proto;                   // 协商的 RESP 版本 (2 或 3)
+    bool should_close;           // 是否应该关闭连接
+    bool want_write;             // 已注册可写事件, 暂停读取
+    time_t last_active_time;     // 最后活动时间
+    diskv_resp_parser_t parser;  // 协议解析状态
+
+    // 事件循环相关
+    struct diskv_reactor* reactor; // 所属的 reactor 线程
+    struct diskv_conn* prev;     // reactor 连接链表 (按最近活跃排序)
+    struct diskv_conn* next;
+} diskv_conn_t;
+
+// 命令统计, 每个 reactor 一份, 只由所属线程更新 (字段全为 uint64_t)
+typedef struct diskv_stats {
+    uint64_t total_connections;
+    uint64_t total_commands;
+    uint64_t expired_keys;       // 后台回收的过期 key
+} diskv_stats_t;
+
+// reactor 线程: 每个线程通过事件循环管理多个非阻塞连接
+typedef struct diskv_reactor {
+    int id;                      // 线程编号
+    infra_thread_t thread;       // 线程句柄
+    poly_poll_loop_t* loop;      // 事件循环
+    volatile bool running;       // 运行标志
+    infra_mutex_t pending_mutex; // 保护 pending 队列
+    diskv_conn_t* pending;       // accept 线程投递的新连接
+    diskv_conn_t* conn_head;     // 最近活跃的连接
+    diskv_conn_t* conn_tail;     // 最久未活跃的连接
+    size_t conn_count;           // 连接数
+    diskv_conn_t* held;          // 等待事务提交的连接
+    bool db_held;                // 当前命令已独占写句柄
+    bool cmd_failed;             // 当前命令存储出错, 结束时回滚到命令开始前
+    diskv_stats_t stats;         // 本线程的命令统计
+} diskv_reactor_t;
+
+// 服务状态结构
+typedef struct diskv_state {
+    bool running;                // 是否正在运行
+    char host[256];             // 监听地址
+    uint16_t port;              // 监听端口
+    char db_path[1024];         // 数据库路径
+    diskv_engine_t engine;      // 存储引擎
+    poly_db_t* db;              // 唯一的存储句柄, 归 writer 管理
+    poly_db_writer_t* writer;   // 组提交, 各 reactor 每条命令独占一次句柄
+    time_t start_time;          // 启动时间
+    void* ctx;                  // 轮询上下文
+    diskv_reactor_t* reactors;  // reactor 线程数组
+    int reactor_count;          // reactor 线程数
+    uint32_t next_reactor;      // 下一个分配连接的 reactor
+    int threads;                // 配置的 reactor 线程数, 0 按 CPU 数
+    uint64_t next_client_id;    // 下一个连接编号
+} diskv_state_t;
+
+// Service interface functions
+infra_error_t diskv_init(void);
+infra_error_t diskv_cleanup(void);
+infra_error_t diskv_start(void);
+infra_error_t diskv_stop(void);
+infra_error_t diskv_cmd_handler(const char* cmd, char* response, size_t size);
+infra_error_t diskv_apply_config(const poly_service_config_t* config);
+
+// Get diskv service instance
+peer_service_t* peer_diskv_get_service(void);
+
+#endif /* PEER_DISKV_H_ */
@@ -0,0 +1,263 @@
+#include "internal/infra/infra_core.h"
+#include "internal/infra/infra_error.h"
+#include "internal/infra/infra_memory.h"
+#include "internal/peer/peer_diskv_resp.h"
+
+// $<len>\r\n 行的最大长度
+#define DISKV_RESP_MAX_BULK_LINE 32
+// 参数数组初始大小, 按实际解析到的参数个数成倍扩大
+#define DISKV_RESP_INIT_ARGS 16
+
+static const char* const ERR_MBULK_COUNT = "Protocol error: invalid multibulk length";
+static const char* const ERR_BULK_LEN = "Protocol error: invalid bulk length";
+static const char* const ERR_EXPECTED_BULK = "Protocol error: expected '$'";
+static const char* const ERR_INLINE_TOO_BIG = "Protocol error: too big inline request";
+static const char* const ERR_MBULK_TOO_BIG = "Protocol error: too big mbulk count string";
+
+//-----------------------------------------------------------------------------
+// Span Helpers
+//-----------------------------------------------------------------------------
+
+bool diskv_span_equals_nocase(diskv_span_t span, const char* str) {
+    size_t len = strlen(str);
+    if (span.len != len) {
+        return false;
+    }
+    for (size_t i = 0; i < len; i++) {
+        char c = span.ptr[i];
+        if (c >= 'a' && c <= 'z') {
+            c -= 'a' - 'A';
+        }
+        char s = str[i];
+        if (s >= 'a' && s <= 'z') {
+            s -= 'a' - 'A';
+        }
+        if (c != s) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool diskv_span_to_i64(diskv_span_t span, int64_t* value) {
+    bool negative = span.len > 0 && span.ptr[0] == '-';
+    size_t i = negative ? 1 : 0;
+    if (span.len == i || span.len - i > 19) {
+        return false;
+    }
+    uint64_t v = 0;
+    for (; i < span.len; i++) {
+        unsigned d = (unsigned char)span.ptr[i] - '0';
+        if (d > 9) {
+            return false;
+        }
+        v = v * 10 + d;
+    }
+    // 19 位十进制不会溢出 uint64_t, 只需检查 int64_t 的范围
+    if (v > (uint64_t)INT64_MAX + (negative ? 1 : 0)) {
+        return false;
+    }
+    *value = negative ? (int64_t)(0 - v) : (int64_t)v;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Parser
+//-----------------------------------------------------------------------------
+
+void diskv_resp_parser_init(diskv_resp_parser_t* parser) {
+    memset(parser, 0, sizeof(*parser));
+}
+
+void diskv_resp_parser_destroy(diskv_resp_parser_t* parser) {
+    if (parser->argv) {
+        infra_free(parser->argv);
+    }
+    memset(parser, 0, sizeof(*parser));
+}
+
+static bool parser_reserve(diskv_resp_parser_t* parser, int count) {
+    if (count <= parser->argv_cap) {
+        return true;
+    }
+    int cap = parser->argv_cap > 0 ? parser->argv_cap : DISKV_RESP_INIT_ARGS;
+    while (cap < count) {
+        cap *= 2;
+    }
+    diskv_span_t* argv = infra_realloc(parser->argv, (size_t)cap * sizeof(diskv_span_t));
+    if (!argv) {
+        return false;
+    }
+    parser->argv = argv;
+    parser->argv_cap = cap;
+    return true;
+}
+
+// 解析 buf[start, len) 中以 \r\n 结尾的一行数字 (前面的类型字节已跳过).
+// 返回 1 成功 (*next 指向下一行), 0 数据不完整, -1 格式错误
+static int parse_number_line(const char* buf, size_t len, size_t start, size_t max_line,
+                             int64_t* value, size_t* next) {
+    size_t avail = len - start;
+    const char* nl = memchr(buf + start, '\n', avail < max_line ? avail : max_line);
+    if (!nl) {
+        return avail < max_line ? 0 : -1;
+    }
+    size_t end = (size_t)(nl - buf);
+    if (end == start || buf[end - 1] != '\r') {
+        return -1;
+    }
+    diskv_span_t digits = {buf + start, end - 1 - start};
+    if (!diskv_span_to_i64(digits, value)) {
+        return -1;
+    }
+    *next = end + 1;
+    return 1;
+}
+
+// *<n>\r\n 之后跟 n 个 $<len>\r\n<data>\r\n
+static infra_error_t parse_multibulk(diskv_resp_parser_t* parser, const char* buf, size_t len,
+                                     diskv_command_t* cmd, size_t* consumed) {
+    int64_t count = 0;
+    size_t pos = 0;
+    int rc = parse_number_line(buf, len, 1, DISKV_RESP_MAX_INLINE, &count, &pos);
+    if (rc == 0) {
+        return INFRA_ERROR_WOULD_BLOCK;
+    }
+    if (rc < 0) {
+        cmd->error = len > DISKV_RESP_MAX_INLINE ? ERR_MBULK_TOO_BIG : ERR_MBULK_COUNT;
+        return INFRA_ERROR_PROTOCOL;
+    }
+    if (count > DISKV_RESP_MAX_ARGS) {
+        cmd->error = ERR_MBULK_COUNT;
+        return INFRA_ERROR_PROTOCOL;
+    }
+
+    int argc = 0;
+    while (argc < count) {
+        if (pos >= len) {
+            return INFRA_ERROR_WOULD_BLOCK;
+        }
+        if (buf[pos] != '$') {
+            cmd->error = ERR_EXPECTED_BULK;
+            return INFRA_ERROR_PROTOCOL;
+        }
+
+        int64_t blen = 0;
+        size_t data = 0;
+        rc = parse_number_line(buf, len, pos + 1, DISKV_RESP_MAX_BULK_LINE, &blen, &data);
+        if (rc == 0) {
+            return INFRA_ERROR_WOULD_BLOCK;
+        }
+        if (rc < 0 || blen < 0 || blen > DISKV_RESP_MAX_BULK) {
+            cmd->error = ERR_BULK_LEN;
+            return INFRA_ERROR_PROTOCOL;
+        }
+
+        // 大参数未到齐时记下所需长度, 调用者据此扩大接收缓冲区
+        size_t end = data + (size_t)blen + 2;
+        if (end > len) {
+            parser->need = end;
+            return INFRA_ERROR_WOULD_BLOCK;
+        }
+        if (buf[end - 2] != '\r' || buf[end - 1] != '\n') {
+            cmd->error = ERR_BULK_LEN;
+            return INFRA_ERROR_PROTOCOL;
+        }
+
+        if (!parser_reserve(parser, argc + 1)) {
+            return INFRA_ERROR_NO_MEMORY;
+        }
+        parser->argv[argc].ptr = buf + data;
+        parser->argv[argc].len = (size_t)blen;
+        argc++;
+        pos = end;
+    }
+
+    // *0 和 *-1 是空命令, 直接跳过
+    cmd->argv = parser->argv;
+    cmd->argc = argc;
+    *consumed = pos;
+    return INFRA_OK;
+}
+
+// 按空白分隔的一行, 供 telnet/nc 等手工调试使用, 不支持引号
+static infra_error_t parse_inline(diskv_resp_parser_t* parser, const char* buf, size_t len,
+                                  diskv_command_t* cmd, size_t* consumed) {
+    const char* nl = memchr(buf, '\n', len < DISKV_RESP_MAX_INLINE ? len : DISKV_RESP_MAX_INLINE);
+    if (!nl) {
+        if (len < DISKV_RESP_MAX_INLINE) {
+            return INFRA_ERROR_WOULD_BLOCK;
+        }
+        cmd->error = ERR_INLINE_TOO_BIG;
+        return INFRA_ERROR_PROTOCOL;
+    }
+
+    const char* p = buf;
+    const char* end = nl;
+    if (end > p && end[-1] == '\r') {
+        end--;
+    }
+
+    int argc = 0;
+    while (p < end) {
+        while (p < end && (*p == ' ' || *p == '\t')) p++;
+        if (p == end) {
+            break;
+        }
+        const char* start = p;
+        while (p < end && *p != ' ' && *p != '\t') p++;
+        if (!parser_reserve(parser, argc + 1)) {
+            return INFRA_ERROR_NO_MEMORY;
+        }
+        parser->argv[argc].ptr = start;
+        parser->argv[argc].len = (size_t)(p - start);
+        argc++;
+    }
+
+    cmd->argv = parser->argv;
+    cmd->argc = argc;
+    *consumed = (size_t)(nl - buf) + 1;
+    return INFRA_OK;
+}
+
+infra_error_t diskv_resp_parse(diskv_resp_parser_t* parser, const char* buf, size_t len,
+                               diskv_command_t* cmd, size_t* consumed) {
+    cmd->argv = NULL;
+    cmd->argc = 0;
+    cmd->error = NULL;
+    *consumed = 0;
+    parser->need = 0;
+    if (len == 0) {
+        return INFRA_ERROR_WOULD_BLOCK;
+    }
+    if (buf[0] == '*') {
+        return parse_multibulk(parser, buf, len, cmd, consumed);
+    }
+    return parse_inline(parser, buf, len, cmd, consumed);
+}
+
+//-----------------------------------------------------------------------------
+// Encoder
+//-----------------------------------------------------------------------------
+
+size_t diskv_resp_header(char* out, char type, int64_t n) {
+    char digits[24];
+    size_t nd = 0;
+    uint64_t v = n < 0 ? 0 - (uint64_t)n : (uint64_t)n;
+    do {
+        digits[nd++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v > 0);
+
+    size_t len = 0;
+    out[len++] = type;
+    if (n < 0) {
+        out[len++] = '-';
+    }
+    while (nd > 0) {
+        out[len++] = digits[--nd];
+    }
+    out[len++] = '\r';
+    out[len++] = '\n';
+    return len;
+}
@@ -0,0 +1,63 @@
+#ifndef PEER_DISKV_RESP_H_
+#define PEER_DISKV_RESP_H_
+
+#include "internal/infra/infra_core.h"
+#include "internal/infra/infra_error.h"
+
+//-----------------------------------------------------------------------------
+// DisKV 的 Redis 协议 (RESP) 解析和编码
+//
+// 请求: multibulk (*<n>\r\n$<len>\r\n<data>\r\n...) 或 inline (按空格分隔的一行),
+// RESP2 和 RESP3 的请求格式相同. 每次调用从接收缓冲区的当前位置解析出一条完整
+// 命令, 参数以 (ptr, len) 区间指向原缓冲区, 不复制, 也不修改缓冲区.
+// 响应: 按连接协商的版本 (HELLO) 编码, RESP3 的 null 和 map 有专门的类型.
+//-----------------------------------------------------------------------------
+
+// inline 命令和 multibulk 头部行的最大长度
+#define DISKV_RESP_MAX_INLINE (64 * 1024)
+// 单条命令的最大参数个数
+#define DISKV_RESP_MAX_ARGS (1024 * 1024)
+// 单个参数的最大长度
+#define DISKV_RESP_MAX_BULK (32 * 1024 * 1024)
+
+// 字节区间, 不以 '\0' 结尾
+typedef struct diskv_span {
+    const char* ptr;
+    size_t len;
+} diskv_span_t;
+
+// 一条解析好的命令, 区间在下一次解析或缓冲区移动之前有效
+typedef struct diskv_command {
+    diskv_span_t* argv;          // argv[0] 为命令名, 数组归解析器所有
+    int argc;
+    const char* error;           // 解析失败时的错误描述 (不含 "-ERR " 前缀和 \r\n)
+} diskv_command_t;
+
+// 解析器状态, 跨多次 recv 保持
+typedef struct diskv_resp_parser {
+    diskv_span_t* argv;          // 参数区间数组, 按需扩大
+    int argv_cap;
+    size_t need;                 // 上次不完整时已知至少需要的字节数, 0 表示未知
+} diskv_resp_parser_t;
+
+void diskv_resp_parser_init(diskv_resp_parser_t* parser);
+void diskv_resp_parser_destroy(diskv_resp_parser_t* parser);
+
+// 从 buf 解析一条命令
+//  INFRA_OK: 得到完整命令, *consumed 为其字节数 (空行 *consumed 非 0 且 argc 为 0)
+//  INFRA_ERROR_WOULD_BLOCK: 数据不完整, parser->need 为已知的最少总字节数
+//  INFRA_ERROR_PROTOCOL: 格式错误, cmd->error 为错误描述, 应回复后关闭连接
+//  INFRA_ERROR_NO_MEMORY: 参数数组扩大失败
+infra_error_t diskv_resp_parse(diskv_resp_parser_t* parser, const char* buf, size_t len,
+                               diskv_command_t* cmd, size_t* consumed);
+
+// 编码 <type><n>\r\n 形式的头部 (整数、数组、bulk 长度等), 返回写入的字节数, out 至少 32 字节
+size_t diskv_resp_header(char* out, char type, int64_t n);
+
+// 区间与字符串比较 (不区分大小写, 用于命令名和选项)
+bool diskv_span_equals_nocase(diskv_span_t span, const char* str);
+
+// 严格的十进制解析, 溢出或含非数字字符时返回 false
+bool diskv_span_to_i64(diskv_span_t span, int64_t* value);
+
+#endif /* PEER_DISKV_RESP_H_ */
@@ -4,27 +4,37 @@
 #include "internal/infra/infra_sync.h"
 #include "internal/infra/infra_log.h"
 #include "internal/infra/infra_thread.h"
+#include "internal/infra/infra_platform.h"
 #include "internal/poly/poly_db.h"
 #include "internal/poly/poly_poll.h"
 #include "internal/poly/poly_cmdline.h"
 #include "internal/peer/peer_service.h"
 #include "internal/peer/peer_memkv.h"
+#include "internal/peer/peer_memkv_store.h"
+#include "internal/peer/peer_memkv_slabs.h"
+#include "internal/peer/peer_memkv_hotkeys.h"
 #include <netinet/tcp.h>  // 添加TCP_NODELAY的定义
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
+#include <stdarg.h>
 #include <fcntl.h>
 #include <ctype.h>  // 添加 ctype.h 头文件
 
-// 键值对结构体定义
-struct kv_pair {
-    void* value;
+// kv 写语句的参数, 按固定编号绑定:
+// ?1 key, ?2 value, ?3 flags, ?4 expiry, ?5 新 CAS, ?6 当前时间, ?7 比较用的 CAS
+typedef struct kv_args {
+    const char* key;
+    const void* value;
     size_t value_len;
     uint32_t flags;
-    time_t exptime;
-};
+    int64_t expiry;              // 绝对时间戳, 0 表示不过期
+    uint64_t cas;
+    uint64_t cmp_cas;
+} kv_args_t;
 
 //-----------------------------------------------------------------------------
 // Forward Declarations
@@ -39,11 +49,13 @@ infra_error_t memkv_apply_config(const poly_service_config_t* config);
 
 static void memkv_conn_destroy(memkv_conn_t* conn);
 static void handle_request(memkv_conn_t* conn);
-static void handle_connection(void* args);
-static int handle_get(memkv_conn_t* conn, const char* key);
-static void handle_delete(memkv_conn_t* conn, const char* key, bool noreply);
+static void conn_process(memkv_conn_t* conn);
+static int handle_get(memkv_conn_t* conn, memkv_span_t key, const memkv_request_t* req);
+static int get_out_result(memkv_conn_t* conn, memkv_span_t key, const memkv_request_t* req,
+                          infra_error_t err, memkv_item_t* item);
+static void handle_delete(memkv_conn_t* conn, memkv_span_t key, bool noreply);
 static void handle_flush(memkv_conn_t* conn, bool noreply);
-static void handle_incr_decr(memkv_conn_t* conn, const char* key, const char* value_str, bool is_incr);
+static void handle_incr_decr(memkv_conn_t* conn, memkv_span_t key, uint64_t delta, bool is_incr);
 static void handle_accept(void* args);
 
 //-----------------------------------------------------------------------------
@@ -51,9 +63,9 @@ static void handle_accept(void* args);
 //-----------------------------------------------------------------------------
 
 #define MEMKV_VERSION "1.0.0"
-#define MEMKV_MAX_DATA_SIZE (32 * 1024 * 1024)  // 32MB max value size
 #define MEMKV_DEFAULT_PORT 11211
 #define MEMKV_MAX_THREADS 32
+#define MEMKV_DEFAULT_MEMORY_MB 64
 
 // 错误码定义
 #define MEMKV_OK INFRA_OK
@@ -65,7 +77,13 @@ static const poly_cmd_option_t memkv_options[] = {
     {"start", "Start the service", false},
     {"stop", "Stop the service", false},
     {"status", "Show service status", false},
-    {"engine", "Storage engine (sqlite/duckdb)", true},
+    {"engine", "Storage engine (memory/sqlite/duckdb)", true},
+    {"memory", "Item memory limit in MB for the memory engine", true},
+    {"factor", "Slab chunk size growth factor", true},
+    {"threads", "Number of reactor threads", true},
+    {"sharded", "Partition the keyspace across reactor threads (memory engine)", false},
+    {"hotcache", "Per-thread replica cache for hot keys (memory engine)", false},
+    {"commit-ms", "Group commit interval in ms for the sqlite engine (0 disables)", true},
     {"plugin", "Plugin path for duckdb", false}
 };
 
@@ -95,11 +113,21 @@ static inline memkv_state_t* get_state(void) {
     return (memkv_state_t*)g_memkv_service.config.user_data;
 }
 
+static const char* engine_name(memkv_engine_t engine) {
+    switch (engine) {
+        case MEMKV_ENGINE_MEMORY: return "memory";
+        case MEMKV_ENGINE_SQLITE: return "sqlite";
+        case MEMKV_ENGINE_DUCKDB: return "duckdb";
+        default: return "unknown";
+    }
+}
+
 //-----------------------------------------------------------------------------
 // Helper Functions
 //-----------------------------------------------------------------------------
 
-static infra_error_t db_init(poly_db_t** db, const char* path) {
+// 只读句柄用私有缓存, 不受写句柄未提交事务的表锁影响 (组提交时连接池只读)
+static infra_error_t db_open(poly_db_t** db, const char* path, memkv_engine_t engine, bool read_only) {
     if (!db || !path) {
         return INFRA_ERROR_INVALID_PARAM;
     }
@@ -107,10 +135,10 @@ static infra_error_t db_init(poly_db_t** db, const char* path) {
     INFRA_LOG_INFO("Opening database: %s", path);
 
     poly_db_config_t config = {
-        .type = POLY_DB_TYPE_SQLITE,
+        .type = engine == MEMKV_ENGINE_DUCKDB ? POLY_DB_TYPE_DUCKDB : POLY_DB_TYPE_SQLITE,
         .url = path,
         .max_memory = 0,  // 不限制内存
-        .read_only = false,
+        .read_only = read_only,
         .plugin_path = NULL,
         .allow_fallback = false
     };
@@ -121,473 +149,2617 @@ static infra_error_t db_init(poly_db_t** db, const char* path) {
         return err;
     }
 
-    // 创建表
+    INFRA_LOG_INFO("Database connection established");
+    return INFRA_OK;
+}
+
+// 建表只在服务启动时做一次
+static infra_error_t db_init_schema(poly_db_t* db) {
     const char* sql = 
         "CREATE TABLE IF NOT EXISTS kv_store ("
         "  key TEXT PRIMARY KEY,"
         "  value BLOB,"
         "  flags INTEGER,"
-        "  expiry INTEGER"
+        "  expiry INTEGER,"
+        "  cas INTEGER NOT NULL DEFAULT 0"
         ");"
         "CREATE INDEX IF NOT EXISTS idx_expiry ON kv_store(expiry);";
 
-    err = poly_db_exec(*db, sql);
+    infra_error_t err = poly_db_exec(db, sql);
     if (err != INFRA_OK) {
         INFRA_LOG_ERROR("Failed to create tables: %d", err);
-        poly_db_close(*db);
-        *db = NULL;
         return err;
     }
 
-    INFRA_LOG_INFO("Database connection established");
-    return INFRA_OK;
+    // 旧版本建的表没有 cas 列
+    if (poly_db_exec(db, "SELECT cas FROM kv_store LIMIT 0") != INFRA_OK) {
+        err = poly_db_exec(db, "ALTER TABLE kv_store ADD COLUMN cas INTEGER NOT NULL DEFAULT 0");
+        if (err != INFRA_OK) {
+            INFRA_LOG_ERROR("Failed to add cas column: %d", err);
+        }
+    }
+    return err;
 }
 
-static infra_error_t kv_get(poly_db_t* db, const char* key, struct kv_pair* pair) {
-    if (!db || !key || !pair) {
-        INFRA_LOG_DEBUG("kv_get for key: [%s]", key ? key : "NULL");
-        INFRA_LOG_ERROR("Invalid parameters");
-        return INFRA_ERROR_INVALID_PARAM;
+// 表中已有的最大 CAS, 新 CAS 从它之后分配
+static uint64_t db_max_cas(poly_db_t* db) {
+    poly_db_stmt_t* stmt = NULL;
+    uint64_t cas = 0;
+    if (poly_db_prepare(db, "SELECT MAX(cas) FROM kv_store", &stmt) != INFRA_OK) {
+        return 0;
     }
+    char* text = NULL;
+    if (poly_db_stmt_step(stmt) == INFRA_OK && poly_db_column_text(stmt, 0, &text) == INFRA_OK) {
+        cas = strtoull(text, NULL, 10);
+        infra_free(text);
+    }
+    poly_db_stmt_finalize(stmt);
+    return cas;
+}
 
-    INFRA_LOG_DEBUG("kv_get for key: [%s]", key);
+//-----------------------------------------------------------------------------
+// Database Pool
+//-----------------------------------------------------------------------------
 
-    // 准备 SQL 语句
-    poly_db_stmt_t* stmt = NULL;
-    infra_error_t err = poly_db_prepare(db, 
-        "SELECT value, flags, expiry FROM kv_store WHERE key = ?", &stmt);
-    if (err != INFRA_OK) {
-        INFRA_LOG_ERROR("Failed to prepare statement: %d", err);
-        return err;
+static void reactors_wakeup(memkv_state_t* state) {
+    for (int i = 0; i < state->reactor_count; i++) {
+        if (state->reactors[i].loop) {
+            poly_poll_loop_wakeup(state->reactors[i].loop);
+        }
     }
+}
+
+static infra_error_t db_pool_init(memkv_state_t* state, int max_size) {
+    memkv_db_pool_t* pool = &state->db_pool;
+    memset(pool, 0, sizeof(*pool));
+    pool->max_size = max_size < 1 ? 1 : (max_size > MEMKV_DB_POOL_MAX ? MEMKV_DB_POOL_MAX : max_size);
 
-    // 绑定参数
-    err = poly_db_bind_text(stmt, 1, key, -1);
+    infra_error_t err = infra_mutex_create(&pool->mutex);
     if (err != INFRA_OK) {
-        INFRA_LOG_ERROR("Failed to bind key: %d", err);
-        poly_db_stmt_finalize(stmt);
         return err;
     }
 
-    // 执行查询
-    err = poly_db_stmt_step(stmt);
-    if (err == INFRA_ERROR_NOT_FOUND) {
-        INFRA_LOG_DEBUG("Key not found: [%s]", key);
-        poly_db_stmt_finalize(stmt);
-        return err;
+    // 先打开一个句柄完成建表, 之后的句柄按需打开; 组提交时表已由写句柄建好
+    poly_db_t* db = NULL;
+    err = db_open(&db, state->db_path, state->engine, state->writer != NULL);
+    if (err == INFRA_OK && !state->writer) {
+        err = db_init_schema(db);
+        if (err != INFRA_OK) {
+            poly_db_close(db);
+        } else {
+            state->db_next_cas = db_max_cas(db);
+        }
     }
     if (err != INFRA_OK) {
-        INFRA_LOG_ERROR("Failed to execute statement: %d", err);
-        poly_db_stmt_finalize(stmt);
+        infra_mutex_destroy(pool->mutex);
+        memset(pool, 0, sizeof(*pool));
         return err;
     }
 
-    // 获取 BLOB 数据
-    void* blob_data = NULL;
-    size_t blob_size = 0;
-    err = poly_db_column_blob(stmt, 0, &blob_data, &blob_size);
-    if (err != INFRA_OK) {
-        INFRA_LOG_ERROR("Failed to get blob data: %d", err);
-        poly_db_stmt_finalize(stmt);
-        return err;
+    pool->handles[0] = db;
+    pool->idle[pool->idle_count++] = db;
+    pool->open_count = 1;
+    return INFRA_OK;
+}
+
+// 调用前所有句柄都应已归还
+static void db_pool_destroy(memkv_state_t* state) {
+    memkv_db_pool_t* pool = &state->db_pool;
+    if (!pool->mutex) {
+        return;
     }
 
-    INFRA_LOG_DEBUG("Got blob data: size=%zu", blob_size);
+    for (int i = 0; i < MEMKV_DB_POOL_MAX; i++) {
+        if (pool->handles[i]) {
+            poly_db_close(pool->handles[i]);
+        }
+    }
+    infra_mutex_destroy(pool->mutex);
+    memset(pool, 0, sizeof(*pool));
+}
 
-    // 获取 expiry
-    char* expiry_str = NULL;
-    err = poly_db_column_text(stmt, 2, &expiry_str);
-    if (err != INFRA_OK) {
-        INFRA_LOG_ERROR("Failed to get expiry: %d", err);
-        poly_db_stmt_finalize(stmt);
-        return err;
+// 借用一个句柄, 不等待: 优先取空闲句柄, open 为 true 且未到上限时新开.
+// 句柄用尽返回 INFRA_ERROR_WOULD_BLOCK, 调用者暂停连接, 有句柄归还时 reactor 被唤醒重试;
+// 后台任务传 false, 只取空闲句柄, 不与前台争抢
+static infra_error_t db_pool_try_acquire(memkv_state_t* state, bool open, poly_db_t** out) {
+    memkv_db_pool_t* pool = &state->db_pool;
+    *out = NULL;
+    if (!pool->mutex) {
+        return INFRA_ERROR_INVALID_STATE;
     }
 
-    // 检查过期时间
-    if (expiry_str) {
-        time_t expiry = strtol(expiry_str, NULL, 10);
-        free(expiry_str);
-        
-        if (expiry > 0) {
-            time_t now = time(NULL);
-            if (now >= expiry) {
-                INFRA_LOG_DEBUG("Key expired: [%s], expiry=%ld, now=%ld", key, expiry, now);
-                poly_db_stmt_finalize(stmt);
-                
-                // 删除过期的键
-                const char* delete_sql = "DELETE FROM kv_store WHERE key = ?";
-                poly_db_stmt_t* delete_stmt = NULL;
-                err = poly_db_prepare(db, delete_sql, &delete_stmt);
-                if (err != INFRA_OK) {
-                    INFRA_LOG_ERROR("Failed to prepare delete statement: %d", err);
-                    return INFRA_ERROR_NOT_FOUND;
-                }
-                
-                err = poly_db_bind_text(delete_stmt, 1, key, -1);
-                if (err != INFRA_OK) {
-                    INFRA_LOG_ERROR("Failed to bind key for delete: %d", err);
-                    poly_db_stmt_finalize(delete_stmt);
-                    return INFRA_ERROR_NOT_FOUND;
-                }
-                
-                err = poly_db_stmt_step(delete_stmt);
-                if (err != INFRA_OK && err != INFRA_ERROR_NOT_FOUND) {
-                    INFRA_LOG_ERROR("Failed to execute delete statement: %d", err);
-                    poly_db_stmt_finalize(delete_stmt);
-                    return INFRA_ERROR_NOT_FOUND;
-                }
-                
-                poly_db_stmt_finalize(delete_stmt);
-                return INFRA_ERROR_NOT_FOUND;
-            }
+    infra_mutex_lock(pool->mutex);
+    if (pool->idle_count > 0) {
+        *out = pool->idle[--pool->idle_count];
+        infra_mutex_unlock(pool->mutex);
+        return INFRA_OK;
+    }
+    if (!open || pool->open_count >= pool->max_size) {
+        if (open) {
+            pool->exhausted = true;
         }
+        infra_mutex_unlock(pool->mutex);
+        return INFRA_ERROR_WOULD_BLOCK;
     }
+    pool->open_count++;
+    infra_mutex_unlock(pool->mutex);
 
-    // 分配内存并复制数据
-    void* data = malloc(blob_size);
-    if (!data) {
-        INFRA_LOG_ERROR("Failed to allocate memory for value");
-        poly_db_stmt_finalize(stmt);
-        return INFRA_ERROR_NO_MEMORY;
-    }
-    memcpy(data, blob_data, blob_size);
-    pair->value = data;
-    pair->value_len = blob_size;
+    // 打开连接较慢, 放在锁外
+    poly_db_t* db = NULL;
+    infra_error_t err = db_open(&db, state->db_path, state->engine, state->writer != NULL);
 
-    // 获取 flags
-    char* flags_str = NULL;
-    err = poly_db_column_text(stmt, 1, &flags_str);
-    if (err == INFRA_OK && flags_str) {
-        pair->flags = (uint32_t)strtoul(flags_str, NULL, 10);
-        free(flags_str);
+    infra_mutex_lock(pool->mutex);
+    if (err != INFRA_OK) {
+        pool->open_count--;
     } else {
-        pair->flags = 0;
+        for (int i = 0; i < MEMKV_DB_POOL_MAX; i++) {
+            if (!pool->handles[i]) {
+                pool->handles[i] = db;
+                break;
+            }
+        }
     }
+    infra_mutex_unlock(pool->mutex);
+    *out = db;
+    return err;
+}
 
-    // 设置过期时间
-    if (expiry_str) {
-        pair->exptime = strtol(expiry_str, NULL, 10);
-    } else {
-        pair->exptime = 0;
+static void db_pool_release(memkv_state_t* state, poly_db_t* db) {
+    memkv_db_pool_t* pool = &state->db_pool;
+    if (!db || !pool->mutex) {
+        return;
     }
 
-    poly_db_stmt_finalize(stmt);
-    INFRA_LOG_DEBUG("Successfully got key-value pair: [%s]=[%.*s], flags=%u, exptime=%ld",
-                    key, (int)pair->value_len, (char*)pair->value, pair->flags, pair->exptime);
-    return INFRA_OK;
+    infra_mutex_lock(pool->mutex);
+    pool->idle[pool->idle_count++] = db;
+    bool wake = pool->exhausted;
+    pool->exhausted = false;
+    infra_mutex_unlock(pool->mutex);
+
+    // 唤醒暂停了连接的 reactor 重新借用
+    if (wake) {
+        reactors_wakeup(state);
+    }
 }
 
-static infra_error_t kv_set(poly_db_t* db, const char* key, const void* value, 
-                           size_t value_len, uint32_t flags, time_t exptime) {
-    if (!db || !key || !value || value_len == 0) {
-        return INFRA_ERROR_INVALID_PARAM;
+// 汇总所有句柄的语句缓存统计
+static void db_pool_stmt_stats(memkv_state_t* state, poly_db_stmt_cache_stats_t* total) {
+    memkv_db_pool_t* pool = &state->db_pool;
+    memset(total, 0, sizeof(*total));
+    if (!pool->mutex) {
+        return;
     }
-    
-    // 计算实际的过期时间戳
-    time_t real_exptime = 0;
-    if (exptime > 0) {
-        time_t now = time(NULL);
-        if (exptime > 60*60*24*30) {  // 大于30天的值被视为时间戳
-            real_exptime = exptime;
-        } else {
-            real_exptime = now + exptime;  // 否则被视为相对时间（秒）
+
+    infra_mutex_lock(pool->mutex);
+    for (int i = 0; i < MEMKV_DB_POOL_MAX; i++) {
+        poly_db_stmt_cache_stats_t stats;
+        if (pool->handles[i] && poly_db_get_stmt_cache_stats(pool->handles[i], &stats) == INFRA_OK) {
+            total->hits += stats.hits;
+            total->misses += stats.misses;
+            total->evictions += stats.evictions;
+            total->entries += stats.entries;
         }
-        printf("DEBUG: Setting expiration time: exptime=%ld, now=%ld, real_exptime=%ld\n",
-               (long)exptime, (long)now, (long)real_exptime);
     }
-    
-    const char* sql = 
-        "INSERT OR REPLACE INTO kv_store (key, value, flags, expiry) "
-        "VALUES (?, ?, ?, ?)";
-    
+    infra_mutex_unlock(pool->mutex);
+}
+
+//-----------------------------------------------------------------------------
+// Group Commit
+//-----------------------------------------------------------------------------
+
+// 组提交只用于 SQLite 文件库: 内存库没有日志 I/O 可分摊, DuckDB 走连接池
+static bool db_group_commit_enabled(const memkv_state_t* state) {
+    return state->engine == MEMKV_ENGINE_SQLITE && state->commit_ms >= 0 &&
+           !strstr(state->db_path, ":memory:") && !strstr(state->db_path, "mode=memory");
+}
+
+// 每次提交后唤醒所有 reactor, 发送等待该事务的响应
+static void db_writer_on_commit(void* arg) {
+    reactors_wakeup((memkv_state_t*)arg);
+}
+
+// 所有 reactor 共用一个写句柄, 各连接的写入攒成一个事务提交, 提交落盘后才确认
+static infra_error_t db_writer_init(memkv_state_t* state) {
+    poly_db_t* db = NULL;
+    infra_error_t err = db_open(&db, state->db_path, state->engine, false);
+    if (err != INFRA_OK) {
+        return err;
+    }
+    err = db_init_schema(db);
+    if (err == INFRA_OK) {
+        state->db_next_cas = db_max_cas(db);
+        poly_db_writer_config_t config = {
+            .max_delay_ms = state->commit_ms > 0 ? (uint32_t)state->commit_ms : MEMKV_COMMIT_DELAY_MS,
+            .max_ops = MEMKV_COMMIT_MAX_OPS,
+            .durable = true,
+            .on_commit = db_writer_on_commit,
+            .on_commit_arg = state
+        };
+        err = poly_db_writer_create(db, &config, &state->writer);
+    }
+    if (err != INFRA_OK) {
+        poly_db_close(db);
+        return err;
+    }
+    state->writer_db = db;
+    return INFRA_OK;
+}
+
+// 提交剩余写入; 提交回调会访问 reactor 的事件循环, 须在其销毁前调用
+static void db_writer_destroy(memkv_state_t* state) {
+    if (!state->writer) {
+        return;
+    }
+    poly_db_writer_destroy(state->writer);
+    poly_db_close(state->writer_db);
+    state->writer = NULL;
+    state->writer_db = NULL;
+}
+
+// 各写入模式对应的单条语句, 条件判断和写入在同一条语句内完成
+static const char* const KV_SQL_SET =
+    "INSERT OR REPLACE INTO kv_store (key, value, flags, expiry, cas) VALUES (?1, ?2, ?3, ?4, ?5)";
+static const char* const KV_SQL_ADD =
+    "INSERT INTO kv_store (key, value, flags, expiry, cas) VALUES (?1, ?2, ?3, ?4, ?5) "
+    "ON CONFLICT(key) DO UPDATE SET value = excluded.value, flags = excluded.flags, "
+    "expiry = excluded.expiry, cas = excluded.cas "
+    "WHERE kv_store.expiry > 0 AND kv_store.expiry <= ?6";
+static const char* const KV_SQL_REPLACE =
+    "UPDATE kv_store SET value = ?2, flags = ?3, expiry = ?4, cas = ?5 "
+    "WHERE key = ?1 AND (expiry = 0 OR expiry > ?6)";
+static const char* const KV_SQL_APPEND =
+    "UPDATE kv_store SET value = CAST(value || ?2 AS BLOB), cas = ?5 "
+    "WHERE key = ?1 AND (expiry = 0 OR expiry > ?6)";
+static const char* const KV_SQL_PREPEND =
+    "UPDATE kv_store SET value = CAST(?2 || value AS BLOB), cas = ?5 "
+    "WHERE key = ?1 AND (expiry = 0 OR expiry > ?6)";
+static const char* const KV_SQL_CAS =
+    "UPDATE kv_store SET value = ?2, flags = ?3, expiry = ?4, cas = ?5 "
+    "WHERE key = ?1 AND (expiry = 0 OR expiry > ?6) AND cas = ?7";
+static const char* const KV_SQL_TOUCH =
+    "UPDATE kv_store SET expiry = ?4 WHERE key = ?1 AND (expiry = 0 OR expiry > ?6)";
+static const char* const KV_SQL_UPDATE_VALUE =
+    "UPDATE kv_store SET value = ?2, cas = ?5 WHERE key = ?1";
+static const char* const KV_SQL_DELETE =
+    "DELETE FROM kv_store WHERE key = ?1 AND (expiry = 0 OR expiry > ?6)";
+static const char* const KV_SQL_DELETE_CAS =
+    "DELETE FROM kv_store WHERE key = ?1 AND (expiry = 0 OR expiry > ?6) AND cas = ?7";
+
+// incr/decr 的单条语句, 命中时 RETURNING 新值. SQLite 整数是有符号的, 十进制 value
+// 拆成高低各 10 位按 uint64 运算 (incr 回绕, decr 到 0 为止); 非数字或超出 uint64
+// 的 value 不匹配任何行. 参数: ?1 key, ?2 now, ?3 cas, ?4/?5 delta 的高/低 10 位
+#define KV_SQL_NUMBER \
+    "WITH v AS (SELECT CAST(substr(t, 1, length(t) - 10) AS INTEGER) AS hi, " \
+    "CAST(substr(t, -10) AS INTEGER) AS lo FROM " \
+    "(SELECT CAST(value AS TEXT) AS t, length(value) AS n FROM kv_store " \
+    "WHERE key = ?1 AND (expiry = 0 OR expiry > ?2)) " \
+    "WHERE n BETWEEN 1 AND 20 AND length(t) = n AND t NOT GLOB '*[^0-9]*' " \
+    "AND (n < 20 OR t <= '18446744073709551615')), "
+#define KV_SQL_NUMBER_SET \
+    "UPDATE kv_store SET value = CAST(CASE WHEN r.hi < 0 THEN 0 " \
+    "WHEN r.hi > 0 THEN r.hi || printf('%010d', r.lo) ELSE r.lo END AS BLOB), " \
+    "cas = ?3 FROM r WHERE key = ?1 RETURNING value"
+static const char* const KV_SQL_INCR =
+    KV_SQL_NUMBER
+    "s AS (SELECT hi + ?4 + (lo + ?5 >= 10000000000) AS hi, (lo + ?5) % 10000000000 AS lo FROM v), "
+    "w AS (SELECT hi, lo, hi > 1844674407 OR (hi = 1844674407 AND lo >= 3709551616) AS k FROM s), "
+    "r AS (SELECT hi - 1844674407 * k - (k AND lo < 3709551616) AS hi, "
+    "lo - 3709551616 * k + 10000000000 * (k AND lo < 3709551616) AS lo FROM w) "
+    KV_SQL_NUMBER_SET;
+static const char* const KV_SQL_DECR =
+    KV_SQL_NUMBER
+    "r AS (SELECT hi - ?4 - (lo < ?5) AS hi, lo - ?5 + 10000000000 * (lo < ?5) AS lo FROM v) "
+    KV_SQL_NUMBER_SET;
+
+// 执行一条 kv 写语句, 绑定前 nparams 个参数, 返回修改的行数.
+// poly_db 没有整数绑定, 数值按文本绑定, 由列的 INTEGER 亲和性转换
+static infra_error_t kv_exec(poly_db_t* db, const char* sql, int nparams,
+                             const kv_args_t* args, uint64_t* changes) {
+    char nums[5][24];
+    snprintf(nums[0], sizeof(nums[0]), "%u", args->flags);
+    snprintf(nums[1], sizeof(nums[1]), "%ld", (long)args->expiry);
+    snprintf(nums[2], sizeof(nums[2]), "%lu", (unsigned long)args->cas);
+    snprintf(nums[3], sizeof(nums[3]), "%ld", (long)time(NULL));
+    snprintf(nums[4], sizeof(nums[4]), "%lu", (unsigned long)args->cmp_cas);
+
     poly_db_stmt_t* stmt = NULL;
     infra_error_t err = poly_db_prepare(db, sql, &stmt);
     if (err != INFRA_OK) {
         INFRA_LOG_ERROR("Failed to prepare statement: %d", err);
         return err;
     }
-    
-    err = poly_db_bind_text(stmt, 1, key, strlen(key));
-    if (err != INFRA_OK) goto cleanup;
-    
-    err = poly_db_bind_blob(stmt, 2, value, value_len);
-    if (err != INFRA_OK) goto cleanup;
-    
-    char flags_str[32];
-    snprintf(flags_str, sizeof(flags_str), "%u", flags);
-    err = poly_db_bind_text(stmt, 3, flags_str, strlen(flags_str));
-    if (err != INFRA_OK) goto cleanup;
-    
-    char exptime_str[32];
-    snprintf(exptime_str, sizeof(exptime_str), "%ld", (long)real_exptime);
-    err = poly_db_bind_text(stmt, 4, exptime_str, strlen(exptime_str));
-    if (err != INFRA_OK) goto cleanup;
-    
-    err = poly_db_stmt_step(stmt);
-    
-cleanup:
+
+    for (int i = 1; i <= nparams && err == INFRA_OK; i++) {
+        if (i == 1) {
+            err = poly_db_bind_text(stmt, 1, args->key, strlen(args->key));
+        } else if (i == 2) {
+            // 空 value 也要绑定为零长度 BLOB 而不是 NULL
+            err = poly_db_bind_blob(stmt, 2, args->value ? args->value : "", args->value_len);
+        } else {
+            err = poly_db_bind_text(stmt, i, nums[i - 3], strlen(nums[i - 3]));
+        }
+    }
+    if (err == INFRA_OK) {
+        err = poly_db_stmt_step(stmt);
+    }
+    if (err == INFRA_OK) {
+        err = poly_db_changes(db, changes);
+    }
+
     poly_db_stmt_finalize(stmt);
     return err;
 }
 
-static infra_error_t kv_delete(poly_db_t* db, const char* key) {
-    infra_error_t err;
-    
-    // 开始事务
-    err = poly_db_exec(db, "BEGIN TRANSACTION");
-    if (err != INFRA_OK) return err;
-    
-    // 先检查键是否存在
-    const char* check_sql = "SELECT 1 FROM kv_store WHERE key = ?";
-    poly_db_stmt_t* check_stmt = NULL;
-    err = poly_db_prepare(db, check_sql, &check_stmt);
-    if (err != INFRA_OK) {
-        poly_db_exec(db, "ROLLBACK");
-        return err;
+// 读取未过期的 key, 命中时返回新分配的 item (不入表), value 从结果列直接分块读入 item
+static infra_error_t kv_get(poly_db_t* db, const char* key, size_t nkey, memkv_item_t** item) {
+    if (!db || !key || !item) {
+        INFRA_LOG_ERROR("Invalid parameters");
+        return INFRA_ERROR_INVALID_PARAM;
     }
-    
-    err = poly_db_bind_text(check_stmt, 1, key, strlen(key));
+
+    INFRA_LOG_DEBUG("kv_get for key: [%s]", key);
+
+    poly_db_stmt_t* stmt = NULL;
+    infra_error_t err = poly_db_prepare(db, 
+        "SELECT cas, flags, expiry, value FROM kv_store WHERE key = ?", &stmt);
     if (err != INFRA_OK) {
-        poly_db_stmt_finalize(check_stmt);
-        poly_db_exec(db, "ROLLBACK");
+        INFRA_LOG_ERROR("Failed to prepare statement: %d", err);
         return err;
     }
-    
-    err = poly_db_stmt_step(check_stmt);
-    bool exists = (err == INFRA_OK);  // 如果找到记录，err 会是 INFRA_OK
-    poly_db_stmt_finalize(check_stmt);
-    
-    if (!exists) {
-        poly_db_exec(db, "ROLLBACK");
-        return INFRA_ERROR_NOT_FOUND;
+
+    err = poly_db_bind_text(stmt, 1, key, nkey);
+    if (err == INFRA_OK) {
+        err = poly_db_stmt_step(stmt);
     }
-    
-    // 键存在，执行删除
-    const char* delete_sql = "DELETE FROM kv_store WHERE key = ?";
-    poly_db_stmt_t* delete_stmt = NULL;
-    
-    err = poly_db_prepare(db, delete_sql, &delete_stmt);
     if (err != INFRA_OK) {
-        poly_db_exec(db, "ROLLBACK");
+        INFRA_LOG_ERROR("Failed to execute statement: %d", err);
+        poly_db_stmt_finalize(stmt);
         return err;
     }
-    
-    err = poly_db_bind_text(delete_stmt, 1, key, strlen(key));
-    if (err != INFRA_OK) {
-        poly_db_stmt_finalize(delete_stmt);
-        poly_db_exec(db, "ROLLBACK");
-        return err;
+
+    // cas 列非空, 取不到说明没有这一行
+    char* text = NULL;
+    if (poly_db_column_text(stmt, 0, &text) != INFRA_OK) {
+        poly_db_stmt_finalize(stmt);
+        return INFRA_ERROR_NOT_FOUND;
     }
-    
-    err = poly_db_stmt_step(delete_stmt);
-    poly_db_stmt_finalize(delete_stmt);
-    
-    if (err != INFRA_OK) {
-        poly_db_exec(db, "ROLLBACK");
-        return err;
+    uint64_t cas = strtoull(text, NULL, 10);
+    infra_free(text);
+
+    uint32_t flags = 0;
+    int64_t exptime = 0;
+    if (poly_db_column_text(stmt, 1, &text) == INFRA_OK) {
+        flags = (uint32_t)strtoul(text, NULL, 10);
+        infra_free(text);
     }
-    
-    // 提交事务
-    return poly_db_exec(db, "COMMIT");
-}
-
-static infra_error_t kv_flush(poly_db_t* db) {
-    return poly_db_exec(db, "DELETE FROM kv_store");
-}
-
-static int send_all(infra_socket_t sock, const void* data, size_t len) {
-    if (sock <= 0 || !data || len == 0) {
-        INFRA_LOG_ERROR("Invalid parameters in send_all: sock=%d, data=%p, len=%zu", 
-               sock, data, len);
-        return INFRA_ERROR_INVALID_PARAM;
+    if (poly_db_column_text(stmt, 2, &text) == INFRA_OK) {
+        exptime = strtol(text, NULL, 10);
+        infra_free(text);
     }
 
-    const char* buf = (const char*)data;
-    size_t sent = 0;
-    int retry_count = 0;
-    const int max_retries = 5;  // 增加最大重试次数
-    const int retry_delay_ms = 20;  // 增加重试延迟
-    const int max_consecutive_zero = 3;  // 最大连续零字节发送次数
-    int consecutive_zero = 0;  // 连续零字节发送计数
+    // 过期的行留给后台回收线程删除, 读路径不写库
+    if (exptime > 0 && time(NULL) >= exptime) {
+        poly_db_stmt_finalize(stmt);
+        return INFRA_ERROR_NOT_FOUND;
+    }
 
-    INFRA_LOG_DEBUG("Starting to send %zu bytes", len);
+    size_t size = 0;
+    err = poly_db_column_blob_size(stmt, 3, &size);
+    memkv_item_t* it = err == INFRA_OK ? memkv_item_alloc(key, nkey, flags, exptime, size) : NULL;
+    if (!it) {
+        poly_db_stmt_finalize(stmt);
+        return err == INFRA_OK ? INFRA_ERROR_NO_MEMORY : err;
+    }
 
-    while (sent < len) {
-        size_t bytes_sent = 0;
-        infra_error_t err = infra_net_send(sock, buf + sent, len - sent, &bytes_sent);
-        
-        INFRA_LOG_DEBUG("Send attempt %d: tried to send %zu bytes, sent %zu bytes, err=%d",
-               retry_count + 1, len - sent, bytes_sent, err);
-        
-        if (err == INFRA_ERROR_WOULD_BLOCK) {
-            if (retry_count < max_retries) {
-                INFRA_LOG_DEBUG("Would block, retrying after %dms (retry %d/%d)",
-                       retry_delay_ms, retry_count + 1, max_retries);
-                usleep(retry_delay_ms * 1000);  // 增加重试延迟
-                retry_count++;
-                continue;
-            }
-            INFRA_LOG_ERROR("Send would block after %d retries", max_retries);
-            return err;
-        }
-        
-        if (err != INFRA_OK) {
-            if (retry_count < max_retries) {
-                INFRA_LOG_DEBUG("Send error %d, retrying after %dms (retry %d/%d)",
-                       err, retry_delay_ms, retry_count + 1, max_retries);
-                usleep(retry_delay_ms * 1000);
-                retry_count++;
-                continue;
-            }
-            INFRA_LOG_ERROR("Failed to send data: err=%d", err);
-            return err;
-        }
-        
-        if (bytes_sent == 0) {
-            consecutive_zero++;
-            if (consecutive_zero >= max_consecutive_zero) {
-                if (retry_count < max_retries) {
-                    INFRA_LOG_DEBUG("Zero bytes sent %d times, retrying after %dms (retry %d/%d)",
-                           consecutive_zero, retry_delay_ms, retry_count + 1, max_retries);
-                    usleep(retry_delay_ms * 1000);
-                    retry_count++;
-                    consecutive_zero = 0;  // 重置连续零字节计数
-                    continue;
-                }
-                INFRA_LOG_ERROR("Connection closed by peer after %d retries", max_retries);
-                return INFRA_ERROR_CLOSED;
-            }
-            continue;
+    size_t offset = 0;
+    while (offset < size) {
+        size_t n = 0;
+        err = poly_db_column_blob_chunk(stmt, 3, MEMKV_ITEM_VALUE(it) + offset, size - offset,
+                                        offset, &n);
+        if (err != INFRA_OK || n == 0) {
+            break;
         }
-        
-        sent += bytes_sent;
-        retry_count = 0;  // 重置重试计数
-        consecutive_zero = 0;  // 重置连续零字节计数
-        
-        INFRA_LOG_DEBUG("Successfully sent %zu/%zu bytes", sent, len);
+        offset += n;
+    }
+    poly_db_stmt_finalize(stmt);
+    if (offset < size) {
+        memkv_item_release(it);
+        return err != INFRA_OK ? err : INFRA_ERROR_IO;
     }
 
-    INFRA_LOG_DEBUG("Successfully sent all %zu bytes", len);
+    it->cas = cas;
+    *item = it;
     return INFRA_OK;
 }
 
-static int handle_get(memkv_conn_t* conn, const char* key) {
-    if (!conn || !key || !conn->store) {
-        INFRA_LOG_ERROR("Invalid parameters");
-        return -1;
+// 读取未过期 key 的 CAS, 用于区分条件写入失败的原因
+static infra_error_t kv_get_cas(poly_db_t* db, const char* key, uint64_t* cas) {
+    poly_db_stmt_t* stmt = NULL;
+    infra_error_t err = poly_db_prepare(db,
+        "SELECT cas FROM kv_store WHERE key = ? AND (expiry = 0 OR expiry > ?)", &stmt);
+    if (err != INFRA_OK) {
+        return err;
     }
 
-    // 获取键值对
-    struct kv_pair pair;
-    infra_error_t err = kv_get(conn->store, key, &pair);
-    
-    if (err == INFRA_ERROR_NOT_FOUND) {
-        // 发送 NOT_FOUND 响应
-        err = send_all(conn->sock, "NOT_FOUND\r\n", 11);
-        if (err != INFRA_OK) {
-            INFRA_LOG_ERROR("Failed to send NOT_FOUND response: %d", err);
-            conn->should_close = true;
-            return -1;
-        }
-        return 0;  // 不需要发送 END\r\n，因为这个会在处理完所有 key 后统一发送
-    } else if (err != INFRA_OK) {
-        INFRA_LOG_ERROR("Failed to get key %s: %d", key, err);
-        conn->should_close = true;
-        return -1;
+    char now[24];
+    snprintf(now, sizeof(now), "%ld", (long)time(NULL));
+    err = poly_db_bind_text(stmt, 1, key, strlen(key));
+    if (err == INFRA_OK) {
+        err = poly_db_bind_text(stmt, 2, now, strlen(now));
     }
-
-    if (!pair.value || pair.value_len == 0) {
-        INFRA_LOG_DEBUG("Value is NULL or empty for key %s", key);
-        free(pair.value);  // 确保释放内存
-        return 0;
+    if (err == INFRA_OK) {
+        err = poly_db_stmt_step(stmt);
+    }
+    char* text = NULL;
+    if (err == INFRA_OK) {
+        err = poly_db_column_text(stmt, 0, &text);
     }
+    if (err == INFRA_OK) {
+        *cas = strtoull(text, NULL, 10);
+        infra_free(text);
+    }
+    poly_db_stmt_finalize(stmt);
+    return err;
+}
 
-    // 发送响应头
-    char response[32];
-    int header_len = snprintf(response, sizeof(response), "VALUE %s %u %zu\r\n", 
-                            key, pair.flags, pair.value_len);
-    if (header_len < 0 || header_len >= (int)sizeof(response)) {
-        INFRA_LOG_ERROR("Response header too long for key %s", key);
-        free(pair.value);
-        return -1;
+// 按模式写入, 返回值与 memkv_store_store 相同
+static infra_error_t kv_store_op(poly_db_t* db, memkv_store_mode_t mode, kv_args_t* args,
+                                 uint64_t* new_cas) {
+    const char* sql;
+    int nparams = 6;
+    switch (mode) {
+        case MEMKV_STORE_SET: sql = KV_SQL_SET; nparams = 5; break;
+        case MEMKV_STORE_ADD: sql = KV_SQL_ADD; break;
+        case MEMKV_STORE_REPLACE: sql = KV_SQL_REPLACE; break;
+        case MEMKV_STORE_APPEND: sql = KV_SQL_APPEND; break;
+        case MEMKV_STORE_PREPEND: sql = KV_SQL_PREPEND; break;
+        case MEMKV_STORE_CAS: sql = KV_SQL_CAS; nparams = 7; break;
+        default: return INFRA_ERROR_INVALID_PARAM;
     }
 
-    // 发送响应头
-    err = send_all(conn->sock, response, header_len);
+    args->cas = __atomic_add_fetch(&get_state()->db_next_cas, 1, __ATOMIC_RELAXED);
+    uint64_t changes = 0;
+    infra_error_t err = kv_exec(db, sql, nparams, args, &changes);
     if (err != INFRA_OK) {
-        INFRA_LOG_ERROR("Failed to send response header: %d", err);
-        free(pair.value);
-        conn->should_close = true;
-        return -1;
+        return err;
+    }
+    if (changes > 0) {
+        if (new_cas) {
+            *new_cas = args->cas;
+        }
+        return INFRA_OK;
     }
 
-    // 发送值
-    err = send_all(conn->sock, pair.value, pair.value_len);
-    if (err != INFRA_OK) {
-        INFRA_LOG_ERROR("Failed to send value: %d", err);
-        free(pair.value);
-        conn->should_close = true;
-        return -1;
+    if (mode == MEMKV_STORE_ADD) {
+        return INFRA_ERROR_EXISTS;
+    }
+    uint64_t cas = 0;
+    if (mode == MEMKV_STORE_CAS && kv_get_cas(db, args->key, &cas) == INFRA_OK) {
+        return INFRA_ERROR_CAS_MISMATCH;
     }
+    return INFRA_ERROR_NOT_FOUND;
+}
 
-    // 发送值后的换行
-    err = send_all(conn->sock, "\r\n", 2);
+static infra_error_t kv_touch(poly_db_t* db, const char* key, int64_t expiry) {
+    kv_args_t args = {.key = key, .expiry = expiry};
+    uint64_t changes = 0;
+    infra_error_t err = kv_exec(db, KV_SQL_TOUCH, 6, &args, &changes);
     if (err != INFRA_OK) {
-        INFRA_LOG_ERROR("Failed to send newline: %d", err);
-        free(pair.value);
-        conn->should_close = true;
-        return -1;
+        return err;
     }
+    return changes > 0 ? INFRA_OK : INFRA_ERROR_NOT_FOUND;
+}
 
-    INFRA_LOG_INFO("Successfully sent key-value pair: [%s]=[%.*s]", 
-                   key, (int)pair.value_len, (char*)pair.value);
-    free(pair.value);
-    return 1;
+// 单条条件删除, cas 非 0 时只删除 CAS 匹配的值
+static infra_error_t kv_delete(poly_db_t* db, const char* key, uint64_t cas) {
+    kv_args_t args = {.key = key, .cmp_cas = cas};
+    uint64_t changes = 0;
+    infra_error_t err = kv_exec(db, cas ? KV_SQL_DELETE_CAS : KV_SQL_DELETE, cas ? 7 : 6,
+                                &args, &changes);
+    if (err != INFRA_OK) {
+        return err;
+    }
+    if (changes > 0) {
+        return INFRA_OK;
+    }
+    uint64_t current = 0;
+    if (cas && kv_get_cas(db, key, &current) == INFRA_OK) {
+        return INFRA_ERROR_CAS_MISMATCH;
+    }
+    return INFRA_ERROR_NOT_FOUND;
 }
 
-static void handle_request(memkv_conn_t* conn) {
-    if (!conn || !conn->rx_buf || conn->sock <= 0) {
-        INFRA_LOG_ERROR("Invalid connection state");
-        return;
+// DuckDB 上的数值增减: 读取和写回在同一个写事务内完成, 由数据库串行化
+static infra_error_t kv_incr_txn(poly_db_t* db, const char* key, size_t nkey, uint64_t delta,
+                                 bool incr, bool create, uint64_t initial, int64_t expiry,
+                                 uint64_t* value, bool* created) {
+    bool own_txn = get_state()->writer == NULL;
+    infra_error_t err = INFRA_OK;
+    if (own_txn) {
+        err = poly_db_exec(db, "BEGIN TRANSACTION");
+        if (err != INFRA_OK) {
+            return err;
+        }
     }
 
-    // 检查缓冲区空间
-    size_t remaining_space = MEMKV_CONN_BUFFER_SIZE - conn->rx_len - 1;
-    if (remaining_space < 1024) {  // 如果剩余空间小于1KB
-        if (conn->set_bytes > 0) {  // 如果正在处理SET命令的数据部分
-            // 继续接收数据
-            remaining_space = MEMKV_CONN_BUFFER_SIZE - conn->rx_len - 1;
-            if (remaining_space == 0) {
-                INFRA_LOG_ERROR("Buffer full while receiving SET data");
-                send_all(conn->sock, "SERVER_ERROR buffer full\r\n", 24);
-                conn->should_close = true;
-                return;
-            }
+    kv_args_t args = {.key = key};
+    const char* sql = KV_SQL_UPDATE_VALUE;
+    uint64_t current = 0;
+    memkv_item_t* it = NULL;
+    err = kv_get(db, key, nkey, &it);
+    if (err == INFRA_ERROR_NOT_FOUND && create) {
+        // 已过期的行一并替换
+        sql = KV_SQL_SET;
+        args.expiry = expiry;
+        current = initial;
+        err = INFRA_OK;
+    } else if (err == INFRA_OK) {
+        memkv_span_t text = {MEMKV_ITEM_VALUE(it), it->nbytes};
+        if (!memkv_span_to_u64(text, &current)) {
+            err = INFRA_ERROR_INVALID_PARAM;
+        } else if (incr) {
+            current += delta;
         } else {
-            // 移动未完成的命令到缓冲区开始
-            if (conn->rx_len > 0) {
-                memmove(conn->rx_buf, conn->rx_buf, conn->rx_len);
-            }
-            remaining_space = MEMKV_CONN_BUFFER_SIZE - conn->rx_len - 1;
+            current = current < delta ? 0 : current - delta;
         }
+        memkv_item_release(it);
     }
 
-    // 接收数据
-    size_t received = 0;
-    infra_error_t err = infra_net_recv(conn->sock, 
-                                      conn->rx_buf + conn->rx_len,
-                                      remaining_space, 
-                                      &received);
-    
-    if (err == INFRA_ERROR_IO) {
-        // 检查是否是非阻塞错误
-        if (errno == EAGAIN || errno == EWOULDBLOCK) {
-            return;  // 暂时没有数据可读，稍后再试
-        }
-        INFRA_LOG_ERROR("Failed to receive data from %s: %s", 
+    char buf[24];
+    if (err == INFRA_OK) {
+        args.value = buf;
+        args.value_len = (size_t)snprintf(buf, sizeof(buf), "%lu", (unsigned long)current);
+        args.cas = __atomic_add_fetch(&get_state()->db_next_cas, 1, __ATOMIC_RELAXED);
+        uint64_t changes = 0;
+        err = kv_exec(db, sql, 5, &args, &changes);
+    }
+
+    if (err == INFRA_OK && own_txn) {
+        err = poly_db_exec(db, "COMMIT");
+    }
+    if (err != INFRA_OK) {
+        // 组提交的事务里还有其他连接的写入, 出错的语句不影响它们
+        if (own_txn) {
+            poly_db_exec(db, "ROLLBACK");
+        }
+        return err;
+    }
+    *value = current;
+    *created = sql == KV_SQL_SET;
+    return INFRA_OK;
+}
+
+// incr 没有匹配的行: key 存在说明 value 不是数字
+static infra_error_t kv_incr_miss(poly_db_t* db, const char* key) {
+    uint64_t cas = 0;
+    return kv_get_cas(db, key, &cas) == INFRA_OK ? INFRA_ERROR_INVALID_PARAM : INFRA_ERROR_NOT_FOUND;
+}
+
+// 执行一次 KV_SQL_INCR/KV_SQL_DECR, 没有可运算的行时返回 INFRA_ERROR_NOT_FOUND
+static infra_error_t kv_incr_update(poly_db_t* db, const char* key, size_t nkey,
+                                    uint64_t delta, bool incr, uint64_t* value) {
+    char nums[4][24];
+    snprintf(nums[0], sizeof(nums[0]), "%ld", (long)time(NULL));
+    snprintf(nums[1], sizeof(nums[1]), "%lu",
+             (unsigned long)__atomic_add_fetch(&get_state()->db_next_cas, 1, __ATOMIC_RELAXED));
+    snprintf(nums[2], sizeof(nums[2]), "%lu", (unsigned long)(delta / 10000000000ULL));
+    snprintf(nums[3], sizeof(nums[3]), "%lu", (unsigned long)(delta % 10000000000ULL));
+
+    poly_db_stmt_t* stmt = NULL;
+    infra_error_t err = poly_db_prepare(db, incr ? KV_SQL_INCR : KV_SQL_DECR, &stmt);
+    if (err != INFRA_OK) {
+        INFRA_LOG_ERROR("Failed to prepare statement: %d", err);
+        return err;
+    }
+    err = poly_db_bind_text(stmt, 1, key, nkey);
+    for (int i = 0; i < 4 && err == INFRA_OK; i++) {
+        err = poly_db_bind_text(stmt, i + 2, nums[i], strlen(nums[i]));
+    }
+    if (err == INFRA_OK) {
+        err = poly_db_stmt_step(stmt);
+    }
+    char* text = NULL;
+    if (err == INFRA_OK) {
+        err = poly_db_column_text(stmt, 0, &text);
+    }
+    if (err == INFRA_OK) {
+        *value = strtoull(text, NULL, 10);
+        infra_free(text);
+    }
+    poly_db_stmt_finalize(stmt);
+    return err;
+}
+
+// 数值增减 (语义同 memkv_store_incr): 命中时读取和写回是同一条 UPDATE, 不需要
+// 显式事务, 借用不同句柄的 reactor 并发 incr 时由数据库串行化, 不会丢失更新.
+// 未命中且 create 时按 add 写入 initial, 与并发的创建者冲突时再 incr 一次
+static infra_error_t kv_incr(poly_db_t* db, const char* key, size_t nkey, uint64_t delta,
+                             bool incr, bool create, uint64_t initial, int64_t expiry,
+                             uint64_t* value, bool* created) {
+    if (poly_db_get_type(db) != POLY_DB_TYPE_SQLITE) {
+        return kv_incr_txn(db, key, nkey, delta, incr, create, initial, expiry, value, created);
+    }
+
+    *created = false;
+    infra_error_t err = kv_incr_update(db, key, nkey, delta, incr, value);
+    if (err != INFRA_ERROR_NOT_FOUND || !create) {
+        return err == INFRA_ERROR_NOT_FOUND ? kv_incr_miss(db, key) : err;
+    }
+
+    char buf[24];
+    kv_args_t args = {.key = key, .value = buf, .expiry = expiry};
+    args.value_len = (size_t)snprintf(buf, sizeof(buf), "%lu", (unsigned long)initial);
+    args.cas = __atomic_add_fetch(&get_state()->db_next_cas, 1, __ATOMIC_RELAXED);
+    uint64_t changes = 0;
+    err = kv_exec(db, KV_SQL_ADD, 6, &args, &changes);
+    if (err != INFRA_OK) {
+        return err;
+    }
+    if (changes > 0) {
+        *value = initial;
+        *created = true;
+        return INFRA_OK;
+    }
+    err = kv_incr_update(db, key, nkey, delta, incr, value);
+    return err == INFRA_ERROR_NOT_FOUND ? kv_incr_miss(db, key) : err;
+}
+
+static infra_error_t kv_flush(poly_db_t* db) {
+    return poly_db_exec(db, "DELETE FROM kv_store");
+}
+
+//-----------------------------------------------------------------------------
+// Shards
+//-----------------------------------------------------------------------------
+
+// 在分片属主线程上执行的操作
+typedef void (*memkv_shard_fn)(memkv_store_t* store, void* arg);
+
+// mailbox 中的消息: 属主执行完请求后把同一个 msg 投回发起方作为回复
+typedef struct memkv_shard_msg {
+    struct memkv_shard_msg* next;
+    memkv_shard_fn fn;           // NULL 表示回复
+    void* arg;
+    memkv_conn_t* conn;          // 发起请求的连接
+} memkv_shard_msg_t;
+
+// 单 key 操作的参数和结果
+typedef struct memkv_shard_op {
+    const char* key;
+    size_t nkey;
+    memkv_store_mode_t mode;
+    const void* value;
+    size_t value_len;
+    uint32_t flags;
+    int64_t expiry;
+    uint64_t cas;                // store/delete 比较用的 CAS
+    uint64_t new_cas;
+    memkv_item_t** item;         // get/touch/alloc 返回的 item, 可为 NULL
+    memkv_item_t* value_item;    // store: 已读入 value 的 item (流式接收), 非空时直接挂表
+    uint64_t delta;              // incr/decr 的增量
+    uint64_t initial;            // incr/decr 未命中时创建的初值
+    bool incr;
+    bool create;
+    uint64_t number;             // incr/decr 的结果
+    bool created;                // incr/decr 未命中时新建
+    infra_error_t err;
+} memkv_shard_op_t;
+
+// 多 key get 中落在同一分片的一组 key
+typedef struct memkv_shard_batch {
+    const memkv_span_t* keys;
+    int count;
+    bool touch;                  // gat/gats
+    int64_t expiry;
+    memkv_item_t** items;        // 按 keys 下标返回结果
+    infra_error_t* errs;
+} memkv_shard_batch_t;
+
+// 投递给其他分片的一次调用, 挂在发起连接上直到所在的命令执行完毕.
+// 命令重新执行时按 (fn, key, 分片, key 数) 匹配取回结果, 不再重复投递
+typedef struct memkv_shard_call {
+    struct memkv_shard_call* next;
+    memkv_shard_msg_t msg;
+    memkv_shard_fn fn;
+    const char* key;             // 指向接收缓冲区或流式 item, 命令完成前地址不变
+    int shard;
+    int count;
+    bool used;                   // 本次执行已取用
+    memkv_item_t* item;          // op 返回的 item, 由记录持有引用
+    memkv_shard_op_t op;
+    memkv_shard_batch_t batch;   // 多 key get, 数组紧随记录之后
+} memkv_shard_call_t;
+
+static int shard_index(const memkv_state_t* state, const char* key, size_t nkey) {
+    // 取哈希的中间 32 位: store 的段用最高位, 桶用最低位, 分片内的 key 仍能均匀分布
+    return (int)((uint32_t)(memkv_hash(key, nkey) >> 32) % (uint32_t)state->shard_count);
+}
+
+static void shard_post(memkv_reactor_t* owner, memkv_shard_msg_t* msg) {
+    memkv_shard_msg_t* head = __atomic_load_n(&owner->mailbox, __ATOMIC_RELAXED);
+    do {
+        msg->next = head;
+    } while (!__atomic_compare_exchange_n(&owner->mailbox, &head, msg, true,
+                                          __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+    // 原本为空时属主可能阻塞在 wait 中; 不为空说明已有人唤醒过它
+    if (!head) {
+        poly_poll_loop_wakeup(owner->loop);
+    }
+}
+
+// 回复到达: 连接的调用全部回复后挂到 ready 链表, 由事件循环重新执行暂停的命令;
+// 已关闭的连接此时才释放
+static void shard_reply(memkv_reactor_t* reactor, memkv_conn_t* conn) {
+    __atomic_fetch_sub(&get_state()->shard_inflight, 1, __ATOMIC_ACQ_REL);
+    if (--conn->call_pending > 0) {
+        return;
+    }
+    if (conn->is_closing) {
+        memkv_conn_destroy(conn);
+        return;
+    }
+    conn->shard_ready = true;
+    conn->ready_next = reactor->ready;
+    reactor->ready = conn;
+}
+
+// 执行其他 reactor 投递过来的请求并投回回复, 处理投回本线程的回复.
+// mailbox 是无锁栈, 一次取走全部后反转, 按投递顺序处理
+static void shard_drain(memkv_reactor_t* reactor) {
+    if (!__atomic_load_n(&reactor->mailbox, __ATOMIC_RELAXED)) {
+        return;
+    }
+    memkv_shard_msg_t* msg = __atomic_exchange_n(&reactor->mailbox, NULL, __ATOMIC_ACQUIRE);
+    memkv_shard_msg_t* list = NULL;
+    while (msg) {
+        memkv_shard_msg_t* next = msg->next;
+        msg->next = list;
+        list = msg;
+        msg = next;
+    }
+    while (list) {
+        // 投回后发起方随时会释放 msg
+        memkv_shard_msg_t* next = list->next;
+        if (list->fn) {
+            list->fn(reactor->shard, list->arg);
+            list->fn = NULL;
+            shard_post(list->conn->reactor, list);
+        } else {
+            shard_reply(reactor, list->conn);
+        }
+        list = next;
+    }
+}
+
+static memkv_shard_call_t* shard_call_new(memkv_shard_fn fn, const char* key, int shard,
+                                          int count, size_t extra) {
+    memkv_shard_call_t* call = infra_malloc(sizeof(memkv_shard_call_t) + extra);
+    if (!call) {
+        return NULL;
+    }
+    memset(call, 0, sizeof(memkv_shard_call_t));
+    call->fn = fn;
+    call->key = key;
+    call->shard = shard;
+    call->count = count;
+    call->used = true;
+    return call;
+}
+
+// 投递给属主, 连接从此暂停到回复到齐
+static void shard_send(memkv_conn_t* conn, memkv_shard_call_t* call, void* arg) {
+    memkv_state_t* state = get_state();
+    call->msg = (memkv_shard_msg_t){.fn = call->fn, .arg = arg, .conn = conn};
+    call->next = conn->calls;
+    conn->calls = call;
+    conn->call_pending++;
+    __atomic_fetch_add(&state->shard_inflight, 1, __ATOMIC_ACQ_REL);
+    shard_post(&state->reactors[call->shard], &call->msg);
+}
+
+// 重新执行时取回本次尚未取用的同一调用
+static memkv_shard_call_t* shard_call_find(memkv_conn_t* conn, memkv_shard_fn fn,
+                                           const char* key, int shard, int count) {
+    for (memkv_shard_call_t* call = conn->calls; call; call = call->next) {
+        if (!call->used && call->fn == fn && call->key == key && call->shard == shard &&
+            call->count == count) {
+            call->used = true;
+            return call;
+        }
+    }
+    return NULL;
+}
+
+// 命令执行完毕, 释放调用记录及其持有的 item
+static void shard_calls_clear(memkv_conn_t* conn) {
+    while (conn->calls) {
+        memkv_shard_call_t* call = conn->calls;
+        conn->calls = call->next;
+        if (call->item) {
+            memkv_item_release(call->item);
+        }
+        for (int i = 0; i < call->batch.count; i++) {
+            if (call->batch.errs[i] == INFRA_OK) {
+                memkv_item_release(call->batch.items[i]);
+            }
+        }
+        infra_free(call);
+    }
+}
+
+// 在 key 所属的分片上执行 fn. 本线程的分片直接执行; 其他分片的调用投递给属主后返回
+// INFRA_ERROR_WOULD_BLOCK, 命令暂停, 回复到齐后整条命令重新执行并取回结果.
+// 本线程分片上的调用每次执行都会重做, 一条命令中先于远程调用的只有读取和幂等的写入.
+// 非分片模式下所有 reactor 共享一个 store
+static void shard_call(memkv_conn_t* conn, const char* key, size_t nkey,
+                       memkv_shard_fn fn, memkv_shard_op_t* op) {
+    memkv_state_t* state = get_state();
+    if (!state->sharded) {
+        fn(state->store, op);
+        return;
+    }
+
+    int shard = shard_index(state, key, nkey);
+    memkv_shard_call_t* call = conn->calls ? shard_call_find(conn, fn, key, shard, 1) : NULL;
+    if (call) {
+        // item 另加一份引用交给调用者, 记录的引用在命令完成时释放
+        op->err = call->op.err;
+        op->new_cas = call->op.new_cas;
+        op->number = call->op.number;
+        op->created = call->op.created;
+        if (op->item) {
+            *op->item = call->item;
+            if (call->item) {
+                memkv_item_ref(call->item);
+            }
+        }
+        return;
+    }
+    if (conn->call_pending == 0 && shard == conn->reactor->id) {
+        fn(conn->reactor->shard, op);
+        return;
+    }
+
+    // 命令已经要暂停时不再执行后续调用, 重新执行时再投递
+    op->err = INFRA_ERROR_WOULD_BLOCK;
+    if (op->item) {
+        *op->item = NULL;
+    }
+    if (conn->call_pending > 0) {
+        return;
+    }
+    call = shard_call_new(fn, key, shard, 1, 0);
+    if (!call) {
+        op->err = INFRA_ERROR_NO_MEMORY;
+        return;
+    }
+    call->op = *op;
+    call->op.item = op->item ? &call->item : NULL;
+    shard_send(conn, call, &call->op);
+}
+
+// 在每个分片上执行 fn (flush_all), 本分片在其他分片都执行完后执行
+static infra_error_t shard_broadcast(memkv_conn_t* conn, memkv_shard_fn fn, void* arg) {
+    memkv_state_t* state = get_state();
+    if (!state->sharded) {
+        fn(state->store, arg);
+        return INFRA_OK;
+    }
+
+    bool blocked = conn->call_pending > 0;
+    infra_error_t err = INFRA_OK;
+    for (int i = 0; i < state->shard_count; i++) {
+        if (i == conn->reactor->id || (conn->calls && shard_call_find(conn, fn, NULL, i, 0))) {
+            continue;
+        }
+        memkv_shard_call_t* call = blocked ? NULL : shard_call_new(fn, NULL, i, 0, 0);
+        if (!call) {
+            err = blocked ? INFRA_ERROR_WOULD_BLOCK : INFRA_ERROR_NO_MEMORY;
+            continue;
+        }
+        shard_send(conn, call, arg);
+    }
+    if (conn->call_pending > 0) {
+        return INFRA_ERROR_WOULD_BLOCK;
+    }
+    if (err == INFRA_OK) {
+        fn(conn->reactor->shard, arg);
+    }
+    return err;
+}
+
+static void shard_op_get(memkv_store_t* store, void* arg) {
+    memkv_shard_op_t* op = arg;
+    op->err = memkv_store_get(store, op->key, op->nkey, op->item);
+}
+
+static void shard_op_store(memkv_store_t* store, void* arg) {
+    memkv_shard_op_t* op = arg;
+    if (op->value_item) {
+        // 流式接收的 item 未挂表, 只有本连接持有
+        op->value_item->flags = op->flags;
+        op->value_item->exptime = op->expiry;
+        op->err = memkv_store_store(store, op->value_item, op->mode, op->cas, &op->new_cas);
+        return;
+    }
+
+    memkv_item_t* it = memkv_store_item_alloc(store, op->key, op->nkey, op->flags,
+                                              op->expiry, op->value_len);
+    if (!it) {
+        op->err = INFRA_ERROR_NO_MEMORY;
+        return;
+    }
+    if (op->value_len > 0) {
+        memcpy(MEMKV_ITEM_VALUE(it), op->value, op->value_len);
+    }
+    op->err = memkv_store_store(store, it, op->mode, op->cas, &op->new_cas);
+    memkv_item_release(it);
+}
+
+// 为流式接收分配未挂表的 item, value 由发起方填充
+static void shard_op_alloc(memkv_store_t* store, void* arg) {
+    memkv_shard_op_t* op = arg;
+    *op->item = memkv_store_item_alloc(store, op->key, op->nkey, 0, 0, op->value_len);
+    op->err = *op->item ? INFRA_OK : INFRA_ERROR_NO_MEMORY;
+}
+
+static void shard_op_touch(memkv_store_t* store, void* arg) {
+    memkv_shard_op_t* op = arg;
+    op->err = memkv_store_touch(store, op->key, op->nkey, op->expiry, op->item);
+}
+
+static void shard_op_delete(memkv_store_t* store, void* arg) {
+    memkv_shard_op_t* op = arg;
+    op->err = memkv_store_delete(store, op->key, op->nkey, op->cas);
+}
+
+static void shard_op_incr(memkv_store_t* store, void* arg) {
+    memkv_shard_op_t* op = arg;
+    op->err = memkv_store_incr(store, op->key, op->nkey, op->delta, op->incr, op->create,
+                               op->initial, op->expiry, &op->number, &op->created, NULL);
+}
+
+static void shard_op_flush(memkv_store_t* store, void* arg) {
+    (void)arg;
+    memkv_store_flush(store);
+}
+
+static infra_error_t shard_get_key(memkv_store_t* store, const memkv_span_t* key, bool touch,
+                                   int64_t expiry, memkv_item_t** item) {
+    *item = NULL;
+    return touch ? memkv_store_touch(store, key->ptr, key->len, expiry, item)
+                 : memkv_store_get(store, key->ptr, key->len, item);
+}
+
+static void shard_op_get_batch(memkv_store_t* store, void* arg) {
+    memkv_shard_batch_t* batch = arg;
+    for (int i = 0; i < batch->count; i++) {
+        batch->errs[i] = shard_get_key(store, &batch->keys[i], batch->touch, batch->expiry,
+                                       &batch->items[i]);
+    }
+}
+
+// 查询一批 key: 按分片分组, 其他分片的每组投递一条请求, 本分片的 key 直接执行.
+// 有请求在途时命令随后暂停, 尚无结果的 key 为 INFRA_ERROR_WOULD_BLOCK;
+// cached 非空时跳过其中已从副本缓存得到结果的 key
+static void shard_get_batch(memkv_conn_t* conn, const memkv_span_t* keys, int count,
+                            bool touch, int64_t expiry, const bool* cached,
+                            memkv_item_t** items, infra_error_t* errs) {
+    memkv_state_t* state = get_state();
+    int index[MEMKV_SHARD_GET_BATCH];
+    int start[MEMKV_MAX_THREADS + 1] = {0};
+    int shards[MEMKV_SHARD_GET_BATCH];
+
+    // 按分片计数排序, 同一分片的下标连续存放
+    for (int i = 0; i < count; i++) {
+        if (cached && cached[i]) {
+            continue;
+        }
+        shards[i] = shard_index(state, keys[i].ptr, keys[i].len);
+        start[shards[i] + 1]++;
+    }
+    for (int s = 0; s < state->shard_count; s++) {
+        start[s + 1] += start[s];
+    }
+    int fill[MEMKV_MAX_THREADS];
+    memcpy(fill, start, sizeof(int) * state->shard_count);
+    for (int i = 0; i < count; i++) {
+        if (!cached || !cached[i]) {
+            index[fill[shards[i]]++] = i;
+        }
+    }
+
+    bool blocked = conn->call_pending > 0;
+    int self = conn->reactor->id;
+    for (int s = 0; s < state->shard_count; s++) {
+        const int* group = &index[start[s]];
+        int n = start[s + 1] - start[s];
+        if (n == 0) {
+            continue;
+        }
+        if (s == self) {
+            for (int i = 0; i < n; i++) {
+                int k = group[i];
+                errs[k] = blocked ? INFRA_ERROR_WOULD_BLOCK
+                                  : shard_get_key(conn->reactor->shard, &keys[k], touch, expiry, &items[k]);
+            }
+            continue;
+        }
+
+        memkv_shard_call_t* call = conn->calls
+            ? shard_call_find(conn, shard_op_get_batch, keys[group[0]].ptr, s, n) : NULL;
+        if (call) {
+            for (int i = 0; i < n; i++) {
+                int k = group[i];
+                errs[k] = call->batch.errs[i];
+                items[k] = call->batch.items[i];
+                if (errs[k] == INFRA_OK) {
+                    memkv_item_ref(items[k]);
+                }
+            }
+            continue;
+        }
+
+        infra_error_t err = INFRA_ERROR_WOULD_BLOCK;
+        if (!blocked) {
+            // 本组的 key、结果数组随记录一起分配
+            size_t extra = n * (sizeof(memkv_span_t) + sizeof(memkv_item_t*) + sizeof(infra_error_t));
+            call = shard_call_new(shard_op_get_batch, keys[group[0]].ptr, s, n, extra);
+            if (call) {
+                memkv_span_t* batch_keys = (memkv_span_t*)(call + 1);
+                for (int i = 0; i < n; i++) {
+                    batch_keys[i] = keys[group[i]];
+                }
+                call->batch = (memkv_shard_batch_t){
+                    .keys = batch_keys,
+                    .count = n,
+                    .touch = touch,
+                    .expiry = expiry,
+                    .items = (memkv_item_t**)(batch_keys + n),
+                    .errs = (infra_error_t*)((memkv_item_t**)(batch_keys + n) + n)
+                };
+                shard_send(conn, call, &call->batch);
+            } else {
+                err = INFRA_ERROR_NO_MEMORY;
+            }
+        }
+        for (int i = 0; i < n; i++) {
+            items[group[i]] = NULL;
+            errs[group[i]] = err;
+        }
+    }
+}
+
+// memory 引擎的存储统计, 分片模式下汇总各分片 (字段全为 uint64_t)
+static bool store_stats_total(memkv_state_t* state, memkv_store_stats_t* total) {
+    if (state->engine != MEMKV_ENGINE_MEMORY) {
+        return false;
+    }
+    if (!state->sharded) {
+        if (!state->store) {
+            return false;
+        }
+        memkv_store_get_stats(state->store, total);
+        return true;
+    }
+    if (!state->shards) {
+        return false;
+    }
+
+    memset(total, 0, sizeof(*total));
+    for (int i = 0; i < state->shard_count; i++) {
+        memkv_store_stats_t st;
+        memkv_store_get_stats(state->shards[i], &st);
+        const uint64_t* src = (const uint64_t*)&st;
+        uint64_t* dst = (uint64_t*)total;
+        for (size_t j = 0; j < sizeof(st) / sizeof(uint64_t); j++) {
+            dst[j] += src[j];
+        }
+    }
+    return true;
+}
+
+// 各 slab class 的统计, 分片模式下按 class 汇总 (各分片的 class 划分相同)
+static int store_slab_stats_total(memkv_state_t* state, memkv_slab_stats_t* slabs, int max) {
+    if (state->engine != MEMKV_ENGINE_MEMORY) {
+        return 0;
+    }
+    if (!state->sharded) {
+        return state->store ? memkv_store_get_slab_stats(state->store, slabs, max) : 0;
+    }
+    if (!state->shards) {
+        return 0;
+    }
+
+    int n = memkv_store_get_slab_stats(state->shards[0], slabs, max);
+    for (int i = 1; i < state->shard_count; i++) {
+        memkv_slab_stats_t st[MEMKV_SLAB_MAX_CLASSES];
+        int m = memkv_store_get_slab_stats(state->shards[i], st, max);
+        for (int c = 0; c < n && c < m; c++) {
+            slabs[c].total_pages += st[c].total_pages;
+            slabs[c].used_chunks += st[c].used_chunks;
+            slabs[c].free_chunks += st[c].free_chunks;
+            slabs[c].curr_items += st[c].curr_items;
+            slabs[c].evictions += st[c].evictions;
+            slabs[c].outofmemory += st[c].outofmemory;
+        }
+    }
+    return n;
+}
+
+//-----------------------------------------------------------------------------
+// Hot Keys
+//-----------------------------------------------------------------------------
+
+// get 之前: 采样到的访问计入热点统计并照常查 store (store 的 LRU 因此仍能看到热点),
+// 其余访问先查本线程的副本缓存. 命中返回 true; *hot 表示采样到的 key 已是热点
+static bool hotkeys_before_get(memkv_reactor_t* reactor, const char* key, size_t nkey,
+                               memkv_item_t** item, bool* hot) {
+    *hot = false;
+    if (memkv_hotkeys_sample(reactor->hotkeys)) {
+        *hot = memkv_hotkeys_record(reactor->hotkeys, key, nkey, memkv_hash(key, nkey));
+        return false;
+    }
+    if (reactor->hotcache &&
+        memkv_hotcache_get(reactor->hotcache, key, nkey, memkv_hash(key, nkey), item)) {
+        reactor->stats.hotcache_hits++;
+        return true;
+    }
+    return false;
+}
+
+// get 之后: 热点 key 收录进副本缓存
+static void hotkeys_after_get(memkv_reactor_t* reactor, bool hot, infra_error_t err,
+                              memkv_item_t* item) {
+    if (hot && err == INFRA_OK && reactor->hotcache) {
+        memkv_hotcache_put(reactor->hotcache, item);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Engine Dispatch
+//-----------------------------------------------------------------------------
+
+static bool engine_ready(memkv_conn_t* conn) {
+    memkv_state_t* state = get_state();
+    if (!state) {
+        return false;
+    }
+    if (state->engine != MEMKV_ENGINE_MEMORY) {
+        return conn->store != NULL;
+    }
+    return state->sharded ? state->shards != NULL : state->store != NULL;
+}
+
+// 组提交时写入在写句柄的当前事务中执行, 只在单条语句期间持有写句柄, 事务编号记入连接,
+// 响应等该事务提交后再发送. 本连接有未提交的写入时读取也走写句柄, 以读到自己的写入;
+// 其余读取用本批借用的连接池句柄, 不与写入争抢
+static poly_db_t* engine_db_begin(memkv_conn_t* conn, bool write) {
+    memkv_state_t* state = get_state();
+    if (!state->writer || (!write && !conn->commit_last)) {
+        return conn->store;
+    }
+    return poly_db_writer_begin(state->writer);
+}
+
+static void engine_db_end(memkv_conn_t* conn, poly_db_t* db) {
+    if (!db || db == conn->store) {
+        return;
+    }
+    uint64_t ticket = poly_db_writer_end(get_state()->writer);
+    if (ticket) {
+        if (!conn->commit_first) {
+            conn->commit_first = ticket;
+        }
+        conn->commit_last = ticket;
+    }
+}
+
+// SQLite/DuckDB 路径绑定 SQL 参数时需要以 '\0' 结尾的 key
+static bool engine_key_cstr(char* buf, const char* key, size_t nkey) {
+    if (nkey == 0 || nkey > MEMKV_STORE_MAX_KEY_LEN) {
+        return false;
+    }
+    memcpy(buf, key, nkey);
+    buf[nkey] = '\0';
+    return true;
+}
+
+// 查找 key, 命中时返回持有引用的 item, 用完需 memkv_item_release (不计入统计)
+static infra_error_t engine_lookup(memkv_conn_t* conn, const char* key, size_t nkey,
+                                   memkv_item_t** item) {
+    memkv_state_t* state = get_state();
+    // 重新执行暂停的命令时不查副本缓存, 调用序列与上次一致
+    bool hot = false;
+    if (!conn->calls && hotkeys_before_get(conn->reactor, key, nkey, item, &hot)) {
+        return INFRA_OK;
+    }
+    if (state->engine == MEMKV_ENGINE_MEMORY) {
+        memkv_shard_op_t op = {.key = key, .nkey = nkey, .item = item};
+        shard_call(conn, key, nkey, shard_op_get, &op);
+        hotkeys_after_get(conn->reactor, hot, op.err, op.err == INFRA_OK ? *item : NULL);
+        return op.err;
+    }
+
+    char ckey[MEMKV_STORE_MAX_KEY_LEN + 1];
+    if (!engine_key_cstr(ckey, key, nkey)) {
+        return INFRA_ERROR_INVALID_PARAM;
+    }
+
+    poly_db_t* db = engine_db_begin(conn, false);
+    infra_error_t err = db ? kv_get(db, ckey, nkey, item) : INFRA_ERROR_IO;
+    engine_db_end(conn, db);
+    return err;
+}
+
+static void engine_count_get(memkv_conn_t* conn, infra_error_t err) {
+    memkv_stats_t* stats = &conn->reactor->stats;
+    stats->cmd_get++;
+    if (err == INFRA_OK) {
+        stats->get_hits++;
+    } else if (err == INFRA_ERROR_NOT_FOUND) {
+        stats->get_misses++;
+    }
+}
+
+static void engine_count_touch(memkv_conn_t* conn, infra_error_t err) {
+    memkv_stats_t* stats = &conn->reactor->stats;
+    stats->cmd_touch++;
+    if (err == INFRA_OK) {
+        stats->touch_hits++;
+    } else if (err == INFRA_ERROR_NOT_FOUND) {
+        stats->touch_misses++;
+    }
+}
+
+static infra_error_t engine_get(memkv_conn_t* conn, const char* key, size_t nkey, memkv_item_t** item) {
+    infra_error_t err = engine_lookup(conn, key, nkey, item);
+    engine_count_get(conn, err);
+    return err;
+}
+
+// 为流式接收的数据块分配 item: memory 引擎从 key 所属分片的 slab 分配, 到齐后直接挂表;
+// 数据库引擎的 item 只用来存放 value, 写库时直接绑定
+static memkv_item_t* engine_item_alloc(memkv_conn_t* conn, const char* key, size_t nkey,
+                                       size_t nbytes) {
+    if (get_state()->engine != MEMKV_ENGINE_MEMORY) {
+        return memkv_item_alloc(key, nkey, 0, 0, nbytes);
+    }
+    memkv_item_t* it = NULL;
+    memkv_shard_op_t op = {.key = key, .nkey = nkey, .value_len = nbytes, .item = &it};
+    shard_call(conn, key, nkey, shard_op_alloc, &op);
+    return it;
+}
+
+// value 是否就是流式接收的 item 中的数据
+static memkv_item_t* engine_stream_item(memkv_conn_t* conn, const void* value) {
+    memkv_item_t* it = conn->stream.item;
+    return it && value == MEMKV_ITEM_VALUE(it) ? it : NULL;
+}
+
+// 按模式写入 (见 memkv_store_store), cmp_cas 只用于 MEMKV_STORE_CAS, cas 非空时返回新的 CAS
+static infra_error_t engine_store(memkv_conn_t* conn, memkv_store_mode_t mode,
+                                  const char* key, size_t nkey, const void* value,
+                                  size_t value_len, uint32_t flags, time_t exptime,
+                                  uint64_t cmp_cas, uint64_t* cas) {
+    if (cas) {
+        *cas = 0;
+    }
+    memkv_state_t* state = get_state();
+    infra_error_t err;
+    if (state->engine != MEMKV_ENGINE_MEMORY) {
+        char ckey[MEMKV_STORE_MAX_KEY_LEN + 1];
+        if (!engine_key_cstr(ckey, key, nkey)) {
+            return INFRA_ERROR_INVALID_PARAM;
+        }
+        kv_args_t args = {
+            .key = ckey,
+            .value = value,
+            .value_len = value_len,
+            .flags = flags,
+            .expiry = memkv_store_realtime(exptime),
+            .cmp_cas = cmp_cas
+        };
+        poly_db_t* db = engine_db_begin(conn, true);
+        err = db ? kv_store_op(db, mode, &args, cas) : INFRA_ERROR_IO;
+        engine_db_end(conn, db);
+    } else {
+        // item 从属主分片的 slab 分配, value 由属主直接从接收缓冲区拷贝;
+        // 流式接收的 value 已在属主分配的 item 中, 不再复制
+        memkv_shard_op_t op = {
+            .key = key,
+            .nkey = nkey,
+            .mode = mode,
+            .value = value,
+            .value_len = value_len,
+            .flags = flags,
+            .expiry = memkv_store_realtime(exptime),
+            .cas = cmp_cas,
+            .value_item = engine_stream_item(conn, value)
+        };
+        shard_call(conn, key, nkey, shard_op_store, &op);
+        err = op.err;
+        if (err == INFRA_OK && cas) {
+            *cas = op.new_cas;
+        }
+    }
+
+    memkv_stats_t* stats = &conn->reactor->stats;
+    stats->cmd_set++;
+    if (mode == MEMKV_STORE_CAS) {
+        if (err == INFRA_OK) {
+            stats->cas_hits++;
+        } else if (err == INFRA_ERROR_CAS_MISMATCH) {
+            stats->cas_badval++;
+        } else if (err == INFRA_ERROR_NOT_FOUND) {
+            stats->cas_misses++;
+        }
+    }
+    return err;
+}
+
+// 更新过期时间, item 非空时一并返回持有引用的 item (gat)
+static infra_error_t engine_touch(memkv_conn_t* conn, const char* key, size_t nkey,
+                                  time_t exptime, memkv_item_t** item) {
+    memkv_state_t* state = get_state();
+    int64_t expiry = memkv_store_realtime(exptime);
+    infra_error_t err;
+    if (state->engine == MEMKV_ENGINE_MEMORY) {
+        memkv_shard_op_t op = {.key = key, .nkey = nkey, .expiry = expiry, .item = item};
+        shard_call(conn, key, nkey, shard_op_touch, &op);
+        err = op.err;
+    } else {
+        char ckey[MEMKV_STORE_MAX_KEY_LEN + 1];
+        if (!engine_key_cstr(ckey, key, nkey)) {
+            return INFRA_ERROR_INVALID_PARAM;
+        }
+        poly_db_t* db = engine_db_begin(conn, true);
+        err = db ? kv_touch(db, ckey, expiry) : INFRA_ERROR_IO;
+        engine_db_end(conn, db);
+        if (err == INFRA_OK && item) {
+            err = engine_lookup(conn, key, nkey, item);
+        }
+    }
+
+    engine_count_touch(conn, err);
+    return err;
+}
+
+// 删除 key, cas 非 0 时只删除 CAS 匹配的值
+static infra_error_t engine_delete(memkv_conn_t* conn, const char* key, size_t nkey, uint64_t cas) {
+    memkv_state_t* state = get_state();
+    infra_error_t err;
+    if (state->engine == MEMKV_ENGINE_MEMORY) {
+        memkv_shard_op_t op = {.key = key, .nkey = nkey, .cas = cas};
+        shard_call(conn, key, nkey, shard_op_delete, &op);
+        err = op.err;
+    } else {
+        char ckey[MEMKV_STORE_MAX_KEY_LEN + 1];
+        if (!engine_key_cstr(ckey, key, nkey)) {
+            return INFRA_ERROR_INVALID_PARAM;
+        }
+        poly_db_t* db = engine_db_begin(conn, true);
+        err = db ? kv_delete(db, ckey, cas) : INFRA_ERROR_IO;
+        engine_db_end(conn, db);
+    }
+
+    memkv_stats_t* stats = &conn->reactor->stats;
+    if (err == INFRA_OK) {
+        stats->delete_hits++;
+    } else if (err == INFRA_ERROR_NOT_FOUND) {
+        stats->delete_misses++;
+    }
+    return err;
+}
+
+static infra_error_t engine_flush(memkv_conn_t* conn) {
+    memkv_state_t* state = get_state();
+    conn->reactor->stats.cmd_flush++;
+    if (state->engine == MEMKV_ENGINE_MEMORY) {
+        return shard_broadcast(conn, shard_op_flush, NULL);
+    }
+    poly_db_t* db = engine_db_begin(conn, true);
+    infra_error_t err = db ? kv_flush(db) : INFRA_ERROR_IO;
+    engine_db_end(conn, db);
+    return err;
+}
+
+// 按十进制文本原子加减, 一次引擎调用完成; 未命中且 create 时写入 initial,
+// 非数字 value 返回 INFRA_ERROR_INVALID_PARAM
+static infra_error_t engine_incr_decr(memkv_conn_t* conn, const char* key, size_t nkey,
+                                      uint64_t delta, bool is_incr, bool create,
+                                      uint64_t initial, time_t exptime, uint64_t* value) {
+    memkv_state_t* state = get_state();
+    infra_error_t err;
+    bool created = false;
+    if (state->engine == MEMKV_ENGINE_MEMORY) {
+        memkv_shard_op_t op = {
+            .key = key,
+            .nkey = nkey,
+            .delta = delta,
+            .incr = is_incr,
+            .create = create,
+            .initial = initial,
+            .expiry = memkv_store_realtime(exptime)
+        };
+        shard_call(conn, key, nkey, shard_op_incr, &op);
+        err = op.err;
+        *value = op.number;
+        created = op.created;
+    } else {
+        char ckey[MEMKV_STORE_MAX_KEY_LEN + 1];
+        if (!engine_key_cstr(ckey, key, nkey)) {
+            return INFRA_ERROR_INVALID_PARAM;
+        }
+        poly_db_t* db = engine_db_begin(conn, true);
+        err = db ? kv_incr(db, ckey, nkey, delta, is_incr, create, initial,
+                           memkv_store_realtime(exptime), value, &created) : INFRA_ERROR_IO;
+        engine_db_end(conn, db);
+    }
+
+    // 未命中时创建的也计为 miss
+    memkv_stats_t* stats = &conn->reactor->stats;
+    if (err == INFRA_OK || err == INFRA_ERROR_NOT_FOUND) {
+        bool miss = err == INFRA_ERROR_NOT_FOUND || created;
+        if (is_incr) {
+            miss ? stats->incr_misses++ : stats->incr_hits++;
+        } else {
+            miss ? stats->decr_misses++ : stats->decr_hits++;
+        }
+    }
+    return err;
+}
+
+//-----------------------------------------------------------------------------
+// Output Queue
+//-----------------------------------------------------------------------------
+
+static bool conn_out_grow_entries(memkv_conn_t* conn) {
+    if (conn->out_count < conn->out_cap) {
+        return true;
+    }
+    size_t cap = conn->out_cap ? conn->out_cap * 2 : 16;
+    memkv_out_entry_t* out = infra_malloc(cap * sizeof(memkv_out_entry_t));
+    if (!out) {
+        return false;
+    }
+    if (conn->out_count > 0) {
+        memcpy(out, conn->out, conn->out_count * sizeof(memkv_out_entry_t));
+    }
+    infra_free(conn->out);
+    conn->out = out;
+    conn->out_cap = cap;
+    return true;
+}
+
+// 在 out_buf 末尾预留 len 字节
+static char* conn_out_reserve(memkv_conn_t* conn, size_t len) {
+    if (conn->out_buf_len + len > conn->out_buf_cap) {
+        size_t cap = conn->out_buf_cap ? conn->out_buf_cap : 4096;
+        while (cap < conn->out_buf_len + len) {
+            cap *= 2;
+        }
+        char* buf = infra_malloc(cap);
+        if (!buf) {
+            return NULL;
+        }
+        if (conn->out_buf_len > 0) {
+            memcpy(buf, conn->out_buf, conn->out_buf_len);
+        }
+        infra_free(conn->out_buf);
+        conn->out_buf = buf;
+        conn->out_buf_cap = cap;
+    }
+    return conn->out_buf + conn->out_buf_len;
+}
+
+// 提交预留的数据, 与上一段 out_buf 数据相邻时合并为一段
+static void conn_out_commit(memkv_conn_t* conn, size_t len) {
+    if (len == 0) {
+        return;
+    }
+
+    memkv_out_entry_t* last = conn->out_count > conn->out_head ? &conn->out[conn->out_count - 1] : NULL;
+    if (last && !last->data && last->offset + last->len == conn->out_buf_len) {
+        last->len += len;
+    } else {
+        if (!conn_out_grow_entries(conn)) {
+            conn->should_close = true;
+            return;
+        }
+        memkv_out_entry_t* entry = &conn->out[conn->out_count++];
+        entry->data = NULL;
+        entry->offset = conn->out_buf_len;
+        entry->len = len;
+        entry->item = NULL;
+    }
+    conn->out_buf_len += len;
+    conn->out_pending += len;
+}
+
+static void conn_out_text(memkv_conn_t* conn, const char* data, size_t len) {
+    char* dst = conn_out_reserve(conn, len);
+    if (!dst) {
+        conn->should_close = true;
+        return;
+    }
+    memcpy(dst, data, len);
+    conn_out_commit(conn, len);
+}
+
+static void conn_out_cstr(memkv_conn_t* conn, const char* str) {
+    conn_out_text(conn, str, strlen(str));
+}
+
+static void conn_out_printf(memkv_conn_t* conn, const char* fmt, ...) {
+    char* dst = conn_out_reserve(conn, 512);
+    if (!dst) {
+        conn->should_close = true;
+        return;
+    }
+    va_list args;
+    va_start(args, fmt);
+    int len = vsnprintf(dst, 512, fmt, args);
+    va_end(args);
+    if (len < 0 || len >= 512) {
+        INFRA_LOG_ERROR("Response line too long");
+        conn->should_close = true;
+        return;
+    }
+    conn_out_commit(conn, (size_t)len);
+}
+
+// 输出 item 的 value, 接管调用者持有的引用; 大 value 不拷贝, 发送完才释放
+static void conn_out_item(memkv_conn_t* conn, memkv_item_t* item) {
+    if (item->nbytes <= MEMKV_OUT_COPY_THRESHOLD) {
+        conn_out_text(conn, MEMKV_ITEM_VALUE(item), item->nbytes);
+        memkv_item_release(item);
+        return;
+    }
+
+    if (!conn_out_grow_entries(conn)) {
+        memkv_item_release(item);
+        conn->should_close = true;
+        return;
+    }
+    memkv_out_entry_t* entry = &conn->out[conn->out_count++];
+    entry->data = MEMKV_ITEM_VALUE(item);
+    entry->offset = 0;
+    entry->len = item->nbytes;
+    entry->item = item;
+    conn->out_pending += item->nbytes;
+}
+
+static void conn_out_reset(memkv_conn_t* conn) {
+    for (size_t i = conn->out_head; i < conn->out_count; i++) {
+        if (conn->out[i].item) {
+            memkv_item_release(conn->out[i].item);
+        }
+    }
+    conn->out_head = 0;
+    conn->out_count = 0;
+    conn->out_sent = 0;
+    conn->out_pending = 0;
+    conn->out_buf_len = 0;
+}
+
+// 尽量发送输出队列, 全部发完返回 INFRA_OK, 套接字写满返回 INFRA_ERROR_WOULD_BLOCK
+static infra_error_t conn_flush(memkv_conn_t* conn) {
+    while (conn->out_head < conn->out_count) {
+        struct iovec iov[MEMKV_OUT_MAX_IOV];
+        int iovcnt = 0;
+        for (size_t i = conn->out_head; i < conn->out_count && iovcnt < MEMKV_OUT_MAX_IOV; i++) {
+            memkv_out_entry_t* entry = &conn->out[i];
+            const char* base = entry->data ? entry->data : conn->out_buf + entry->offset;
+            size_t skip = i == conn->out_head ? conn->out_sent : 0;
+            iov[iovcnt].iov_base = (void*)(base + skip);
+            iov[iovcnt].iov_len = entry->len - skip;
+            iovcnt++;
+        }
+
+        size_t sent = 0;
+        infra_error_t err = infra_net_sendv(conn->sock, iov, iovcnt, &sent);
+        if (err != INFRA_OK) {
+            if (err != INFRA_ERROR_WOULD_BLOCK) {
+                INFRA_LOG_ERROR("Failed to send to %s: %s", conn->client_addr, strerror(errno));
+            }
+            return err;
+        }
+
+        conn->out_pending -= sent;
+        while (sent > 0) {
+            memkv_out_entry_t* entry = &conn->out[conn->out_head];
+            size_t left = entry->len - conn->out_sent;
+            if (sent < left) {
+                conn->out_sent += sent;
+                break;
+            }
+            sent -= left;
+            if (entry->item) {
+                memkv_item_release(entry->item);
+                entry->item = NULL;
+            }
+            conn->out_head++;
+            conn->out_sent = 0;
+        }
+    }
+
+    conn_out_reset(conn);
+    return INFRA_OK;
+}
+
+// get/gets/gat/gats 的单个 key
+static int handle_get(memkv_conn_t* conn, memkv_span_t key, const memkv_request_t* req) {
+    if (!conn || !engine_ready(conn)) {
+        INFRA_LOG_ERROR("Invalid parameters");
+        return -1;
+    }
+
+    // 获取键值对, 未命中时不输出任何内容, 最后统一发送 END
+    bool touch = req->cmd == MEMKV_CMD_GAT || req->cmd == MEMKV_CMD_GATS;
+    memkv_item_t* item = NULL;
+    infra_error_t err = touch ? engine_touch(conn, key.ptr, key.len, (time_t)req->exptime, &item)
+                              : engine_get(conn, key.ptr, key.len, &item);
+    return get_out_result(conn, key, req, err, item);
+}
+
+// 输出 get 的单个结果并释放 item; 返回值同 handle_get
+static int get_out_result(memkv_conn_t* conn, memkv_span_t key, const memkv_request_t* req,
+                          infra_error_t err, memkv_item_t* item) {
+    bool with_cas = req->cmd == MEMKV_CMD_GETS || req->cmd == MEMKV_CMD_GATS;
+    if (err == INFRA_ERROR_NOT_FOUND) {
+        return 0;
+    } else if (err != INFRA_OK) {
+        INFRA_LOG_ERROR("Failed to get key %.*s: %d", (int)key.len, key.ptr, err);
+        conn->should_close = true;
+        return -1;
+    }
+
+    // 响应头、value、换行依次进入输出队列, value 引用 item 不拷贝
+    INFRA_LOG_DEBUG("Queued key-value pair: [%.*s], %u bytes", (int)key.len, key.ptr, item->nbytes);
+    if (with_cas) {
+        conn_out_printf(conn, "VALUE %.*s %u %u %lu\r\n", (int)item->nkey, MEMKV_ITEM_KEY(item),
+                        item->flags, item->nbytes, (unsigned long)item->cas);
+    } else {
+        conn_out_printf(conn, "VALUE %.*s %u %u\r\n",
+                        (int)item->nkey, MEMKV_ITEM_KEY(item), item->flags, item->nbytes);
+    }
+    conn_out_item(conn, item);
+    conn_out_text(conn, "\r\n", 2);
+    return conn->should_close ? -1 : 1;
+}
+
+// 分片模式的多 key get: 每批 key 向各分片扇出一次, 结果按请求顺序输出
+static int handle_get_multi(memkv_conn_t* conn, const memkv_request_t* req) {
+    if (!engine_ready(conn)) {
+        INFRA_LOG_ERROR("Invalid parameters");
+        return -1;
+    }
+
+    bool touch = req->cmd == MEMKV_CMD_GAT || req->cmd == MEMKV_CMD_GATS;
+    int64_t expiry = memkv_store_realtime((time_t)req->exptime);
+    memkv_span_t keys[MEMKV_SHARD_GET_BATCH];
+    memkv_item_t* items[MEMKV_SHARD_GET_BATCH];
+    infra_error_t errs[MEMKV_SHARD_GET_BATCH];
+    bool cached[MEMKV_SHARD_GET_BATCH];
+    bool hot[MEMKV_SHARD_GET_BATCH];
+    memkv_span_t rest = req->keys;
+    int count;
+    do {
+        count = 0;
+        while (count < MEMKV_SHARD_GET_BATCH && memkv_proto_next_token(&rest, &keys[count])) {
+            // gat 要写入过期时间, 不走副本缓存; 重新执行时也不走
+            hot[count] = false;
+            cached[count] = !touch && !conn->calls && hotkeys_before_get(conn->reactor, keys[count].ptr, keys[count].len,
+                                                         &items[count], &hot[count]);
+            if (cached[count]) {
+                errs[count] = INFRA_OK;
+            }
+            count++;
+        }
+        if (count == 0) {
+            break;
+        }
+
+        shard_get_batch(conn, keys, count, touch, expiry, cached, items, errs);
+        if (conn->call_pending > 0) {
+            // 等待其他分片, 命令稍后重新执行
+            for (int i = 0; i < count; i++) {
+                if (errs[i] == INFRA_OK) {
+                    memkv_item_release(items[i]);
+                }
+            }
+            return -1;
+        }
+
+        int ret = 0;
+        for (int i = 0; i < count; i++) {
+            hotkeys_after_get(conn->reactor, hot[i], errs[i], errs[i] == INFRA_OK ? items[i] : NULL);
+            if (touch) {
+                engine_count_touch(conn, errs[i]);
+            } else {
+                engine_count_get(conn, errs[i]);
+            }
+            // 出错后剩余的结果只释放不输出
+            if (ret >= 0) {
+                ret = get_out_result(conn, keys[i], req, errs[i], items[i]);
+            } else if (errs[i] == INFRA_OK) {
+                memkv_item_release(items[i]);
+            }
+        }
+        if (ret < 0) {
+            return -1;
+        }
+    } while (count == MEMKV_SHARD_GET_BATCH);
+    return 0;
+}
+
+static memkv_store_mode_t store_mode(memkv_cmd_t cmd) {
+    switch (cmd) {
+        case MEMKV_CMD_ADD: return MEMKV_STORE_ADD;
+        case MEMKV_CMD_REPLACE: return MEMKV_STORE_REPLACE;
+        case MEMKV_CMD_APPEND: return MEMKV_STORE_APPEND;
+        case MEMKV_CMD_PREPEND: return MEMKV_STORE_PREPEND;
+        case MEMKV_CMD_CAS: return MEMKV_STORE_CAS;
+        default: return MEMKV_STORE_SET;
+    }
+}
+
+// set/add/replace/append/prepend/cas
+static void handle_store(memkv_conn_t* conn, const memkv_request_t* req) {
+    if (!engine_ready(conn)) {
+        if (!req->noreply) {
+            conn_out_cstr(conn, "SERVER_ERROR\r\n");
+        }
+        return;
+    }
+
+    infra_error_t err = engine_store(conn, store_mode(req->cmd), req->key.ptr, req->key.len,
+                                     req->data.ptr, req->data.len, req->flags,
+                                     (time_t)req->exptime, req->cas_unique, NULL);
+    const char* reply;
+    switch (err) {
+        case INFRA_OK: reply = "STORED\r\n"; break;
+        case INFRA_ERROR_CAS_MISMATCH: reply = "EXISTS\r\n"; break;
+        case INFRA_ERROR_EXISTS: reply = "NOT_STORED\r\n"; break;
+        case INFRA_ERROR_NOT_FOUND:
+            reply = req->cmd == MEMKV_CMD_CAS ? "NOT_FOUND\r\n" : "NOT_STORED\r\n";
+            break;
+        case INFRA_ERROR_NO_SPACE: reply = "SERVER_ERROR object too large for cache\r\n"; break;
+        case INFRA_ERROR_NO_MEMORY: reply = "SERVER_ERROR out of memory storing object\r\n"; break;
+        default:
+            // WOULD_BLOCK: 等待其他分片, 命令稍后重新执行
+            if (err != INFRA_ERROR_WOULD_BLOCK) {
+                INFRA_LOG_ERROR("Failed to store key-value pair: %d", err);
+            }
+            reply = "SERVER_ERROR\r\n";
+            break;
+    }
+    if (!req->noreply) {
+        conn_out_cstr(conn, reply);
+    }
+}
+
+static void handle_touch(memkv_conn_t* conn, const memkv_request_t* req) {
+    if (!engine_ready(conn)) {
+        if (!req->noreply) {
+            conn_out_cstr(conn, "SERVER_ERROR\r\n");
+        }
+        return;
+    }
+
+    infra_error_t err = engine_touch(conn, req->key.ptr, req->key.len, (time_t)req->exptime, NULL);
+    if (req->noreply) {
+        return;
+    }
+    if (err == INFRA_OK) {
+        conn_out_cstr(conn, "TOUCHED\r\n");
+    } else if (err == INFRA_ERROR_NOT_FOUND) {
+        conn_out_cstr(conn, "NOT_FOUND\r\n");
+    } else {
+        conn_out_cstr(conn, "SERVER_ERROR\r\n");
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Stats
+//-----------------------------------------------------------------------------
+
+typedef void (*stats_emit_fn)(memkv_conn_t* conn, const memkv_request_t* req,
+                              const char* name, const char* value);
+
+static void stats_emit_u64(memkv_conn_t* conn, const memkv_request_t* req, stats_emit_fn emit,
+                           const char* name, uint64_t value) {
+    char buf[24];
+    snprintf(buf, sizeof(buf), "%lu", (unsigned long)value);
+    emit(conn, req, name, buf);
+}
+
+// 汇总各 reactor 的计数, 其他线程的计数可能略有滞后
+static void stats_collect(memkv_conn_t* conn, const memkv_request_t* req, stats_emit_fn emit) {
+    memkv_state_t* state = get_state();
+    memkv_stats_t total = {0};
+    uint64_t curr_connections = 0;
+    for (int i = 0; i < state->reactor_count; i++) {
+        const uint64_t* src = (const uint64_t*)&state->reactors[i].stats;
+        uint64_t* dst = (uint64_t*)&total;
+        for (size_t j = 0; j < sizeof(total) / sizeof(uint64_t); j++) {
+            dst[j] += src[j];
+        }
+        curr_connections += state->reactors[i].conn_count;
+    }
+
+    time_t now = time(NULL);
+    stats_emit_u64(conn, req, emit, "pid", (uint64_t)getpid());
+    stats_emit_u64(conn, req, emit, "uptime", (uint64_t)(now - state->start_time));
+    stats_emit_u64(conn, req, emit, "time", (uint64_t)now);
+    emit(conn, req, "version", MEMKV_VERSION);
+    emit(conn, req, "engine", engine_name(state->engine));
+    stats_emit_u64(conn, req, emit, "curr_connections", curr_connections);
+    stats_emit_u64(conn, req, emit, "total_connections", total.total_connections);
+    stats_emit_u64(conn, req, emit, "threads", (uint64_t)state->reactor_count);
+    stats_emit_u64(conn, req, emit, "shards", state->sharded ? (uint64_t)state->shard_count : 1);
+    stats_emit_u64(conn, req, emit, "cmd_get", total.cmd_get);
+    stats_emit_u64(conn, req, emit, "cmd_set", total.cmd_set);
+    stats_emit_u64(conn, req, emit, "cmd_flush", total.cmd_flush);
+    stats_emit_u64(conn, req, emit, "cmd_touch", total.cmd_touch);
+    stats_emit_u64(conn, req, emit, "get_hits", total.get_hits);
+    stats_emit_u64(conn, req, emit, "get_misses", total.get_misses);
+    stats_emit_u64(conn, req, emit, "delete_hits", total.delete_hits);
+    stats_emit_u64(conn, req, emit, "delete_misses", total.delete_misses);
+    stats_emit_u64(conn, req, emit, "incr_hits", total.incr_hits);
+    stats_emit_u64(conn, req, emit, "incr_misses", total.incr_misses);
+    stats_emit_u64(conn, req, emit, "decr_hits", total.decr_hits);
+    stats_emit_u64(conn, req, emit, "decr_misses", total.decr_misses);
+    stats_emit_u64(conn, req, emit, "cas_hits", total.cas_hits);
+    stats_emit_u64(conn, req, emit, "cas_misses", total.cas_misses);
+    stats_emit_u64(conn, req, emit, "cas_badval", total.cas_badval);
+    stats_emit_u64(conn, req, emit, "touch_hits", total.touch_hits);
+    stats_emit_u64(conn, req, emit, "touch_misses", total.touch_misses);
+    stats_emit_u64(conn, req, emit, "hotcache_hits", total.hotcache_hits);
+
+    memkv_store_stats_t store_stats;
+    if (store_stats_total(state, &store_stats)) {
+        stats_emit_u64(conn, req, emit, "curr_items", store_stats.curr_items);
+        stats_emit_u64(conn, req, emit, "total_items", store_stats.total_items);
+        stats_emit_u64(conn, req, emit, "bytes", store_stats.bytes);
+        stats_emit_u64(conn, req, emit, "limit_maxbytes", store_stats.limit_maxbytes);
+        stats_emit_u64(conn, req, emit, "total_malloced", store_stats.total_malloced);
+        stats_emit_u64(conn, req, emit, "evictions", store_stats.evictions);
+        stats_emit_u64(conn, req, emit, "expired_unfetched", store_stats.expired);
+        stats_emit_u64(conn, req, emit, "crawler_reclaimed", store_stats.crawler_reclaimed);
+    } else if (state->engine != MEMKV_ENGINE_MEMORY) {
+        stats_emit_u64(conn, req, emit, "crawler_reclaimed",
+                       __atomic_load_n(&state->db_crawler_reclaimed, __ATOMIC_RELAXED));
+    }
+}
+
+// stats slabs: 每个用过的 slab class 一组统计, large class 编号为 0
+static void stats_slabs(memkv_conn_t* conn) {
+    memkv_state_t* state = get_state();
+    memkv_slab_stats_t slabs[MEMKV_SLAB_MAX_CLASSES];
+    int n = store_slab_stats_total(state, slabs, MEMKV_SLAB_MAX_CLASSES);
+
+    int active = 0;
+    for (int i = 0; i < n; i++) {
+        const memkv_slab_stats_t* st = &slabs[i];
+        if (st->total_pages == 0 && st->used_chunks == 0) {
+            continue;
+        }
+        active++;
+        conn_out_printf(conn, "STAT %u:chunk_size %zu\r\n", st->id, st->chunk_size);
+        conn_out_printf(conn, "STAT %u:chunks_per_page %u\r\n", st->id, st->chunks_per_page);
+        conn_out_printf(conn, "STAT %u:total_pages %lu\r\n", st->id, (unsigned long)st->total_pages);
+        conn_out_printf(conn, "STAT %u:used_chunks %lu\r\n", st->id, (unsigned long)st->used_chunks);
+        conn_out_printf(conn, "STAT %u:free_chunks %lu\r\n", st->id, (unsigned long)st->free_chunks);
+        conn_out_printf(conn, "STAT %u:curr_items %lu\r\n", st->id, (unsigned long)st->curr_items);
+        conn_out_printf(conn, "STAT %u:evictions %lu\r\n", st->id, (unsigned long)st->evictions);
+        conn_out_printf(conn, "STAT %u:outofmemory %lu\r\n", st->id, (unsigned long)st->outofmemory);
+    }
+    conn_out_printf(conn, "STAT active_slabs %d\r\n", active);
+    memkv_store_stats_t store_stats;
+    if (store_stats_total(state, &store_stats)) {
+        conn_out_printf(conn, "STAT total_malloced %lu\r\n",
+                        (unsigned long)store_stats.total_malloced);
+    }
+    conn_out_text(conn, "END\r\n", 5);
+}
+
+// stats hotkeys: 汇总各 reactor 跟踪的热点 key, 按估计访问次数从大到小输出
+static void stats_hotkeys(memkv_conn_t* conn) {
+    memkv_state_t* state = get_state();
+    int cap = state->reactor_count * MEMKV_HOTKEYS_TRACKED;
+    memkv_hotkey_t* all = cap > 0 ? infra_malloc(cap * sizeof(memkv_hotkey_t)) : NULL;
+    int n = 0;
+    for (int i = 0; all && i < state->reactor_count; i++) {
+        memkv_hotkey_t* top = all + n;
+        int m = memkv_hotkeys_top(state->reactors[i].hotkeys, top, MEMKV_HOTKEYS_TRACKED);
+        // 同一个 key 可能被多个 reactor 跟踪, 计数相加
+        for (int j = 0; j < m; j++) {
+            int k = 0;
+            while (k < n && (all[k].nkey != top[j].nkey ||
+                             memcmp(all[k].key, top[j].key, top[j].nkey) != 0)) {
+                k++;
+            }
+            if (k < n) {
+                all[k].count += top[j].count;
+                all[k].error += top[j].error;
+            } else {
+                all[n++] = top[j];
+            }
+        }
+    }
+
+    // 合并后的 key 不多, 选择排序
+    int shown = n < MEMKV_HOTKEYS_TRACKED ? n : MEMKV_HOTKEYS_TRACKED;
+    for (int i = 0; i < shown; i++) {
+        int max = i;
+        for (int j = i + 1; j < n; j++) {
+            if (all[j].count > all[max].count) {
+                max = j;
+            }
+        }
+        memkv_hotkey_t tmp = all[i];
+        all[i] = all[max];
+        all[max] = tmp;
+
+        conn_out_printf(conn, "STAT %d:key %.*s\r\n", i, (int)all[i].nkey, all[i].key);
+        conn_out_printf(conn, "STAT %d:gets %lu\r\n", i, (unsigned long)all[i].count);
+        conn_out_printf(conn, "STAT %d:error %lu\r\n", i, (unsigned long)all[i].error);
+    }
+    conn_out_printf(conn, "STAT sample_rate %d\r\n", MEMKV_HOTKEYS_SAMPLE_RATE);
+    conn_out_printf(conn, "STAT hotcache %s\r\n", state->hotcache ? "on" : "off");
+    conn_out_text(conn, "END\r\n", 5);
+    if (all) {
+        infra_free(all);
+    }
+}
+
+static void stats_emit_text(memkv_conn_t* conn, const memkv_request_t* req,
+                            const char* name, const char* value) {
+    (void)req;
+    conn_out_printf(conn, "STAT %s %s\r\n", name, value);
+}
+
+// stats [slabs|hotkeys]: 其他分组返回 ERROR
+static void handle_stats(memkv_conn_t* conn, const memkv_request_t* req) {
+    memkv_span_t args = req->args;
+    memkv_span_t group;
+    if (memkv_proto_next_token(&args, &group)) {
+        if (memkv_span_equals(group, "slabs")) {
+            stats_slabs(conn);
+            return;
+        }
+        if (memkv_span_equals(group, "hotkeys")) {
+            stats_hotkeys(conn);
+            return;
+        }
+        conn->failed_commands++;
+        conn_out_cstr(conn, "ERROR\r\n");
+        return;
+    }
+    stats_collect(conn, req, stats_emit_text);
+    conn_out_text(conn, "END\r\n", 5);
+}
+
+//-----------------------------------------------------------------------------
+// Meta Commands
+//-----------------------------------------------------------------------------
+
+// 输出 meta 响应的返回标志, item 为空时只输出 k 和 O
+static void meta_out_flags(memkv_conn_t* conn, const memkv_request_t* req,
+                           const memkv_item_t* item, uint64_t cas) {
+    if (item) {
+        if (req->meta & MEMKV_META_FLAGS) {
+            conn_out_printf(conn, " f%u", item->flags);
+        }
+        if (req->meta & MEMKV_META_SIZE) {
+            conn_out_printf(conn, " s%u", item->nbytes);
+        }
+        if (req->meta & MEMKV_META_TTL) {
+            long ttl = -1;
+            if (item->exptime > 0) {
+                ttl = (long)(item->exptime - time(NULL));
+                if (ttl < 0) ttl = 0;
+            }
+            conn_out_printf(conn, " t%ld", ttl);
+        }
+    }
+    if (req->meta & MEMKV_META_CAS) {
+        conn_out_printf(conn, " c%lu", (unsigned long)cas);
+    }
+    if (req->meta & MEMKV_META_KEY) {
+        conn_out_printf(conn, " k%.*s", (int)req->key.len, req->key.ptr);
+    }
+    if (req->meta & MEMKV_META_OPAQUE) {
+        conn_out_printf(conn, " O%.*s", (int)req->meta_opaque.len, req->meta_opaque.ptr);
+    }
+    conn_out_text(conn, "\r\n", 2);
+}
+
+// mg <key> <flags>*: 命中返回 VA/HD, 未命中返回 EN
+static void handle_meta_get(memkv_conn_t* conn, const memkv_request_t* req) {
+    if (!engine_ready(conn)) {
+        conn_out_cstr(conn, "SERVER_ERROR\r\n");
+        return;
+    }
+
+    // T 标志: 读取的同时更新过期时间
+    memkv_item_t* item = NULL;
+    infra_error_t err = (req->meta & MEMKV_META_SET_TTL)
+        ? engine_touch(conn, req->key.ptr, req->key.len, (time_t)req->exptime, &item)
+        : engine_get(conn, req->key.ptr, req->key.len, &item);
+    if (err == INFRA_ERROR_NOT_FOUND) {
+        if (!req->quiet) {
+            conn_out_text(conn, "EN\r\n", 4);
+        }
+        return;
+    } else if (err != INFRA_OK) {
+        conn_out_cstr(conn, "SERVER_ERROR\r\n");
+        return;
+    }
+
+    if (req->meta & MEMKV_META_VALUE) {
+        conn_out_printf(conn, "VA %u", item->nbytes);
+    } else {
+        conn_out_text(conn, "HD", 2);
+    }
+    meta_out_flags(conn, req, item, item->cas);
+    if (req->meta & MEMKV_META_VALUE) {
+        conn_out_item(conn, item);
+        conn_out_text(conn, "\r\n", 2);
+    } else {
+        memkv_item_release(item);
+    }
+}
+
+// ms <key> <datalen> <flags>*: M 标志选择模式 (S/E/A/P/R), C 标志与 S/R 组合为 cas
+static void handle_meta_set(memkv_conn_t* conn, const memkv_request_t* req) {
+    if (!engine_ready(conn)) {
+        conn_out_cstr(conn, "SERVER_ERROR\r\n");
+        return;
+    }
+
+    memkv_store_mode_t mode;
+    switch (req->mode) {
+        case 'E': mode = MEMKV_STORE_ADD; break;
+        case 'A': mode = MEMKV_STORE_APPEND; break;
+        case 'P': mode = MEMKV_STORE_PREPEND; break;
+        case 'R': mode = MEMKV_STORE_REPLACE; break;
+        default: mode = MEMKV_STORE_SET; break;
+    }
+    bool compare = (req->meta & MEMKV_META_COMPARE) != 0;
+    if ((req->meta & MEMKV_META_INVALIDATE) ||
+        (compare && mode != MEMKV_STORE_SET && mode != MEMKV_STORE_REPLACE)) {
+        conn_out_cstr(conn, "SERVER_ERROR not supported\r\n");
+        return;
+    }
+    if (compare) {
+        mode = MEMKV_STORE_CAS;
+    }
+
+    uint64_t cas = 0;
+    infra_error_t err = engine_store(conn, mode, req->key.ptr, req->key.len, req->data.ptr,
+                                     req->data.len, req->flags, (time_t)req->exptime,
+                                     req->cas_unique, &cas);
+    const char* status;
+    switch (err) {
+        case INFRA_OK: status = "HD"; break;
+        case INFRA_ERROR_CAS_MISMATCH: status = "EX"; break;
+        case INFRA_ERROR_NOT_FOUND: status = mode == MEMKV_STORE_CAS ? "NF" : "NS"; break;
+        case INFRA_ERROR_EXISTS: status = "NS"; break;
+        default:
+            conn_out_cstr(conn, "SERVER_ERROR\r\n");
+            return;
+    }
+    if (err != INFRA_OK || !req->quiet) {
+        conn_out_text(conn, status, 2);
+        meta_out_flags(conn, req, NULL, cas);
+    }
+}
+
+// md <key> <flags>*: 删除返回 HD, 不存在返回 NF, C 不匹配返回 EX; q 时只返回失败
+static void handle_meta_delete(memkv_conn_t* conn, const memkv_request_t* req) {
+    if (!engine_ready(conn)) {
+        conn_out_cstr(conn, "SERVER_ERROR\r\n");
+        return;
+    }
+
+    if (req->meta & MEMKV_META_INVALIDATE) {
+        conn_out_cstr(conn, "SERVER_ERROR not supported\r\n");
+        return;
+    }
+
+    uint64_t cas = (req->meta & MEMKV_META_COMPARE) ? req->cas_unique : 0;
+    infra_error_t err = engine_delete(conn, req->key.ptr, req->key.len, cas);
+    const char* status;
+    switch (err) {
+        case INFRA_OK: status = "HD"; break;
+        case INFRA_ERROR_NOT_FOUND: status = "NF"; break;
+        case INFRA_ERROR_CAS_MISMATCH: status = "EX"; break;
+        default:
+            conn_out_cstr(conn, "SERVER_ERROR\r\n");
+            return;
+    }
+    if (err == INFRA_ERROR_CAS_MISMATCH || !req->quiet) {
+        conn_out_text(conn, status, 2);
+        meta_out_flags(conn, req, NULL, 0);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Binary Protocol
+//-----------------------------------------------------------------------------
+
+static const char* bin_status_message(uint16_t status) {
+    switch (status) {
+        case MEMKV_BIN_STATUS_KEY_ENOENT: return "Not found";
+        case MEMKV_BIN_STATUS_KEY_EEXISTS: return "Data exists for key.";
+        case MEMKV_BIN_STATUS_E2BIG: return "Too large.";
+        case MEMKV_BIN_STATUS_EINVAL: return "Invalid arguments";
+        case MEMKV_BIN_STATUS_NOT_STORED: return "Not stored.";
+        case MEMKV_BIN_STATUS_DELTA_BADVAL: return "Non-numeric server-side value for incr or decr";
+        case MEMKV_BIN_STATUS_UNKNOWN_COMMAND: return "Unknown command";
+        case MEMKV_BIN_STATUS_ENOMEM: return "Out of memory";
+        case MEMKV_BIN_STATUS_NOT_SUPPORTED: return "Not supported";
+        default: return "Internal error";
+    }
+}
+
+static uint16_t bin_status_from_error(infra_error_t err) {
+    switch (err) {
+        case INFRA_OK: return MEMKV_BIN_STATUS_OK;
+        case INFRA_ERROR_NOT_FOUND: return MEMKV_BIN_STATUS_KEY_ENOENT;
+        case INFRA_ERROR_NO_MEMORY: return MEMKV_BIN_STATUS_ENOMEM;
+        case INFRA_ERROR_INVALID_PARAM: return MEMKV_BIN_STATUS_EINVAL;
+        case INFRA_ERROR_NOT_SUPPORTED: return MEMKV_BIN_STATUS_NOT_SUPPORTED;
+        default: return MEMKV_BIN_STATUS_EINTERNAL;
+    }
+}
+
+// 输出响应头及 extras, key; 随后的 vlen 字节 value 由调用者输出
+static void bin_out_header(memkv_conn_t* conn, const memkv_request_t* req, uint16_t status,
+                           const char* extras, uint8_t extlen, const char* key, uint16_t keylen,
+                           size_t vlen, uint64_t cas) {
+    size_t len = MEMKV_BIN_HEADER_LEN + extlen + keylen;
+    char* dst = conn_out_reserve(conn, len);
+    if (!dst) {
+        conn->should_close = true;
+        return;
+    }
+    memkv_proto_bin_header(dst, req->opcode, status, keylen, extlen,
+                           (uint32_t)(extlen + keylen + vlen), req->opaque, cas);
+    if (extlen > 0) {
+        memcpy(dst + MEMKV_BIN_HEADER_LEN, extras, extlen);
+    }
+    if (keylen > 0) {
+        memcpy(dst + MEMKV_BIN_HEADER_LEN + extlen, key, keylen);
+    }
+    conn_out_commit(conn, len);
+}
+
+// 错误响应, 包体为错误描述; 静默命令的错误也要回复
+static void bin_out_status(memkv_conn_t* conn, const memkv_request_t* req, uint16_t status) {
+    const char* msg = bin_status_message(status);
+    size_t len = strlen(msg);
+    bin_out_header(conn, req, status, NULL, 0, NULL, 0, len, 0);
+    conn_out_text(conn, msg, len);
+}
+
+// 成功且没有包体的响应, 静默命令不回复
+static void bin_out_ok(memkv_conn_t* conn, const memkv_request_t* req, uint64_t cas) {
+    if (!req->quiet) {
+        bin_out_header(conn, req, MEMKV_BIN_STATUS_OK, NULL, 0, NULL, 0, 0, cas);
+    }
+}
+
+// get/getk 及 gat/gatk (touch 命令中的 GAT 系列操作码)
+static void bin_handle_get(memkv_conn_t* conn, const memkv_request_t* req) {
+    memkv_item_t* item = NULL;
+    infra_error_t err = req->cmd == MEMKV_CMD_TOUCH
+        ? engine_touch(conn, req->key.ptr, req->key.len, (time_t)req->exptime, &item)
+        : engine_get(conn, req->key.ptr, req->key.len, &item);
+    if (err == INFRA_ERROR_NOT_FOUND) {
+        // GETQ/GETKQ 未命中不回复
+        if (!req->quiet) {
+            bin_out_status(conn, req, MEMKV_BIN_STATUS_KEY_ENOENT);
+        }
+        return;
+    } else if (err != INFRA_OK) {
+        bin_out_status(conn, req, bin_status_from_error(err));
+        return;
+    }
+
+    char extras[4];
+    extras[0] = (char)(item->flags >> 24);
+    extras[1] = (char)(item->flags >> 16);
+    extras[2] = (char)(item->flags >> 8);
+    extras[3] = (char)item->flags;
+    bin_out_header(conn, req, MEMKV_BIN_STATUS_OK, extras, 4,
+                   req->return_key ? req->key.ptr : NULL,
+                   req->return_key ? (uint16_t)req->key.len : 0,
+                   item->nbytes, item->cas);
+    conn_out_item(conn, item);
+}
+
+// set/add/replace/append/prepend, set 带 CAS 时按 cas 写入
+static void bin_handle_store(memkv_conn_t* conn, const memkv_request_t* req) {
+    memkv_store_mode_t mode = store_mode(req->cmd);
+    if (req->cas_unique != 0) {
+        // append/prepend 的 CAS 校验尚不支持
+        if (mode != MEMKV_STORE_SET && mode != MEMKV_STORE_REPLACE) {
+            bin_out_status(conn, req, MEMKV_BIN_STATUS_NOT_SUPPORTED);
+            return;
+        }
+        mode = MEMKV_STORE_CAS;
+    }
+
+    uint64_t cas = 0;
+    infra_error_t err = engine_store(conn, mode, req->key.ptr, req->key.len, req->data.ptr,
+                                     req->data.len, req->flags, (time_t)req->exptime,
+                                     req->cas_unique, &cas);
+    switch (err) {
+        case INFRA_OK:
+            bin_out_ok(conn, req, cas);
+            break;
+        case INFRA_ERROR_EXISTS:
+        case INFRA_ERROR_CAS_MISMATCH:
+            bin_out_status(conn, req, MEMKV_BIN_STATUS_KEY_EEXISTS);
+            break;
+        case INFRA_ERROR_NOT_FOUND:
+            bin_out_status(conn, req, mode == MEMKV_STORE_APPEND || mode == MEMKV_STORE_PREPEND
+                                          ? MEMKV_BIN_STATUS_NOT_STORED
+                                          : MEMKV_BIN_STATUS_KEY_ENOENT);
+            break;
+        case INFRA_ERROR_NO_SPACE:
+            bin_out_status(conn, req, MEMKV_BIN_STATUS_E2BIG);
+            break;
+        default:
+            bin_out_status(conn, req, bin_status_from_error(err));
+            break;
+    }
+}
+
+static void bin_stats_emit(memkv_conn_t* conn, const memkv_request_t* req,
+                           const char* name, const char* value) {
+    size_t vlen = strlen(value);
+    bin_out_header(conn, req, MEMKV_BIN_STATUS_OK, NULL, 0, name, (uint16_t)strlen(name), vlen, 0);
+    conn_out_text(conn, value, vlen);
+}
+
+static void bin_handle_incr_decr(memkv_conn_t* conn, const memkv_request_t* req) {
+    uint64_t value = 0;
+    infra_error_t err = engine_incr_decr(conn, req->key.ptr, req->key.len, req->delta,
+                                         req->cmd == MEMKV_CMD_INCR, req->create, req->initial,
+                                         (time_t)req->exptime, &value);
+    if (err == INFRA_ERROR_INVALID_PARAM) {
+        bin_out_status(conn, req, MEMKV_BIN_STATUS_DELTA_BADVAL);
+        return;
+    } else if (err != INFRA_OK) {
+        bin_out_status(conn, req, bin_status_from_error(err));
+        return;
+    }
+    if (req->quiet) {
+        return;
+    }
+
+    char body[8];
+    for (int i = 0; i < 8; i++) {
+        body[i] = (char)(value >> (56 - 8 * i));
+    }
+    bin_out_header(conn, req, MEMKV_BIN_STATUS_OK, NULL, 0, NULL, 0, sizeof(body), 0);
+    conn_out_text(conn, body, sizeof(body));
+}
+
+// 执行一条二进制请求
+static void handle_binary(memkv_conn_t* conn, const memkv_request_t* req) {
+    conn->total_commands++;
+
+    bool needs_engine = req->cmd != MEMKV_CMD_NOOP && req->cmd != MEMKV_CMD_VERSION &&
+                        req->cmd != MEMKV_CMD_QUIT && req->cmd != MEMKV_CMD_STATS;
+    if (needs_engine && !engine_ready(conn)) {
+        bin_out_status(conn, req, MEMKV_BIN_STATUS_EINTERNAL);
+        return;
+    }
+
+    infra_error_t err;
+    switch (req->cmd) {
+        case MEMKV_CMD_GET:
+            bin_handle_get(conn, req);
+            break;
+        case MEMKV_CMD_SET:
+        case MEMKV_CMD_ADD:
+        case MEMKV_CMD_REPLACE:
+        case MEMKV_CMD_APPEND:
+        case MEMKV_CMD_PREPEND:
+            bin_handle_store(conn, req);
+            break;
+        case MEMKV_CMD_DELETE:
+            err = engine_delete(conn, req->key.ptr, req->key.len, req->cas_unique);
+            if (err == INFRA_ERROR_CAS_MISMATCH) {
+                bin_out_status(conn, req, MEMKV_BIN_STATUS_KEY_EEXISTS);
+            } else if (err != INFRA_OK) {
+                bin_out_status(conn, req, bin_status_from_error(err));
+            } else {
+                bin_out_ok(conn, req, 0);
+            }
+            break;
+        case MEMKV_CMD_TOUCH:
+            if (req->opcode != MEMKV_BIN_OP_TOUCH) {
+                bin_handle_get(conn, req);
+                break;
+            }
+            err = engine_touch(conn, req->key.ptr, req->key.len, (time_t)req->exptime, NULL);
+            if (err != INFRA_OK) {
+                bin_out_status(conn, req, bin_status_from_error(err));
+            } else {
+                bin_out_ok(conn, req, 0);
+            }
+            break;
+        case MEMKV_CMD_INCR:
+        case MEMKV_CMD_DECR:
+            bin_handle_incr_decr(conn, req);
+            break;
+        case MEMKV_CMD_FLUSH_ALL:
+            err = engine_flush(conn);
+            if (err != INFRA_OK) {
+                bin_out_status(conn, req, bin_status_from_error(err));
+            } else {
+                bin_out_ok(conn, req, 0);
+            }
+            break;
+        case MEMKV_CMD_NOOP:
+            bin_out_header(conn, req, MEMKV_BIN_STATUS_OK, NULL, 0, NULL, 0, 0, 0);
+            break;
+        case MEMKV_CMD_VERSION:
+            bin_out_header(conn, req, MEMKV_BIN_STATUS_OK, NULL, 0, NULL, 0,
+                           strlen(MEMKV_VERSION), 0);
+            conn_out_cstr(conn, MEMKV_VERSION);
+            break;
+        case MEMKV_CMD_STATS:
+            // 每项统计一个响应, 以空 key 的响应结束; 不支持统计分组
+            if (req->key.len > 0) {
+                bin_out_status(conn, req, MEMKV_BIN_STATUS_KEY_ENOENT);
+                break;
+            }
+            stats_collect(conn, req, bin_stats_emit);
+            bin_out_header(conn, req, MEMKV_BIN_STATUS_OK, NULL, 0, NULL, 0, 0, 0);
+            break;
+        case MEMKV_CMD_QUIT:
+            bin_out_ok(conn, req, 0);
+            conn->should_close = true;
+            break;
+        default:
+            conn->failed_commands++;
+            bin_out_status(conn, req, MEMKV_BIN_STATUS_NOT_SUPPORTED);
+            break;
+    }
+}
+
+// 执行一条解析好的请求
+static void handle_command(memkv_conn_t* conn, const memkv_request_t* req) {
+    INFRA_LOG_DEBUG("Processing command from %s: %.*s", conn->client_addr,
+                    (int)req->name.len, req->name.ptr);
+    conn->total_commands++;
+
+    switch (req->cmd) {
+        case MEMKV_CMD_GET:
+        case MEMKV_CMD_GETS:
+        case MEMKV_CMD_GAT:
+        case MEMKV_CMD_GATS: {
+            if (get_state()->sharded) {
+                if (handle_get_multi(conn, req) < 0) {
+                    return;
+                }
+                conn_out_text(conn, "END\r\n", 5);
+                break;
+            }
+            memkv_span_t keys = req->keys;
+            memkv_span_t key;
+            while (memkv_proto_next_token(&keys, &key)) {
+                if (handle_get(conn, key, req) < 0) {
+                    return;
+                }
+            }
+            conn_out_text(conn, "END\r\n", 5);
+            break;
+        }
+        case MEMKV_CMD_SET:
+        case MEMKV_CMD_ADD:
+        case MEMKV_CMD_REPLACE:
+        case MEMKV_CMD_APPEND:
+        case MEMKV_CMD_PREPEND:
+        case MEMKV_CMD_CAS:
+            handle_store(conn, req);
+            break;
+        case MEMKV_CMD_TOUCH:
+            handle_touch(conn, req);
+            break;
+        case MEMKV_CMD_STATS:
+            handle_stats(conn, req);
+            break;
+        case MEMKV_CMD_DELETE:
+            handle_delete(conn, req->key, req->noreply);
+            break;
+        case MEMKV_CMD_FLUSH_ALL:
+            handle_flush(conn, req->noreply);
+            break;
+        case MEMKV_CMD_INCR:
+        case MEMKV_CMD_DECR:
+            handle_incr_decr(conn, req->key, req->delta, req->cmd == MEMKV_CMD_INCR);
+            break;
+        case MEMKV_CMD_VERSION:
+            conn_out_cstr(conn, "VERSION " MEMKV_VERSION "\r\n");
+            break;
+        case MEMKV_CMD_QUIT:
+            conn->should_close = true;
+            break;
+        case MEMKV_CMD_META_GET:
+            handle_meta_get(conn, req);
+            break;
+        case MEMKV_CMD_META_SET:
+            handle_meta_set(conn, req);
+            break;
+        case MEMKV_CMD_META_DELETE:
+            handle_meta_delete(conn, req);
+            break;
+        case MEMKV_CMD_META_NOOP:
+            conn_out_text(conn, "MN\r\n", 4);
+            break;
+        default:
+            // 已能正确分帧但尚未实现的命令
+            conn->failed_commands++;
+            conn_out_cstr(conn, "ERROR\r\n");
+            break;
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Receive
+//-----------------------------------------------------------------------------
+
+// 接收缓冲区放不下当前请求时成倍扩大, 已到上限返回 false
+static bool conn_rx_grow(memkv_conn_t* conn) {
+    if (conn->rx_cap >= MEMKV_CONN_RX_MAX) {
+        return false;
+    }
+    size_t cap = conn->rx_cap * 2 < MEMKV_CONN_RX_MAX ? conn->rx_cap * 2 : MEMKV_CONN_RX_MAX;
+    char* buf = infra_realloc(conn->rx_buf, cap);
+    if (!buf) {
+        return false;
+    }
+    conn->rx_buf = buf;
+    conn->rx_cap = cap;
+    return true;
+}
+
+// 积压处理完后收缩回初始大小, 空闲连接只占用少量内存
+static void conn_rx_shrink(memkv_conn_t* conn) {
+    if (conn->rx_len > 0 || conn->rx_cap <= MEMKV_CONN_RX_INIT) {
+        return;
+    }
+    char* buf = infra_realloc(conn->rx_buf, MEMKV_CONN_RX_INIT);
+    if (buf) {
+        conn->rx_buf = buf;
+        conn->rx_cap = MEMKV_CONN_RX_INIT;
+    }
+}
+
+// 存储命令的大数据块未到齐: 分配 item, 之后收到的数据直接读入其 value
+static void stream_begin(memkv_conn_t* conn, const memkv_request_t* req) {
+    memkv_item_t* it = engine_ready(conn)
+        ? engine_item_alloc(conn, req->key.ptr, req->key.len, req->data.len) : NULL;
+    if (!it && conn->call_pending > 0) {
+        return;  // 等待属主分配, 命令重新执行时再开始接收
+    }
+    if (!it) {
+        conn->total_commands++;
+        conn->failed_commands++;
+        if (!req->noreply) {
+            conn_out_cstr(conn, "SERVER_ERROR out of memory storing object\r\n");
+        }
+        memkv_proto_skip(&conn->parser, req->data.len + 2);
+        return;
+    }
+
+    memkv_stream_t* stream = &conn->stream;
+    stream->item = it;
+    stream->req = *req;
+    stream->filled = 0;
+    stream->tail_len = 0;
+
+    // 接收缓冲区随后会被移动, 请求中引用它的区间改指向副本
+    stream->req.name = (memkv_span_t){MEMKV_ITEM_KEY(it), 0};
+    stream->req.args = stream->req.name;
+    stream->req.key = (memkv_span_t){MEMKV_ITEM_KEY(it), it->nkey};
+    stream->req.keys = stream->req.key;
+    if (req->meta & MEMKV_META_OPAQUE) {
+        memcpy(stream->opaque, req->meta_opaque.ptr, req->meta_opaque.len);
+        stream->req.meta_opaque.ptr = stream->opaque;
+    }
+}
+
+// 把接收缓冲区中的数据读入流式接收的 item, 返回消耗的字节数
+static size_t stream_feed(memkv_conn_t* conn, const char* data, size_t len) {
+    memkv_stream_t* stream = &conn->stream;
+    size_t want = stream->item->nbytes - stream->filled;
+    size_t n = len < want ? len : want;
+    memcpy(MEMKV_ITEM_VALUE(stream->item) + stream->filled, data, n);
+    stream->filled += n;
+    while (n < len && stream->tail_len < 2) {
+        stream->tail[stream->tail_len++] = data[n++];
+    }
+    return n;
+}
+
+// 数据块到齐后执行命令
+static void stream_finish(memkv_conn_t* conn) {
+    memkv_stream_t* stream = &conn->stream;
+    memkv_request_t req = stream->req;
+    req.data.ptr = MEMKV_ITEM_VALUE(stream->item);
+    req.data.len = stream->item->nbytes;
+
+    if (stream->tail[0] != '\r' || stream->tail[1] != '\n') {
+        conn->total_commands++;
+        conn->failed_commands++;
+        conn_out_cstr(conn, "CLIENT_ERROR bad data chunk\r\n");
+    } else if (req.cmd == MEMKV_CMD_META_SET) {
+        conn->total_commands++;
+        handle_meta_set(conn, &req);
+    } else {
+        conn->total_commands++;
+        handle_store(conn, &req);
+    }
+    if (conn->call_pending > 0) {
+        return;  // 等待属主写入, 重新执行时 item 仍要用
+    }
+
+    // 挂表后由 store 持有自己的引用
+    memkv_item_release(stream->item);
+    stream->item = NULL;
+}
+
+static void handle_request(memkv_conn_t* conn) {
+    if (!conn || !conn->rx_buf || conn->sock <= 0) {
+        INFRA_LOG_ERROR("Invalid connection state");
+        return;
+    }
+
+    // 流式接收的 value 未收完且没有积压数据时, 直接读入 item
+    memkv_stream_t* stream = &conn->stream;
+    bool direct = stream->item && conn->rx_len == 0 && stream->filled < stream->item->nbytes;
+    char* dst;
+    size_t room;
+    if (direct) {
+        dst = MEMKV_ITEM_VALUE(stream->item) + stream->filled;
+        room = stream->item->nbytes - stream->filled;
+    } else {
+        // 解析器保证单条请求不超过缓冲区上限, 到上限仍放不下说明请求非法
+        if (conn->rx_len == conn->rx_cap && !conn_rx_grow(conn)) {
+            INFRA_LOG_ERROR("Receive buffer full for %s", conn->client_addr);
+            conn_out_cstr(conn, "SERVER_ERROR buffer full\r\n");
+            conn->should_close = true;
+            return;
+        }
+        dst = conn->rx_buf + conn->rx_len;
+        room = conn->rx_cap - conn->rx_len;
+    }
+
+    // 接收数据
+    size_t received = 0;
+    infra_error_t err = infra_net_recv(conn->sock, dst, room, &received);
+    
+    if (err == INFRA_ERROR_IO) {
+        // 检查是否是非阻塞错误
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return;  // 暂时没有数据可读，稍后再试
+        }
+        INFRA_LOG_ERROR("Failed to receive data from %s: %s", 
                         conn->client_addr, strerror(errno));
         conn->should_close = true;
         return;
+    } else if (err == INFRA_ERROR_WOULD_BLOCK) {
+        return;
     } else if (err != INFRA_OK) {
         INFRA_LOG_ERROR("Failed to receive data from %s: %d", 
                         conn->client_addr, err);
@@ -602,293 +2774,841 @@ static void handle_request(memkv_conn_t* conn) {
         return;
     }
 
-    conn->rx_len += received;
-    conn->rx_buf[conn->rx_len] = '\0';  // 确保字符串以 null 结尾
     conn->last_active_time = time(NULL);
+    if (direct) {
+        stream->filled += received;
+        return;
+    }
+    conn->rx_len += received;
 
     INFRA_LOG_DEBUG("Received %zu bytes from %s, total buffer size: %zu", 
                 received, conn->client_addr, conn->rx_len);
 
-    // 处理接收到的命令
-    char* line = conn->rx_buf;
-    char* next_line;
-    char* data_line = NULL;
-    size_t data_len = 0;
-    
-    while (line && *line && !conn->should_close) {
-        // 查找下一行
-        next_line = strstr(line, "\r\n");
-        if (!next_line) {
-            // 命令不完整，等待更多数据
-            if (line != conn->rx_buf) {
-                // 移动未完成的命令到缓冲区开始
-                size_t remaining = conn->rx_len - (line - conn->rx_buf);
-                memmove(conn->rx_buf, line, remaining);
-                conn->rx_len = remaining;
-            }
-            return;
+    conn_process(conn);
+}
+
+// 命令执行前的连接状态, 命令因等待其他分片而暂停时据此撤销其输出和计数
+typedef struct memkv_conn_mark {
+    size_t out_count;
+    size_t out_last_len;         // 最后一段未发送数据的长度, 之后的输出可能并入其中
+    size_t out_buf_len;
+    size_t out_pending;
+    uint32_t total_commands;
+    uint32_t failed_commands;
+    bool should_close;
+    memkv_parser_t parser;
+    memkv_stats_t stats;
+} memkv_conn_mark_t;
+
+static void conn_mark(memkv_conn_t* conn, memkv_conn_mark_t* mark) {
+    mark->out_count = conn->out_count;
+    mark->out_last_len = conn->out_count > conn->out_head ? conn->out[conn->out_count - 1].len : 0;
+    mark->out_buf_len = conn->out_buf_len;
+    mark->out_pending = conn->out_pending;
+    mark->total_commands = conn->total_commands;
+    mark->failed_commands = conn->failed_commands;
+    mark->should_close = conn->should_close;
+    mark->parser = conn->parser;
+    mark->stats = conn->reactor->stats;
+}
+
+// 命令执行完毕时释放调用记录并返回 false; 有调用在途时撤销这条命令的输出和计数,
+// 返回 true, 回复到齐后从同一位置重新执行
+static bool conn_rollback(memkv_conn_t* conn, const memkv_conn_mark_t* mark) {
+    if (conn->call_pending == 0) {
+        shard_calls_clear(conn);
+        return false;
+    }
+
+    for (size_t i = mark->out_count; i < conn->out_count; i++) {
+        if (conn->out[i].item) {
+            memkv_item_release(conn->out[i].item);
         }
-        *next_line = '\0';  // 将 \r\n 替换为字符串结束符
-        next_line += 2;     // 跳过 \r\n
+    }
+    conn->out_count = mark->out_count;
+    if (mark->out_count > conn->out_head) {
+        conn->out[mark->out_count - 1].len = mark->out_last_len;
+    }
+    conn->out_buf_len = mark->out_buf_len;
+    conn->out_pending = mark->out_pending;
+    conn->total_commands = mark->total_commands;
+    conn->failed_commands = mark->failed_commands;
+    conn->should_close = mark->should_close;
+    conn->parser = mark->parser;
+    conn->reactor->stats = mark->stats;
+    for (memkv_shard_call_t* call = conn->calls; call; call = call->next) {
+        call->used = false;
+    }
+    return true;
+}
 
-        // 跳过空行
-        if (*line == '\0') {
-            line = next_line;
-            continue;
+// 逐条解析并执行 rx_buf 中的请求, 请求直接引用 rx_buf 中的数据.
+// 响应先进入输出队列; 积压过多且发不出去时暂停, 剩余请求等可写后继续处理.
+// 分片模式下命令等待其他分片时撤销并暂停, 回复到齐后从 rx_head 重新执行
+static void conn_process(memkv_conn_t* conn) {
+    if (conn->call_pending > 0) {
+        return;
+    }
+
+    bool sharded = get_state()->sharded;
+    memkv_conn_mark_t mark;
+    size_t pos = conn->rx_head;
+    // 数据块已到齐而写入暂停过的流式命令, 不需要新数据就能继续
+    while ((pos < conn->rx_len || (conn->stream.item && conn->stream.tail_len == 2)) &&
+           !conn->should_close) {
+        if (conn->out_pending >= MEMKV_OUT_HIGH_WATER &&
+            (conn->commit_last || conn_flush(conn) != INFRA_OK)) {
+            break;
+        }
+        if (sharded) {
+            conn_mark(conn, &mark);
         }
 
-        // 如果正在处理 SET 命令的数据部分
-        if (conn->set_bytes > 0) {
-            data_line = line;
-            data_len = next_line - line - 2;  // 减去 \r\n
-            
-            // 验证数据长度
-            if (data_len != conn->set_bytes) {
-                INFRA_LOG_ERROR("Data length mismatch: expected %zu, got %zu", 
-                               conn->set_bytes, data_len);
-                if (!conn->set_noreply) {
-                    send_all(conn->sock, "CLIENT_ERROR bad data chunk\r\n", 26);
+        if (conn->stream.item) {
+            if (conn->stream.tail_len < 2) {
+                pos += stream_feed(conn, conn->rx_buf + pos, conn->rx_len - pos);
+                if (conn->stream.tail_len < 2) {
+                    break;  // 数据块未到齐
                 }
-                conn->set_bytes = 0;  // 重置 SET 命令状态
-                line = next_line;
-                continue;
             }
+            stream_finish(conn);
+            if (sharded && conn_rollback(conn, &mark)) {
+                break;
+            }
+            continue;
+        }
 
-            // 保存数据
-            err = kv_set(conn->store, conn->set_key, data_line, data_len, 
-                        conn->set_flags, conn->set_exptime);
-            
-            if (err == INFRA_OK) {
-                if (!conn->set_noreply) {
-                    send_all(conn->sock, "STORED\r\n", 8);
-                }
+        memkv_request_t req;
+        size_t consumed = 0;
+        infra_error_t err = memkv_proto_parse(&conn->parser, conn->rx_buf + pos, conn->rx_len - pos,
+                                &req, &consumed);
+        if (err == INFRA_OK && req.stream) {
+            stream_begin(conn, &req);
+        } else if (err == INFRA_OK) {
+            if (conn->parser.protocol == MEMKV_PROTO_BINARY) {
+                handle_binary(conn, &req);
             } else {
-                INFRA_LOG_ERROR("Failed to set key-value pair: %d", err);
-                if (!conn->set_noreply) {
-                    send_all(conn->sock, "SERVER_ERROR\r\n", 14);
-                }
+                handle_command(conn, &req);
+            }
+        } else if (err == INFRA_ERROR_WOULD_BLOCK) {
+            if (consumed == 0) {
+                break;  // 请求不完整, 等待更多数据
+            }
+        } else if (err == INFRA_ERROR_PROTOCOL) {
+            conn->failed_commands++;
+            if (conn->parser.protocol == MEMKV_PROTO_BINARY) {
+                bin_out_status(conn, &req, req.status);
+            } else if (!req.noreply && req.error) {
+                conn_out_cstr(conn, req.error);
+            }
+            if (consumed == 0) {
+                conn->should_close = true;
+                break;
             }
+        } else {
+            conn->should_close = true;
+            break;
+        }
+        if (sharded && conn_rollback(conn, &mark)) {
+            break;
+        }
+        pos += consumed;
+    }
+
+    if (conn->calls) {
+        // 调用记录按 key 的地址匹配, 暂停的命令完成前不移动接收缓冲区
+        conn->rx_head = pos;
+        return;
+    }
+    conn->rx_head = 0;
+
+    // 未处理完的半条请求移到缓冲区开头
+    if (pos > 0) {
+        size_t remaining = conn->rx_len - pos;
+        if (remaining > 0) {
+            memmove(conn->rx_buf, conn->rx_buf + pos, remaining);
+        }
+        conn->rx_len = remaining;
+    }
+    conn_rx_shrink(conn);
+}
+
+//-----------------------------------------------------------------------------
+// Reactor
+//-----------------------------------------------------------------------------
+
+#define MEMKV_REACTOR_MAX_EVENTS 256
+#define MEMKV_REACTOR_TICK_MS 1000
+
+static void reactor_link_conn(memkv_reactor_t* reactor, memkv_conn_t* conn) {
+    conn->prev = NULL;
+    conn->next = reactor->conn_head;
+    if (reactor->conn_head) {
+        reactor->conn_head->prev = conn;
+    }
+    reactor->conn_head = conn;
+    if (!reactor->conn_tail) {
+        reactor->conn_tail = conn;
+    }
+    reactor->conn_count++;
+}
+
+static void reactor_unlink_conn(memkv_reactor_t* reactor, memkv_conn_t* conn) {
+    if (conn->prev) {
+        conn->prev->next = conn->next;
+    } else {
+        reactor->conn_head = conn->next;
+    }
+    if (conn->next) {
+        conn->next->prev = conn->prev;
+    } else {
+        reactor->conn_tail = conn->prev;
+    }
+    conn->prev = conn->next = NULL;
+    reactor->conn_count--;
+}
+
+// 活跃的连接移到链表头部, 超时扫描只需从尾部开始
+static void reactor_touch_conn(memkv_reactor_t* reactor, memkv_conn_t* conn) {
+    conn->last_active_time = time(NULL);
+    if (reactor->conn_head == conn) {
+        return;
+    }
+    reactor_unlink_conn(reactor, conn);
+    reactor_link_conn(reactor, conn);
+}
+
+// 按连接状态设置关注的事件: 输出积压时只等可写, 暂停期间 (等待数据库句柄或分片回复)
+// 不读取, 其余时候等可读
+static infra_error_t reactor_arm_conn(memkv_reactor_t* reactor, memkv_conn_t* conn) {
+    int events = conn->want_write ? POLY_POLL_WRITE
+                                  : (conn->parked || conn->calls ? 0 : POLY_POLL_READ);
+    if (events == conn->poll_events) {
+        return INFRA_OK;
+    }
+    if (poly_poll_loop_modify(reactor->loop, conn->sock, events, conn) != INFRA_OK) {
+        conn->should_close = true;
+        return INFRA_ERROR_IO;
+    }
+    conn->poll_events = events;
+    return INFRA_OK;
+}
+
+// 发送输出队列; 发不完时改为只等待可写, 暂停读取作为背压, 发完后恢复读取.
+// 响应依赖的组提交事务未落盘前不发送
+static infra_error_t reactor_flush_conn(memkv_reactor_t* reactor, memkv_conn_t* conn) {
+    infra_error_t err = conn->commit_last ? INFRA_OK : conn_flush(conn);
+    if (err != INFRA_OK && err != INFRA_ERROR_WOULD_BLOCK) {
+        conn->should_close = true;
+        return err;
+    }
+    conn->want_write = err == INFRA_ERROR_WOULD_BLOCK;
+    if (reactor_arm_conn(reactor, conn) != INFRA_OK) {
+        return INFRA_ERROR_IO;
+    }
+    return err;
+}
+
+static void reactor_close_conn(memkv_reactor_t* reactor, memkv_conn_t* conn) {
+    // 尽量把已排队的响应 (如协议错误) 发出去, 不等待; 未提交的写入不能确认
+    if (conn->out_head < conn->out_count && !conn->commit_last) {
+        conn_flush(conn);
+    }
+    if (conn->held) {
+        memkv_conn_t** link = &reactor->held;
+        while (*link != conn) {
+            link = &(*link)->held_next;
+        }
+        *link = conn->held_next;
+    }
+    if (conn->parked) {
+        memkv_conn_t** link = &reactor->parked;
+        while (*link != conn) {
+            link = &(*link)->parked_next;
+        }
+        *link = conn->parked_next;
+    }
+    if (conn->shard_ready) {
+        memkv_conn_t** link = &reactor->ready;
+        while (*link != conn) {
+            link = &(*link)->ready_next;
+        }
+        *link = conn->ready_next;
+    }
+    poly_poll_loop_remove(reactor->loop, conn->sock);
+    reactor_unlink_conn(reactor, conn);
+    if (conn->call_pending > 0) {
+        // 在途的请求还引用着连接的记录和接收缓冲区, 回复到齐后再释放
+        infra_net_close(conn->sock);
+        conn->sock = 0;
+        conn->is_closing = true;
+        return;
+    }
+    memkv_conn_destroy(conn);
+}
 
-            conn->set_bytes = 0;  // 重置 SET 命令状态
-            line = next_line;
+// 连接池句柄用尽: 不再关注连接的事件, 请求留在内核缓冲区, 有句柄归还后恢复
+static void reactor_park_conn(memkv_reactor_t* reactor, memkv_conn_t* conn) {
+    conn->parked = true;
+    conn->parked_next = reactor->parked;
+    reactor->parked = conn;
+    reactor_arm_conn(reactor, conn);
+}
+
+// 本轮请求处理完毕: 响应依赖未提交的事务时暂缓发送, 挂到 held 链表等待提交;
+// 否则立即发送, 输出积压时暂停解析的请求在发完后用 db 继续处理, 没有句柄时暂停连接;
+// 等待分片回复的连接由回复唤醒
+static void reactor_commit_conn(memkv_reactor_t* reactor, memkv_conn_t* conn, poly_db_t* db) {
+    while (!conn->commit_last) {
+        bool paused = conn->out_pending >= MEMKV_OUT_HIGH_WATER;
+        if (reactor_flush_conn(reactor, conn) != INFRA_OK || !paused || conn->rx_len == 0 ||
+            conn->should_close || conn->call_pending > 0) {
+            return;
+        }
+        if (!db && get_state()->engine != MEMKV_ENGINE_MEMORY) {
+            reactor_park_conn(reactor, conn);
+            return;
+        }
+        conn->store = db;
+        conn_process(conn);
+        conn->store = NULL;
+    }
+
+    if (!conn->held) {
+        conn->held = true;
+        conn->held_next = reactor->held;
+        reactor->held = conn;
+    }
+}
+
+// 借到句柄后恢复暂停的连接: 重新关注可读, 先处理已收到的请求
+static void reactor_resume_parked(memkv_reactor_t* reactor, poly_db_t* db) {
+    memkv_conn_t* conn = reactor->parked;
+    reactor->parked = NULL;
+
+    while (conn) {
+        memkv_conn_t* next = conn->parked_next;
+        conn->parked = false;
+        conn->parked_next = NULL;
+        if (reactor_arm_conn(reactor, conn) == INFRA_OK && conn->rx_len > 0) {
+            conn->store = db;
+            conn_process(conn);
+            conn->store = NULL;
+            reactor_commit_conn(reactor, conn, db);
+        }
+        if (conn->should_close) {
+            reactor_close_conn(reactor, conn);
+        }
+        conn = next;
+    }
+}
+
+// 发送事务已提交的连接的响应, 提交失败的连接直接断开
+static void reactor_release_held(memkv_reactor_t* reactor, poly_db_t* db) {
+    memkv_state_t* state = get_state();
+    memkv_conn_t* conn = reactor->held;
+    reactor->held = NULL;
+
+    while (conn) {
+        memkv_conn_t* next = conn->held_next;
+        infra_error_t err = poly_db_writer_check(state->writer, conn->commit_first, conn->commit_last);
+        if (err == INFRA_ERROR_WOULD_BLOCK) {
+            conn->held_next = reactor->held;
+            reactor->held = conn;
+            conn = next;
             continue;
         }
 
-        // 解析命令
-        char cmd[32] = {0};
-        char key[256] = {0};
-        
-        if (sscanf(line, "%31s %255s", cmd, key) < 1) {
-            INFRA_LOG_ERROR("Failed to parse command from %s: [%s]", conn->client_addr, line);
-            conn->failed_commands++;
-            send_all(conn->sock, "ERROR\r\n", 7);
-            line = next_line;
+        conn->held = false;
+        conn->held_next = NULL;
+        conn->commit_first = 0;
+        conn->commit_last = 0;
+        if (err != INFRA_OK) {
+            INFRA_LOG_ERROR("Group commit failed, closing %s", conn->client_addr);
+            conn_out_reset(conn);
+            conn->should_close = true;
+        } else {
+            reactor_commit_conn(reactor, conn, db);
+        }
+        if (conn->should_close) {
+            reactor_close_conn(reactor, conn);
+        }
+        conn = next;
+    }
+}
+
+// 分片回复已到齐的连接: 重新执行暂停的命令, 继续处理其后已收到的请求
+static void reactor_resume_ready(memkv_reactor_t* reactor) {
+    memkv_conn_t* conn = reactor->ready;
+    reactor->ready = NULL;
+
+    while (conn) {
+        memkv_conn_t* next = conn->ready_next;
+        conn->shard_ready = false;
+        conn->ready_next = NULL;
+        conn_process(conn);
+        reactor_commit_conn(reactor, conn, NULL);
+        if (conn->should_close) {
+            reactor_close_conn(reactor, conn);
+        } else {
+            reactor_touch_conn(reactor, conn);
+        }
+        conn = next;
+    }
+}
+
+// 注册 accept 线程投递过来的新连接
+static void reactor_register_pending(memkv_reactor_t* reactor) {
+    infra_mutex_lock(reactor->pending_mutex);
+    memkv_conn_t* conn = reactor->pending;
+    reactor->pending = NULL;
+    infra_mutex_unlock(reactor->pending_mutex);
+
+    while (conn) {
+        memkv_conn_t* next = conn->next;
+        conn->next = NULL;
+
+        infra_error_t err = poly_poll_loop_add(reactor->loop, conn->sock, POLY_POLL_READ, conn);
+        if (err != INFRA_OK) {
+            INFRA_LOG_ERROR("Failed to register connection %s: %d", conn->client_addr, err);
+            memkv_conn_destroy(conn);
+            conn = next;
             continue;
         }
 
-        INFRA_LOG_DEBUG("Processing command from %s: %s, key: %s", conn->client_addr, cmd, key);
-        conn->total_commands++;
+        conn->reactor = reactor;
+        conn->poll_events = POLY_POLL_READ;
+        conn->last_active_time = time(NULL);
+        reactor->stats.total_connections++;
+        reactor_link_conn(reactor, conn);
+        INFRA_LOG_INFO("New client connection from %s (reactor %d)", conn->client_addr, reactor->id);
+        conn = next;
+    }
+}
 
-        // 处理命令
-        if (strncmp(cmd, "get", 3) == 0) {
-            // 检查是否有更多的参数
-            char* next_key = key;
-            bool error_occurred = false;
-            
-            while (next_key && *next_key && !error_occurred && !conn->should_close) {
-                // 处理当前 key
-                int result = handle_get(conn, next_key);
-                if (result < 0) {
-                    error_occurred = true;
-                    break;
-                }
-                
-                // 查找下一个 key
-                char* space = strchr(next_key, ' ');
-                if (space) {
-                    *space = '\0';
-                    next_key = space + 1;
-                    while (*next_key == ' ') next_key++;  // 跳过多余的空格
-                } else {
-                    next_key = NULL;
-                }
+// 关闭空闲超时的连接
+static void reactor_sweep_idle(memkv_reactor_t* reactor) {
+    time_t now = time(NULL);
+    while (reactor->conn_tail &&
+           now - reactor->conn_tail->last_active_time > MEMKV_CONN_IDLE_TIMEOUT) {
+        memkv_conn_t* conn = reactor->conn_tail;
+        INFRA_LOG_INFO("Connection timeout for %s", conn->client_addr);
+        reactor_close_conn(reactor, conn);
+    }
+}
+
+static void* reactor_thread(void* arg) {
+    memkv_reactor_t* reactor = (memkv_reactor_t*)arg;
+    memkv_state_t* state = get_state();
+    poly_poll_event_t events[MEMKV_REACTOR_MAX_EVENTS];
+    memkv_conn_t* closing[MEMKV_REACTOR_MAX_EVENTS];
+    uint64_t last_sweep = infra_time_ms();
+
+    INFRA_LOG_DEBUG("Reactor %d started (%s)", reactor->id, poly_poll_loop_backend(reactor->loop));
+
+    while (reactor->running) {
+        int count = 0;
+        infra_error_t err = poly_poll_loop_wait(reactor->loop, events,
+                                                MEMKV_REACTOR_MAX_EVENTS,
+                                                MEMKV_REACTOR_TICK_MS, &count);
+        if (err != INFRA_OK) {
+            INFRA_LOG_ERROR("Reactor %d wait failed: %d", reactor->id, err);
+            infra_sleep(10);
+            continue;
+        }
+
+        reactor_register_pending(reactor);
+        shard_drain(reactor);
+
+        // 数据库引擎每批请求借用一个共享句柄, 批处理结束即归还; 句柄用尽时不等待,
+        // 暂停本批的连接, 有句柄归还时被唤醒再恢复. 组提交的写句柄只在写入语句期间持有
+        poly_db_t* batch_db = NULL;
+        bool db_busy = false;
+        if ((count > 0 || reactor->parked || reactor->held) && state->engine != MEMKV_ENGINE_MEMORY) {
+            db_busy = db_pool_try_acquire(state, true, &batch_db) == INFRA_ERROR_WOULD_BLOCK;
+            if (!batch_db && !db_busy) {
+                INFRA_LOG_ERROR("Reactor %d failed to acquire database handle", reactor->id);
             }
-            
-            // 如果没有发生错误，发送 END 标记
-            if (!error_occurred && !conn->should_close) {
-                err = send_all(conn->sock, "END\r\n", 5);
-                if (err != INFRA_OK) {
-                    INFRA_LOG_ERROR("Failed to send END response: %d", err);
-                    conn->should_close = true;
-                }
+        }
+
+        // 同一批事件处理完后再释放连接, 避免后续事件引用已释放的连接
+        int closing_count = 0;
+        for (int i = 0; i < count; i++) {
+            memkv_conn_t* conn = (memkv_conn_t*)events[i].user_data;
+            if (!conn || conn->should_close) {
+                continue;
+            }
+            if (conn->parked || (conn->calls && !conn->want_write)) {
+                // 暂停读取期间只会收到错误事件, 对端已断开
+                conn->should_close = true;
+                closing[closing_count++] = conn;
+                continue;
             }
-            line = next_line;
-        }
-        else if (strcmp(cmd, "set") == 0) {
-            char flags_str[32] = {0};
-            char exptime_str[32] = {0};
-            char bytes_str[32] = {0};
-            char noreply_str[32] = {0};
-            int matched = sscanf(line, "%*s %*s %31s %31s %31s %31s", 
-                               flags_str, exptime_str, bytes_str, noreply_str);
-            
-            if (matched >= 3) {
-                conn->set_flags = (uint32_t)strtoul(flags_str, NULL, 10);
-                conn->set_exptime = (uint32_t)strtoul(exptime_str, NULL, 10);
-                conn->set_bytes = (size_t)strtoul(bytes_str, NULL, 10);
-                
-                if (conn->set_bytes > MEMKV_MAX_DATA_SIZE) {
-                    INFRA_LOG_ERROR("Value too large from %s: %zu", conn->client_addr, conn->set_bytes);
-                    if (!conn->set_noreply) {
-                        send_all(conn->sock, "SERVER_ERROR value too large\r\n", 28);
+
+            conn->store = batch_db;
+            if (conn->want_write) {
+                // 输出积压期间只关注可写, 发完后继续处理已收到的请求
+                if (events[i].events & (POLY_POLL_WRITE | POLY_POLL_ERROR)) {
+                    if (reactor_flush_conn(reactor, conn) == INFRA_OK && conn->rx_len > 0) {
+                        if (db_busy) {
+                            reactor_park_conn(reactor, conn);
+                        } else {
+                            conn_process(conn);
+                            reactor_commit_conn(reactor, conn, batch_db);
+                        }
                     }
-                    conn->set_bytes = 0;  // 重置 SET 命令状态
-                    line = next_line;
-                    continue;
                 }
+            } else if (db_busy) {
+                reactor_park_conn(reactor, conn);
+            } else if (events[i].events & (POLY_POLL_READ | POLY_POLL_ERROR)) {
+                handle_request(conn);
+                reactor_commit_conn(reactor, conn, batch_db);
+            }
+            conn->store = NULL;
+
+            if (conn->should_close) {
+                closing[closing_count++] = conn;
+            } else {
+                reactor_touch_conn(reactor, conn);
+            }
+
+            // 及时执行其他 reactor 的请求, 不让它们等完整批事件
+            shard_drain(reactor);
+        }
+
+        for (int i = 0; i < closing_count; i++) {
+            reactor_close_conn(reactor, closing[i]);
+        }
+        if (reactor->ready) {
+            reactor_resume_ready(reactor);
+        }
+        if (batch_db && reactor->parked) {
+            reactor_resume_parked(reactor, batch_db);
+        }
+        if (reactor->held) {
+            reactor_release_held(reactor, batch_db);
+        }
+        db_pool_release(state, batch_db);
+
+        uint64_t now = infra_time_ms();
+        if (now - last_sweep >= MEMKV_REACTOR_TICK_MS) {
+            reactor_sweep_idle(reactor);
+            // 热点计数每秒减半, 副本缓存释放已失效的 item
+            memkv_hotkeys_decay(reactor->hotkeys);
+            if (reactor->hotcache) {
+                memkv_hotcache_sweep(reactor->hotcache);
+            }
+            last_sweep = now;
+        }
+    }
+
+    // 关闭剩余连接
+    reactor_register_pending(reactor);
+    while (reactor->conn_head) {
+        reactor_close_conn(reactor, reactor->conn_head);
+    }
+
+    // 其他 reactor 可能还有请求投给本分片, 已关闭的连接也在等回复:
+    // 全部退出事件循环且所有调用都已回复后才停止服务 mailbox
+    if (state->sharded) {
+        __atomic_fetch_add(&state->reactors_exited, 1, __ATOMIC_ACQ_REL);
+        while (__atomic_load_n(&state->reactors_exited, __ATOMIC_ACQUIRE) < state->reactors_started ||
+               __atomic_load_n(&state->shard_inflight, __ATOMIC_ACQUIRE) > 0) {
+            shard_drain(reactor);
+            infra_platform_yield();
+        }
+    }
+
+    INFRA_LOG_DEBUG("Reactor %d stopped", reactor->id);
+    return NULL;
+}
+
+static int reactor_default_count(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    if (n < 1) n = 1;
+    if (n > MEMKV_MAX_THREADS) n = MEMKV_MAX_THREADS;
+    return (int)n;
+}
+
+static void reactors_stop(memkv_state_t* state) {
+    if (!state->reactors) {
+        return;
+    }
+
+    // 先全部通知再逐个等待, 分片模式下各 reactor 要一起退出
+    for (int i = 0; i < state->reactor_count; i++) {
+        memkv_reactor_t* reactor = &state->reactors[i];
+        if (reactor->thread) {
+            reactor->running = false;
+            poly_poll_loop_wakeup(reactor->loop);
+        }
+    }
+    for (int i = 0; i < state->reactor_count; i++) {
+        memkv_reactor_t* reactor = &state->reactors[i];
+        if (reactor->thread) {
+            infra_thread_join(reactor->thread);
+            reactor->thread = NULL;
+        }
+    }
+    db_writer_destroy(state);
+
+    for (int i = 0; i < state->reactor_count; i++) {
+        memkv_reactor_t* reactor = &state->reactors[i];
+        if (reactor->loop) {
+            poly_poll_loop_destroy(reactor->loop);
+        }
+        if (reactor->pending_mutex) {
+            infra_mutex_destroy(reactor->pending_mutex);
+        }
+        memkv_hotkeys_destroy(reactor->hotkeys);
+        memkv_hotcache_destroy(reactor->hotcache);
+    }
+
+    infra_free(state->reactors);
+    state->reactors = NULL;
+    state->reactor_count = 0;
+    state->reactors_started = 0;
+    state->reactors_exited = 0;
+}
+
+static int reactor_configured_count(const memkv_state_t* state) {
+    return state->threads > 0 ? state->threads : reactor_default_count();
+}
+
+static infra_error_t reactors_start(memkv_state_t* state) {
+    // 分片模式下 reactor 与分片一一对应
+    int count = state->sharded ? state->shard_count : reactor_configured_count(state);
+
+    state->reactors = infra_malloc(count * sizeof(memkv_reactor_t));
+    if (!state->reactors) {
+        return INFRA_ERROR_NO_MEMORY;
+    }
+    memset(state->reactors, 0, count * sizeof(memkv_reactor_t));
+    state->reactor_count = count;
+    state->next_reactor = 0;
+    state->reactors_started = 0;
+    state->reactors_exited = 0;
+    state->shard_inflight = 0;
+
+    for (int i = 0; i < count; i++) {
+        memkv_reactor_t* reactor = &state->reactors[i];
+        reactor->id = i;
+        reactor->running = true;
+        reactor->shard = state->sharded ? state->shards[i] : NULL;
+
+        infra_error_t err = infra_mutex_create(&reactor->pending_mutex);
+        if (err == INFRA_OK) {
+            err = poly_poll_loop_create(&reactor->loop);
+        }
+        if (err == INFRA_OK) {
+            err = memkv_hotkeys_create(MEMKV_HOTKEYS_SAMPLE_RATE, &reactor->hotkeys);
+        }
+        if (err == INFRA_OK && state->hotcache) {
+            err = memkv_hotcache_create(&reactor->hotcache);
+        }
+        if (err == INFRA_OK) {
+            err = infra_thread_create(&reactor->thread, reactor_thread, reactor);
+        }
+        if (err == INFRA_OK) {
+            state->reactors_started++;
+        } else {
+            INFRA_LOG_ERROR("Failed to start reactor %d: %d", i, err);
+            reactors_stop(state);
+            return err;
+        }
+    }
+
+    INFRA_LOG_INFO("Started %d reactor threads (%s)", count,
+                   poly_poll_loop_backend(state->reactors[0].loop));
+    return INFRA_OK;
+}
+
+// 把新连接交给一个 reactor (轮询分配)
+static infra_error_t reactor_dispatch(memkv_state_t* state, memkv_conn_t* conn) {
+    if (!state->reactors || state->reactor_count <= 0) {
+        return INFRA_ERROR_INVALID_STATE;
+    }
+
+    uint32_t idx = __atomic_fetch_add(&state->next_reactor, 1, __ATOMIC_RELAXED);
+    memkv_reactor_t* reactor = &state->reactors[idx % (uint32_t)state->reactor_count];
+
+    infra_mutex_lock(reactor->pending_mutex);
+    conn->next = reactor->pending;
+    reactor->pending = conn;
+    infra_mutex_unlock(reactor->pending_mutex);
+
+    return poly_poll_loop_wakeup(reactor->loop);
+}
 
-                conn->set_noreply = (matched == 4 && strcmp(noreply_str, "noreply") == 0);
-                strncpy(conn->set_key, key, sizeof(conn->set_key) - 1);
-                line = next_line;
-            } else {
-                INFRA_LOG_ERROR("Invalid SET command format from %s: [%s]", conn->client_addr, line);
-                if (!conn->set_noreply) {
-                    send_all(conn->sock, "CLIENT_ERROR bad command line format\r\n", 37);
-                }
-                conn->set_bytes = 0;  // 重置 SET 命令状态
-                line = next_line;
+//-----------------------------------------------------------------------------
+// Expiry Crawler
+//-----------------------------------------------------------------------------
+
+// 分批删除已过期的行, 每条语句借助 expiry 索引只删一小批, 用时达到预算后停止
+static uint64_t db_crawl(memkv_state_t* state, uint32_t budget_ms) {
+    // 组提交时删除并入当前事务, 不需要等待提交
+    poly_db_t* db = NULL;
+    if (state->writer) {
+        db = poly_db_writer_begin(state->writer);
+    } else {
+        db_pool_try_acquire(state, false, &db);
+    }
+    if (!db) {
+        return 0;
+    }
+
+    char sql[160];
+    snprintf(sql, sizeof(sql),
+             "DELETE FROM kv_store WHERE rowid IN (SELECT rowid FROM kv_store "
+             "WHERE expiry > 0 AND expiry <= ? LIMIT %d)", MEMKV_CRAWLER_DB_BATCH);
+    char now[24];
+    snprintf(now, sizeof(now), "%ld", (long)time(NULL));
+
+    uint64_t start = infra_time_ms();
+    uint64_t reclaimed = 0;
+    for (;;) {
+        poly_db_stmt_t* stmt = NULL;
+        uint64_t changes = 0;
+        infra_error_t err = poly_db_prepare(db, sql, &stmt);
+        if (err == INFRA_OK) {
+            err = poly_db_bind_text(stmt, 1, now, strlen(now));
+            if (err == INFRA_OK) {
+                err = poly_db_stmt_step(stmt);
             }
+            poly_db_stmt_finalize(stmt);
         }
-        else if (strcmp(cmd, "delete") == 0) {
-            char noreply_str[32] = {0};
-            bool noreply = (sscanf(line, "%*s %*s %31s", noreply_str) == 1 && 
-                           strcmp(noreply_str, "noreply") == 0);
-            handle_delete(conn, key, noreply);
-            line = next_line;
-        }
-        else if (strcmp(cmd, "flush_all") == 0) {
-            char noreply_str[32] = {0};
-            bool noreply = (sscanf(line, "%*s %*s %31s", noreply_str) == 1 && 
-                           strcmp(noreply_str, "noreply") == 0);
-            handle_flush(conn, noreply);
-            line = next_line;
-        }
-        else if (strcmp(cmd, "incr") == 0 || strcmp(cmd, "decr") == 0) {
-            char value_str[32] = {0};
-            if (sscanf(line, "%*s %*s %31s", value_str) == 1) {
-                handle_incr_decr(conn, key, value_str, cmd[0] == 'i');
-            } else {
-                INFRA_LOG_ERROR("Invalid INCR/DECR command format from %s: [%s]", conn->client_addr, line);
-                conn->failed_commands++;
-                send_all(conn->sock, "CLIENT_ERROR bad command line format\r\n", 37);
-            }
-            line = next_line;
+        if (err == INFRA_OK) {
+            err = poly_db_changes(db, &changes);
+        }
+        if (err != INFRA_OK) {
+            INFRA_LOG_DEBUG("Expiry crawler delete failed: %d", err);
+            break;
         }
-        else {
-            INFRA_LOG_ERROR("Unknown command from %s: [%s]", conn->client_addr, cmd);
-            send_all(conn->sock, "ERROR\r\n", 7);
-            line = next_line;
+        reclaimed += changes;
+        if (changes < MEMKV_CRAWLER_DB_BATCH || infra_time_ms() - start >= budget_ms) {
+            break;
         }
     }
 
-    // 更新缓冲区
-    if (line != conn->rx_buf) {
-        size_t processed = line - conn->rx_buf;
-        if (processed < conn->rx_len) {
-            size_t remaining = conn->rx_len - processed;
-            memmove(conn->rx_buf, line, remaining);
-            conn->rx_len = remaining;
-        } else {
-            conn->rx_len = 0;
-        }
-    }
-    
-    // 如果缓冲区已经处理完毕，重置它
-    if (conn->rx_len == 0) {
-        conn->rx_buf[0] = '\0';
+    if (state->writer) {
+        poly_db_writer_end(state->writer);
+    } else {
+        db_pool_release(state, db);
     }
+    return reclaimed;
 }
 
-static void handle_connection(void* args) {
-    poly_poll_handler_args_t* handler_args = (poly_poll_handler_args_t*)args;
-    if (!handler_args || !handler_args->user_data) {
-        INFRA_LOG_ERROR("Invalid parameters in handle_connection");
-        return;
-    }
+// 周期性回收过期数据, 每个周期只占用很短的时间, 前台读写不等待回收
+static void* crawler_thread(void* arg) {
+    memkv_state_t* state = (memkv_state_t*)arg;
 
-    memkv_conn_t* conn = (memkv_conn_t*)handler_args->user_data;
-    
-    // 设置 TCP keepalive 参数
-    if (setsockopt(conn->sock, SOL_SOCKET, SO_KEEPALIVE, &(int){1}, sizeof(int)) < 0) {
-        INFRA_LOG_WARN("Failed to set SO_KEEPALIVE");
-    }
+    INFRA_LOG_DEBUG("Expiry crawler started");
+    infra_mutex_lock(state->crawler_mutex);
+    while (state->crawler_running) {
+        infra_cond_timedwait(state->crawler_cond, state->crawler_mutex, MEMKV_CRAWLER_INTERVAL_MS);
+        if (!state->crawler_running) {
+            break;
+        }
+        infra_mutex_unlock(state->crawler_mutex);
 
-    #ifdef TCP_KEEPIDLE
-    if (setsockopt(conn->sock, IPPROTO_TCP, TCP_KEEPIDLE, &(int){120}, sizeof(int)) < 0) {
-        INFRA_LOG_WARN("Failed to set TCP_KEEPIDLE");
-    }
-    #endif
+        if (state->engine == MEMKV_ENGINE_MEMORY && state->sharded) {
+            // 回收只 trylock 段锁, 不会阻塞分片的属主
+            for (int i = 0; i < state->shard_count; i++) {
+                memkv_store_crawl(state->shards[i], MEMKV_CRAWLER_BUDGET_MS);
+            }
+        } else if (state->engine == MEMKV_ENGINE_MEMORY) {
+            memkv_store_crawl(state->store, MEMKV_CRAWLER_BUDGET_MS);
+        } else {
+            uint64_t n = db_crawl(state, MEMKV_CRAWLER_BUDGET_MS);
+            if (n > 0) {
+                __atomic_fetch_add(&state->db_crawler_reclaimed, n, __ATOMIC_RELAXED);
+            }
+        }
 
-    #ifdef TCP_KEEPINTVL
-    if (setsockopt(conn->sock, IPPROTO_TCP, TCP_KEEPINTVL, &(int){30}, sizeof(int)) < 0) {
-        INFRA_LOG_WARN("Failed to set TCP_KEEPINTVL");
+        infra_mutex_lock(state->crawler_mutex);
     }
-    #endif
+    infra_mutex_unlock(state->crawler_mutex);
+    INFRA_LOG_DEBUG("Expiry crawler stopped");
+    return NULL;
+}
 
-    #ifdef TCP_KEEPCNT
-    if (setsockopt(conn->sock, IPPROTO_TCP, TCP_KEEPCNT, &(int){3}, sizeof(int)) < 0) {
-        INFRA_LOG_WARN("Failed to set TCP_KEEPCNT");
+static void crawler_stop(memkv_state_t* state) {
+    if (state->crawler) {
+        infra_mutex_lock(state->crawler_mutex);
+        state->crawler_running = false;
+        infra_cond_signal(state->crawler_cond);
+        infra_mutex_unlock(state->crawler_mutex);
+        infra_thread_join(state->crawler);
+        state->crawler = NULL;
     }
-    #endif
-
-    // 设置非阻塞模式
-    if (infra_net_set_nonblock(conn->sock, true) != INFRA_OK) {
-        INFRA_LOG_ERROR("Failed to set non-blocking mode");
-        memkv_conn_destroy(conn);
-        return;
+    if (state->crawler_cond) {
+        infra_cond_destroy(state->crawler_cond);
+        state->crawler_cond = NULL;
+    }
+    if (state->crawler_mutex) {
+        infra_mutex_destroy(state->crawler_mutex);
+        state->crawler_mutex = NULL;
     }
+}
 
-    // 初始化数据库连接
-    infra_error_t err = db_init(&conn->store, conn->store_path);
+static infra_error_t crawler_start(memkv_state_t* state) {
+    infra_error_t err = infra_mutex_create(&state->crawler_mutex);
+    if (err == INFRA_OK) {
+        err = infra_cond_init(&state->crawler_cond);
+    }
+    if (err == INFRA_OK) {
+        state->crawler_running = true;
+        err = infra_thread_create(&state->crawler, crawler_thread, state);
+    }
     if (err != INFRA_OK) {
-        INFRA_LOG_ERROR("Failed to initialize database connection");
-        memkv_conn_destroy(conn);
-        return;
+        state->crawler_running = false;
+        state->crawler = NULL;
+        crawler_stop(state);
     }
+    return err;
+}
 
-    INFRA_LOG_INFO("New client connection from %s", conn->client_addr);
+//-----------------------------------------------------------------------------
+// Shard Stores
+//-----------------------------------------------------------------------------
 
-    // 处理客户端请求
-    while (!conn->should_close) {
-        handle_request(conn);
-        if (conn->should_close) {
-            break;
-        }
-        
-        // 检查连接是否超时
-        time_t now = time(NULL);
-        if (now - conn->last_active_time > 300) { // 5分钟超时
-            INFRA_LOG_INFO("Connection timeout for %s", conn->client_addr);
-            break;
-        }
-        
-        // 如果没有更多数据要处理，就短暂等待
-        if (conn->rx_len == 0) {
-            usleep(1000);  // 1ms
-            continue;
+static void shards_destroy(memkv_state_t* state) {
+    if (!state->shards) {
+        return;
+    }
+    for (int i = 0; i < state->shard_count; i++) {
+        if (state->shards[i]) {
+            memkv_store_destroy(state->shards[i]);
         }
     }
+    infra_free(state->shards);
+    state->shards = NULL;
+    state->shard_count = 0;
+}
 
-    // 在关闭连接前确保数据已经持久化
-    if (conn->store) {
-        poly_db_exec(conn->store, "PRAGMA wal_checkpoint;");
+static infra_error_t shards_create(memkv_state_t* state) {
+    int count = reactor_configured_count(state);
+    state->shards = infra_malloc(count * sizeof(memkv_store_t*));
+    if (!state->shards) {
+        return INFRA_ERROR_NO_MEMORY;
     }
-
-    // 等待一小段时间，确保所有数据都发送完成
-    usleep(10000);  // 10ms
-
-    // 关闭连接
-    memkv_conn_destroy(conn);
+    memset(state->shards, 0, count * sizeof(memkv_store_t*));
+    state->shard_count = count;
+
+    // 分片只由一个线程读写, 少分几段即可
+    memkv_store_config_t store_config = {
+        .segments = 8,
+        .max_memory = state->max_memory / count,
+        .growth_factor = state->growth_factor
+    };
+    for (int i = 0; i < count; i++) {
+        infra_error_t err = memkv_store_create(&store_config, &state->shards[i]);
+        if (err != INFRA_OK) {
+            shards_destroy(state);
+            return err;
+        }
+    }
+    return INFRA_OK;
 }
 
 //-----------------------------------------------------------------------------
@@ -923,6 +3643,9 @@ infra_error_t memkv_init(void) {
     state->port = MEMKV_DEFAULT_PORT;
     strncpy(state->host, "127.0.0.1", sizeof(state->host) - 1);
     strncpy(state->db_path, ":memory:", sizeof(state->db_path) - 1);
+    state->engine = MEMKV_ENGINE_MEMORY;
+    state->max_memory = (size_t)MEMKV_DEFAULT_MEMORY_MB * 1024 * 1024;
+    state->store = NULL;
     state->running = false;
     state->ctx = NULL;
     
@@ -951,6 +3674,12 @@ infra_error_t memkv_cleanup(void) {
     // 清理资源 - 使用 memset 清空数组
     memset(state->db_path, 0, sizeof(state->db_path));
 
+    if (state->store) {
+        memkv_store_destroy(state->store);
+        state->store = NULL;
+    }
+    shards_destroy(state);
+
     // 释放状态结构
     infra_free(state);
     g_memkv_service.config.user_data = NULL;
@@ -976,12 +3705,13 @@ infra_error_t memkv_start(void) {
         memset(state->ctx, 0, sizeof(poly_poll_context_t));
 
         // 初始化轮询上下文
+        // 线程池只负责把新连接交给 reactor, 不再长期占用线程
         poly_poll_config_t config = {
             .min_threads = 1,
-            .max_threads = 4,
-            .queue_size = 1024,
+            .max_threads = 2,
+            .queue_size = 4096,
             .max_listeners = 1,
-            .read_buffer_size = MEMKV_CONN_BUFFER_SIZE
+            .read_buffer_size = MEMKV_CONN_RX_INIT
         };
 
         infra_error_t err = poly_poll_init(state->ctx, &config);
@@ -993,6 +3723,52 @@ infra_error_t memkv_start(void) {
         }
     }
 
+    // 分片模式: 每个 reactor 一个 store, 内存上限平分
+    if (state->engine == MEMKV_ENGINE_MEMORY && state->sharded && !state->shards) {
+        infra_error_t err = shards_create(state);
+        if (err != INFRA_OK) {
+            INFRA_LOG_ERROR("Failed to create memory shards: %d", err);
+            return err;
+        }
+    }
+
+    // 创建原生内存存储
+    if (state->engine == MEMKV_ENGINE_MEMORY && !state->sharded && !state->store) {
+        memkv_store_config_t store_config = {
+            .max_memory = state->max_memory,
+            .growth_factor = state->growth_factor
+        };
+        infra_error_t err = memkv_store_create(&store_config, &state->store);
+        if (err != INFRA_OK) {
+            INFRA_LOG_ERROR("Failed to create memory store: %d", err);
+            return err;
+        }
+    }
+
+    // SQLite 文件库默认组提交: 打开写句柄并建表, 不使用连接池
+    if (db_group_commit_enabled(state) && !state->writer) {
+        infra_error_t err = db_writer_init(state);
+        if (err != INFRA_OK) {
+            INFRA_LOG_ERROR("Failed to initialize group commit writer: %d", err);
+            return err;
+        }
+    }
+
+    // 数据库引擎: 打开连接池并建表, 每个 reactor 同一时刻最多借用一个句柄; 组提交时连接池只用于读取
+    if (state->engine != MEMKV_ENGINE_MEMORY && !state->db_pool.mutex) {
+        int pool_size = reactor_configured_count(state);
+        // 内存库走 SQLite 共享缓存, 表级锁下多句柄并发写只会互相 SQLITE_LOCKED
+        if (state->engine == MEMKV_ENGINE_SQLITE && strcmp(state->db_path, ":memory:") == 0) {
+            pool_size = 1;
+        }
+        infra_error_t err = db_pool_init(state, pool_size);
+        if (err != INFRA_OK) {
+            INFRA_LOG_ERROR("Failed to initialize database pool: %d", err);
+            db_writer_destroy(state);
+            return err;
+        }
+    }
+
     // 添加监听器
     INFRA_LOG_INFO("Adding listener on %s:%d", state->host, state->port);
     
@@ -1006,19 +3782,40 @@ infra_error_t memkv_start(void) {
         return err;
     }
 
+    // 启动 reactor 线程
+    err = reactors_start(state);
+    if (err != INFRA_OK) {
+        INFRA_LOG_ERROR("Failed to start reactors: %d", err);
+        return err;
+    }
+
+    // 启动过期回收线程
+    err = crawler_start(state);
+    if (err != INFRA_OK) {
+        INFRA_LOG_ERROR("Failed to start expiry crawler: %d", err);
+        reactors_stop(state);
+        return err;
+    }
+
     // 设置处理器
     poly_poll_set_handler(state->ctx, handle_accept);
 
-    // 启动轮询
+    state->running = true;
+    state->start_time = time(NULL);
+    g_memkv_service.state = PEER_SERVICE_STATE_RUNNING;
+
+    // 启动轮询 (阻塞直到 memkv_stop)
     err = poly_poll_start(state->ctx);
     if (err != INFRA_OK) {
         INFRA_LOG_ERROR("Failed to start polling: %d", err);
+        state->running = false;
+        crawler_stop(state);
+        reactors_stop(state);
+        db_pool_destroy(state);
+        g_memkv_service.state = PEER_SERVICE_STATE_STOPPED;
         return err;
     }
 
-    state->running = true;
-    g_memkv_service.state = PEER_SERVICE_STATE_RUNNING;
-
     return INFRA_OK;
 }
 
@@ -1045,6 +3842,10 @@ infra_error_t memkv_stop(void) {
         state->ctx = NULL;
     }
 
+    crawler_stop(state);
+    reactors_stop(state);
+    db_pool_destroy(state);
+
     g_memkv_service.state = PEER_SERVICE_STATE_STOPPED;
     return INFRA_OK;
 }
@@ -1081,13 +3882,46 @@ infra_error_t memkv_cmd_handler(const char* cmd, char* response, size_t size) {
             case PEER_SERVICE_STATE_RUNNING: state_str = "running"; break;
             case PEER_SERVICE_STATE_STOPPED: state_str = "stopped"; break;
         }
+        size_t connections = 0;
+        if (state && state->reactors) {
+            for (int i = 0; i < state->reactor_count; i++) {
+                connections += state->reactors[i].conn_count;
+            }
+        }
+        poly_db_stmt_cache_stats_t stmt_stats = {0};
+        poly_db_writer_stats_t commit_stats = {0};
+        if (state) {
+            db_pool_stmt_stats(state, &stmt_stats);
+            if (state->writer) {
+                poly_db_writer_get_stats(state->writer, &commit_stats);
+            }
+        }
         snprintf(response, size, "MemKV Service Status:\n"
                 "State: %s\n"
                 "Port: %d\n"
-                "DB Path: %s\n",
+                "Engine: %s\n"
+                "DB Path: %s\n"
+                "DB Pool: %d/%d\n"
+                "Stmt Cache: %lu hits, %lu misses\n"
+                "Group Commit: %s, %lu commits, %lu writes, %lu failures\n"
+                "Reactors: %d\n"
+                "Shards: %d\n"
+                "Connections: %zu\n",
                 state_str,
                 state ? state->port : MEMKV_DEFAULT_PORT,
-                state && state->db_path ? state->db_path : "none");
+                state ? engine_name(state->engine) : "none",
+                state && state->db_path ? state->db_path : "none",
+                state ? state->db_pool.open_count : 0,
+                state ? state->db_pool.max_size : 0,
+                (unsigned long)stmt_stats.hits,
+                (unsigned long)stmt_stats.misses,
+                state && state->writer ? "on" : "off",
+                (unsigned long)commit_stats.commits,
+                (unsigned long)commit_stats.ops,
+                (unsigned long)commit_stats.failures,
+                state ? state->reactor_count : 0,
+                state && state->sharded ? state->shard_count : 1,
+                connections);
         return INFRA_OK;
     }
     else if (strcmp(argv[0], "start") == 0) {
@@ -1137,8 +3971,63 @@ infra_error_t memkv_apply_config(const poly_service_config_t* config) {
         state->db_path[sizeof(state->db_path) - 1] = '\0';
     }
 
-    INFRA_LOG_INFO("Applied configuration - host: %s, port: %d, db_path: %s",
-        state->host, state->port, state->db_path);
+    // 存储引擎
+    if (config->engine[0]) {
+        if (strcmp(config->engine, "memory") == 0) {
+            state->engine = MEMKV_ENGINE_MEMORY;
+        } else if (strcmp(config->engine, "sqlite") == 0) {
+            state->engine = MEMKV_ENGINE_SQLITE;
+        } else if (strcmp(config->engine, "duckdb") == 0) {
+            state->engine = MEMKV_ENGINE_DUCKDB;
+        } else {
+            INFRA_LOG_ERROR("Unknown storage engine: %s", config->engine);
+            return INFRA_ERROR_INVALID_PARAM;
+        }
+    }
+
+    // 内存上限和 slab 增长因子 (memory 引擎)
+    if (config->memory_mb > 0) {
+        state->max_memory = (size_t)config->memory_mb * 1024 * 1024;
+    }
+    if (config->growth_factor > 0) {
+        if (config->growth_factor < MEMKV_SLAB_MIN_FACTOR) {
+            INFRA_LOG_ERROR("Invalid slab growth factor: %.2f", config->growth_factor);
+            return INFRA_ERROR_INVALID_PARAM;
+        }
+        state->growth_factor = config->growth_factor;
+    }
+
+    // reactor 线程数和分片模式
+    if (config->threads > 0) {
+        if (config->threads > MEMKV_MAX_THREADS) {
+            INFRA_LOG_ERROR("Too many threads: %d (max %d)", config->threads, MEMKV_MAX_THREADS);
+            return INFRA_ERROR_INVALID_PARAM;
+        }
+        state->threads = config->threads;
+    }
+    if (config->sharded) {
+        if (state->engine != MEMKV_ENGINE_MEMORY) {
+            INFRA_LOG_ERROR("Sharded mode requires the memory engine");
+            return INFRA_ERROR_INVALID_PARAM;
+        }
+        state->sharded = true;
+    }
+    if (config->hotcache) {
+        if (state->engine != MEMKV_ENGINE_MEMORY) {
+            INFRA_LOG_ERROR("Hot key cache requires the memory engine");
+            return INFRA_ERROR_INVALID_PARAM;
+        }
+        state->hotcache = true;
+    }
+    if (config->commit_ms != 0) {
+        state->commit_ms = config->commit_ms;
+    }
+
+    INFRA_LOG_INFO("Applied configuration - host: %s, port: %d, engine: %s, db_path: %s, memory: %zuMB, "
+        "threads: %d, sharded: %s",
+        state->host, state->port, engine_name(state->engine), state->db_path,
+        state->max_memory / (1024 * 1024), reactor_configured_count(state),
+        state->sharded ? "yes" : "no");
 
     return INFRA_OK;
 }
@@ -1147,186 +4036,68 @@ peer_service_t* peer_memkv_get_service(void) {
     return &g_memkv_service;
 }
 
-static void handle_delete(memkv_conn_t* conn, const char* key, bool noreply) {
-    if (!conn || !conn->store || !key || conn->sock <= 0) {
-        INFRA_LOG_ERROR("Invalid parameters in handle_delete");
-        if (!noreply && conn && conn->sock > 0) {
-            infra_net_send(conn->sock, "CLIENT_ERROR bad command line format\r\n", 37, NULL);
+static void handle_delete(memkv_conn_t* conn, memkv_span_t key, bool noreply) {
+    if (!engine_ready(conn)) {
+        INFRA_LOG_ERROR("Storage not ready in handle_delete");
+        if (!noreply) {
+            conn_out_cstr(conn, "SERVER_ERROR\r\n");
         }
         return;
     }
 
-    // 检查 key 的长度
-    size_t key_len = strlen(key);
-    if (key_len == 0 || key_len > 250) {  // 250 是一个合理的限制
-        INFRA_LOG_ERROR("Invalid key length: %zu", key_len);
-        if (!noreply && conn->sock > 0) {
-            infra_net_send(conn->sock, "CLIENT_ERROR invalid key length\r\n", 31, NULL);
-        }
+    // key 长度已由解析器校验
+    infra_error_t err = engine_delete(conn, key.ptr, key.len, 0);
+    if (noreply) {
         return;
     }
-
-    infra_error_t err = kv_delete(conn->store, key);
     if (err == INFRA_OK) {
-        if (!noreply) {
-            err = send_all(conn->sock, "DELETED\r\n", 9);
-            if (err != INFRA_OK) {
-                INFRA_LOG_ERROR("Failed to send DELETED response: %d", err);
-                conn->should_close = true;
-            }
-        }
+        conn_out_cstr(conn, "DELETED\r\n");
     } else if (err == INFRA_ERROR_NOT_FOUND) {
-        if (!noreply) {
-            err = send_all(conn->sock, "NOT_FOUND\r\n", 11);
-            if (err != INFRA_OK) {
-                INFRA_LOG_ERROR("Failed to send NOT_FOUND response: %d", err);
-                conn->should_close = true;
-            }
-        }
+        conn_out_cstr(conn, "NOT_FOUND\r\n");
     } else {
-        if (!noreply) {
-            err = send_all(conn->sock, "SERVER_ERROR\r\n", 14);
-            if (err != INFRA_OK) {
-                INFRA_LOG_ERROR("Failed to send SERVER_ERROR response: %d", err);
-                conn->should_close = true;
-            }
-        }
+        conn_out_cstr(conn, "SERVER_ERROR\r\n");
     }
 }
 
 static void handle_flush(memkv_conn_t* conn, bool noreply) {
-    if (!conn || !conn->store || conn->sock <= 0) {
-        INFRA_LOG_ERROR("Invalid parameters in handle_flush");
-        if (!noreply && conn && conn->sock > 0) {
-            infra_net_send(conn->sock, "CLIENT_ERROR bad command line format\r\n", 37, NULL);
+    if (!engine_ready(conn)) {
+        INFRA_LOG_ERROR("Storage not ready in handle_flush");
+        if (!noreply) {
+            conn_out_cstr(conn, "SERVER_ERROR\r\n");
         }
         return;
     }
 
-    infra_error_t err = kv_flush(conn->store);
+    infra_error_t err = engine_flush(conn);
     if (!noreply) {
-        if (err == INFRA_OK) {
-            err = send_all(conn->sock, "OK\r\n", 4);
-            if (err != INFRA_OK) {
-                INFRA_LOG_ERROR("Failed to send OK response: %d", err);
-                conn->should_close = true;
-            }
-        } else {
-            err = send_all(conn->sock, "SERVER_ERROR\r\n", 14);
-            if (err != INFRA_OK) {
-                INFRA_LOG_ERROR("Failed to send SERVER_ERROR response: %d", err);
-                conn->should_close = true;
-            }
-        }
+        conn_out_cstr(conn, err == INFRA_OK ? "OK\r\n" : "SERVER_ERROR\r\n");
     }
 }
 
-static void handle_incr_decr(memkv_conn_t* conn, const char* key, const char* value_str, bool is_incr) {
-    if (!conn || !conn->store || !key || !value_str || conn->sock <= 0) {
-        INFRA_LOG_ERROR("Invalid parameters in handle_incr_decr");
-        infra_net_send(conn->sock, "CLIENT_ERROR bad command line format\r\n", 37, NULL);
+static void handle_incr_decr(memkv_conn_t* conn, memkv_span_t key, uint64_t delta, bool is_incr) {
+    if (!engine_ready(conn)) {
+        INFRA_LOG_ERROR("Storage not ready in handle_incr_decr");
+        conn_out_cstr(conn, "SERVER_ERROR\r\n");
         return;
     }
 
-    INFRA_LOG_DEBUG("Handling %s command for key='%s', value='%s'", 
-                    is_incr ? "INCR" : "DECR", key, value_str);
-           
-    uint64_t delta = strtoull(value_str, NULL, 10);
-    struct kv_pair pair;
-    infra_error_t err = kv_get(conn->store, key, &pair);
-    if (err != INFRA_OK || !pair.value) {
-        if (is_incr) {
-            // 对于INCR，如果key不存在，初始化为0
-            char zero_str[] = "0";
-            err = kv_set(conn->store, key, zero_str, strlen(zero_str), 0, 0);
-            if (err == INFRA_OK) {
-                err = send_all(conn->sock, "0\r\n", 3);
-                if (err != INFRA_OK) {
-                    INFRA_LOG_ERROR("Failed to send initial value response: %d", err);
-                    conn->should_close = true;
-                }
-            } else {
-                INFRA_LOG_ERROR("Failed to set initial value: %d", err);
-                err = send_all(conn->sock, "ERROR\r\n", 7);
-                if (err != INFRA_OK) {
-                    INFRA_LOG_ERROR("Failed to send ERROR response: %d", err);
-                    conn->should_close = true;
-                }
-            }
-        } else {
-            err = send_all(conn->sock, "NOT_FOUND\r\n", 11);
-            if (err != INFRA_OK) {
-                INFRA_LOG_ERROR("Failed to send NOT_FOUND response: %d", err);
-                conn->should_close = true;
-            }
-        }
-        return;
-    }
+    INFRA_LOG_DEBUG("Handling %s command for key='%.*s', delta=%lu", 
+                    is_incr ? "INCR" : "DECR", (int)key.len, key.ptr, (unsigned long)delta);
 
-    // 确保old_value是以null结尾的字符串
-    char* null_term_value = malloc(pair.value_len + 1);
-    if (!null_term_value) {
-        free(pair.value);
-        err = send_all(conn->sock, "SERVER_ERROR out of memory\r\n", 26);
-        if (err != INFRA_OK) {
-            INFRA_LOG_ERROR("Failed to send error response: %d", err);
-            conn->should_close = true;
-        }
-        return;
-    }
-    memcpy(null_term_value, pair.value, pair.value_len);
-    null_term_value[pair.value_len] = '\0';
-    
-    uint64_t current = strtoull(null_term_value, NULL, 10);
-    free(pair.value);
-    free(null_term_value);
-    
-    if (is_incr) {
-        current += delta;
-    } else {
-        if (current < delta) {
-            current = 0;
-        } else {
-            current -= delta;
-        }
-    }
-    
-    char new_value[32];
-    int new_value_len = snprintf(new_value, sizeof(new_value), "%lu", current);
-    if (new_value_len < 0 || (size_t)new_value_len >= sizeof(new_value)) {
-        INFRA_LOG_ERROR("Failed to format new value");
-        err = send_all(conn->sock, "SERVER_ERROR value too large\r\n", 28);
-        if (err != INFRA_OK) {
-            INFRA_LOG_ERROR("Failed to send error response: %d", err);
-            conn->should_close = true;
-        }
-        return;
-    }
-    
-    err = kv_set(conn->store, key, new_value, new_value_len, pair.flags, 0);
+    // 对于INCR，如果key不存在，初始化为0
+    uint64_t value = 0;
+    infra_error_t err = engine_incr_decr(conn, key.ptr, key.len, delta, is_incr, is_incr, 0, 0, &value);
     if (err == INFRA_OK) {
-        char response[32];
-        int response_len = snprintf(response, sizeof(response), "%lu\r\n", current);
-        if (response_len < 0 || (size_t)response_len >= sizeof(response)) {
-            INFRA_LOG_ERROR("Failed to format response");
-            err = send_all(conn->sock, "SERVER_ERROR response too large\r\n", 30);
-            if (err != INFRA_OK) {
-                INFRA_LOG_ERROR("Failed to send error response: %d", err);
-                conn->should_close = true;
-            }
-            return;
-        }
-        err = send_all(conn->sock, response, response_len);
-        if (err != INFRA_OK) {
-            INFRA_LOG_ERROR("Failed to send response: %d", err);
-            conn->should_close = true;
-        }
+        conn_out_printf(conn, "%lu\r\n", (unsigned long)value);
+    } else if (err == INFRA_ERROR_NOT_FOUND) {
+        conn_out_cstr(conn, "NOT_FOUND\r\n");
+    } else if (err == INFRA_ERROR_INVALID_PARAM) {
+        conn_out_cstr(conn, "CLIENT_ERROR cannot increment or decrement non-numeric value\r\n");
     } else {
-        err = send_all(conn->sock, "ERROR\r\n", 7);
-        if (err != INFRA_OK) {
-            INFRA_LOG_ERROR("Failed to send ERROR response: %d", err);
-            conn->should_close = true;
+        if (err != INFRA_ERROR_WOULD_BLOCK) {
+            INFRA_LOG_ERROR("Failed to update counter: %d", err);
         }
+        conn_out_cstr(conn, "ERROR\r\n");
     }
 }
 
@@ -1335,11 +4106,8 @@ static void memkv_conn_destroy(memkv_conn_t* conn) {
         return;
     }
 
-    // 关闭数据库连接
-    if (conn->store) {
-        poly_db_close(conn->store);
-        conn->store = NULL;
-    }
+    // 数据库句柄属于连接池, 这里只解除引用
+    conn->store = NULL;
 
     // 关闭套接字
     if (conn->sock > 0) {
@@ -1347,17 +4115,34 @@ static void memkv_conn_destroy(memkv_conn_t* conn) {
         conn->sock = 0;
     }
 
-    // 释放接收缓冲区
+    // 释放接收缓冲区和未收完的流式 item
     if (conn->rx_buf) {
         infra_free(conn->rx_buf);
         conn->rx_buf = NULL;
     }
+    if (conn->stream.item) {
+        memkv_item_release(conn->stream.item);
+        conn->stream.item = NULL;
+    }
+    shard_calls_clear(conn);
+
+    // 释放输出队列 (归还被引用的 item)
+    conn_out_reset(conn);
+    if (conn->out) {
+        infra_free(conn->out);
+        conn->out = NULL;
+    }
+    if (conn->out_buf) {
+        infra_free(conn->out_buf);
+        conn->out_buf = NULL;
+    }
 
     // 清空客户端地址
     memset(conn->client_addr, 0, sizeof(conn->client_addr));
 
     // 重置其他字段
     conn->rx_len = 0;
+    conn->rx_cap = 0;
     conn->should_close = false;
     conn->is_closing = false;
     conn->is_initialized = false;
@@ -1389,10 +4174,11 @@ static memkv_conn_t* memkv_conn_create(infra_socket_t sock) {
     memset(conn, 0, sizeof(memkv_conn_t));
 
     // 分配接收缓冲区
-    conn->rx_buf = (char*)infra_malloc(MEMKV_CONN_BUFFER_SIZE);
+    conn->rx_buf = (char*)infra_malloc(MEMKV_CONN_RX_INIT);
+    conn->rx_cap = MEMKV_CONN_RX_INIT;
     if (!conn->rx_buf) {
         INFRA_LOG_ERROR("Failed to allocate receive buffer");
-        free(conn);
+        infra_free(conn);
         return NULL;
     }
 
@@ -1415,16 +4201,47 @@ static memkv_conn_t* memkv_conn_create(infra_socket_t sock) {
     conn->failed_commands = 0;
     conn->rx_len = 0;
     conn->last_active_time = time(NULL);
-    
-    // 设置数据库路径
-    strncpy(conn->store_path, state->db_path, sizeof(conn->store_path) - 1);
-    conn->store_path[sizeof(conn->store_path) - 1] = '\0';
+
+    // 缓冲的单条请求 (命令行 + 数据块) 必须能放进接收缓冲区, 大数据块流式接收
+    memkv_parser_init(&conn->parser, MEMKV_CONN_RX_MAX - MEMKV_PROTO_MAX_LINE - 2);
+    memkv_parser_set_stream(&conn->parser, MEMKV_STREAM_MIN, MEMKV_MAX_DATA_SIZE);
 
     // 设置 TCP_NODELAY
     if (setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &(int){1}, sizeof(int)) < 0) {
         INFRA_LOG_WARN("Failed to set TCP_NODELAY");
     }
 
+    // 设置 TCP keepalive 参数
+    if (setsockopt(sock, SOL_SOCKET, SO_KEEPALIVE, &(int){1}, sizeof(int)) < 0) {
+        INFRA_LOG_WARN("Failed to set SO_KEEPALIVE");
+    }
+
+    #ifdef TCP_KEEPIDLE
+    if (setsockopt(sock, IPPROTO_TCP, TCP_KEEPIDLE, &(int){120}, sizeof(int)) < 0) {
+        INFRA_LOG_WARN("Failed to set TCP_KEEPIDLE");
+    }
+    #endif
+
+    #ifdef TCP_KEEPINTVL
+    if (setsockopt(sock, IPPROTO_TCP, TCP_KEEPINTVL, &(int){30}, sizeof(int)) < 0) {
+        INFRA_LOG_WARN("Failed to set TCP_KEEPINTVL");
+    }
+    #endif
+
+    #ifdef TCP_KEEPCNT
+    if (setsockopt(sock, IPPROTO_TCP, TCP_KEEPCNT, &(int){3}, sizeof(int)) < 0) {
+        INFRA_LOG_WARN("Failed to set TCP_KEEPCNT");
+    }
+    #endif
+
+    // 设置非阻塞模式
+    if (infra_net_set_nonblock(sock, true) != INFRA_OK) {
+        INFRA_LOG_ERROR("Failed to set non-blocking mode");
+        conn->sock = 0;
+        memkv_conn_destroy(conn);
+        return NULL;
+    }
+
     return conn;
 }
 
@@ -1436,11 +4253,18 @@ static void handle_accept(void* args) {
     }
 
     infra_socket_t client = handler_args->client;
+    infra_free(handler_args);
     if (client <= 0) {
         INFRA_LOG_ERROR("Invalid client socket");
         return;
     }
 
+    memkv_state_t* state = get_state();
+    if (!state || !state->running) {
+        infra_net_close(client);
+        return;
+    }
+
     // 创建新的连接状态
     memkv_conn_t* conn = memkv_conn_create(client);
     if (!conn) {
@@ -1449,9 +4273,10 @@ static void handle_accept(void* args) {
         return;
     }
 
-    // 更新处理器参数
-    handler_args->user_data = conn;
-    
-    // 处理连接
-    handle_connection(args);
+    // 交给 reactor 线程处理, 本线程立即返回
+    infra_error_t err = reactor_dispatch(state, conn);
+    if (err != INFRA_OK) {
+        INFRA_LOG_ERROR("Failed to dispatch connection: %d", err);
+        memkv_conn_destroy(conn);
+    }
 }
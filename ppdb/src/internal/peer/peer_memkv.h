@@ -7,9 +7,73 @@
 #include "internal/infra/infra_error.h"
 #include "internal/poly/poly_db.h"
 #include "internal/poly/poly_poll.h"
+#include "internal/peer/peer_memkv_store.h"
+#include "internal/peer/peer_memkv_proto.h"
+#include "internal/peer/peer_memkv_hotkeys.h"
 
-// 增加缓冲区大小到 2MB
-#define MEMKV_CONN_BUFFER_SIZE (2 * 1024 * 1024)
+// 接收缓冲区初始大小, 放不下一条请求时成倍扩大, 处理完积压后收缩回来
+#define MEMKV_CONN_RX_INIT (16 * 1024)
+// 接收缓冲区上限: 命令行和不流式接收的数据块 (二进制协议) 都要能放下
+#define MEMKV_CONN_RX_MAX (2 * 1024 * 1024)
+// 文本协议中不小于该长度的数据块不经接收缓冲区, 直接读入 item
+#define MEMKV_STREAM_MIN (64 * 1024)
+// 流式接收的 value 上限
+#define MEMKV_MAX_DATA_SIZE (32 * 1024 * 1024)
+
+// 空闲连接超时(秒)
+#define MEMKV_CONN_IDLE_TIMEOUT 300
+
+// 数据库连接池上限 (SQLite/DuckDB 引擎)
+#define MEMKV_DB_POOL_MAX 8
+
+// SQLite 组提交: 写入最多攒多少毫秒或多少条后提交一次
+#define MEMKV_COMMIT_DELAY_MS 2
+#define MEMKV_COMMIT_MAX_OPS 1024
+
+// 输出队列: 一次 writev 最多的 iovec 数
+#define MEMKV_OUT_MAX_IOV 64
+// 小于该长度的 value 直接拷入输出缓冲区, 与响应头合并成一段
+#define MEMKV_OUT_COPY_THRESHOLD 512
+// 待发送数据超过该值时暂停解析, 等客户端读走
+#define MEMKV_OUT_HIGH_WATER (4 * 1024 * 1024)
+
+// 后台过期回收: 每个周期的间隔和最多占用的时间 (毫秒)
+#define MEMKV_CRAWLER_INTERVAL_MS 100
+#define MEMKV_CRAWLER_BUDGET_MS 2
+// 数据库引擎每条 DELETE 最多删除的行数
+#define MEMKV_CRAWLER_DB_BATCH 256
+
+// 多 key get 每批最多扇出的 key 数, 更多的 key 分批处理
+#define MEMKV_SHARD_GET_BATCH 128
+
+struct memkv_reactor;
+struct memkv_shard_msg;
+struct memkv_shard_call;
+
+// 输出队列中的一段数据
+typedef struct memkv_out_entry {
+    const char* data;            // 外部数据 (item value), NULL 表示位于 out_buf
+    size_t offset;               // 位于 out_buf 时的偏移
+    size_t len;
+    memkv_item_t* item;          // 持有的 item 引用, 发送完后释放
+} memkv_out_entry_t;
+
+// 存储引擎
+typedef enum {
+    MEMKV_ENGINE_MEMORY = 0,     // 原生内存哈希表 (默认)
+    MEMKV_ENGINE_SQLITE,         // poly_db SQLite
+    MEMKV_ENGINE_DUCKDB          // poly_db DuckDB
+} memkv_engine_t;
+
+// 流式接收中的存储命令: 数据块直接读入 item 的 value, 到齐后执行
+typedef struct memkv_stream {
+    memkv_item_t* item;          // 目标 item, NULL 表示没有流式接收中的命令
+    memkv_request_t req;         // 命令行解析结果, key 和 O 标志改指向下面的副本
+    size_t filled;               // value 已收到的字节数
+    char tail[2];                // 数据块后应为 \r\n
+    size_t tail_len;
+    char opaque[MEMKV_META_MAX_OPAQUE];
+} memkv_stream_t;
 
 // 连接状态结构
 typedef struct memkv_conn {
@@ -17,30 +81,145 @@ typedef struct memkv_conn {
     char client_addr[256];        // 客户端地址
     char* rx_buf;                 // 接收缓冲区
     size_t rx_len;               // 接收缓冲区中的数据长度
+    size_t rx_cap;               // 接收缓冲区大小
+    memkv_stream_t stream;       // 流式接收中的大数据块
     bool should_close;           // 是否应该关闭连接
-    bool is_closing;             // 是否正在关闭
+    bool is_closing;             // 已关闭但还有分片请求在途, 回复到齐后释放
     bool is_initialized;         // 是否已初始化
     time_t last_active_time;     // 最后活动时间
     uint32_t total_commands;     // 总命令数
     uint32_t failed_commands;    // 失败命令数
-    poly_db_t* store;            // 数据库连接
-    char store_path[1024];       // 数据库路径
-    
-    // SET 命令相关
-    char set_key[256];           // SET 命令的键
-    uint32_t set_flags;          // SET 命令的标志
-    uint32_t set_exptime;        // SET 命令的过期时间
-    size_t set_bytes;            // SET 命令的数据长度
-    bool set_noreply;            // SET 命令是否不需要回复
+    poly_db_t* store;            // 本批请求借用的数据库连接 (SQLite/DuckDB 引擎)
+    memkv_parser_t parser;       // 协议解析状态
+
+    // 输出队列, 每轮解析结束后用 writev 一次发出, 发不完时等待可写
+    memkv_out_entry_t* out;
+    size_t out_head;             // 第一段未发完的数据
+    size_t out_count;
+    size_t out_cap;
+    size_t out_sent;             // 第一段已发送的字节数
+    size_t out_pending;          // 待发送字节总数
+    char* out_buf;               // 响应头等小块数据
+    size_t out_buf_len;
+    size_t out_buf_cap;
+    bool want_write;             // 已注册可写事件, 暂停读取
+
+    // 组提交: 响应依赖的事务编号范围, 事务提交前不发送
+    uint64_t commit_first;
+    uint64_t commit_last;
+    bool held;                   // 在 reactor 的 held 链表中
+    struct memkv_conn* held_next;
+    bool parked;                 // 连接池句柄用尽, 暂停读取, 在 reactor 的 parked 链表中
+    struct memkv_conn* parked_next;
+
+    // 分片模式: 命令调用其他分片时投递请求后暂停, 不再读取; 回复到齐后从 rx_head
+    // 重新执行该命令, 已完成的调用从记录中取回结果
+    struct memkv_shard_call* calls; // 当前命令投递过的调用
+    int call_pending;            // 尚未回复的调用数
+    size_t rx_head;              // 暂停的命令在 rx_buf 中的位置, 命令完成前不移动 rx_buf
+    bool shard_ready;            // 回复已到齐, 在 reactor 的 ready 链表中
+    struct memkv_conn* ready_next;
+    int poll_events;             // 当前关注的事件
+
+    // 事件循环相关
+    struct memkv_reactor* reactor; // 所属的 reactor 线程
+    struct memkv_conn* prev;     // reactor 连接链表 (按最近活跃排序)
+    struct memkv_conn* next;
 } memkv_conn_t;
 
+// 命令统计, 每个 reactor 一份, 只由所属线程更新, stats 命令汇总 (字段全为 uint64_t)
+typedef struct memkv_stats {
+    uint64_t total_connections;
+    uint64_t cmd_get;
+    uint64_t cmd_set;
+    uint64_t cmd_flush;
+    uint64_t cmd_touch;
+    uint64_t get_hits;
+    uint64_t get_misses;
+    uint64_t delete_hits;
+    uint64_t delete_misses;
+    uint64_t incr_hits;
+    uint64_t incr_misses;
+    uint64_t decr_hits;
+    uint64_t decr_misses;
+    uint64_t cas_hits;
+    uint64_t cas_misses;
+    uint64_t cas_badval;
+    uint64_t touch_hits;
+    uint64_t touch_misses;
+    uint64_t hotcache_hits;      // 由副本缓存直接返回的 get
+} memkv_stats_t;
+
+// reactor 线程: 每个线程通过事件循环管理多个非阻塞连接
+typedef struct memkv_reactor {
+    int id;                      // 线程编号
+    infra_thread_t thread;       // 线程句柄
+    poly_poll_loop_t* loop;      // 事件循环
+    volatile bool running;       // 运行标志
+    infra_mutex_t pending_mutex; // 保护 pending 队列
+    memkv_conn_t* pending;       // accept 线程投递的新连接
+    memkv_conn_t* conn_head;     // 最近活跃的连接
+    memkv_conn_t* conn_tail;     // 最久未活跃的连接
+    size_t conn_count;           // 连接数
+    memkv_conn_t* held;          // 等待组提交的连接
+    memkv_conn_t* parked;        // 等待数据库句柄的连接
+    memkv_conn_t* ready;         // 分片回复已到齐, 等待重新执行的连接
+    memkv_stats_t stats;         // 本线程的命令统计
+    memkv_store_t* shard;        // 独占的分片 (shard-per-reactor 模式), 否则为 NULL
+    struct memkv_shard_msg* mailbox; // 其他 reactor 投递的请求及投回的回复 (无锁栈, 原子操作)
+    memkv_hotkeys_t* hotkeys;    // 本线程 get 的热点统计
+    memkv_hotcache_t* hotcache;  // 热点 key 的副本缓存, 未启用时为 NULL
+} memkv_reactor_t;
+
+// 数据库连接池: 服务内共享, 按需打开, reactor 每批请求借用一个句柄, 从不阻塞等待
+typedef struct memkv_db_pool {
+    poly_db_t* handles[MEMKV_DB_POOL_MAX];  // 所有已打开的句柄
+    poly_db_t* idle[MEMKV_DB_POOL_MAX];     // 空闲句柄栈
+    int open_count;              // 已打开 (含正在打开) 的句柄数
+    int idle_count;              // 空闲句柄数
+    int max_size;                // 句柄上限
+    bool exhausted;              // 有 reactor 因句柄用尽暂停了连接, 归还时唤醒
+    infra_mutex_t mutex;
+} memkv_db_pool_t;
+
 // 服务状态结构
 typedef struct memkv_state {
     bool running;                // 是否正在运行
     char host[256];             // 监听地址
     uint16_t port;              // 监听端口
     char db_path[1024];         // 数据库路径
+    memkv_engine_t engine;      // 存储引擎
+    memkv_store_t* store;       // 原生内存存储 (MEMKV_ENGINE_MEMORY)
+    size_t max_memory;          // 原生存储的 item 内存上限 (字节)
+    double growth_factor;       // slab 增长因子, 0 使用默认值
+    memkv_db_pool_t db_pool;    // 数据库连接池 (SQLite/DuckDB 引擎)
+    poly_db_t* writer_db;       // 组提交的写句柄 (SQLite 文件), 写入都经它执行, 读取仍用连接池
+    poly_db_writer_t* writer;
+    int commit_ms;              // 组提交间隔, 0 使用默认值, <0 关闭
+    uint64_t db_next_cas;       // SQLite/DuckDB 引擎的 CAS 计数器 (原子操作)
+    time_t start_time;          // 启动时间
     void* ctx;                  // 轮询上下文
+    memkv_reactor_t* reactors;  // reactor 线程数组
+    int reactor_count;          // reactor 线程数
+    uint32_t next_reactor;      // 下一个分配连接的 reactor
+    int reactors_started;       // 已启动的 reactor 线程数
+    int reactors_exited;        // 已退出事件循环的 reactor 数 (原子操作)
+    int threads;                // 配置的 reactor 线程数, 0 按 CPU 数
+    bool hotcache;              // 为热点 key 启用线程本地副本缓存 (memory 引擎)
+
+    // shard-per-reactor 模式 (memory 引擎): keyspace 按哈希分给各 reactor,
+    // 每个分片只由属主线程读写, 其他 reactor 经 mailbox 把请求交给属主执行
+    bool sharded;
+    memkv_store_t** shards;     // 各分片的 store, 下标即属主 reactor 编号
+    int shard_count;
+    int shard_inflight;         // 已投递未处理回复的调用数 (原子操作), 退出时等其归零
+
+    // 后台过期回收线程
+    infra_thread_t crawler;
+    volatile bool crawler_running;
+    infra_mutex_t crawler_mutex;
+    infra_cond_t crawler_cond;  // 停止时唤醒
+    uint64_t db_crawler_reclaimed; // 数据库引擎回收的过期行数
 } memkv_state_t;
 
 // Service interface functions
@@ -0,0 +1,244 @@
+#include "internal/infra/infra_core.h"
+#include "internal/infra/infra_sync.h"
+#include "internal/peer/peer_memkv_hotkeys.h"
+
+//-----------------------------------------------------------------------------
+// Types
+//-----------------------------------------------------------------------------
+
+typedef struct memkv_hotkeys_slot {
+    uint64_t hash;
+    uint64_t count;              // 采样次数
+    uint64_t error;              // 顶替时继承的计数
+    uint16_t nkey;
+    char key[MEMKV_STORE_MAX_KEY_LEN];
+} memkv_hotkeys_slot_t;
+
+struct memkv_hotkeys {
+    infra_mutex_t mutex;         // 记录/减半与 stats 读取互斥, 只在采样时加锁
+    uint32_t sample_rate;
+    uint32_t countdown;          // 距下一次采样的访问数
+    uint64_t rng;
+    int used;
+    memkv_hotkeys_slot_t slots[MEMKV_HOTKEYS_TRACKED];
+};
+
+// 直接映射, 按 item 的哈希选槽
+struct memkv_hotcache {
+    memkv_item_t* slots[MEMKV_HOTCACHE_SLOTS];
+};
+
+//-----------------------------------------------------------------------------
+// Hot Key Tracker
+//-----------------------------------------------------------------------------
+
+static uint32_t hotkeys_next_gap(memkv_hotkeys_t* hk) {
+    // xorshift64, 采样间隔在 [1, 2 * rate - 1] 内均匀分布, 避免与访问模式同步
+    hk->rng ^= hk->rng << 13;
+    hk->rng ^= hk->rng >> 7;
+    hk->rng ^= hk->rng << 17;
+    if (hk->sample_rate <= 1) {
+        return 1;
+    }
+    return 1 + (uint32_t)(hk->rng % (2 * hk->sample_rate - 1));
+}
+
+infra_error_t memkv_hotkeys_create(uint32_t sample_rate, memkv_hotkeys_t** hotkeys) {
+    if (!hotkeys) {
+        return INFRA_ERROR_INVALID_PARAM;
+    }
+
+    memkv_hotkeys_t* hk = infra_malloc(sizeof(memkv_hotkeys_t));
+    if (!hk) {
+        return INFRA_ERROR_NO_MEMORY;
+    }
+    memset(hk, 0, sizeof(memkv_hotkeys_t));
+    if (infra_mutex_create(&hk->mutex) != INFRA_OK) {
+        infra_free(hk);
+        return INFRA_ERROR_NO_MEMORY;
+    }
+    hk->sample_rate = sample_rate > 0 ? sample_rate : MEMKV_HOTKEYS_SAMPLE_RATE;
+    hk->rng = 0x9e3779b97f4a7c15ULL ^ (uint64_t)(uintptr_t)hk;
+    hk->countdown = hotkeys_next_gap(hk);
+    *hotkeys = hk;
+    return INFRA_OK;
+}
+
+void memkv_hotkeys_destroy(memkv_hotkeys_t* hotkeys) {
+    if (!hotkeys) {
+        return;
+    }
+    infra_mutex_destroy(hotkeys->mutex);
+    infra_free(hotkeys);
+}
+
+bool memkv_hotkeys_sample(memkv_hotkeys_t* hotkeys) {
+    if (--hotkeys->countdown > 0) {
+        return false;
+    }
+    hotkeys->countdown = hotkeys_next_gap(hotkeys);
+    return true;
+}
+
+bool memkv_hotkeys_record(memkv_hotkeys_t* hotkeys, const char* key, size_t nkey, uint64_t hash) {
+    if (nkey == 0 || nkey > MEMKV_STORE_MAX_KEY_LEN) {
+        return false;
+    }
+
+    infra_mutex_lock(hotkeys->mutex);
+    memkv_hotkeys_slot_t* slot = NULL;
+    memkv_hotkeys_slot_t* min = NULL;
+    for (int i = 0; i < hotkeys->used; i++) {
+        memkv_hotkeys_slot_t* s = &hotkeys->slots[i];
+        if (s->hash == hash && s->nkey == nkey && memcmp(s->key, key, nkey) == 0) {
+            slot = s;
+            break;
+        }
+        if (!min || s->count < min->count) {
+            min = s;
+        }
+    }
+
+    if (!slot) {
+        if (hotkeys->used < MEMKV_HOTKEYS_TRACKED) {
+            slot = &hotkeys->slots[hotkeys->used++];
+            slot->count = 0;
+            slot->error = 0;
+        } else {
+            // 顶替计数最小的 key, 新 key 的真实计数不超过被顶替者
+            slot = min;
+            slot->error = slot->count;
+        }
+        slot->hash = hash;
+        slot->nkey = (uint16_t)nkey;
+        memcpy(slot->key, key, nkey);
+    }
+    slot->count++;
+
+    bool hot = (slot->count - slot->error) * hotkeys->sample_rate >= MEMKV_HOTKEYS_HOT_GETS;
+    infra_mutex_unlock(hotkeys->mutex);
+    return hot;
+}
+
+void memkv_hotkeys_decay(memkv_hotkeys_t* hotkeys) {
+    infra_mutex_lock(hotkeys->mutex);
+    int used = 0;
+    for (int i = 0; i < hotkeys->used; i++) {
+        memkv_hotkeys_slot_t* s = &hotkeys->slots[i];
+        s->count /= 2;
+        s->error /= 2;
+        // 不再被访问的 key 让出计数器
+        if (s->count > 0) {
+            if (used != i) {
+                hotkeys->slots[used] = *s;
+            }
+            used++;
+        }
+    }
+    hotkeys->used = used;
+    infra_mutex_unlock(hotkeys->mutex);
+}
+
+int memkv_hotkeys_top(memkv_hotkeys_t* hotkeys, memkv_hotkey_t* out, int max) {
+    if (!hotkeys || !out || max <= 0) {
+        return 0;
+    }
+
+    infra_mutex_lock(hotkeys->mutex);
+    int n = 0;
+    for (int i = 0; i < hotkeys->used; i++) {
+        const memkv_hotkeys_slot_t* s = &hotkeys->slots[i];
+        memkv_hotkey_t hot;
+        hot.nkey = s->nkey;
+        memcpy(hot.key, s->key, s->nkey);
+        hot.count = s->count * hotkeys->sample_rate;
+        hot.error = s->error * hotkeys->sample_rate;
+
+        // 插入排序, 计数器不多; 已满时挤掉最小的
+        if (n == max && out[n - 1].count >= hot.count) {
+            continue;
+        }
+        int j = n < max ? n++ : max - 1;
+        while (j > 0 && out[j - 1].count < hot.count) {
+            out[j] = out[j - 1];
+            j--;
+        }
+        out[j] = hot;
+    }
+    infra_mutex_unlock(hotkeys->mutex);
+    return n;
+}
+
+//-----------------------------------------------------------------------------
+// Replica Cache
+//-----------------------------------------------------------------------------
+
+infra_error_t memkv_hotcache_create(memkv_hotcache_t** cache) {
+    if (!cache) {
+        return INFRA_ERROR_INVALID_PARAM;
+    }
+
+    memkv_hotcache_t* c = infra_malloc(sizeof(memkv_hotcache_t));
+    if (!c) {
+        return INFRA_ERROR_NO_MEMORY;
+    }
+    memset(c, 0, sizeof(memkv_hotcache_t));
+    *cache = c;
+    return INFRA_OK;
+}
+
+void memkv_hotcache_destroy(memkv_hotcache_t* cache) {
+    if (!cache) {
+        return;
+    }
+    for (int i = 0; i < MEMKV_HOTCACHE_SLOTS; i++) {
+        if (cache->slots[i]) {
+            memkv_item_release(cache->slots[i]);
+        }
+    }
+    infra_free(cache);
+}
+
+bool memkv_hotcache_get(memkv_hotcache_t* cache, const char* key, size_t nkey, uint64_t hash,
+                        memkv_item_t** item) {
+    size_t i = hash & (MEMKV_HOTCACHE_SLOTS - 1);
+    memkv_item_t* it = cache->slots[i];
+    if (!it || it->hash != hash || it->nkey != nkey ||
+        memcmp(MEMKV_ITEM_KEY(it), key, nkey) != 0) {
+        return false;
+    }
+
+    // 已被替换、删除或过期的副本就地丢弃
+    if (!memkv_item_live(it, (int64_t)time(NULL))) {
+        cache->slots[i] = NULL;
+        memkv_item_release(it);
+        return false;
+    }
+
+    memkv_item_ref(it);
+    *item = it;
+    return true;
+}
+
+void memkv_hotcache_put(memkv_hotcache_t* cache, memkv_item_t* item) {
+    size_t i = item->hash & (MEMKV_HOTCACHE_SLOTS - 1);
+    if (cache->slots[i] == item) {
+        return;
+    }
+    memkv_item_ref(item);
+    if (cache->slots[i]) {
+        memkv_item_release(cache->slots[i]);
+    }
+    cache->slots[i] = item;
+}
+
+void memkv_hotcache_sweep(memkv_hotcache_t* cache) {
+    int64_t now = (int64_t)time(NULL);
+    for (int i = 0; i < MEMKV_HOTCACHE_SLOTS; i++) {
+        memkv_item_t* it = cache->slots[i];
+        if (it && !memkv_item_live(it, now)) {
+            cache->slots[i] = NULL;
+            memkv_item_release(it);
+        }
+    }
+}
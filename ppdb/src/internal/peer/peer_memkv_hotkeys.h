@@ -0,0 +1,69 @@
+#ifndef PEER_MEMKV_HOTKEYS_H_
+#define PEER_MEMKV_HOTKEYS_H_
+
+#include "internal/infra/infra_core.h"
+#include "internal/infra/infra_error.h"
+#include "internal/peer/peer_memkv_store.h"
+
+//-----------------------------------------------------------------------------
+// MemKV 热点 key 检测和线程本地副本缓存
+//
+// 每个 reactor 一个跟踪器, 对 get 随机采样, 用 space-saving 算法维护访问最多的
+// key: 固定数量的计数器, 未跟踪的 key 顶替计数最小的一个并继承其计数作为误差.
+// 计数定期减半, 反映的是近期的访问频率.
+// 副本缓存同样每个 reactor 一份, 只收录检测出的热点 key, 命中时不访问 store,
+// 避免各线程争用同一个桶和段锁. 缓存持有 item 的引用, item 被替换、删除、淘汰
+// 或过期后即失效, 写入不需要通知各线程.
+//-----------------------------------------------------------------------------
+
+// 每个跟踪器的计数器数
+#define MEMKV_HOTKEYS_TRACKED 64
+// 平均每多少次 get 采样一次
+#define MEMKV_HOTKEYS_SAMPLE_RATE 16
+// 估计访问次数 (扣除误差) 达到该值的 key 视为热点, 计数每秒减半
+#define MEMKV_HOTKEYS_HOT_GETS 1000
+// 每个副本缓存的槽数 (2 的幂)
+#define MEMKV_HOTCACHE_SLOTS 64
+
+typedef struct memkv_hotkeys memkv_hotkeys_t;
+typedef struct memkv_hotcache memkv_hotcache_t;
+
+// 单个热点 key 的统计
+typedef struct memkv_hotkey {
+    char key[MEMKV_STORE_MAX_KEY_LEN];
+    uint16_t nkey;
+    uint64_t count;              // 估计访问次数 (已按采样率放大)
+    uint64_t error;              // 高估的上限
+} memkv_hotkey_t;
+
+// 跟踪器: 只由所属 reactor 记录, stats 可从其他线程读取
+infra_error_t memkv_hotkeys_create(uint32_t sample_rate, memkv_hotkeys_t** hotkeys);
+void memkv_hotkeys_destroy(memkv_hotkeys_t* hotkeys);
+
+// 本次访问是否采样, 不加锁
+bool memkv_hotkeys_sample(memkv_hotkeys_t* hotkeys);
+
+// 记录一次采样到的访问, 返回 key 是否已是热点
+bool memkv_hotkeys_record(memkv_hotkeys_t* hotkeys, const char* key, size_t nkey, uint64_t hash);
+
+// 所有计数减半
+void memkv_hotkeys_decay(memkv_hotkeys_t* hotkeys);
+
+// 按计数从大到小返回跟踪的 key, 返回个数
+int memkv_hotkeys_top(memkv_hotkeys_t* hotkeys, memkv_hotkey_t* out, int max);
+
+// 副本缓存: 只由所属 reactor 访问
+infra_error_t memkv_hotcache_create(memkv_hotcache_t** cache);
+void memkv_hotcache_destroy(memkv_hotcache_t* cache);
+
+// 查找仍然有效的副本, 命中时 *item 增加一次引用
+bool memkv_hotcache_get(memkv_hotcache_t* cache, const char* key, size_t nkey, uint64_t hash,
+                        memkv_item_t** item);
+
+// 收录 item (增加一次引用), 替换同一槽中的旧副本
+void memkv_hotcache_put(memkv_hotcache_t* cache, memkv_item_t* item);
+
+// 释放已失效的副本
+void memkv_hotcache_sweep(memkv_hotcache_t* cache);
+
+#endif /* PEER_MEMKV_HOTKEYS_H_ */
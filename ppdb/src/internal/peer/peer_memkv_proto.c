@@ -0,0 +1,719 @@
+#include "internal/infra/infra_core.h"
+#include "internal/infra/infra_error.h"
+#include "internal/peer/peer_memkv_proto.h"
+
+// 非 get 命令行的最大 token 数: cas <key> <flags> <exptime> <bytes> <cas> [noreply]
+#define MEMKV_PROTO_MAX_TOKENS 8
+
+static const char* const ERR_UNKNOWN = "ERROR\r\n";
+static const char* const ERR_FORMAT = "CLIENT_ERROR bad command line format\r\n";
+static const char* const ERR_LINE_TOO_LONG = "CLIENT_ERROR line too long\r\n";
+static const char* const ERR_BAD_CHUNK = "CLIENT_ERROR bad data chunk\r\n";
+static const char* const ERR_DELTA = "CLIENT_ERROR invalid numeric delta argument\r\n";
+static const char* const ERR_TOO_LARGE = "SERVER_ERROR object too large for cache\r\n";
+static const char* const ERR_BAD_FLAG = "CLIENT_ERROR invalid flag\r\n";
+
+// meta 命令允许的标志
+static const char* const META_GET_FLAGS = "vkfstcqOT";
+static const char* const META_SET_FLAGS = "kcqOTFCIM";
+static const char* const META_DELETE_FLAGS = "kqOCI";
+
+//-----------------------------------------------------------------------------
+// Span Helpers
+//-----------------------------------------------------------------------------
+
+bool memkv_proto_next_token(memkv_span_t* span, memkv_span_t* token) {
+    const char* p = span->ptr;
+    const char* end = span->ptr + span->len;
+
+    while (p < end && *p == ' ') p++;
+    if (p == end) {
+        span->ptr = end;
+        span->len = 0;
+        return false;
+    }
+
+    const char* start = p;
+    while (p < end && *p != ' ') p++;
+    token->ptr = start;
+    token->len = (size_t)(p - start);
+    span->ptr = p;
+    span->len = (size_t)(end - p);
+    return true;
+}
+
+bool memkv_span_equals(memkv_span_t span, const char* str) {
+    size_t len = strlen(str);
+    return span.len == len && memcmp(span.ptr, str, len) == 0;
+}
+
+bool memkv_span_to_u64(memkv_span_t span, uint64_t* value) {
+    if (span.len == 0 || span.len > 20) {
+        return false;
+    }
+    uint64_t v = 0;
+    for (size_t i = 0; i < span.len; i++) {
+        unsigned d = (unsigned char)span.ptr[i] - '0';
+        if (d > 9) {
+            return false;
+        }
+        if (v > (UINT64_MAX - d) / 10) {
+            return false;
+        }
+        v = v * 10 + d;
+    }
+    *value = v;
+    return true;
+}
+
+bool memkv_span_to_i64(memkv_span_t span, int64_t* value) {
+    bool negative = span.len > 0 && span.ptr[0] == '-';
+    if (negative) {
+        span.ptr++;
+        span.len--;
+    }
+    uint64_t v;
+    if (!memkv_span_to_u64(span, &v) || v > (uint64_t)INT64_MAX) {
+        return false;
+    }
+    *value = negative ? -(int64_t)v : (int64_t)v;
+    return true;
+}
+
+static bool span_to_u32(memkv_span_t span, uint32_t* value) {
+    uint64_t v;
+    if (!memkv_span_to_u64(span, &v) || v > UINT32_MAX) {
+        return false;
+    }
+    *value = (uint32_t)v;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Command Lookup
+//-----------------------------------------------------------------------------
+
+static memkv_cmd_t lookup_cmd(memkv_span_t name) {
+    // 先按长度分派, 只做一次 memcmp
+    switch (name.len) {
+        case 2:
+            if (name.ptr[0] != 'm') break;
+            if (name.ptr[1] == 'g') return MEMKV_CMD_META_GET;
+            if (name.ptr[1] == 's') return MEMKV_CMD_META_SET;
+            if (name.ptr[1] == 'd') return MEMKV_CMD_META_DELETE;
+            if (name.ptr[1] == 'n') return MEMKV_CMD_META_NOOP;
+            break;
+        case 3:
+            if (memcmp(name.ptr, "get", 3) == 0) return MEMKV_CMD_GET;
+            if (memcmp(name.ptr, "set", 3) == 0) return MEMKV_CMD_SET;
+            if (memcmp(name.ptr, "add", 3) == 0) return MEMKV_CMD_ADD;
+            if (memcmp(name.ptr, "cas", 3) == 0) return MEMKV_CMD_CAS;
+            if (memcmp(name.ptr, "gat", 3) == 0) return MEMKV_CMD_GAT;
+            break;
+        case 4:
+            if (memcmp(name.ptr, "gets", 4) == 0) return MEMKV_CMD_GETS;
+            if (memcmp(name.ptr, "incr", 4) == 0) return MEMKV_CMD_INCR;
+            if (memcmp(name.ptr, "decr", 4) == 0) return MEMKV_CMD_DECR;
+            if (memcmp(name.ptr, "quit", 4) == 0) return MEMKV_CMD_QUIT;
+            if (memcmp(name.ptr, "gats", 4) == 0) return MEMKV_CMD_GATS;
+            break;
+        case 5:
+            if (memcmp(name.ptr, "touch", 5) == 0) return MEMKV_CMD_TOUCH;
+            if (memcmp(name.ptr, "stats", 5) == 0) return MEMKV_CMD_STATS;
+            break;
+        case 6:
+            if (memcmp(name.ptr, "delete", 6) == 0) return MEMKV_CMD_DELETE;
+            if (memcmp(name.ptr, "append", 6) == 0) return MEMKV_CMD_APPEND;
+            break;
+        case 7:
+            if (memcmp(name.ptr, "replace", 7) == 0) return MEMKV_CMD_REPLACE;
+            if (memcmp(name.ptr, "prepend", 7) == 0) return MEMKV_CMD_PREPEND;
+            if (memcmp(name.ptr, "version", 7) == 0) return MEMKV_CMD_VERSION;
+            break;
+        case 9:
+            if (memcmp(name.ptr, "flush_all", 9) == 0) return MEMKV_CMD_FLUSH_ALL;
+            break;
+    }
+    return MEMKV_CMD_UNKNOWN;
+}
+
+static bool is_storage_cmd(memkv_cmd_t cmd) {
+    return cmd == MEMKV_CMD_SET || cmd == MEMKV_CMD_ADD || cmd == MEMKV_CMD_REPLACE ||
+           cmd == MEMKV_CMD_APPEND || cmd == MEMKV_CMD_PREPEND || cmd == MEMKV_CMD_CAS;
+}
+
+static bool valid_key(memkv_span_t key) {
+    return key.len > 0 && key.len <= MEMKV_PROTO_MAX_KEY_LEN;
+}
+
+// 去掉末尾的 noreply
+static void strip_noreply(memkv_span_t* tokens, int* ntokens, memkv_request_t* req) {
+    if (*ntokens > 0 && memkv_span_equals(tokens[*ntokens - 1], "noreply")) {
+        req->noreply = true;
+        (*ntokens)--;
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Parser
+//-----------------------------------------------------------------------------
+
+void memkv_parser_init(memkv_parser_t* parser, size_t max_value) {
+    memset(parser, 0, sizeof(*parser));
+    parser->state = MEMKV_PARSE_LINE;
+    parser->max_value = max_value;
+}
+
+void memkv_parser_set_stream(memkv_parser_t* parser, size_t stream_min, size_t max_stream) {
+    parser->stream_min = stream_min;
+    parser->max_stream = max_stream;
+}
+
+void memkv_proto_skip(memkv_parser_t* parser, size_t len) {
+    if (len > 0) {
+        parser->state = MEMKV_PARSE_SWALLOW;
+        parser->swallow = len;
+    }
+}
+
+// 读取命令行之后的数据块: <bytes> 字节数据 + \r\n
+static infra_error_t parse_data_block(memkv_parser_t* parser, memkv_request_t* req, uint64_t bytes,
+                                      const char* buf, size_t len, size_t line_total,
+                                      size_t* consumed) {
+    bool stream = parser->stream_min > 0 && bytes >= parser->stream_min;
+
+    // 超限的数据块直接丢弃, 连接保持可用
+    if (bytes > (stream ? parser->max_stream : parser->max_value)) {
+        req->error = ERR_TOO_LARGE;
+        parser->state = MEMKV_PARSE_SWALLOW;
+        parser->swallow = (size_t)bytes + 2;
+        *consumed = line_total;
+        return INFRA_ERROR_PROTOCOL;
+    }
+
+    size_t need = line_total + (size_t)bytes + 2;
+    if (len < need && stream) {
+        // 大数据块不经接收缓冲区, 只交出命令行, 数据块由调用者读入
+        parser->state = MEMKV_PARSE_LINE;
+        parser->need = 0;
+        *consumed = line_total;
+        req->stream = true;
+        req->data.ptr = NULL;
+        req->data.len = (size_t)bytes;
+        return INFRA_OK;
+    }
+    if (len < need) {
+        // 记下总长度, 数据到齐前不再重复解析命令行
+        parser->state = MEMKV_PARSE_DATA;
+        parser->need = need;
+        *consumed = 0;
+        return INFRA_ERROR_WOULD_BLOCK;
+    }
+
+    parser->state = MEMKV_PARSE_LINE;
+    parser->need = 0;
+    *consumed = need;
+
+    const char* data = buf + line_total;
+    if (data[bytes] != '\r' || data[bytes + 1] != '\n') {
+        req->error = ERR_BAD_CHUNK;
+        return INFRA_ERROR_PROTOCOL;
+    }
+    req->data.ptr = data;
+    req->data.len = (size_t)bytes;
+    return INFRA_OK;
+}
+
+// 解析存储命令: <cmd> <key> <flags> <exptime> <bytes> [<cas>] [noreply]
+static infra_error_t parse_storage(memkv_parser_t* parser, memkv_request_t* req,
+                                   memkv_span_t* tokens, int ntokens,
+                                   const char* buf, size_t len, size_t line_total,
+                                   size_t* consumed) {
+    int expected = req->cmd == MEMKV_CMD_CAS ? 5 : 4;
+    uint64_t bytes = 0;
+
+    strip_noreply(tokens, &ntokens, req);
+    if (ntokens != expected || !valid_key(tokens[0]) ||
+        !span_to_u32(tokens[1], &req->flags) ||
+        !memkv_span_to_i64(tokens[2], &req->exptime) ||
+        !memkv_span_to_u64(tokens[3], &bytes) ||
+        (req->cmd == MEMKV_CMD_CAS && !memkv_span_to_u64(tokens[4], &req->cas_unique))) {
+        req->error = ERR_FORMAT;
+        *consumed = line_total;
+        return INFRA_ERROR_PROTOCOL;
+    }
+    req->key = tokens[0];
+    return parse_data_block(parser, req, bytes, buf, len, line_total, consumed);
+}
+
+// 解析 meta 命令的标志, 只接受 allowed 中的标志
+static bool parse_meta_flags(memkv_span_t rest, const char* allowed, memkv_request_t* req) {
+    memkv_span_t tok;
+    req->mode = 'S';
+    while (memkv_proto_next_token(&rest, &tok)) {
+        if (!strchr(allowed, tok.ptr[0])) {
+            return false;
+        }
+        memkv_span_t arg = {tok.ptr + 1, tok.len - 1};
+        switch (tok.ptr[0]) {
+            case 'v': req->meta |= MEMKV_META_VALUE; break;
+            case 'k': req->meta |= MEMKV_META_KEY; break;
+            case 'f': req->meta |= MEMKV_META_FLAGS; break;
+            case 's': req->meta |= MEMKV_META_SIZE; break;
+            case 't': req->meta |= MEMKV_META_TTL; break;
+            case 'c': req->meta |= MEMKV_META_CAS; break;
+            case 'I': req->meta |= MEMKV_META_INVALIDATE; break;
+            case 'q': req->quiet = true; break;
+            case 'O':
+                if (arg.len == 0 || arg.len > MEMKV_META_MAX_OPAQUE) return false;
+                req->meta |= MEMKV_META_OPAQUE;
+                req->meta_opaque = arg;
+                break;
+            case 'T':
+                if (!memkv_span_to_i64(arg, &req->exptime)) return false;
+                req->meta |= MEMKV_META_SET_TTL;
+                break;
+            case 'F':
+                if (!span_to_u32(arg, &req->flags)) return false;
+                req->meta |= MEMKV_META_SET_FLAGS;
+                break;
+            case 'C':
+                if (!memkv_span_to_u64(arg, &req->cas_unique)) return false;
+                req->meta |= MEMKV_META_COMPARE;
+                break;
+            case 'M':
+                if (arg.len != 1 || !strchr("SEAPRseapr", arg.ptr[0])) return false;
+                req->mode = (char)toupper((unsigned char)arg.ptr[0]);
+                break;
+            default:
+                return false;
+        }
+    }
+    return true;
+}
+
+// 解析 meta 命令: mg <key> <flags>*, ms <key> <datalen> <flags>*, md <key> <flags>*, mn
+static infra_error_t parse_meta(memkv_parser_t* parser, memkv_request_t* req, memkv_span_t rest,
+                                const char* buf, size_t len, size_t line_total, size_t* consumed) {
+    *consumed = line_total;
+
+    if (req->cmd == MEMKV_CMD_META_NOOP) {
+        memkv_span_t extra;
+        if (memkv_proto_next_token(&rest, &extra)) {
+            req->error = ERR_FORMAT;
+            return INFRA_ERROR_PROTOCOL;
+        }
+        return INFRA_OK;
+    }
+
+    if (!memkv_proto_next_token(&rest, &req->key) || !valid_key(req->key)) {
+        req->error = ERR_FORMAT;
+        return INFRA_ERROR_PROTOCOL;
+    }
+
+    uint64_t bytes = 0;
+    memkv_span_t datalen;
+    if (req->cmd == MEMKV_CMD_META_SET &&
+        (!memkv_proto_next_token(&rest, &datalen) || !memkv_span_to_u64(datalen, &bytes))) {
+        req->error = ERR_FORMAT;
+        return INFRA_ERROR_PROTOCOL;
+    }
+
+    const char* allowed = req->cmd == MEMKV_CMD_META_GET ? META_GET_FLAGS :
+                          req->cmd == MEMKV_CMD_META_SET ? META_SET_FLAGS : META_DELETE_FLAGS;
+    if (!parse_meta_flags(rest, allowed, req)) {
+        req->error = ERR_BAD_FLAG;
+        if (req->cmd == MEMKV_CMD_META_SET) {
+            // 数据块已在路上, 丢弃后连接仍可用
+            parser->state = MEMKV_PARSE_SWALLOW;
+            parser->swallow = (size_t)bytes + 2;
+        }
+        return INFRA_ERROR_PROTOCOL;
+    }
+
+    if (req->cmd != MEMKV_CMD_META_SET) {
+        return INFRA_OK;
+    }
+    return parse_data_block(parser, req, bytes, buf, len, line_total, consumed);
+}
+
+//-----------------------------------------------------------------------------
+// Binary Protocol
+//-----------------------------------------------------------------------------
+
+static uint16_t read_u16(const char* p) {
+    const unsigned char* u = (const unsigned char*)p;
+    return (uint16_t)((u[0] << 8) | u[1]);
+}
+
+static uint32_t read_u32(const char* p) {
+    const unsigned char* u = (const unsigned char*)p;
+    return ((uint32_t)u[0] << 24) | ((uint32_t)u[1] << 16) | ((uint32_t)u[2] << 8) | u[3];
+}
+
+static uint64_t read_u64(const char* p) {
+    return ((uint64_t)read_u32(p) << 32) | read_u32(p + 4);
+}
+
+static void write_u16(char* p, uint16_t v) {
+    p[0] = (char)(v >> 8);
+    p[1] = (char)v;
+}
+
+static void write_u32(char* p, uint32_t v) {
+    p[0] = (char)(v >> 24);
+    p[1] = (char)(v >> 16);
+    p[2] = (char)(v >> 8);
+    p[3] = (char)v;
+}
+
+void memkv_proto_bin_header(char* out, uint8_t opcode, uint16_t status, uint16_t keylen,
+                            uint8_t extlen, uint32_t bodylen, uint32_t opaque, uint64_t cas) {
+    out[0] = (char)MEMKV_BIN_RES_MAGIC;
+    out[1] = (char)opcode;
+    write_u16(out + 2, keylen);
+    out[4] = (char)extlen;
+    out[5] = 0;  // data type
+    write_u16(out + 6, status);
+    write_u32(out + 8, bodylen);
+    // opaque 按原字节序写回
+    memcpy(out + 12, &opaque, 4);
+    write_u32(out + 16, (uint32_t)(cas >> 32));
+    write_u32(out + 20, (uint32_t)cas);
+}
+
+// 把操作码映射为命令, 未知操作码返回 false
+static bool bin_lookup(memkv_request_t* req) {
+    switch (req->opcode) {
+        case MEMKV_BIN_OP_GETKQ:
+            req->return_key = true;
+            /* fallthrough */
+        case MEMKV_BIN_OP_GETQ:
+            req->quiet = true;
+            req->cmd = MEMKV_CMD_GET;
+            return true;
+        case MEMKV_BIN_OP_GETK:
+            req->return_key = true;
+            /* fallthrough */
+        case MEMKV_BIN_OP_GET:
+            req->cmd = MEMKV_CMD_GET;
+            return true;
+        case MEMKV_BIN_OP_SETQ: req->quiet = true; /* fallthrough */
+        case MEMKV_BIN_OP_SET: req->cmd = MEMKV_CMD_SET; return true;
+        case MEMKV_BIN_OP_ADDQ: req->quiet = true; /* fallthrough */
+        case MEMKV_BIN_OP_ADD: req->cmd = MEMKV_CMD_ADD; return true;
+        case MEMKV_BIN_OP_REPLACEQ: req->quiet = true; /* fallthrough */
+        case MEMKV_BIN_OP_REPLACE: req->cmd = MEMKV_CMD_REPLACE; return true;
+        case MEMKV_BIN_OP_APPENDQ: req->quiet = true; /* fallthrough */
+        case MEMKV_BIN_OP_APPEND: req->cmd = MEMKV_CMD_APPEND; return true;
+        case MEMKV_BIN_OP_PREPENDQ: req->quiet = true; /* fallthrough */
+        case MEMKV_BIN_OP_PREPEND: req->cmd = MEMKV_CMD_PREPEND; return true;
+        case MEMKV_BIN_OP_DELETEQ: req->quiet = true; /* fallthrough */
+        case MEMKV_BIN_OP_DELETE: req->cmd = MEMKV_CMD_DELETE; return true;
+        case MEMKV_BIN_OP_INCREMENTQ: req->quiet = true; /* fallthrough */
+        case MEMKV_BIN_OP_INCREMENT: req->cmd = MEMKV_CMD_INCR; return true;
+        case MEMKV_BIN_OP_DECREMENTQ: req->quiet = true; /* fallthrough */
+        case MEMKV_BIN_OP_DECREMENT: req->cmd = MEMKV_CMD_DECR; return true;
+        case MEMKV_BIN_OP_QUITQ: req->quiet = true; /* fallthrough */
+        case MEMKV_BIN_OP_QUIT: req->cmd = MEMKV_CMD_QUIT; return true;
+        case MEMKV_BIN_OP_FLUSHQ: req->quiet = true; /* fallthrough */
+        case MEMKV_BIN_OP_FLUSH: req->cmd = MEMKV_CMD_FLUSH_ALL; return true;
+        case MEMKV_BIN_OP_NOOP: req->cmd = MEMKV_CMD_NOOP; return true;
+        case MEMKV_BIN_OP_VERSION: req->cmd = MEMKV_CMD_VERSION; return true;
+        case MEMKV_BIN_OP_STAT: req->cmd = MEMKV_CMD_STATS; return true;
+        case MEMKV_BIN_OP_TOUCH: req->cmd = MEMKV_CMD_TOUCH; return true;
+        case MEMKV_BIN_OP_GATKQ:
+            req->return_key = true;
+            /* fallthrough */
+        case MEMKV_BIN_OP_GATQ:
+            req->quiet = true;
+            req->cmd = MEMKV_CMD_TOUCH;
+            return true;
+        case MEMKV_BIN_OP_GATK:
+            req->return_key = true;
+            /* fallthrough */
+        case MEMKV_BIN_OP_GAT:
+            req->cmd = MEMKV_CMD_TOUCH;
+            return true;
+    }
+    return false;
+}
+
+// 校验包体结构并取出 extras
+static bool bin_validate(memkv_request_t* req, const char* extras, size_t extlen) {
+    bool has_key = valid_key(req->key);
+    bool no_key = req->key.len == 0;
+    bool no_value = req->data.len == 0;
+
+    switch (req->cmd) {
+        case MEMKV_CMD_GET:
+        case MEMKV_CMD_DELETE:
+            return extlen == 0 && has_key && no_value;
+        case MEMKV_CMD_SET:
+        case MEMKV_CMD_ADD:
+        case MEMKV_CMD_REPLACE:
+            if (extlen != 8 || !has_key) return false;
+            req->flags = read_u32(extras);
+            req->exptime = read_u32(extras + 4);
+            return true;
+        case MEMKV_CMD_APPEND:
+        case MEMKV_CMD_PREPEND:
+            return extlen == 0 && has_key;
+        case MEMKV_CMD_INCR:
+        case MEMKV_CMD_DECR: {
+            if (extlen != 20 || !has_key || !no_value) return false;
+            req->delta = read_u64(extras);
+            req->initial = read_u64(extras + 8);
+            // 过期时间为 0xffffffff 表示未命中时不创建
+            uint32_t exptime = read_u32(extras + 16);
+            req->create = exptime != 0xffffffffu;
+            req->exptime = req->create ? exptime : 0;
+            return true;
+        }
+        case MEMKV_CMD_TOUCH:
+            if (extlen != 4 || !has_key || !no_value) return false;
+            req->exptime = read_u32(extras);
+            return true;
+        case MEMKV_CMD_FLUSH_ALL:
+            if ((extlen != 0 && extlen != 4) || !no_key || !no_value) return false;
+            req->exptime = extlen == 4 ? read_u32(extras) : 0;
+            return true;
+        case MEMKV_CMD_STATS:
+            // key 为统计分组, 可以为空
+            return extlen == 0 && req->key.len <= MEMKV_PROTO_MAX_KEY_LEN && no_value;
+        default:
+            return extlen == 0 && no_key && no_value;
+    }
+}
+
+// 解析一个二进制请求包: 24 字节头 + extras + key + value
+static infra_error_t parse_binary(memkv_parser_t* parser, const char* buf, size_t len,
+                                  memkv_request_t* req, size_t* consumed) {
+    if (len < MEMKV_BIN_HEADER_LEN) {
+        return INFRA_ERROR_WOULD_BLOCK;
+    }
+
+    req->opcode = (uint8_t)buf[1];
+    memcpy(&req->opaque, buf + 12, 4);
+    uint16_t keylen = read_u16(buf + 2);
+    uint8_t extlen = (uint8_t)buf[4];
+    uint32_t bodylen = read_u32(buf + 8);
+    req->cas_unique = read_u64(buf + 16);
+
+    // 魔数或长度不对时无法确定包边界, 只能关闭连接
+    if ((uint8_t)buf[0] != MEMKV_BIN_REQ_MAGIC || (size_t)keylen + extlen > bodylen) {
+        req->status = MEMKV_BIN_STATUS_EINVAL;
+        return INFRA_ERROR_PROTOCOL;
+    }
+
+    bool known = bin_lookup(req);
+    size_t vlen = bodylen - keylen - extlen;
+    if (vlen > parser->max_value) {
+        req->status = MEMKV_BIN_STATUS_E2BIG;
+        parser->state = MEMKV_PARSE_SWALLOW;
+        parser->swallow = bodylen;
+        *consumed = MEMKV_BIN_HEADER_LEN;
+        return INFRA_ERROR_PROTOCOL;
+    }
+
+    size_t need = MEMKV_BIN_HEADER_LEN + (size_t)bodylen;
+    if (len < need) {
+        parser->state = MEMKV_PARSE_DATA;
+        parser->need = need;
+        return INFRA_ERROR_WOULD_BLOCK;
+    }
+    parser->state = MEMKV_PARSE_LINE;
+    parser->need = 0;
+    *consumed = need;
+
+    if (!known) {
+        req->status = MEMKV_BIN_STATUS_UNKNOWN_COMMAND;
+        return INFRA_ERROR_PROTOCOL;
+    }
+
+    const char* extras = buf + MEMKV_BIN_HEADER_LEN;
+    req->key.ptr = extras + extlen;
+    req->key.len = keylen;
+    req->keys = req->key;
+    req->data.ptr = req->key.ptr + keylen;
+    req->data.len = vlen;
+    req->noreply = req->quiet && req->cmd != MEMKV_CMD_GET && req->cmd != MEMKV_CMD_TOUCH;
+
+    if (!bin_validate(req, extras, extlen)) {
+        req->status = MEMKV_BIN_STATUS_EINVAL;
+        return INFRA_ERROR_PROTOCOL;
+    }
+    return INFRA_OK;
+}
+
+infra_error_t memkv_proto_parse(memkv_parser_t* parser, const char* buf, size_t len,
+                                memkv_request_t* req, size_t* consumed) {
+    if (!parser || !buf || !req || !consumed) {
+        return INFRA_ERROR_INVALID_PARAM;
+    }
+
+    memset(req, 0, sizeof(*req));
+    *consumed = 0;
+
+    if (parser->state == MEMKV_PARSE_SWALLOW) {
+        size_t n = len < parser->swallow ? len : parser->swallow;
+        parser->swallow -= n;
+        if (parser->swallow == 0) {
+            parser->state = MEMKV_PARSE_LINE;
+        }
+        *consumed = n;
+        return INFRA_ERROR_WOULD_BLOCK;
+    }
+
+    if (parser->state == MEMKV_PARSE_DATA && len < parser->need) {
+        return INFRA_ERROR_WOULD_BLOCK;
+    }
+
+    // 第一个字节决定整个连接使用的协议
+    if (parser->protocol == MEMKV_PROTO_AUTO) {
+        if (len == 0) {
+            return INFRA_ERROR_WOULD_BLOCK;
+        }
+        parser->protocol = (uint8_t)buf[0] == MEMKV_BIN_REQ_MAGIC ? MEMKV_PROTO_BINARY : MEMKV_PROTO_TEXT;
+    }
+    if (parser->protocol == MEMKV_PROTO_BINARY) {
+        return parse_binary(parser, buf, len, req, consumed);
+    }
+
+    // 查找行尾, 跳过上次已经扫描过的部分
+    size_t start = parser->state == MEMKV_PARSE_LINE ? parser->scanned : 0;
+    const char* nl = start < len ? memchr(buf + start, '\n', len - start) : NULL;
+    if (!nl) {
+        if (len > MEMKV_PROTO_MAX_LINE) {
+            req->error = ERR_LINE_TOO_LONG;
+            parser->scanned = 0;
+            return INFRA_ERROR_PROTOCOL;
+        }
+        parser->scanned = len;
+        return INFRA_ERROR_WOULD_BLOCK;
+    }
+    parser->scanned = 0;
+
+    size_t line_total = (size_t)(nl - buf) + 1;
+    size_t line_len = line_total - 1;
+    if (line_len > 0 && buf[line_len - 1] == '\r') {
+        line_len--;
+    }
+
+    memkv_span_t line = {buf, line_len};
+    if (!memkv_proto_next_token(&line, &req->name)) {
+        // 空行, 跳过
+        *consumed = line_total;
+        return INFRA_ERROR_WOULD_BLOCK;
+    }
+    req->args = line;
+    req->cmd = lookup_cmd(req->name);
+
+    if (req->cmd >= MEMKV_CMD_META_GET) {
+        // meta 命令的标志个数不定, 单独解析
+        return parse_meta(parser, req, line, buf, len, line_total, consumed);
+    }
+
+    if (req->cmd == MEMKV_CMD_GET || req->cmd == MEMKV_CMD_GETS ||
+        req->cmd == MEMKV_CMD_GAT || req->cmd == MEMKV_CMD_GATS) {
+        // key 数不限, 只校验, 由调用者用 memkv_proto_next_token 遍历
+        memkv_span_t rest = line;
+        memkv_span_t key;
+        size_t nkeys = 0;
+        *consumed = line_total;
+        // gat/gats <exptime> <key>*
+        if (req->cmd == MEMKV_CMD_GAT || req->cmd == MEMKV_CMD_GATS) {
+            memkv_span_t exptime;
+            if (!memkv_proto_next_token(&rest, &exptime) ||
+                !memkv_span_to_i64(exptime, &req->exptime)) {
+                req->error = ERR_FORMAT;
+                return INFRA_ERROR_PROTOCOL;
+            }
+            line = rest;
+        }
+        while (memkv_proto_next_token(&rest, &key)) {
+            if (!valid_key(key)) {
+                req->error = ERR_FORMAT;
+                return INFRA_ERROR_PROTOCOL;
+            }
+            if (nkeys++ == 0) {
+                req->key = key;
+            }
+        }
+        if (nkeys == 0) {
+            req->error = ERR_UNKNOWN;
+            return INFRA_ERROR_PROTOCOL;
+        }
+        req->keys = line;
+        return INFRA_OK;
+    }
+
+    memkv_span_t tokens[MEMKV_PROTO_MAX_TOKENS];
+    int ntokens = 0;
+    memkv_span_t rest = line;
+    while (ntokens < MEMKV_PROTO_MAX_TOKENS && memkv_proto_next_token(&rest, &tokens[ntokens])) {
+        ntokens++;
+    }
+    memkv_span_t extra;
+    if (memkv_proto_next_token(&rest, &extra)) {
+        req->error = req->cmd == MEMKV_CMD_UNKNOWN ? ERR_UNKNOWN : ERR_FORMAT;
+        *consumed = line_total;
+        return INFRA_ERROR_PROTOCOL;
+    }
+
+    if (is_storage_cmd(req->cmd)) {
+        return parse_storage(parser, req, tokens, ntokens, buf, len, line_total, consumed);
+    }
+
+    *consumed = line_total;
+    bool ok = false;
+    switch (req->cmd) {
+        case MEMKV_CMD_DELETE:
+            // delete <key> [0] [noreply], 兼容旧客户端的 time 参数 0
+            strip_noreply(tokens, &ntokens, req);
+            if (ntokens == 2 && memkv_span_equals(tokens[1], "0")) {
+                ntokens = 1;
+            }
+            ok = ntokens == 1 && valid_key(tokens[0]);
+            break;
+        case MEMKV_CMD_INCR:
+        case MEMKV_CMD_DECR:
+            strip_noreply(tokens, &ntokens, req);
+            ok = ntokens == 2 && valid_key(tokens[0]);
+            if (ok && !memkv_span_to_u64(tokens[1], &req->delta)) {
+                req->key = tokens[0];
+                req->error = ERR_DELTA;
+                return INFRA_ERROR_PROTOCOL;
+            }
+            break;
+        case MEMKV_CMD_TOUCH:
+            strip_noreply(tokens, &ntokens, req);
+            ok = ntokens == 2 && valid_key(tokens[0]) &&
+                 memkv_span_to_i64(tokens[1], &req->exptime);
+            break;
+        case MEMKV_CMD_FLUSH_ALL:
+            // flush_all [delay] [noreply]
+            strip_noreply(tokens, &ntokens, req);
+            ok = ntokens == 0 || (ntokens == 1 && memkv_span_to_i64(tokens[0], &req->exptime));
+            break;
+        case MEMKV_CMD_STATS:
+            ok = true;
+            break;
+        case MEMKV_CMD_VERSION:
+        case MEMKV_CMD_QUIT:
+            ok = ntokens == 0;
+            break;
+        default:
+            req->error = ERR_UNKNOWN;
+            return INFRA_ERROR_PROTOCOL;
+    }
+
+    if (!ok) {
+        req->error = ERR_FORMAT;
+        return INFRA_ERROR_PROTOCOL;
+    }
+    if (ntokens > 0 && req->cmd != MEMKV_CMD_FLUSH_ALL && req->cmd != MEMKV_CMD_STATS) {
+        req->key = tokens[0];
+    }
+    return INFRA_OK;
+}
@@ -0,0 +1,211 @@
+#ifndef PEER_MEMKV_PROTO_H_
+#define PEER_MEMKV_PROTO_H_
+
+#include "internal/infra/infra_core.h"
+#include "internal/infra/infra_error.h"
+
+//-----------------------------------------------------------------------------
+// memcached 文本协议解析器
+//
+// 增量解析: 每次调用从接收缓冲区的当前位置解析出一条完整请求.
+// key, value 等都以 (ptr, len) 区间指向原缓冲区, 不复制, 也不修改缓冲区.
+// 存储命令的数据块按长度读取, 数据中可以包含 \r\n.
+//
+// 同一解析器还支持二进制协议和 meta 命令 (mg/ms/md/mn):
+// 连接的第一个字节为 0x80 时按二进制协议解析, 否则按文本协议.
+//-----------------------------------------------------------------------------
+
+// 命令行最大长度 (含多 key 的 get)
+#define MEMKV_PROTO_MAX_LINE (64 * 1024)
+#define MEMKV_PROTO_MAX_KEY_LEN 250
+// meta 命令 O 标志内容的最大长度
+#define MEMKV_META_MAX_OPAQUE 32
+
+// 二进制协议
+#define MEMKV_BIN_REQ_MAGIC 0x80
+#define MEMKV_BIN_RES_MAGIC 0x81
+#define MEMKV_BIN_HEADER_LEN 24
+
+typedef enum {
+    MEMKV_BIN_OP_GET = 0x00,
+    MEMKV_BIN_OP_SET = 0x01,
+    MEMKV_BIN_OP_ADD = 0x02,
+    MEMKV_BIN_OP_REPLACE = 0x03,
+    MEMKV_BIN_OP_DELETE = 0x04,
+    MEMKV_BIN_OP_INCREMENT = 0x05,
+    MEMKV_BIN_OP_DECREMENT = 0x06,
+    MEMKV_BIN_OP_QUIT = 0x07,
+    MEMKV_BIN_OP_FLUSH = 0x08,
+    MEMKV_BIN_OP_GETQ = 0x09,
+    MEMKV_BIN_OP_NOOP = 0x0a,
+    MEMKV_BIN_OP_VERSION = 0x0b,
+    MEMKV_BIN_OP_GETK = 0x0c,
+    MEMKV_BIN_OP_GETKQ = 0x0d,
+    MEMKV_BIN_OP_APPEND = 0x0e,
+    MEMKV_BIN_OP_PREPEND = 0x0f,
+    MEMKV_BIN_OP_STAT = 0x10,
+    MEMKV_BIN_OP_SETQ = 0x11,
+    MEMKV_BIN_OP_ADDQ = 0x12,
+    MEMKV_BIN_OP_REPLACEQ = 0x13,
+    MEMKV_BIN_OP_DELETEQ = 0x14,
+    MEMKV_BIN_OP_INCREMENTQ = 0x15,
+    MEMKV_BIN_OP_DECREMENTQ = 0x16,
+    MEMKV_BIN_OP_QUITQ = 0x17,
+    MEMKV_BIN_OP_FLUSHQ = 0x18,
+    MEMKV_BIN_OP_APPENDQ = 0x19,
+    MEMKV_BIN_OP_PREPENDQ = 0x1a,
+    MEMKV_BIN_OP_TOUCH = 0x1c,
+    MEMKV_BIN_OP_GAT = 0x1d,
+    MEMKV_BIN_OP_GATQ = 0x1e,
+    MEMKV_BIN_OP_GATK = 0x23,
+    MEMKV_BIN_OP_GATKQ = 0x24
+} memkv_bin_op_t;
+
+typedef enum {
+    MEMKV_BIN_STATUS_OK = 0x0000,
+    MEMKV_BIN_STATUS_KEY_ENOENT = 0x0001,
+    MEMKV_BIN_STATUS_KEY_EEXISTS = 0x0002,
+    MEMKV_BIN_STATUS_E2BIG = 0x0003,
+    MEMKV_BIN_STATUS_EINVAL = 0x0004,
+    MEMKV_BIN_STATUS_NOT_STORED = 0x0005,
+    MEMKV_BIN_STATUS_DELTA_BADVAL = 0x0006,
+    MEMKV_BIN_STATUS_UNKNOWN_COMMAND = 0x0081,
+    MEMKV_BIN_STATUS_ENOMEM = 0x0082,
+    MEMKV_BIN_STATUS_NOT_SUPPORTED = 0x0083,
+    MEMKV_BIN_STATUS_EINTERNAL = 0x0084
+} memkv_bin_status_t;
+
+// meta 命令标志位
+#define MEMKV_META_VALUE     0x0001   // v: 返回 value
+#define MEMKV_META_KEY       0x0002   // k: 返回 key
+#define MEMKV_META_FLAGS     0x0004   // f: 返回客户端标志
+#define MEMKV_META_SIZE      0x0008   // s: 返回 value 长度
+#define MEMKV_META_TTL       0x0010   // t: 返回剩余过期时间
+#define MEMKV_META_CAS       0x0020   // c: 返回 CAS
+#define MEMKV_META_OPAQUE    0x0040   // O<token>: 原样返回
+#define MEMKV_META_SET_TTL   0x0080   // T<ttl>: 设置过期时间
+#define MEMKV_META_SET_FLAGS 0x0100   // F<flags>: 设置客户端标志
+#define MEMKV_META_COMPARE   0x0200   // C<cas>: 比较 CAS
+#define MEMKV_META_INVALIDATE 0x0400  // I: 标记失效而不是删除
+
+// 字节区间, 不以 '\0' 结尾
+typedef struct memkv_span {
+    const char* ptr;
+    size_t len;
+} memkv_span_t;
+
+typedef enum {
+    MEMKV_CMD_UNKNOWN = 0,
+    MEMKV_CMD_GET,
+    MEMKV_CMD_GETS,
+    MEMKV_CMD_SET,
+    MEMKV_CMD_ADD,
+    MEMKV_CMD_REPLACE,
+    MEMKV_CMD_APPEND,
+    MEMKV_CMD_PREPEND,
+    MEMKV_CMD_CAS,
+    MEMKV_CMD_DELETE,
+    MEMKV_CMD_INCR,
+    MEMKV_CMD_DECR,
+    MEMKV_CMD_TOUCH,
+    MEMKV_CMD_FLUSH_ALL,
+    MEMKV_CMD_STATS,
+    MEMKV_CMD_VERSION,
+    MEMKV_CMD_QUIT,
+    MEMKV_CMD_GAT,
+    MEMKV_CMD_GATS,
+    MEMKV_CMD_NOOP,              // 二进制 noop
+    MEMKV_CMD_META_GET,          // mg
+    MEMKV_CMD_META_SET,          // ms
+    MEMKV_CMD_META_DELETE,       // md
+    MEMKV_CMD_META_NOOP          // mn
+} memkv_cmd_t;
+
+typedef enum {
+    MEMKV_PROTO_AUTO = 0,        // 尚未收到数据
+    MEMKV_PROTO_TEXT,
+    MEMKV_PROTO_BINARY
+} memkv_proto_t;
+
+// 一条解析好的请求, 区间在下一次解析或缓冲区移动之前有效
+typedef struct memkv_request {
+    memkv_cmd_t cmd;
+    memkv_span_t name;           // 命令名
+    memkv_span_t key;            // 第一个 key (get/gets/gat/gats 的其余 key 见 keys)
+    memkv_span_t keys;           // get/gets/gat/gats: 全部 key 所在的区间, 用 memkv_proto_next_token 遍历
+    memkv_span_t args;           // 命令名之后的整行参数
+    memkv_span_t data;           // 存储命令的数据块 (不含结尾 \r\n)
+    bool stream;                 // 数据块流式接收: data.ptr 为 NULL, 之后的 data.len + 2 字节
+                                 // (数据块和 \r\n) 由调用者读走, 不再交给解析器
+    uint32_t flags;
+    int64_t exptime;             // 存储命令, touch, gat/gats 的过期时间
+    uint64_t cas_unique;         // cas 命令的版本号
+    uint64_t delta;              // incr/decr 的增量
+    bool noreply;
+    const char* error;           // 解析失败时返回给客户端的错误响应
+
+    // 二进制协议
+    uint8_t opcode;              // memkv_bin_op_t
+    uint32_t opaque;             // 原样返回
+    uint64_t initial;            // increment/decrement 的初始值
+    bool create;                 // increment/decrement 未命中时用 initial 创建
+    bool quiet;                  // 静默: 成功 (get 为未命中) 时不回复, meta 的 q 标志同义
+    bool return_key;             // 响应中带 key (GETK/GATK)
+    uint16_t status;             // 解析失败时的状态码 (memkv_bin_status_t)
+
+    // meta 命令
+    uint32_t meta;               // MEMKV_META_*
+    memkv_span_t meta_opaque;    // O 标志的内容
+    char mode;                   // ms 的 M 标志: S/E/A/P/R, 默认 S
+} memkv_request_t;
+
+// 解析器状态, 跨多次 recv 保持
+typedef enum {
+    MEMKV_PARSE_LINE = 0,        // 等待命令行
+    MEMKV_PARSE_DATA,            // 命令行已解析, 等待数据块到齐
+    MEMKV_PARSE_SWALLOW          // 丢弃超限的数据块
+} memkv_parse_state_t;
+
+typedef struct memkv_parser {
+    memkv_parse_state_t state;
+    size_t scanned;              // LINE: 已扫描过未找到换行的字节数
+    size_t need;                 // DATA: 当前请求的总字节数 (命令行 + 数据 + \r\n)
+    size_t swallow;              // SWALLOW: 还需丢弃的字节数
+    size_t max_value;            // 数据块上限, 超出时回复错误并丢弃数据
+    size_t stream_min;           // 文本协议中不小于该长度且未到齐的数据块流式接收, 0 表示不启用
+    size_t max_stream;           // 流式接收的数据块上限
+    memkv_proto_t protocol;      // 由第一个字节确定, 之后不变
+} memkv_parser_t;
+
+void memkv_parser_init(memkv_parser_t* parser, size_t max_value);
+
+// 启用大数据块的流式接收 (见 memkv_request_t.stream)
+void memkv_parser_set_stream(memkv_parser_t* parser, size_t stream_min, size_t max_stream);
+
+// 丢弃接下来的 len 字节 (如流式接收的数据块无处存放时)
+void memkv_proto_skip(memkv_parser_t* parser, size_t len);
+
+// 从 buf 解析一条请求
+//  INFRA_OK: 得到完整请求, *consumed 为其字节数
+//  INFRA_ERROR_WOULD_BLOCK: 数据不完整, *consumed 为可以丢弃的字节数 (通常为 0)
+//  INFRA_ERROR_PROTOCOL: 请求格式错误, req->error 为错误响应 (二进制协议为 req->status),
+//                        跳过 *consumed 字节后可继续;
+//                        *consumed 为 0 表示无法恢复, 应关闭连接
+infra_error_t memkv_proto_parse(memkv_parser_t* parser, const char* buf, size_t len,
+                                memkv_request_t* req, size_t* consumed);
+
+// 写入 24 字节的二进制响应头
+void memkv_proto_bin_header(char* out, uint8_t opcode, uint16_t status, uint16_t keylen,
+                            uint8_t extlen, uint32_t bodylen, uint32_t opaque, uint64_t cas);
+
+// 从 span 中取出下一个以空格分隔的 token, 没有更多 token 时返回 false
+bool memkv_proto_next_token(memkv_span_t* span, memkv_span_t* token);
+
+// 区间与字符串比较
+bool memkv_span_equals(memkv_span_t span, const char* str);
+
+// 严格的十进制解析, 溢出或含非数字字符时返回 false
+bool memkv_span_to_u64(memkv_span_t span, uint64_t* value);
+bool memkv_span_to_i64(memkv_span_t span, int64_t* value);
+
+#endif /* PEER_MEMKV_PROTO_H_ */
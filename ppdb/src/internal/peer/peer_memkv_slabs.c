@@ -0,0 +1,369 @@
+#include "internal/infra/infra_core.h"
+#include "internal/infra/infra_sync.h"
+#include "internal/infra/infra_log.h"
+#include "internal/peer/peer_memkv_slabs.h"
+
+//-----------------------------------------------------------------------------
+// Types
+//-----------------------------------------------------------------------------
+
+typedef struct memkv_slab_page {
+    struct memkv_slab_page* next;
+    char data[];
+} memkv_slab_page_t;
+
+typedef struct memkv_slab_class {
+    uint32_t id;
+    size_t size;                 // chunk 大小, large class 为 0
+    uint32_t perslab;            // 每页 chunk 数
+    infra_mutex_t mutex;         // 保护空闲链表, 页链表和 LRU
+    memkv_item_t* free;          // 空闲 chunk, 用 h_next 串起来
+    uint64_t free_count;
+    memkv_slab_page_t* pages;
+    uint64_t page_count;
+    uint64_t used;               // 已分配出去的 chunk 数
+    memkv_item_t* lru_head;      // 最近访问
+    memkv_item_t* lru_tail;      // 最久未访问
+    uint64_t lru_count;
+    uint64_t evictions;
+    uint64_t outofmemory;
+    struct memkv_slabs* slabs;
+} memkv_slab_class_t;
+
+struct memkv_slabs {
+    memkv_slab_class_t classes[MEMKV_SLAB_MAX_CLASSES];
+    int nclasses;                // 含 large class
+    size_t page_size;
+    size_t mem_limit;
+    uint64_t mem_malloced;       // 已申请的页和大 item 的字节数 (原子操作)
+    memkv_slabs_evict_fn evict;
+    void* ctx;
+};
+
+//-----------------------------------------------------------------------------
+// Helper Functions
+//-----------------------------------------------------------------------------
+
+static inline size_t item_ntotal(const memkv_item_t* item) {
+    return sizeof(memkv_item_t) + item->nkey + item->nbytes;
+}
+
+static inline size_t align8(size_t n) {
+    return (n + 7) & ~(size_t)7;
+}
+
+// 线性查找: class 数很少, 且大小单调递增
+static memkv_slab_class_t* class_for(memkv_slabs_t* slabs, size_t ntotal) {
+    for (int i = 1; i < slabs->nclasses; i++) {
+        if (ntotal <= slabs->classes[i].size) {
+            return &slabs->classes[i];
+        }
+    }
+    return &slabs->classes[MEMKV_SLAB_LARGE];
+}
+
+// 总量未超上限, 或本 class 还没有任何页 (保证每个 class 至少能用一页)
+static bool mem_available(memkv_slabs_t* slabs, memkv_slab_class_t* cls, size_t len) {
+    if (slabs->mem_limit == 0) {
+        return true;
+    }
+    uint64_t used = __atomic_load_n(&slabs->mem_malloced, __ATOMIC_RELAXED);
+    if (used + len <= slabs->mem_limit) {
+        return true;
+    }
+    return cls->id == MEMKV_SLAB_LARGE ? cls->used == 0 : cls->page_count == 0;
+}
+
+static void lru_remove(memkv_slab_class_t* cls, memkv_item_t* it) {
+    if (it->prev) {
+        it->prev->next = it->next;
+    } else {
+        cls->lru_head = it->next;
+    }
+    if (it->next) {
+        it->next->prev = it->prev;
+    } else {
+        cls->lru_tail = it->prev;
+    }
+    it->prev = NULL;
+    it->next = NULL;
+    cls->lru_count--;
+}
+
+static void lru_push_head(memkv_slab_class_t* cls, memkv_item_t* it) {
+    it->prev = NULL;
+    it->next = cls->lru_head;
+    if (cls->lru_head) {
+        cls->lru_head->prev = it;
+    } else {
+        cls->lru_tail = it;
+    }
+    cls->lru_head = it;
+    cls->lru_count++;
+}
+
+// 申请一页并切成 chunk, 调用者持有 class 锁
+static bool class_grow(memkv_slabs_t* slabs, memkv_slab_class_t* cls) {
+    if (!mem_available(slabs, cls, slabs->page_size)) {
+        return false;
+    }
+    memkv_slab_page_t* page = infra_malloc(sizeof(memkv_slab_page_t) + slabs->page_size);
+    if (!page) {
+        return false;
+    }
+    page->next = cls->pages;
+    cls->pages = page;
+    cls->page_count++;
+    __atomic_add_fetch(&slabs->mem_malloced, slabs->page_size, __ATOMIC_RELAXED);
+
+    for (uint32_t i = 0; i < cls->perslab; i++) {
+        memkv_item_t* it = (memkv_item_t*)(page->data + (size_t)i * cls->size);
+        it->h_next = cls->free;
+        cls->free = it;
+    }
+    cls->free_count += cls->perslab;
+    return true;
+}
+
+// 从 LRU 尾部淘汰一个 item, 返回它的内存 (未放回空闲链表), 调用者持有 class 锁
+static memkv_item_t* class_evict(memkv_slabs_t* slabs, memkv_slab_class_t* cls) {
+    memkv_item_t* it = cls->lru_tail;
+    for (int tries = 0; it && tries < MEMKV_SLAB_EVICT_SEARCH; tries++, it = it->prev) {
+        // 还有读者引用的 item 即使摘下也无法回收
+        if (__atomic_load_n(&it->refcount, __ATOMIC_ACQUIRE) != 1) {
+            continue;
+        }
+        if (!slabs->evict(slabs->ctx, it)) {
+            continue;
+        }
+        lru_remove(cls, it);
+        it->refcount = 0;
+        cls->used--;
+        cls->evictions++;
+        return it;
+    }
+    return NULL;
+}
+
+static memkv_item_t* alloc_large(memkv_slabs_t* slabs, memkv_slab_class_t* cls, size_t ntotal) {
+    while (!mem_available(slabs, cls, ntotal)) {
+        memkv_item_t* victim = class_evict(slabs, cls);
+        if (!victim) {
+            return NULL;
+        }
+        __atomic_sub_fetch(&slabs->mem_malloced, item_ntotal(victim), __ATOMIC_RELAXED);
+        infra_free(victim);
+    }
+
+    memkv_item_t* it = infra_malloc(ntotal);
+    if (it) {
+        __atomic_add_fetch(&slabs->mem_malloced, ntotal, __ATOMIC_RELAXED);
+    }
+    return it;
+}
+
+//-----------------------------------------------------------------------------
+// Slab Functions
+//-----------------------------------------------------------------------------
+
+infra_error_t memkv_slabs_create(const memkv_slabs_config_t* config, memkv_slabs_evict_fn evict,
+                                 void* ctx, memkv_slabs_t** slabs) {
+    if (!evict || !slabs) {
+        return INFRA_ERROR_INVALID_PARAM;
+    }
+
+    double factor = MEMKV_SLAB_DEFAULT_FACTOR;
+    size_t page_size = MEMKV_SLAB_PAGE_SIZE;
+    size_t mem_limit = 0;
+    if (config) {
+        if (config->factor > 0) factor = config->factor;
+        if (config->page_size > 0) page_size = config->page_size;
+        mem_limit = config->mem_limit;
+    }
+    size_t min_chunk = align8(sizeof(memkv_item_t) + 16);
+    if (factor < MEMKV_SLAB_MIN_FACTOR || page_size < min_chunk * 2) {
+        return INFRA_ERROR_INVALID_PARAM;
+    }
+
+    memkv_slabs_t* s = infra_malloc(sizeof(memkv_slabs_t));
+    if (!s) {
+        return INFRA_ERROR_NO_MEMORY;
+    }
+    memset(s, 0, sizeof(memkv_slabs_t));
+    s->page_size = page_size;
+    s->mem_limit = mem_limit;
+    s->evict = evict;
+    s->ctx = ctx;
+
+    // class 1..n-2 按因子递增, 最后一个 class 一页一个 chunk
+    size_t size = min_chunk;
+    int n = 1;
+    while (n < MEMKV_SLAB_MAX_CLASSES - 1 && size <= page_size / factor) {
+        s->classes[n].size = size;
+        s->classes[n].perslab = (uint32_t)(page_size / size);
+        n++;
+        size_t next = align8((size_t)(size * factor));
+        size = next > size ? next : size + 8;
+    }
+    s->classes[n].size = page_size;
+    s->classes[n].perslab = 1;
+    s->nclasses = n + 1;
+
+    for (int i = 0; i < s->nclasses; i++) {
+        memkv_slab_class_t* cls = &s->classes[i];
+        cls->id = (uint32_t)i;
+        cls->slabs = s;
+        if (infra_mutex_create(&cls->mutex) != INFRA_OK) {
+            memkv_slabs_destroy(s);
+            return INFRA_ERROR_NO_MEMORY;
+        }
+    }
+
+    INFRA_LOG_DEBUG("memkv slabs: %d classes, factor %.2f, page %zu, limit %zu",
+                    s->nclasses - 1, factor, page_size, mem_limit);
+    *slabs = s;
+    return INFRA_OK;
+}
+
+// 调用前所有 item 都应已回收; 仍被引用的大 item 不在页内, 由最后的 release 释放
+void memkv_slabs_destroy(memkv_slabs_t* slabs) {
+    if (!slabs) {
+        return;
+    }
+    for (int i = 0; i < slabs->nclasses; i++) {
+        memkv_slab_class_t* cls = &slabs->classes[i];
+        memkv_slab_page_t* page = cls->pages;
+        while (page) {
+            memkv_slab_page_t* next = page->next;
+            infra_free(page);
+            page = next;
+        }
+        if (cls->mutex) {
+            infra_mutex_destroy(cls->mutex);
+        }
+    }
+    infra_free(slabs);
+}
+
+memkv_item_t* memkv_slabs_alloc(memkv_slabs_t* slabs, size_t ntotal) {
+    if (!slabs || ntotal < sizeof(memkv_item_t)) {
+        return NULL;
+    }
+
+    memkv_slab_class_t* cls = class_for(slabs, ntotal);
+    memkv_item_t* it = NULL;
+
+    infra_mutex_lock(cls->mutex);
+    if (cls->id == MEMKV_SLAB_LARGE) {
+        it = alloc_large(slabs, cls, ntotal);
+    } else {
+        if (!cls->free) {
+            class_grow(slabs, cls);
+        }
+        if (cls->free) {
+            it = cls->free;
+            cls->free = it->h_next;
+            cls->free_count--;
+        } else {
+            it = class_evict(slabs, cls);
+        }
+    }
+    if (it) {
+        cls->used++;
+    } else {
+        cls->outofmemory++;
+    }
+    infra_mutex_unlock(cls->mutex);
+
+    if (it) {
+        it->slab = cls;
+        it->prev = NULL;
+        it->next = NULL;
+    }
+    return it;
+}
+
+void memkv_slabs_free(memkv_item_t* item) {
+    memkv_slab_class_t* cls = item ? item->slab : NULL;
+    if (!cls) {
+        return;
+    }
+
+    infra_mutex_lock(cls->mutex);
+    cls->used--;
+    if (cls->id == MEMKV_SLAB_LARGE) {
+        __atomic_sub_fetch(&cls->slabs->mem_malloced, item_ntotal(item), __ATOMIC_RELAXED);
+        infra_free(item);
+    } else {
+        item->h_next = cls->free;
+        cls->free = item;
+        cls->free_count++;
+    }
+    infra_mutex_unlock(cls->mutex);
+}
+
+void memkv_slabs_lru_link(memkv_item_t* item, uint32_t now) {
+    memkv_slab_class_t* cls = item->slab;
+    if (!cls) {
+        return;
+    }
+    item->atime = now;
+    infra_mutex_lock(cls->mutex);
+    lru_push_head(cls, item);
+    infra_mutex_unlock(cls->mutex);
+}
+
+void memkv_slabs_lru_unlink(memkv_item_t* item) {
+    memkv_slab_class_t* cls = item->slab;
+    if (!cls) {
+        return;
+    }
+    infra_mutex_lock(cls->mutex);
+    lru_remove(cls, item);
+    infra_mutex_unlock(cls->mutex);
+}
+
+void memkv_slabs_lru_bump(memkv_item_t* item, uint32_t now) {
+    memkv_slab_class_t* cls = item->slab;
+    if (!cls || now - item->atime < MEMKV_SLAB_LRU_BUMP_INTERVAL) {
+        return;
+    }
+    item->atime = now;
+    infra_mutex_lock(cls->mutex);
+    if (cls->lru_head != item) {
+        lru_remove(cls, item);
+        lru_push_head(cls, item);
+    }
+    infra_mutex_unlock(cls->mutex);
+}
+
+int memkv_slabs_get_stats(memkv_slabs_t* slabs, memkv_slab_stats_t* stats, int max) {
+    if (!slabs || !stats) {
+        return 0;
+    }
+    int n = 0;
+    for (int i = 0; i < slabs->nclasses && n < max; i++) {
+        memkv_slab_class_t* cls = &slabs->classes[i];
+        memkv_slab_stats_t* st = &stats[n++];
+        infra_mutex_lock(cls->mutex);
+        st->id = cls->id;
+        st->chunk_size = cls->size;
+        st->chunks_per_page = cls->perslab;
+        st->total_pages = cls->page_count;
+        st->used_chunks = cls->used;
+        st->free_chunks = cls->free_count;
+        st->curr_items = cls->lru_count;
+        st->evictions = cls->evictions;
+        st->outofmemory = cls->outofmemory;
+        infra_mutex_unlock(cls->mutex);
+    }
+    return n;
+}
+
+size_t memkv_slabs_mem_limit(const memkv_slabs_t* slabs) {
+    return slabs ? slabs->mem_limit : 0;
+}
+
+uint64_t memkv_slabs_mem_malloced(const memkv_slabs_t* slabs) {
+    return slabs ? __atomic_load_n(&slabs->mem_malloced, __ATOMIC_RELAXED) : 0;
+}
@@ -0,0 +1,78 @@
+#ifndef PEER_MEMKV_SLABS_H_
+#define PEER_MEMKV_SLABS_H_
+
+#include "internal/infra/infra_core.h"
+#include "internal/infra/infra_error.h"
+#include "internal/peer/peer_memkv_store.h"
+
+//-----------------------------------------------------------------------------
+// MemKV slab 分配器
+//
+// item 按总长度落入大小按增长因子递增的 class, 每个 class 以页为单位向系统
+// 申请内存并切成等长 chunk, 释放的 chunk 挂回本 class 的空闲链表, 分配和释放
+// 都是 O(1), 反复写入也不会产生碎片.
+// 每个 class 有独立的 LRU, 总内存达到上限后从本 class 的 LRU 尾部淘汰.
+// 与 memcached 相同, 每个 class 即使超过上限也至少能分到一页.
+// 超过一页的 item 单独 malloc, 归入 large class, 同样计入上限并按 LRU 淘汰.
+//-----------------------------------------------------------------------------
+
+#define MEMKV_SLAB_PAGE_SIZE (1024 * 1024)
+#define MEMKV_SLAB_MAX_CLASSES 64
+#define MEMKV_SLAB_DEFAULT_FACTOR 1.25
+#define MEMKV_SLAB_MIN_FACTOR 1.01
+#define MEMKV_SLAB_LARGE 0           // large class 的编号, 普通 class 从 1 开始
+
+// 淘汰时从 LRU 尾部最多检查的 item 数 (跳过正被读取的 item)
+#define MEMKV_SLAB_EVICT_SEARCH 5
+
+// 同一 item 两次 LRU 提升的最小间隔 (秒), 避免每次读取都争用 class 锁
+#define MEMKV_SLAB_LRU_BUMP_INTERVAL 60
+
+typedef struct memkv_slabs memkv_slabs_t;
+
+// 淘汰回调: 在 class 锁内调用, 必须用 trylock 锁住 item 所在的哈希段,
+// 确认 item 仍挂在表上且只有表持有引用后把它从哈希表摘下 (不释放, 不动 LRU).
+// 成功返回 true, chunk 由分配器直接回收
+typedef bool (*memkv_slabs_evict_fn)(void* ctx, memkv_item_t* item);
+
+typedef struct memkv_slabs_config {
+    size_t mem_limit;            // 内存上限 (字节), 0 表示不限
+    double factor;               // class 大小增长因子, 0 使用默认值
+    size_t page_size;            // 页大小, 0 使用默认值
+} memkv_slabs_config_t;
+
+// 单个 class 的统计
+typedef struct memkv_slab_stats {
+    uint32_t id;
+    size_t chunk_size;
+    uint32_t chunks_per_page;
+    uint64_t total_pages;
+    uint64_t used_chunks;
+    uint64_t free_chunks;
+    uint64_t curr_items;         // LRU 中的 item 数
+    uint64_t evictions;
+    uint64_t outofmemory;        // 无法分配也无法淘汰的次数
+} memkv_slab_stats_t;
+
+infra_error_t memkv_slabs_create(const memkv_slabs_config_t* config, memkv_slabs_evict_fn evict,
+                                 void* ctx, memkv_slabs_t** slabs);
+void memkv_slabs_destroy(memkv_slabs_t* slabs);
+
+// 分配 ntotal 字节 (item 头 + key + value), 必要时淘汰; 失败返回 NULL.
+// 返回的 item 只设置了 slab 字段, 其余由调用者初始化
+memkv_item_t* memkv_slabs_alloc(memkv_slabs_t* slabs, size_t ntotal);
+
+// 回收引用计数归零的 item
+void memkv_slabs_free(memkv_item_t* item);
+
+// LRU 维护, 调用者持有 item 所在哈希段的锁; 非 slab 分配的 item 忽略
+void memkv_slabs_lru_link(memkv_item_t* item, uint32_t now);
+void memkv_slabs_lru_unlink(memkv_item_t* item);
+void memkv_slabs_lru_bump(memkv_item_t* item, uint32_t now);
+
+// 统计: 返回写入 stats 的 class 数 (含 large class), 总量见 mem_limit/mem_malloced/evictions
+int memkv_slabs_get_stats(memkv_slabs_t* slabs, memkv_slab_stats_t* stats, int max);
+size_t memkv_slabs_mem_limit(const memkv_slabs_t* slabs);
+uint64_t memkv_slabs_mem_malloced(const memkv_slabs_t* slabs);
+
+#endif /* PEER_MEMKV_SLABS_H_ */
@@ -0,0 +1,783 @@
+#include "internal/infra/infra_core.h"
+#include "internal/infra/infra_sync.h"
+#include "internal/infra/infra_log.h"
+#include "internal/peer/peer_memkv_store.h"
+#include "internal/peer/peer_memkv_slabs.h"
+
+//-----------------------------------------------------------------------------
+// Constants
+//-----------------------------------------------------------------------------
+
+#define MEMKV_STORE_INITIAL_BUCKETS 1024
+#define MEMKV_STORE_MAX_SEGMENTS 4096
+
+// 平均链长超过该值时扩容
+#define MEMKV_STORE_LOAD_FACTOR 2
+
+// 过期回收每次持有段锁时最多扫描的桶数, 扫完一批检查一次用时
+#define MEMKV_STORE_CRAWL_BATCH 64
+
+//-----------------------------------------------------------------------------
+// Types
+//-----------------------------------------------------------------------------
+
+typedef struct memkv_segment {
+    infra_mutex_t mutex;         // 段锁
+    memkv_item_t** buckets;      // 桶数组
+    size_t mask;                 // 桶数 - 1
+    uint64_t count;              // 段内 item 数
+    uint64_t bytes;              // 段内字节数
+    uint64_t total_items;
+    uint64_t get_hits;
+    uint64_t get_misses;
+    uint64_t expired;
+    uint64_t evictions;
+    uint64_t crawler_reclaimed;  // 后台回收的过期 item 数
+} memkv_segment_t;
+
+struct memkv_store {
+    memkv_segment_t* segments;
+    size_t segment_mask;
+    int segment_shift;           // 用哈希高位选段, 低位选桶
+    uint64_t next_cas;           // 全局 CAS 计数器 (原子操作)
+    memkv_slabs_t* slabs;        // item 内存
+    size_t crawl_segment;        // 过期回收的游标, 只由回收线程访问
+    size_t crawl_bucket;
+};
+
+//-----------------------------------------------------------------------------
+// Helper Functions
+//-----------------------------------------------------------------------------
+
+uint64_t memkv_hash(const char* key, size_t nkey) {
+    // FNV-1a 加 64 位 finalizer, key 较短时足够快且分布均匀
+    const unsigned char* p = (const unsigned char*)key;
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < nkey; i++) {
+        h ^= p[i];
+        h *= 0x100000001b3ULL;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return h;
+}
+
+static size_t round_up_pow2(size_t n) {
+    size_t v = 1;
+    while (v < n) {
+        v <<= 1;
+    }
+    return v;
+}
+
+static inline size_t item_total_size(const memkv_item_t* item) {
+    return sizeof(memkv_item_t) + item->nkey + item->nbytes;
+}
+
+static inline bool item_expired(const memkv_item_t* item, int64_t now) {
+    return item->exptime > 0 && now >= item->exptime;
+}
+
+static inline memkv_segment_t* segment_for(memkv_store_t* store, uint64_t hash) {
+    return &store->segments[(hash >> store->segment_shift) & store->segment_mask];
+}
+
+// 查找 key, 返回指向链表指针的指针, 便于删除
+static memkv_item_t** segment_find(memkv_segment_t* seg, uint64_t hash,
+                                   const char* key, size_t nkey) {
+    memkv_item_t** pp = &seg->buckets[hash & seg->mask];
+    while (*pp) {
+        memkv_item_t* it = *pp;
+        if (it->hash == hash && it->nkey == nkey &&
+            memcmp(MEMKV_ITEM_KEY(it), key, nkey) == 0) {
+            return pp;
+        }
+        pp = &it->h_next;
+    }
+    return pp;
+}
+
+// 只从哈希链摘下, 不动 LRU, 不释放表的引用
+static void segment_detach(memkv_segment_t* seg, memkv_item_t** pp) {
+    memkv_item_t* it = *pp;
+    *pp = it->h_next;
+    it->h_next = NULL;
+    // 其他线程的副本缓存不加锁检查该标志
+    __atomic_and_fetch(&it->it_flags, (uint8_t)~MEMKV_ITEM_LINKED, __ATOMIC_RELEASE);
+    seg->count--;
+    seg->bytes -= item_total_size(it);
+}
+
+static void segment_unlink(memkv_segment_t* seg, memkv_item_t** pp) {
+    memkv_item_t* it = *pp;
+    segment_detach(seg, pp);
+    memkv_slabs_lru_unlink(it);
+    memkv_item_release(it);
+}
+
+// slab 淘汰回调, 在 class 锁内调用; 段锁只能 trylock, 否则与 段锁 -> class 锁 的顺序相反
+static bool store_evict(void* ctx, memkv_item_t* item) {
+    memkv_store_t* store = (memkv_store_t*)ctx;
+    memkv_segment_t* seg = segment_for(store, item->hash);
+    if (infra_mutex_trylock(seg->mutex) != INFRA_OK) {
+        return false;
+    }
+
+    // 持有段锁后不会再有新的引用, 引用计数为 1 说明只有表持有
+    bool evicted = false;
+    if ((item->it_flags & MEMKV_ITEM_LINKED) &&
+        __atomic_load_n(&item->refcount, __ATOMIC_ACQUIRE) == 1) {
+        memkv_item_t** pp = segment_find(seg, item->hash, MEMKV_ITEM_KEY(item), item->nkey);
+        if (*pp == item) {
+            segment_detach(seg, pp);
+            if (item_expired(item, (int64_t)time(NULL))) {
+                seg->expired++;
+            } else {
+                seg->evictions++;
+            }
+            evicted = true;
+        }
+    }
+    infra_mutex_unlock(seg->mutex);
+    return evicted;
+}
+
+// 桶数翻倍, 在段锁内一次完成 (每段只占整表的一小部分)
+static void segment_grow(memkv_segment_t* seg) {
+    size_t old_size = seg->mask + 1;
+    size_t new_size = old_size * 2;
+    memkv_item_t** buckets = infra_calloc(new_size, sizeof(memkv_item_t*));
+    if (!buckets) {
+        INFRA_LOG_WARN("Failed to grow memkv segment to %zu buckets", new_size);
+        return;
+    }
+
+    for (size_t i = 0; i < old_size; i++) {
+        memkv_item_t* it = seg->buckets[i];
+        while (it) {
+            memkv_item_t* next = it->h_next;
+            size_t b = it->hash & (new_size - 1);
+            it->h_next = buckets[b];
+            buckets[b] = it;
+            it = next;
+        }
+    }
+
+    infra_free(seg->buckets);
+    seg->buckets = buckets;
+    seg->mask = new_size - 1;
+}
+
+//-----------------------------------------------------------------------------
+// Item Functions
+//-----------------------------------------------------------------------------
+
+static inline bool item_size_ok(const char* key, size_t nkey, size_t nbytes) {
+    return key && nkey > 0 && nkey <= MEMKV_STORE_MAX_KEY_LEN && nbytes <= UINT32_MAX;
+}
+
+static memkv_item_t* item_init(memkv_item_t* it, const char* key, size_t nkey, uint32_t flags,
+                               int64_t exptime, size_t nbytes) {
+    it->h_next = NULL;
+    it->prev = NULL;
+    it->next = NULL;
+    it->hash = memkv_hash(key, nkey);
+    it->cas = 0;
+    it->exptime = exptime;
+    it->flags = flags;
+    it->nbytes = (uint32_t)nbytes;
+    it->refcount = 1;
+    it->atime = 0;
+    it->nkey = (uint16_t)nkey;
+    it->it_flags = 0;
+    it->reserved = 0;
+    memcpy(MEMKV_ITEM_KEY(it), key, nkey);
+    return it;
+}
+
+memkv_item_t* memkv_item_alloc(const char* key, size_t nkey, uint32_t flags,
+                               int64_t exptime, size_t nbytes) {
+    if (!item_size_ok(key, nkey, nbytes)) {
+        return NULL;
+    }
+
+    memkv_item_t* it = infra_malloc(sizeof(memkv_item_t) + nkey + nbytes);
+    if (!it) {
+        return NULL;
+    }
+    it->slab = NULL;
+    return item_init(it, key, nkey, flags, exptime, nbytes);
+}
+
+memkv_item_t* memkv_store_item_alloc(memkv_store_t* store, const char* key, size_t nkey,
+                                     uint32_t flags, int64_t exptime, size_t nbytes) {
+    if (!store || !item_size_ok(key, nkey, nbytes)) {
+        return NULL;
+    }
+
+    memkv_item_t* it = memkv_slabs_alloc(store->slabs, sizeof(memkv_item_t) + nkey + nbytes);
+    if (!it) {
+        return NULL;
+    }
+    return item_init(it, key, nkey, flags, exptime, nbytes);
+}
+
+void memkv_item_ref(memkv_item_t* item) {
+    if (item) {
+        __atomic_add_fetch(&item->refcount, 1, __ATOMIC_RELAXED);
+    }
+}
+
+void memkv_item_release(memkv_item_t* item) {
+    if (item && __atomic_sub_fetch(&item->refcount, 1, __ATOMIC_ACQ_REL) == 0) {
+        if (item->slab) {
+            memkv_slabs_free(item);
+        } else {
+            infra_free(item);
+        }
+    }
+}
+
+bool memkv_item_live(const memkv_item_t* item, int64_t now) {
+    if (!(__atomic_load_n(&item->it_flags, __ATOMIC_ACQUIRE) & MEMKV_ITEM_LINKED)) {
+        return false;
+    }
+    int64_t exptime = __atomic_load_n(&item->exptime, __ATOMIC_RELAXED);
+    return exptime <= 0 || now < exptime;
+}
+
+int64_t memkv_store_realtime(int64_t exptime) {
+    if (exptime <= 0) {
+        return 0;
+    }
+    if (exptime > MEMKV_REALTIME_MAXDELTA) {
+        return exptime;
+    }
+    return (int64_t)time(NULL) + exptime;
+}
+
+//-----------------------------------------------------------------------------
+// Store Functions
+//-----------------------------------------------------------------------------
+
+infra_error_t memkv_store_create(const memkv_store_config_t* config, memkv_store_t** store) {
+    if (!store) {
+        return INFRA_ERROR_INVALID_PARAM;
+    }
+
+    size_t nseg = MEMKV_STORE_DEFAULT_SEGMENTS;
+    size_t nbuckets = MEMKV_STORE_INITIAL_BUCKETS;
+    if (config) {
+        if (config->segments > 0) nseg = (size_t)config->segments;
+        if (config->initial_buckets > 0) nbuckets = config->initial_buckets;
+    }
+    nseg = round_up_pow2(nseg);
+    if (nseg > MEMKV_STORE_MAX_SEGMENTS) nseg = MEMKV_STORE_MAX_SEGMENTS;
+    nbuckets = round_up_pow2(nbuckets);
+
+    memkv_store_t* s = infra_malloc(sizeof(memkv_store_t));
+    if (!s) {
+        return INFRA_ERROR_NO_MEMORY;
+    }
+    memset(s, 0, sizeof(memkv_store_t));
+
+    s->segments = infra_calloc(nseg, sizeof(memkv_segment_t));
+    if (!s->segments) {
+        infra_free(s);
+        return INFRA_ERROR_NO_MEMORY;
+    }
+    s->segment_mask = nseg - 1;
+    s->segment_shift = 64 - __builtin_ctzll(nseg);
+    if (nseg == 1) {
+        s->segment_shift = 0;
+    }
+    s->next_cas = 0;
+
+    memkv_slabs_config_t slabs_config = {0};
+    if (config) {
+        slabs_config.mem_limit = config->max_memory;
+        slabs_config.factor = config->growth_factor;
+    }
+    infra_error_t err = memkv_slabs_create(&slabs_config, store_evict, s, &s->slabs);
+    if (err != INFRA_OK) {
+        infra_free(s->segments);
+        infra_free(s);
+        return err;
+    }
+
+    for (size_t i = 0; i < nseg; i++) {
+        memkv_segment_t* seg = &s->segments[i];
+        seg->buckets = infra_calloc(nbuckets, sizeof(memkv_item_t*));
+        err = seg->buckets ? infra_mutex_create(&seg->mutex) : INFRA_ERROR_NO_MEMORY;
+        if (err != INFRA_OK) {
+            memkv_store_destroy(s);
+            return err;
+        }
+        seg->mask = nbuckets - 1;
+    }
+
+    *store = s;
+    return INFRA_OK;
+}
+
+void memkv_store_destroy(memkv_store_t* store) {
+    if (!store) {
+        return;
+    }
+
+    if (store->segments) {
+        for (size_t i = 0; i <= store->segment_mask; i++) {
+            memkv_segment_t* seg = &store->segments[i];
+            if (seg->buckets) {
+                for (size_t b = 0; b <= seg->mask; b++) {
+                    while (seg->buckets[b]) {
+                        segment_unlink(seg, &seg->buckets[b]);
+                    }
+                }
+                infra_free(seg->buckets);
+            }
+            if (seg->mutex) {
+                infra_mutex_destroy(seg->mutex);
+            }
+        }
+        infra_free(store->segments);
+    }
+    memkv_slabs_destroy(store->slabs);
+    infra_free(store);
+}
+
+infra_error_t memkv_store_get(memkv_store_t* store, const char* key, size_t nkey,
+                              memkv_item_t** item) {
+    if (!store || !key || nkey == 0 || !item) {
+        return INFRA_ERROR_INVALID_PARAM;
+    }
+
+    *item = NULL;
+    uint64_t hash = memkv_hash(key, nkey);
+    memkv_segment_t* seg = segment_for(store, hash);
+
+    infra_mutex_lock(seg->mutex);
+    memkv_item_t** pp = segment_find(seg, hash, key, nkey);
+    memkv_item_t* it = *pp;
+    if (it && item_expired(it, (int64_t)time(NULL))) {
+        segment_unlink(seg, pp);
+        seg->expired++;
+        it = NULL;
+    }
+    if (it) {
+        memkv_item_ref(it);
+        memkv_slabs_lru_bump(it, (uint32_t)time(NULL));
+        seg->get_hits++;
+    } else {
+        seg->get_misses++;
+    }
+    infra_mutex_unlock(seg->mutex);
+
+    if (!it) {
+        return INFRA_ERROR_NOT_FOUND;
+    }
+    *item = it;
+    return INFRA_OK;
+}
+
+// 把 item 挂到 pp 处 (替换 *pp 上的旧值), 调用者持有段锁
+static void segment_link(memkv_store_t* store, memkv_segment_t* seg, memkv_item_t** pp,
+                         memkv_item_t* item) {
+    if (*pp) {
+        segment_unlink(seg, pp);
+    }
+
+    // 表持有一次引用
+    memkv_item_ref(item);
+    item->cas = __atomic_add_fetch(&store->next_cas, 1, __ATOMIC_RELAXED);
+    __atomic_or_fetch(&item->it_flags, MEMKV_ITEM_LINKED, __ATOMIC_RELEASE);
+    item->h_next = seg->buckets[item->hash & seg->mask];
+    seg->buckets[item->hash & seg->mask] = item;
+    seg->count++;
+    seg->bytes += item_total_size(item);
+    seg->total_items++;
+    memkv_slabs_lru_link(item, (uint32_t)time(NULL));
+
+    if (seg->count > (seg->mask + 1) * MEMKV_STORE_LOAD_FACTOR) {
+        segment_grow(seg);
+    }
+}
+
+// 合并新旧 value, 新 item 沿用旧 item 的 flags 和过期时间
+// 在段锁内分配, 淘汰时对本段的 trylock 会失败, 不会摘下 old
+static memkv_item_t* item_concat(memkv_store_t* store, const memkv_item_t* old,
+                                 const memkv_item_t* item, bool append) {
+    memkv_item_t* it = memkv_store_item_alloc(store, MEMKV_ITEM_KEY(old), old->nkey, old->flags,
+                                              old->exptime, (size_t)old->nbytes + item->nbytes);
+    if (!it) {
+        return NULL;
+    }
+    const memkv_item_t* first = append ? old : item;
+    const memkv_item_t* second = append ? item : old;
+    memcpy(MEMKV_ITEM_VALUE(it), MEMKV_ITEM_VALUE(first), first->nbytes);
+    memcpy(MEMKV_ITEM_VALUE(it) + first->nbytes, MEMKV_ITEM_VALUE(second), second->nbytes);
+    return it;
+}
+
+infra_error_t memkv_store_set(memkv_store_t* store, memkv_item_t* item) {
+    return memkv_store_store(store, item, MEMKV_STORE_SET, 0, NULL);
+}
+
+infra_error_t memkv_store_store(memkv_store_t* store, memkv_item_t* item, memkv_store_mode_t mode,
+                                uint64_t cas, uint64_t* new_cas) {
+    if (!store || !item || (item->it_flags & MEMKV_ITEM_LINKED)) {
+        return INFRA_ERROR_INVALID_PARAM;
+    }
+
+    memkv_segment_t* seg = segment_for(store, item->hash);
+    infra_error_t err = INFRA_OK;
+
+    infra_mutex_lock(seg->mutex);
+    memkv_item_t** pp = segment_find(seg, item->hash, MEMKV_ITEM_KEY(item), item->nkey);
+    memkv_item_t* old = *pp;
+    if (old && item_expired(old, (int64_t)time(NULL))) {
+        segment_unlink(seg, pp);
+        seg->expired++;
+        old = NULL;
+    }
+
+    memkv_item_t* linked = item;
+    switch (mode) {
+        case MEMKV_STORE_SET:
+            break;
+        case MEMKV_STORE_ADD:
+            if (old) err = INFRA_ERROR_EXISTS;
+            break;
+        case MEMKV_STORE_REPLACE:
+            if (!old) err = INFRA_ERROR_NOT_FOUND;
+            break;
+        case MEMKV_STORE_CAS:
+            if (!old) {
+                err = INFRA_ERROR_NOT_FOUND;
+            } else if (old->cas != cas) {
+                err = INFRA_ERROR_CAS_MISMATCH;
+            }
+            break;
+        case MEMKV_STORE_APPEND:
+        case MEMKV_STORE_PREPEND:
+            if (!old) {
+                err = INFRA_ERROR_NOT_FOUND;
+            } else if ((size_t)old->nbytes + item->nbytes > UINT32_MAX) {
+                err = INFRA_ERROR_NO_SPACE;
+            } else {
+                linked = item_concat(store, old, item, mode == MEMKV_STORE_APPEND);
+                if (!linked) err = INFRA_ERROR_NO_MEMORY;
+            }
+            break;
+        default:
+            err = INFRA_ERROR_INVALID_PARAM;
+            break;
+    }
+
+    if (err == INFRA_OK) {
+        // 旧 item 过期时已被摘下, 重新定位插入位置
+        pp = segment_find(seg, item->hash, MEMKV_ITEM_KEY(item), item->nkey);
+        segment_link(store, seg, pp, linked);
+        if (new_cas) {
+            *new_cas = linked->cas;
+        }
+    }
+    infra_mutex_unlock(seg->mutex);
+
+    if (linked != item) {
+        // 合并出的 item 由表持有
+        memkv_item_release(linked);
+    }
+    return err;
+}
+
+// value 是否为十进制无符号整数 (不溢出 64 位)
+static bool value_to_u64(const char* p, size_t n, uint64_t* value) {
+    if (n == 0 || n > 20) {
+        return false;
+    }
+    uint64_t v = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (p[i] < '0' || p[i] > '9') {
+            return false;
+        }
+        uint64_t d = (uint64_t)(p[i] - '0');
+        if (v > (UINT64_MAX - d) / 10) {
+            return false;
+        }
+        v = v * 10 + d;
+    }
+    *value = v;
+    return true;
+}
+
+// 格式化为十进制, buf 至少 20 字节, 返回位数
+static size_t u64_to_text(uint64_t v, char* buf) {
+    char tmp[20];
+    size_t n = 0;
+    do {
+        tmp[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v > 0);
+    for (size_t i = 0; i < n; i++) {
+        buf[i] = tmp[n - 1 - i];
+    }
+    return n;
+}
+
+infra_error_t memkv_store_incr(memkv_store_t* store, const char* key, size_t nkey, uint64_t delta,
+                               bool incr, bool create, uint64_t initial, int64_t exptime,
+                               uint64_t* value, bool* created, uint64_t* new_cas) {
+    if (!store || !key || nkey == 0 || !value) {
+        return INFRA_ERROR_INVALID_PARAM;
+    }
+
+    uint64_t hash = memkv_hash(key, nkey);
+    memkv_segment_t* seg = segment_for(store, hash);
+    infra_error_t err = INFRA_OK;
+    memkv_item_t* fresh = NULL;
+    char text[20];
+
+    infra_mutex_lock(seg->mutex);
+    memkv_item_t** pp = segment_find(seg, hash, key, nkey);
+    memkv_item_t* it = *pp;
+    if (it && item_expired(it, (int64_t)time(NULL))) {
+        segment_unlink(seg, pp);
+        seg->expired++;
+        it = NULL;
+        pp = segment_find(seg, hash, key, nkey);
+    }
+
+    uint64_t current = 0;
+    if (!it) {
+        if (!create) {
+            err = INFRA_ERROR_NOT_FOUND;
+        } else {
+            current = initial;
+            size_t len = u64_to_text(current, text);
+            fresh = memkv_store_item_alloc(store, key, nkey, 0, exptime, len);
+            if (fresh) {
+                memcpy(MEMKV_ITEM_VALUE(fresh), text, len);
+            } else {
+                err = INFRA_ERROR_NO_MEMORY;
+            }
+        }
+    } else if (!value_to_u64(MEMKV_ITEM_VALUE(it), it->nbytes, &current)) {
+        err = INFRA_ERROR_INVALID_PARAM;
+    } else {
+        // incr 按 64 位回绕, decr 最小为 0 (memcached 语义)
+        if (incr) {
+            current += delta;
+        } else {
+            current = current < delta ? 0 : current - delta;
+        }
+        size_t len = u64_to_text(current, text);
+        if (len == it->nbytes && __atomic_load_n(&it->refcount, __ATOMIC_ACQUIRE) == 1) {
+            // 只有表持有且持有段锁, 没有读者能看到改写过程
+            memcpy(MEMKV_ITEM_VALUE(it), text, len);
+            it->cas = __atomic_add_fetch(&store->next_cas, 1, __ATOMIC_RELAXED);
+            memkv_slabs_lru_bump(it, (uint32_t)time(NULL));
+            if (new_cas) {
+                *new_cas = it->cas;
+            }
+        } else {
+            // 位数变化或正被读取时换成新 item, 沿用 flags 和过期时间;
+            // 在段锁内分配, 淘汰时对本段的 trylock 会失败, 不会摘下 it
+            fresh = memkv_store_item_alloc(store, key, nkey, it->flags, it->exptime, len);
+            if (fresh) {
+                memcpy(MEMKV_ITEM_VALUE(fresh), text, len);
+            } else {
+                err = INFRA_ERROR_NO_MEMORY;
+            }
+        }
+    }
+
+    if (fresh) {
+        segment_link(store, seg, pp, fresh);
+        if (new_cas) {
+            *new_cas = fresh->cas;
+        }
+    }
+    infra_mutex_unlock(seg->mutex);
+
+    if (fresh) {
+        memkv_item_release(fresh);
+    }
+    if (err == INFRA_OK) {
+        *value = current;
+        if (created) {
+            *created = !it;
+        }
+    }
+    return err;
+}
+
+infra_error_t memkv_store_touch(memkv_store_t* store, const char* key, size_t nkey,
+                                int64_t exptime, memkv_item_t** item) {
+    if (!store || !key || nkey == 0) {
+        return INFRA_ERROR_INVALID_PARAM;
+    }
+
+    uint64_t hash = memkv_hash(key, nkey);
+    memkv_segment_t* seg = segment_for(store, hash);
+
+    infra_mutex_lock(seg->mutex);
+    memkv_item_t** pp = segment_find(seg, hash, key, nkey);
+    memkv_item_t* it = *pp;
+    if (it && item_expired(it, (int64_t)time(NULL))) {
+        segment_unlink(seg, pp);
+        seg->expired++;
+        it = NULL;
+    }
+    if (it) {
+        __atomic_store_n(&it->exptime, exptime, __ATOMIC_RELAXED);
+        memkv_slabs_lru_bump(it, (uint32_t)time(NULL));
+        if (item) {
+            memkv_item_ref(it);
+            seg->get_hits++;
+        }
+    } else if (item) {
+        seg->get_misses++;
+    }
+    infra_mutex_unlock(seg->mutex);
+
+    if (!it) {
+        return INFRA_ERROR_NOT_FOUND;
+    }
+    if (item) {
+        *item = it;
+    }
+    return INFRA_OK;
+}
+
+infra_error_t memkv_store_delete(memkv_store_t* store, const char* key, size_t nkey, uint64_t cas) {
+    if (!store || !key || nkey == 0) {
+        return INFRA_ERROR_INVALID_PARAM;
+    }
+
+    uint64_t hash = memkv_hash(key, nkey);
+    memkv_segment_t* seg = segment_for(store, hash);
+    infra_error_t err = INFRA_ERROR_NOT_FOUND;
+
+    infra_mutex_lock(seg->mutex);
+    memkv_item_t** pp = segment_find(seg, hash, key, nkey);
+    if (*pp) {
+        // 已过期的 key 视为不存在
+        if (item_expired(*pp, (int64_t)time(NULL))) {
+            seg->expired++;
+            segment_unlink(seg, pp);
+        } else if (cas != 0 && (*pp)->cas != cas) {
+            err = INFRA_ERROR_CAS_MISMATCH;
+        } else {
+            err = INFRA_OK;
+            segment_unlink(seg, pp);
+        }
+    }
+    infra_mutex_unlock(seg->mutex);
+
+    return err;
+}
+
+infra_error_t memkv_store_flush(memkv_store_t* store) {
+    if (!store) {
+        return INFRA_ERROR_INVALID_PARAM;
+    }
+
+    for (size_t i = 0; i <= store->segment_mask; i++) {
+        memkv_segment_t* seg = &store->segments[i];
+        infra_mutex_lock(seg->mutex);
+        for (size_t b = 0; b <= seg->mask; b++) {
+            while (seg->buckets[b]) {
+                segment_unlink(seg, &seg->buckets[b]);
+            }
+        }
+        infra_mutex_unlock(seg->mutex);
+    }
+
+    return INFRA_OK;
+}
+
+size_t memkv_store_crawl(memkv_store_t* store, uint32_t budget_ms) {
+    if (!store) {
+        return 0;
+    }
+
+    uint64_t start = infra_time_ms();
+    int64_t now = (int64_t)time(NULL);
+    size_t reclaimed = 0;
+
+    // 每次调用最多扫完整张表一轮
+    size_t visited = 0;
+    while (visited <= store->segment_mask) {
+        memkv_segment_t* seg = &store->segments[store->crawl_segment];
+        bool segment_done = true;
+
+        // 段正被前台占用时跳过, 剩下的桶留到下一轮
+        if (infra_mutex_trylock(seg->mutex) == INFRA_OK) {
+            size_t end = store->crawl_bucket + MEMKV_STORE_CRAWL_BATCH;
+            if (end > seg->mask + 1) {
+                end = seg->mask + 1;
+            }
+            for (size_t b = store->crawl_bucket; b < end; b++) {
+                memkv_item_t** pp = &seg->buckets[b];
+                while (*pp) {
+                    if (item_expired(*pp, now)) {
+                        seg->expired++;
+                        seg->crawler_reclaimed++;
+                        segment_unlink(seg, pp);
+                        reclaimed++;
+                    } else {
+                        pp = &(*pp)->h_next;
+                    }
+                }
+            }
+            // 期间段可能扩容过, 按当前桶数判断是否扫完
+            segment_done = end > seg->mask;
+            infra_mutex_unlock(seg->mutex);
+            store->crawl_bucket = segment_done ? 0 : end;
+        } else {
+            store->crawl_bucket = 0;
+        }
+
+        if (segment_done) {
+            store->crawl_segment = (store->crawl_segment + 1) & store->segment_mask;
+            visited++;
+        }
+        if (infra_time_ms() - start >= budget_ms) {
+            break;
+        }
+    }
+
+    return reclaimed;
+}
+
+void memkv_store_get_stats(memkv_store_t* store, memkv_store_stats_t* stats) {
+    if (!stats) {
+        return;
+    }
+    memset(stats, 0, sizeof(memkv_store_stats_t));
+    if (!store) {
+        return;
+    }
+
+    for (size_t i = 0; i <= store->segment_mask; i++) {
+        memkv_segment_t* seg = &store->segments[i];
+        infra_mutex_lock(seg->mutex);
+        stats->curr_items += seg->count;
+        stats->bytes += seg->bytes;
+        stats->total_items += seg->total_items;
+        stats->get_hits += seg->get_hits;
+        stats->get_misses += seg->get_misses;
+        stats->expired += seg->expired;
+        stats->evictions += seg->evictions;
+        stats->crawler_reclaimed += seg->crawler_reclaimed;
+        infra_mutex_unlock(seg->mutex);
+    }
+    stats->limit_maxbytes = memkv_slabs_mem_limit(store->slabs);
+    stats->total_malloced = memkv_slabs_mem_malloced(store->slabs);
+}
+
+int memkv_store_get_slab_stats(memkv_store_t* store, memkv_slab_stats_t* stats, int max) {
+    return store ? memkv_slabs_get_stats(store->slabs, stats, max) : 0;
+}
@@ -0,0 +1,154 @@
+#ifndef PEER_MEMKV_STORE_H_
+#define PEER_MEMKV_STORE_H_
+
+#include "internal/infra/infra_core.h"
+#include "internal/infra/infra_error.h"
+
+//-----------------------------------------------------------------------------
+// MemKV 原生内存存储引擎
+//
+// 分段 (segment) 哈希表: 每个段有独立的锁和桶数组, 按需各自扩容.
+// item 一次分配, key 和 value 内联存放, 通过引用计数在表和读者之间共享,
+// 读路径不复制 value. item 内存来自 slab 分配器 (peer_memkv_slabs.h),
+// 达到内存上限时按 class 的 LRU 淘汰.
+//-----------------------------------------------------------------------------
+
+#define MEMKV_STORE_DEFAULT_SEGMENTS 64
+#define MEMKV_STORE_MAX_KEY_LEN 250
+
+// memcached 约定: 超过 30 天的 exptime 视为绝对时间戳
+#define MEMKV_REALTIME_MAXDELTA (60 * 60 * 24 * 30)
+
+// item 标志
+#define MEMKV_ITEM_LINKED 0x01   // 已挂在哈希表上
+
+typedef struct memkv_item {
+    struct memkv_item* h_next;   // 哈希链 (空闲时为 slab 空闲链表)
+    struct memkv_item* prev;     // slab class 的 LRU
+    struct memkv_item* next;
+    struct memkv_slab_class* slab; // 所属 slab class, NULL 表示直接 malloc
+    uint64_t hash;               // key 的哈希值
+    uint64_t cas;                // CAS 版本号
+    int64_t exptime;             // 绝对过期时间(秒), 0 表示不过期
+    uint32_t flags;              // 客户端标志
+    uint32_t nbytes;             // value 长度
+    uint32_t refcount;           // 引用计数 (原子操作)
+    uint32_t atime;              // 最近一次 LRU 提升的时间(秒)
+    uint16_t nkey;               // key 长度
+    uint8_t it_flags;            // MEMKV_ITEM_*
+    uint8_t reserved;
+    char data[];                 // key 后紧跟 value
+} memkv_item_t;
+
+#define MEMKV_ITEM_KEY(it)   ((it)->data)
+#define MEMKV_ITEM_VALUE(it) ((it)->data + (it)->nkey)
+
+typedef struct memkv_store memkv_store_t;
+struct memkv_slab_stats;
+
+// 写入模式 (memcached 存储命令)
+typedef enum {
+    MEMKV_STORE_SET = 0,         // 无条件写入
+    MEMKV_STORE_ADD,             // key 不存在时写入
+    MEMKV_STORE_REPLACE,         // key 存在时写入
+    MEMKV_STORE_APPEND,          // 追加到已有 value 之后
+    MEMKV_STORE_PREPEND,         // 插入到已有 value 之前
+    MEMKV_STORE_CAS              // CAS 匹配时写入
+} memkv_store_mode_t;
+
+// 存储配置
+typedef struct memkv_store_config {
+    int segments;                // 段数 (取整到 2 的幂), 0 使用默认值
+    size_t initial_buckets;      // 每段初始桶数, 0 使用默认值
+    size_t max_memory;           // item 内存上限 (字节), 0 表示不限
+    double growth_factor;        // slab class 增长因子, 0 使用默认值
+} memkv_store_config_t;
+
+// 统计信息
+typedef struct memkv_store_stats {
+    uint64_t curr_items;         // 当前 item 数
+    uint64_t total_items;        // 累计写入 item 数
+    uint64_t bytes;              // item 占用字节数
+    uint64_t get_hits;
+    uint64_t get_misses;
+    uint64_t expired;            // 过期回收数
+    uint64_t evictions;          // 因内存上限淘汰的 item 数
+    uint64_t crawler_reclaimed;  // 后台回收的过期 item 数 (含在 expired 中)
+    uint64_t limit_maxbytes;     // 内存上限, 0 表示不限
+    uint64_t total_malloced;     // slab 已申请的内存
+} memkv_store_stats_t;
+
+// 创建和销毁
+infra_error_t memkv_store_create(const memkv_store_config_t* config, memkv_store_t** store);
+void memkv_store_destroy(memkv_store_t* store);
+
+// 分配一个未挂表的 item (引用计数为 1), value 由调用者填充.
+// memkv_item_alloc 直接 malloc, 用于不入表的临时 item;
+// memkv_store_item_alloc 从 store 的 slab 分配, 内存不足且无法淘汰时返回 NULL
+memkv_item_t* memkv_item_alloc(const char* key, size_t nkey, uint32_t flags,
+                               int64_t exptime, size_t nbytes);
+memkv_item_t* memkv_store_item_alloc(memkv_store_t* store, const char* key, size_t nkey,
+                                     uint32_t flags, int64_t exptime, size_t nbytes);
+
+// 增加/释放引用, 计数归零时释放内存
+void memkv_item_ref(memkv_item_t* item);
+void memkv_item_release(memkv_item_t* item);
+
+// item 是否仍挂在表上且未过期, 可在不持有段锁时调用 (副本缓存)
+bool memkv_item_live(const memkv_item_t* item, int64_t now);
+
+// 把相对过期时间转换为绝对时间戳
+int64_t memkv_store_realtime(int64_t exptime);
+
+// 查找 key, 命中时 *item 增加一次引用, 用完需 memkv_item_release
+infra_error_t memkv_store_get(memkv_store_t* store, const char* key, size_t nkey,
+                              memkv_item_t** item);
+
+// 挂入 item, 替换同名旧值, 分配新的 CAS
+infra_error_t memkv_store_set(memkv_store_t* store, memkv_item_t* item);
+
+// 按模式写入, 检查和替换在同一次段锁内完成:
+//  INFRA_ERROR_EXISTS: add 时 key 已存在
+//  INFRA_ERROR_NOT_FOUND: replace/append/prepend/cas 时 key 不存在
+//  INFRA_ERROR_CAS_MISMATCH: cas 不匹配
+// append/prepend 另外分配合并后的 item, 沿用旧 item 的 flags 和过期时间, 传入的 item 不挂表.
+// 成功时 new_cas 非空则返回新 CAS
+infra_error_t memkv_store_store(memkv_store_t* store, memkv_item_t* item, memkv_store_mode_t mode,
+                                uint64_t cas, uint64_t* new_cas);
+
+// 数值增减, 读取, 计算和写回在同一次段锁内完成, 并发的 incr/decr 不会丢失更新.
+// value 仍以十进制文本存放 (读路径直接发送 value); 只有表持有引用且位数不变时原地改写,
+// 否则换成新 item, 沿用 flags 和过期时间. incr 按 64 位回绕, decr 最小为 0.
+// key 不存在且 create 为 true 时以 initial 创建, 过期时间为 exptime (绝对时间戳):
+//  INFRA_ERROR_NOT_FOUND: key 不存在且不创建
+//  INFRA_ERROR_INVALID_PARAM: 原 value 不是十进制无符号整数
+// 成功时 *value 为新值, created 非空则返回是否新建, new_cas 非空则返回新 CAS
+infra_error_t memkv_store_incr(memkv_store_t* store, const char* key, size_t nkey, uint64_t delta,
+                               bool incr, bool create, uint64_t initial, int64_t exptime,
+                               uint64_t* value, bool* created, uint64_t* new_cas);
+
+// 更新过期时间 (绝对时间戳), item 非空时返回持有引用的 item (gat)
+infra_error_t memkv_store_touch(memkv_store_t* store, const char* key, size_t nkey,
+                                int64_t exptime, memkv_item_t** item);
+
+// 删除 key, cas 非 0 时只删除 CAS 匹配的值, 不匹配返回 INFRA_ERROR_CAS_MISMATCH
+infra_error_t memkv_store_delete(memkv_store_t* store, const char* key, size_t nkey, uint64_t cas);
+
+// 清空所有 key
+infra_error_t memkv_store_flush(memkv_store_t* store);
+
+// 后台过期回收: 从上次停下的桶继续扫描, 摘下已过期的 item, 用时达到 budget_ms 后返回.
+// 段锁只 trylock, 前台正占用的段留到下一轮, 读写不会因回收而等待.
+// 同一时刻只能有一个线程调用, 返回本次回收的 item 数
+size_t memkv_store_crawl(memkv_store_t* store, uint32_t budget_ms);
+
+// 获取统计信息
+void memkv_store_get_stats(memkv_store_t* store, memkv_store_stats_t* stats);
+
+// 获取各 slab class 的统计, 返回 class 数
+int memkv_store_get_slab_stats(memkv_store_t* store, struct memkv_slab_stats* stats, int max);
+
+// key 哈希
+uint64_t memkv_hash(const char* key, size_t nkey);
+
+#endif /* PEER_MEMKV_STORE_H_ */
@@ -7,15 +7,31 @@
 #include "internal/poly/poly_poll.h"
 #include "internal/peer/peer_service.h"
 #include "internal/peer/peer_sqlite3.h"
+#include "internal/peer/peer_sqlite3_proto.h"
 #include <sys/socket.h>
+#include <sys/uio.h>
 
 //-----------------------------------------------------------------------------
 // Constants
 //-----------------------------------------------------------------------------
 
 #define SQLITE3_MAX_PATH_LEN 256
-#define SQLITE3_MAX_SQL_LEN 4096
 #define SQLITE3_MAX_CONNECTIONS 128
+// 接收缓冲区初始大小, 放不下一个请求帧时按需扩大, 处理完后收缩回来
+#define SQLITE3_CONN_RX_INIT (16 * 1024)
+// 待发送的结果达到该值时写出, 等客户端读走后才继续读游标
+#define SQLITE3_SEND_BATCH (64 * 1024)
+// 客户端一直不读结果时的超时(毫秒)
+#define SQLITE3_SEND_TIMEOUT_MS 60000
+// 等待空闲读连接或写连接的超时(毫秒), 与 busy_timeout 一致
+#define SQLITE3_DB_WAIT_MS 5000
+// 持有写连接时客户端不读结果的超时(毫秒), 超时断开连接并回滚.
+// 其他写语句最多也只等这么久, 不让一个慢客户端拖住整个服务
+#define SQLITE3_HELD_SEND_TIMEOUT_MS SQLITE3_DB_WAIT_MS
+// 持有写连接时缓存的结果上限, 超过后才在持有写连接的情况下发送
+#define SQLITE3_HELD_BUFFER_MAX (4 * 1024 * 1024)
+// 读连接池的上限
+#define SQLITE3_MAX_READERS 16
 #define SQLITE3_DEFAULT_CONFIG_FILE "./sqlite3.conf"
 #define SQLITE3_MAX_HOST_LEN 64
 
@@ -26,8 +42,12 @@
 // Connection state
 typedef struct {
     infra_socket_t client;              // Client socket
-    poly_db_t* db;                      // Database connection
-    char buffer[SQLITE3_MAX_SQL_LEN];   // SQL buffer
+    bool writer_held;                   // 显式事务未结束, 一直持有写连接
+    char* rx_buf;                       // 接收缓冲区, 存放未处理完的请求帧
+    size_t rx_len;
+    size_t rx_cap;
+    sqlite3_proto_buf_t out;            // 待发送的响应帧
+    poly_poll_t* wpoll;                 // 发送阻塞时等待可写
     volatile bool is_closing;           // Connection closing flag
 } sqlite3_conn_t;
 
@@ -41,6 +61,15 @@ typedef struct {
     volatile bool running;              // Service running flag
     infra_mutex_t mutex;                // Service mutex
     poly_poll_context_t* poll_ctx;      // Poll context
+    // 所有客户端共用的数据库连接, 由 mutex 保护
+    poly_db_t* writer;                  // 唯一的写连接, 同一时刻只归一个客户端
+    bool writer_busy;
+    infra_cond_t writer_cond;
+    poly_db_t** readers;                // 只读连接池, 查询并发执行
+    int reader_count;
+    poly_db_t** idle_readers;           // 空闲读连接栈
+    int idle_count;
+    infra_cond_t reader_cond;
 } sqlite3_state_t;
 
 // 获取服务状态的辅助函数
@@ -95,6 +124,162 @@ infra_error_t sqlite3_apply_config(const poly_service_config_t* config) {
     return INFRA_OK;
 }
 
+//-----------------------------------------------------------------------------
+// Database pool
+//
+// 一个写连接加若干只读连接 (WAL 模式下读写互不阻塞). 写语句排队使用写连接,
+// 由服务串行执行, 不再在 SQLite 的文件锁上竞争; 查询从池中取空闲读连接并发执行.
+//-----------------------------------------------------------------------------
+
+static int reader_configured_count(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    if (n < 1) n = 1;
+    if (n > SQLITE3_MAX_READERS) n = SQLITE3_MAX_READERS;
+    return (int)n;
+}
+
+static poly_db_t* db_pool_open_one(const char* path, bool read_only) {
+    poly_db_config_t config = {
+        .type = POLY_DB_TYPE_SQLITE,
+        .url = path,
+        .max_memory = 100 * 1024 * 1024,  // 100MB 内存限制
+        .read_only = read_only,
+        .plugin_path = NULL,
+        .allow_fallback = false
+    };
+    poly_db_t* db = NULL;
+    if (poly_db_open(&config, &db) != INFRA_OK) {
+        INFRA_LOG_ERROR("Failed to open database: %s", path);
+        return NULL;
+    }
+
+    // 写连接负责把数据库切到 WAL 模式 (持久化在文件中), 读连接打开时已是 WAL
+    const char* pragmas[] = {
+        read_only ? NULL : "PRAGMA journal_mode=WAL;",
+        "PRAGMA busy_timeout=5000;",
+        "PRAGMA cache_size=2000;",                     // 2000 pages = ~8MB cache
+        read_only ? NULL : "PRAGMA synchronous=NORMAL;" // 提高写入性能
+    };
+    for (size_t i = 0; i < sizeof(pragmas) / sizeof(pragmas[0]); i++) {
+        if (pragmas[i] && poly_db_exec(db, pragmas[i]) != INFRA_OK) {
+            INFRA_LOG_ERROR("Failed to execute %s", pragmas[i]);
+            poly_db_close(db);
+            return NULL;
+        }
+    }
+    return db;
+}
+
+static void db_pool_close(sqlite3_state_t* state) {
+    for (int i = 0; i < state->reader_count; i++) {
+        poly_db_close(state->readers[i]);
+    }
+    infra_free(state->readers);
+    infra_free(state->idle_readers);
+    state->readers = NULL;
+    state->idle_readers = NULL;
+    state->reader_count = 0;
+    state->idle_count = 0;
+    if (state->writer) {
+        poly_db_close(state->writer);
+        state->writer = NULL;
+    }
+    state->writer_busy = false;
+}
+
+static infra_error_t db_pool_open(sqlite3_state_t* state) {
+    if (state->writer) {
+        return INFRA_OK;
+    }
+
+    INFRA_LOG_INFO("Opening database: %s", state->db_path);
+    // 先打开写连接: 数据库文件不存在时由它创建, 只读连接才能打开
+    state->writer = db_pool_open_one(state->db_path, false);
+    if (!state->writer) {
+        return INFRA_ERROR_OPEN_FAILED;
+    }
+
+    // 内存数据库无法被其他连接以私有缓存打开, 全部语句走写连接
+    if (!state->db_path[0] || strcmp(state->db_path, ":memory:") == 0) {
+        INFRA_LOG_INFO("In-memory database, reader pool disabled");
+        return INFRA_OK;
+    }
+
+    int count = reader_configured_count();
+    state->readers = infra_malloc(count * sizeof(poly_db_t*));
+    state->idle_readers = infra_malloc(count * sizeof(poly_db_t*));
+    if (!state->readers || !state->idle_readers) {
+        db_pool_close(state);
+        return INFRA_ERROR_NO_MEMORY;
+    }
+    for (int i = 0; i < count; i++) {
+        poly_db_t* db = db_pool_open_one(state->db_path, true);
+        if (!db) {
+            db_pool_close(state);
+            return INFRA_ERROR_OPEN_FAILED;
+        }
+        state->readers[state->reader_count++] = db;
+        state->idle_readers[state->idle_count++] = db;
+    }
+
+    INFRA_LOG_INFO("Database pool ready: 1 writer, %d readers", state->reader_count);
+    return INFRA_OK;
+}
+
+// 取一个空闲读连接; 没有读连接池或等待超时时返回 NULL, 语句改走写连接
+static poly_db_t* db_pool_acquire_reader(sqlite3_state_t* state) {
+    if (state->reader_count == 0) {
+        return NULL;
+    }
+    infra_mutex_lock(state->mutex);
+    poly_db_t* db = NULL;
+    uint64_t deadline = infra_time_ms() + SQLITE3_DB_WAIT_MS;
+    while (state->idle_count == 0 && state->running) {
+        uint64_t now = infra_time_ms();
+        if (now >= deadline) break;
+        infra_cond_timedwait(state->reader_cond, state->mutex, (uint32_t)(deadline - now));
+    }
+    if (state->idle_count > 0) {
+        db = state->idle_readers[--state->idle_count];
+    }
+    infra_mutex_unlock(state->mutex);
+    return db;
+}
+
+static void db_pool_release_reader(sqlite3_state_t* state, poly_db_t* db) {
+    infra_mutex_lock(state->mutex);
+    state->idle_readers[state->idle_count++] = db;
+    infra_cond_signal(state->reader_cond);
+    infra_mutex_unlock(state->mutex);
+}
+
+// 写语句排队等待写连接, 超时返回 INFRA_ERROR_BUSY
+static infra_error_t db_pool_acquire_writer(sqlite3_state_t* state) {
+    infra_mutex_lock(state->mutex);
+    infra_error_t err = INFRA_OK;
+    uint64_t deadline = infra_time_ms() + SQLITE3_DB_WAIT_MS;
+    while (state->writer_busy) {
+        uint64_t now = infra_time_ms();
+        if (now >= deadline || !state->running) {
+            err = INFRA_ERROR_BUSY;
+            break;
+        }
+        infra_cond_timedwait(state->writer_cond, state->mutex, (uint32_t)(deadline - now));
+    }
+    if (err == INFRA_OK) {
+        state->writer_busy = true;
+    }
+    infra_mutex_unlock(state->mutex);
+    return err;
+}
+
+static void db_pool_release_writer(sqlite3_state_t* state) {
+    infra_mutex_lock(state->mutex);
+    state->writer_busy = false;
+    infra_cond_signal(state->writer_cond);
+    infra_mutex_unlock(state->mutex);
+}
+
 //-----------------------------------------------------------------------------
 // Connection handling
 //-----------------------------------------------------------------------------
@@ -111,10 +296,8 @@ static sqlite3_conn_t* sqlite3_conn_create(infra_socket_t client) {
         INFRA_LOG_ERROR("Failed to allocate connection");
         return NULL;
     }
-    
-    conn->client = client;
-    conn->db = NULL;
-    conn->is_closing = false;
+    memset(conn, 0, sizeof(sqlite3_conn_t));
+    sqlite3_proto_buf_init(&conn->out);
     
     // 设置 socket 为非阻塞模式
     infra_error_t err = infra_net_set_nonblock(client, true);
@@ -124,69 +307,25 @@ static sqlite3_conn_t* sqlite3_conn_create(infra_socket_t client) {
         return NULL;
     }
 
-    // Open database connection using poly_db with shared cache
-    poly_db_config_t config = {
-        .type = POLY_DB_TYPE_SQLITE,
-        .url = state->db_path,
-        .max_memory = 100 * 1024 * 1024,  // 100MB 内存限制
-        .read_only = false,
-        .plugin_path = NULL,
-        .allow_fallback = false
-    };
-    
-    INFRA_LOG_INFO("Opening database: %s", state->db_path);
-    
-    err = poly_db_open(&config, &conn->db);
-    if (err != INFRA_OK) {
-        INFRA_LOG_ERROR("Failed to open database connection: %d", err);
-        infra_free(conn);
-        return NULL;
-    }
-
-    // 启用 WAL 模式以提高并发性能
-    err = poly_db_exec(conn->db, "PRAGMA journal_mode=WAL;");
-    if (err != INFRA_OK) {
-        INFRA_LOG_ERROR("Failed to enable WAL mode");
-        poly_db_close(conn->db);
+    conn->rx_buf = infra_malloc(SQLITE3_CONN_RX_INIT);
+    if (!conn->rx_buf) {
+        INFRA_LOG_ERROR("Failed to allocate receive buffer");
         infra_free(conn);
         return NULL;
     }
+    conn->rx_cap = SQLITE3_CONN_RX_INIT;
 
-    // 设置较短的超时和重试
-    err = poly_db_exec(conn->db, "PRAGMA busy_timeout=5000;");
-    if (err != INFRA_OK) {
-        INFRA_LOG_ERROR("Failed to set busy timeout");
-        poly_db_close(conn->db);
+    if (poly_poll_create(&conn->wpoll) != INFRA_OK ||
+        poly_poll_add(conn->wpoll, client, POLLOUT | POLLERR | POLLHUP) != INFRA_OK) {
+        INFRA_LOG_ERROR("Failed to create write poll");
+        if (conn->wpoll) poly_poll_destroy(conn->wpoll);
+        infra_free(conn->rx_buf);
         infra_free(conn);
         return NULL;
     }
 
-    // 设置共享缓存模式
-    err = poly_db_exec(conn->db, "PRAGMA cache_size=2000;");  // 2000 pages = ~8MB cache
-    if (err != INFRA_OK) {
-        INFRA_LOG_ERROR("Failed to set cache size");
-        poly_db_close(conn->db);
-        infra_free(conn);
-        return NULL;
-    }
-
-    err = poly_db_exec(conn->db, "PRAGMA synchronous=NORMAL;");  // 提高写入性能
-    if (err != INFRA_OK) {
-        INFRA_LOG_ERROR("Failed to set synchronous mode");
-        poly_db_close(conn->db);
-        infra_free(conn);
-        return NULL;
-    }
-
-    err = poly_db_exec(conn->db, "PRAGMA locking_mode=NORMAL;");  // 使用正常的锁定模式
-    if (err != INFRA_OK) {
-        INFRA_LOG_ERROR("Failed to set locking mode");
-        poly_db_close(conn->db);
-        infra_free(conn);
-        return NULL;
-    }
-    
-    INFRA_LOG_INFO("Database connection established");
+    // 创建成功后 socket 才归连接所有, 由 sqlite3_conn_destroy 关闭
+    conn->client = client;
     return conn;
 }
 
@@ -202,24 +341,34 @@ static void sqlite3_conn_destroy(sqlite3_conn_t* conn) {
     }
     conn->is_closing = true;
 
-    INFRA_LOG_DEBUG("Destroying connection: client=%ld, db=%p", conn->client, conn->db);
+    INFRA_LOG_DEBUG("Destroying connection: client=%ld", conn->client);
 
-    // Close database connection using poly_db
-    if (conn->db) {
-        INFRA_LOG_DEBUG("Closing database connection");
-        poly_db_close(conn->db);
-        conn->db = NULL;
+    // 客户端断开时事务还没结束, 回滚后归还写连接
+    if (conn->writer_held) {
+        sqlite3_state_t* state = get_state();
+        INFRA_LOG_INFO("Rolling back unfinished transaction");
+        if (state && state->writer) {
+            poly_db_exec(state->writer, "ROLLBACK");
+            db_pool_release_writer(state);
+        }
+        conn->writer_held = false;
     }
 
     if (conn->client) {
-        INFRA_LOG_DEBUG("Clearing client socket reference");
+        INFRA_LOG_DEBUG("Closing client socket");
+        infra_net_close(conn->client);
         conn->client = 0;
     }
 
-    // Verify cleanup
-    if (conn->db != NULL) {
-        INFRA_LOG_ERROR("Database connection not properly cleaned up");
+    if (conn->wpoll) {
+        poly_poll_destroy(conn->wpoll);
+        conn->wpoll = NULL;
     }
+    infra_free(conn->rx_buf);
+    conn->rx_buf = NULL;
+    sqlite3_proto_buf_destroy(&conn->out);
+
+    // Verify cleanup
     if (conn->client != 0) {
         INFRA_LOG_ERROR("Client socket reference not properly cleaned up");
     }
@@ -232,6 +381,281 @@ static void sqlite3_conn_destroy(sqlite3_conn_t* conn) {
 // Request handling
 //-----------------------------------------------------------------------------
 
+// 把待发送的响应全部写出. socket 写满时在这里等待可写, 游标不会继续前进,
+// 查询按客户端读取的速度推进, 服务端只缓存一批结果.
+// 持有写连接时只等 SQLITE3_HELD_SEND_TIMEOUT_MS, 超时断开由 sqlite3_conn_destroy 回滚
+static bool conn_flush(sqlite3_conn_t* conn) {
+    sqlite3_state_t* state = get_state();
+    int timeout_ms = conn->writer_held ? SQLITE3_HELD_SEND_TIMEOUT_MS : SQLITE3_SEND_TIMEOUT_MS;
+    size_t total_sent = 0;
+    int stalled_ms = 0;
+
+    while (total_sent < conn->out.len) {
+        struct iovec iov = {conn->out.data + total_sent, conn->out.len - total_sent};
+        size_t sent = 0;
+        infra_error_t err = infra_net_sendv(conn->client, &iov, 1, &sent);
+        if (err == INFRA_OK) {
+            total_sent += sent;
+            stalled_ms = 0;
+            continue;
+        }
+        if (err != INFRA_ERROR_WOULD_BLOCK) {
+            INFRA_LOG_ERROR("Failed to send response: %d", err);
+            return false;
+        }
+        if (!state || !state->running || stalled_ms >= timeout_ms) {
+            INFRA_LOG_ERROR("Client stopped reading, dropping connection");
+            return false;
+        }
+
+        poly_poll_wait(conn->wpoll, 1000);
+        int events = 0;
+        poly_poll_get_events(conn->wpoll, 0, &events);
+        if (events & (POLLERR | POLLHUP)) {
+            return false;
+        }
+        if (!(events & POLLOUT)) {
+            stalled_ms += 1000;
+        }
+    }
+
+    conn->out.len = 0;
+    return true;
+}
+
+static void conn_put_error(sqlite3_conn_t* conn, infra_error_t code, const char* message) {
+    size_t frame = sqlite3_proto_begin(&conn->out, SQLITE3_MSG_ERROR);
+    sqlite3_proto_put_u32(&conn->out, (uint32_t)code);
+    sqlite3_proto_put_bytes(&conn->out, message, strlen(message));
+    sqlite3_proto_end(&conn->out, frame);
+}
+
+// 执行一条语句: 逐行读游标直接编码进输出缓冲区, 攒满一批就发出.
+// 在写连接上执行时先缓存结果, 归还写连接后再发送, 客户端读得慢不会拖住其他写语句;
+// 缓存超过 SQLITE3_HELD_BUFFER_MAX 才边持有边发送, 这时按较短的超时发送.
+// 返回 INFRA_ERROR_CLOSED 表示连接已不可用, 其他错误由调用者回复 E
+static infra_error_t conn_stream(sqlite3_conn_t* conn, poly_db_t* db, poly_db_cursor_t* cursor) {
+    sqlite3_proto_buf_t* out = &conn->out;
+    size_t flush_at = conn->writer_held ? SQLITE3_HELD_BUFFER_MAX : SQLITE3_SEND_BATCH;
+    int columns = poly_db_cursor_column_count(cursor);
+    if (columns > 0) {
+        size_t frame = sqlite3_proto_begin(out, SQLITE3_MSG_ROW_DESC);
+        sqlite3_proto_put_u16(out, (uint16_t)columns);
+        for (int i = 0; i < columns; i++) {
+            const char* name = poly_db_cursor_column_name(cursor, i);
+            size_t len = name ? strlen(name) : 0;
+            sqlite3_proto_put_u16(out, (uint16_t)(len > UINT16_MAX ? UINT16_MAX : len));
+            sqlite3_proto_put_bytes(out, name, len > UINT16_MAX ? UINT16_MAX : len);
+        }
+        sqlite3_proto_end(out, frame);
+    }
+
+    uint64_t rows = 0;
+    size_t batch = 0;
+    uint32_t batch_rows = 0;
+    infra_error_t err;
+    while ((err = poly_db_cursor_next(cursor)) == INFRA_OK) {
+        if (batch_rows == 0) {
+            batch = sqlite3_proto_begin(out, SQLITE3_MSG_DATA);
+            sqlite3_proto_put_u32(out, 0);
+        }
+        for (int i = 0; i < columns; i++) {
+            poly_db_value_t value;
+            poly_db_cursor_column(cursor, i, &value);
+            sqlite3_proto_put_value(out, &value);
+        }
+        batch_rows++;
+        rows++;
+
+        if (batch_rows >= SQLITE3_PROTO_BATCH_ROWS || out->len - batch >= SQLITE3_SEND_BATCH) {
+            sqlite3_proto_set_u32(out, batch + SQLITE3_PROTO_HEADER, batch_rows);
+            sqlite3_proto_end(out, batch);
+            batch_rows = 0;
+            if (out->failed) return INFRA_ERROR_NO_MEMORY;
+            if (out->len >= flush_at && !conn_flush(conn)) return INFRA_ERROR_CLOSED;
+        }
+    }
+    if (batch_rows > 0) {
+        sqlite3_proto_set_u32(out, batch + SQLITE3_PROTO_HEADER, batch_rows);
+        sqlite3_proto_end(out, batch);
+    }
+    if (err != INFRA_ERROR_NOT_FOUND) {
+        return err;
+    }
+
+    if (columns == 0) {
+        poly_db_changes(db, &rows);
+    }
+    size_t frame = sqlite3_proto_begin(out, SQLITE3_MSG_COMPLETE);
+    sqlite3_proto_put_u64(out, rows);
+    sqlite3_proto_end(out, frame);
+    return out->failed ? INFRA_ERROR_NO_MEMORY : INFRA_OK;
+}
+
+// 打开 sql 开头的一条语句并选择执行的连接. 事务中的语句都走写连接, 保证能读到
+// 本事务未提交的修改; 查询先在读连接上编译, 确认不修改数据库 (排除 WITH ... INSERT)
+// 且有结果列 (排除 BEGIN 等事务控制语句) 后在读连接上执行, 否则改到写连接.
+// 成功时 *db 为语句所在的连接, 用完后调用 conn_release_db
+static infra_error_t conn_open_statement(sqlite3_conn_t* conn, const char* sql, const char* end,
+                                         poly_db_cursor_t** cursor, const char** tail, poly_db_t** db) {
+    sqlite3_state_t* state = get_state();
+    *db = NULL;
+
+    if (!conn->writer_held && sqlite3_sql_is_query(sql, end)) {
+        poly_db_t* reader = db_pool_acquire_reader(state);
+        if (reader) {
+            infra_error_t err = poly_db_cursor_open_script(reader, sql, (size_t)(end - sql), cursor, tail);
+            if (err == INFRA_OK && poly_db_cursor_readonly(*cursor) &&
+                poly_db_cursor_column_count(*cursor) > 0) {
+                *db = reader;
+                return INFRA_OK;
+            }
+            // 写语句, 或在读连接上编译失败 (例如引用写连接上的临时表), 交给写连接
+            if (err == INFRA_OK) {
+                poly_db_cursor_close(*cursor);
+                *cursor = NULL;
+            }
+            db_pool_release_reader(state, reader);
+        }
+    }
+
+    if (!conn->writer_held) {
+        infra_error_t err = db_pool_acquire_writer(state);
+        if (err != INFRA_OK) {
+            return err;
+        }
+        conn->writer_held = true;
+    }
+    *db = state->writer;
+    return poly_db_cursor_open_script(state->writer, sql, (size_t)(end - sql), cursor, tail);
+}
+
+// 语句执行完后归还连接; 写连接上开启了事务时继续持有, 直到 COMMIT/ROLLBACK
+static void conn_release_db(sqlite3_conn_t* conn, poly_db_t* db) {
+    sqlite3_state_t* state = get_state();
+    if (db != state->writer) {
+        db_pool_release_reader(state, db);
+        return;
+    }
+    if (!poly_db_in_transaction(db)) {
+        conn->writer_held = false;
+        db_pool_release_writer(state);
+    }
+}
+
+// 依次执行一个请求中的全部语句, 出错时回复 E 并跳过剩余语句, 最后回复 Z
+static bool conn_execute(sqlite3_conn_t* conn, const char* sql, size_t len) {
+    const char* end = sql + len;
+    // 剩余部分只有空白或注释时直接结束, 不必为此占用写连接
+    while ((sql = sqlite3_sql_skip_space(sql, end)) < end) {
+        poly_db_cursor_t* cursor = NULL;
+        const char* tail = NULL;
+        poly_db_t* db = NULL;
+        infra_error_t err = conn_open_statement(conn, sql, end, &cursor, &tail, &db);
+        if (err != INFRA_OK) {
+            if (err == INFRA_ERROR_BUSY) {
+                conn_put_error(conn, err, "database is busy");
+            } else if (err != INFRA_ERROR_NOT_FOUND) {
+                conn_put_error(conn, err, poly_db_get_error_message(db));
+            }
+            if (db) conn_release_db(conn, db);
+            break;
+        }
+        sql = tail;
+
+        err = conn_stream(conn, db, cursor);
+        poly_db_cursor_close(cursor);
+        if (err != INFRA_OK && err != INFRA_ERROR_CLOSED) {
+            // 输出缓冲区扩大失败时丢掉已编码的部分, 只回复错误
+            if (conn->out.failed) {
+                conn->out.failed = false;
+                conn->out.len = 0;
+                conn_put_error(conn, err, "out of memory");
+            } else {
+                conn_put_error(conn, err, poly_db_get_error_message(db));
+            }
+        }
+        conn_release_db(conn, db);
+        if (err == INFRA_ERROR_CLOSED) {
+            return false;
+        }
+        if (err != INFRA_OK) {
+            break;
+        }
+    }
+
+    size_t frame = sqlite3_proto_begin(&conn->out, SQLITE3_MSG_READY);
+    sqlite3_proto_end(&conn->out, frame);
+    return !conn->out.failed && conn_flush(conn);
+}
+
+// 处理接收缓冲区中所有完整的请求帧, 返回 false 表示应关闭连接
+static bool conn_process(sqlite3_conn_t* conn) {
+    size_t pos = 0;
+    bool keep = true;
+    while (keep && pos < conn->rx_len) {
+        sqlite3_frame_t frame;
+        size_t consumed = 0;
+        size_t need = 0;
+        infra_error_t err = sqlite3_proto_parse(conn->rx_buf + pos, conn->rx_len - pos,
+                                                &frame, &consumed, &need);
+        if (err == INFRA_ERROR_WOULD_BLOCK) {
+            // 大请求未到齐, 扩大接收缓冲区到能放下整帧
+            if (need > conn->rx_cap) {
+                memmove(conn->rx_buf, conn->rx_buf + pos, conn->rx_len - pos);
+                conn->rx_len -= pos;
+                pos = 0;
+                char* rx = infra_realloc(conn->rx_buf, need);
+                if (!rx) {
+                    conn_put_error(conn, INFRA_ERROR_NO_MEMORY, "request too large");
+                    conn_flush(conn);
+                    return false;
+                }
+                conn->rx_buf = rx;
+                conn->rx_cap = need;
+            }
+            break;
+        }
+        if (err != INFRA_OK) {
+            conn_put_error(conn, err, "frame too large");
+            conn_flush(conn);
+            return false;
+        }
+
+        switch (frame.type) {
+            case SQLITE3_MSG_QUERY:
+                keep = conn_execute(conn, frame.payload, frame.len);
+                break;
+            case SQLITE3_MSG_TERMINATE:
+                keep = false;
+                break;
+            default:
+                conn_put_error(conn, INFRA_ERROR_PROTOCOL, "unknown message type");
+                conn_flush(conn);
+                keep = false;
+                break;
+        }
+        pos += consumed;
+    }
+    if (!keep) {
+        return false;
+    }
+
+    if (pos > 0) {
+        memmove(conn->rx_buf, conn->rx_buf + pos, conn->rx_len - pos);
+        conn->rx_len -= pos;
+    }
+    // 大请求处理完后收缩回初始大小
+    if (conn->rx_cap > SQLITE3_CONN_RX_INIT && conn->rx_len <= SQLITE3_CONN_RX_INIT / 2) {
+        char* rx = infra_realloc(conn->rx_buf, SQLITE3_CONN_RX_INIT);
+        if (rx) {
+            conn->rx_buf = rx;
+            conn->rx_cap = SQLITE3_CONN_RX_INIT;
+        }
+    }
+    return true;
+}
+
 static void handle_request_wrapper(void* args) {
     if (!args) {
         INFRA_LOG_ERROR("NULL handler args");
@@ -256,9 +680,18 @@ static void handle_request_wrapper(void* args) {
     // Create connection state
     sqlite3_conn_t* conn = sqlite3_conn_create(handler_args->client);
     if (!conn) {
-        const char* error_msg = "ERROR: Failed to create connection\n";
+        const char* error_msg = "failed to create connection";
+        sqlite3_proto_buf_t out;
+        sqlite3_proto_buf_init(&out);
+        size_t frame = sqlite3_proto_begin(&out, SQLITE3_MSG_ERROR);
+        sqlite3_proto_put_u32(&out, (uint32_t)INFRA_ERROR_OPEN_FAILED);
+        sqlite3_proto_put_bytes(&out, error_msg, strlen(error_msg));
+        sqlite3_proto_end(&out, frame);
         size_t sent;
-        infra_net_send(handler_args->client, error_msg, strlen(error_msg), &sent);
+        if (!out.failed) {
+            infra_net_send(handler_args->client, out.data, out.len, &sent);
+        }
+        sqlite3_proto_buf_destroy(&out);
         infra_net_close(handler_args->client);
         free(handler_args);
         return;
@@ -319,9 +752,8 @@ static void handle_request_wrapper(void* args) {
 
         if (events & POLLIN) {
             size_t received = 0;
-            memset(conn->buffer, 0, sizeof(conn->buffer));
-            
-            err = infra_net_recv(conn->client, conn->buffer, sizeof(conn->buffer) - 1, &received);
+            err = infra_net_recv(conn->client, conn->rx_buf + conn->rx_len,
+                                 conn->rx_cap - conn->rx_len, &received);
             if (err != INFRA_OK) {
                 if (err != INFRA_ERROR_TIMEOUT) {
                     INFRA_LOG_ERROR("Failed to receive from %s: %d", client_addr, err);
@@ -335,84 +767,14 @@ static void handle_request_wrapper(void* args) {
                 break;
             }
 
-            // Ensure NULL termination
-            conn->buffer[received] = '\0';
-            INFRA_LOG_DEBUG("Received SQL from %s (%zu bytes): %s", client_addr, received, conn->buffer);
-
-            // 尝试执行 SQL
-            const char* sql = conn->buffer;
-            bool is_query = false;
-
-            // 简单检查是否是查询语句
-            const char* sql_upper = sql;
-            while (*sql_upper && isspace(*sql_upper)) sql_upper++;
-            is_query = (strncasecmp(sql_upper, "SELECT", 6) == 0);
-
-            char response[4096] = {0};
-            if (is_query) {
-                // 执行查询
-                poly_db_result_t* result = NULL;
-                err = poly_db_query(conn->db, sql, &result);
-                if (err != INFRA_OK) {
-                    snprintf(response, sizeof(response), "ERROR: Query failed (%d)\n", err);
-                    INFRA_LOG_ERROR("Query failed for %s: %d", client_addr, err);
-                } else {
-                    size_t row_count = 0;
-                    err = poly_db_result_row_count(result, &row_count);
-                    if (err != INFRA_OK) {
-                        snprintf(response, sizeof(response), "ERROR: Failed to get row count (%d)\n", err);
-                        INFRA_LOG_ERROR("Failed to get row count for %s: %d", client_addr, err);
-                    } else {
-                        snprintf(response, sizeof(response), "OK: %zu rows\n", row_count);
-                        INFRA_LOG_DEBUG("Query returned %zu rows for %s", row_count, client_addr);
-                    }
-                    if (result) {
-                        poly_db_result_free(result);
-                    }
-                }
-            } else {
-                // 执行非查询语句
-                err = poly_db_exec(conn->db, sql);
-                if (err != INFRA_OK) {
-                    snprintf(response, sizeof(response), "ERROR: Execution failed (%d)\n", err);
-                    INFRA_LOG_ERROR("Execution failed for %s: %d", client_addr, err);
-                } else {
-                    snprintf(response, sizeof(response), "OK\n");
-                    INFRA_LOG_DEBUG("Execution succeeded for %s", client_addr);
-                }
-            }
-
-            // 立即发送响应
-            size_t total_sent = 0;
-            size_t response_len = strlen(response);
-            
-            INFRA_LOG_DEBUG("Sending response to %s (%zu bytes): %s", client_addr, response_len, response);
-            
-            while (total_sent < response_len) {
-                size_t remaining = response_len - total_sent;
-                size_t sent = 0;
-                
-                err = infra_net_send(conn->client, response + total_sent, remaining, &sent);
-                if (err != INFRA_OK) {
-                    if (err != INFRA_ERROR_TIMEOUT) {
-                        INFRA_LOG_ERROR("Failed to send response to %s: %d", client_addr, err);
-                        goto cleanup;
-                    }
-                    continue;
-                }
-                
-                total_sent += sent;
-                if (sent == 0) {
-                    INFRA_LOG_ERROR("Connection closed while sending response to %s", client_addr);
-                    goto cleanup;
-                }
+            conn->rx_len += received;
+            INFRA_LOG_DEBUG("Received %zu bytes from %s", received, client_addr);
+            if (!conn_process(conn)) {
+                break;
             }
-            
-            INFRA_LOG_DEBUG("Response sent to %s", client_addr);
         }
     }
 
-cleanup:
     INFRA_LOG_INFO("Closing connection from %s", client_addr);
     poly_poll_destroy(poll);
     sqlite3_conn_destroy(conn);
@@ -510,6 +872,18 @@ infra_error_t sqlite3_init(void) {
         infra_free(state);
         return err;
     }
+    err = infra_cond_init(&state->writer_cond);
+    if (err == INFRA_OK) {
+        err = infra_cond_init(&state->reader_cond);
+        if (err != INFRA_OK) {
+            infra_cond_destroy(state->writer_cond);
+        }
+    }
+    if (err != INFRA_OK) {
+        infra_mutex_destroy(state->mutex);
+        infra_free(state);
+        return err;
+    }
 
     // Set service state
     g_sqlite3_service.config.user_data = state;
@@ -541,6 +915,13 @@ infra_error_t sqlite3_start(void) {
         return INFRA_ERROR_INVALID_STATE;
     }
 
+    // 打开写连接和读连接池
+    infra_error_t err = db_pool_open(state);
+    if (err != INFRA_OK) {
+        g_sqlite3_service.state = PEER_SERVICE_STATE_STOPPED;
+        return err;
+    }
+
     // Initialize poll context
     state->poll_ctx = (poly_poll_context_t*)infra_malloc(sizeof(poly_poll_context_t));
     if (!state->poll_ctx) {
@@ -548,15 +929,15 @@ infra_error_t sqlite3_start(void) {
         return INFRA_ERROR_NO_MEMORY;
     }
 
-    // Initialize poll context
+    // 每个客户端连接占用一个线程, 线程数不少于读连接数, 查询才能占满所有读连接
     poly_poll_config_t poll_config = {
-        .min_threads = 1,
-        .max_threads = 4,
+        .min_threads = state->reader_count > 0 ? state->reader_count : 1,
+        .max_threads = SQLITE3_MAX_CONNECTIONS,
         .queue_size = 1000,
         .max_listeners = 1
     };
 
-    infra_error_t err = poly_poll_init(state->poll_ctx, &poll_config);
+    err = poly_poll_init(state->poll_ctx, &poll_config);
     if (err != INFRA_OK) {
         infra_free(state->poll_ctx);
         state->poll_ctx = NULL;
@@ -650,8 +1031,13 @@ infra_error_t sqlite3_cleanup(void) {
         return INFRA_ERROR_INVALID_STATE;
     }
 
+    // 关闭数据库连接
+    db_pool_close(state);
+
     // 销毁互斥锁
-    infra_mutex_destroy(&state->mutex);
+    infra_cond_destroy(state->writer_cond);
+    infra_cond_destroy(state->reader_cond);
+    infra_mutex_destroy(state->mutex);
 
     // 释放轮询上下文
     if (state->poll_ctx) {
@@ -0,0 +1,236 @@
+#include "internal/infra/infra_core.h"
+#include "internal/infra/infra_error.h"
+#include "internal/infra/infra_memory.h"
+#include "internal/peer/peer_sqlite3_proto.h"
+
+// 输出缓冲区初始大小
+#define SQLITE3_PROTO_BUF_INIT (64 * 1024)
+
+//-----------------------------------------------------------------------------
+// Parser
+//-----------------------------------------------------------------------------
+
+infra_error_t sqlite3_proto_parse(const char* buf, size_t len, sqlite3_frame_t* frame,
+                                  size_t* consumed, size_t* need) {
+    *consumed = 0;
+    *need = 0;
+    if (len < SQLITE3_PROTO_HEADER) {
+        return INFRA_ERROR_WOULD_BLOCK;
+    }
+    size_t payload = sqlite3_proto_get_u32(buf + 1);
+    if (payload > SQLITE3_PROTO_MAX_FRAME) {
+        return INFRA_ERROR_PROTOCOL;
+    }
+    size_t total = SQLITE3_PROTO_HEADER + payload;
+    if (len < total) {
+        *need = total;
+        return INFRA_ERROR_WOULD_BLOCK;
+    }
+    frame->type = buf[0];
+    frame->payload = buf + SQLITE3_PROTO_HEADER;
+    frame->len = payload;
+    *consumed = total;
+    return INFRA_OK;
+}
+
+//-----------------------------------------------------------------------------
+// Encoder
+//-----------------------------------------------------------------------------
+
+void sqlite3_proto_buf_init(sqlite3_proto_buf_t* buf) {
+    memset(buf, 0, sizeof(*buf));
+}
+
+void sqlite3_proto_buf_destroy(sqlite3_proto_buf_t* buf) {
+    if (buf->data) {
+        infra_free(buf->data);
+    }
+    memset(buf, 0, sizeof(*buf));
+}
+
+static bool buf_reserve(sqlite3_proto_buf_t* buf, size_t extra) {
+    if (buf->failed) {
+        return false;
+    }
+    if (buf->len + extra <= buf->cap) {
+        return true;
+    }
+    size_t cap = buf->cap > 0 ? buf->cap : SQLITE3_PROTO_BUF_INIT;
+    while (cap < buf->len + extra) {
+        cap *= 2;
+    }
+    char* data = infra_realloc(buf->data, cap);
+    if (!data) {
+        buf->failed = true;
+        return false;
+    }
+    buf->data = data;
+    buf->cap = cap;
+    return true;
+}
+
+static void write_u32(char* p, uint32_t v) {
+    p[0] = (char)(v >> 24);
+    p[1] = (char)(v >> 16);
+    p[2] = (char)(v >> 8);
+    p[3] = (char)v;
+}
+
+size_t sqlite3_proto_begin(sqlite3_proto_buf_t* buf, char type) {
+    size_t frame = buf->len;
+    if (buf_reserve(buf, SQLITE3_PROTO_HEADER)) {
+        buf->data[buf->len] = type;
+        buf->len += SQLITE3_PROTO_HEADER;
+    }
+    return frame;
+}
+
+void sqlite3_proto_end(sqlite3_proto_buf_t* buf, size_t frame) {
+    if (!buf->failed) {
+        write_u32(buf->data + frame + 1, (uint32_t)(buf->len - frame - SQLITE3_PROTO_HEADER));
+    }
+}
+
+void sqlite3_proto_put_u16(sqlite3_proto_buf_t* buf, uint16_t v) {
+    if (buf_reserve(buf, 2)) {
+        buf->data[buf->len++] = (char)(v >> 8);
+        buf->data[buf->len++] = (char)v;
+    }
+}
+
+void sqlite3_proto_put_u32(sqlite3_proto_buf_t* buf, uint32_t v) {
+    if (buf_reserve(buf, 4)) {
+        write_u32(buf->data + buf->len, v);
+        buf->len += 4;
+    }
+}
+
+void sqlite3_proto_put_u64(sqlite3_proto_buf_t* buf, uint64_t v) {
+    if (buf_reserve(buf, 8)) {
+        write_u32(buf->data + buf->len, (uint32_t)(v >> 32));
+        write_u32(buf->data + buf->len + 4, (uint32_t)v);
+        buf->len += 8;
+    }
+}
+
+void sqlite3_proto_put_bytes(sqlite3_proto_buf_t* buf, const void* data, size_t len) {
+    if (len > 0 && buf_reserve(buf, len)) {
+        memcpy(buf->data + buf->len, data, len);
+        buf->len += len;
+    }
+}
+
+void sqlite3_proto_set_u32(sqlite3_proto_buf_t* buf, size_t offset, uint32_t v) {
+    if (!buf->failed) {
+        write_u32(buf->data + offset, v);
+    }
+}
+
+void sqlite3_proto_put_value(sqlite3_proto_buf_t* buf, const poly_db_value_t* value) {
+    // 类型字节和定长部分一次预留
+    if (!buf_reserve(buf, 9)) {
+        return;
+    }
+    char* p = buf->data + buf->len;
+    switch (value->type) {
+        case POLY_DB_VALUE_INTEGER:
+            p[0] = SQLITE3_PROTO_INTEGER;
+            write_u32(p + 1, (uint32_t)((uint64_t)value->i >> 32));
+            write_u32(p + 5, (uint32_t)value->i);
+            buf->len += 9;
+            break;
+        case POLY_DB_VALUE_REAL: {
+            uint64_t bits;
+            memcpy(&bits, &value->d, sizeof(bits));
+            p[0] = SQLITE3_PROTO_REAL;
+            write_u32(p + 1, (uint32_t)(bits >> 32));
+            write_u32(p + 5, (uint32_t)bits);
+            buf->len += 9;
+            break;
+        }
+        case POLY_DB_VALUE_TEXT:
+        case POLY_DB_VALUE_BLOB:
+            p[0] = value->type == POLY_DB_VALUE_TEXT ? SQLITE3_PROTO_TEXT : SQLITE3_PROTO_BLOB;
+            write_u32(p + 1, (uint32_t)value->len);
+            buf->len += 5;
+            sqlite3_proto_put_bytes(buf, value->data, value->len);
+            break;
+        default:
+            p[0] = SQLITE3_PROTO_NULL;
+            buf->len += 1;
+            break;
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Decoder
+//-----------------------------------------------------------------------------
+
+size_t sqlite3_proto_get_value(const char* p, size_t len, poly_db_value_t* value) {
+    if (len < 1) {
+        return 0;
+    }
+    memset(value, 0, sizeof(*value));
+    switch (p[0]) {
+        case SQLITE3_PROTO_NULL:
+            value->type = POLY_DB_VALUE_NULL;
+            return 1;
+        case SQLITE3_PROTO_INTEGER:
+            if (len < 9) return 0;
+            value->type = POLY_DB_VALUE_INTEGER;
+            value->i = (int64_t)sqlite3_proto_get_u64(p + 1);
+            return 9;
+        case SQLITE3_PROTO_REAL: {
+            if (len < 9) return 0;
+            uint64_t bits = sqlite3_proto_get_u64(p + 1);
+            value->type = POLY_DB_VALUE_REAL;
+            memcpy(&value->d, &bits, sizeof(bits));
+            return 9;
+        }
+        case SQLITE3_PROTO_TEXT:
+        case SQLITE3_PROTO_BLOB: {
+            if (len < 5) return 0;
+            size_t n = sqlite3_proto_get_u32(p + 1);
+            if (len - 5 < n) return 0;
+            value->type = p[0] == SQLITE3_PROTO_TEXT ? POLY_DB_VALUE_TEXT : POLY_DB_VALUE_BLOB;
+            value->data = p + 5;
+            value->len = n;
+            return 5 + n;
+        }
+        default:
+            return 0;
+    }
+}
+
+//-----------------------------------------------------------------------------
+// SQL
+//-----------------------------------------------------------------------------
+
+const char* sqlite3_sql_skip_space(const char* sql, const char* end) {
+    while (sql < end) {
+        if (isspace((unsigned char)*sql)) {
+            sql++;
+        } else if (end - sql >= 2 && sql[0] == '-' && sql[1] == '-') {
+            while (sql < end && *sql != '\n') sql++;
+        } else if (end - sql >= 2 && sql[0] == '/' && sql[1] == '*') {
+            sql += 2;
+            while (end - sql >= 2 && !(sql[0] == '*' && sql[1] == '/')) sql++;
+            sql += 2;
+        } else {
+            break;
+        }
+    }
+    return sql < end ? sql : end;
+}
+
+bool sqlite3_sql_is_query(const char* sql, const char* end) {
+    const char* keywords[] = {"SELECT", "WITH", "VALUES"};
+    for (size_t i = 0; i < sizeof(keywords) / sizeof(keywords[0]); i++) {
+        size_t n = strlen(keywords[i]);
+        if ((size_t)(end - sql) >= n && strncasecmp(sql, keywords[i], n) == 0 &&
+            ((size_t)(end - sql) == n || (!isalnum((unsigned char)sql[n]) && sql[n] != '_'))) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,101 @@
+#ifndef PEER_SQLITE3_PROTO_H_
+#define PEER_SQLITE3_PROTO_H_
+
+#include "internal/infra/infra_core.h"
+#include "internal/infra/infra_error.h"
+#include "internal/poly/poly_db.h"
+
+//-----------------------------------------------------------------------------
+// sqlite3 服务的线路协议
+//
+// 双向都按帧传输: 1 字节类型 + 4 字节负载长度 + 负载, 所有整数均为大端.
+// 客户端发送 Q (SQL 文本, 可以包含多条语句, 不以 '\0' 结尾) 或 X (关闭连接),
+// 可以连续发送多个 Q 不等回复. 服务端对 Q 中的每条语句依次回复:
+//   T  列描述: u16 列数, 每列 u16 名字长度 + 名字 (只有返回列的语句才有)
+//   D  一批行: u32 行数, 之后逐行逐列编码值, 每批不超过 SQLITE3_PROTO_BATCH_ROWS 行
+//   C  完成: u64 行数, 查询为返回的行数, 其他语句为修改的行数
+// 语句出错时回复 E (i32 错误码 + 消息文本), 不再执行剩余语句; 每个 Q 最后以 Z 结束.
+// 值: 1 字节类型 + 数据. NULL 没有数据; INTEGER 为 i64; REAL 为 IEEE 754 double
+// 的 8 字节; TEXT 和 BLOB 为 u32 长度 + 字节.
+//-----------------------------------------------------------------------------
+
+#define SQLITE3_PROTO_HEADER 5
+// 单帧的最大负载, 也是一次请求的 SQL 文本上限
+#define SQLITE3_PROTO_MAX_FRAME (64 * 1024 * 1024)
+// 一个 D 帧最多的行数
+#define SQLITE3_PROTO_BATCH_ROWS 1024
+
+// 帧类型
+#define SQLITE3_MSG_QUERY      'Q'
+#define SQLITE3_MSG_TERMINATE  'X'
+#define SQLITE3_MSG_ROW_DESC   'T'
+#define SQLITE3_MSG_DATA       'D'
+#define SQLITE3_MSG_COMPLETE   'C'
+#define SQLITE3_MSG_ERROR      'E'
+#define SQLITE3_MSG_READY      'Z'
+
+// 值类型
+#define SQLITE3_PROTO_NULL     0
+#define SQLITE3_PROTO_INTEGER  1
+#define SQLITE3_PROTO_REAL     2
+#define SQLITE3_PROTO_TEXT     3
+#define SQLITE3_PROTO_BLOB     4
+
+// 一帧, 负载指向输入缓冲区, 不复制
+typedef struct sqlite3_frame {
+    char type;
+    const char* payload;
+    size_t len;
+} sqlite3_frame_t;
+
+// 从 buf 解析一帧
+//  INFRA_OK: *consumed 为整帧的字节数
+//  INFRA_ERROR_WOULD_BLOCK: 数据不完整, *need 为整帧的字节数 (头部未到齐时为 0)
+//  INFRA_ERROR_PROTOCOL: 负载超过 SQLITE3_PROTO_MAX_FRAME
+infra_error_t sqlite3_proto_parse(const char* buf, size_t len, sqlite3_frame_t* frame,
+                                  size_t* consumed, size_t* need);
+
+// 输出缓冲区, 按需扩大. 扩大失败后置 failed, 之后的写入都被忽略, 由调用者在帧末检查
+typedef struct sqlite3_proto_buf {
+    char* data;
+    size_t len;
+    size_t cap;
+    bool failed;
+} sqlite3_proto_buf_t;
+
+void sqlite3_proto_buf_init(sqlite3_proto_buf_t* buf);
+void sqlite3_proto_buf_destroy(sqlite3_proto_buf_t* buf);
+
+// 开始一帧, 返回帧在缓冲区中的位置; 负载写完后调用 sqlite3_proto_end 填入长度
+size_t sqlite3_proto_begin(sqlite3_proto_buf_t* buf, char type);
+void sqlite3_proto_end(sqlite3_proto_buf_t* buf, size_t frame);
+
+void sqlite3_proto_put_u16(sqlite3_proto_buf_t* buf, uint16_t v);
+void sqlite3_proto_put_u32(sqlite3_proto_buf_t* buf, uint32_t v);
+void sqlite3_proto_put_u64(sqlite3_proto_buf_t* buf, uint64_t v);
+void sqlite3_proto_put_bytes(sqlite3_proto_buf_t* buf, const void* data, size_t len);
+// 改写已写入的 u32 (例如 D 帧开头的行数)
+void sqlite3_proto_set_u32(sqlite3_proto_buf_t* buf, size_t offset, uint32_t v);
+// 编码一个值, 引擎特有的类型按 NULL 发送
+void sqlite3_proto_put_value(sqlite3_proto_buf_t* buf, const poly_db_value_t* value);
+
+static inline uint32_t sqlite3_proto_get_u32(const char* p) {
+    const unsigned char* u = (const unsigned char*)p;
+    return ((uint32_t)u[0] << 24) | ((uint32_t)u[1] << 16) | ((uint32_t)u[2] << 8) | u[3];
+}
+
+static inline uint64_t sqlite3_proto_get_u64(const char* p) {
+    return ((uint64_t)sqlite3_proto_get_u32(p) << 32) | sqlite3_proto_get_u32(p + 4);
+}
+
+// 解码一个值, TEXT/BLOB 指向输入; 返回消耗的字节数, 数据不完整或类型未知时返回 0
+size_t sqlite3_proto_get_value(const char* p, size_t len, poly_db_value_t* value);
+
+// 跳过 sql 开头的空白和注释, 返回下一条语句的开头 (只剩空白时为 end)
+const char* sqlite3_sql_skip_space(const char* sql, const char* end);
+// 语句是否以 SELECT/WITH/VALUES 开头, 只有这些语句尝试读连接.
+// 只看开头的关键字, WITH ... INSERT 也返回 true, 由读连接上编译的结果排除;
+// PRAGMA 等虽然只读但会改变连接的设置, 不能在共用的读连接上执行
+bool sqlite3_sql_is_query(const char* sql, const char* end);
+
+#endif /* PEER_SQLITE3_PROTO_H_ */
@@ -37,6 +37,13 @@ typedef struct {
     char target_host[POLY_CMD_MAX_NAME];
     int target_port;
     char backend[POLY_CMD_MAX_VALUE];
+    char engine[POLY_CMD_MAX_NAME];     // 存储引擎 (memkv: memory/sqlite/duckdb)
+    int memory_mb;                      // memkv: item 内存上限 (MB), 0 使用默认值
+    double growth_factor;               // memkv: slab 增长因子, 0 使用默认值
+    int threads;                        // memkv/diskv: reactor 线程数, 0 按 CPU 数
+    bool sharded;                       // memkv: shard-per-reactor 模式 (memory 引擎)
+    bool hotcache;                      // memkv: 热点 key 的线程本地副本缓存 (memory 引擎)
+    int commit_ms;                      // memkv: 组提交间隔 (毫秒, sqlite 引擎), 0 使用默认值, <0 关闭
 } poly_service_config_t;
 
 // Global configuration
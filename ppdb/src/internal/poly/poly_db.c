@@ -21,6 +21,31 @@ typedef duckdb_state (*duckdb_bind_varchar_t)(duckdb_prepared_statement prepared
 typedef idx_t (*duckdb_row_count_t)(duckdb_result *result);
 typedef duckdb_string (*duckdb_value_string_t)(duckdb_result *result, idx_t col, idx_t row);
 typedef void (*duckdb_free_t)(void *ptr);
+typedef duckdb_state (*duckdb_clear_bindings_t)(duckdb_prepared_statement prepared_statement);
+typedef idx_t (*duckdb_rows_changed_t)(duckdb_result *result);
+// 流式结果和 data chunk
+typedef duckdb_state (*duckdb_execute_prepared_streaming_t)(duckdb_prepared_statement prepared_statement, duckdb_result *out_result);
+typedef duckdb_data_chunk (*duckdb_fetch_chunk_t)(duckdb_result result);
+typedef void (*duckdb_destroy_data_chunk_t)(duckdb_data_chunk *chunk);
+typedef idx_t (*duckdb_data_chunk_get_size_t)(duckdb_data_chunk chunk);
+typedef duckdb_vector (*duckdb_data_chunk_get_vector_t)(duckdb_data_chunk chunk, idx_t col_idx);
+typedef void* (*duckdb_vector_get_data_t)(duckdb_vector vector);
+typedef uint64_t* (*duckdb_vector_get_validity_t)(duckdb_vector vector);
+typedef idx_t (*duckdb_column_count_t)(duckdb_result *result);
+typedef const char* (*duckdb_column_name_t)(duckdb_result *result, idx_t col);
+typedef duckdb_type (*duckdb_column_type_t)(duckdb_result *result, idx_t col);
+// appender
+typedef duckdb_state (*duckdb_appender_create_t)(duckdb_connection connection, const char *schema, const char *table, duckdb_appender *out_appender);
+typedef idx_t (*duckdb_appender_column_count_t)(duckdb_appender appender);
+typedef const char* (*duckdb_appender_error_t)(duckdb_appender appender);
+typedef duckdb_state (*duckdb_appender_close_t)(duckdb_appender appender);
+typedef duckdb_state (*duckdb_appender_destroy_t)(duckdb_appender *appender);
+typedef duckdb_state (*duckdb_appender_end_row_t)(duckdb_appender appender);
+typedef duckdb_state (*duckdb_append_null_t)(duckdb_appender appender);
+typedef duckdb_state (*duckdb_append_int64_t)(duckdb_appender appender, int64_t value);
+typedef duckdb_state (*duckdb_append_double_t)(duckdb_appender appender, double value);
+typedef duckdb_state (*duckdb_append_varchar_length_t)(duckdb_appender appender, const char *val, idx_t length);
+typedef duckdb_state (*duckdb_append_blob_t)(duckdb_appender appender, const void *data, idx_t length);
 
 // DuckDB 实现结构体
 typedef struct duckdb_impl {
@@ -41,6 +66,32 @@ typedef struct duckdb_impl {
     duckdb_row_count_t row_count;
     duckdb_value_string_t value_string;
     duckdb_free_t free;
+    duckdb_clear_bindings_t clear_bindings;  // 可选, 旧版本库可能没有
+    duckdb_rows_changed_t rows_changed;      // 可选
+    // 流式游标用, 可选, 缺少时游标不可用
+    duckdb_execute_prepared_streaming_t execute_prepared_streaming;
+    duckdb_fetch_chunk_t fetch_chunk;
+    duckdb_destroy_data_chunk_t destroy_data_chunk;
+    duckdb_data_chunk_get_size_t data_chunk_get_size;
+    duckdb_data_chunk_get_vector_t data_chunk_get_vector;
+    duckdb_vector_get_data_t vector_get_data;
+    duckdb_vector_get_validity_t vector_get_validity;
+    duckdb_column_count_t column_count;
+    duckdb_column_name_t column_name;
+    duckdb_column_type_t column_type;
+    // 批量导入用, 可选, 缺少时 bulk 不可用
+    duckdb_appender_create_t appender_create;
+    duckdb_appender_column_count_t appender_column_count;
+    duckdb_appender_error_t appender_error;
+    duckdb_appender_close_t appender_close;
+    duckdb_appender_destroy_t appender_destroy;
+    duckdb_appender_end_row_t appender_end_row;
+    duckdb_append_null_t append_null;
+    duckdb_append_int64_t append_int64;
+    duckdb_append_double_t append_double;
+    duckdb_append_varchar_length_t append_varchar_length;
+    duckdb_append_blob_t append_blob;
+    uint64_t last_changes;                   // 最近一条语句修改的行数
 } duckdb_impl_t;
 
 // SQLite 实现结构体
@@ -58,8 +109,71 @@ typedef struct poly_db_result {
 typedef struct poly_db_stmt {
     poly_db_t* db;
     void* internal_stmt;
+    struct stmt_cache_entry* cache_entry;  // 非 NULL 表示属于语句缓存
 } poly_db_stmt_t;
 
+// 流式游标结构体
+typedef struct poly_db_cursor {
+    poly_db_t* db;
+    int columns;
+    bool done;                  // 已读完或出错, 不再推进 (SQLite 会自动从头重新执行)
+    char scratch[32];           // 数值转文本的缓冲区
+    // SQLite
+    poly_db_stmt_t* stmt;
+    // DuckDB: 结果按 chunk 拉取, 每列的数据和有效位在换 chunk 时取一次
+    duckdb_connection conn;
+    duckdb_prepared_statement prepared;
+    duckdb_result result;
+    bool has_result;
+    duckdb_data_chunk chunk;
+    idx_t chunk_rows;
+    idx_t row;                  // 当前行在 chunk 中的下标
+    duckdb_type* types;
+    void** data;
+    uint64_t** validity;
+    // 按列批量读取, 第一次 next_batch 时分配
+    poly_db_batch_t batch;
+    poly_db_vector_t* vectors;
+    poly_db_value_t* values;    // SQLite: 每列 POLY_DB_BATCH_ROWS 个值
+    uint64_t* value_bits;       // SQLite: 每列的有效位
+    char* arena;                // SQLite: 本批文本/二进制值的拷贝
+    size_t arena_len;
+    size_t arena_cap;
+} poly_db_cursor_t;
+
+// 批量导入结构体
+typedef struct poly_db_bulk {
+    poly_db_t* db;
+    int columns;
+    bool failed;                // 有行写入失败, 只能回滚
+    // SQLite: 复用的 INSERT 和导入前的设置
+    sqlite3_stmt* insert;
+    int old_synchronous;
+    int64_t old_cache_size;
+    char old_journal[32];       // 空串表示没有改动日志模式
+    // DuckDB
+    duckdb_connection conn;
+    duckdb_appender appender;
+} poly_db_bulk_t;
+
+// 语句缓存项
+typedef struct stmt_cache_entry {
+    char* sql;                  // NULL 表示空槽
+    uint64_t hash;
+    poly_db_stmt_t* stmt;
+    bool in_use;                // 已借出, 未 finalize
+    uint64_t last_used;         // LRU 时钟
+} stmt_cache_entry_t;
+
+typedef struct stmt_cache {
+    infra_mutex_t mutex;
+    stmt_cache_entry_t entries[POLY_DB_STMT_CACHE_SIZE];
+    uint64_t clock;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+} stmt_cache_t;
+
 // 多态数据库结构体
 typedef struct poly_db {
     poly_db_type_t type;
@@ -78,6 +192,21 @@ typedef struct poly_db {
     infra_error_t (*bind_blob)(poly_db_stmt_t* stmt, int index, const void* data, size_t len);
     infra_error_t (*column_blob)(poly_db_stmt_t* stmt, int col, void** data, size_t* size);
     infra_error_t (*column_text)(poly_db_stmt_t* stmt, int col, char** text);
+    infra_error_t (*stmt_reset)(poly_db_stmt_t* stmt);
+    // 流式游标相关函数
+    infra_error_t (*cursor_open)(poly_db_cursor_t* cursor, const char* sql);
+    infra_error_t (*cursor_open_script)(poly_db_cursor_t* cursor, const char* sql, size_t len,
+                                        const char** tail);
+    infra_error_t (*cursor_next)(poly_db_cursor_t* cursor);
+    infra_error_t (*cursor_column)(poly_db_cursor_t* cursor, int col, poly_db_value_t* value);
+    infra_error_t (*cursor_next_batch)(poly_db_cursor_t* cursor);
+    const char* (*cursor_column_name)(poly_db_cursor_t* cursor, int col);
+    void (*cursor_close)(poly_db_cursor_t* cursor);
+    // 批量导入相关函数
+    infra_error_t (*bulk_begin)(poly_db_bulk_t* bulk, const char* table);
+    infra_error_t (*bulk_append_row)(poly_db_bulk_t* bulk, const poly_db_value_t* values);
+    infra_error_t (*bulk_end)(poly_db_bulk_t* bulk, bool commit);
+    stmt_cache_t stmt_cache;
 } poly_db_t;
 
 // 修改错误码（稍后再清理）
@@ -116,6 +245,33 @@ static infra_error_t create_duckdb(duckdb_impl_t** impl) {
     duckdb->row_count = (duckdb_row_count_t)dlsym(duckdb->handle, "duckdb_row_count");
     duckdb->value_string = (duckdb_value_string_t)dlsym(duckdb->handle, "duckdb_value_string");
     duckdb->free = (duckdb_free_t)dlsym(duckdb->handle, "duckdb_free");
+    duckdb->clear_bindings = (duckdb_clear_bindings_t)dlsym(duckdb->handle, "duckdb_clear_bindings");
+    duckdb->rows_changed = (duckdb_rows_changed_t)dlsym(duckdb->handle, "duckdb_rows_changed");
+    duckdb->execute_prepared_streaming = (duckdb_execute_prepared_streaming_t)dlsym(duckdb->handle, "duckdb_execute_prepared_streaming");
+    duckdb->fetch_chunk = (duckdb_fetch_chunk_t)dlsym(duckdb->handle, "duckdb_fetch_chunk");
+    if (!duckdb->fetch_chunk) {
+        // 1.1 之前的库只有 duckdb_stream_fetch_chunk, 签名相同
+        duckdb->fetch_chunk = (duckdb_fetch_chunk_t)dlsym(duckdb->handle, "duckdb_stream_fetch_chunk");
+    }
+    duckdb->destroy_data_chunk = (duckdb_destroy_data_chunk_t)dlsym(duckdb->handle, "duckdb_destroy_data_chunk");
+    duckdb->data_chunk_get_size = (duckdb_data_chunk_get_size_t)dlsym(duckdb->handle, "duckdb_data_chunk_get_size");
+    duckdb->data_chunk_get_vector = (duckdb_data_chunk_get_vector_t)dlsym(duckdb->handle, "duckdb_data_chunk_get_vector");
+    duckdb->vector_get_data = (duckdb_vector_get_data_t)dlsym(duckdb->handle, "duckdb_vector_get_data");
+    duckdb->vector_get_validity = (duckdb_vector_get_validity_t)dlsym(duckdb->handle, "duckdb_vector_get_validity");
+    duckdb->column_count = (duckdb_column_count_t)dlsym(duckdb->handle, "duckdb_column_count");
+    duckdb->column_name = (duckdb_column_name_t)dlsym(duckdb->handle, "duckdb_column_name");
+    duckdb->column_type = (duckdb_column_type_t)dlsym(duckdb->handle, "duckdb_column_type");
+    duckdb->appender_create = (duckdb_appender_create_t)dlsym(duckdb->handle, "duckdb_appender_create");
+    duckdb->appender_column_count = (duckdb_appender_column_count_t)dlsym(duckdb->handle, "duckdb_appender_column_count");
+    duckdb->appender_error = (duckdb_appender_error_t)dlsym(duckdb->handle, "duckdb_appender_error");
+    duckdb->appender_close = (duckdb_appender_close_t)dlsym(duckdb->handle, "duckdb_appender_close");
+    duckdb->appender_destroy = (duckdb_appender_destroy_t)dlsym(duckdb->handle, "duckdb_appender_destroy");
+    duckdb->appender_end_row = (duckdb_appender_end_row_t)dlsym(duckdb->handle, "duckdb_appender_end_row");
+    duckdb->append_null = (duckdb_append_null_t)dlsym(duckdb->handle, "duckdb_append_null");
+    duckdb->append_int64 = (duckdb_append_int64_t)dlsym(duckdb->handle, "duckdb_append_int64");
+    duckdb->append_double = (duckdb_append_double_t)dlsym(duckdb->handle, "duckdb_append_double");
+    duckdb->append_varchar_length = (duckdb_append_varchar_length_t)dlsym(duckdb->handle, "duckdb_append_varchar_length");
+    duckdb->append_blob = (duckdb_append_blob_t)dlsym(duckdb->handle, "duckdb_append_blob");
 
     // 验证所有函数指针都已加载
     if (!duckdb->open || !duckdb->close || !duckdb->connect || !duckdb->disconnect ||
@@ -158,6 +314,7 @@ static infra_error_t poly_duckdb_exec(poly_db_t* db, const char* sql) {
         return INFRA_ERROR_EXEC_FAILED;
     }
 
+    impl->last_changes = impl->rows_changed ? impl->rows_changed(&result) : 0;
     impl->destroy_result(&result);
     impl->disconnect(&conn);
     return INFRA_OK;
@@ -230,10 +387,14 @@ static infra_error_t poly_duckdb_result_get_blob(poly_db_result_t* result, size_
         return INFRA_ERROR_NOT_FOUND;
     }
     
+    // 库分配的副本要用 duckdb_free 释放
     void* blob_copy = infra_malloc(blob.size);
+    if (blob_copy) {
+        memcpy(blob_copy, blob.data, blob.size);
+    }
+    impl->free(blob.data);
     if (!blob_copy) return INFRA_ERROR_NO_MEMORY;
-    
-    memcpy(blob_copy, blob.data, blob.size);
+
     *data = blob_copy;
     *size = blob.size;
     
@@ -257,6 +418,7 @@ static infra_error_t poly_duckdb_result_get_string(poly_db_result_t* result, siz
     }
     
     *str = infra_strdup(value.data);
+    impl->free(value.data);
     if (!*str) return INFRA_ERROR_NO_MEMORY;
     
     return INFRA_OK;
@@ -486,6 +648,7 @@ static infra_error_t sqlite_prepare(poly_db_t* db, const char* sql, poly_db_stmt
 
     new_stmt->db = db;
     new_stmt->internal_stmt = sqlite_stmt;
+    new_stmt->cache_entry = NULL;
     *stmt = new_stmt;
     return INFRA_OK;
 }
@@ -498,6 +661,14 @@ static infra_error_t sqlite_stmt_finalize(poly_db_stmt_t* stmt) {
     return INFRA_OK;
 }
 
+// 归还缓存前重置: 结束当前执行并解除对调用者缓冲区的绑定 (SQLITE_STATIC)
+static infra_error_t sqlite_stmt_reset(poly_db_stmt_t* stmt) {
+    if (!stmt) return INFRA_ERROR_INVALID_PARAM;
+    sqlite3_stmt* sqlite_stmt = (sqlite3_stmt*)stmt->internal_stmt;
+    sqlite3_reset(sqlite_stmt);
+    return sqlite3_clear_bindings(sqlite_stmt) == SQLITE_OK ? INFRA_OK : INFRA_ERROR_QUERY_FAILED;
+}
+
 static infra_error_t sqlite_stmt_step(poly_db_stmt_t* stmt) {
     if (!stmt) return INFRA_ERROR_INVALID_PARAM;
     sqlite3_stmt* sqlite_stmt = (sqlite3_stmt*)stmt->internal_stmt;
@@ -592,6 +763,7 @@ static infra_error_t poly_duckdb_prepare(poly_db_t* db, const char* sql, poly_db
 
     new_stmt->db = db;
     new_stmt->internal_stmt = duck_stmt;
+    new_stmt->cache_entry = NULL;
     *stmt = new_stmt;
     return INFRA_OK;
 }
@@ -606,6 +778,16 @@ static infra_error_t poly_duckdb_stmt_finalize(poly_db_stmt_t* stmt) {
     return INFRA_OK;
 }
 
+static infra_error_t poly_duckdb_stmt_reset(poly_db_stmt_t* stmt) {
+    if (!stmt) return INFRA_ERROR_INVALID_PARAM;
+    duckdb_impl_t* impl = (duckdb_impl_t*)stmt->db->impl;
+    duckdb_prepared_statement* duck_stmt = (duckdb_prepared_statement*)stmt->internal_stmt;
+
+    // DuckDB 每次执行都是独立结果集, 只需清掉绑定; 库不支持时不能安全复用
+    if (!impl->clear_bindings) return INFRA_ERROR_NOT_SUPPORTED;
+    return impl->clear_bindings(*duck_stmt) == DuckDBSuccess ? INFRA_OK : INFRA_ERROR_QUERY_FAILED;
+}
+
 static infra_error_t poly_duckdb_stmt_step(poly_db_stmt_t* stmt) {
     if (!stmt) return INFRA_ERROR_INVALID_PARAM;
     duckdb_impl_t* impl = (duckdb_impl_t*)stmt->db->impl;
@@ -615,6 +797,7 @@ static infra_error_t poly_duckdb_stmt_step(poly_db_stmt_t* stmt) {
     duckdb_state state = impl->execute_prepared(*duck_stmt, &result);
     if (state != DuckDBSuccess) return INFRA_ERROR_QUERY_FAILED;
     
+    impl->last_changes = impl->rows_changed ? impl->rows_changed(&result) : 0;
     impl->destroy_result(&result);
     return INFRA_OK;
 }
@@ -655,15 +838,775 @@ static infra_error_t poly_duckdb_column_text(poly_db_stmt_t* stmt, int col, char
     return INFRA_ERROR_QUERY_FAILED;
 }
 
+// SQLite 流式游标: 直接 step 缓存中的语句, 列值指向 SQLite 的行缓冲区
+static infra_error_t sqlite_cursor_open(poly_db_cursor_t* cursor, const char* sql) {
+    infra_error_t err = poly_db_prepare(cursor->db, sql, &cursor->stmt);
+    if (err != INFRA_OK) {
+        INFRA_LOG_ERROR("Failed to prepare cursor: %s",
+            sqlite3_errmsg(((sqlite_impl_t*)cursor->db->impl)->db));
+        return err;
+    }
+    cursor->columns = sqlite3_column_count((sqlite3_stmt*)cursor->stmt->internal_stmt);
+    return INFRA_OK;
+}
+
+// 脚本中的一条语句, 单独编译不进语句缓存 (文本不以 '\0' 结尾, 也不会重复)
+static infra_error_t sqlite_cursor_open_script(poly_db_cursor_t* cursor, const char* sql, size_t len,
+                                               const char** tail) {
+    sqlite_impl_t* impl = (sqlite_impl_t*)cursor->db->impl;
+    if (len > INT32_MAX) return INFRA_ERROR_INVALID_PARAM;
+
+    sqlite3_stmt* stmt = NULL;
+    int rc = sqlite3_prepare_v2(impl->db, sql, (int)len, &stmt, tail);
+    if (rc != SQLITE_OK) {
+        INFRA_LOG_DEBUG("Failed to prepare script statement: %s", sqlite3_errmsg(impl->db));
+        return INFRA_ERROR_QUERY_FAILED;
+    }
+    if (!stmt) {
+        return INFRA_ERROR_NOT_FOUND;  // 只剩空白或注释
+    }
+
+    cursor->stmt = infra_malloc(sizeof(poly_db_stmt_t));
+    if (!cursor->stmt) {
+        sqlite3_finalize(stmt);
+        return INFRA_ERROR_NO_MEMORY;
+    }
+    cursor->stmt->db = cursor->db;
+    cursor->stmt->internal_stmt = stmt;
+    cursor->stmt->cache_entry = NULL;
+    cursor->columns = sqlite3_column_count(stmt);
+    return INFRA_OK;
+}
+
+static infra_error_t sqlite_cursor_next(poly_db_cursor_t* cursor) {
+    int rc = sqlite3_step((sqlite3_stmt*)cursor->stmt->internal_stmt);
+    if (rc == SQLITE_ROW) return INFRA_OK;
+    if (rc == SQLITE_DONE) return INFRA_ERROR_NOT_FOUND;
+    INFRA_LOG_ERROR("Cursor step failed: %s", sqlite3_errmsg(((sqlite_impl_t*)cursor->db->impl)->db));
+    return INFRA_ERROR_QUERY_FAILED;
+}
+
+static infra_error_t sqlite_cursor_column(poly_db_cursor_t* cursor, int col, poly_db_value_t* value) {
+    sqlite3_stmt* stmt = (sqlite3_stmt*)cursor->stmt->internal_stmt;
+    switch (sqlite3_column_type(stmt, col)) {
+        case SQLITE_INTEGER:
+            value->type = POLY_DB_VALUE_INTEGER;
+            value->i = sqlite3_column_int64(stmt, col);
+            break;
+        case SQLITE_FLOAT:
+            value->type = POLY_DB_VALUE_REAL;
+            value->d = sqlite3_column_double(stmt, col);
+            break;
+        case SQLITE_TEXT:
+            value->type = POLY_DB_VALUE_TEXT;
+            value->data = sqlite3_column_text(stmt, col);
+            value->len = (size_t)sqlite3_column_bytes(stmt, col);
+            break;
+        case SQLITE_BLOB:
+            value->type = POLY_DB_VALUE_BLOB;
+            value->data = sqlite3_column_blob(stmt, col);
+            value->len = (size_t)sqlite3_column_bytes(stmt, col);
+            break;
+        default:
+            value->type = POLY_DB_VALUE_NULL;
+            break;
+    }
+    return INFRA_OK;
+}
+
+static const char* sqlite_cursor_column_name(poly_db_cursor_t* cursor, int col) {
+    return sqlite3_column_name((sqlite3_stmt*)cursor->stmt->internal_stmt, col);
+}
+
+// 本批文本/二进制值拷入 arena, 先记偏移, 攒完一批后再换成指针
+static bool cursor_arena_append(poly_db_cursor_t* cursor, poly_db_value_t* value) {
+    if (cursor->arena_len + value->len > cursor->arena_cap) {
+        size_t cap = cursor->arena_cap ? cursor->arena_cap : 64 * 1024;
+        while (cap < cursor->arena_len + value->len) {
+            cap *= 2;
+        }
+        char* arena = infra_realloc(cursor->arena, cap);
+        if (!arena) return false;
+        cursor->arena = arena;
+        cursor->arena_cap = cap;
+    }
+    if (value->len > 0) {
+        memcpy(cursor->arena + cursor->arena_len, value->data, value->len);
+    }
+    value->data = (const void*)(uintptr_t)cursor->arena_len;
+    cursor->arena_len += value->len;
+    return true;
+}
+
+// SQLite 按行存储且每行类型可以不同, 逐行 step 后转成 poly_db_value_t 列
+static infra_error_t sqlite_cursor_next_batch(poly_db_cursor_t* cursor) {
+    size_t words = POLY_DB_BATCH_ROWS / 64;
+    if (!cursor->values && cursor->columns > 0) {
+        cursor->values = infra_malloc(cursor->columns * POLY_DB_BATCH_ROWS * sizeof(poly_db_value_t));
+        cursor->value_bits = infra_malloc(cursor->columns * words * sizeof(uint64_t));
+        if (!cursor->values || !cursor->value_bits) return INFRA_ERROR_NO_MEMORY;
+    }
+    memset(cursor->value_bits, 0, cursor->columns * words * sizeof(uint64_t));
+    cursor->arena_len = 0;
+
+    size_t rows = 0;
+    infra_error_t err = INFRA_OK;
+    while (rows < POLY_DB_BATCH_ROWS && (err = sqlite_cursor_next(cursor)) == INFRA_OK) {
+        for (int col = 0; col < cursor->columns; col++) {
+            poly_db_value_t* value = &cursor->values[col * POLY_DB_BATCH_ROWS + rows];
+            memset(value, 0, sizeof(*value));
+            sqlite_cursor_column(cursor, col, value);
+            if (value->type == POLY_DB_VALUE_NULL) {
+                continue;
+            }
+            if ((value->type == POLY_DB_VALUE_TEXT || value->type == POLY_DB_VALUE_BLOB) &&
+                !cursor_arena_append(cursor, value)) {
+                return INFRA_ERROR_NO_MEMORY;
+            }
+            cursor->value_bits[col * words + rows / 64] |= (uint64_t)1 << (rows % 64);
+        }
+        rows++;
+    }
+    if (err != INFRA_OK && err != INFRA_ERROR_NOT_FOUND) return err;
+    if (rows == 0) return INFRA_ERROR_NOT_FOUND;
+    // 最后一批不满, 语句已结束, 再 step 会从头重新执行
+    if (err == INFRA_ERROR_NOT_FOUND) cursor->done = true;
+
+    for (int col = 0; col < cursor->columns; col++) {
+        poly_db_value_t* values = &cursor->values[col * POLY_DB_BATCH_ROWS];
+        for (size_t i = 0; i < rows; i++) {
+            if (values[i].type == POLY_DB_VALUE_TEXT || values[i].type == POLY_DB_VALUE_BLOB) {
+                values[i].data = cursor->arena + (uintptr_t)values[i].data;
+            }
+        }
+        cursor->vectors[col].format = POLY_DB_COLUMN_VALUE;
+        cursor->vectors[col].data = values;
+        cursor->vectors[col].validity = &cursor->value_bits[col * words];
+    }
+    cursor->batch.rows = rows;
+    return INFRA_OK;
+}
+
+static void sqlite_cursor_close(poly_db_cursor_t* cursor) {
+    if (cursor->stmt) {
+        poly_db_stmt_finalize(cursor->stmt);
+        cursor->stmt = NULL;
+    }
+}
+
+// DuckDB 流式游标: 流式执行预处理语句, 逐个拉取 data chunk, 行内直接读向量数据.
+// 游标独占一个连接, 流式结果在连接断开前有效
+static void poly_duckdb_cursor_close(poly_db_cursor_t* cursor) {
+    duckdb_impl_t* impl = (duckdb_impl_t*)cursor->db->impl;
+    if (cursor->chunk) {
+        impl->destroy_data_chunk(&cursor->chunk);
+    }
+    if (cursor->has_result) {
+        impl->destroy_result(&cursor->result);
+        cursor->has_result = false;
+    }
+    if (cursor->prepared) {
+        impl->destroy_prepare(&cursor->prepared);
+    }
+    if (cursor->conn) {
+        impl->disconnect(&cursor->conn);
+    }
+    infra_free(cursor->types);
+    cursor->types = NULL;
+}
+
+static infra_error_t poly_duckdb_cursor_open(poly_db_cursor_t* cursor, const char* sql) {
+    duckdb_impl_t* impl = (duckdb_impl_t*)cursor->db->impl;
+    if (!impl->execute_prepared_streaming || !impl->fetch_chunk || !impl->destroy_data_chunk ||
+        !impl->data_chunk_get_size || !impl->data_chunk_get_vector || !impl->vector_get_data ||
+        !impl->vector_get_validity || !impl->column_count || !impl->column_name || !impl->column_type) {
+        return INFRA_ERROR_NOT_SUPPORTED;
+    }
+
+    if (impl->connect(impl->handle, &cursor->conn) != DuckDBSuccess) {
+        cursor->conn = NULL;
+        return INFRA_ERROR_EXEC_FAILED;
+    }
+    if (impl->prepare(cursor->conn, sql, &cursor->prepared) != DuckDBSuccess) {
+        poly_duckdb_cursor_close(cursor);
+        return INFRA_ERROR_QUERY_FAILED;
+    }
+    cursor->has_result = true;  // 失败时也要 destroy_result
+    if (impl->execute_prepared_streaming(cursor->prepared, &cursor->result) != DuckDBSuccess) {
+        poly_duckdb_cursor_close(cursor);
+        return INFRA_ERROR_QUERY_FAILED;
+    }
+
+    idx_t columns = impl->column_count(&cursor->result);
+    if (columns > 0) {
+        // 类型、数据、有效位三个数组一次分配
+        size_t size = columns * (sizeof(duckdb_type) + sizeof(void*) + sizeof(uint64_t*));
+        char* block = infra_malloc(size);
+        if (!block) {
+            poly_duckdb_cursor_close(cursor);
+            return INFRA_ERROR_NO_MEMORY;
+        }
+        memset(block, 0, size);
+        cursor->data = (void**)block;
+        cursor->validity = (uint64_t**)(block + columns * sizeof(void*));
+        cursor->types = (duckdb_type*)(block + columns * (sizeof(void*) + sizeof(uint64_t*)));
+        for (idx_t i = 0; i < columns; i++) {
+            cursor->types[i] = impl->column_type(&cursor->result, i);
+        }
+    }
+    cursor->columns = (int)columns;
+    return INFRA_OK;
+}
+
+// 换下一个非空 chunk, 取出每列的数据和有效位
+static infra_error_t poly_duckdb_cursor_fetch(poly_db_cursor_t* cursor) {
+    duckdb_impl_t* impl = (duckdb_impl_t*)cursor->db->impl;
+    for (;;) {
+        if (cursor->chunk) {
+            impl->destroy_data_chunk(&cursor->chunk);
+            cursor->chunk = NULL;
+        }
+        cursor->chunk = impl->fetch_chunk(cursor->result);
+        if (!cursor->chunk) {
+            return INFRA_ERROR_NOT_FOUND;
+        }
+        cursor->chunk_rows = impl->data_chunk_get_size(cursor->chunk);
+        if (cursor->chunk_rows > 0) {
+            break;
+        }
+    }
+    cursor->row = 0;
+    for (int i = 0; i < cursor->columns; i++) {
+        duckdb_vector vector = impl->data_chunk_get_vector(cursor->chunk, i);
+        cursor->data[i] = impl->vector_get_data(vector);
+        cursor->validity[i] = impl->vector_get_validity(vector);
+    }
+    return INFRA_OK;
+}
+
+static infra_error_t poly_duckdb_cursor_next(poly_db_cursor_t* cursor) {
+    if (cursor->chunk && ++cursor->row < cursor->chunk_rows) {
+        return INFRA_OK;
+    }
+    return poly_duckdb_cursor_fetch(cursor);
+}
+
+static poly_db_column_format_t duckdb_column_format(duckdb_type type) {
+    switch (type) {
+        case DUCKDB_TYPE_BOOLEAN:   return POLY_DB_COLUMN_BOOL;
+        case DUCKDB_TYPE_TINYINT:   return POLY_DB_COLUMN_INT8;
+        case DUCKDB_TYPE_SMALLINT:  return POLY_DB_COLUMN_INT16;
+        case DUCKDB_TYPE_INTEGER:
+        case DUCKDB_TYPE_DATE:      return POLY_DB_COLUMN_INT32;
+        case DUCKDB_TYPE_BIGINT:
+        case DUCKDB_TYPE_TIME:
+        case DUCKDB_TYPE_TIMESTAMP:
+        case DUCKDB_TYPE_TIMESTAMP_S:
+        case DUCKDB_TYPE_TIMESTAMP_MS:
+        case DUCKDB_TYPE_TIMESTAMP_NS:
+        case DUCKDB_TYPE_TIMESTAMP_TZ: return POLY_DB_COLUMN_INT64;
+        case DUCKDB_TYPE_UTINYINT:  return POLY_DB_COLUMN_UINT8;
+        case DUCKDB_TYPE_USMALLINT: return POLY_DB_COLUMN_UINT16;
+        case DUCKDB_TYPE_UINTEGER:  return POLY_DB_COLUMN_UINT32;
+        case DUCKDB_TYPE_UBIGINT:   return POLY_DB_COLUMN_UINT64;
+        case DUCKDB_TYPE_FLOAT:     return POLY_DB_COLUMN_FLOAT;
+        case DUCKDB_TYPE_DOUBLE:    return POLY_DB_COLUMN_DOUBLE;
+        case DUCKDB_TYPE_VARCHAR:
+        case DUCKDB_TYPE_BLOB:      return POLY_DB_COLUMN_STRING;
+        default:                    return POLY_DB_COLUMN_OTHER;
+    }
+}
+
+// 一个 chunk 就是一批, 向量直接交给调用者
+static infra_error_t poly_duckdb_cursor_next_batch(poly_db_cursor_t* cursor) {
+    infra_error_t err = poly_duckdb_cursor_fetch(cursor);
+    if (err != INFRA_OK) return err;
+
+    for (int i = 0; i < cursor->columns; i++) {
+        cursor->vectors[i].format = duckdb_column_format(cursor->types[i]);
+        cursor->vectors[i].data = cursor->data[i];
+        cursor->vectors[i].validity = cursor->validity[i];
+    }
+    cursor->batch.rows = cursor->chunk_rows;
+    cursor->row = cursor->chunk_rows;
+    return INFRA_OK;
+}
+
+static infra_error_t poly_duckdb_cursor_column(poly_db_cursor_t* cursor, int col, poly_db_value_t* value) {
+    if (!cursor->chunk) return INFRA_ERROR_NOT_FOUND;
+
+    idx_t row = cursor->row;
+    const uint64_t* validity = cursor->validity[col];
+    if (validity && !(validity[row / 64] & ((uint64_t)1 << (row % 64)))) {
+        value->type = POLY_DB_VALUE_NULL;
+        return INFRA_OK;
+    }
+
+    const void* data = cursor->data[col];
+    value->type = POLY_DB_VALUE_INTEGER;
+    switch (cursor->types[col]) {
+        case DUCKDB_TYPE_BOOLEAN:   value->i = ((const bool*)data)[row]; break;
+        case DUCKDB_TYPE_TINYINT:   value->i = ((const int8_t*)data)[row]; break;
+        case DUCKDB_TYPE_SMALLINT:  value->i = ((const int16_t*)data)[row]; break;
+        case DUCKDB_TYPE_INTEGER:   value->i = ((const int32_t*)data)[row]; break;
+        case DUCKDB_TYPE_BIGINT:    value->i = ((const int64_t*)data)[row]; break;
+        case DUCKDB_TYPE_UTINYINT:  value->i = ((const uint8_t*)data)[row]; break;
+        case DUCKDB_TYPE_USMALLINT: value->i = ((const uint16_t*)data)[row]; break;
+        case DUCKDB_TYPE_UINTEGER:  value->i = ((const uint32_t*)data)[row]; break;
+        case DUCKDB_TYPE_UBIGINT:   value->i = (int64_t)((const uint64_t*)data)[row]; break;
+        case DUCKDB_TYPE_DATE:      value->i = ((const int32_t*)data)[row]; break;
+        case DUCKDB_TYPE_TIME:
+        case DUCKDB_TYPE_TIMESTAMP:
+        case DUCKDB_TYPE_TIMESTAMP_S:
+        case DUCKDB_TYPE_TIMESTAMP_MS:
+        case DUCKDB_TYPE_TIMESTAMP_NS:
+        case DUCKDB_TYPE_TIMESTAMP_TZ:
+            value->i = ((const int64_t*)data)[row];
+            break;
+        case DUCKDB_TYPE_FLOAT:
+            value->type = POLY_DB_VALUE_REAL;
+            value->d = ((const float*)data)[row];
+            break;
+        case DUCKDB_TYPE_DOUBLE:
+            value->type = POLY_DB_VALUE_REAL;
+            value->d = ((const double*)data)[row];
+            break;
+        case DUCKDB_TYPE_VARCHAR:
+        case DUCKDB_TYPE_BLOB: {
+            // 不超过 12 字节的字符串内联在向量中, 更长的指向 chunk 持有的缓冲区
+            const duckdb_string_t* str = &((const duckdb_string_t*)data)[row];
+            value->type = cursor->types[col] == DUCKDB_TYPE_VARCHAR ? POLY_DB_VALUE_TEXT : POLY_DB_VALUE_BLOB;
+            value->len = str->value.inlined.length;
+            value->data = value->len <= sizeof(str->value.inlined.inlined)
+                        ? str->value.inlined.inlined : str->value.pointer.ptr;
+            break;
+        }
+        default:
+            value->type = POLY_DB_VALUE_OTHER;
+            break;
+    }
+    return INFRA_OK;
+}
+
+static const char* poly_duckdb_cursor_column_name(poly_db_cursor_t* cursor, int col) {
+    duckdb_impl_t* impl = (duckdb_impl_t*)cursor->db->impl;
+    return impl->column_name(&cursor->result, col);
+}
+
+// SQLite 批量导入: 复用一条 INSERT, 整个导入一个事务
+static bool sqlite_pragma_get(sqlite3* db, const char* sql, char* out, size_t size) {
+    sqlite3_stmt* stmt = NULL;
+    bool ok = false;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) == SQLITE_OK &&
+        sqlite3_step(stmt) == SQLITE_ROW) {
+        const char* text = (const char*)sqlite3_column_text(stmt, 0);
+        if (text) {
+            snprintf(out, size, "%s", text);
+            ok = true;
+        }
+    }
+    sqlite3_finalize(stmt);
+    return ok;
+}
+
+// 恢复导入前的设置, synchronous 在事务中不能修改, 要在提交或回滚之后
+static void sqlite_bulk_restore(poly_db_bulk_t* bulk) {
+    sqlite3* db = ((sqlite_impl_t*)bulk->db->impl)->db;
+    char* sql = sqlite3_mprintf("PRAGMA synchronous=%d; PRAGMA cache_size=%lld",
+                                bulk->old_synchronous, (long long)bulk->old_cache_size);
+    if (sql) {
+        sqlite3_exec(db, sql, NULL, NULL, NULL);
+        sqlite3_free(sql);
+    }
+    if (bulk->old_journal[0]) {
+        sql = sqlite3_mprintf("PRAGMA journal_mode=%s", bulk->old_journal);
+        if (sql) {
+            sqlite3_exec(db, sql, NULL, NULL, NULL);
+            sqlite3_free(sql);
+        }
+    }
+}
+
+static infra_error_t sqlite_bulk_begin(poly_db_bulk_t* bulk, const char* table) {
+    sqlite3* db = ((sqlite_impl_t*)bulk->db->impl)->db;
+    if (!sqlite3_get_autocommit(db)) {
+        INFRA_LOG_ERROR("Bulk load needs a handle without an open transaction");
+        return INFRA_ERROR_INVALID_STATE;
+    }
+
+    // 列数取自表定义
+    char* sql = sqlite3_mprintf("SELECT * FROM \"%w\"", table);
+    if (!sql) return INFRA_ERROR_NO_MEMORY;
+    sqlite3_stmt* probe = NULL;
+    int rc = sqlite3_prepare_v2(db, sql, -1, &probe, NULL);
+    sqlite3_free(sql);
+    if (rc != SQLITE_OK) {
+        INFRA_LOG_ERROR("Bulk load table error: %s", sqlite3_errmsg(db));
+        sqlite3_finalize(probe);
+        return INFRA_ERROR_QUERY_FAILED;
+    }
+    bulk->columns = sqlite3_column_count(probe);
+    sqlite3_finalize(probe);
+
+    char* head = sqlite3_mprintf("INSERT INTO \"%w\" VALUES (", table);
+    if (!head) return INFRA_ERROR_NO_MEMORY;
+    size_t head_len = strlen(head);
+    char* insert = infra_malloc(head_len + (size_t)bulk->columns * 2 + 2);
+    if (!insert) {
+        sqlite3_free(head);
+        return INFRA_ERROR_NO_MEMORY;
+    }
+    memcpy(insert, head, head_len);
+    sqlite3_free(head);
+    size_t len = head_len;
+    for (int i = 0; i < bulk->columns; i++) {
+        insert[len++] = i > 0 ? ',' : ' ';
+        insert[len++] = '?';
+    }
+    insert[len++] = ')';
+    insert[len] = '\0';
+    rc = sqlite3_prepare_v3(db, insert, -1, SQLITE_PREPARE_PERSISTENT, &bulk->insert, NULL);
+    infra_free(insert);
+    if (rc != SQLITE_OK) {
+        INFRA_LOG_ERROR("Failed to prepare bulk insert: %s", sqlite3_errmsg(db));
+        return INFRA_ERROR_QUERY_FAILED;
+    }
+
+    // 记下原设置再调整: 回滚日志放内存, 不 fsync, 页缓存放大到约 256MB
+    char value[32];
+    bulk->old_synchronous = sqlite_pragma_get(db, "PRAGMA synchronous", value, sizeof(value)) ? atoi(value) : 2;
+    bulk->old_cache_size = sqlite_pragma_get(db, "PRAGMA cache_size", value, sizeof(value)) ? atoll(value) : -2000;
+    if (sqlite_pragma_get(db, "PRAGMA journal_mode", value, sizeof(value)) &&
+        (strcmp(value, "delete") == 0 || strcmp(value, "truncate") == 0 || strcmp(value, "persist") == 0)) {
+        snprintf(bulk->old_journal, sizeof(bulk->old_journal), "%s", value);
+        sqlite3_exec(db, "PRAGMA journal_mode=MEMORY", NULL, NULL, NULL);
+    }
+    sqlite3_exec(db, "PRAGMA synchronous=OFF", NULL, NULL, NULL);
+    sqlite3_exec(db, "PRAGMA cache_size=-262144", NULL, NULL, NULL);
+
+    if (sqlite3_exec(db, "BEGIN", NULL, NULL, NULL) != SQLITE_OK) {
+        INFRA_LOG_ERROR("Failed to begin bulk load: %s", sqlite3_errmsg(db));
+        sqlite3_finalize(bulk->insert);
+        bulk->insert = NULL;
+        sqlite_bulk_restore(bulk);
+        return INFRA_ERROR_EXEC_FAILED;
+    }
+    return INFRA_OK;
+}
+
+static infra_error_t sqlite_bulk_append_row(poly_db_bulk_t* bulk, const poly_db_value_t* values) {
+    sqlite3_stmt* stmt = bulk->insert;
+    int rc = SQLITE_OK;
+    for (int i = 0; i < bulk->columns && rc == SQLITE_OK; i++) {
+        const poly_db_value_t* v = &values[i];
+        switch (v->type) {
+            case POLY_DB_VALUE_NULL:
+                rc = sqlite3_bind_null(stmt, i + 1);
+                break;
+            case POLY_DB_VALUE_INTEGER:
+                rc = sqlite3_bind_int64(stmt, i + 1, v->i);
+                break;
+            case POLY_DB_VALUE_REAL:
+                rc = sqlite3_bind_double(stmt, i + 1, v->d);
+                break;
+            case POLY_DB_VALUE_TEXT:
+                rc = sqlite3_bind_text64(stmt, i + 1, v->len ? v->data : "", v->len,
+                                         SQLITE_STATIC, SQLITE_UTF8);
+                break;
+            case POLY_DB_VALUE_BLOB:
+                // 指针为 NULL 时 SQLite 会绑定成 NULL, 空 BLOB 给一个非空指针
+                rc = sqlite3_bind_blob64(stmt, i + 1, v->len ? v->data : "", v->len, SQLITE_STATIC);
+                break;
+            default:
+                return INFRA_ERROR_INVALID_TYPE;
+        }
+    }
+    if (rc == SQLITE_OK) {
+        rc = sqlite3_step(stmt);
+    }
+    sqlite3_reset(stmt);
+    if (rc != SQLITE_DONE) {
+        INFRA_LOG_ERROR("Bulk insert failed: %s", sqlite3_errmsg(sqlite3_db_handle(stmt)));
+        return INFRA_ERROR_QUERY_FAILED;
+    }
+    return INFRA_OK;
+}
+
+static infra_error_t sqlite_bulk_end(poly_db_bulk_t* bulk, bool commit) {
+    sqlite3* db = ((sqlite_impl_t*)bulk->db->impl)->db;
+    infra_error_t err = INFRA_OK;
+    sqlite3_finalize(bulk->insert);
+    bulk->insert = NULL;
+
+    if (commit && sqlite3_exec(db, "COMMIT", NULL, NULL, NULL) != SQLITE_OK) {
+        INFRA_LOG_ERROR("Failed to commit bulk load: %s", sqlite3_errmsg(db));
+        err = INFRA_ERROR_EXEC_FAILED;
+        commit = false;
+    }
+    if (!commit && !sqlite3_get_autocommit(db)) {
+        sqlite3_exec(db, "ROLLBACK", NULL, NULL, NULL);
+    }
+    sqlite_bulk_restore(bulk);
+    // 提交时没有 fsync; WAL 下按恢复后的 synchronous 做一次 checkpoint, 把导入的数据落盘
+    if (commit && !bulk->old_journal[0] && bulk->old_synchronous > 0) {
+        sqlite3_wal_checkpoint_v2(db, NULL, SQLITE_CHECKPOINT_PASSIVE, NULL, NULL);
+    }
+    return err;
+}
+
+// DuckDB 批量导入: appender 在导入连接上的显式事务中写入
+static bool poly_duckdb_conn_exec(duckdb_impl_t* impl, duckdb_connection conn, const char* sql) {
+    duckdb_result result;
+    duckdb_state state = impl->query(conn, sql, &result);
+    impl->destroy_result(&result);
+    return state == DuckDBSuccess;
+}
+
+static infra_error_t poly_duckdb_bulk_begin(poly_db_bulk_t* bulk, const char* table) {
+    duckdb_impl_t* impl = (duckdb_impl_t*)bulk->db->impl;
+    if (!impl->appender_create || !impl->appender_column_count || !impl->appender_error ||
+        !impl->appender_close || !impl->appender_destroy || !impl->appender_end_row ||
+        !impl->append_null || !impl->append_int64 || !impl->append_double ||
+        !impl->append_varchar_length || !impl->append_blob) {
+        return INFRA_ERROR_NOT_SUPPORTED;
+    }
+
+    if (impl->connect(impl->handle, &bulk->conn) != DuckDBSuccess) {
+        bulk->conn = NULL;
+        return INFRA_ERROR_EXEC_FAILED;
+    }
+    if (!poly_duckdb_conn_exec(impl, bulk->conn, "BEGIN TRANSACTION")) {
+        impl->disconnect(&bulk->conn);
+        return INFRA_ERROR_EXEC_FAILED;
+    }
+    // 创建失败时也要 destroy
+    if (impl->appender_create(bulk->conn, NULL, table, &bulk->appender) != DuckDBSuccess) {
+        INFRA_LOG_ERROR("Failed to create appender: %s",
+            bulk->appender ? impl->appender_error(bulk->appender) : "unknown error");
+        impl->appender_destroy(&bulk->appender);
+        poly_duckdb_conn_exec(impl, bulk->conn, "ROLLBACK");
+        impl->disconnect(&bulk->conn);
+        return INFRA_ERROR_QUERY_FAILED;
+    }
+    bulk->columns = (int)impl->appender_column_count(bulk->appender);
+    return INFRA_OK;
+}
+
+static infra_error_t poly_duckdb_bulk_append_row(poly_db_bulk_t* bulk, const poly_db_value_t* values) {
+    duckdb_impl_t* impl = (duckdb_impl_t*)bulk->db->impl;
+    duckdb_state state = DuckDBSuccess;
+    for (int i = 0; i < bulk->columns && state == DuckDBSuccess; i++) {
+        const poly_db_value_t* v = &values[i];
+        switch (v->type) {
+            case POLY_DB_VALUE_NULL:
+                state = impl->append_null(bulk->appender);
+                break;
+            case POLY_DB_VALUE_INTEGER:
+                state = impl->append_int64(bulk->appender, v->i);
+                break;
+            case POLY_DB_VALUE_REAL:
+                state = impl->append_double(bulk->appender, v->d);
+                break;
+            case POLY_DB_VALUE_TEXT:
+                state = impl->append_varchar_length(bulk->appender, v->len ? v->data : "", v->len);
+                break;
+            case POLY_DB_VALUE_BLOB:
+                state = impl->append_blob(bulk->appender, v->len ? v->data : "", v->len);
+                break;
+            default:
+                return INFRA_ERROR_INVALID_TYPE;
+        }
+    }
+    if (state == DuckDBSuccess) {
+        state = impl->appender_end_row(bulk->appender);
+    }
+    if (state != DuckDBSuccess) {
+        INFRA_LOG_ERROR("Bulk append failed: %s", impl->appender_error(bulk->appender));
+        return INFRA_ERROR_QUERY_FAILED;
+    }
+    return INFRA_OK;
+}
+
+static infra_error_t poly_duckdb_bulk_end(poly_db_bulk_t* bulk, bool commit) {
+    duckdb_impl_t* impl = (duckdb_impl_t*)bulk->db->impl;
+    infra_error_t err = INFRA_OK;
+    // close 写出 appender 中剩余的行, 约束检查在这里才报错
+    if (commit && impl->appender_close(bulk->appender) != DuckDBSuccess) {
+        INFRA_LOG_ERROR("Failed to flush appender: %s", impl->appender_error(bulk->appender));
+        err = INFRA_ERROR_QUERY_FAILED;
+        commit = false;
+    }
+    impl->appender_destroy(&bulk->appender);
+    if (commit && !poly_duckdb_conn_exec(impl, bulk->conn, "COMMIT")) {
+        INFRA_LOG_ERROR("Failed to commit bulk load");
+        err = INFRA_ERROR_EXEC_FAILED;
+        commit = false;
+    }
+    if (!commit) {
+        poly_duckdb_conn_exec(impl, bulk->conn, "ROLLBACK");
+    }
+    impl->disconnect(&bulk->conn);
+    return err;
+}
+
+// 语句缓存
+static uint64_t stmt_cache_hash(const char* sql) {
+    uint64_t h = 14695981039346656037ULL;  // FNV-1a
+    while (*sql) {
+        h ^= (unsigned char)*sql++;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+// 真正释放缓存项中的语句, 调用者持有缓存锁
+static void stmt_cache_drop(poly_db_t* db, stmt_cache_entry_t* entry) {
+    if (entry->stmt) {
+        entry->stmt->cache_entry = NULL;
+        db->stmt_finalize(entry->stmt);
+    }
+    infra_free(entry->sql);
+    memset(entry, 0, sizeof(*entry));
+}
+
+// 查找空闲的同文本语句, 命中时标记为借出
+static poly_db_stmt_t* stmt_cache_acquire(poly_db_t* db, const char* sql, uint64_t hash) {
+    stmt_cache_t* cache = &db->stmt_cache;
+    for (int i = 0; i < POLY_DB_STMT_CACHE_SIZE; i++) {
+        stmt_cache_entry_t* entry = &cache->entries[i];
+        if (entry->sql && !entry->in_use && entry->hash == hash && strcmp(entry->sql, sql) == 0) {
+            entry->in_use = true;
+            entry->last_used = ++cache->clock;
+            return entry->stmt;
+        }
+    }
+    return NULL;
+}
+
+// 为新编译的语句找一个槽位: 优先空槽, 其次淘汰最久未用的空闲项
+// 所有槽位都被借出时返回 NULL, 语句不进缓存
+static stmt_cache_entry_t* stmt_cache_slot(poly_db_t* db) {
+    stmt_cache_t* cache = &db->stmt_cache;
+    stmt_cache_entry_t* victim = NULL;
+    for (int i = 0; i < POLY_DB_STMT_CACHE_SIZE; i++) {
+        stmt_cache_entry_t* entry = &cache->entries[i];
+        if (!entry->sql) return entry;
+        if (!entry->in_use && (!victim || entry->last_used < victim->last_used)) {
+            victim = entry;
+        }
+    }
+    if (victim) {
+        stmt_cache_drop(db, victim);
+        cache->evictions++;
+    }
+    return victim;
+}
+
+infra_error_t poly_db_get_stmt_cache_stats(poly_db_t* db, poly_db_stmt_cache_stats_t* stats) {
+    if (!db || !stats) return INFRA_ERROR_INVALID_PARAM;
+    stmt_cache_t* cache = &db->stmt_cache;
+
+    memset(stats, 0, sizeof(*stats));
+    if (cache->mutex) infra_mutex_lock(cache->mutex);
+    stats->hits = cache->hits;
+    stats->misses = cache->misses;
+    stats->evictions = cache->evictions;
+    for (int i = 0; i < POLY_DB_STMT_CACHE_SIZE; i++) {
+        if (cache->entries[i].sql) stats->entries++;
+    }
+    if (cache->mutex) infra_mutex_unlock(cache->mutex);
+    return INFRA_OK;
+}
+
+infra_error_t poly_db_stmt_cache_clear(poly_db_t* db) {
+    if (!db) return INFRA_ERROR_INVALID_PARAM;
+    stmt_cache_t* cache = &db->stmt_cache;
+    if (!cache->mutex) return INFRA_OK;
+
+    infra_mutex_lock(cache->mutex);
+    for (int i = 0; i < POLY_DB_STMT_CACHE_SIZE; i++) {
+        stmt_cache_entry_t* entry = &cache->entries[i];
+        if (!entry->sql) continue;
+        if (entry->in_use) {
+            // 借出中的语句脱离缓存, 由持有者 finalize 时真正释放
+            entry->stmt->cache_entry = NULL;
+            entry->stmt = NULL;
+        }
+        stmt_cache_drop(db, entry);
+    }
+    infra_mutex_unlock(cache->mutex);
+    return INFRA_OK;
+}
+
 // 公共接口函数
 infra_error_t poly_db_prepare(poly_db_t* db, const char* sql, poly_db_stmt_t** stmt) {
     if (!db || !sql || !stmt) return INFRA_ERROR_INVALID_PARAM;
-    return db->prepare(db, sql, stmt);
+    stmt_cache_t* cache = &db->stmt_cache;
+    if (!cache->mutex || !db->stmt_reset) {
+        return db->prepare(db, sql, stmt);
+    }
+
+    uint64_t hash = stmt_cache_hash(sql);
+    infra_mutex_lock(cache->mutex);
+    poly_db_stmt_t* cached = stmt_cache_acquire(db, sql, hash);
+    if (cached) {
+        cache->hits++;
+        infra_mutex_unlock(cache->mutex);
+        *stmt = cached;
+        return INFRA_OK;
+    }
+    cache->misses++;
+    infra_mutex_unlock(cache->mutex);
+
+    // 编译放在锁外, 同一条 SQL 并发未命中时各自编译, 都可以进缓存
+    poly_db_stmt_t* new_stmt = NULL;
+    infra_error_t err = db->prepare(db, sql, &new_stmt);
+    if (err != INFRA_OK) return err;
+    new_stmt->cache_entry = NULL;
+
+    char* sql_copy = infra_strdup(sql);
+    if (sql_copy) {
+        infra_mutex_lock(cache->mutex);
+        stmt_cache_entry_t* entry = stmt_cache_slot(db);
+        if (entry) {
+            entry->sql = sql_copy;
+            entry->hash = hash;
+            entry->stmt = new_stmt;
+            entry->in_use = true;
+            entry->last_used = ++cache->clock;
+            new_stmt->cache_entry = entry;
+            sql_copy = NULL;
+        }
+        infra_mutex_unlock(cache->mutex);
+        infra_free(sql_copy);
+    }
+
+    *stmt = new_stmt;
+    return INFRA_OK;
 }
 
 infra_error_t poly_db_stmt_finalize(poly_db_stmt_t* stmt) {
     if (!stmt || !stmt->db) return INFRA_ERROR_INVALID_PARAM;
-    return stmt->db->stmt_finalize(stmt);
+    poly_db_t* db = stmt->db;
+    stmt_cache_t* cache = &db->stmt_cache;
+
+    if (cache->mutex) {
+        infra_mutex_lock(cache->mutex);
+        stmt_cache_entry_t* entry = stmt->cache_entry;
+        if (entry) {
+            // 缓存语句只重置后归还; 重置失败则从缓存中移除
+            if (db->stmt_reset(stmt) == INFRA_OK) {
+                entry->in_use = false;
+                infra_mutex_unlock(cache->mutex);
+                return INFRA_OK;
+            }
+            stmt_cache_drop(db, entry);
+            infra_mutex_unlock(cache->mutex);
+            return INFRA_OK;
+        }
+        infra_mutex_unlock(cache->mutex);
+    }
+    return db->stmt_finalize(stmt);
 }
 
 infra_error_t poly_db_stmt_step(poly_db_stmt_t* stmt) {
@@ -711,8 +1654,11 @@ infra_error_t poly_db_open(const poly_db_config_t* config, poly_db_t** db) {
             memset(sqlite, 0, sizeof(sqlite_impl_t));
 
             // 打开 SQLite 数据库
-            int flags = config->read_only ? SQLITE_OPEN_READONLY : SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE;
-            flags |= SQLITE_OPEN_FULLMUTEX | SQLITE_OPEN_SHAREDCACHE | SQLITE_OPEN_URI;  // 添加 URI 支持
+            // 只读连接用私有缓存: 共享缓存内所有连接按表加锁并串行访问, 多个读连接无法并发,
+            // WAL 模式下私有缓存的读连接互不阻塞, 也不被写连接阻塞
+            int flags = config->read_only ? SQLITE_OPEN_READONLY | SQLITE_OPEN_PRIVATECACHE
+                                          : SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_SHAREDCACHE;
+            flags |= SQLITE_OPEN_FULLMUTEX | SQLITE_OPEN_URI;  // 添加 URI 支持
             const char* db_path = config->url;
             if (!db_path || strcmp(db_path, ":memory:") == 0) {
                 db_path = "file::memory:?cache=shared&mode=memory";  // 使用正确的 URI 格式
@@ -773,6 +1719,17 @@ infra_error_t poly_db_open(const poly_db_config_t* config, poly_db_t** db) {
             new_db->bind_blob = sqlite_bind_blob;
             new_db->column_blob = sqlite_column_blob;
             new_db->column_text = sqlite_column_text;
+            new_db->stmt_reset = sqlite_stmt_reset;
+            new_db->cursor_open = sqlite_cursor_open;
+            new_db->cursor_open_script = sqlite_cursor_open_script;
+            new_db->cursor_next = sqlite_cursor_next;
+            new_db->cursor_column = sqlite_cursor_column;
+            new_db->cursor_next_batch = sqlite_cursor_next_batch;
+            new_db->cursor_column_name = sqlite_cursor_column_name;
+            new_db->cursor_close = sqlite_cursor_close;
+            new_db->bulk_begin = sqlite_bulk_begin;
+            new_db->bulk_append_row = sqlite_bulk_append_row;
+            new_db->bulk_end = sqlite_bulk_end;
             break;
         }
         case POLY_DB_TYPE_DUCKDB: {
@@ -798,6 +1755,16 @@ infra_error_t poly_db_open(const poly_db_config_t* config, poly_db_t** db) {
             new_db->bind_blob = poly_duckdb_bind_blob;
             new_db->column_blob = poly_duckdb_column_blob;
             new_db->column_text = poly_duckdb_column_text;
+            new_db->stmt_reset = duckdb->clear_bindings ? poly_duckdb_stmt_reset : NULL;
+            new_db->cursor_open = poly_duckdb_cursor_open;
+            new_db->cursor_next = poly_duckdb_cursor_next;
+            new_db->cursor_column = poly_duckdb_cursor_column;
+            new_db->cursor_next_batch = poly_duckdb_cursor_next_batch;
+            new_db->cursor_column_name = poly_duckdb_cursor_column_name;
+            new_db->cursor_close = poly_duckdb_cursor_close;
+            new_db->bulk_begin = poly_duckdb_bulk_begin;
+            new_db->bulk_append_row = poly_duckdb_bulk_append_row;
+            new_db->bulk_end = poly_duckdb_bulk_end;
             break;
         }
         default:
@@ -805,12 +1772,23 @@ infra_error_t poly_db_open(const poly_db_config_t* config, poly_db_t** db) {
             return INFRA_ERROR_INVALID_PARAM;
     }
 
+    // 语句缓存锁创建失败时退化为不缓存
+    if (infra_mutex_create(&new_db->stmt_cache.mutex) != INFRA_OK) {
+        new_db->stmt_cache.mutex = NULL;
+    }
+
     *db = new_db;
     return INFRA_OK;
 }
 
 infra_error_t poly_db_close(poly_db_t* db) {
     if (!db) return INFRA_ERROR_INVALID_PARAM;
+    // 先释放缓存中的语句, 再关闭底层连接
+    if (db->stmt_cache.mutex) {
+        poly_db_stmt_cache_clear(db);
+        infra_mutex_destroy(db->stmt_cache.mutex);
+        db->stmt_cache.mutex = NULL;
+    }
     if (db->close) {
         db->close(db);  // close 函数会释放 db
         return INFRA_OK;
@@ -866,6 +1844,294 @@ poly_db_type_t poly_db_get_type(const poly_db_t* db) {
     return db ? db->type : POLY_DB_TYPE_UNKNOWN;
 }
 
+// 最近一次出错的描述; DuckDB 的错误跟着各自的结果对象, 这里拿不到
+const char* poly_db_get_error_message(const poly_db_t* db) {
+    if (!db || !db->impl) return "invalid database handle";
+    if (db->type == POLY_DB_TYPE_SQLITE) {
+        return sqlite3_errmsg(((sqlite_impl_t*)db->impl)->db);
+    }
+    return "unknown error";
+}
+
+infra_error_t poly_db_changes(poly_db_t* db, uint64_t* changes) {
+    if (!db || !db->impl || !changes) return INFRA_ERROR_INVALID_PARAM;
+
+    switch (db->type) {
+        case POLY_DB_TYPE_SQLITE:
+            *changes = (uint64_t)sqlite3_changes64(((sqlite_impl_t*)db->impl)->db);
+            return INFRA_OK;
+        case POLY_DB_TYPE_DUCKDB: {
+            duckdb_impl_t* impl = (duckdb_impl_t*)db->impl;
+            if (!impl->rows_changed) return INFRA_ERROR_NOT_SUPPORTED;
+            *changes = impl->last_changes;
+            return INFRA_OK;
+        }
+        default:
+            return INFRA_ERROR_NOT_SUPPORTED;
+    }
+}
+
+bool poly_db_in_transaction(poly_db_t* db) {
+    if (!db || !db->impl) return false;
+    switch (db->type) {
+        case POLY_DB_TYPE_SQLITE:
+            return !sqlite3_get_autocommit(((sqlite_impl_t*)db->impl)->db);
+        default:
+            return false;
+    }
+}
+
+// 流式游标
+infra_error_t poly_db_cursor_open(poly_db_t* db, const char* sql, poly_db_cursor_t** cursor) {
+    if (!db || !sql || !cursor) return INFRA_ERROR_INVALID_PARAM;
+    if (!db->cursor_open) return INFRA_ERROR_NOT_SUPPORTED;
+
+    poly_db_cursor_t* c = infra_malloc(sizeof(poly_db_cursor_t));
+    if (!c) return INFRA_ERROR_NO_MEMORY;
+    memset(c, 0, sizeof(*c));
+    c->db = db;
+
+    infra_error_t err = db->cursor_open(c, sql);
+    if (err != INFRA_OK) {
+        infra_free(c);
+        return err;
+    }
+    *cursor = c;
+    return INFRA_OK;
+}
+
+infra_error_t poly_db_cursor_open_script(poly_db_t* db, const char* sql, size_t len,
+                                        poly_db_cursor_t** cursor, const char** tail) {
+    if (!db || !sql || !cursor || !tail) return INFRA_ERROR_INVALID_PARAM;
+    *cursor = NULL;
+    *tail = sql + len;
+    if (!db->cursor_open_script) return INFRA_ERROR_NOT_SUPPORTED;
+
+    poly_db_cursor_t* c = infra_malloc(sizeof(poly_db_cursor_t));
+    if (!c) return INFRA_ERROR_NO_MEMORY;
+    memset(c, 0, sizeof(*c));
+    c->db = db;
+
+    infra_error_t err = db->cursor_open_script(c, sql, len, tail);
+    if (err != INFRA_OK) {
+        infra_free(c);
+        return err;
+    }
+    *cursor = c;
+    return INFRA_OK;
+}
+
+infra_error_t poly_db_cursor_next(poly_db_cursor_t* cursor) {
+    if (!cursor) return INFRA_ERROR_INVALID_PARAM;
+    if (cursor->done) return INFRA_ERROR_NOT_FOUND;
+    infra_error_t err = cursor->db->cursor_next(cursor);
+    cursor->done = err != INFRA_OK;
+    return err;
+}
+
+infra_error_t poly_db_cursor_close(poly_db_cursor_t* cursor) {
+    if (!cursor) return INFRA_ERROR_INVALID_PARAM;
+    cursor->db->cursor_close(cursor);
+    infra_free(cursor->vectors);
+    infra_free(cursor->values);
+    infra_free(cursor->value_bits);
+    infra_free(cursor->arena);
+    infra_free(cursor);
+    return INFRA_OK;
+}
+
+bool poly_db_cursor_readonly(poly_db_cursor_t* cursor) {
+    if (!cursor) return false;
+    switch (cursor->db->type) {
+        case POLY_DB_TYPE_SQLITE:
+            return sqlite3_stmt_readonly((sqlite3_stmt*)cursor->stmt->internal_stmt) != 0;
+        default:
+            return false;
+    }
+}
+
+int poly_db_cursor_column_count(poly_db_cursor_t* cursor) {
+    return cursor ? cursor->columns : 0;
+}
+
+const char* poly_db_cursor_column_name(poly_db_cursor_t* cursor, int col) {
+    if (!cursor || col < 0 || col >= cursor->columns) return NULL;
+    return cursor->db->cursor_column_name(cursor, col);
+}
+
+infra_error_t poly_db_cursor_column(poly_db_cursor_t* cursor, int col, poly_db_value_t* value) {
+    if (!cursor || !value || col < 0 || col >= cursor->columns) return INFRA_ERROR_INVALID_PARAM;
+    memset(value, 0, sizeof(*value));
+    return cursor->db->cursor_column(cursor, col, value);
+}
+
+infra_error_t poly_db_cursor_next_batch(poly_db_cursor_t* cursor, const poly_db_batch_t** batch) {
+    if (!cursor || !batch) return INFRA_ERROR_INVALID_PARAM;
+    *batch = NULL;
+    if (cursor->done) return INFRA_ERROR_NOT_FOUND;
+    if (!cursor->vectors && cursor->columns > 0) {
+        cursor->vectors = infra_malloc(cursor->columns * sizeof(poly_db_vector_t));
+        if (!cursor->vectors) return INFRA_ERROR_NO_MEMORY;
+        memset(cursor->vectors, 0, cursor->columns * sizeof(poly_db_vector_t));
+        cursor->batch.columns = cursor->columns;
+        cursor->batch.vectors = cursor->vectors;
+    }
+
+    infra_error_t err = cursor->db->cursor_next_batch(cursor);
+    if (err != INFRA_OK) cursor->done = true;
+    if (err == INFRA_OK) *batch = &cursor->batch;
+    return err;
+}
+
+infra_error_t poly_db_vector_get_string(const poly_db_vector_t* vector, size_t row,
+                                        const char** str, size_t* len) {
+    if (!vector || !str || !len) return INFRA_ERROR_INVALID_PARAM;
+    if (!poly_db_vector_is_valid(vector, row)) return INFRA_ERROR_NOT_FOUND;
+
+    if (vector->format == POLY_DB_COLUMN_STRING) {
+        const duckdb_string_t* s = &((const duckdb_string_t*)vector->data)[row];
+        *len = s->value.inlined.length;
+        *str = *len <= sizeof(s->value.inlined.inlined) ? s->value.inlined.inlined : s->value.pointer.ptr;
+        return INFRA_OK;
+    }
+    if (vector->format == POLY_DB_COLUMN_VALUE) {
+        const poly_db_value_t* value = &((const poly_db_value_t*)vector->data)[row];
+        if (value->type != POLY_DB_VALUE_TEXT && value->type != POLY_DB_VALUE_BLOB) {
+            return INFRA_ERROR_INVALID_PARAM;
+        }
+        *str = (const char*)value->data;
+        *len = value->len;
+        return INFRA_OK;
+    }
+    return INFRA_ERROR_INVALID_PARAM;
+}
+
+infra_error_t poly_db_bulk_begin(poly_db_t* db, const char* table, poly_db_bulk_t** bulk) {
+    if (!db || !table || !*table || !bulk) return INFRA_ERROR_INVALID_PARAM;
+    *bulk = NULL;
+
+    poly_db_bulk_t* new_bulk = infra_malloc(sizeof(poly_db_bulk_t));
+    if (!new_bulk) return INFRA_ERROR_NO_MEMORY;
+    memset(new_bulk, 0, sizeof(poly_db_bulk_t));
+    new_bulk->db = db;
+
+    infra_error_t err = db->bulk_begin(new_bulk, table);
+    if (err != INFRA_OK) {
+        infra_free(new_bulk);
+        return err;
+    }
+    *bulk = new_bulk;
+    return INFRA_OK;
+}
+
+infra_error_t poly_db_bulk_append_row(poly_db_bulk_t* bulk, const poly_db_value_t* values, int count) {
+    if (!bulk || !values || count != bulk->columns) return INFRA_ERROR_INVALID_PARAM;
+    if (bulk->failed) return INFRA_ERROR_INVALID_STATE;
+
+    infra_error_t err = bulk->db->bulk_append_row(bulk, values);
+    if (err != INFRA_OK) bulk->failed = true;
+    return err;
+}
+
+infra_error_t poly_db_bulk_end(poly_db_bulk_t* bulk, bool commit) {
+    if (!bulk) return INFRA_ERROR_INVALID_PARAM;
+    infra_error_t err = bulk->db->bulk_end(bulk, commit && !bulk->failed);
+    if (err == INFRA_OK && commit && bulk->failed) {
+        err = INFRA_ERROR_INVALID_STATE;
+    }
+    infra_free(bulk);
+    return err;
+}
+
+int poly_db_bulk_column_count(poly_db_bulk_t* bulk) {
+    return bulk ? bulk->columns : 0;
+}
+
+// 文本转数值: 整个字符串都要是数字, 与 SQLite 的宽松转换不同, 避免把脏数据读成 0
+static bool cursor_text_to_number(poly_db_cursor_t* cursor, const poly_db_value_t* value,
+                                  int64_t* i, double* d) {
+    if (value->len == 0 || value->len >= sizeof(cursor->scratch)) return false;
+    memcpy(cursor->scratch, value->data, value->len);
+    cursor->scratch[value->len] = '\0';
+    char* end = NULL;
+    if (i) {
+        *i = strtoll(cursor->scratch, &end, 10);
+    } else {
+        *d = strtod(cursor->scratch, &end);
+    }
+    return end && *end == '\0';
+}
+
+infra_error_t poly_db_cursor_get_int64(poly_db_cursor_t* cursor, int col, int64_t* value) {
+    if (!value) return INFRA_ERROR_INVALID_PARAM;
+    poly_db_value_t v;
+    infra_error_t err = poly_db_cursor_column(cursor, col, &v);
+    if (err != INFRA_OK) return err;
+
+    switch (v.type) {
+        case POLY_DB_VALUE_INTEGER: *value = v.i; return INFRA_OK;
+        case POLY_DB_VALUE_REAL: *value = (int64_t)v.d; return INFRA_OK;
+        case POLY_DB_VALUE_TEXT:
+            return cursor_text_to_number(cursor, &v, value, NULL) ? INFRA_OK : INFRA_ERROR_INVALID_PARAM;
+        case POLY_DB_VALUE_NULL: return INFRA_ERROR_NOT_FOUND;
+        default: return INFRA_ERROR_NOT_SUPPORTED;
+    }
+}
+
+infra_error_t poly_db_cursor_get_double(poly_db_cursor_t* cursor, int col, double* value) {
+    if (!value) return INFRA_ERROR_INVALID_PARAM;
+    poly_db_value_t v;
+    infra_error_t err = poly_db_cursor_column(cursor, col, &v);
+    if (err != INFRA_OK) return err;
+
+    switch (v.type) {
+        case POLY_DB_VALUE_INTEGER: *value = (double)v.i; return INFRA_OK;
+        case POLY_DB_VALUE_REAL: *value = v.d; return INFRA_OK;
+        case POLY_DB_VALUE_TEXT:
+            return cursor_text_to_number(cursor, &v, NULL, value) ? INFRA_OK : INFRA_ERROR_INVALID_PARAM;
+        case POLY_DB_VALUE_NULL: return INFRA_ERROR_NOT_FOUND;
+        default: return INFRA_ERROR_NOT_SUPPORTED;
+    }
+}
+
+// 数值格式化到游标的缓冲区, 下一次读取前有效
+infra_error_t poly_db_cursor_get_text(poly_db_cursor_t* cursor, int col, const char** text, size_t* len) {
+    if (!text || !len) return INFRA_ERROR_INVALID_PARAM;
+    poly_db_value_t v;
+    infra_error_t err = poly_db_cursor_column(cursor, col, &v);
+    if (err != INFRA_OK) return err;
+
+    int n;
+    switch (v.type) {
+        case POLY_DB_VALUE_TEXT:
+        case POLY_DB_VALUE_BLOB:
+            *text = (const char*)v.data;
+            *len = v.len;
+            return INFRA_OK;
+        case POLY_DB_VALUE_INTEGER:
+            n = snprintf(cursor->scratch, sizeof(cursor->scratch), "%lld", (long long)v.i);
+            break;
+        case POLY_DB_VALUE_REAL:
+            n = snprintf(cursor->scratch, sizeof(cursor->scratch), "%.17g", v.d);
+            break;
+        case POLY_DB_VALUE_NULL:
+            return INFRA_ERROR_NOT_FOUND;
+        default:
+            return INFRA_ERROR_NOT_SUPPORTED;
+    }
+    *text = cursor->scratch;
+    *len = (size_t)n;
+    return INFRA_OK;
+}
+
+infra_error_t poly_db_cursor_get_blob(poly_db_cursor_t* cursor, int col, const void** data, size_t* len) {
+    if (!data) return INFRA_ERROR_INVALID_PARAM;
+    const char* text = NULL;
+    infra_error_t err = poly_db_cursor_get_text(cursor, col, &text, len);
+    *data = err == INFRA_OK ? text : NULL;
+    return err;
+}
+
 // SQLite 实现的分块 BLOB 操作
 static infra_error_t sqlite_column_blob_size(poly_db_stmt_t* stmt, int col, size_t* size) {
     if (!stmt || !size) return INFRA_ERROR_INVALID_PARAM;
@@ -1073,3 +2339,270 @@ infra_error_t poly_db_bind_blob_update(poly_db_stmt_t* stmt, int index,
             return INFRA_ERROR_NOT_SUPPORTED;
     }
 }
+
+//-----------------------------------------------------------------------------
+// Group commit writer
+//-----------------------------------------------------------------------------
+
+// 记住最近若干个提交失败的事务编号, 等待中的调用者据此得知结果;
+// 被挤出的记录只保留最大编号, 不早于它的事务无法确认结果, 按失败处理
+#define POLY_DB_WRITER_FAILED_RING 16
+
+struct poly_db_writer {
+    poly_db_t* db;
+    poly_db_writer_config_t config;
+    infra_mutex_t mutex;        // 保护句柄和以下状态
+    infra_cond_t wake;          // 通知提交线程
+    infra_cond_t done;          // 通知 poly_db_writer_wait
+    infra_thread_t thread;
+    bool running;
+    bool in_txn;                // 事务已打开
+    bool dirty;                 // 事务中有修改
+    uint64_t txn_seq;           // 当前事务的编号, 从 1 开始
+    uint64_t finished_seq;      // 已结束 (提交或回滚) 的最大事务编号
+    uint64_t txn_ops;           // 当前事务修改的行数
+    uint64_t txn_first_ms;      // 当前事务第一次修改的时间
+    int64_t hold_changes;       // begin 时的累计修改行数
+    uint64_t failed[POLY_DB_WRITER_FAILED_RING];
+    uint32_t failed_next;
+    uint64_t failed_evicted;    // 被挤出环的最大失败编号
+    poly_db_writer_stats_t stats;
+};
+
+// 句柄累计修改的行数; 拿不到时返回 -1, 按每次持有都有修改处理
+static int64_t writer_total_changes(poly_db_t* db) {
+    if (db->type == POLY_DB_TYPE_SQLITE) {
+        return (int64_t)sqlite3_total_changes64(((sqlite_impl_t*)db->impl)->db);
+    }
+    return -1;
+}
+
+// 调用时持有 mutex
+static void writer_commit_locked(poly_db_writer_t* writer) {
+    if (!writer->in_txn) {
+        return;
+    }
+
+    infra_error_t err = poly_db_exec(writer->db, "COMMIT");
+    if (writer->dirty) {
+        if (err == INFRA_OK) {
+            writer->stats.commits++;
+            writer->stats.ops += writer->txn_ops;
+        } else {
+            INFRA_LOG_ERROR("Group commit of transaction %lu failed: %d",
+                            (unsigned long)writer->txn_seq, err);
+            poly_db_exec(writer->db, "ROLLBACK");
+            writer->stats.failures++;
+            uint64_t* slot = &writer->failed[writer->failed_next++ % POLY_DB_WRITER_FAILED_RING];
+            if (*slot > writer->failed_evicted) {
+                writer->failed_evicted = *slot;
+            }
+            *slot = writer->txn_seq;
+        }
+        writer->finished_seq = writer->txn_seq;
+        writer->txn_seq++;
+    } else if (err != INFRA_OK) {
+        poly_db_exec(writer->db, "ROLLBACK");
+    }
+    writer->in_txn = false;
+    writer->dirty = false;
+    writer->txn_ops = 0;
+}
+
+static bool writer_commit_due(poly_db_writer_t* writer, uint64_t now, uint32_t* wait_ms) {
+    if (!writer->dirty) {
+        *wait_ms = 1000;
+        return false;
+    }
+    uint64_t elapsed = now - writer->txn_first_ms;
+    if (writer->txn_ops >= writer->config.max_ops || elapsed >= writer->config.max_delay_ms) {
+        return true;
+    }
+    *wait_ms = (uint32_t)(writer->config.max_delay_ms - elapsed);
+    return false;
+}
+
+static void* writer_thread(void* arg) {
+    poly_db_writer_t* writer = (poly_db_writer_t*)arg;
+
+    infra_mutex_lock(writer->mutex);
+    while (writer->running) {
+        uint32_t wait_ms = 0;
+        if (!writer_commit_due(writer, infra_time_ms(), &wait_ms)) {
+            infra_cond_timedwait(writer->wake, writer->mutex, wait_ms);
+            continue;
+        }
+
+        writer_commit_locked(writer);
+        infra_cond_broadcast(writer->done);
+        // 回调里通常要唤醒等待的线程, 不持锁调用
+        infra_mutex_unlock(writer->mutex);
+        if (writer->config.on_commit) {
+            writer->config.on_commit(writer->config.on_commit_arg);
+        }
+        infra_mutex_lock(writer->mutex);
+    }
+
+    // 提交剩余写入
+    writer_commit_locked(writer);
+    infra_cond_broadcast(writer->done);
+    infra_mutex_unlock(writer->mutex);
+    if (writer->config.on_commit) {
+        writer->config.on_commit(writer->config.on_commit_arg);
+    }
+    return NULL;
+}
+
+infra_error_t poly_db_writer_create(poly_db_t* db, const poly_db_writer_config_t* config,
+                                    poly_db_writer_t** writer) {
+    if (!db || !config || !writer) return INFRA_ERROR_INVALID_PARAM;
+
+    // 持久化模式: WAL 下提交只顺序追加日志, FULL 保证提交返回时日志已落盘
+    if (config->durable && db->type == POLY_DB_TYPE_SQLITE) {
+        infra_error_t err = poly_db_exec(db, "PRAGMA journal_mode=WAL");
+        if (err == INFRA_OK) {
+            err = poly_db_exec(db, "PRAGMA synchronous=FULL");
+        }
+        if (err != INFRA_OK) {
+            INFRA_LOG_ERROR("Failed to enable durable commits: %d", err);
+            return err;
+        }
+    }
+
+    poly_db_writer_t* w = infra_malloc(sizeof(poly_db_writer_t));
+    if (!w) return INFRA_ERROR_NO_MEMORY;
+    memset(w, 0, sizeof(*w));
+    w->db = db;
+    w->config = *config;
+    if (w->config.max_ops == 0) {
+        w->config.max_ops = 1;
+    }
+    w->txn_seq = 1;
+    w->running = true;
+
+    infra_error_t err = infra_mutex_create(&w->mutex);
+    if (err == INFRA_OK) {
+        err = infra_cond_init(&w->wake);
+    }
+    if (err == INFRA_OK) {
+        err = infra_cond_init(&w->done);
+    }
+    if (err == INFRA_OK) {
+        err = infra_thread_create(&w->thread, writer_thread, w);
+    }
+    if (err != INFRA_OK) {
+        if (w->done) infra_cond_destroy(w->done);
+        if (w->wake) infra_cond_destroy(w->wake);
+        if (w->mutex) infra_mutex_destroy(w->mutex);
+        infra_free(w);
+        return err;
+    }
+
+    *writer = w;
+    return INFRA_OK;
+}
+
+void poly_db_writer_destroy(poly_db_writer_t* writer) {
+    if (!writer) return;
+
+    infra_mutex_lock(writer->mutex);
+    writer->running = false;
+    infra_cond_signal(writer->wake);
+    infra_mutex_unlock(writer->mutex);
+    infra_thread_join(writer->thread);
+
+    infra_cond_destroy(writer->done);
+    infra_cond_destroy(writer->wake);
+    infra_mutex_destroy(writer->mutex);
+    infra_free(writer);
+}
+
+poly_db_t* poly_db_writer_begin(poly_db_writer_t* writer) {
+    if (!writer) return NULL;
+
+    infra_mutex_lock(writer->mutex);
+    if (!writer->in_txn) {
+        if (poly_db_exec(writer->db, "BEGIN") != INFRA_OK) {
+            infra_mutex_unlock(writer->mutex);
+            return NULL;
+        }
+        writer->in_txn = true;
+    }
+    writer->hold_changes = writer_total_changes(writer->db);
+    return writer->db;
+}
+
+uint64_t poly_db_writer_end(poly_db_writer_t* writer) {
+    if (!writer) return 0;
+
+    int64_t total = writer_total_changes(writer->db);
+    uint64_t ops = total < 0 ? 1 : (uint64_t)(total - writer->hold_changes);
+    if (ops > 0) {
+        if (!writer->dirty) {
+            writer->dirty = true;
+            writer->txn_first_ms = infra_time_ms();
+        }
+        writer->txn_ops += ops;
+        // 第一次修改时提交线程要开始计时, 攒够一批时要立即提交
+        if (writer->txn_ops == ops || writer->txn_ops >= writer->config.max_ops) {
+            infra_cond_signal(writer->wake);
+        }
+    }
+
+    uint64_t ticket = 0;
+    if (writer->dirty) {
+        // 本次读到的数据可能来自本事务中尚未提交的修改
+        ticket = writer->txn_seq;
+    } else {
+        // 只读的事务立即结束, 不长期占用快照
+        writer_commit_locked(writer);
+    }
+    infra_mutex_unlock(writer->mutex);
+    return ticket;
+}
+
+static infra_error_t writer_check_locked(poly_db_writer_t* writer, uint64_t first, uint64_t last) {
+    if (last > writer->finished_seq) {
+        return INFRA_ERROR_WOULD_BLOCK;
+    }
+    if (first <= writer->failed_evicted) {
+        return INFRA_ERROR_IO;
+    }
+    for (int i = 0; i < POLY_DB_WRITER_FAILED_RING; i++) {
+        if (writer->failed[i] && writer->failed[i] >= first && writer->failed[i] <= last) {
+            return INFRA_ERROR_IO;
+        }
+    }
+    return INFRA_OK;
+}
+
+infra_error_t poly_db_writer_check(poly_db_writer_t* writer, uint64_t first, uint64_t last) {
+    if (!writer) return INFRA_ERROR_INVALID_PARAM;
+    if (last == 0) return INFRA_OK;
+
+    infra_mutex_lock(writer->mutex);
+    infra_error_t err = writer_check_locked(writer, first ? first : last, last);
+    infra_mutex_unlock(writer->mutex);
+    return err;
+}
+
+infra_error_t poly_db_writer_wait(poly_db_writer_t* writer, uint64_t ticket) {
+    if (!writer) return INFRA_ERROR_INVALID_PARAM;
+    if (ticket == 0) return INFRA_OK;
+
+    infra_mutex_lock(writer->mutex);
+    infra_error_t err;
+    while ((err = writer_check_locked(writer, ticket, ticket)) == INFRA_ERROR_WOULD_BLOCK) {
+        infra_cond_wait(writer->done, writer->mutex);
+    }
+    infra_mutex_unlock(writer->mutex);
+    return err;
+}
+
+void poly_db_writer_get_stats(poly_db_writer_t* writer, poly_db_writer_stats_t* stats) {
+    if (!writer || !stats) return;
+
+    infra_mutex_lock(writer->mutex);
+    *stats = writer->stats;
+    infra_mutex_unlock(writer->mutex);
+}
@@ -39,6 +39,18 @@ typedef struct poly_db_config {
     bool allow_fallback;        // Allow fallback to SQLite if DuckDB fails
 } poly_db_config_t;
 
+// Prepared statement cache
+// poly_db_prepare() 按 SQL 文本复用已编译的语句, poly_db_stmt_finalize()
+// 对缓存语句只做 reset + clear bindings 并归还缓存, 真正释放在 poly_db_close()
+#define POLY_DB_STMT_CACHE_SIZE 32
+
+typedef struct poly_db_stmt_cache_stats {
+    uint64_t hits;              // 命中缓存, 省去一次 prepare
+    uint64_t misses;            // 未命中, 新编译语句
+    uint64_t evictions;         // 缓存满时淘汰的语句数
+    size_t entries;             // 当前缓存的语句数
+} poly_db_stmt_cache_stats_t;
+
 // Database interface functions
 infra_error_t poly_db_open(const poly_db_config_t* config, poly_db_t** db);
 infra_error_t poly_db_close(poly_db_t* db);
@@ -61,9 +73,186 @@ infra_error_t poly_db_column_blob_size(poly_db_stmt_t* stmt, int col, size_t* si
 infra_error_t poly_db_column_blob_chunk(poly_db_stmt_t* stmt, int col, void* buffer, size_t size, size_t offset, size_t* read_size);
 infra_error_t poly_db_column_text(poly_db_stmt_t* stmt, int col, char** text);
 
+// Statement cache functions
+infra_error_t poly_db_get_stmt_cache_stats(poly_db_t* db, poly_db_stmt_cache_stats_t* stats);
+infra_error_t poly_db_stmt_cache_clear(poly_db_t* db);
+
 // Status functions
 poly_db_status_t poly_db_get_status(const poly_db_t* db);
 const char* poly_db_get_error_message(const poly_db_t* db);
 poly_db_type_t poly_db_get_type(const poly_db_t* db);
 
+// 最近一条 INSERT/UPDATE/DELETE 修改的行数, 用于条件写入判断是否生效
+infra_error_t poly_db_changes(poly_db_t* db, uint64_t* changes);
+// 是否处于显式事务中 (BEGIN 之后, COMMIT/ROLLBACK 之前); 目前只有 SQLite 能判断
+bool poly_db_in_transaction(poly_db_t* db);
+
+//-----------------------------------------------------------------------------
+// Streaming cursor
+//
+// 只进游标: 逐行读取查询结果, 不整体物化, 任意行数只占常量内存. 列值以指针+长度
+// 返回, 指向引擎内部的缓冲区, 只在下一次 poly_db_cursor_next 之前有效, 读取不分配
+// 内存. SQLite 直接 step 语句, DuckDB 按 data chunk 流式拉取.
+//-----------------------------------------------------------------------------
+
+struct poly_db_cursor;
+typedef struct poly_db_cursor poly_db_cursor_t;
+
+typedef enum poly_db_value_type {
+    POLY_DB_VALUE_NULL = 0,
+    POLY_DB_VALUE_INTEGER = 1,
+    POLY_DB_VALUE_REAL = 2,
+    POLY_DB_VALUE_TEXT = 3,
+    POLY_DB_VALUE_BLOB = 4,
+    POLY_DB_VALUE_OTHER = 5     // 引擎特有类型 (DECIMAL, LIST 等), 不能按值读取
+} poly_db_value_type_t;
+
+// 当前行的一个列值, TEXT 不保证以 '\0' 结尾
+typedef struct poly_db_value {
+    poly_db_value_type_t type;
+    int64_t i;                  // INTEGER (布尔为 0/1, 日期时间为引擎的原始计数)
+    double d;                   // REAL
+    const void* data;           // TEXT/BLOB
+    size_t len;
+} poly_db_value_t;
+
+// 只执行 sql 中的第一条语句; SQLite 复用语句缓存
+infra_error_t poly_db_cursor_open(poly_db_t* db, const char* sql, poly_db_cursor_t** cursor);
+// 依次执行多条语句的脚本: 只打开 sql[0, len) 开头的一条, *tail 指向其后剩余的文本;
+// 只剩空白或注释时返回 INFRA_ERROR_NOT_FOUND. 不经过语句缓存, 目前只有 SQLite 支持
+infra_error_t poly_db_cursor_open_script(poly_db_t* db, const char* sql, size_t len,
+                                        poly_db_cursor_t** cursor, const char** tail);
+// INFRA_OK 移到下一行, INFRA_ERROR_NOT_FOUND 已无更多行, 其他为执行出错
+infra_error_t poly_db_cursor_next(poly_db_cursor_t* cursor);
+infra_error_t poly_db_cursor_close(poly_db_cursor_t* cursor);
+
+// 语句是否不修改数据库, 用于把查询分给只读连接. SQLite 中 BEGIN/COMMIT 等事务控制语句
+// 也算只读; 无法判断的引擎返回 false
+bool poly_db_cursor_readonly(poly_db_cursor_t* cursor);
+int poly_db_cursor_column_count(poly_db_cursor_t* cursor);
+const char* poly_db_cursor_column_name(poly_db_cursor_t* cursor, int col);
+infra_error_t poly_db_cursor_column(poly_db_cursor_t* cursor, int col, poly_db_value_t* value);
+
+// 按类型读取, 数值与文本之间自动转换; NULL 返回 INFRA_ERROR_NOT_FOUND
+infra_error_t poly_db_cursor_get_int64(poly_db_cursor_t* cursor, int col, int64_t* value);
+infra_error_t poly_db_cursor_get_double(poly_db_cursor_t* cursor, int col, double* value);
+infra_error_t poly_db_cursor_get_text(poly_db_cursor_t* cursor, int col, const char** text, size_t* len);
+infra_error_t poly_db_cursor_get_blob(poly_db_cursor_t* cursor, int col, const void** data, size_t* len);
+
+//-----------------------------------------------------------------------------
+// Columnar batches
+//
+// 按列批量读取游标: DuckDB 直接交出一个 data chunk 的向量, 定长类型是原生数组,
+// 不拷贝也不逐值调用; SQLite 攒最多 POLY_DB_BATCH_ROWS 行转成列. 批次在下一次
+// 读取前有效. 同一个游标只用 poly_db_cursor_next 或只用 poly_db_cursor_next_batch.
+//-----------------------------------------------------------------------------
+
+#define POLY_DB_BATCH_ROWS 1024
+
+// 列数据的物理格式, 决定 poly_db_vector_t.data 的元素类型
+typedef enum poly_db_column_format {
+    POLY_DB_COLUMN_OTHER = 0,   // 不能直接读取的引擎特有类型
+    POLY_DB_COLUMN_BOOL,        // bool
+    POLY_DB_COLUMN_INT8,
+    POLY_DB_COLUMN_INT16,
+    POLY_DB_COLUMN_INT32,       // 也用于 DuckDB DATE (天数)
+    POLY_DB_COLUMN_INT64,       // 也用于 DuckDB TIME/TIMESTAMP (原始计数)
+    POLY_DB_COLUMN_UINT8,
+    POLY_DB_COLUMN_UINT16,
+    POLY_DB_COLUMN_UINT32,
+    POLY_DB_COLUMN_UINT64,
+    POLY_DB_COLUMN_FLOAT,
+    POLY_DB_COLUMN_DOUBLE,
+    POLY_DB_COLUMN_STRING,      // 引擎内部的字符串表示, 用 poly_db_vector_get_string 读取
+    POLY_DB_COLUMN_VALUE        // poly_db_value_t 数组 (SQLite, 每行类型可以不同)
+} poly_db_column_format_t;
+
+typedef struct poly_db_vector {
+    poly_db_column_format_t format;
+    const void* data;           // rows 个元素
+    const uint64_t* validity;   // 第 i 行非 NULL 时第 i 位为 1; NULL 表示全部非 NULL
+} poly_db_vector_t;
+
+typedef struct poly_db_batch {
+    size_t rows;
+    int columns;
+    const poly_db_vector_t* vectors;
+} poly_db_batch_t;
+
+// INFRA_OK 返回下一批 (rows > 0), INFRA_ERROR_NOT_FOUND 已无更多行
+infra_error_t poly_db_cursor_next_batch(poly_db_cursor_t* cursor, const poly_db_batch_t** batch);
+
+static inline bool poly_db_vector_is_valid(const poly_db_vector_t* vector, size_t row) {
+    return !vector->validity || ((vector->validity[row / 64] >> (row % 64)) & 1);
+}
+
+// STRING 和 VALUE 列中文本/二进制值的视图, 不以 '\0' 结尾
+infra_error_t poly_db_vector_get_string(const poly_db_vector_t* vector, size_t row,
+                                        const char** str, size_t* len);
+
+//-----------------------------------------------------------------------------
+// Bulk load
+//
+// 大批量导入一张表: 整个导入是一个事务, 每行一次调用, 不经过 SQL 解析.
+// DuckDB 走 appender, 按 data chunk 攒行后整块写入; SQLite 复用一条编译好的
+// INSERT, 导入期间关闭 synchronous, 放大页缓存, 回滚日志改在内存 (WAL 不变),
+// 结束时恢复原设置, WAL 数据库随后做一次 checkpoint 落盘. 非 WAL 的数据库在导入
+// 期间掉电或崩溃可能损坏, 适合可以重做的初始加载. begin 到 end 之间独占句柄.
+//-----------------------------------------------------------------------------
+
+typedef struct poly_db_bulk poly_db_bulk_t;
+
+// 按表定义顺序写入 table 的全部列, 调用时句柄上不能有打开的事务
+infra_error_t poly_db_bulk_begin(poly_db_t* db, const char* table, poly_db_bulk_t** bulk);
+// count 必须等于表的列数. 值只在调用期间被读取. 任何一行失败后导入只能回滚
+infra_error_t poly_db_bulk_append_row(poly_db_bulk_t* bulk, const poly_db_value_t* values, int count);
+// commit 为 false 或之前有行失败时回滚; 无论结果如何都释放 bulk
+infra_error_t poly_db_bulk_end(poly_db_bulk_t* bulk, bool commit);
+int poly_db_bulk_column_count(poly_db_bulk_t* bulk);
+
+//-----------------------------------------------------------------------------
+// Group commit writer
+//
+// 多个线程的写入共用一个句柄上的同一个事务, 由后台线程每隔 max_delay_ms 或
+// 累计 max_ops 行修改时提交一次, 把每次写入一个事务的提交开销 (日志 I/O, fsync)
+// 分摊到整批写入上. 调用者在 begin/end 之间独占句柄, end 返回的 ticket 在其
+// 事务提交后才算生效, 响应应在此之后再发送.
+//-----------------------------------------------------------------------------
+
+struct poly_db_writer;
+typedef struct poly_db_writer poly_db_writer_t;
+
+typedef struct poly_db_writer_config {
+    uint32_t max_delay_ms;      // 第一次修改后最多等待多久提交
+    uint32_t max_ops;           // 事务中修改的行数达到该值时立即提交
+    bool durable;               // SQLite: WAL + synchronous=FULL, 提交完成即已落盘
+    void (*on_commit)(void* arg);  // 每次提交结束 (成功或失败) 后在提交线程上调用
+    void* on_commit_arg;
+} poly_db_writer_config_t;
+
+typedef struct poly_db_writer_stats {
+    uint64_t commits;           // 提交的事务数
+    uint64_t ops;               // 提交的修改行数
+    uint64_t failures;          // 提交失败并回滚的事务数
+} poly_db_writer_stats_t;
+
+// 句柄归调用者所有, 在 poly_db_writer_destroy 之后关闭
+infra_error_t poly_db_writer_create(poly_db_t* db, const poly_db_writer_config_t* config,
+                                    poly_db_writer_t** writer);
+// 提交剩余写入并停止提交线程
+void poly_db_writer_destroy(poly_db_writer_t* writer);
+
+// 独占句柄, 返回时已处于打开的事务中, 不能再 BEGIN/COMMIT
+poly_db_t* poly_db_writer_begin(poly_db_writer_t* writer);
+// 释放句柄, 返回本次读写依赖的事务编号, 0 表示不依赖未提交的数据
+uint64_t poly_db_writer_end(poly_db_writer_t* writer);
+
+// 检查编号在 [first, last] 内的事务: INFRA_OK 全部已提交,
+// INFRA_ERROR_WOULD_BLOCK 尚未提交, INFRA_ERROR_IO 其中有提交失败 (或失败记录已被挤出无法确认) 的事务
+infra_error_t poly_db_writer_check(poly_db_writer_t* writer, uint64_t first, uint64_t last);
+// 阻塞到 ticket 所在的事务提交, 返回值同 poly_db_writer_check
+infra_error_t poly_db_writer_wait(poly_db_writer_t* writer, uint64_t ticket);
+
+void poly_db_writer_get_stats(poly_db_writer_t* writer, poly_db_writer_stats_t* stats);
+
 #endif // POLY_DB_H
@@ -382,3 +382,384 @@ void poly_poll_cleanup(poly_poll_context_t* ctx) {
     // Clear context
     memset(ctx, 0, sizeof(poly_poll_context_t));
 }
+
+//-----------------------------------------------------------------------------
+// Event Loop
+//-----------------------------------------------------------------------------
+
+#if defined(__linux__) || defined(__COSMOPOLITAN__)
+#define POLY_POLL_HAVE_EPOLL 1
+#include <sys/epoll.h>
+#endif
+
+#define POLY_POLL_BACKEND_POLL  0
+#define POLY_POLL_BACKEND_EPOLL 1
+
+struct poly_poll_loop {
+    int backend;                // 后端类型
+    int epfd;                   // epoll 描述符
+    int wake_fds[2];            // 唤醒管道
+    atomic_bool wake_pending;   // 是否已有未处理的唤醒
+    void** slots;               // fd -> user_data
+    int* index;                 // poll 后端: fd -> pfds 下标
+    size_t slot_capacity;
+    struct pollfd* pfds;        // poll 后端的 pollfd 数组 (下标 0 为唤醒管道)
+    size_t pfd_count;
+    size_t pfd_capacity;
+};
+
+static infra_error_t loop_reserve_slot(poly_poll_loop_t* loop, int fd) {
+    if (fd < 0) {
+        return INFRA_ERROR_INVALID_PARAM;
+    }
+    if ((size_t)fd < loop->slot_capacity) {
+        return INFRA_OK;
+    }
+
+    size_t new_capacity = loop->slot_capacity ? loop->slot_capacity : 64;
+    while (new_capacity <= (size_t)fd) {
+        new_capacity *= 2;
+    }
+
+    void** slots = infra_malloc(new_capacity * sizeof(void*));
+    int* index = infra_malloc(new_capacity * sizeof(int));
+    if (!slots || !index) {
+        if (slots) infra_free(slots);
+        if (index) infra_free(index);
+        return INFRA_ERROR_NO_MEMORY;
+    }
+
+    if (loop->slot_capacity > 0) {
+        memcpy(slots, loop->slots, loop->slot_capacity * sizeof(void*));
+        memcpy(index, loop->index, loop->slot_capacity * sizeof(int));
+        infra_free(loop->slots);
+        infra_free(loop->index);
+    }
+    loop->slots = slots;
+    loop->index = index;
+
+    for (size_t i = loop->slot_capacity; i < new_capacity; i++) {
+        loop->slots[i] = NULL;
+        loop->index[i] = -1;
+    }
+    loop->slot_capacity = new_capacity;
+    return INFRA_OK;
+}
+
+static short loop_to_poll_events(int events) {
+    short pe = 0;
+    if (events & POLY_POLL_READ) pe |= POLLIN;
+    if (events & POLY_POLL_WRITE) pe |= POLLOUT;
+    return pe;
+}
+
+static int loop_from_poll_events(short revents) {
+    int events = 0;
+    if (revents & POLLIN) events |= POLY_POLL_READ;
+    if (revents & POLLOUT) events |= POLY_POLL_WRITE;
+    if (revents & (POLLERR | POLLHUP | POLLNVAL)) events |= POLY_POLL_ERROR;
+    return events;
+}
+
+#ifdef POLY_POLL_HAVE_EPOLL
+static uint32_t loop_to_epoll_events(int events) {
+    uint32_t ee = 0;
+    if (events & POLY_POLL_READ) ee |= EPOLLIN | EPOLLRDHUP;
+    if (events & POLY_POLL_WRITE) ee |= EPOLLOUT;
+    return ee;
+}
+
+static int loop_from_epoll_events(uint32_t ee) {
+    int events = 0;
+    if (ee & EPOLLIN) events |= POLY_POLL_READ;
+    if (ee & EPOLLOUT) events |= POLY_POLL_WRITE;
+    if (ee & (EPOLLERR | EPOLLHUP | EPOLLRDHUP)) events |= POLY_POLL_ERROR;
+    return events;
+}
+#endif
+
+static infra_error_t loop_pfd_append(poly_poll_loop_t* loop, int fd, int events) {
+    if (loop->pfd_count >= loop->pfd_capacity) {
+        size_t new_capacity = loop->pfd_capacity ? loop->pfd_capacity * 2 : 64;
+        struct pollfd* pfds = infra_malloc(new_capacity * sizeof(struct pollfd));
+        if (!pfds) {
+            return INFRA_ERROR_NO_MEMORY;
+        }
+        if (loop->pfd_count > 0) {
+            memcpy(pfds, loop->pfds, loop->pfd_count * sizeof(struct pollfd));
+        }
+        infra_free(loop->pfds);
+        loop->pfds = pfds;
+        loop->pfd_capacity = new_capacity;
+    }
+
+    loop->pfds[loop->pfd_count].fd = fd;
+    loop->pfds[loop->pfd_count].events = loop_to_poll_events(events);
+    loop->pfds[loop->pfd_count].revents = 0;
+    loop->index[fd] = (int)loop->pfd_count;
+    loop->pfd_count++;
+    return INFRA_OK;
+}
+
+infra_error_t poly_poll_loop_create(poly_poll_loop_t** loop) {
+    if (!loop) {
+        return INFRA_ERROR_INVALID_PARAM;
+    }
+
+    poly_poll_loop_t* l = infra_malloc(sizeof(poly_poll_loop_t));
+    if (!l) {
+        return INFRA_ERROR_NO_MEMORY;
+    }
+    memset(l, 0, sizeof(poly_poll_loop_t));
+    l->epfd = -1;
+    atomic_init(&l->wake_pending, false);
+
+    if (pipe(l->wake_fds) != 0) {
+        INFRA_LOG_ERROR("Failed to create wakeup pipe: %s", strerror(errno));
+        infra_free(l);
+        return INFRA_ERROR_IO;
+    }
+    for (int i = 0; i < 2; i++) {
+        fcntl(l->wake_fds[i], F_SETFL, fcntl(l->wake_fds[i], F_GETFL, 0) | O_NONBLOCK);
+        fcntl(l->wake_fds[i], F_SETFD, FD_CLOEXEC);
+    }
+
+    infra_error_t err = loop_reserve_slot(l, l->wake_fds[0]);
+    if (err != INFRA_OK) {
+        poly_poll_loop_destroy(l);
+        return err;
+    }
+
+    l->backend = POLY_POLL_BACKEND_POLL;
+#ifdef POLY_POLL_HAVE_EPOLL
+    // epoll 不可用 (如非 Linux 的 cosmopolitan 目标) 时回退到 poll
+    l->epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (l->epfd >= 0) {
+        struct epoll_event ev = {0};
+        ev.events = EPOLLIN;
+        ev.data.fd = l->wake_fds[0];
+        if (epoll_ctl(l->epfd, EPOLL_CTL_ADD, l->wake_fds[0], &ev) == 0) {
+            l->backend = POLY_POLL_BACKEND_EPOLL;
+        } else {
+            close(l->epfd);
+            l->epfd = -1;
+        }
+    }
+#endif
+
+    if (l->backend == POLY_POLL_BACKEND_POLL) {
+        err = loop_pfd_append(l, l->wake_fds[0], POLY_POLL_READ);
+        if (err != INFRA_OK) {
+            poly_poll_loop_destroy(l);
+            return err;
+        }
+    }
+
+    *loop = l;
+    return INFRA_OK;
+}
+
+void poly_poll_loop_destroy(poly_poll_loop_t* loop) {
+    if (!loop) {
+        return;
+    }
+
+    if (loop->epfd >= 0) {
+        close(loop->epfd);
+    }
+    if (loop->wake_fds[0] > 0) close(loop->wake_fds[0]);
+    if (loop->wake_fds[1] > 0) close(loop->wake_fds[1]);
+
+    infra_free(loop->slots);
+    infra_free(loop->index);
+    infra_free(loop->pfds);
+    infra_free(loop);
+}
+
+infra_error_t poly_poll_loop_add(poly_poll_loop_t* loop, infra_socket_t sock,
+                                int events, void* user_data) {
+    if (!loop || sock < 0) {
+        return INFRA_ERROR_INVALID_PARAM;
+    }
+
+    int fd = (int)sock;
+    infra_error_t err = loop_reserve_slot(loop, fd);
+    if (err != INFRA_OK) {
+        return err;
+    }
+
+#ifdef POLY_POLL_HAVE_EPOLL
+    if (loop->backend == POLY_POLL_BACKEND_EPOLL) {
+        struct epoll_event ev = {0};
+        ev.events = loop_to_epoll_events(events);
+        ev.data.fd = fd;
+        if (epoll_ctl(loop->epfd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            return errno == EEXIST ? INFRA_ERROR_EXISTS : INFRA_ERROR_IO;
+        }
+        loop->slots[fd] = user_data;
+        return INFRA_OK;
+    }
+#endif
+
+    if (loop->index[fd] >= 0) {
+        return INFRA_ERROR_EXISTS;
+    }
+    err = loop_pfd_append(loop, fd, events);
+    if (err != INFRA_OK) {
+        return err;
+    }
+    loop->slots[fd] = user_data;
+    return INFRA_OK;
+}
+
+infra_error_t poly_poll_loop_modify(poly_poll_loop_t* loop, infra_socket_t sock,
+                                   int events, void* user_data) {
+    if (!loop || sock < 0 || (size_t)sock >= loop->slot_capacity) {
+        return INFRA_ERROR_INVALID_PARAM;
+    }
+
+    int fd = (int)sock;
+#ifdef POLY_POLL_HAVE_EPOLL
+    if (loop->backend == POLY_POLL_BACKEND_EPOLL) {
+        struct epoll_event ev = {0};
+        ev.events = loop_to_epoll_events(events);
+        ev.data.fd = fd;
+        if (epoll_ctl(loop->epfd, EPOLL_CTL_MOD, fd, &ev) != 0) {
+            return errno == ENOENT ? INFRA_ERROR_NOT_FOUND : INFRA_ERROR_IO;
+        }
+        loop->slots[fd] = user_data;
+        return INFRA_OK;
+    }
+#endif
+
+    int idx = loop->index[fd];
+    if (idx < 0) {
+        return INFRA_ERROR_NOT_FOUND;
+    }
+    loop->pfds[idx].events = loop_to_poll_events(events);
+    loop->slots[fd] = user_data;
+    return INFRA_OK;
+}
+
+infra_error_t poly_poll_loop_remove(poly_poll_loop_t* loop, infra_socket_t sock) {
+    if (!loop || sock < 0 || (size_t)sock >= loop->slot_capacity) {
+        return INFRA_ERROR_INVALID_PARAM;
+    }
+
+    int fd = (int)sock;
+    loop->slots[fd] = NULL;
+
+#ifdef POLY_POLL_HAVE_EPOLL
+    if (loop->backend == POLY_POLL_BACKEND_EPOLL) {
+        if (epoll_ctl(loop->epfd, EPOLL_CTL_DEL, fd, NULL) != 0) {
+            return errno == ENOENT ? INFRA_ERROR_NOT_FOUND : INFRA_ERROR_IO;
+        }
+        return INFRA_OK;
+    }
+#endif
+
+    int idx = loop->index[fd];
+    if (idx < 0) {
+        return INFRA_ERROR_NOT_FOUND;
+    }
+
+    // 用最后一项填补空位
+    size_t last = loop->pfd_count - 1;
+    if ((size_t)idx != last) {
+        loop->pfds[idx] = loop->pfds[last];
+        loop->index[loop->pfds[idx].fd] = idx;
+    }
+    loop->pfd_count--;
+    loop->index[fd] = -1;
+    return INFRA_OK;
+}
+
+static void loop_drain_wakeup(poly_poll_loop_t* loop) {
+    char buf[64];
+    while (read(loop->wake_fds[0], buf, sizeof(buf)) > 0) {
+    }
+    atomic_store(&loop->wake_pending, false);
+}
+
+infra_error_t poly_poll_loop_wait(poly_poll_loop_t* loop, poly_poll_event_t* events,
+                                 int max_events, int timeout_ms, int* count) {
+    if (!loop || !events || max_events <= 0 || !count) {
+        return INFRA_ERROR_INVALID_PARAM;
+    }
+
+    *count = 0;
+
+#ifdef POLY_POLL_HAVE_EPOLL
+    if (loop->backend == POLY_POLL_BACKEND_EPOLL) {
+        struct epoll_event evs[256];
+        int n = epoll_wait(loop->epfd, evs, max_events < 256 ? max_events : 256, timeout_ms);
+        if (n < 0) {
+            return errno == EINTR ? INFRA_OK : INFRA_ERROR_IO;
+        }
+
+        int out = 0;
+        for (int i = 0; i < n; i++) {
+            int fd = evs[i].data.fd;
+            if (fd == loop->wake_fds[0]) {
+                loop_drain_wakeup(loop);
+                continue;
+            }
+            events[out].sock = fd;
+            events[out].events = loop_from_epoll_events(evs[i].events);
+            events[out].user_data = (size_t)fd < loop->slot_capacity ? loop->slots[fd] : NULL;
+            out++;
+        }
+        *count = out;
+        return INFRA_OK;
+    }
+#endif
+
+    int n = poll(loop->pfds, (nfds_t)loop->pfd_count, timeout_ms);
+    if (n < 0) {
+        return errno == EINTR ? INFRA_OK : INFRA_ERROR_IO;
+    }
+
+    int out = 0;
+    for (size_t i = 0; i < loop->pfd_count && n > 0 && out < max_events; i++) {
+        if (!loop->pfds[i].revents) {
+            continue;
+        }
+        n--;
+        int fd = loop->pfds[i].fd;
+        if (fd == loop->wake_fds[0]) {
+            loop_drain_wakeup(loop);
+            continue;
+        }
+        events[out].sock = fd;
+        events[out].events = loop_from_poll_events(loop->pfds[i].revents);
+        events[out].user_data = loop->slots[fd];
+        out++;
+    }
+    *count = out;
+    return INFRA_OK;
+}
+
+infra_error_t poly_poll_loop_wakeup(poly_poll_loop_t* loop) {
+    if (!loop) {
+        return INFRA_ERROR_INVALID_PARAM;
+    }
+
+    // 合并重复唤醒, 避免管道写满
+    if (atomic_exchange(&loop->wake_pending, true)) {
+        return INFRA_OK;
+    }
+
+    char c = 1;
+    if (write(loop->wake_fds[1], &c, 1) < 0 && errno != EAGAIN) {
+        atomic_store(&loop->wake_pending, false);
+        return INFRA_ERROR_IO;
+    }
+    return INFRA_OK;
+}
+
+const char* poly_poll_loop_backend(const poly_poll_loop_t* loop) {
+    if (loop && loop->backend == POLY_POLL_BACKEND_EPOLL) {
+        return "epoll";
+    }
+    return "poll";
+}
@@ -97,4 +97,38 @@ infra_error_t poly_poll_get_events(poly_poll_t* poll, size_t index, int* events)
 infra_error_t poly_poll_get_socket(poly_poll_t* poll, size_t index, infra_socket_t* sock);
 size_t poly_poll_get_count(poly_poll_t* poll);
 
+//-----------------------------------------------------------------------------
+// 事件循环 (Linux 下使用 epoll, 其他平台回退到 poll)
+//-----------------------------------------------------------------------------
+
+// 就绪事件
+typedef struct poly_poll_event {
+    infra_socket_t sock;        // 就绪的套接字
+    int events;                 // POLY_POLL_READ/WRITE/ERROR
+    void* user_data;            // 注册时传入的用户数据
+} poly_poll_event_t;
+
+typedef struct poly_poll_loop poly_poll_loop_t;
+
+// 创建和销毁事件循环
+infra_error_t poly_poll_loop_create(poly_poll_loop_t** loop);
+void poly_poll_loop_destroy(poly_poll_loop_t* loop);
+
+// 注册/修改/移除套接字 (只能在事件循环线程中调用)
+infra_error_t poly_poll_loop_add(poly_poll_loop_t* loop, infra_socket_t sock,
+                                int events, void* user_data);
+infra_error_t poly_poll_loop_modify(poly_poll_loop_t* loop, infra_socket_t sock,
+                                   int events, void* user_data);
+infra_error_t poly_poll_loop_remove(poly_poll_loop_t* loop, infra_socket_t sock);
+
+// 等待就绪事件, 超时或被唤醒时 *count 为 0
+infra_error_t poly_poll_loop_wait(poly_poll_loop_t* loop, poly_poll_event_t* events,
+                                 int max_events, int timeout_ms, int* count);
+
+// 唤醒阻塞在 wait 中的事件循环 (线程安全)
+infra_error_t poly_poll_loop_wakeup(poly_poll_loop_t* loop);
+
+// 当前使用的后端 ("epoll" 或 "poll")
+const char* poly_poll_loop_backend(const poly_poll_loop_t* loop);
+
 #endif /* POLY_POLL_H */
@@ -11,6 +11,9 @@
 #ifdef DEV_SQLITE3
 #include "internal/peer/peer_sqlite3.h"
 #endif
+#ifdef DEV_DISKV
+#include "internal/peer/peer_diskv.h"
+#endif
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -32,6 +35,7 @@ static const char* get_service_type_name(poly_service_type_t type);
 static infra_error_t handle_rinetd_cmd(const poly_config_t* config, int argc, char** argv);
 static infra_error_t handle_sqlite3_cmd(const poly_config_t* config, int argc, char** argv);
 static infra_error_t handle_memkv_cmd(const poly_config_t* config, int argc, char** argv);
+static infra_error_t handle_diskv_cmd(const poly_config_t* config, int argc, char** argv);
 static infra_error_t handle_help_cmd(const poly_config_t* config, int argc, char** argv);
 
 // Global service registry
@@ -299,6 +303,13 @@ static void register_commands(void) {
             .options = service_options,
             .option_count = sizeof(service_options) / sizeof(service_options[0]),
             .handler = handle_memkv_cmd
+        },
+        {
+            .name = "diskv",
+            .desc = "Manage diskv service",
+            .options = service_options,
+            .option_count = sizeof(service_options) / sizeof(service_options[0]),
+            .handler = handle_diskv_cmd
         }
     };
 
@@ -782,6 +793,12 @@ static infra_error_t handle_memkv_cmd(const poly_config_t* config, int argc, cha
     const char* config_file = NULL;
     const char* engine = NULL;
     int port = 0;
+    int memory_mb = 0;
+    double factor = 0;
+    int threads = 0;
+    bool sharded = false;
+    bool hotcache = false;
+    int commit_ms = 0;
 
     for (int i = 2; i < argc; i++) {
         if (strcmp(argv[i], "--start") == 0) {
@@ -802,6 +819,31 @@ static infra_error_t handle_memkv_cmd(const poly_config_t* config, int argc, cha
         else if (strncmp(argv[i], "--port=", 7) == 0) {
             port = atoi(argv[i] + 7);
         }
+        else if (strncmp(argv[i], "--memory=", 9) == 0) {
+            memory_mb = atoi(argv[i] + 9);
+        }
+        else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+            memory_mb = atoi(argv[++i]);
+        }
+        else if (strncmp(argv[i], "--factor=", 9) == 0) {
+            factor = atof(argv[i] + 9);
+        }
+        else if (strncmp(argv[i], "--threads=", 10) == 0) {
+            threads = atoi(argv[i] + 10);
+        }
+        else if (strcmp(argv[i], "--sharded") == 0) {
+            sharded = true;
+        }
+        else if (strcmp(argv[i], "--hotcache") == 0) {
+            hotcache = true;
+        }
+        else if (strncmp(argv[i], "--commit-ms=", 12) == 0) {
+            // 0 关闭组提交, 每条写入单独提交
+            commit_ms = atoi(argv[i] + 12);
+            if (commit_ms <= 0) {
+                commit_ms = -1;
+            }
+        }
     }
 
     // Initialize service only if starting
@@ -832,7 +874,197 @@ static infra_error_t handle_memkv_cmd(const poly_config_t* config, int argc, cha
         service_config.services[0].listen_port = port;
     }
     if (engine) {
-        strncpy(service_config.services[0].backend, engine, sizeof(service_config.services[0].backend) - 1);
+        strncpy(service_config.services[0].engine, engine, sizeof(service_config.services[0].engine) - 1);
+    }
+    if (memory_mb > 0) {
+        service_config.services[0].memory_mb = memory_mb;
+    }
+    if (factor > 0) {
+        service_config.services[0].growth_factor = factor;
+    }
+    if (threads > 0) {
+        service_config.services[0].threads = threads;
+    }
+    if (sharded) {
+        service_config.services[0].sharded = true;
+    }
+    if (hotcache) {
+        service_config.services[0].hotcache = true;
+    }
+    if (commit_ms != 0) {
+        service_config.services[0].commit_ms = commit_ms;
+    }
+
+    // Apply configuration
+    err = service->apply_config(&service_config.services[0]);
+    if (err != INFRA_OK) {
+        fprintf(stderr, "Failed to apply configuration: %d\n", err);
+        return err;
+    }
+
+    // Execute command
+    char response[MAX_CMD_RESPONSE] = {0};
+    if (start) {
+        err = service->cmd_handler("start", response, sizeof(response));
+    }
+    else if (stop) {
+        err = service->cmd_handler("stop", response, sizeof(response));
+    }
+    else if (status) {
+        err = service->cmd_handler("status", response, sizeof(response));
+    }
+    else {
+        fprintf(stderr, "No action specified (--start, --stop, or --status)\n");
+        return INFRA_ERROR_INVALID_PARAM;
+    }
+
+    if (err != INFRA_OK) {
+        fprintf(stderr, "Command failed: %s\n", response);
+        return err;
+    }
+
+    printf("%s", response);
+    return INFRA_OK;
+}
+
+// diskv 的配置行: <host> <port> diskv <engine>:<path> [# comment], 其他服务的行跳过
+static infra_error_t parse_diskv_config(const char* config_file, poly_config_t* config) {
+    if (!config_file || !config) {
+        return INFRA_ERROR_INVALID_PARAM;
+    }
+
+    FILE* fp = fopen(config_file, "r");
+    if (!fp) {
+        fprintf(stderr, "Failed to open config file: %s\n", config_file);
+        return INFRA_ERROR_NOT_FOUND;
+    }
+
+    config->service_count = 0;
+
+    char line[1024];
+    int line_num = 0;
+    while (fgets(line, sizeof(line), fp)) {
+        line_num++;
+
+        char host[64], type[32], backend[256];
+        int port;
+        if (sscanf(line, "%63s %d %31s %255s", host, &port, type, backend) != 4 ||
+            host[0] == '#' || strcmp(type, "diskv") != 0) {
+            continue;
+        }
+        if (port <= 0 || port > 65535) {
+            INFRA_LOG_ERROR("Invalid port number at line %d: %d", line_num, port);
+            continue;
+        }
+
+        if (config->service_count >= POLY_CMD_MAX_SERVICES) {
+            INFRA_LOG_ERROR("Too many services defined");
+            fclose(fp);
+            return INFRA_ERROR_NO_MEMORY;
+        }
+
+        // Add diskv service config
+        poly_service_config_t* svc = &config->services[config->service_count];
+        svc->type = POLY_SERVICE_DISKV;
+        strncpy(svc->listen_host, host, POLY_CMD_MAX_NAME - 1);
+        svc->listen_host[POLY_CMD_MAX_NAME - 1] = '\0';
+        svc->listen_port = port;
+        strncpy(svc->backend, backend, POLY_CMD_MAX_VALUE - 1);
+        svc->backend[POLY_CMD_MAX_VALUE - 1] = '\0';
+
+        INFRA_LOG_INFO("Added diskv service: %s:%d, backend: %s",
+            svc->listen_host, svc->listen_port, svc->backend);
+
+        config->service_count++;
+    }
+
+    fclose(fp);
+
+    if (config->service_count == 0) {
+        INFRA_LOG_ERROR("No valid diskv service configuration found");
+        return INFRA_ERROR_NOT_FOUND;
+    }
+
+    return INFRA_OK;
+}
+
+static infra_error_t handle_diskv_cmd(const poly_config_t* config, int argc, char** argv) {
+    if (!config || argc < 3) {
+        return INFRA_ERROR_INVALID_PARAM;
+    }
+
+    // Get service instance
+    peer_service_t* service = peer_diskv_get_service();
+    if (!service) {
+        fprintf(stderr, "Failed to get diskv service\n");
+        return INFRA_ERROR_NOT_FOUND;
+    }
+
+    // Parse command line options first
+    bool start = false;
+    bool stop = false;
+    bool status = false;
+    const char* config_file = NULL;
+    const char* backend = NULL;
+    int port = 0;
+    int threads = 0;
+
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--start") == 0) {
+            start = true;
+        }
+        else if (strcmp(argv[i], "--stop") == 0) {
+            stop = true;
+        }
+        else if (strcmp(argv[i], "--status") == 0) {
+            status = true;
+        }
+        else if (strncmp(argv[i], "--config=", 9) == 0) {
+            config_file = argv[i] + 9;
+        }
+        else if (strncmp(argv[i], "--backend=", 10) == 0) {
+            backend = argv[i] + 10;
+        }
+        else if (strncmp(argv[i], "--port=", 7) == 0) {
+            port = atoi(argv[i] + 7);
+        }
+        else if (strncmp(argv[i], "--threads=", 10) == 0) {
+            threads = atoi(argv[i] + 10);
+        }
+    }
+
+    // Initialize service only if starting
+    infra_error_t err = INFRA_OK;
+    if (start) {
+        err = service->init();
+        if (err != INFRA_OK) {
+            fprintf(stderr, "Failed to initialize service: %d\n", err);
+            return err;
+        }
+    }
+
+    // Parse config file if provided
+    poly_config_t service_config = {0};
+    service_config.service_count = 1;
+    service_config.services[0].type = POLY_SERVICE_DISKV;
+
+    if (config_file) {
+        infra_error_t err = parse_diskv_config(config_file, &service_config);
+        if (err != INFRA_OK) {
+            fprintf(stderr, "Failed to parse config file: %s\n", config_file);
+            return err;
+        }
+    }
+
+    // Override config with command line options
+    if (port > 0) {
+        service_config.services[0].listen_port = port;
+    }
+    if (backend) {
+        strncpy(service_config.services[0].backend, backend, sizeof(service_config.services[0].backend) - 1);
+    }
+    if (threads > 0) {
+        service_config.services[0].threads = threads;
     }
 
     // Apply configuration
@@ -954,6 +1186,9 @@ int main(int argc, char** argv) {
 #ifdef DEV_MEMKV
     peer_service_register(peer_memkv_get_service());
 #endif
+#ifdef DEV_DISKV
+    peer_service_register(peer_diskv_get_service());
+#endif
 
     // Register commands
     register_commands();
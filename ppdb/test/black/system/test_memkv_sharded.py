@@ -0,0 +1,170 @@
+import unittest
+import socket
+import logging
+
+# 分片模式测试, 需先启动: ppdb memkv --start --sharded --threads=4
+# key 按哈希分布到各 reactor, 大多数请求要经其他分片执行, 检查流水线请求的响应顺序
+
+# 配置日志
+logging.basicConfig(
+    level=logging.INFO,
+    format='%(asctime)s [%(levelname)s] %(message)s',
+    datefmt='%Y-%m-%d %H:%M:%S'
+)
+
+HOST = 'localhost'
+PORT = 11211
+
+
+class MemKVConn:
+    def __init__(self):
+        self.sock = socket.create_connection((HOST, PORT), timeout=5.0)
+        self.buf = b''
+
+    def close(self):
+        self.sock.close()
+
+    def send(self, data):
+        self.sock.sendall(data)
+
+    def read_line(self):
+        while b'\r\n' not in self.buf:
+            chunk = self.sock.recv(65536)
+            if not chunk:
+                raise ConnectionError("connection closed")
+            self.buf += chunk
+        line, self.buf = self.buf.split(b'\r\n', 1)
+        return line
+
+    def read_bytes(self, n):
+        while len(self.buf) < n + 2:
+            chunk = self.sock.recv(65536)
+            if not chunk:
+                raise ConnectionError("connection closed")
+            self.buf += chunk
+        data, self.buf = self.buf[:n], self.buf[n + 2:]
+        return data
+
+    # 读取一条 get 响应, 返回 {key: value}, 同时检查 VALUE 的顺序
+    def read_values(self, order=None):
+        values = {}
+        keys = []
+        while True:
+            line = self.read_line()
+            if line == b'END':
+                break
+            parts = line.split()
+            self.assertion(parts[0] == b'VALUE', line)
+            keys.append(parts[1])
+            values[parts[1]] = self.read_bytes(int(parts[3]))
+        if order is not None:
+            self.assertion(keys == order, (keys[:5], order[:5]))
+        return values
+
+    @staticmethod
+    def assertion(cond, info):
+        if not cond:
+            raise AssertionError(info)
+
+
+class TestMemKVSharded(unittest.TestCase):
+    def setUp(self):
+        self.conn = MemKVConn()
+        self.conn.send(b'flush_all\r\n')
+        self.assertEqual(self.conn.read_line(), b'OK')
+
+    def tearDown(self):
+        self.conn.close()
+
+    def test_pipelined_set_get(self):
+        logging.info("Testing pipelined set/get across shards...")
+        n = 500
+        req = b''.join(b'set k%d 0 0 %d\r\nv%d\r\n' % (i, len(b'v%d' % i), i) for i in range(n))
+        req += b''.join(b'get k%d\r\n' % i for i in range(n))
+        self.conn.send(req)
+        for i in range(n):
+            self.assertEqual(self.conn.read_line(), b'STORED')
+        for i in range(n):
+            values = self.conn.read_values()
+            self.assertEqual(values, {b'k%d' % i: b'v%d' % i})
+
+    def test_read_after_write_order(self):
+        logging.info("Testing write/read ordering on one connection...")
+        req = b''
+        for i in range(200):
+            req += b'set c%d 0 0 1\r\n1\r\n' % i
+            req += b'incr c%d 5\r\n' % i
+            req += b'append c%d 0 0 1\r\nx\r\n' % i
+            req += b'get c%d\r\n' % i
+            req += b'delete c%d\r\n' % i
+            req += b'get c%d\r\n' % i
+        self.conn.send(req)
+        for i in range(200):
+            self.assertEqual(self.conn.read_line(), b'STORED')
+            self.assertEqual(self.conn.read_line(), b'6')
+            self.assertEqual(self.conn.read_line(), b'STORED')
+            self.assertEqual(self.conn.read_values(), {b'c%d' % i: b'6x'})
+            self.assertEqual(self.conn.read_line(), b'DELETED')
+            self.assertEqual(self.conn.read_line(), b'END')
+
+    def test_multi_get_order(self):
+        logging.info("Testing multi-get ordering...")
+        # 超过一批 (128 个 key), 含重复和未命中的 key
+        keys = [b'm%d' % i for i in range(300)]
+        req = b''.join(b'set %s 0 0 %d\r\n%s\r\n' % (k, len(k), k) for k in keys[::2])
+        self.conn.send(req)
+        for _ in keys[::2]:
+            self.assertEqual(self.conn.read_line(), b'STORED')
+
+        wanted = keys + keys[:10]
+        self.conn.send(b'get ' + b' '.join(wanted) + b'\r\n' + b'gets m0\r\n')
+        hits = [k for k in wanted if int(k[1:]) % 2 == 0]
+        values = self.conn.read_values(order=hits)
+        for k in hits:
+            self.assertEqual(values[k], k)
+        line = self.conn.read_line()
+        self.assertTrue(line.startswith(b'VALUE m0 0 2 '))
+        self.assertEqual(self.conn.read_bytes(2), b'm0')
+        self.assertEqual(self.conn.read_line(), b'END')
+
+    def test_large_values(self):
+        logging.info("Testing streamed values across shards...")
+        n = 20
+        size = 256 * 1024
+        req = b''
+        for i in range(n):
+            req += b'set big%d 0 0 %d\r\n' % (i, size) + bytes([65 + i]) * size + b'\r\n'
+            req += b'get big%d\r\n' % i
+        self.conn.send(req)
+        for i in range(n):
+            self.assertEqual(self.conn.read_line(), b'STORED')
+            values = self.conn.read_values()
+            self.assertEqual(values[b'big%d' % i], bytes([65 + i]) * size)
+
+    def test_cross_connection(self):
+        logging.info("Testing visibility across connections...")
+        other = MemKVConn()
+        try:
+            for i in range(100):
+                self.conn.send(b'set x%d 0 0 2\r\nv%d\r\n' % (i, i % 10))
+                self.assertEqual(self.conn.read_line(), b'STORED')
+                other.send(b'mg x%d v\r\n' % i)
+                self.assertEqual(other.read_line(), b'VA 2')
+                self.assertEqual(other.read_bytes(2), b'v%d' % (i % 10))
+        finally:
+            other.close()
+
+    def test_close_with_pending(self):
+        logging.info("Testing close while requests are in flight...")
+        for _ in range(20):
+            conn = MemKVConn()
+            conn.send(b''.join(b'set p%d 0 0 1\r\nx\r\nget p%d\r\n' % (i, i) for i in range(200)))
+            conn.close()
+        # 已关闭连接收到的请求可能仍在执行, 用另外的 key 检查服务仍然正常
+        self.conn.send(b'set q0 0 0 1\r\ny\r\nget q0\r\n')
+        self.assertEqual(self.conn.read_line(), b'STORED')
+        self.assertEqual(self.conn.read_values(), {b'q0': b'y'})
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,216 @@
+import unittest
+import socket
+import struct
+import time
+import logging
+
+# sqlite3 服务的语句路由测试, 需先启动使用文件数据库的 sqlite3 服务 (端口 15433),
+# 读连接池才会启用. 查询走读连接并发执行, 写语句和事务中的语句走唯一的写连接
+
+# 配置日志
+logging.basicConfig(
+    level=logging.INFO,
+    format='%(asctime)s [%(levelname)s] %(message)s',
+    datefmt='%Y-%m-%d %H:%M:%S'
+)
+
+HOST = 'localhost'
+PORT = 15433
+
+
+class SQLite3Error(Exception):
+    pass
+
+
+class SQLite3Conn:
+    def __init__(self, rcvbuf=None):
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        if rcvbuf:
+            self.sock.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, rcvbuf)
+        self.sock.settimeout(30.0)
+        self.sock.connect((HOST, PORT))
+        self.buf = b''
+
+    def close(self):
+        self.sock.close()
+
+    def send(self, sql):
+        data = sql.encode()
+        self.sock.sendall(b'Q' + struct.pack('>I', len(data)) + data)
+
+    def read_frame(self):
+        while len(self.buf) < 5 or len(self.buf) < 5 + struct.unpack('>I', self.buf[1:5])[0]:
+            chunk = self.sock.recv(1 << 20)
+            if not chunk:
+                raise ConnectionError("connection closed")
+            self.buf += chunk
+        n = struct.unpack('>I', self.buf[1:5])[0]
+        frame = (self.buf[0:1], self.buf[5:5 + n])
+        self.buf = self.buf[5 + n:]
+        return frame
+
+    @staticmethod
+    def decode_row(p, pos, columns):
+        row = []
+        for _ in range(columns):
+            t = p[pos]
+            if t == 0:
+                row.append(None)
+                pos += 1
+            elif t == 1:
+                row.append(struct.unpack('>q', p[pos + 1:pos + 9])[0])
+                pos += 9
+            elif t == 2:
+                row.append(struct.unpack('>d', p[pos + 1:pos + 9])[0])
+                pos += 9
+            else:
+                n = struct.unpack('>I', p[pos + 1:pos + 5])[0]
+                v = p[pos + 5:pos + 5 + n]
+                row.append(v.decode() if t == 3 else v)
+                pos += 5 + n
+        return row, pos
+
+    # 读取一个请求的全部回复, 返回最后一条语句的行; 出错时抛出 SQLite3Error
+    def read_result(self):
+        rows = []
+        columns = 0
+        error = None
+        while True:
+            t, p = self.read_frame()
+            if t == b'T':
+                columns = struct.unpack('>H', p[:2])[0]
+                rows = []
+            elif t == b'D':
+                pos = 4
+                for _ in range(struct.unpack('>I', p[:4])[0]):
+                    row, pos = self.decode_row(p, pos, columns)
+                    rows.append(row)
+            elif t == b'E':
+                error = p[4:].decode()
+            elif t == b'Z':
+                if error is not None:
+                    raise SQLite3Error(error)
+                return rows
+
+    def query(self, sql):
+        self.send(sql)
+        return self.read_result()
+
+
+class TestSQLite3Routing(unittest.TestCase):
+    def setUp(self):
+        self.conn = SQLite3Conn()
+        self.conn.query('DROP TABLE IF EXISTS route_test; '
+                        'CREATE TABLE route_test (id INTEGER PRIMARY KEY, v TEXT)')
+
+    def tearDown(self):
+        self.conn.close()
+
+    def count(self, conn=None):
+        return (conn or self.conn).query('SELECT COUNT(*) FROM route_test')[0][0]
+
+    def test_with_insert(self):
+        logging.info("Testing WITH ... INSERT goes to the writer...")
+        rows = self.conn.query("WITH x(id, v) AS (VALUES (1, 'a'), (2, 'b')) "
+                               "INSERT INTO route_test SELECT * FROM x")
+        self.assertEqual(rows, [])
+        other = SQLite3Conn()
+        try:
+            self.assertEqual(self.count(other), 2)
+        finally:
+            other.close()
+
+    def test_returning(self):
+        logging.info("Testing DML ... RETURNING...")
+        rows = self.conn.query("INSERT INTO route_test VALUES (1, 'a'), (2, 'b') RETURNING id, v")
+        self.assertEqual(rows, [[1, 'a'], [2, 'b']])
+        rows = self.conn.query("UPDATE route_test SET v = v || '!' WHERE id = 2 RETURNING v")
+        self.assertEqual(rows, [['b!']])
+        rows = self.conn.query("WITH x(id) AS (VALUES (3)) "
+                               "INSERT INTO route_test SELECT id, 'c' FROM x RETURNING id")
+        self.assertEqual(rows, [[3]])
+        rows = self.conn.query("DELETE FROM route_test WHERE id = 1 RETURNING v")
+        self.assertEqual(rows, [['a']])
+        self.assertEqual(self.count(), 2)
+
+    def test_pragma(self):
+        logging.info("Testing PRAGMA runs on the writer...")
+        self.conn.query('PRAGMA user_version = 7')
+        self.assertEqual(self.conn.query('PRAGMA user_version'), [[7]])
+        other = SQLite3Conn()
+        try:
+            self.assertEqual(other.query('/* c */ PRAGMA user_version'), [[7]])
+            other.query('PRAGMA user_version = 0')
+        finally:
+            other.close()
+
+    def test_transaction_pinning(self):
+        logging.info("Testing BEGIN ... COMMIT pins the writer...")
+        self.conn.query("INSERT INTO route_test VALUES (1, 'a')")
+        other = SQLite3Conn()
+        try:
+            # 事务中的查询走写连接, 能读到未提交的修改, 跨请求保持
+            self.assertEqual(self.conn.query("BEGIN; INSERT INTO route_test VALUES (2, 'b'); "
+                                             "SELECT COUNT(*) FROM route_test"), [[2]])
+            self.assertEqual(self.count(), 2)
+            # 其他连接的查询在读连接上执行, 不等待事务, 只看到已提交的数据
+            start = time.time()
+            self.assertEqual(self.count(other), 1)
+            self.assertLess(time.time() - start, 1.0)
+            self.conn.query('COMMIT')
+            self.assertEqual(self.count(other), 2)
+            # 提交后写连接已归还
+            start = time.time()
+            other.query("INSERT INTO route_test VALUES (3, 'c')")
+            self.assertLess(time.time() - start, 1.0)
+
+            self.conn.query("BEGIN; INSERT INTO route_test VALUES (4, 'd')")
+            self.conn.query('ROLLBACK')
+            self.assertEqual(self.count(other), 3)
+        finally:
+            other.close()
+
+    def test_slow_client_returning(self):
+        logging.info("Testing a slow client does not hold the writer...")
+        # 约 3.5MB 的 RETURNING 结果, 客户端不读; 结果缓存后写连接立即归还
+        slow = SQLite3Conn(rcvbuf=4096)
+        other = SQLite3Conn()
+        try:
+            slow.send("WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n WHERE i < 3500) "
+                      "INSERT INTO route_test SELECT i, hex(randomblob(500)) FROM n RETURNING v")
+            time.sleep(0.5)
+            start = time.time()
+            other.query("INSERT INTO route_test VALUES (5000, 'x')")
+            self.assertLess(time.time() - start, 1.0)
+            rows = slow.read_result()
+            self.assertEqual(len(rows), 3500)
+        finally:
+            slow.close()
+            other.close()
+
+    def test_slow_client_in_transaction(self):
+        logging.info("Testing a stalled client in a transaction is dropped...")
+        # 事务中的大结果超过缓存上限, 客户端一直不读时断开并回滚, 其他写语句得以继续
+        slow = SQLite3Conn(rcvbuf=4096)
+        other = SQLite3Conn()
+        try:
+            slow.send("BEGIN; INSERT INTO route_test VALUES (1, 'a'); "
+                      "WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n WHERE i < 10000) "
+                      "SELECT i, randomblob(1000) FROM n")
+            time.sleep(0.5)
+            deadline = time.time() + 20
+            while True:
+                try:
+                    other.query("INSERT INTO route_test VALUES (2, 'b')")
+                    break
+                except SQLite3Error as e:
+                    self.assertIn('busy', str(e))
+                    self.assertLess(time.time(), deadline)
+            self.assertEqual(other.query('SELECT id FROM route_test'), [[2]])
+        finally:
+            slow.close()
+            other.close()
+
+
+if __name__ == '__main__':
+    unittest.main()
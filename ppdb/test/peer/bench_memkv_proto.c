@@ -0,0 +1,99 @@
+#include "internal/peer/peer_memkv_proto.h"
+#include "internal/infra/infra_core.h"
+#include "internal/infra/infra_memory.h"
+
+//-----------------------------------------------------------------------------
+// memcached 文本协议解析微基准
+//
+// 生成 get/set 混合的请求流 (默认 80% get), 反复解析, 输出每秒解析的命令数.
+// 用法: bench_memkv_proto [命令数] [value 字节数] [秒数]
+//-----------------------------------------------------------------------------
+
+#define BENCH_DEFAULT_COMMANDS 10000
+#define BENCH_DEFAULT_VALUE_SIZE 100
+#define BENCH_DEFAULT_SECONDS 2
+
+static char* build_stream(int commands, int value_size, size_t* len) {
+    size_t cap = (size_t)commands * (value_size + 64);
+    char* buf = infra_malloc(cap);
+    if (!buf) return NULL;
+
+    char* value = infra_malloc(value_size);
+    if (!value) {
+        infra_free(buf);
+        return NULL;
+    }
+    memset(value, 'v', value_size);
+
+    size_t pos = 0;
+    for (int i = 0; i < commands; i++) {
+        if (i % 5 == 0) {
+            pos += snprintf(buf + pos, cap - pos, "set key:%08d 0 0 %d\r\n", i, value_size);
+            memcpy(buf + pos, value, value_size);
+            pos += value_size;
+            memcpy(buf + pos, "\r\n", 2);
+            pos += 2;
+        } else {
+            pos += snprintf(buf + pos, cap - pos, "get key:%08d\r\n", i);
+        }
+    }
+
+    infra_free(value);
+    *len = pos;
+    return buf;
+}
+
+int main(int argc, char** argv) {
+    int commands = argc > 1 ? atoi(argv[1]) : BENCH_DEFAULT_COMMANDS;
+    int value_size = argc > 2 ? atoi(argv[2]) : BENCH_DEFAULT_VALUE_SIZE;
+    int seconds = argc > 3 ? atoi(argv[3]) : BENCH_DEFAULT_SECONDS;
+    if (commands <= 0 || value_size < 0 || seconds <= 0) {
+        printf("usage: %s [commands] [value_size] [seconds]\n", argv[0]);
+        return 1;
+    }
+
+    size_t len = 0;
+    char* stream = build_stream(commands, value_size, &len);
+    if (!stream) {
+        printf("failed to build request stream\n");
+        return 1;
+    }
+
+    memkv_parser_t parser;
+    memkv_parser_init(&parser, 1024 * 1024);
+
+    uint64_t parsed = 0;
+    uint64_t bytes = 0;
+    uint64_t checksum = 0;
+    uint64_t start = infra_time_ms();
+    uint64_t deadline = start + (uint64_t)seconds * 1000;
+    uint64_t now = start;
+
+    while (now < deadline) {
+        size_t pos = 0;
+        while (pos < len) {
+            memkv_request_t req;
+            size_t consumed = 0;
+            infra_error_t err = memkv_proto_parse(&parser, stream + pos, len - pos, &req, &consumed);
+            if (err != INFRA_OK) {
+                printf("unexpected parse result %d at offset %zu\n", err, pos);
+                infra_free(stream);
+                return 1;
+            }
+            // 防止编译器把解析结果优化掉
+            checksum += req.key.len + req.data.len;
+            pos += consumed;
+            parsed++;
+        }
+        bytes += len;
+        now = infra_time_ms();
+    }
+
+    double elapsed = (now - start) / 1000.0;
+    printf("commands: %lu, elapsed: %.2fs\n", (unsigned long)parsed, elapsed);
+    printf("throughput: %.0f commands/sec, %.1f MB/sec (checksum %lu)\n",
+           parsed / elapsed, bytes / elapsed / (1024 * 1024), (unsigned long)checksum);
+
+    infra_free(stream);
+    return 0;
+}
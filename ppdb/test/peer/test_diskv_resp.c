@@ -0,0 +1,199 @@
+#include "internal/peer/peer_diskv_resp.h"
+#include "../white/framework/test_framework.h"
+#include "internal/infra/infra_core.h"
+
+static bool span_is(diskv_span_t span, const char* str) {
+    return span.len == strlen(str) && memcmp(span.ptr, str, span.len) == 0;
+}
+
+// 测试 multibulk 命令解析, 参数直接指向输入缓冲区
+static void test_resp_multibulk(void) {
+    diskv_resp_parser_t parser;
+    diskv_resp_parser_init(&parser);
+    diskv_command_t cmd;
+    size_t consumed = 0;
+
+    const char* set = "*3\r\n$3\r\nSET\r\n$3\r\nfoo\r\n$5\r\nhello\r\n";
+    TEST_ASSERT(diskv_resp_parse(&parser, set, strlen(set), &cmd, &consumed) == INFRA_OK);
+    TEST_ASSERT(consumed == strlen(set));
+    TEST_ASSERT(cmd.argc == 3);
+    TEST_ASSERT(diskv_span_equals_nocase(cmd.argv[0], "set"));
+    TEST_ASSERT(span_is(cmd.argv[1], "foo"));
+    TEST_ASSERT(cmd.argv[1].ptr == set + 17);
+    TEST_ASSERT(span_is(cmd.argv[2], "hello"));
+
+    // 空参数和 *0
+    const char* empty = "*2\r\n$3\r\nGET\r\n$0\r\n\r\n*0\r\n";
+    TEST_ASSERT(diskv_resp_parse(&parser, empty, strlen(empty), &cmd, &consumed) == INFRA_OK);
+    TEST_ASSERT(cmd.argc == 2 && cmd.argv[1].len == 0);
+    TEST_ASSERT(diskv_resp_parse(&parser, empty + consumed, strlen(empty) - consumed,
+                                 &cmd, &consumed) == INFRA_OK);
+    TEST_ASSERT(cmd.argc == 0 && consumed == 4);
+    // 与 Redis 一致, 负数个数也当作空命令
+    TEST_ASSERT(diskv_resp_parse(&parser, "*-1\r\n", 5, &cmd, &consumed) == INFRA_OK);
+    TEST_ASSERT(cmd.argc == 0 && consumed == 5);
+
+    // 参数个数超过初始数组大小
+    char many[4096];
+    size_t len = (size_t)snprintf(many, sizeof(many), "*100\r\n");
+    for (int i = 0; i < 100; i++) {
+        len += (size_t)snprintf(many + len, sizeof(many) - len, "$1\r\n%c\r\n", 'a' + i % 26);
+    }
+    TEST_ASSERT(diskv_resp_parse(&parser, many, len, &cmd, &consumed) == INFRA_OK);
+    TEST_ASSERT(cmd.argc == 100 && consumed == len);
+    TEST_ASSERT(cmd.argv[99].ptr[0] == 'a' + 99 % 26);
+
+    diskv_resp_parser_destroy(&parser);
+}
+
+// 测试数据按长度读取, 可以包含 \r\n 和 '\0'
+static void test_resp_binary(void) {
+    diskv_resp_parser_t parser;
+    diskv_resp_parser_init(&parser);
+    diskv_command_t cmd;
+    size_t consumed = 0;
+
+    const char set[] = "*3\r\n$3\r\nSET\r\n$1\r\nk\r\n$6\r\na\r\n\0\r\n\r\n";
+    size_t len = sizeof(set) - 1;
+    TEST_ASSERT(diskv_resp_parse(&parser, set, len, &cmd, &consumed) == INFRA_OK);
+    TEST_ASSERT(consumed == len);
+    TEST_ASSERT(cmd.argv[2].len == 6 && memcmp(cmd.argv[2].ptr, "a\r\n\0\r\n", 6) == 0);
+
+    diskv_resp_parser_destroy(&parser);
+}
+
+// 测试数据逐字节到达: 未完整前返回 WOULD_BLOCK, 已知长度时给出所需字节数
+static void test_resp_incremental(void) {
+    diskv_resp_parser_t parser;
+    diskv_resp_parser_init(&parser);
+    diskv_command_t cmd;
+    size_t consumed = 0;
+
+    const char* set = "*3\r\n$3\r\nSET\r\n$1\r\nk\r\n$10\r\n0123456789\r\n";
+    size_t len = strlen(set);
+    for (size_t i = 0; i < len; i++) {
+        TEST_ASSERT(diskv_resp_parse(&parser, set, i, &cmd, &consumed) == INFRA_ERROR_WOULD_BLOCK);
+        TEST_ASSERT(consumed == 0);
+    }
+    // 最后一个参数的长度行已到齐
+    TEST_ASSERT(diskv_resp_parse(&parser, set, len - 5, &cmd, &consumed) == INFRA_ERROR_WOULD_BLOCK);
+    TEST_ASSERT(parser.need == len);
+    TEST_ASSERT(diskv_resp_parse(&parser, set, len, &cmd, &consumed) == INFRA_OK);
+    TEST_ASSERT(parser.need == 0 && consumed == len);
+
+    diskv_resp_parser_destroy(&parser);
+}
+
+// 测试 pipeline: 一个缓冲区中连续多条命令
+static void test_resp_pipeline(void) {
+    diskv_resp_parser_t parser;
+    diskv_resp_parser_init(&parser);
+    diskv_command_t cmd;
+    size_t consumed = 0;
+
+    const char* buf = "*1\r\n$4\r\nPING\r\n*2\r\n$3\r\nGET\r\n$1\r\na\r\nPING\r\n*2\r\n$3\r\nGET";
+    size_t len = strlen(buf);
+    size_t pos = 0;
+    const char* names[] = {"PING", "GET", "PING"};
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT(diskv_resp_parse(&parser, buf + pos, len - pos, &cmd, &consumed) == INFRA_OK);
+        TEST_ASSERT(span_is(cmd.argv[0], names[i]));
+        pos += consumed;
+    }
+    TEST_ASSERT(diskv_resp_parse(&parser, buf + pos, len - pos, &cmd, &consumed) ==
+                INFRA_ERROR_WOULD_BLOCK);
+
+    diskv_resp_parser_destroy(&parser);
+}
+
+// 测试 inline 命令
+static void test_resp_inline(void) {
+    diskv_resp_parser_t parser;
+    diskv_resp_parser_init(&parser);
+    diskv_command_t cmd;
+    size_t consumed = 0;
+
+    const char* line = "set  foo\tbar\r\n";
+    TEST_ASSERT(diskv_resp_parse(&parser, line, strlen(line), &cmd, &consumed) == INFRA_OK);
+    TEST_ASSERT(consumed == strlen(line) && cmd.argc == 3);
+    TEST_ASSERT(span_is(cmd.argv[1], "foo") && span_is(cmd.argv[2], "bar"));
+
+    // 只有 \n 结尾, 以及空行
+    TEST_ASSERT(diskv_resp_parse(&parser, "ping\n", 5, &cmd, &consumed) == INFRA_OK);
+    TEST_ASSERT(cmd.argc == 1 && consumed == 5);
+    TEST_ASSERT(diskv_resp_parse(&parser, "\r\n", 2, &cmd, &consumed) == INFRA_OK);
+    TEST_ASSERT(cmd.argc == 0 && consumed == 2);
+    TEST_ASSERT(diskv_resp_parse(&parser, "get a", 5, &cmd, &consumed) == INFRA_ERROR_WOULD_BLOCK);
+
+    diskv_resp_parser_destroy(&parser);
+}
+
+// 测试格式错误
+static void test_resp_errors(void) {
+    diskv_resp_parser_t parser;
+    diskv_resp_parser_init(&parser);
+    diskv_command_t cmd;
+    size_t consumed = 0;
+
+    const char* bad[] = {
+        "*x\r\n",
+        "*1\r\n:3\r\nfoo\r\n",
+        "*1\r\n$-1\r\n",
+        "*1\r\n$3\r\nfooXX",
+        "*1\r\n$99999999999\r\n",
+        "*1\n"
+    };
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        TEST_ASSERT(diskv_resp_parse(&parser, bad[i], strlen(bad[i]), &cmd, &consumed) ==
+                    INFRA_ERROR_PROTOCOL);
+        TEST_ASSERT(cmd.error != NULL && strncmp(cmd.error, "Protocol error", 14) == 0);
+    }
+
+    // 超长的 inline 行
+    size_t len = DISKV_RESP_MAX_INLINE + 1;
+    char* big = infra_malloc(len);
+    TEST_ASSERT(big != NULL);
+    memset(big, 'a', len);
+    TEST_ASSERT(diskv_resp_parse(&parser, big, len, &cmd, &consumed) == INFRA_ERROR_PROTOCOL);
+    infra_free(big);
+
+    diskv_resp_parser_destroy(&parser);
+}
+
+// 测试响应头编码和数值解析
+static void test_resp_numbers(void) {
+    char out[32];
+    size_t n = diskv_resp_header(out, ':', 0);
+    TEST_ASSERT(n == 4 && memcmp(out, ":0\r\n", 4) == 0);
+    n = diskv_resp_header(out, '$', -1);
+    TEST_ASSERT(n == 5 && memcmp(out, "$-1\r\n", 5) == 0);
+    n = diskv_resp_header(out, ':', INT64_MIN);
+    TEST_ASSERT(n == 23 && memcmp(out, ":-9223372036854775808\r\n", 23) == 0);
+
+    int64_t v = 0;
+    diskv_span_t max = {"9223372036854775807", 19};
+    TEST_ASSERT(diskv_span_to_i64(max, &v) && v == INT64_MAX);
+    diskv_span_t min = {"-9223372036854775808", 20};
+    TEST_ASSERT(diskv_span_to_i64(min, &v) && v == INT64_MIN);
+    diskv_span_t over = {"9223372036854775808", 19};
+    TEST_ASSERT(!diskv_span_to_i64(over, &v));
+    diskv_span_t junk = {"12a", 3};
+    TEST_ASSERT(!diskv_span_to_i64(junk, &v));
+    diskv_span_t dash = {"-", 1};
+    TEST_ASSERT(!diskv_span_to_i64(dash, &v));
+}
+
+// 测试入口
+int main(int argc, char** argv) {
+    // 测试不引用 infra_core, 其自动初始化不会被链接进来
+    infra_init();
+    TEST_BEGIN();
+    RUN_TEST(test_resp_multibulk);
+    RUN_TEST(test_resp_binary);
+    RUN_TEST(test_resp_incremental);
+    RUN_TEST(test_resp_pipeline);
+    RUN_TEST(test_resp_inline);
+    RUN_TEST(test_resp_errors);
+    RUN_TEST(test_resp_numbers);
+    TEST_END();
+}
@@ -0,0 +1,111 @@
+#include "internal/peer/peer_memkv_hotkeys.h"
+#include "internal/peer/peer_memkv_store.h"
+#include "../white/framework/test_framework.h"
+#include "internal/infra/infra_core.h"
+
+static void record_key(memkv_hotkeys_t* hk, const char* key, int times) {
+    for (int i = 0; i < times; i++) {
+        memkv_hotkeys_record(hk, key, strlen(key), memkv_hash(key, strlen(key)));
+    }
+}
+
+// 测试 space-saving: 大量冷 key 中仍能找出少数热点
+static void test_hotkeys_top(void) {
+    memkv_hotkeys_t* hk = NULL;
+    TEST_ASSERT(memkv_hotkeys_create(1, &hk) == INFRA_OK);
+
+    char key[32];
+    for (int round = 0; round < 100; round++) {
+        record_key(hk, "hot1", 30);
+        record_key(hk, "hot2", 20);
+        for (int i = 0; i < 50; i++) {
+            snprintf(key, sizeof(key), "cold%d", round * 50 + i);
+            record_key(hk, key, 1);
+        }
+    }
+
+    memkv_hotkey_t top[4];
+    int n = memkv_hotkeys_top(hk, top, 4);
+    TEST_ASSERT(n == 4);
+    TEST_ASSERT(top[0].nkey == 4 && memcmp(top[0].key, "hot1", 4) == 0);
+    TEST_ASSERT(top[1].nkey == 4 && memcmp(top[1].key, "hot2", 4) == 0);
+    // 计数只会高估, 扣除误差后不超过真实值
+    TEST_ASSERT(top[0].count >= 3000 && top[0].count - top[0].error <= 3000);
+    TEST_ASSERT(top[2].count < top[1].count);
+
+    // 达到阈值才算热点
+    TEST_ASSERT(memkv_hotkeys_record(hk, "hot1", 4, memkv_hash("hot1", 4)));
+    TEST_ASSERT(!memkv_hotkeys_record(hk, "new", 3, memkv_hash("new", 3)));
+
+    // 减半后不再访问的 key 逐渐让出计数器
+    for (int i = 0; i < 16; i++) {
+        memkv_hotkeys_decay(hk);
+    }
+    TEST_ASSERT(memkv_hotkeys_top(hk, top, 4) == 0);
+
+    memkv_hotkeys_destroy(hk);
+}
+
+// 测试采样率
+static void test_hotkeys_sample(void) {
+    memkv_hotkeys_t* hk = NULL;
+    TEST_ASSERT(memkv_hotkeys_create(16, &hk) == INFRA_OK);
+    int sampled = 0;
+    for (int i = 0; i < 160000; i++) {
+        if (memkv_hotkeys_sample(hk)) {
+            sampled++;
+        }
+    }
+    TEST_ASSERT(sampled > 9000 && sampled < 11000);
+    memkv_hotkeys_destroy(hk);
+}
+
+// 测试副本缓存在写入、删除后失效
+static void test_hotcache_invalidate(void) {
+    memkv_store_t* store = NULL;
+    TEST_ASSERT(memkv_store_create(NULL, &store) == INFRA_OK);
+    memkv_hotcache_t* cache = NULL;
+    TEST_ASSERT(memkv_hotcache_create(&cache) == INFRA_OK);
+
+    memkv_item_t* it = memkv_store_item_alloc(store, "k", 1, 0, 0, 2);
+    memcpy(MEMKV_ITEM_VALUE(it), "v1", 2);
+    TEST_ASSERT(memkv_store_set(store, it) == INFRA_OK);
+    memkv_hotcache_put(cache, it);
+    memkv_item_release(it);
+
+    uint64_t hash = memkv_hash("k", 1);
+    memkv_item_t* got = NULL;
+    TEST_ASSERT(memkv_hotcache_get(cache, "k", 1, hash, &got));
+    TEST_ASSERT(memcmp(MEMKV_ITEM_VALUE(got), "v1", 2) == 0);
+    memkv_item_release(got);
+    TEST_ASSERT(!memkv_hotcache_get(cache, "x", 1, memkv_hash("x", 1), &got));
+
+    // 覆盖写入后旧副本失效
+    it = memkv_store_item_alloc(store, "k", 1, 0, 0, 2);
+    memcpy(MEMKV_ITEM_VALUE(it), "v2", 2);
+    TEST_ASSERT(memkv_store_set(store, it) == INFRA_OK);
+    TEST_ASSERT(!memkv_hotcache_get(cache, "k", 1, hash, &got));
+    memkv_hotcache_put(cache, it);
+    memkv_item_release(it);
+    TEST_ASSERT(memkv_hotcache_get(cache, "k", 1, hash, &got));
+    TEST_ASSERT(memcmp(MEMKV_ITEM_VALUE(got), "v2", 2) == 0);
+    memkv_item_release(got);
+
+    // 删除后失效, sweep 释放引用
+    TEST_ASSERT(memkv_store_delete(store, "k", 1, 0) == INFRA_OK);
+    memkv_hotcache_sweep(cache);
+    TEST_ASSERT(!memkv_hotcache_get(cache, "k", 1, hash, &got));
+
+    memkv_hotcache_destroy(cache);
+    memkv_store_destroy(store);
+}
+
+int main(int argc, char** argv) {
+    // 测试不引用 infra_core, 其自动初始化不会被链接进来
+    infra_init();
+    TEST_BEGIN();
+    RUN_TEST(test_hotkeys_top);
+    RUN_TEST(test_hotkeys_sample);
+    RUN_TEST(test_hotcache_invalidate);
+    TEST_END();
+}
@@ -0,0 +1,330 @@
+#include "internal/peer/peer_memkv_proto.h"
+#include "../white/framework/test_framework.h"
+#include "internal/infra/infra_core.h"
+
+#define MAX_VALUE (1024 * 1024)
+
+static infra_error_t parse(memkv_parser_t* parser, const char* buf, size_t len,
+                           memkv_request_t* req, size_t* consumed) {
+    return memkv_proto_parse(parser, buf, len, req, consumed);
+}
+
+// 测试基本命令解析
+static void test_proto_basic(void) {
+    memkv_parser_t parser;
+    memkv_parser_init(&parser, MAX_VALUE);
+    memkv_request_t req;
+    size_t consumed = 0;
+
+    const char* get = "get foo bar\r\n";
+    TEST_ASSERT(parse(&parser, get, strlen(get), &req, &consumed) == INFRA_OK);
+    TEST_ASSERT(req.cmd == MEMKV_CMD_GET);
+    TEST_ASSERT(consumed == strlen(get));
+    TEST_ASSERT(memkv_span_equals(req.key, "foo"));
+    // key 直接指向输入缓冲区
+    TEST_ASSERT(req.key.ptr == get + 4);
+
+    memkv_span_t keys = req.keys;
+    memkv_span_t key;
+    int nkeys = 0;
+    while (memkv_proto_next_token(&keys, &key)) nkeys++;
+    TEST_ASSERT(nkeys == 2);
+
+    const char* del = "delete foo noreply\r\n";
+    TEST_ASSERT(parse(&parser, del, strlen(del), &req, &consumed) == INFRA_OK);
+    TEST_ASSERT(req.cmd == MEMKV_CMD_DELETE);
+    TEST_ASSERT(req.noreply);
+
+    const char* incr = "incr counter 42\r\n";
+    TEST_ASSERT(parse(&parser, incr, strlen(incr), &req, &consumed) == INFRA_OK);
+    TEST_ASSERT(req.cmd == MEMKV_CMD_INCR);
+    TEST_ASSERT(req.delta == 42);
+
+    const char* bogus = "bogus\r\nget a\r\n";
+    TEST_ASSERT(parse(&parser, bogus, strlen(bogus), &req, &consumed) == INFRA_ERROR_PROTOCOL);
+    TEST_ASSERT(consumed == 7);
+    TEST_ASSERT(req.error != NULL);
+}
+
+// 测试数据块按长度读取, 可以包含 \r\n
+static void test_proto_set_binary(void) {
+    memkv_parser_t parser;
+    memkv_parser_init(&parser, MAX_VALUE);
+    memkv_request_t req;
+    size_t consumed = 0;
+
+    const char set[] = "set k 7 100 6\r\na\r\nb\r\n\r\nget k\r\n";
+    size_t len = sizeof(set) - 1;
+    TEST_ASSERT(parse(&parser, set, len, &req, &consumed) == INFRA_OK);
+    TEST_ASSERT(req.cmd == MEMKV_CMD_SET);
+    TEST_ASSERT(req.flags == 7);
+    TEST_ASSERT(req.exptime == 100);
+    TEST_ASSERT(req.data.len == 6);
+    TEST_ASSERT(memcmp(req.data.ptr, "a\r\nb\r\n", 6) == 0);
+
+    TEST_ASSERT(parse(&parser, set + consumed, len - consumed, &req, &consumed) == INFRA_OK);
+    TEST_ASSERT(req.cmd == MEMKV_CMD_GET);
+
+    const char bad[] = "set k 0 0 2\r\nabcd\r\n";
+    TEST_ASSERT(parse(&parser, bad, sizeof(bad) - 1, &req, &consumed) == INFRA_ERROR_PROTOCOL);
+}
+
+// 测试逐字节到达的增量解析
+static void test_proto_incremental(void) {
+    memkv_parser_t parser;
+    memkv_parser_init(&parser, MAX_VALUE);
+    memkv_request_t req;
+    size_t consumed = 0;
+
+    const char msg[] = "set key 0 0 5\r\nhello\r\n";
+    size_t len = sizeof(msg) - 1;
+    for (size_t i = 1; i < len; i++) {
+        TEST_ASSERT(parse(&parser, msg, i, &req, &consumed) == INFRA_ERROR_WOULD_BLOCK);
+        TEST_ASSERT(consumed == 0);
+    }
+    TEST_ASSERT(parse(&parser, msg, len, &req, &consumed) == INFRA_OK);
+    TEST_ASSERT(consumed == len);
+    TEST_ASSERT(memkv_span_equals(req.key, "key"));
+    TEST_ASSERT(req.data.len == 5);
+}
+
+// 测试超限数据块被丢弃, 后续请求不受影响
+static void test_proto_swallow(void) {
+    memkv_parser_t parser;
+    memkv_parser_init(&parser, 4);
+    memkv_request_t req;
+    size_t consumed = 0;
+
+    const char msg[] = "set big 0 0 10\r\n0123456789\r\nget big\r\n";
+    size_t len = sizeof(msg) - 1;
+    size_t pos = 0;
+
+    TEST_ASSERT(parse(&parser, msg, len, &req, &consumed) == INFRA_ERROR_PROTOCOL);
+    TEST_ASSERT(consumed > 0);
+    pos += consumed;
+
+    TEST_ASSERT(parse(&parser, msg + pos, len - pos, &req, &consumed) == INFRA_ERROR_WOULD_BLOCK);
+    TEST_ASSERT(consumed == 12);
+    pos += consumed;
+
+    TEST_ASSERT(parse(&parser, msg + pos, len - pos, &req, &consumed) == INFRA_OK);
+    TEST_ASSERT(req.cmd == MEMKV_CMD_GET);
+}
+
+// 测试大数据块流式接收: 只交出命令行, 到齐的小数据块照常解析
+static void test_proto_stream(void) {
+    memkv_parser_t parser;
+    memkv_parser_init(&parser, 4);
+    memkv_parser_set_stream(&parser, 8, 16);
+    memkv_request_t req;
+    size_t consumed = 0;
+
+    const char msg[] = "set big 0 0 10\r\n01234";
+    TEST_ASSERT(parse(&parser, msg, sizeof(msg) - 1, &req, &consumed) == INFRA_OK);
+    TEST_ASSERT(req.stream && req.data.ptr == NULL && req.data.len == 10);
+    TEST_ASSERT(consumed == 16);
+    TEST_ASSERT(memkv_span_equals(req.key, "big"));
+
+    // 调用者读走数据块后继续解析下一条
+    const char rest[] = "56789\r\nget big\r\n";
+    TEST_ASSERT(parse(&parser, rest + 7, sizeof(rest) - 8, &req, &consumed) == INFRA_OK);
+    TEST_ASSERT(req.cmd == MEMKV_CMD_GET && !req.stream);
+
+    // 已经到齐时直接引用缓冲区
+    const char whole[] = "set big 0 0 10\r\n0123456789\r\n";
+    TEST_ASSERT(parse(&parser, whole, sizeof(whole) - 1, &req, &consumed) == INFRA_OK);
+    TEST_ASSERT(!req.stream && req.data.len == 10);
+
+    // 超过流式上限仍丢弃
+    const char huge[] = "set big 0 0 20\r\n";
+    TEST_ASSERT(parse(&parser, huge, sizeof(huge) - 1, &req, &consumed) == INFRA_ERROR_PROTOCOL);
+    TEST_ASSERT(parser.state == MEMKV_PARSE_SWALLOW);
+
+    // 调用者无处存放时跳过数据块
+    memkv_parser_init(&parser, 4);
+    memkv_proto_skip(&parser, 12);
+    const char skip[] = "0123456789\r\nget a\r\n";
+    TEST_ASSERT(parse(&parser, skip, sizeof(skip) - 1, &req, &consumed) == INFRA_ERROR_WOULD_BLOCK);
+    TEST_ASSERT(consumed == 12);
+    TEST_ASSERT(parse(&parser, skip + 12, sizeof(skip) - 13, &req, &consumed) == INFRA_OK);
+    TEST_ASSERT(req.cmd == MEMKV_CMD_GET);
+}
+
+// 测试数值解析
+static void test_proto_numbers(void) {
+    uint64_t u;
+    int64_t i;
+    memkv_span_t max = {"18446744073709551615", 20};
+    memkv_span_t over = {"18446744073709551616", 20};
+    memkv_span_t neg = {"-1", 2};
+    memkv_span_t junk = {"12a", 3};
+
+    TEST_ASSERT(memkv_span_to_u64(max, &u) && u == UINT64_MAX);
+    TEST_ASSERT(!memkv_span_to_u64(over, &u));
+    TEST_ASSERT(!memkv_span_to_u64(junk, &u));
+    TEST_ASSERT(memkv_span_to_i64(neg, &i) && i == -1);
+}
+
+// 测试 gat/gats, cas 和 touch 的参数
+static void test_proto_gat_cas(void) {
+    memkv_parser_t parser;
+    memkv_parser_init(&parser, MAX_VALUE);
+    memkv_request_t req;
+    size_t consumed = 0;
+
+    const char* gat = "gats 300 foo bar\r\n";
+    TEST_ASSERT(parse(&parser, gat, strlen(gat), &req, &consumed) == INFRA_OK);
+    TEST_ASSERT(req.cmd == MEMKV_CMD_GATS);
+    TEST_ASSERT(req.exptime == 300);
+    TEST_ASSERT(memkv_span_equals(req.key, "foo"));
+
+    // keys 不含过期时间
+    memkv_span_t keys = req.keys;
+    memkv_span_t key;
+    int nkeys = 0;
+    while (memkv_proto_next_token(&keys, &key)) nkeys++;
+    TEST_ASSERT(nkeys == 2);
+
+    const char* nokey = "gat 300\r\n";
+    TEST_ASSERT(parse(&parser, nokey, strlen(nokey), &req, &consumed) == INFRA_ERROR_PROTOCOL);
+
+    const char cas[] = "cas k 1 0 2 99 noreply\r\nab\r\n";
+    TEST_ASSERT(parse(&parser, cas, sizeof(cas) - 1, &req, &consumed) == INFRA_OK);
+    TEST_ASSERT(req.cmd == MEMKV_CMD_CAS);
+    TEST_ASSERT(req.cas_unique == 99);
+    TEST_ASSERT(req.noreply);
+    TEST_ASSERT(consumed == sizeof(cas) - 1);
+
+    const char* touch = "touch k 10\r\n";
+    TEST_ASSERT(parse(&parser, touch, strlen(touch), &req, &consumed) == INFRA_OK);
+    TEST_ASSERT(req.cmd == MEMKV_CMD_TOUCH);
+    TEST_ASSERT(req.exptime == 10);
+}
+
+// 构造二进制请求头
+static size_t bin_request(char* buf, uint8_t opcode, const char* ext, size_t extlen,
+                          const char* key, const char* value, uint32_t opaque) {
+    size_t keylen = key ? strlen(key) : 0;
+    size_t vlen = value ? strlen(value) : 0;
+    uint32_t bodylen = (uint32_t)(extlen + keylen + vlen);
+    memset(buf, 0, MEMKV_BIN_HEADER_LEN);
+    buf[0] = (char)MEMKV_BIN_REQ_MAGIC;
+    buf[1] = (char)opcode;
+    buf[2] = (char)(keylen >> 8);
+    buf[3] = (char)keylen;
+    buf[4] = (char)extlen;
+    buf[8] = (char)(bodylen >> 24);
+    buf[9] = (char)(bodylen >> 16);
+    buf[10] = (char)(bodylen >> 8);
+    buf[11] = (char)bodylen;
+    memcpy(buf + 12, &opaque, 4);
+    size_t pos = MEMKV_BIN_HEADER_LEN;
+    if (extlen) memcpy(buf + pos, ext, extlen);
+    pos += extlen;
+    if (keylen) memcpy(buf + pos, key, keylen);
+    pos += keylen;
+    if (vlen) memcpy(buf + pos, value, vlen);
+    return pos + vlen;
+}
+
+// 测试二进制协议: 按首字节识别, 分帧, 静默命令
+static void test_proto_binary(void) {
+    memkv_parser_t parser;
+    memkv_parser_init(&parser, MAX_VALUE);
+    memkv_request_t req;
+    size_t consumed = 0;
+    char buf[256];
+
+    const char ext[8] = {0, 0, 0, 9, 0, 0, 0, 60};
+    size_t len = bin_request(buf, MEMKV_BIN_OP_SETQ, ext, 8, "key", "value", 77);
+    for (size_t i = 1; i < len; i++) {
+        TEST_ASSERT(parse(&parser, buf, i, &req, &consumed) == INFRA_ERROR_WOULD_BLOCK);
+        TEST_ASSERT(consumed == 0);
+    }
+    TEST_ASSERT(parser.protocol == MEMKV_PROTO_BINARY);
+    TEST_ASSERT(parse(&parser, buf, len, &req, &consumed) == INFRA_OK);
+    TEST_ASSERT(consumed == len);
+    TEST_ASSERT(req.cmd == MEMKV_CMD_SET);
+    TEST_ASSERT(req.quiet && req.noreply);
+    TEST_ASSERT(req.opaque == 77);
+    TEST_ASSERT(req.flags == 9 && req.exptime == 60);
+    TEST_ASSERT(memkv_span_equals(req.key, "key"));
+    TEST_ASSERT(req.data.len == 5 && memcmp(req.data.ptr, "value", 5) == 0);
+
+    len = bin_request(buf, MEMKV_BIN_OP_GETKQ, NULL, 0, "key", NULL, 0);
+    TEST_ASSERT(parse(&parser, buf, len, &req, &consumed) == INFRA_OK);
+    TEST_ASSERT(req.cmd == MEMKV_CMD_GET && req.quiet && req.return_key);
+
+    // extras 长度不对, 整包跳过
+    len = bin_request(buf, MEMKV_BIN_OP_SET, NULL, 0, "key", "v", 0);
+    TEST_ASSERT(parse(&parser, buf, len, &req, &consumed) == INFRA_ERROR_PROTOCOL);
+    TEST_ASSERT(req.status == MEMKV_BIN_STATUS_EINVAL && consumed == len);
+
+    len = bin_request(buf, 0x7f, NULL, 0, NULL, NULL, 0);
+    TEST_ASSERT(parse(&parser, buf, len, &req, &consumed) == INFRA_ERROR_PROTOCOL);
+    TEST_ASSERT(req.status == MEMKV_BIN_STATUS_UNKNOWN_COMMAND && consumed == len);
+
+    // 魔数错误无法恢复
+    buf[0] = 0x42;
+    TEST_ASSERT(parse(&parser, buf, len, &req, &consumed) == INFRA_ERROR_PROTOCOL);
+    TEST_ASSERT(consumed == 0);
+
+    char out[MEMKV_BIN_HEADER_LEN];
+    memkv_proto_bin_header(out, MEMKV_BIN_OP_GET, MEMKV_BIN_STATUS_KEY_ENOENT, 0, 4, 9, 77, 1);
+    TEST_ASSERT((uint8_t)out[0] == MEMKV_BIN_RES_MAGIC);
+    TEST_ASSERT(out[7] == MEMKV_BIN_STATUS_KEY_ENOENT && out[11] == 9 && out[23] == 1);
+}
+
+// 测试 meta 命令解析
+static void test_proto_meta(void) {
+    memkv_parser_t parser;
+    memkv_parser_init(&parser, MAX_VALUE);
+    memkv_request_t req;
+    size_t consumed = 0;
+
+    const char* mg = "mg foo v f t k q Oabc\r\n";
+    TEST_ASSERT(parse(&parser, mg, strlen(mg), &req, &consumed) == INFRA_OK);
+    TEST_ASSERT(parser.protocol == MEMKV_PROTO_TEXT);
+    TEST_ASSERT(req.cmd == MEMKV_CMD_META_GET);
+    TEST_ASSERT(memkv_span_equals(req.key, "foo"));
+    TEST_ASSERT(req.meta == (MEMKV_META_VALUE | MEMKV_META_FLAGS | MEMKV_META_TTL |
+                             MEMKV_META_KEY | MEMKV_META_OPAQUE));
+    TEST_ASSERT(req.quiet);
+    TEST_ASSERT(memkv_span_equals(req.meta_opaque, "abc"));
+
+    const char ms[] = "ms foo 4 T30 F3 MA\r\nab\r\n\r\nmn\r\n";
+    size_t len = sizeof(ms) - 1;
+    TEST_ASSERT(parse(&parser, ms, len, &req, &consumed) == INFRA_OK);
+    TEST_ASSERT(req.cmd == MEMKV_CMD_META_SET);
+    TEST_ASSERT(req.exptime == 30 && req.flags == 3 && req.mode == 'A');
+    TEST_ASSERT(req.data.len == 4 && memcmp(req.data.ptr, "ab\r\n", 4) == 0);
+    TEST_ASSERT(parse(&parser, ms + consumed, len - consumed, &req, &consumed) == INFRA_OK);
+    TEST_ASSERT(req.cmd == MEMKV_CMD_META_NOOP);
+
+    // 不支持的标志: 数据块被丢弃
+    const char bad[] = "ms foo 2 v\r\nab\r\nmn\r\n";
+    len = sizeof(bad) - 1;
+    size_t pos = 0;
+    TEST_ASSERT(parse(&parser, bad, len, &req, &consumed) == INFRA_ERROR_PROTOCOL);
+    TEST_ASSERT(req.error != NULL);
+    pos += consumed;
+    TEST_ASSERT(parse(&parser, bad + pos, len - pos, &req, &consumed) == INFRA_ERROR_WOULD_BLOCK);
+    pos += consumed;
+    TEST_ASSERT(parse(&parser, bad + pos, len - pos, &req, &consumed) == INFRA_OK);
+    TEST_ASSERT(req.cmd == MEMKV_CMD_META_NOOP);
+}
+
+// 测试入口
+int main(int argc, char** argv) {
+    TEST_BEGIN();
+    RUN_TEST(test_proto_basic);
+    RUN_TEST(test_proto_set_binary);
+    RUN_TEST(test_proto_incremental);
+    RUN_TEST(test_proto_swallow);
+    RUN_TEST(test_proto_stream);
+    RUN_TEST(test_proto_numbers);
+    RUN_TEST(test_proto_gat_cas);
+    RUN_TEST(test_proto_binary);
+    RUN_TEST(test_proto_meta);
+    TEST_END();
+}
@@ -0,0 +1,236 @@
+#include "internal/peer/peer_memkv_store.h"
+#include "internal/peer/peer_memkv_slabs.h"
+#include "../white/framework/test_framework.h"
+#include "internal/infra/infra_core.h"
+
+static memkv_item_t* make_item(memkv_store_t* store, const char* key, size_t nbytes, char fill) {
+    memkv_item_t* it = memkv_store_item_alloc(store, key, strlen(key), 0, 0, nbytes);
+    if (it) {
+        memset(MEMKV_ITEM_VALUE(it), fill, nbytes);
+    }
+    return it;
+}
+
+static infra_error_t set_value(memkv_store_t* store, const char* key, size_t nbytes, char fill) {
+    memkv_item_t* it = make_item(store, key, nbytes, fill);
+    if (!it) {
+        return INFRA_ERROR_NO_MEMORY;
+    }
+    infra_error_t err = memkv_store_set(store, it);
+    memkv_item_release(it);
+    return err;
+}
+
+// 测试 slab class 划分和 chunk 回收
+static void test_store_slab_reuse(void) {
+    memkv_store_t* store = NULL;
+    TEST_ASSERT(memkv_store_create(NULL, &store) == INFRA_OK);
+
+    TEST_ASSERT(set_value(store, "a", 100, 'a') == INFRA_OK);
+    TEST_ASSERT(set_value(store, "a", 100, 'b') == INFRA_OK);
+
+    memkv_slab_stats_t stats[MEMKV_SLAB_MAX_CLASSES];
+    int n = memkv_store_get_slab_stats(store, stats, MEMKV_SLAB_MAX_CLASSES);
+    TEST_ASSERT(n > 2);
+    // chunk 大小严格递增, 最后一个 class 一页一个 chunk
+    for (int i = 2; i < n; i++) {
+        TEST_ASSERT(stats[i].chunk_size > stats[i - 1].chunk_size);
+    }
+    TEST_ASSERT(stats[n - 1].chunks_per_page == 1);
+
+    // 覆盖写入后旧 chunk 已回收, 只占用一个
+    uint64_t used = 0;
+    for (int i = 0; i < n; i++) {
+        used += stats[i].used_chunks;
+    }
+    TEST_ASSERT(used == 1);
+
+    TEST_ASSERT(memkv_store_flush(store) == INFRA_OK);
+    n = memkv_store_get_slab_stats(store, stats, MEMKV_SLAB_MAX_CLASSES);
+    for (int i = 0; i < n; i++) {
+        TEST_ASSERT(stats[i].used_chunks == 0);
+    }
+    memkv_store_destroy(store);
+}
+
+// 测试达到内存上限后按 LRU 淘汰, 正被读取的 item 不淘汰
+static void test_store_eviction(void) {
+    memkv_store_config_t config = {0};
+    config.max_memory = 2 * MEMKV_SLAB_PAGE_SIZE;
+    memkv_store_t* store = NULL;
+    TEST_ASSERT(memkv_store_create(&config, &store) == INFRA_OK);
+
+    // 持有最早写入的 key 的引用
+    TEST_ASSERT(set_value(store, "k0", 1000, 'x') == INFRA_OK);
+    memkv_item_t* held = NULL;
+    TEST_ASSERT(memkv_store_get(store, "k0", 2, &held) == INFRA_OK);
+
+    char key[32];
+    for (int i = 1; i < 10000; i++) {
+        snprintf(key, sizeof(key), "k%d", i);
+        TEST_ASSERT(set_value(store, key, 1000, 'x') == INFRA_OK);
+    }
+
+    memkv_store_stats_t stats;
+    memkv_store_get_stats(store, &stats);
+    TEST_ASSERT(stats.evictions > 0);
+    TEST_ASSERT(stats.total_malloced <= config.max_memory);
+    TEST_ASSERT(stats.curr_items < 10000);
+
+    // 最新的 key 仍在, 被引用的 key 未被淘汰
+    memkv_item_t* it = NULL;
+    TEST_ASSERT(memkv_store_get(store, "k9999", 5, &it) == INFRA_OK);
+    memkv_item_release(it);
+    TEST_ASSERT(memkv_store_get(store, "k0", 2, &it) == INFRA_OK);
+    memkv_item_release(it);
+    TEST_ASSERT(MEMKV_ITEM_VALUE(held)[0] == 'x');
+    memkv_item_release(held);
+
+    memkv_store_destroy(store);
+}
+
+// 测试超过一页的 item
+static void test_store_large_item(void) {
+    memkv_store_config_t config = {0};
+    config.max_memory = 4 * MEMKV_SLAB_PAGE_SIZE;
+    memkv_store_t* store = NULL;
+    TEST_ASSERT(memkv_store_create(&config, &store) == INFRA_OK);
+
+    size_t big = MEMKV_SLAB_PAGE_SIZE + 1000;
+    for (int i = 0; i < 8; i++) {
+        char key[16];
+        snprintf(key, sizeof(key), "big%d", i);
+        TEST_ASSERT(set_value(store, key, big, (char)('a' + i)) == INFRA_OK);
+    }
+
+    memkv_store_stats_t stats;
+    memkv_store_get_stats(store, &stats);
+    TEST_ASSERT(stats.evictions > 0);
+    TEST_ASSERT(stats.total_malloced <= config.max_memory);
+
+    memkv_item_t* it = NULL;
+    TEST_ASSERT(memkv_store_get(store, "big7", 4, &it) == INFRA_OK);
+    TEST_ASSERT(it->nbytes == big && MEMKV_ITEM_VALUE(it)[big - 1] == 'h');
+    memkv_item_release(it);
+
+    memkv_store_destroy(store);
+}
+
+// 测试后台过期回收
+static void test_store_crawl(void) {
+    memkv_store_t* store = NULL;
+    TEST_ASSERT(memkv_store_create(NULL, &store) == INFRA_OK);
+
+    int64_t past = (int64_t)time(NULL) - 1;
+    char key[32];
+    for (int i = 0; i < 1000; i++) {
+        snprintf(key, sizeof(key), "e%d", i);
+        memkv_item_t* it = memkv_store_item_alloc(store, key, strlen(key), 0, past, 10);
+        TEST_ASSERT(it != NULL);
+        TEST_ASSERT(memkv_store_set(store, it) == INFRA_OK);
+        memkv_item_release(it);
+    }
+    TEST_ASSERT(set_value(store, "keep", 10, 'k') == INFRA_OK);
+
+    // 读到的过期 key 视为未命中, 顺手摘下
+    memkv_item_t* it = NULL;
+    TEST_ASSERT(memkv_store_get(store, "e0", 2, &it) == INFRA_ERROR_NOT_FOUND);
+
+    // 足够的预算下一次扫完整张表
+    size_t reclaimed = memkv_store_crawl(store, 1000);
+    TEST_ASSERT(reclaimed == 999);
+
+    memkv_store_stats_t stats;
+    memkv_store_get_stats(store, &stats);
+    TEST_ASSERT(stats.curr_items == 1);
+    TEST_ASSERT(stats.crawler_reclaimed == 999);
+    TEST_ASSERT(stats.expired == 1000);
+    TEST_ASSERT(memkv_store_crawl(store, 1000) == 0);
+
+    memkv_store_destroy(store);
+}
+
+static memkv_store_t* g_incr_store;
+
+static void* incr_worker(void* arg) {
+    (void)arg;
+    uint64_t value = 0;
+    for (int i = 0; i < 10000; i++) {
+        memkv_store_incr(g_incr_store, "n", 1, 1, true, false, 0, 0, &value, NULL, NULL);
+    }
+    return NULL;
+}
+
+// 测试数值增减: 原地改写, 位数变化, 非数值, 并发不丢更新
+static void test_store_incr(void) {
+    memkv_store_t* store = NULL;
+    TEST_ASSERT(memkv_store_create(NULL, &store) == INFRA_OK);
+
+    uint64_t value = 0;
+    TEST_ASSERT(memkv_store_incr(store, "n", 1, 1, true, false, 0, 0, &value, NULL, NULL) ==
+                INFRA_ERROR_NOT_FOUND);
+    bool created = false;
+    TEST_ASSERT(memkv_store_incr(store, "n", 1, 1, true, true, 8, 0, &value, &created, NULL) ==
+                INFRA_OK);
+    TEST_ASSERT(value == 8 && created);
+
+    // 位数不变时原地改写, 位数变化时换新 item
+    memkv_item_t* before = NULL;
+    TEST_ASSERT(memkv_store_get(store, "n", 1, &before) == INFRA_OK);
+    memkv_item_release(before);
+    TEST_ASSERT(memkv_store_incr(store, "n", 1, 1, true, false, 0, 0, &value, NULL, NULL) == INFRA_OK);
+    memkv_item_t* it = NULL;
+    TEST_ASSERT(memkv_store_get(store, "n", 1, &it) == INFRA_OK);
+    TEST_ASSERT(it == before && value == 9 && MEMKV_ITEM_VALUE(it)[0] == '9');
+
+    // 读者持有旧 item 时不原地改写, 读者看到的 value 不变
+    uint64_t cas = 0;
+    TEST_ASSERT(memkv_store_incr(store, "n", 1, 1, true, false, 0, 0, &value, NULL, &cas) == INFRA_OK);
+    TEST_ASSERT(value == 10 && cas != it->cas);
+    TEST_ASSERT(it->nbytes == 1 && MEMKV_ITEM_VALUE(it)[0] == '9');
+    memkv_item_release(it);
+    TEST_ASSERT(memkv_store_get(store, "n", 1, &it) == INFRA_OK);
+    TEST_ASSERT(it->nbytes == 2 && memcmp(MEMKV_ITEM_VALUE(it), "10", 2) == 0);
+    memkv_item_release(it);
+
+    // decr 最小为 0, incr 按 64 位回绕
+    TEST_ASSERT(memkv_store_incr(store, "n", 1, 100, false, false, 0, 0, &value, NULL, NULL) == INFRA_OK);
+    TEST_ASSERT(value == 0);
+    TEST_ASSERT(memkv_store_incr(store, "n", 1, UINT64_MAX, true, false, 0, 0, &value, NULL, NULL) ==
+                INFRA_OK);
+    TEST_ASSERT(value == UINT64_MAX);
+    TEST_ASSERT(memkv_store_incr(store, "n", 1, 2, true, false, 0, 0, &value, NULL, NULL) == INFRA_OK);
+    TEST_ASSERT(value == 1);
+
+    TEST_ASSERT(set_value(store, "s", 3, 'x') == INFRA_OK);
+    TEST_ASSERT(memkv_store_incr(store, "s", 1, 1, true, false, 0, 0, &value, NULL, NULL) ==
+                INFRA_ERROR_INVALID_PARAM);
+
+    // 并发 incr 同一个 key
+    TEST_ASSERT(memkv_store_delete(store, "n", 1, 0) == INFRA_OK);
+    TEST_ASSERT(memkv_store_incr(store, "n", 1, 0, true, true, 0, 0, &value, NULL, NULL) == INFRA_OK);
+    g_incr_store = store;
+    infra_thread_t threads[4];
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT(infra_thread_create(&threads[i], incr_worker, NULL) == INFRA_OK);
+    }
+    for (int i = 0; i < 4; i++) {
+        infra_thread_join(threads[i]);
+    }
+    TEST_ASSERT(memkv_store_incr(store, "n", 1, 0, true, false, 0, 0, &value, NULL, NULL) == INFRA_OK);
+    TEST_ASSERT(value == 40000);
+
+    memkv_store_destroy(store);
+}
+
+int main(int argc, char** argv) {
+    // 测试不引用 infra_core, 其自动初始化不会被链接进来
+    infra_init();
+    TEST_BEGIN();
+    RUN_TEST(test_store_slab_reuse);
+    RUN_TEST(test_store_eviction);
+    RUN_TEST(test_store_large_item);
+    RUN_TEST(test_store_crawl);
+    RUN_TEST(test_store_incr);
+    TEST_END();
+}
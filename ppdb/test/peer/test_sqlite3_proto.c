@@ -0,0 +1,185 @@
+#include "internal/peer/peer_sqlite3_proto.h"
+#include "../white/framework/test_framework.h"
+#include "internal/infra/infra_core.h"
+
+// 测试帧解析: 数据逐字节到达, 头部到齐后给出整帧所需字节数
+static void test_proto_parse(void) {
+    const char buf[] = "Q\0\0\0\x08SELECT 1X\0\0\0\0";
+    size_t len = sizeof(buf) - 1;
+    sqlite3_frame_t frame;
+    size_t consumed = 0;
+    size_t need = 0;
+
+    for (size_t i = 0; i < 13; i++) {
+        TEST_ASSERT(sqlite3_proto_parse(buf, i, &frame, &consumed, &need) == INFRA_ERROR_WOULD_BLOCK);
+        TEST_ASSERT(consumed == 0);
+        TEST_ASSERT(need == (i < SQLITE3_PROTO_HEADER ? 0 : 13));
+    }
+    TEST_ASSERT(sqlite3_proto_parse(buf, len, &frame, &consumed, &need) == INFRA_OK);
+    TEST_ASSERT(frame.type == SQLITE3_MSG_QUERY && consumed == 13);
+    TEST_ASSERT(frame.len == 8 && frame.payload == buf + 5);
+    TEST_ASSERT(memcmp(frame.payload, "SELECT 1", 8) == 0);
+
+    // 空负载
+    TEST_ASSERT(sqlite3_proto_parse(buf + consumed, len - consumed, &frame, &consumed, &need) == INFRA_OK);
+    TEST_ASSERT(frame.type == SQLITE3_MSG_TERMINATE && frame.len == 0 && consumed == 5);
+
+    // 超过上限
+    const char big[] = "Q\x7f\xff\xff\xff";
+    TEST_ASSERT(sqlite3_proto_parse(big, 5, &frame, &consumed, &need) == INFRA_ERROR_PROTOCOL);
+}
+
+// 测试帧编码: 负载长度在 end 时填入, set_u32 改写已写入的计数
+static void test_proto_frame(void) {
+    sqlite3_proto_buf_t out;
+    sqlite3_proto_buf_init(&out);
+
+    size_t frame = sqlite3_proto_begin(&out, SQLITE3_MSG_ROW_DESC);
+    TEST_ASSERT(frame == 0);
+    sqlite3_proto_put_u16(&out, 1);
+    sqlite3_proto_put_u16(&out, 2);
+    sqlite3_proto_put_bytes(&out, "id", 2);
+    sqlite3_proto_end(&out, frame);
+
+    frame = sqlite3_proto_begin(&out, SQLITE3_MSG_COMPLETE);
+    sqlite3_proto_put_u32(&out, 0);
+    size_t count = out.len - 4;
+    sqlite3_proto_put_u64(&out, 0x0102030405060708ULL);
+    sqlite3_proto_set_u32(&out, count, 7);
+    sqlite3_proto_end(&out, frame);
+    TEST_ASSERT(!out.failed);
+    TEST_ASSERT(out.len == 11 + 17);
+
+    sqlite3_frame_t f;
+    size_t consumed = 0;
+    size_t need = 0;
+    TEST_ASSERT(sqlite3_proto_parse(out.data, out.len, &f, &consumed, &need) == INFRA_OK);
+    TEST_ASSERT(f.type == SQLITE3_MSG_ROW_DESC && f.len == 6 && consumed == 11);
+    TEST_ASSERT(memcmp(f.payload, "\0\x01\0\x02id", 6) == 0);
+    TEST_ASSERT(sqlite3_proto_parse(out.data + consumed, out.len - consumed, &f, &consumed, &need) == INFRA_OK);
+    TEST_ASSERT(f.type == SQLITE3_MSG_COMPLETE && f.len == 12);
+    TEST_ASSERT(sqlite3_proto_get_u32(f.payload) == 7);
+    TEST_ASSERT(sqlite3_proto_get_u64(f.payload + 4) == 0x0102030405060708ULL);
+
+    sqlite3_proto_buf_destroy(&out);
+    TEST_ASSERT(out.data == NULL && out.len == 0);
+}
+
+// 测试值的编码和解码
+static void test_proto_values(void) {
+    sqlite3_proto_buf_t out;
+    sqlite3_proto_buf_init(&out);
+
+    poly_db_value_t in[5];
+    memset(in, 0, sizeof(in));
+    in[0].type = POLY_DB_VALUE_INTEGER;
+    in[0].i = INT64_MIN;
+    in[1].type = POLY_DB_VALUE_REAL;
+    in[1].d = -1.5;
+    in[2].type = POLY_DB_VALUE_TEXT;
+    in[2].data = "hello";
+    in[2].len = 5;
+    in[3].type = POLY_DB_VALUE_BLOB;
+    in[3].data = "a\0b";
+    in[3].len = 3;
+    in[4].type = POLY_DB_VALUE_NULL;
+    for (int i = 0; i < 5; i++) {
+        sqlite3_proto_put_value(&out, &in[i]);
+    }
+    TEST_ASSERT(!out.failed);
+    TEST_ASSERT(out.len == 9 + 9 + 10 + 8 + 1);
+
+    size_t pos = 0;
+    poly_db_value_t v;
+    size_t n = sqlite3_proto_get_value(out.data + pos, out.len - pos, &v);
+    TEST_ASSERT(n == 9 && v.type == POLY_DB_VALUE_INTEGER && v.i == INT64_MIN);
+    pos += n;
+    n = sqlite3_proto_get_value(out.data + pos, out.len - pos, &v);
+    TEST_ASSERT(n == 9 && v.type == POLY_DB_VALUE_REAL && v.d == -1.5);
+    pos += n;
+    n = sqlite3_proto_get_value(out.data + pos, out.len - pos, &v);
+    TEST_ASSERT(n == 10 && v.type == POLY_DB_VALUE_TEXT && v.len == 5);
+    TEST_ASSERT(memcmp(v.data, "hello", 5) == 0);
+    pos += n;
+    n = sqlite3_proto_get_value(out.data + pos, out.len - pos, &v);
+    TEST_ASSERT(n == 8 && v.type == POLY_DB_VALUE_BLOB && v.len == 3);
+    TEST_ASSERT(memcmp(v.data, "a\0b", 3) == 0);
+    pos += n;
+    n = sqlite3_proto_get_value(out.data + pos, out.len - pos, &v);
+    TEST_ASSERT(n == 1 && v.type == POLY_DB_VALUE_NULL);
+    pos += n;
+    TEST_ASSERT(pos == out.len);
+
+    // 数据不完整和未知类型
+    TEST_ASSERT(sqlite3_proto_get_value(out.data, 8, &v) == 0);
+    TEST_ASSERT(sqlite3_proto_get_value(out.data + 18, 9, &v) == 0);
+    TEST_ASSERT(sqlite3_proto_get_value("\x09", 1, &v) == 0);
+
+    sqlite3_proto_buf_destroy(&out);
+}
+
+// 测试语句分类: 只有以 SELECT/WITH/VALUES 开头的语句尝试读连接
+static void test_sql_is_query(void) {
+    const char* queries[] = {
+        "SELECT 1", "select * from t", "WITH x AS (SELECT 1) SELECT * FROM x",
+        "VALUES (1), (2)", "SELECT", "with\tx(a) AS (VALUES (1)) SELECT a FROM x",
+        // WITH ... INSERT 和带 RETURNING 的 CTE 也按查询尝试, 由读连接上的编译结果排除
+        "WITH x AS (SELECT 1) INSERT INTO t SELECT * FROM x",
+        "WITH x AS (SELECT 1) INSERT INTO t SELECT * FROM x RETURNING *",
+    };
+    const char* writes[] = {
+        "INSERT INTO t VALUES (1) RETURNING id", "UPDATE t SET a = 1 RETURNING a",
+        "DELETE FROM t RETURNING *", "PRAGMA user_version", "PRAGMA journal_mode = WAL",
+        "BEGIN", "BEGIN IMMEDIATE", "COMMIT", "END", "ROLLBACK", "SAVEPOINT s",
+        "CREATE TEMP TABLE tt(x)", "ATTACH 'x.db' AS x", "EXPLAIN SELECT 1",
+        "SELECTED", "WITHOUT", "VALUES_1", "SELECT_x", "", "SEL",
+    };
+    for (size_t i = 0; i < sizeof(queries) / sizeof(queries[0]); i++) {
+        const char* sql = queries[i];
+        TEST_ASSERT(sqlite3_sql_is_query(sql, sql + strlen(sql)));
+    }
+    for (size_t i = 0; i < sizeof(writes) / sizeof(writes[0]); i++) {
+        const char* sql = writes[i];
+        TEST_ASSERT(!sqlite3_sql_is_query(sql, sql + strlen(sql)));
+    }
+
+    // 只看 end 之前的部分: 多语句请求中截取到第一条之后仍能识别
+    const char* multi = "SELECT 1; INSERT INTO t VALUES (1)";
+    TEST_ASSERT(sqlite3_sql_is_query(multi, multi + 6));
+    TEST_ASSERT(!sqlite3_sql_is_query(multi, multi + 5));
+    TEST_ASSERT(!sqlite3_sql_is_query(multi + 10, multi + strlen(multi)));
+}
+
+// 测试跳过空白和注释, 找到下一条语句的开头
+static void test_sql_skip_space(void) {
+    const char sql[] = "  -- comment\n /* block */\tSELECT 1";
+    const char* end = sql + strlen(sql);
+    const char* p = sqlite3_sql_skip_space(sql, end);
+    TEST_ASSERT(p == strstr(sql, "SELECT"));
+    TEST_ASSERT(sqlite3_sql_is_query(p, end));
+
+    // 注释后是 PRAGMA 时仍走写连接
+    const char pragma[] = "/* x */ PRAGMA user_version";
+    p = sqlite3_sql_skip_space(pragma, pragma + strlen(pragma));
+    TEST_ASSERT(!sqlite3_sql_is_query(p, pragma + strlen(pragma)));
+
+    // 只剩空白或注释 (包括未结束的注释) 时返回 end
+    const char* tails[] = {"", "   \n\t", "-- only comment", "/* open", "/* a */ -- b\n  "};
+    for (size_t i = 0; i < sizeof(tails) / sizeof(tails[0]); i++) {
+        end = tails[i] + strlen(tails[i]);
+        TEST_ASSERT(sqlite3_sql_skip_space(tails[i], end) == end);
+    }
+}
+
+// 测试入口
+int main(int argc, char** argv) {
+    // 测试不引用 infra_core, 其自动初始化不会被链接进来
+    infra_init();
+    TEST_BEGIN();
+    RUN_TEST(test_proto_parse);
+    RUN_TEST(test_proto_frame);
+    RUN_TEST(test_proto_values);
+    RUN_TEST(test_sql_is_query);
+    RUN_TEST(test_sql_skip_space);
+    TEST_END();
+}
@@ -0,0 +1,138 @@
+#include "internal/poly/poly_db.h"
+#include "internal/infra/infra_core.h"
+#include "internal/infra/infra_memory.h"
+
+//-----------------------------------------------------------------------------
+// poly_db 批量导入基准
+//
+// 每个引擎建一张 (id, name, score) 表, 分别用逐行 prepare/bind/step (同一事务内)
+// 和 poly_db_bulk 导入同样的行, 输出每秒导入的行数. DuckDB 库加载失败时跳过.
+// 用法: bench_poly_db_bulk [行数] [sqlite|duckdb|all] [数据库文件前缀]
+//-----------------------------------------------------------------------------
+
+#define BENCH_DEFAULT_ROWS 1000000
+#define BENCH_DEFAULT_PATH "/tmp/bench_poly_db_bulk"
+
+static poly_db_t* open_fresh(poly_db_type_t type, const char* path) {
+    // 数据库文件以及 SQLite/DuckDB 的日志文件
+    const char* suffixes[] = {"", "-journal", "-wal", ".wal"};
+    char file[1100];
+    for (size_t i = 0; i < sizeof(suffixes) / sizeof(suffixes[0]); i++) {
+        snprintf(file, sizeof(file), "%s%s", path, suffixes[i]);
+        remove(file);
+    }
+
+    poly_db_config_t config = {
+        .type = type,
+        .url = path,
+        .read_only = false,
+        .allow_fallback = false
+    };
+    poly_db_t* db = NULL;
+    if (poly_db_open(&config, &db) != INFRA_OK) {
+        return NULL;
+    }
+    if (poly_db_exec(db, "CREATE TABLE t (id BIGINT, name VARCHAR, score DOUBLE)") != INFRA_OK) {
+        poly_db_close(db);
+        return NULL;
+    }
+    return db;
+}
+
+// 逐行绑定参数执行同一条 INSERT (语句缓存命中), 全部在一个事务内
+static infra_error_t load_rows(poly_db_t* db, int rows) {
+    if (poly_db_exec(db, "BEGIN TRANSACTION") != INFRA_OK) {
+        return INFRA_ERROR_QUERY_FAILED;
+    }
+    char id[24];
+    char name[32];
+    char score[32];
+    for (int i = 0; i < rows; i++) {
+        poly_db_stmt_t* stmt = NULL;
+        infra_error_t err = poly_db_prepare(db, "INSERT INTO t VALUES (?, ?, ?)", &stmt);
+        if (err != INFRA_OK) return err;
+        size_t id_len = (size_t)snprintf(id, sizeof(id), "%d", i);
+        size_t name_len = (size_t)snprintf(name, sizeof(name), "name%d", i);
+        size_t score_len = (size_t)snprintf(score, sizeof(score), "%.1f", i * 0.5);
+        err = poly_db_bind_text(stmt, 1, id, id_len);
+        if (err == INFRA_OK) err = poly_db_bind_text(stmt, 2, name, name_len);
+        if (err == INFRA_OK) err = poly_db_bind_text(stmt, 3, score, score_len);
+        if (err == INFRA_OK) err = poly_db_stmt_step(stmt);
+        poly_db_stmt_finalize(stmt);
+        if (err != INFRA_OK) return err;
+    }
+    return poly_db_exec(db, "COMMIT");
+}
+
+static infra_error_t load_bulk(poly_db_t* db, int rows) {
+    poly_db_bulk_t* bulk = NULL;
+    infra_error_t err = poly_db_bulk_begin(db, "t", &bulk);
+    if (err != INFRA_OK) return err;
+
+    char name[32];
+    poly_db_value_t row[3];
+    memset(row, 0, sizeof(row));
+    row[0].type = POLY_DB_VALUE_INTEGER;
+    row[1].type = POLY_DB_VALUE_TEXT;
+    row[1].data = name;
+    row[2].type = POLY_DB_VALUE_REAL;
+    for (int i = 0; i < rows && err == INFRA_OK; i++) {
+        row[0].i = i;
+        row[1].len = (size_t)snprintf(name, sizeof(name), "name%d", i);
+        row[2].d = i * 0.5;
+        err = poly_db_bulk_append_row(bulk, row, 3);
+    }
+    infra_error_t end = poly_db_bulk_end(bulk, err == INFRA_OK);
+    return err != INFRA_OK ? err : end;
+}
+
+static void run_engine(poly_db_type_t type, const char* engine, int rows, const char* prefix) {
+    char path[1024];
+    snprintf(path, sizeof(path), "%s.%s", prefix, engine);
+
+    struct {
+        const char* name;
+        infra_error_t (*load)(poly_db_t* db, int rows);
+    } modes[] = {
+        {"row-by-row", load_rows},
+        {"bulk", load_bulk}
+    };
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        poly_db_t* db = open_fresh(type, path);
+        if (!db) {
+            printf("%-7s skipped (failed to open %s)\n", engine, path);
+            return;
+        }
+        uint64_t start = infra_time_ms();
+        infra_error_t err = modes[m].load(db, rows);
+        uint64_t elapsed_ms = infra_time_ms() - start;
+        poly_db_close(db);
+        if (err != INFRA_OK) {
+            printf("%-7s %-10s failed: %d\n", engine, modes[m].name, err);
+            continue;
+        }
+        double elapsed = (elapsed_ms ? elapsed_ms : 1) / 1000.0;
+        printf("%-7s %-10s rows: %d, elapsed: %.2fs, throughput: %.0f rows/sec\n",
+               engine, modes[m].name, rows, elapsed, rows / elapsed);
+    }
+}
+
+int main(int argc, char** argv) {
+    int rows = argc > 1 ? atoi(argv[1]) : BENCH_DEFAULT_ROWS;
+    const char* engine = argc > 2 ? argv[2] : "all";
+    const char* prefix = argc > 3 ? argv[3] : BENCH_DEFAULT_PATH;
+    bool all = strcmp(engine, "all") == 0;
+    if (rows <= 0 || (!all && strcmp(engine, "sqlite") != 0 && strcmp(engine, "duckdb") != 0)) {
+        printf("usage: %s [rows] [sqlite|duckdb|all] [path_prefix]\n", argv[0]);
+        return 1;
+    }
+
+    infra_init();
+    if (all || strcmp(engine, "sqlite") == 0) {
+        run_engine(POLY_DB_TYPE_SQLITE, "sqlite", rows, prefix);
+    }
+    if (all || strcmp(engine, "duckdb") == 0) {
+        run_engine(POLY_DB_TYPE_DUCKDB, "duckdb", rows, prefix);
+    }
+    return 0;
+}
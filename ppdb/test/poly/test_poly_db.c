@@ -103,10 +103,471 @@ static void test_db_basic(void) {
     poly_db_close(db);
 }
 
+// 测试预处理语句缓存
+static void test_db_stmt_cache(void) {
+    poly_db_t* db = NULL;
+    poly_db_config_t config = {
+        .type = POLY_DB_TYPE_SQLITE,
+        .url = ":memory:",
+        .read_only = false,
+        .allow_fallback = false
+    };
+    infra_error_t err = poly_db_open(&config, &db);
+    TEST_ASSERT(err == INFRA_OK);
+
+    err = poly_db_exec(db, "CREATE TABLE kv (key TEXT PRIMARY KEY, value BLOB)");
+    TEST_ASSERT(err == INFRA_OK);
+
+    // 同一条 SQL 反复使用, 只有第一次编译
+    const char* insert_sql = "INSERT INTO kv (key, value) VALUES (?, ?)";
+    char key[16];
+    for (int i = 0; i < 10; i++) {
+        poly_db_stmt_t* stmt = NULL;
+        err = poly_db_prepare(db, insert_sql, &stmt);
+        TEST_ASSERT(err == INFRA_OK);
+        snprintf(key, sizeof(key), "key%d", i);
+        TEST_ASSERT(poly_db_bind_text(stmt, 1, key, strlen(key)) == INFRA_OK);
+        TEST_ASSERT(poly_db_bind_blob(stmt, 2, "value", 5) == INFRA_OK);
+        TEST_ASSERT(poly_db_stmt_step(stmt) == INFRA_OK);
+        poly_db_stmt_finalize(stmt);
+    }
+
+    poly_db_stmt_cache_stats_t stats;
+    TEST_ASSERT(poly_db_get_stmt_cache_stats(db, &stats) == INFRA_OK);
+    TEST_ASSERT(stats.misses == 1);
+    TEST_ASSERT(stats.hits == 9);
+    TEST_ASSERT(stats.entries == 1);
+
+    // 复用的语句从头执行, 且不残留上次的绑定
+    const char* select_sql = "SELECT value FROM kv WHERE key = ?";
+    for (int i = 0; i < 2; i++) {
+        poly_db_stmt_t* stmt = NULL;
+        TEST_ASSERT(poly_db_prepare(db, select_sql, &stmt) == INFRA_OK);
+        TEST_ASSERT(poly_db_bind_text(stmt, 1, "key3", 4) == INFRA_OK);
+        TEST_ASSERT(poly_db_stmt_step(stmt) == INFRA_OK);
+        void* data = NULL;
+        size_t size = 0;
+        TEST_ASSERT(poly_db_column_blob(stmt, 0, &data, &size) == INFRA_OK);
+        TEST_ASSERT(size == 5 && memcmp(data, "value", 5) == 0);
+        infra_free(data);
+        poly_db_stmt_finalize(stmt);
+    }
+
+    // 同一条 SQL 同时借出两份时, 第二份另行编译
+    poly_db_stmt_t* first = NULL;
+    poly_db_stmt_t* second = NULL;
+    TEST_ASSERT(poly_db_prepare(db, select_sql, &first) == INFRA_OK);
+    TEST_ASSERT(poly_db_prepare(db, select_sql, &second) == INFRA_OK);
+    TEST_ASSERT(first != second);
+    poly_db_stmt_finalize(second);
+    poly_db_stmt_finalize(first);
+
+    TEST_ASSERT(poly_db_get_stmt_cache_stats(db, &stats) == INFRA_OK);
+    TEST_ASSERT(stats.entries == 3);
+
+    TEST_ASSERT(poly_db_stmt_cache_clear(db) == INFRA_OK);
+    TEST_ASSERT(poly_db_get_stmt_cache_stats(db, &stats) == INFRA_OK);
+    TEST_ASSERT(stats.entries == 0);
+
+    poly_db_close(db);
+}
+
+// 测试流式游标: 逐行读取, 列值直接指向引擎缓冲区
+static void test_db_cursor(void) {
+    poly_db_t* db = NULL;
+    poly_db_config_t config = {
+        .type = POLY_DB_TYPE_SQLITE,
+        .url = ":memory:",
+        .read_only = false,
+        .allow_fallback = false
+    };
+    infra_error_t err = poly_db_open(&config, &db);
+    TEST_ASSERT(err == INFRA_OK);
+
+    TEST_ASSERT(poly_db_exec(db, "CREATE TABLE t (id INTEGER, name TEXT, score REAL, data BLOB)") == INFRA_OK);
+    TEST_ASSERT(poly_db_exec(db,
+        "WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n WHERE i < 10000) "
+        "INSERT INTO t SELECT i, 'name' || i, i * 0.5, CASE WHEN i % 2 THEN x'00ff' END FROM n") == INFRA_OK);
+
+    poly_db_cursor_t* cursor = NULL;
+    TEST_ASSERT(poly_db_cursor_open(db, "SELECT id, name, score, data FROM t ORDER BY id", &cursor) == INFRA_OK);
+    TEST_ASSERT(poly_db_cursor_column_count(cursor) == 4);
+    TEST_ASSERT(strcmp(poly_db_cursor_column_name(cursor, 1), "name") == 0);
+    TEST_ASSERT(poly_db_cursor_column_name(cursor, 4) == NULL);
+
+    int64_t rows = 0;
+    int64_t sum = 0;
+    int64_t nulls = 0;
+    while ((err = poly_db_cursor_next(cursor)) == INFRA_OK) {
+        rows++;
+        int64_t id = 0;
+        TEST_ASSERT(poly_db_cursor_get_int64(cursor, 0, &id) == INFRA_OK);
+        sum += id;
+
+        char expect[32];
+        int n = snprintf(expect, sizeof(expect), "name%lld", (long long)id);
+        const char* name = NULL;
+        size_t len = 0;
+        TEST_ASSERT(poly_db_cursor_get_text(cursor, 1, &name, &len) == INFRA_OK);
+        TEST_ASSERT(len == (size_t)n && memcmp(name, expect, len) == 0);
+
+        double score = 0;
+        TEST_ASSERT(poly_db_cursor_get_double(cursor, 2, &score) == INFRA_OK);
+        TEST_ASSERT(score == id * 0.5);
+
+        const void* data = NULL;
+        err = poly_db_cursor_get_blob(cursor, 3, &data, &len);
+        if (id % 2) {
+            TEST_ASSERT(err == INFRA_OK && len == 2 && memcmp(data, "\x00\xff", 2) == 0);
+        } else {
+            TEST_ASSERT(err == INFRA_ERROR_NOT_FOUND);
+            nulls++;
+        }
+    }
+    TEST_ASSERT(err == INFRA_ERROR_NOT_FOUND);
+    TEST_ASSERT(rows == 10000 && sum == 50005000 && nulls == 5000);
+    // 读完之后继续 next 仍然是结束
+    TEST_ASSERT(poly_db_cursor_next(cursor) == INFRA_ERROR_NOT_FOUND);
+    TEST_ASSERT(poly_db_cursor_close(cursor) == INFRA_OK);
+
+    // 数值和文本之间的转换, 以及没读完就关闭
+    TEST_ASSERT(poly_db_cursor_open(db, "SELECT 42, '17', 'x1', 2.5 FROM t", &cursor) == INFRA_OK);
+    TEST_ASSERT(poly_db_cursor_next(cursor) == INFRA_OK);
+    const char* text = NULL;
+    size_t len = 0;
+    TEST_ASSERT(poly_db_cursor_get_text(cursor, 0, &text, &len) == INFRA_OK);
+    TEST_ASSERT(len == 2 && memcmp(text, "42", 2) == 0);
+    int64_t value = 0;
+    TEST_ASSERT(poly_db_cursor_get_int64(cursor, 1, &value) == INFRA_OK && value == 17);
+    TEST_ASSERT(poly_db_cursor_get_int64(cursor, 2, &value) == INFRA_ERROR_INVALID_PARAM);
+    TEST_ASSERT(poly_db_cursor_get_int64(cursor, 3, &value) == INFRA_OK && value == 2);
+    poly_db_value_t v;
+    TEST_ASSERT(poly_db_cursor_column(cursor, 3, &v) == INFRA_OK && v.type == POLY_DB_VALUE_REAL);
+    TEST_ASSERT(poly_db_cursor_column(cursor, 9, &v) == INFRA_ERROR_INVALID_PARAM);
+    TEST_ASSERT(poly_db_cursor_close(cursor) == INFRA_OK);
+
+    // 同一条 SQL 再次打开时复用缓存的语句, 从头开始
+    TEST_ASSERT(poly_db_cursor_open(db, "SELECT 42, '17', 'x1', 2.5 FROM t", &cursor) == INFRA_OK);
+    rows = 0;
+    while (poly_db_cursor_next(cursor) == INFRA_OK) {
+        rows++;
+    }
+    TEST_ASSERT(rows == 10000);
+    poly_db_cursor_close(cursor);
+    poly_db_stmt_cache_stats_t stats;
+    TEST_ASSERT(poly_db_get_stmt_cache_stats(db, &stats) == INFRA_OK);
+    TEST_ASSERT(stats.hits == 1);
+
+    // SQL 错误在打开时返回
+    cursor = NULL;
+    TEST_ASSERT(poly_db_cursor_open(db, "SELECT * FROM missing", &cursor) != INFRA_OK);
+    TEST_ASSERT(cursor == NULL);
+
+    poly_db_close(db);
+}
+
+// 测试按列批量读取
+static void test_db_cursor_batch(void) {
+    poly_db_t* db = NULL;
+    poly_db_config_t config = {
+        .type = POLY_DB_TYPE_SQLITE,
+        .url = ":memory:",
+        .read_only = false,
+        .allow_fallback = false
+    };
+    infra_error_t err = poly_db_open(&config, &db);
+    TEST_ASSERT(err == INFRA_OK);
+
+    TEST_ASSERT(poly_db_exec(db, "CREATE TABLE t (id INTEGER, name TEXT)") == INFRA_OK);
+    TEST_ASSERT(poly_db_exec(db,
+        "WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n WHERE i < 2500) "
+        "INSERT INTO t SELECT i, CASE WHEN i % 3 THEN 'name' || i END FROM n") == INFRA_OK);
+
+    poly_db_cursor_t* cursor = NULL;
+    TEST_ASSERT(poly_db_cursor_open(db, "SELECT id, name FROM t ORDER BY id", &cursor) == INFRA_OK);
+
+    const poly_db_batch_t* batch = NULL;
+    size_t sizes[3] = {0};
+    int batches = 0;
+    int64_t sum = 0;
+    int64_t nulls = 0;
+    while ((err = poly_db_cursor_next_batch(cursor, &batch)) == INFRA_OK) {
+        TEST_ASSERT(batches < 3);
+        sizes[batches++] = batch->rows;
+        TEST_ASSERT(batch->columns == 2);
+        const poly_db_vector_t* ids = &batch->vectors[0];
+        const poly_db_vector_t* names = &batch->vectors[1];
+        TEST_ASSERT(ids->format == POLY_DB_COLUMN_VALUE);
+        const poly_db_value_t* values = ids->data;
+        for (size_t i = 0; i < batch->rows; i++) {
+            TEST_ASSERT(poly_db_vector_is_valid(ids, i));
+            int64_t id = values[i].i;
+            sum += id;
+
+            const char* name = NULL;
+            size_t len = 0;
+            if (id % 3) {
+                char expect[32];
+                int n = snprintf(expect, sizeof(expect), "name%lld", (long long)id);
+                TEST_ASSERT(poly_db_vector_get_string(names, i, &name, &len) == INFRA_OK);
+                TEST_ASSERT(len == (size_t)n && memcmp(name, expect, len) == 0);
+            } else {
+                TEST_ASSERT(!poly_db_vector_is_valid(names, i));
+                TEST_ASSERT(poly_db_vector_get_string(names, i, &name, &len) == INFRA_ERROR_NOT_FOUND);
+                nulls++;
+            }
+        }
+    }
+    TEST_ASSERT(err == INFRA_ERROR_NOT_FOUND && batch == NULL);
+    TEST_ASSERT(batches == 3);
+    TEST_ASSERT(sizes[0] == POLY_DB_BATCH_ROWS && sizes[1] == POLY_DB_BATCH_ROWS && sizes[2] == 452);
+    TEST_ASSERT(sum == 3126250 && nulls == 833);
+    TEST_ASSERT(poly_db_cursor_next_batch(cursor, &batch) == INFRA_ERROR_NOT_FOUND);
+    TEST_ASSERT(poly_db_cursor_close(cursor) == INFRA_OK);
+
+    // 空结果
+    TEST_ASSERT(poly_db_cursor_open(db, "SELECT id FROM t WHERE id < 0", &cursor) == INFRA_OK);
+    TEST_ASSERT(poly_db_cursor_next_batch(cursor, &batch) == INFRA_ERROR_NOT_FOUND);
+    TEST_ASSERT(poly_db_cursor_close(cursor) == INFRA_OK);
+
+    poly_db_close(db);
+}
+
+static int64_t query_int64(poly_db_t* db, const char* sql) {
+    poly_db_cursor_t* cursor = NULL;
+    int64_t value = -1;
+    if (poly_db_cursor_open(db, sql, &cursor) == INFRA_OK) {
+        if (poly_db_cursor_next(cursor) == INFRA_OK) {
+            poly_db_cursor_get_int64(cursor, 0, &value);
+        }
+        poly_db_cursor_close(cursor);
+    }
+    return value;
+}
+
+// 测试批量导入
+static void test_db_bulk(void) {
+    poly_db_t* db = NULL;
+    poly_db_config_t config = {
+        .type = POLY_DB_TYPE_SQLITE,
+        .url = ":memory:",
+        .read_only = false,
+        .allow_fallback = false
+    };
+    infra_error_t err = poly_db_open(&config, &db);
+    TEST_ASSERT(err == INFRA_OK);
+    TEST_ASSERT(poly_db_exec(db, "CREATE TABLE t (id INTEGER PRIMARY KEY, name TEXT, score REAL, data BLOB)") == INFRA_OK);
+    TEST_ASSERT(poly_db_exec(db, "PRAGMA synchronous=FULL") == INFRA_OK);
+
+    poly_db_bulk_t* bulk = NULL;
+    TEST_ASSERT(poly_db_bulk_begin(db, "t", &bulk) == INFRA_OK);
+    TEST_ASSERT(poly_db_bulk_column_count(bulk) == 4);
+    // 导入期间关闭 fsync
+    TEST_ASSERT(query_int64(db, "PRAGMA synchronous") == 0);
+
+    poly_db_value_t row[4];
+    char name[32];
+    for (int i = 1; i <= 10000; i++) {
+        memset(row, 0, sizeof(row));
+        row[0].type = POLY_DB_VALUE_INTEGER;
+        row[0].i = i;
+        row[1].type = POLY_DB_VALUE_TEXT;
+        row[1].len = (size_t)snprintf(name, sizeof(name), "name%d", i);
+        row[1].data = name;
+        row[2].type = POLY_DB_VALUE_REAL;
+        row[2].d = i * 0.5;
+        row[3].type = i % 2 ? POLY_DB_VALUE_BLOB : POLY_DB_VALUE_NULL;
+        row[3].data = "\x00\xff";
+        row[3].len = 2;
+        TEST_ASSERT(poly_db_bulk_append_row(bulk, row, 4) == INFRA_OK);
+    }
+    TEST_ASSERT(poly_db_bulk_append_row(bulk, row, 3) == INFRA_ERROR_INVALID_PARAM);
+    TEST_ASSERT(poly_db_bulk_end(bulk, true) == INFRA_OK);
+
+    TEST_ASSERT(query_int64(db, "SELECT COUNT(*) FROM t") == 10000);
+    TEST_ASSERT(query_int64(db, "SELECT SUM(id) FROM t WHERE name = 'name' || id") == 50005000);
+    TEST_ASSERT(query_int64(db, "SELECT COUNT(*) FROM t WHERE data = x'00ff'") == 5000);
+    TEST_ASSERT(query_int64(db, "SELECT SUM(score) FROM t") == 25002500);
+    TEST_ASSERT(query_int64(db, "PRAGMA synchronous") == 2);
+
+    // 不提交时回滚
+    TEST_ASSERT(poly_db_bulk_begin(db, "t", &bulk) == INFRA_OK);
+    row[0].i = 20001;
+    TEST_ASSERT(poly_db_bulk_append_row(bulk, row, 4) == INFRA_OK);
+    TEST_ASSERT(poly_db_bulk_end(bulk, false) == INFRA_OK);
+    TEST_ASSERT(query_int64(db, "SELECT COUNT(*) FROM t") == 10000);
+
+    // 一行失败后整个导入回滚
+    TEST_ASSERT(poly_db_bulk_begin(db, "t", &bulk) == INFRA_OK);
+    row[0].i = 20002;
+    TEST_ASSERT(poly_db_bulk_append_row(bulk, row, 4) == INFRA_OK);
+    row[0].i = 1;
+    TEST_ASSERT(poly_db_bulk_append_row(bulk, row, 4) == INFRA_ERROR_QUERY_FAILED);
+    row[0].i = 20003;
+    TEST_ASSERT(poly_db_bulk_append_row(bulk, row, 4) == INFRA_ERROR_INVALID_STATE);
+    TEST_ASSERT(poly_db_bulk_end(bulk, true) == INFRA_ERROR_INVALID_STATE);
+    TEST_ASSERT(query_int64(db, "SELECT COUNT(*) FROM t") == 10000);
+
+    // 表不存在, 以及已在事务中
+    bulk = NULL;
+    TEST_ASSERT(poly_db_bulk_begin(db, "missing", &bulk) != INFRA_OK);
+    TEST_ASSERT(bulk == NULL);
+    TEST_ASSERT(poly_db_exec(db, "BEGIN") == INFRA_OK);
+    TEST_ASSERT(poly_db_bulk_begin(db, "t", &bulk) == INFRA_ERROR_INVALID_STATE);
+    TEST_ASSERT(poly_db_exec(db, "ROLLBACK") == INFRA_OK);
+
+    poly_db_close(db);
+}
+
+// 测试多语句脚本逐条执行
+static void test_db_cursor_script(void) {
+    poly_db_t* db = NULL;
+    poly_db_config_t config = {
+        .type = POLY_DB_TYPE_SQLITE,
+        .url = ":memory:",
+        .read_only = false,
+        .allow_fallback = false
+    };
+    infra_error_t err = poly_db_open(&config, &db);
+    TEST_ASSERT(err == INFRA_OK);
+
+    // 不以 '\0' 结尾, 长度之后的文本不执行
+    const char* script = "CREATE TABLE t (id INTEGER);\n"
+                         "INSERT INTO t VALUES (1), (2), (3);\n"
+                         "SELECT id FROM t ORDER BY id; -- done\n"
+                         "DROP TABLE t;";
+    size_t len = strlen(script) - strlen("DROP TABLE t;");
+    const char* sql = script;
+    const char* tail = NULL;
+    poly_db_cursor_t* cursor = NULL;
+    int columns[3];
+    int64_t rows[3];
+    int count = 0;
+    while (count < 3) {
+        err = poly_db_cursor_open_script(db, sql, len - (size_t)(sql - script), &cursor, &tail);
+        if (err != INFRA_OK) break;
+        TEST_ASSERT(tail > sql);
+        columns[count] = poly_db_cursor_column_count(cursor);
+        rows[count] = 0;
+        int64_t id = 0;
+        while (poly_db_cursor_next(cursor) == INFRA_OK) {
+            TEST_ASSERT(poly_db_cursor_get_int64(cursor, 0, &id) == INFRA_OK);
+            TEST_ASSERT(id == rows[count] + 1);
+            rows[count]++;
+        }
+        TEST_ASSERT(poly_db_cursor_close(cursor) == INFRA_OK);
+        sql = tail;
+        count++;
+    }
+    TEST_ASSERT(count == 3);
+    TEST_ASSERT(columns[0] == 0 && columns[1] == 0 && columns[2] == 1);
+    TEST_ASSERT(rows[2] == 3);
+    // 只剩注释
+    TEST_ASSERT(poly_db_cursor_open_script(db, sql, len - (size_t)(sql - script), &cursor, &tail) ==
+                INFRA_ERROR_NOT_FOUND);
+    TEST_ASSERT(query_int64(db, "SELECT COUNT(*) FROM t") == 3);
+
+    // 语法错误
+    const char* bad = "SELEC 1; SELECT 2";
+    cursor = NULL;
+    TEST_ASSERT(poly_db_cursor_open_script(db, bad, strlen(bad), &cursor, &tail) != INFRA_OK);
+    TEST_ASSERT(cursor == NULL);
+    TEST_ASSERT(strstr(poly_db_get_error_message(db), "syntax error") != NULL);
+
+    poly_db_close(db);
+}
+
+// 组提交写句柄中执行一条写入, 返回依赖的事务编号
+static uint64_t writer_exec(poly_db_writer_t* writer, const char* sql) {
+    poly_db_t* db = poly_db_writer_begin(writer);
+    TEST_ASSERT(db != NULL);
+    TEST_ASSERT(poly_db_exec(db, sql) == INFRA_OK);
+    return poly_db_writer_end(writer);
+}
+
+// 测试组提交: 事务编号, 提交失败通知每个持有者, 失败记录被挤出环后仍按失败处理
+static void test_db_writer(void) {
+    poly_db_t* db = NULL;
+    poly_db_config_t config = {
+        .type = POLY_DB_TYPE_SQLITE,
+        .url = ":memory:",
+        .read_only = false,
+        .allow_fallback = false
+    };
+    infra_error_t err = poly_db_open(&config, &db);
+    TEST_ASSERT(err == INFRA_OK);
+    // 违反延迟外键约束的事务在 COMMIT 时失败
+    TEST_ASSERT(poly_db_exec(db, "PRAGMA foreign_keys=ON") == INFRA_OK);
+    TEST_ASSERT(poly_db_exec(db, "CREATE TABLE p (id INTEGER PRIMARY KEY)") == INFRA_OK);
+    TEST_ASSERT(poly_db_exec(db, "CREATE TABLE c (pid INTEGER REFERENCES p(id) "
+                                 "DEFERRABLE INITIALLY DEFERRED)") == INFRA_OK);
+
+    // 只按修改行数提交: 每攒够两行提交一次
+    poly_db_writer_t* writer = NULL;
+    poly_db_writer_config_t wconfig = {.max_delay_ms = 600000, .max_ops = 2};
+    TEST_ASSERT(poly_db_writer_create(db, &wconfig, &writer) == INFRA_OK);
+
+    uint64_t t1 = writer_exec(writer, "INSERT INTO p VALUES (1)");
+    TEST_ASSERT(t1 != 0);
+    TEST_ASSERT(poly_db_writer_check(writer, t1, t1) == INFRA_ERROR_WOULD_BLOCK);
+    // 读取可能看到未提交的修改, 依赖同一个事务
+    poly_db_writer_begin(writer);
+    TEST_ASSERT(poly_db_writer_end(writer) == t1);
+    uint64_t t2 = writer_exec(writer, "INSERT INTO p VALUES (2)");
+    TEST_ASSERT(t2 == t1);
+    TEST_ASSERT(poly_db_writer_wait(writer, t2) == INFRA_OK);
+    TEST_ASSERT(poly_db_writer_check(writer, t1, t2) == INFRA_OK);
+    // 没有未提交的修改时读取不依赖事务
+    poly_db_writer_begin(writer);
+    TEST_ASSERT(poly_db_writer_end(writer) == 0);
+
+    // 同一事务的两个持有者都得知提交失败
+    uint64_t t3 = writer_exec(writer, "INSERT INTO p VALUES (3)");
+    TEST_ASSERT(t3 == t2 + 1);
+    uint64_t t4 = writer_exec(writer, "INSERT INTO c VALUES (999)");
+    TEST_ASSERT(t4 == t3);
+    TEST_ASSERT(poly_db_writer_wait(writer, t3) == INFRA_ERROR_IO);
+    TEST_ASSERT(poly_db_writer_check(writer, t4, t4) == INFRA_ERROR_IO);
+    TEST_ASSERT(poly_db_writer_check(writer, t1, t4) == INFRA_ERROR_IO);
+    TEST_ASSERT(poly_db_writer_check(writer, t1, t2) == INFRA_OK);
+    TEST_ASSERT(query_int64(db, "SELECT COUNT(*) FROM p") == 2);
+
+    // 失败记录多于环的容量, 最早的失败不能被当成提交成功
+    uint64_t ticket = 0;
+    for (int i = 0; i < 20; i++) {
+        ticket = writer_exec(writer, "INSERT INTO c VALUES (998), (999)");
+        TEST_ASSERT(ticket == t3 + 1 + (uint64_t)i);
+        TEST_ASSERT(poly_db_writer_wait(writer, ticket) == INFRA_ERROR_IO);
+    }
+    TEST_ASSERT(poly_db_writer_check(writer, t3, t3) == INFRA_ERROR_IO);
+    TEST_ASSERT(poly_db_writer_check(writer, t3 + 1, t3 + 1) == INFRA_ERROR_IO);
+    TEST_ASSERT(poly_db_writer_check(writer, ticket, ticket) == INFRA_ERROR_IO);
+
+    // 之后成功的事务不受影响
+    uint64_t t5 = writer_exec(writer, "INSERT INTO p VALUES (5), (6)");
+    TEST_ASSERT(t5 == ticket + 1);
+    TEST_ASSERT(poly_db_writer_wait(writer, t5) == INFRA_OK);
+    TEST_ASSERT(poly_db_writer_check(writer, t5, t5) == INFRA_OK);
+
+    poly_db_writer_stats_t stats;
+    poly_db_writer_get_stats(writer, &stats);
+    TEST_ASSERT(stats.commits == 2 && stats.failures == 21 && stats.ops == 4);
+
+    poly_db_writer_destroy(writer);
+    TEST_ASSERT(query_int64(db, "SELECT COUNT(*) FROM p") == 4);
+    poly_db_close(db);
+}
+
 // 测试入口
 int main(int argc, char** argv) {
     TEST_BEGIN();
     RUN_TEST(test_db_open);
     RUN_TEST(test_db_basic);
+    RUN_TEST(test_db_stmt_cache);
+    RUN_TEST(test_db_cursor);
+    RUN_TEST(test_db_cursor_batch);
+    RUN_TEST(test_db_bulk);
+    RUN_TEST(test_db_cursor_script);
+    RUN_TEST(test_db_writer);
     TEST_END();
 }
@@ -99,6 +99,28 @@ void test_memory_operations(void) {
     teardown_test();
 }
 
+// Realloc growth test: the old block is smaller than the new size,
+// only its bytes may be copied
+void test_memory_realloc_grow(void) {
+    setup_test();
+
+    char* buf = infra_malloc(16);
+    TEST_ASSERT(buf != NULL);
+    memset(buf, 0x5A, 16);
+
+    for (size_t size = 4096; size <= 1024 * 1024; size *= 4) {
+        buf = infra_realloc(buf, size);
+        TEST_ASSERT(buf != NULL);
+        for (int i = 0; i < 16; i++) {
+            TEST_ASSERT(buf[i] == 0x5A);
+        }
+        memset(buf + 16, 0, size - 16);
+    }
+
+    infra_free(buf);
+    teardown_test();
+}
+
 // Memory performance test
 void test_memory_performance(void) {
     setup_test();
@@ -166,6 +188,7 @@ int main(void) {
     TEST_RUN(test_memory_cleanup);
     TEST_RUN(test_memory_basic);
     TEST_RUN(test_memory_operations);
+    TEST_RUN(test_memory_realloc_grow);
     TEST_RUN(test_memory_performance);
     TEST_RUN(test_memory_stress);
 
@@ -4,6 +4,7 @@
 #include "internal/infra/infra_sync.h"
 #include "internal/infra/infra_platform.h"
 #include <stdio.h>
+#include <time.h>
 
 static void* thread_func(void* arg) {
     int* counter = (int*)arg;
@@ -168,12 +169,43 @@ static void test_thread_pool(void) {
     TEST_ASSERT(err == INFRA_OK);
 }
 
+// idle_timeout 为 0 时空闲线程阻塞等待: 空闲期间几乎不占 CPU, 有任务时仍能及时执行, 销毁时能退出
+static void test_thread_pool_idle_block(void) {
+    infra_error_t err;
+    infra_thread_pool_t* pool;
+    int counter = 0;
+
+    infra_thread_pool_config_t config = {
+        .min_threads = 1,
+        .max_threads = 1,
+        .queue_size = 10,
+        .idle_timeout = 0
+    };
+    err = infra_thread_pool_create(&config, &pool);
+    TEST_ASSERT(err == INFRA_OK);
+
+    clock_t start = clock();
+    infra_sleep(500);
+    TEST_ASSERT((clock() - start) * 1000 / CLOCKS_PER_SEC < 20);
+
+    for (int i = 0; i < 5; i++) {
+        err = infra_thread_pool_submit(pool, task_func, &counter);
+        TEST_ASSERT(err == INFRA_OK);
+    }
+    infra_sleep(100);
+    TEST_ASSERT(counter == 5);
+
+    err = infra_thread_pool_destroy(pool);
+    TEST_ASSERT(err == INFRA_OK);
+}
+
 int main(void) {
     TEST_RUN(test_thread);
     TEST_RUN(test_mutex);
     TEST_RUN(test_cond);
     TEST_RUN(test_rwlock);
     TEST_RUN(test_thread_pool);
+    TEST_RUN(test_thread_pool_idle_block);
     
     return 0;
 }
\ No newline at end of file
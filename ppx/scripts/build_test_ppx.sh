@@ -44,6 +44,14 @@ build_tests() {
         exit 1
     fi
 
+    # PPX objects the tests link against, ppx.o carries main()
+    local ppx_objects=()
+    for obj in "${build_dir}"/*.o; do
+        if [ "$(basename "${obj}")" != "ppx.o" ]; then
+            ppx_objects+=("${obj}")
+        fi
+    done
+
     # Compile and link tests
     echo "Building and running tests..."
     for src in "${TEST_SOURCES[@]}"; do
@@ -56,7 +64,7 @@ build_tests() {
         fi
         
         echo "Building test: ${test_name}"
-        "${CC}" ${CFLAGS} "${src}" -L"${build_dir}" -L"${BUILD_DIR}/arch" -larch -o "${test_bin}"
+        "${CC}" ${CFLAGS} "${src}" "${ppx_objects[@]}" -L"${build_dir}" -L"${BUILD_DIR}/arch" -larch -o "${test_bin}"
         if [ $? -ne 0 ]; then
             echo "Failed to build test: ${test_name}"
             exit 1
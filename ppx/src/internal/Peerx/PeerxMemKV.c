@@ -1,77 +1,247 @@
 #include "PeerxMemKV.h"
-#include "internal/infrax/InfraxMemory.h"
 #include "internal/infrax/InfraxHash.h"
+#include "internal/infrax/InfraxSync.h"
+#include "internal/infrax/InfraxThread.h"
 #include <string.h>
 #include <stdio.h>
 #include <time.h>
-
-#define MAX_BUCKETS 1024
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// All store memory comes from the system allocator: stripes allocate and free
+// entries concurrently, and the InfraxMemory pool has no locking of its own
+#define INITIAL_BUCKETS 1024
 #define LOAD_FACTOR_THRESHOLD 0.75
 
-// Hash table entry
+// Number of lock stripes, a power of two no larger than INITIAL_BUCKETS.
+// Table sizes are powers of two >= LOCK_STRIPES, so the low bits of a key's
+// hash pick the same stripe in the old and the new table during a rehash
+#define LOCK_STRIPES 64
+
+// Old-table buckets a writer migrates per operation while rehashing
+#define REHASH_STEP_BUCKETS 4
+
+// Buckets the incremental expiry cycle visits per write operation
+#define EXPIRE_CYCLE_BUCKETS 16
+
+// scan: default key count, and buckets visited per requested key at most
+// (bounds the work of a call over a sparse table)
+#define SCAN_DEFAULT_COUNT 10
+#define SCAN_BUCKETS_PER_KEY 10
+
+// Longest key the entry header can describe
+#define MAX_KEY_LEN 0xffff
+
+// Hash table entry, one allocation holding header, key and value:
+//   [header][key bytes]['\0'][value bytes]
+// INT and FLOAT values live in the header, STRING values keep their
+// terminator so borrowed strings can be used directly.
+// The table owns one reference, each borrower one more
 typedef struct peerx_memkv_entry {
-    peerx_memkv_pair_t pair;
     struct peerx_memkv_entry* next;
+    int64_t expire_at;         // Unix timestamp in milliseconds, 0 for no expiration
+    union {
+        int64_t i;
+        double f;
+    } num;
+    uint32_t hash;
+    uint32_t refcount;         // Atomic
+    uint32_t value_len;        // Bytes after the key, 0 for a NULL string/binary
+    uint16_t key_len;
+    uint8_t type;              // peerx_memkv_type_t
+    uint8_t reserved;
+    char data[];
 } peerx_memkv_entry_t;
 
-// Private data structure
+#define ENTRY_KEY(e) ((e)->data)
+#define ENTRY_VALUE(e) ((e)->data + (e)->key_len + 1)
+
+// Snapshot file layout (native byte order):
+//   [file header][section table: LOCK_STRIPES x {offset, count}][records...]
+// one section per lock stripe, each record is
+//   [record header][key bytes]['\0'][value bytes][zero padding to 8 bytes]
+// The key/value bytes match an entry's data, so the loader copies them in one go.
+// The loader threads claim whole sections
+#define SNAPSHOT_MAGIC "PXKVSNP1"
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_BUFFER_SIZE (1024 * 1024)
+#define SNAPSHOT_LOAD_THREADS 8
+
 typedef struct {
-    InfraxMemory* memory;
-    peerx_memkv_entry_t* buckets[MAX_BUCKETS];
+    char magic[8];
+    uint32_t version;
+    uint32_t sections;         // LOCK_STRIPES of the writer
+    uint64_t count;            // Total records
+    int64_t created_at;        // Unix timestamp in milliseconds
+} peerx_memkv_snap_header_t;
+
+typedef struct {
+    uint64_t offset;           // From the start of the file
+    uint64_t count;
+} peerx_memkv_snap_section_t;
+
+typedef struct {
+    int64_t expire_at;
+    int64_t num;               // INT/FLOAT bits
+    uint32_t value_len;
+    uint16_t key_len;
+    uint8_t type;
+    uint8_t reserved;
+    uint32_t padding;
+} peerx_memkv_snap_record_t;
+
+#define SNAPSHOT_ALIGN(n) (((n) + 7) & ~(size_t)7)
+// Smallest record on disk (empty key and value), bounds the record count a file can hold
+#define SNAPSHOT_MIN_RECORD SNAPSHOT_ALIGN(sizeof(peerx_memkv_snap_record_t) + 1)
+#define SNAPSHOT_MAX_BUCKETS ((size_t)1 << 30)
+
+// Compiled glob pattern: the literal prefix is compared with memcmp first and
+// only the rest of the pattern goes through the matcher
+typedef struct {
+    const char* pattern;       // NULL matches every key
+    size_t len;
+    size_t prefix_len;         // Literal bytes before the first special char
+    bool literal;              // No special chars, exact compare
+    bool prefix_star;          // Pattern is "<prefix>*"
+} peerx_memkv_glob_t;
+
+// Bucket array, size is a power of two
+typedef struct {
+    peerx_memkv_entry_t** buckets;
     size_t size;
+    size_t mask;
+} peerx_memkv_table_t;
+
+// Lock stripe: guards bucket i of both tables for every i with
+// (i & (LOCK_STRIPES - 1)) equal to the stripe index
+typedef struct {
+    InfraxSync* lock;          // rwlock
+    size_t rehash_pos;         // Next old-table bucket (in stripe order) to migrate
+    bool rehash_done;          // All of this stripe's old buckets migrated
+    size_t expire_pos;         // Next bucket (in stripe order) for the expiry cycle
+} peerx_memkv_stripe_t;
+
+// Private data structure
+//
+// Redis-style incremental rehash: when the load factor is exceeded a table of
+// twice the size is allocated as ht[1] and every write migrates a few buckets
+// of its own stripe from ht[0]; lookups check both tables until the last
+// stripe is done and ht[1] becomes ht[0]. Allocating and swapping tables are
+// the only steps that take all stripe locks.
+typedef struct {
+    peerx_memkv_table_t ht[2];
+    bool rehashing;            // Changed only with every stripe write-locked
+    peerx_memkv_stripe_t stripes[LOCK_STRIPES];
+    InfraxSync* size;          // Atomic key count
+    InfraxSync* stripes_done;  // Atomic count of stripes done migrating
+    InfraxSync* help_cursor;   // Atomic, spreads rehash help over idle stripes
+    InfraxThread* snapshot_thread;
+    char* snapshot_path;
+    infrax_error_t snapshot_result;
     InfraxHash* hash;
 } PeerxMemKVPrivate;
 
-// Global memory manager
-static InfraxMemory* g_memory = NULL;
-extern InfraxMemoryClassType InfraxMemoryClass;
 extern InfraxHashClassType InfraxHashClass;
+extern InfraxSyncClassType InfraxSyncClass;
+
+// Forward declarations of operations
+static infrax_error_t peerx_memkv_set(PeerxMemKV* self, const char* key, const peerx_memkv_value_t* value);
+static infrax_error_t peerx_memkv_set_ex(PeerxMemKV* self, const char* key,
+                                        const peerx_memkv_value_t* value, int64_t ttl_ms);
+static infrax_error_t peerx_memkv_get(PeerxMemKV* self, const char* key, peerx_memkv_value_t* value);
+static infrax_error_t peerx_memkv_del(PeerxMemKV* self, const char* key);
+static bool peerx_memkv_exists(PeerxMemKV* self, const char* key);
+static infrax_error_t peerx_memkv_borrow(PeerxMemKV* self, const char* key, peerx_memkv_ref_t* ref);
+static void peerx_memkv_release(PeerxMemKV* self, peerx_memkv_ref_t* ref);
+static infrax_error_t peerx_memkv_multi_set(PeerxMemKV* self, const peerx_memkv_pair_t* pairs, size_t count);
+static infrax_error_t peerx_memkv_multi_get(PeerxMemKV* self, const char** keys, size_t key_count,
+                                           peerx_memkv_pair_t* pairs, size_t* pair_count);
+static infrax_error_t peerx_memkv_multi_del(PeerxMemKV* self, const char** keys, size_t count);
+static infrax_error_t peerx_memkv_keys(PeerxMemKV* self, const char* pattern, char** keys, size_t* count);
+static infrax_error_t peerx_memkv_scan(PeerxMemKV* self, uint64_t cursor, const char* pattern,
+                                       size_t count, peerx_memkv_scan_fn fn, void* ctx,
+                                       uint64_t* next_cursor);
+static infrax_error_t peerx_memkv_expire(PeerxMemKV* self, const char* key, int64_t ttl_ms);
+static infrax_error_t peerx_memkv_ttl(PeerxMemKV* self, const char* key, int64_t* ttl_ms);
+static infrax_error_t peerx_memkv_snapshot(PeerxMemKV* self, const char* path);
+static infrax_error_t peerx_memkv_snapshot_wait(PeerxMemKV* self);
+static infrax_error_t peerx_memkv_load(PeerxMemKV* self, const char* path);
+static infrax_error_t peerx_memkv_flush(PeerxMemKV* self);
+static infrax_error_t peerx_memkv_info(PeerxMemKV* self, char* info, size_t size);
 
 // Forward declarations of private functions
-static bool init_memory(void);
-static void cleanup_entry(PeerxMemKVPrivate* private, peerx_memkv_entry_t* entry);
+static peerx_memkv_entry_t* entry_new(const char* key, size_t key_len, uint32_t hash,
+                                      const peerx_memkv_value_t* value, int64_t expire_at);
+static void entry_release(peerx_memkv_entry_t* entry);
+static infrax_error_t entry_to_value(const peerx_memkv_entry_t* entry, peerx_memkv_value_t* value);
 static bool is_expired(const peerx_memkv_entry_t* entry);
-static void cleanup_expired(PeerxMemKV* self);
+static bool table_init(peerx_memkv_table_t* table, size_t size);
+static void table_clear(PeerxMemKVPrivate* private, peerx_memkv_table_t* table);
+static void private_free(PeerxMemKVPrivate* private);
+static peerx_memkv_stripe_t* stripe_for(PeerxMemKVPrivate* private, uint32_t hash);
+static void lock_all(PeerxMemKVPrivate* private);
+static void unlock_all(PeerxMemKVPrivate* private);
+static peerx_memkv_entry_t** find_entry(PeerxMemKVPrivate* private, const char* key,
+                                        size_t key_len, uint32_t hash);
+static void remove_entry(PeerxMemKVPrivate* private, peerx_memkv_entry_t** pp);
+static bool rehash_step(PeerxMemKVPrivate* private, size_t stripe);
+static void rehash_start(PeerxMemKVPrivate* private);
+static void rehash_finish(PeerxMemKVPrivate* private);
+static void rehash_help(PeerxMemKVPrivate* private);
+static void expire_cycle(PeerxMemKVPrivate* private, size_t stripe);
+static void* snapshot_thread(void* arg);
+static infrax_error_t snapshot_wait(PeerxMemKVPrivate* private);
+static void glob_compile(peerx_memkv_glob_t* glob, const char* pattern);
+static bool glob_match_key(const peerx_memkv_glob_t* glob, const char* key, size_t key_len);
+static uint64_t scan_step(PeerxMemKVPrivate* private, uint64_t v, const peerx_memkv_glob_t* glob,
+                          peerx_memkv_scan_fn fn, void* ctx, size_t* emitted);
 
 // Constructor
 static PeerxMemKV* peerx_memkv_new(void) {
-    // Initialize memory if needed
-    if (!init_memory()) {
-        return NULL;
-    }
-
     // Allocate instance
-    PeerxMemKV* self = g_memory->alloc(g_memory, sizeof(PeerxMemKV));
+    PeerxMemKV* self = malloc(sizeof(PeerxMemKV));
     if (!self) {
         return NULL;
     }
 
     // Initialize instance
     memset(self, 0, sizeof(PeerxMemKV));
-    
+
     // Initialize base service
     PeerxService* base = PeerxServiceClass.new();
     if (!base) {
-        g_memory->dealloc(g_memory, self);
+        free(self);
         return NULL;
     }
     memcpy(&self->base, base, sizeof(PeerxService));
-    g_memory->dealloc(g_memory, base);
+    // The async instance now belongs to self->base, hand the rest back to PeerxService
+    base->async = NULL;
+    PeerxServiceClass.free(base);
 
     // Allocate private data
-    PeerxMemKVPrivate* private = g_memory->alloc(g_memory, sizeof(PeerxMemKVPrivate));
+    PeerxMemKVPrivate* private = malloc(sizeof(PeerxMemKVPrivate));
     if (!private) {
-        g_memory->dealloc(g_memory, self);
+        free(self);
         return NULL;
     }
 
     // Initialize private data
     memset(private, 0, sizeof(PeerxMemKVPrivate));
-    private->memory = g_memory;
     private->hash = InfraxHashClass.new();
-    if (!private->hash) {
-        g_memory->dealloc(g_memory, private);
-        g_memory->dealloc(g_memory, self);
+    private->size = InfraxSyncClass.new(INFRAX_SYNC_TYPE_ATOMIC);
+    private->stripes_done = InfraxSyncClass.new(INFRAX_SYNC_TYPE_ATOMIC);
+    private->help_cursor = InfraxSyncClass.new(INFRAX_SYNC_TYPE_ATOMIC);
+    bool ok = private->hash && private->size && private->stripes_done &&
+              private->help_cursor && table_init(&private->ht[0], INITIAL_BUCKETS);
+    for (int i = 0; ok && i < LOCK_STRIPES; i++) {
+        private->stripes[i].lock = InfraxSyncClass.new(INFRAX_SYNC_TYPE_RWLOCK);
+        ok = private->stripes[i].lock != NULL;
+    }
+    if (!ok) {
+        private_free(private);
+        free(self);
         return NULL;
     }
 
@@ -83,12 +253,18 @@ static PeerxMemKV* peerx_memkv_new(void) {
     self->get = peerx_memkv_get;
     self->del = peerx_memkv_del;
     self->exists = peerx_memkv_exists;
+    self->borrow = peerx_memkv_borrow;
+    self->release = peerx_memkv_release;
     self->multi_set = peerx_memkv_multi_set;
     self->multi_get = peerx_memkv_multi_get;
     self->multi_del = peerx_memkv_multi_del;
     self->keys = peerx_memkv_keys;
+    self->scan = peerx_memkv_scan;
     self->expire = peerx_memkv_expire;
     self->ttl = peerx_memkv_ttl;
+    self->snapshot = peerx_memkv_snapshot;
+    self->snapshot_wait = peerx_memkv_snapshot_wait;
+    self->load = peerx_memkv_load;
     self->flush = peerx_memkv_flush;
     self->info = peerx_memkv_info;
 
@@ -107,32 +283,19 @@ static void peerx_memkv_free(PeerxMemKV* self) {
     // Free private data
     PeerxMemKVPrivate* private = self->base.private_data;
     if (private) {
-        // Free all entries
-        for (int i = 0; i < MAX_BUCKETS; i++) {
-            peerx_memkv_entry_t* entry = private->buckets[i];
-            while (entry) {
-                peerx_memkv_entry_t* next = entry->next;
-                cleanup_entry(private, entry);
-                entry = next;
-            }
-        }
-
-        if (private->hash) {
-            InfraxHashClass.free(private->hash);
-        }
-        private->memory->dealloc(private->memory, private);
+        private_free(private);
     }
 
-    g_memory->dealloc(g_memory, self);
+    free(self);
 }
 
 // Key-value operations
-static infrax_error_t peerx_memkv_set(PeerxMemKV* self, const char* key, 
+static infrax_error_t peerx_memkv_set(PeerxMemKV* self, const char* key,
                                      const peerx_memkv_value_t* value) {
     return peerx_memkv_set_ex(self, key, value, 0);
 }
 
-static infrax_error_t peerx_memkv_set_ex(PeerxMemKV* self, const char* key, 
+static infrax_error_t peerx_memkv_set_ex(PeerxMemKV* self, const char* key,
                                         const peerx_memkv_value_t* value,
                                         int64_t ttl_ms) {
     if (!self || !key || !value) {
@@ -144,51 +307,66 @@ static infrax_error_t peerx_memkv_set_ex(PeerxMemKV* self, const char* key,
         return INFRAX_ERROR_INVALID_STATE;
     }
 
-    // Calculate hash
-    uint32_t hash = InfraxHashClass.hash(private->hash, key, strlen(key));
-    uint32_t bucket = hash % MAX_BUCKETS;
-
-    // Check if key exists
-    peerx_memkv_entry_t* entry = private->buckets[bucket];
-    while (entry) {
-        if (strcmp(entry->pair.key, key) == 0) {
-            // Update value
-            peerx_memkv_value_free(&entry->pair.value);
-            infrax_error_t err = peerx_memkv_value_copy(&entry->pair.value, value);
-            if (err != INFRAX_OK) {
-                return err;
-            }
-            entry->pair.expire_at = ttl_ms ? (time(NULL) * 1000 + ttl_ms) : 0;
-            return INFRAX_OK;
-        }
-        entry = entry->next;
+    size_t key_len = strlen(key);
+    if (key_len > MAX_KEY_LEN) {
+        return INFRAX_ERROR_INVALID_PARAM;
     }
 
-    // Create new entry
-    entry = g_memory->alloc(g_memory, sizeof(peerx_memkv_entry_t));
+    // Build the entry before taking the lock
+    uint32_t hash = InfraxHashClass.hash(private->hash, key, key_len);
+    int64_t expire_at = ttl_ms ? (time(NULL) * 1000 + ttl_ms) : 0;
+    peerx_memkv_entry_t* entry = entry_new(key, key_len, hash, value, expire_at);
     if (!entry) {
         return INFRAX_ERROR_NO_MEMORY;
     }
 
-    // Initialize entry
-    memset(entry, 0, sizeof(peerx_memkv_entry_t));
-    strncpy(entry->pair.key, key, sizeof(entry->pair.key) - 1);
-    infrax_error_t err = peerx_memkv_value_copy(&entry->pair.value, value);
-    if (err != INFRAX_OK) {
-        g_memory->dealloc(g_memory, entry);
-        return err;
+    size_t s = hash & (LOCK_STRIPES - 1);
+    peerx_memkv_stripe_t* stripe = &private->stripes[s];
+
+    InfraxSyncClass.rwlock_write_lock(stripe->lock);
+
+    // Amortised maintenance on this stripe: migrate and reclaim a few buckets
+    bool finished = rehash_step(private, s);
+    expire_cycle(private, s);
+
+    peerx_memkv_entry_t* old = NULL;
+    peerx_memkv_entry_t** pp = find_entry(private, key, key_len, hash);
+    if (pp) {
+        // Swap the new entry into the old one's place, borrowers keep the old one alive
+        old = *pp;
+        entry->next = old->next;
+        *pp = entry;
+    } else {
+        // New keys go to the new table while rehashing
+        peerx_memkv_table_t* table = &private->ht[private->rehashing ? 1 : 0];
+        peerx_memkv_entry_t** bucket = &table->buckets[hash & table->mask];
+        entry->next = *bucket;
+        *bucket = entry;
+        InfraxSyncClass.atomic_fetch_add(private->size, 1);
     }
-    entry->pair.expire_at = ttl_ms ? (time(NULL) * 1000 + ttl_ms) : 0;
 
-    // Add to bucket
-    entry->next = private->buckets[bucket];
-    private->buckets[bucket] = entry;
-    private->size++;
+    bool rehashing = private->rehashing;
+    bool grow = !rehashing &&
+                (double)InfraxSyncClass.atomic_load(private->size) >
+                (double)private->ht[0].size * LOAD_FACTOR_THRESHOLD;
+    InfraxSyncClass.rwlock_write_unlock(stripe->lock);
+
+    if (old) {
+        entry_release(old);
+    }
+
+    if (finished) {
+        rehash_finish(private);
+    } else if (rehashing) {
+        rehash_help(private);
+    } else if (grow) {
+        rehash_start(private);
+    }
 
     return INFRAX_OK;
 }
 
-static infrax_error_t peerx_memkv_get(PeerxMemKV* self, const char* key, 
+static infrax_error_t peerx_memkv_get(PeerxMemKV* self, const char* key,
                                      peerx_memkv_value_t* value) {
     if (!self || !key || !value) {
         return INFRAX_ERROR_INVALID_PARAM;
@@ -199,24 +377,16 @@ static infrax_error_t peerx_memkv_get(PeerxMemKV* self, const char* key,
         return INFRAX_ERROR_INVALID_STATE;
     }
 
-    // Calculate hash
-    uint32_t hash = InfraxHashClass.hash(private->hash, key, strlen(key));
-    uint32_t bucket = hash % MAX_BUCKETS;
-
-    // Find key
-    peerx_memkv_entry_t* entry = private->buckets[bucket];
-    while (entry) {
-        if (strcmp(entry->pair.key, key) == 0) {
-            if (is_expired(entry)) {
-                cleanup_expired(self);
-                return INFRAX_ERROR_NOT_FOUND;
-            }
-            return peerx_memkv_value_copy(value, &entry->pair.value);
-        }
-        entry = entry->next;
+    // Copy out of a borrowed entry so the allocation happens outside the lock
+    peerx_memkv_ref_t ref;
+    infrax_error_t err = peerx_memkv_borrow(self, key, &ref);
+    if (err != INFRAX_OK) {
+        return err;
     }
+    err = entry_to_value(ref.entry, value);
+    peerx_memkv_release(self, &ref);
 
-    return INFRAX_ERROR_NOT_FOUND;
+    return err;
 }
 
 static infrax_error_t peerx_memkv_del(PeerxMemKV* self, const char* key) {
@@ -230,24 +400,21 @@ static infrax_error_t peerx_memkv_del(PeerxMemKV* self, const char* key) {
     }
 
     // Calculate hash
-    uint32_t hash = InfraxHashClass.hash(private->hash, key, strlen(key));
-    uint32_t bucket = hash % MAX_BUCKETS;
+    size_t key_len = strlen(key);
+    uint32_t hash = InfraxHashClass.hash(private->hash, key, key_len);
+    peerx_memkv_stripe_t* stripe = stripe_for(private, hash);
 
     // Find and remove key
-    peerx_memkv_entry_t** pp = &private->buckets[bucket];
-    peerx_memkv_entry_t* entry = *pp;
-    while (entry) {
-        if (strcmp(entry->pair.key, key) == 0) {
-            *pp = entry->next;
-            cleanup_entry(private, entry);
-            private->size--;
-            return INFRAX_OK;
-        }
-        pp = &entry->next;
-        entry = entry->next;
+    infrax_error_t err = INFRAX_ERROR_NOT_FOUND;
+    InfraxSyncClass.rwlock_write_lock(stripe->lock);
+    peerx_memkv_entry_t** pp = find_entry(private, key, key_len, hash);
+    if (pp) {
+        remove_entry(private, pp);
+        err = INFRAX_OK;
     }
+    InfraxSyncClass.rwlock_write_unlock(stripe->lock);
 
-    return INFRAX_ERROR_NOT_FOUND;
+    return err;
 }
 
 static bool peerx_memkv_exists(PeerxMemKV* self, const char* key) {
@@ -261,27 +428,83 @@ static bool peerx_memkv_exists(PeerxMemKV* self, const char* key) {
     }
 
     // Calculate hash
-    uint32_t hash = InfraxHashClass.hash(private->hash, key, strlen(key));
-    uint32_t bucket = hash % MAX_BUCKETS;
-
-    // Find key
-    peerx_memkv_entry_t* entry = private->buckets[bucket];
-    while (entry) {
-        if (strcmp(entry->pair.key, key) == 0) {
-            if (is_expired(entry)) {
-                cleanup_expired(self);
-                return false;
-            }
-            return true;
-        }
-        entry = entry->next;
+    size_t key_len = strlen(key);
+    uint32_t hash = InfraxHashClass.hash(private->hash, key, key_len);
+    peerx_memkv_stripe_t* stripe = stripe_for(private, hash);
+
+    InfraxSyncClass.rwlock_read_lock(stripe->lock);
+    peerx_memkv_entry_t** pp = find_entry(private, key, key_len, hash);
+    bool found = pp && !is_expired(*pp);
+    InfraxSyncClass.rwlock_read_unlock(stripe->lock);
+
+    return found;
+}
+
+static infrax_error_t peerx_memkv_borrow(PeerxMemKV* self, const char* key,
+                                        peerx_memkv_ref_t* ref) {
+    if (!self || !key || !ref) {
+        return INFRAX_ERROR_INVALID_PARAM;
+    }
+
+    PeerxMemKVPrivate* private = self->base.private_data;
+    if (!private) {
+        return INFRAX_ERROR_INVALID_STATE;
     }
 
-    return false;
+    memset(ref, 0, sizeof(peerx_memkv_ref_t));
+
+    // Calculate hash
+    size_t key_len = strlen(key);
+    uint32_t hash = InfraxHashClass.hash(private->hash, key, key_len);
+    peerx_memkv_stripe_t* stripe = stripe_for(private, hash);
+
+    // Readers share the stripe; expired keys are left to the expiry cycle
+    peerx_memkv_entry_t* entry = NULL;
+    InfraxSyncClass.rwlock_read_lock(stripe->lock);
+    peerx_memkv_entry_t** pp = find_entry(private, key, key_len, hash);
+    if (pp && !is_expired(*pp)) {
+        entry = *pp;
+        __atomic_fetch_add(&entry->refcount, 1, __ATOMIC_RELAXED);
+    }
+    InfraxSyncClass.rwlock_read_unlock(stripe->lock);
+
+    if (!entry) {
+        return INFRAX_ERROR_NOT_FOUND;
+    }
+
+    ref->type = (peerx_memkv_type_t)entry->type;
+    ref->key = ENTRY_KEY(entry);
+    ref->key_len = entry->key_len;
+    ref->expire_at = entry->expire_at;
+    switch (ref->type) {
+        case PEERX_MEMKV_TYPE_INT:
+            ref->i = entry->num.i;
+            break;
+        case PEERX_MEMKV_TYPE_FLOAT:
+            ref->f = entry->num.f;
+            break;
+        case PEERX_MEMKV_TYPE_STRING:
+            ref->data = entry->value_len ? ENTRY_VALUE(entry) : NULL;
+            ref->size = entry->value_len ? entry->value_len - 1 : 0;
+            break;
+        case PEERX_MEMKV_TYPE_BINARY:
+            ref->data = entry->value_len ? ENTRY_VALUE(entry) : NULL;
+            ref->size = entry->value_len;
+            break;
+    }
+    ref->entry = entry;
+    return INFRAX_OK;
+}
+
+static void peerx_memkv_release(PeerxMemKV* self, peerx_memkv_ref_t* ref) {
+    (void)self;
+    if (!ref || !ref->entry) return;
+    entry_release((peerx_memkv_entry_t*)ref->entry);
+    memset(ref, 0, sizeof(peerx_memkv_ref_t));
 }
 
 // Batch operations
-static infrax_error_t peerx_memkv_multi_set(PeerxMemKV* self, 
+static infrax_error_t peerx_memkv_multi_set(PeerxMemKV* self,
                                            const peerx_memkv_pair_t* pairs,
                                            size_t count) {
     if (!self || !pairs || count == 0) {
@@ -311,7 +534,7 @@ static infrax_error_t peerx_memkv_multi_get(PeerxMemKV* self, const char** keys,
     for (size_t i = 0; i < key_count && found < *pair_count; i++) {
         peerx_memkv_value_t value;
         peerx_memkv_value_init(&value);
-        
+
         infrax_error_t err = peerx_memkv_get(self, keys[i], &value);
         if (err == INFRAX_OK) {
             strncpy(pairs[found].key, keys[i], sizeof(pairs[found].key) - 1);
@@ -349,29 +572,80 @@ static infrax_error_t peerx_memkv_keys(PeerxMemKV* self, const char* pattern,
         return INFRAX_ERROR_INVALID_STATE;
     }
 
+    // Walk one stripe at a time so writers on other stripes keep going
     size_t found = 0;
-    for (int i = 0; i < MAX_BUCKETS && found < *count; i++) {
-        peerx_memkv_entry_t* entry = private->buckets[i];
-        while (entry && found < *count) {
-            if (!is_expired(entry) && (!pattern || strstr(entry->pair.key, pattern))) {
-                keys[found] = g_memory->alloc(g_memory, strlen(entry->pair.key) + 1);
-                if (!keys[found]) {
-                    for (size_t j = 0; j < found; j++) {
-                        g_memory->dealloc(g_memory, keys[j]);
+    infrax_error_t err = INFRAX_OK;
+    for (size_t s = 0; s < LOCK_STRIPES && found < *count && err == INFRAX_OK; s++) {
+        peerx_memkv_stripe_t* stripe = &private->stripes[s];
+        InfraxSyncClass.rwlock_read_lock(stripe->lock);
+        for (int t = 0; t < (private->rehashing ? 2 : 1) && err == INFRAX_OK; t++) {
+            peerx_memkv_table_t* table = &private->ht[t];
+            for (size_t b = s; b < table->size && found < *count; b += LOCK_STRIPES) {
+                peerx_memkv_entry_t* entry = table->buckets[b];
+                while (entry && found < *count) {
+                    if (!is_expired(entry) && (!pattern || strstr(ENTRY_KEY(entry), pattern))) {
+                        keys[found] = malloc(entry->key_len + 1);
+                        if (!keys[found]) {
+                            err = INFRAX_ERROR_NO_MEMORY;
+                            break;
+                        }
+                        memcpy(keys[found], ENTRY_KEY(entry), entry->key_len + 1);
+                        found++;
                     }
-                    return INFRAX_ERROR_NO_MEMORY;
+                    entry = entry->next;
+                }
+                if (err != INFRAX_OK) {
+                    break;
                 }
-                strcpy(keys[found], entry->pair.key);
-                found++;
             }
-            entry = entry->next;
         }
+        InfraxSyncClass.rwlock_read_unlock(stripe->lock);
+    }
+
+    if (err != INFRAX_OK) {
+        for (size_t j = 0; j < found; j++) {
+            free(keys[j]);
+        }
+        return err;
     }
 
     *count = found;
     return INFRAX_OK;
 }
 
+static infrax_error_t peerx_memkv_scan(PeerxMemKV* self, uint64_t cursor, const char* pattern,
+                                       size_t count, peerx_memkv_scan_fn fn, void* ctx,
+                                       uint64_t* next_cursor) {
+    if (!self || !fn || !next_cursor) {
+        return INFRAX_ERROR_INVALID_PARAM;
+    }
+
+    PeerxMemKVPrivate* private = self->base.private_data;
+    if (!private) {
+        return INFRAX_ERROR_INVALID_STATE;
+    }
+
+    peerx_memkv_glob_t glob;
+    glob_compile(&glob, pattern);
+    if (count == 0) {
+        count = SCAN_DEFAULT_COUNT;
+    }
+
+    // One bucket (plus its expansion in the larger table) per step. All of
+    // them share the cursor's low bits, so a single stripe lock covers a step
+    size_t emitted = 0;
+    size_t budget = count * SCAN_BUCKETS_PER_KEY;
+    do {
+        peerx_memkv_stripe_t* stripe = &private->stripes[cursor & (LOCK_STRIPES - 1)];
+        InfraxSyncClass.rwlock_read_lock(stripe->lock);
+        cursor = scan_step(private, cursor, &glob, fn, ctx, &emitted);
+        InfraxSyncClass.rwlock_read_unlock(stripe->lock);
+    } while (cursor != 0 && emitted < count && --budget > 0);
+
+    *next_cursor = cursor;
+    return INFRAX_OK;
+}
+
 static infrax_error_t peerx_memkv_expire(PeerxMemKV* self, const char* key,
                                         int64_t ttl_ms) {
     if (!self || !key) {
@@ -384,24 +658,24 @@ static infrax_error_t peerx_memkv_expire(PeerxMemKV* self, const char* key,
     }
 
     // Calculate hash
-    uint32_t hash = InfraxHashClass.hash(private->hash, key, strlen(key));
-    uint32_t bucket = hash % MAX_BUCKETS;
-
-    // Find key
-    peerx_memkv_entry_t* entry = private->buckets[bucket];
-    while (entry) {
-        if (strcmp(entry->pair.key, key) == 0) {
-            if (is_expired(entry)) {
-                cleanup_expired(self);
-                return INFRAX_ERROR_NOT_FOUND;
-            }
-            entry->pair.expire_at = ttl_ms ? (time(NULL) * 1000 + ttl_ms) : 0;
-            return INFRAX_OK;
+    size_t key_len = strlen(key);
+    uint32_t hash = InfraxHashClass.hash(private->hash, key, key_len);
+    peerx_memkv_stripe_t* stripe = stripe_for(private, hash);
+
+    infrax_error_t err = INFRAX_ERROR_NOT_FOUND;
+    InfraxSyncClass.rwlock_write_lock(stripe->lock);
+    peerx_memkv_entry_t** pp = find_entry(private, key, key_len, hash);
+    if (pp) {
+        if (is_expired(*pp)) {
+            remove_entry(private, pp);
+        } else {
+            (*pp)->expire_at = ttl_ms ? (time(NULL) * 1000 + ttl_ms) : 0;
+            err = INFRAX_OK;
         }
-        entry = entry->next;
     }
+    InfraxSyncClass.rwlock_write_unlock(stripe->lock);
 
-    return INFRAX_ERROR_NOT_FOUND;
+    return err;
 }
 
 static infrax_error_t peerx_memkv_ttl(PeerxMemKV* self, const char* key,
@@ -416,32 +690,305 @@ static infrax_error_t peerx_memkv_ttl(PeerxMemKV* self, const char* key,
     }
 
     // Calculate hash
-    uint32_t hash = InfraxHashClass.hash(private->hash, key, strlen(key));
-    uint32_t bucket = hash % MAX_BUCKETS;
-
-    // Find key
-    peerx_memkv_entry_t* entry = private->buckets[bucket];
-    while (entry) {
-        if (strcmp(entry->pair.key, key) == 0) {
-            if (is_expired(entry)) {
-                cleanup_expired(self);
-                return INFRAX_ERROR_NOT_FOUND;
+    size_t key_len = strlen(key);
+    uint32_t hash = InfraxHashClass.hash(private->hash, key, key_len);
+    peerx_memkv_stripe_t* stripe = stripe_for(private, hash);
+
+    infrax_error_t err = INFRAX_ERROR_NOT_FOUND;
+    InfraxSyncClass.rwlock_read_lock(stripe->lock);
+    peerx_memkv_entry_t** pp = find_entry(private, key, key_len, hash);
+    if (pp && !is_expired(*pp)) {
+        int64_t expire_at = (*pp)->expire_at;
+        if (expire_at == 0) {
+            *ttl_ms = -1;  // No expiration
+        } else {
+            int64_t now = time(NULL) * 1000;
+            *ttl_ms = expire_at - now;
+            if (*ttl_ms < 0) {
+                *ttl_ms = 0;
             }
-            if (entry->pair.expire_at == 0) {
-                *ttl_ms = -1;  // No expiration
-            } else {
-                int64_t now = time(NULL) * 1000;
-                *ttl_ms = entry->pair.expire_at - now;
-                if (*ttl_ms < 0) {
-                    *ttl_ms = 0;
+        }
+        err = INFRAX_OK;
+    }
+    InfraxSyncClass.rwlock_read_unlock(stripe->lock);
+
+    return err;
+}
+
+// Persistence
+static infrax_error_t peerx_memkv_snapshot(PeerxMemKV* self, const char* path) {
+    if (!self || !path) {
+        return INFRAX_ERROR_INVALID_PARAM;
+    }
+
+    PeerxMemKVPrivate* private = self->base.private_data;
+    if (!private) {
+        return INFRAX_ERROR_INVALID_STATE;
+    }
+
+    // The thread is reaped by snapshot_wait
+    if (private->snapshot_thread) {
+        return INFRAX_ERROR_INVALID_STATE;
+    }
+
+    private->snapshot_path = malloc(strlen(path) + 1);
+    if (!private->snapshot_path) {
+        return INFRAX_ERROR_NO_MEMORY;
+    }
+    strcpy(private->snapshot_path, path);
+    private->snapshot_result = INFRAX_OK;
+
+    InfraxThreadConfig config = {
+        .name = "memkv-snapshot",
+        .func = snapshot_thread,
+        .arg = private
+    };
+    private->snapshot_thread = InfraxThreadClass.new(&config);
+    InfraxError err = private->snapshot_thread ?
+        InfraxThreadClass.start(private->snapshot_thread, snapshot_thread, private) :
+        make_error(INFRAX_ERROR_NO_MEMORY, "Failed to create snapshot thread");
+    if (err.code != INFRAX_ERROR_OK) {
+        if (private->snapshot_thread) {
+            InfraxThreadClass.free(private->snapshot_thread);
+            private->snapshot_thread = NULL;
+        }
+        free(private->snapshot_path);
+        private->snapshot_path = NULL;
+        return INFRAX_ERROR_NO_MEMORY;
+    }
+
+    return INFRAX_OK;
+}
+
+static infrax_error_t peerx_memkv_snapshot_wait(PeerxMemKV* self) {
+    if (!self) {
+        return INFRAX_ERROR_INVALID_PARAM;
+    }
+
+    PeerxMemKVPrivate* private = self->base.private_data;
+    if (!private) {
+        return INFRAX_ERROR_INVALID_STATE;
+    }
+
+    return snapshot_wait(private);
+}
+
+// Shared state of the loader threads
+typedef struct {
+    PeerxMemKVPrivate* private;
+    const char* base;
+    size_t file_size;
+    const peerx_memkv_snap_section_t* sections;
+    uint32_t nsections;
+    InfraxSync* next_section;  // Atomic
+    InfraxSync* loaded;        // Atomic
+    InfraxSync* failed;        // Atomic, set on a malformed record or out of memory
+    int64_t now;
+} peerx_memkv_load_ctx_t;
+
+// Build entries for whole sections and push them onto their buckets.
+// The caller holds every stripe lock, so only loader threads touch the
+// table and a compare-and-swap on the bucket head is enough
+static void* load_sections(void* arg) {
+    peerx_memkv_load_ctx_t* ctx = arg;
+    PeerxMemKVPrivate* private = ctx->private;
+    peerx_memkv_table_t* table = &private->ht[0];
+    const char* end = ctx->base + ctx->file_size;
+
+    for (;;) {
+        int64_t i = InfraxSyncClass.atomic_fetch_add(ctx->next_section, 1);
+        if (i >= ctx->nsections || InfraxSyncClass.atomic_load(ctx->failed)) {
+            break;
+        }
+
+        const peerx_memkv_snap_section_t* section = &ctx->sections[i];
+        if (section->offset > ctx->file_size) {
+            InfraxSyncClass.atomic_store(ctx->failed, 1);
+            break;
+        }
+        const char* p = ctx->base + section->offset;
+        int64_t loaded = 0;
+        for (uint64_t n = 0; n < section->count; n++) {
+            peerx_memkv_snap_record_t rec;
+            if ((size_t)(end - p) < sizeof(rec)) {
+                InfraxSyncClass.atomic_store(ctx->failed, 1);
+                break;
+            }
+            memcpy(&rec, p, sizeof(rec));
+            size_t data_len = (size_t)rec.key_len + 1 + rec.value_len;
+            const char* data = p + sizeof(rec);
+            if ((size_t)(end - data) < SNAPSHOT_ALIGN(data_len) || data[rec.key_len] != '\0' ||
+                rec.type > PEERX_MEMKV_TYPE_BINARY) {
+                InfraxSyncClass.atomic_store(ctx->failed, 1);
+                break;
+            }
+            p = data + SNAPSHOT_ALIGN(data_len);
+
+            if (rec.expire_at != 0 && ctx->now >= rec.expire_at) {
+                continue;
+            }
+
+            peerx_memkv_entry_t* entry = malloc(sizeof(peerx_memkv_entry_t) + data_len);
+            if (!entry) {
+                InfraxSyncClass.atomic_store(ctx->failed, 1);
+                break;
+            }
+            entry->expire_at = rec.expire_at;
+            entry->num.i = rec.num;
+            entry->hash = InfraxHashClass.hash(private->hash, data, rec.key_len);
+            entry->refcount = 1;
+            entry->value_len = rec.value_len;
+            entry->key_len = rec.key_len;
+            entry->type = rec.type;
+            entry->reserved = 0;
+            memcpy(entry->data, data, data_len);
+
+            peerx_memkv_entry_t** bucket = &table->buckets[entry->hash & table->mask];
+            entry->next = __atomic_load_n(bucket, __ATOMIC_RELAXED);
+            while (!__atomic_compare_exchange_n(bucket, &entry->next, entry, true,
+                                                __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+            }
+            loaded++;
+        }
+        InfraxSyncClass.atomic_fetch_add(ctx->loaded, loaded);
+    }
+
+    return NULL;
+}
+
+static infrax_error_t peerx_memkv_load(PeerxMemKV* self, const char* path) {
+    if (!self || !path) {
+        return INFRAX_ERROR_INVALID_PARAM;
+    }
+
+    PeerxMemKVPrivate* private = self->base.private_data;
+    if (!private) {
+        return INFRAX_ERROR_INVALID_STATE;
+    }
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return INFRAX_ERROR_FILE_NOT_FOUND;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(peerx_memkv_snap_header_t)) {
+        close(fd);
+        return INFRAX_ERROR_FILE_READ;
+    }
+    size_t file_size = (size_t)st.st_size;
+    const char* base = mmap(NULL, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        return INFRAX_ERROR_FILE_ACCESS;
+    }
+    madvise((void*)base, file_size, MADV_SEQUENTIAL | MADV_WILLNEED);
+
+    peerx_memkv_snap_header_t header;
+    memcpy(&header, base, sizeof(header));
+    size_t table_bytes = (size_t)header.sections * sizeof(peerx_memkv_snap_section_t);
+    if (memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != SNAPSHOT_VERSION || header.sections == 0 ||
+        header.sections > file_size / sizeof(peerx_memkv_snap_section_t) ||
+        sizeof(header) + table_bytes > file_size ||
+        header.count > (file_size - sizeof(header) - table_bytes) / SNAPSHOT_MIN_RECORD) {
+        munmap((void*)base, file_size);
+        return INFRAX_ERROR_FILE_READ;
+    }
+
+    // The section counts must add up to the header's, so no loader walks past it
+    const peerx_memkv_snap_section_t* sections =
+        (const peerx_memkv_snap_section_t*)(base + sizeof(header));
+    uint64_t total = 0;
+    for (uint32_t i = 0; i < header.sections; i++) {
+        if (sections[i].count > header.count - total) {
+            munmap((void*)base, file_size);
+            return INFRAX_ERROR_FILE_READ;
+        }
+        total += sections[i].count;
+    }
+    if (total != header.count) {
+        munmap((void*)base, file_size);
+        return INFRAX_ERROR_FILE_READ;
+    }
+
+    // Size the table for the whole snapshot up front, so loading never rehashes
+    size_t buckets = INITIAL_BUCKETS;
+    while (buckets < SNAPSHOT_MAX_BUCKETS &&
+           (double)buckets * LOAD_FACTOR_THRESHOLD < (double)header.count) {
+        buckets <<= 1;
+    }
+
+    infrax_error_t err = INFRAX_OK;
+    lock_all(private);
+    if (InfraxSyncClass.atomic_load(private->size) != 0 || private->rehashing) {
+        err = INFRAX_ERROR_INVALID_STATE;
+    } else if (buckets != private->ht[0].size) {
+        peerx_memkv_table_t table;
+        if (table_init(&table, buckets)) {
+            free(private->ht[0].buckets);
+            private->ht[0] = table;
+        } else {
+            err = INFRAX_ERROR_NO_MEMORY;
+        }
+    }
+
+    if (err == INFRAX_OK) {
+        peerx_memkv_load_ctx_t ctx = {
+            .private = private,
+            .base = base,
+            .file_size = file_size,
+            .sections = sections,
+            .nsections = header.sections,
+            .next_section = InfraxSyncClass.new(INFRAX_SYNC_TYPE_ATOMIC),
+            .loaded = InfraxSyncClass.new(INFRAX_SYNC_TYPE_ATOMIC),
+            .failed = InfraxSyncClass.new(INFRAX_SYNC_TYPE_ATOMIC),
+            .now = time(NULL) * 1000
+        };
+
+        if (ctx.next_section && ctx.loaded && ctx.failed) {
+            // This thread loads too; helpers that fail to start are simply skipped
+            InfraxThread* threads[SNAPSHOT_LOAD_THREADS - 1] = {0};
+            int nthreads = header.sections < SNAPSHOT_LOAD_THREADS ?
+                           (int)header.sections : SNAPSHOT_LOAD_THREADS;
+            for (int i = 0; i < nthreads - 1; i++) {
+                InfraxThreadConfig config = {
+                    .name = "memkv-load",
+                    .func = load_sections,
+                    .arg = &ctx
+                };
+                threads[i] = InfraxThreadClass.new(&config);
+                if (threads[i] &&
+                    InfraxThreadClass.start(threads[i], load_sections, &ctx).code != INFRAX_ERROR_OK) {
+                    InfraxThreadClass.free(threads[i]);
+                    threads[i] = NULL;
+                }
+            }
+            load_sections(&ctx);
+            for (int i = 0; i < nthreads - 1; i++) {
+                if (threads[i]) {
+                    InfraxThreadClass.join(threads[i], NULL);
+                    InfraxThreadClass.free(threads[i]);
                 }
             }
-            return INFRAX_OK;
+
+            if (InfraxSyncClass.atomic_load(ctx.failed)) {
+                table_clear(private, &private->ht[0]);
+                err = INFRAX_ERROR_FILE_READ;
+            } else {
+                InfraxSyncClass.atomic_store(private->size, InfraxSyncClass.atomic_load(ctx.loaded));
+            }
+        } else {
+            err = INFRAX_ERROR_NO_MEMORY;
         }
-        entry = entry->next;
+
+        if (ctx.next_section) InfraxSyncClass.free(ctx.next_section);
+        if (ctx.loaded) InfraxSyncClass.free(ctx.loaded);
+        if (ctx.failed) InfraxSyncClass.free(ctx.failed);
     }
+    unlock_all(private);
 
-    return INFRAX_ERROR_NOT_FOUND;
+    munmap((void*)base, file_size);
+    return err;
 }
 
 // Server operations
@@ -455,18 +1002,18 @@ static infrax_error_t peerx_memkv_flush(PeerxMemKV* self) {
         return INFRAX_ERROR_INVALID_STATE;
     }
 
-    // Free all entries
-    for (int i = 0; i < MAX_BUCKETS; i++) {
-        peerx_memkv_entry_t* entry = private->buckets[i];
-        while (entry) {
-            peerx_memkv_entry_t* next = entry->next;
-            cleanup_entry(private, entry);
-            entry = next;
-        }
-        private->buckets[i] = NULL;
+    // Free all entries, abandoning any rehash in progress
+    lock_all(private);
+    table_clear(private, &private->ht[0]);
+    if (private->rehashing) {
+        table_clear(private, &private->ht[1]);
+        free(private->ht[1].buckets);
+        memset(&private->ht[1], 0, sizeof(peerx_memkv_table_t));
+        private->rehashing = false;
     }
+    InfraxSyncClass.atomic_store(private->size, 0);
+    unlock_all(private);
 
-    private->size = 0;
     return INFRAX_OK;
 }
 
@@ -480,23 +1027,38 @@ static infrax_error_t peerx_memkv_info(PeerxMemKV* self, char* info, size_t size
         return INFRAX_ERROR_INVALID_STATE;
     }
 
-    // Count non-empty buckets
+    // Count non-empty buckets, one stripe at a time
     size_t used_buckets = 0;
-    for (int i = 0; i < MAX_BUCKETS; i++) {
-        if (private->buckets[i]) {
-            used_buckets++;
+    size_t buckets = 0;
+    bool rehashing = false;
+    for (size_t s = 0; s < LOCK_STRIPES; s++) {
+        peerx_memkv_stripe_t* stripe = &private->stripes[s];
+        InfraxSyncClass.rwlock_read_lock(stripe->lock);
+        rehashing = private->rehashing;
+        buckets = private->ht[0].size + (rehashing ? private->ht[1].size : 0);
+        for (int t = 0; t < (rehashing ? 2 : 1); t++) {
+            peerx_memkv_table_t* table = &private->ht[t];
+            for (size_t b = s; b < table->size; b += LOCK_STRIPES) {
+                if (table->buckets[b]) {
+                    used_buckets++;
+                }
+            }
         }
+        InfraxSyncClass.rwlock_read_unlock(stripe->lock);
     }
 
+    size_t keys = (size_t)InfraxSyncClass.atomic_load(private->size);
     snprintf(info, size,
              "Keys: %zu\n"
-             "Buckets: %d\n"
+             "Buckets: %zu\n"
              "Used buckets: %zu\n"
-             "Load factor: %.2f",
-             private->size,
-             MAX_BUCKETS,
+             "Load factor: %.2f\n"
+             "Rehashing: %s",
+             keys,
+             buckets,
              used_buckets,
-             (float)private->size / MAX_BUCKETS);
+             buckets ? (float)keys / buckets : 0.0f,
+             rehashing ? "yes" : "no");
 
     return INFRAX_OK;
 }
@@ -585,12 +1147,12 @@ void peerx_memkv_value_free(peerx_memkv_value_t* value) {
     switch (value->type) {
         case PEERX_MEMKV_TYPE_STRING:
             if (value->value.str) {
-                g_memory->dealloc(g_memory, value->value.str);
+                free(value->value.str);
             }
             break;
         case PEERX_MEMKV_TYPE_BINARY:
             if (value->value.bin.data) {
-                g_memory->dealloc(g_memory, value->value.bin.data);
+                free(value->value.bin.data);
             }
             break;
         default:
@@ -612,7 +1174,7 @@ infrax_error_t peerx_memkv_value_copy(peerx_memkv_value_t* dst,
     switch (src->type) {
         case PEERX_MEMKV_TYPE_STRING:
             if (src->value.str) {
-                dst->value.str = g_memory->alloc(g_memory, strlen(src->value.str) + 1);
+                dst->value.str = malloc(strlen(src->value.str) + 1);
                 if (!dst->value.str) {
                     return INFRAX_ERROR_NO_MEMORY;
                 }
@@ -630,7 +1192,7 @@ infrax_error_t peerx_memkv_value_copy(peerx_memkv_value_t* dst,
 
         case PEERX_MEMKV_TYPE_BINARY:
             if (src->value.bin.data && src->value.bin.size > 0) {
-                dst->value.bin.data = g_memory->alloc(g_memory, src->value.bin.size);
+                dst->value.bin.data = malloc(src->value.bin.size);
                 if (!dst->value.bin.data) {
                     return INFRAX_ERROR_NO_MEMORY;
                 }
@@ -644,54 +1206,599 @@ infrax_error_t peerx_memkv_value_copy(peerx_memkv_value_t* dst,
 }
 
 // Private helper functions
-static bool init_memory(void) {
-    if (g_memory) return true;
-    
-    InfraxMemoryConfig config = {
-        .initial_size = 1024 * 1024,  // 1MB
-        .use_gc = false,
-        .use_pool = true,
-        .gc_threshold = 0
-    };
-    
-    g_memory = InfraxMemoryClass.new(&config);
-    return g_memory != NULL;
+// Allocate an entry holding one reference, NULL if out of memory
+static peerx_memkv_entry_t* entry_new(const char* key, size_t key_len, uint32_t hash,
+                                      const peerx_memkv_value_t* value, int64_t expire_at) {
+    size_t value_len = 0;
+    const void* bytes = NULL;
+    switch (value->type) {
+        case PEERX_MEMKV_TYPE_STRING:
+            if (value->value.str) {
+                bytes = value->value.str;
+                value_len = strlen(value->value.str) + 1;
+            }
+            break;
+        case PEERX_MEMKV_TYPE_BINARY:
+            if (value->value.bin.data && value->value.bin.size > 0) {
+                bytes = value->value.bin.data;
+                value_len = value->value.bin.size;
+            }
+            break;
+        default:
+            break;
+    }
+    if (value_len > UINT32_MAX) {
+        return NULL;
+    }
+
+    peerx_memkv_entry_t* entry = malloc(sizeof(peerx_memkv_entry_t) + key_len + 1 + value_len);
+    if (!entry) {
+        return NULL;
+    }
+
+    entry->next = NULL;
+    entry->expire_at = expire_at;
+    entry->num.i = 0;
+    if (value->type == PEERX_MEMKV_TYPE_INT) {
+        entry->num.i = value->value.i;
+    } else if (value->type == PEERX_MEMKV_TYPE_FLOAT) {
+        entry->num.f = value->value.f;
+    }
+    entry->hash = hash;
+    entry->refcount = 1;
+    entry->value_len = (uint32_t)value_len;
+    entry->key_len = (uint16_t)key_len;
+    entry->type = (uint8_t)value->type;
+    entry->reserved = 0;
+    memcpy(ENTRY_KEY(entry), key, key_len);
+    ENTRY_KEY(entry)[key_len] = '\0';
+    if (value_len) {
+        memcpy(ENTRY_VALUE(entry), bytes, value_len);
+    }
+    return entry;
 }
 
-static void cleanup_entry(PeerxMemKVPrivate* private, peerx_memkv_entry_t* entry) {
-    if (!private || !entry) return;
-    peerx_memkv_value_free(&entry->pair.value);
-    private->memory->dealloc(private->memory, entry);
+// Drop one reference, the last one frees the entry
+static void entry_release(peerx_memkv_entry_t* entry) {
+    if (__atomic_sub_fetch(&entry->refcount, 1, __ATOMIC_ACQ_REL) == 0) {
+        free(entry);
+    }
+}
+
+// Deep copy of the entry's value for the copying API
+static infrax_error_t entry_to_value(const peerx_memkv_entry_t* entry, peerx_memkv_value_t* value) {
+    peerx_memkv_value_free(value);
+    value->type = (peerx_memkv_type_t)entry->type;
+
+    switch (value->type) {
+        case PEERX_MEMKV_TYPE_INT:
+            value->value.i = entry->num.i;
+            break;
+        case PEERX_MEMKV_TYPE_FLOAT:
+            value->value.f = entry->num.f;
+            break;
+        case PEERX_MEMKV_TYPE_STRING:
+        case PEERX_MEMKV_TYPE_BINARY:
+            if (entry->value_len) {
+                void* data = malloc(entry->value_len);
+                if (!data) {
+                    return INFRAX_ERROR_NO_MEMORY;
+                }
+                memcpy(data, ENTRY_VALUE(entry), entry->value_len);
+                if (value->type == PEERX_MEMKV_TYPE_STRING) {
+                    value->value.str = data;
+                } else {
+                    value->value.bin.data = data;
+                    value->value.bin.size = entry->value_len;
+                }
+            }
+            break;
+    }
+
+    return INFRAX_OK;
 }
 
 static bool is_expired(const peerx_memkv_entry_t* entry) {
-    if (!entry || entry->pair.expire_at == 0) {
+    if (!entry || entry->expire_at == 0) {
         return false;
     }
-    return (time(NULL) * 1000) >= entry->pair.expire_at;
+    return (time(NULL) * 1000) >= entry->expire_at;
 }
 
-static void cleanup_expired(PeerxMemKV* self) {
-    if (!self) return;
+static bool table_init(peerx_memkv_table_t* table, size_t size) {
+    table->buckets = malloc(size * sizeof(peerx_memkv_entry_t*));
+    if (!table->buckets) {
+        return false;
+    }
+    memset(table->buckets, 0, size * sizeof(peerx_memkv_entry_t*));
+    table->size = size;
+    table->mask = size - 1;
+    return true;
+}
 
-    PeerxMemKVPrivate* private = self->base.private_data;
-    if (!private) return;
+// Free every entry in the table, keeping the bucket array
+static void table_clear(PeerxMemKVPrivate* private, peerx_memkv_table_t* table) {
+    for (size_t i = 0; i < table->size; i++) {
+        peerx_memkv_entry_t* entry = table->buckets[i];
+        while (entry) {
+            peerx_memkv_entry_t* next = entry->next;
+            entry_release(entry);
+            entry = next;
+        }
+        table->buckets[i] = NULL;
+    }
+}
 
-    for (int i = 0; i < MAX_BUCKETS; i++) {
-        peerx_memkv_entry_t** pp = &private->buckets[i];
-        peerx_memkv_entry_t* entry = *pp;
+static void private_free(PeerxMemKVPrivate* private) {
+    snapshot_wait(private);
+    for (int t = 0; t < 2; t++) {
+        if (private->ht[t].buckets) {
+            table_clear(private, &private->ht[t]);
+            free(private->ht[t].buckets);
+        }
+    }
+    for (int i = 0; i < LOCK_STRIPES; i++) {
+        if (private->stripes[i].lock) {
+            InfraxSyncClass.free(private->stripes[i].lock);
+        }
+    }
+    if (private->size) InfraxSyncClass.free(private->size);
+    if (private->stripes_done) InfraxSyncClass.free(private->stripes_done);
+    if (private->help_cursor) InfraxSyncClass.free(private->help_cursor);
+    if (private->hash) {
+        InfraxHashClass.free(private->hash);
+    }
+    free(private);
+}
+
+static peerx_memkv_stripe_t* stripe_for(PeerxMemKVPrivate* private, uint32_t hash) {
+    return &private->stripes[hash & (LOCK_STRIPES - 1)];
+}
+
+// Write-lock every stripe, always in index order
+static void lock_all(PeerxMemKVPrivate* private) {
+    for (int i = 0; i < LOCK_STRIPES; i++) {
+        InfraxSyncClass.rwlock_write_lock(private->stripes[i].lock);
+    }
+}
+
+static void unlock_all(PeerxMemKVPrivate* private) {
+    for (int i = LOCK_STRIPES - 1; i >= 0; i--) {
+        InfraxSyncClass.rwlock_write_unlock(private->stripes[i].lock);
+    }
+}
+
+// Look the key up in both tables, caller holds its stripe lock.
+// Returns the link pointing at the entry, or NULL
+static peerx_memkv_entry_t** find_entry(PeerxMemKVPrivate* private, const char* key,
+                                        size_t key_len, uint32_t hash) {
+    for (int t = 0; t < (private->rehashing ? 2 : 1); t++) {
+        peerx_memkv_table_t* table = &private->ht[t];
+        peerx_memkv_entry_t** pp = &table->buckets[hash & table->mask];
+        while (*pp) {
+            peerx_memkv_entry_t* entry = *pp;
+            if (entry->hash == hash && entry->key_len == key_len &&
+                memcmp(ENTRY_KEY(entry), key, key_len) == 0) {
+                return pp;
+            }
+            pp = &(*pp)->next;
+        }
+    }
+    return NULL;
+}
+
+// Unlink and free the entry *pp points to
+static void remove_entry(PeerxMemKVPrivate* private, peerx_memkv_entry_t** pp) {
+    peerx_memkv_entry_t* entry = *pp;
+    *pp = entry->next;
+    entry_release(entry);
+    InfraxSyncClass.atomic_fetch_sub(private->size, 1);
+}
+
+// Migrate up to REHASH_STEP_BUCKETS old buckets of one stripe, caller holds
+// that stripe's write lock. Returns true when this call completed the last
+// stripe, the caller then swaps the tables after unlocking
+static bool rehash_step(PeerxMemKVPrivate* private, size_t s) {
+    peerx_memkv_stripe_t* stripe = &private->stripes[s];
+    if (!private->rehashing || stripe->rehash_done) {
+        return false;
+    }
+
+    peerx_memkv_table_t* from = &private->ht[0];
+    peerx_memkv_table_t* to = &private->ht[1];
+    size_t per_stripe = from->size / LOCK_STRIPES;
+    for (int i = 0; i < REHASH_STEP_BUCKETS && stripe->rehash_pos < per_stripe; i++) {
+        size_t b = s + stripe->rehash_pos * LOCK_STRIPES;
+        peerx_memkv_entry_t* entry = from->buckets[b];
         while (entry) {
-            if (is_expired(entry)) {
-                *pp = entry->next;
-                cleanup_entry(private, entry);
-                private->size--;
-                entry = *pp;
+            peerx_memkv_entry_t* next = entry->next;
+            peerx_memkv_entry_t** bucket = &to->buckets[entry->hash & to->mask];
+            entry->next = *bucket;
+            *bucket = entry;
+            entry = next;
+        }
+        from->buckets[b] = NULL;
+        stripe->rehash_pos++;
+    }
+
+    if (stripe->rehash_pos < per_stripe) {
+        return false;
+    }
+    stripe->rehash_done = true;
+    return InfraxSyncClass.atomic_fetch_add(private->stripes_done, 1) + 1 == LOCK_STRIPES;
+}
+
+// Allocate the new table, called without any stripe lock held
+static void rehash_start(PeerxMemKVPrivate* private) {
+    lock_all(private);
+    // Another writer may have started it while we waited for the locks
+    if (!private->rehashing &&
+        (double)InfraxSyncClass.atomic_load(private->size) >
+        (double)private->ht[0].size * LOAD_FACTOR_THRESHOLD &&
+        table_init(&private->ht[1], private->ht[0].size * 2)) {
+        for (int i = 0; i < LOCK_STRIPES; i++) {
+            private->stripes[i].rehash_pos = 0;
+            private->stripes[i].rehash_done = false;
+        }
+        InfraxSyncClass.atomic_store(private->stripes_done, 0);
+        private->rehashing = true;
+    }
+    unlock_all(private);
+}
+
+// Swap in the new table once every stripe has migrated
+static void rehash_finish(PeerxMemKVPrivate* private) {
+    lock_all(private);
+    if (private->rehashing &&
+        InfraxSyncClass.atomic_load(private->stripes_done) == LOCK_STRIPES) {
+        free(private->ht[0].buckets);
+        private->ht[0] = private->ht[1];
+        memset(&private->ht[1], 0, sizeof(peerx_memkv_table_t));
+        private->rehashing = false;
+    }
+    unlock_all(private);
+}
+
+// Push the rehash forward on a stripe that may see no writes of its own.
+// Only try-locks, so a busy stripe is simply skipped
+static void rehash_help(PeerxMemKVPrivate* private) {
+    size_t s = (size_t)InfraxSyncClass.atomic_fetch_add(private->help_cursor, 1) & (LOCK_STRIPES - 1);
+    peerx_memkv_stripe_t* stripe = &private->stripes[s];
+    InfraxError lock_err = InfraxSyncClass.rwlock_try_write_lock(stripe->lock);
+    if (lock_err.code != INFRAX_ERROR_SYNC_OK) {
+        return;
+    }
+    bool finished = rehash_step(private, s);
+    InfraxSyncClass.rwlock_write_unlock(stripe->lock);
+
+    if (finished) {
+        rehash_finish(private);
+    }
+}
+
+// Incremental expiry: sweep a few of this stripe's buckets from where the last
+// cycle stopped, caller holds the stripe's write lock. The cost per call is
+// bounded and the whole stripe is covered every few hundred writes to it
+static void expire_cycle(PeerxMemKVPrivate* private, size_t s) {
+    peerx_memkv_stripe_t* stripe = &private->stripes[s];
+    peerx_memkv_table_t* table = &private->ht[private->rehashing ? 1 : 0];
+    size_t per_stripe = table->size / LOCK_STRIPES;
+
+    int64_t now = time(NULL) * 1000;
+    for (int i = 0; i < EXPIRE_CYCLE_BUCKETS; i++) {
+        stripe->expire_pos %= per_stripe;
+        peerx_memkv_entry_t** pp = &table->buckets[s + stripe->expire_pos * LOCK_STRIPES];
+        while (*pp) {
+            if ((*pp)->expire_at != 0 && now >= (*pp)->expire_at) {
+                remove_entry(private, pp);
+            } else {
+                pp = &(*pp)->next;
+            }
+        }
+        stripe->expire_pos++;
+    }
+}
+
+static void glob_compile(peerx_memkv_glob_t* glob, const char* pattern) {
+    memset(glob, 0, sizeof(peerx_memkv_glob_t));
+    if (!pattern || strcmp(pattern, "*") == 0) {
+        return;
+    }
+
+    glob->pattern = pattern;
+    glob->len = strlen(pattern);
+    glob->prefix_len = strcspn(pattern, "*?[\\");
+    glob->literal = glob->prefix_len == glob->len;
+    glob->prefix_star = glob->prefix_len + 1 == glob->len && pattern[glob->prefix_len] == '*';
+}
+
+// Match c against the class after '[', advancing *pp past the closing ']'
+static bool glob_class(const char** pp, const char* end, char c) {
+    const char* p = *pp;
+    bool negate = false;
+    bool match = false;
+
+    if (p < end && *p == '^') {
+        negate = true;
+        p++;
+    }
+    while (p < end && *p != ']') {
+        if (*p == '\\' && p + 1 < end) {
+            match |= p[1] == c;
+            p += 2;
+        } else if (p + 2 < end && p[1] == '-' && p[2] != ']') {
+            char lo = p[0] < p[2] ? p[0] : p[2];
+            char hi = p[0] < p[2] ? p[2] : p[0];
+            match |= c >= lo && c <= hi;
+            p += 3;
+        } else {
+            match |= *p == c;
+            p++;
+        }
+    }
+    if (p < end) {
+        p++;
+    }
+
+    *pp = p;
+    return negate ? !match : match;
+}
+
+// Iterative glob matcher, backtracks only to the last '*'
+static bool glob_match(const char* p, const char* pend, const char* s, const char* send) {
+    const char* star_p = NULL;
+    const char* star_s = NULL;
+
+    while (s < send) {
+        if (p < pend && *p == '*') {
+            while (p < pend && *p == '*') p++;
+            if (p == pend) return true;
+            star_p = p;
+            star_s = s;
+            continue;
+        }
+        if (p < pend) {
+            const char* next = p + 1;
+            bool ok;
+            if (*p == '?') {
+                ok = true;
+            } else if (*p == '[') {
+                ok = glob_class(&next, pend, *s);
+            } else if (*p == '\\' && p + 1 < pend) {
+                ok = p[1] == *s;
+                next = p + 2;
             } else {
-                pp = &entry->next;
-                entry = entry->next;
+                ok = *p == *s;
+            }
+            if (ok) {
+                p = next;
+                s++;
+                continue;
             }
         }
+        if (!star_p) return false;
+        p = star_p;
+        s = ++star_s;
     }
+
+    while (p < pend && *p == '*') p++;
+    return p == pend;
+}
+
+static bool glob_match_key(const peerx_memkv_glob_t* glob, const char* key, size_t key_len) {
+    if (!glob->pattern) {
+        return true;
+    }
+    if (glob->literal) {
+        return key_len == glob->len && memcmp(key, glob->pattern, key_len) == 0;
+    }
+    if (key_len < glob->prefix_len || memcmp(key, glob->pattern, glob->prefix_len) != 0) {
+        return false;
+    }
+    if (glob->prefix_star) {
+        return true;
+    }
+    return glob_match(glob->pattern + glob->prefix_len, glob->pattern + glob->len,
+                      key + glob->prefix_len, key + key_len);
+}
+
+static uint64_t rev_bits(uint64_t v) {
+    v = ((v >> 1) & 0x5555555555555555ULL) | ((v & 0x5555555555555555ULL) << 1);
+    v = ((v >> 2) & 0x3333333333333333ULL) | ((v & 0x3333333333333333ULL) << 2);
+    v = ((v >> 4) & 0x0f0f0f0f0f0f0f0fULL) | ((v & 0x0f0f0f0f0f0f0f0fULL) << 4);
+    v = ((v >> 8) & 0x00ff00ff00ff00ffULL) | ((v & 0x00ff00ff00ff00ffULL) << 8);
+    v = ((v >> 16) & 0x0000ffff0000ffffULL) | ((v & 0x0000ffff0000ffffULL) << 16);
+    return (v >> 32) | (v << 32);
+}
+
+// Advance the cursor by one bucket of a table with the given mask.
+// The cursor counts with its bits reversed, so buckets visited before a
+// resize map onto buckets that are also behind the cursor afterwards
+static uint64_t cursor_next(uint64_t v, size_t mask) {
+    v |= ~(uint64_t)mask;
+    v = rev_bits(v);
+    v++;
+    return rev_bits(v);
+}
+
+static size_t scan_bucket(const peerx_memkv_entry_t* entry, const peerx_memkv_glob_t* glob,
+                          peerx_memkv_scan_fn fn, void* ctx) {
+    size_t emitted = 0;
+    for (; entry; entry = entry->next) {
+        if (!is_expired(entry) && glob_match_key(glob, ENTRY_KEY(entry), entry->key_len)) {
+            fn(ctx, ENTRY_KEY(entry), entry->key_len);
+            emitted++;
+        }
+    }
+    return emitted;
+}
+
+// One scan step (Redis dictScan), caller holds the stripe of the cursor's low bits.
+// While rehashing, the small table's bucket is visited together with every
+// bucket of the large table it expands into
+static uint64_t scan_step(PeerxMemKVPrivate* private, uint64_t v, const peerx_memkv_glob_t* glob,
+                          peerx_memkv_scan_fn fn, void* ctx, size_t* emitted) {
+    peerx_memkv_table_t* t0 = &private->ht[0];
+    *emitted += scan_bucket(t0->buckets[v & t0->mask], glob, fn, ctx);
+    if (!private->rehashing) {
+        return cursor_next(v, t0->mask);
+    }
+
+    peerx_memkv_table_t* t1 = &private->ht[1];
+    do {
+        *emitted += scan_bucket(t1->buckets[v & t1->mask], glob, fn, ctx);
+        v = cursor_next(v, t1->mask);
+    } while (v & (t0->mask ^ t1->mask));
+    return v;
+}
+
+// Pinned entry and the expiry seen while pinning it (expire() updates it in place)
+typedef struct {
+    peerx_memkv_entry_t* entry;
+    int64_t expire_at;
+} peerx_memkv_snap_item_t;
+
+static bool snapshot_write_item(FILE* f, const peerx_memkv_snap_item_t* item) {
+    static const char zeros[8] = {0};
+    const peerx_memkv_entry_t* entry = item->entry;
+    peerx_memkv_snap_record_t rec = {
+        .expire_at = item->expire_at,
+        .num = entry->num.i,
+        .value_len = entry->value_len,
+        .key_len = entry->key_len,
+        .type = entry->type
+    };
+    size_t data_len = (size_t)entry->key_len + 1 + entry->value_len;
+    size_t pad = SNAPSHOT_ALIGN(data_len) - data_len;
+    return fwrite(&rec, sizeof(rec), 1, f) == 1 &&
+           fwrite(entry->data, 1, data_len, f) == data_len &&
+           (pad == 0 || fwrite(zeros, 1, pad, f) == pad);
+}
+
+// Write one stripe: pin its live entries under the read lock, then do the
+// I/O unlocked. Entries are immutable apart from expire_at, so a pinned
+// entry can be read without the lock
+static bool snapshot_write_stripe(PeerxMemKVPrivate* private, size_t s, FILE* f,
+                                  peerx_memkv_snap_section_t* section) {
+    peerx_memkv_snap_item_t* items = NULL;
+    size_t count = 0;
+    size_t capacity = 0;
+    bool ok = true;
+
+    peerx_memkv_stripe_t* stripe = &private->stripes[s];
+    InfraxSyncClass.rwlock_read_lock(stripe->lock);
+    for (int t = 0; t < (private->rehashing ? 2 : 1) && ok; t++) {
+        peerx_memkv_table_t* table = &private->ht[t];
+        for (size_t b = s; b < table->size && ok; b += LOCK_STRIPES) {
+            for (peerx_memkv_entry_t* entry = table->buckets[b]; entry; entry = entry->next) {
+                if (is_expired(entry)) {
+                    continue;
+                }
+                if (count == capacity) {
+                    size_t new_capacity = capacity ? capacity * 2 : 1024;
+                    void* grown = realloc(items,
+                                                    new_capacity * sizeof(peerx_memkv_snap_item_t));
+                    if (!grown) {
+                        ok = false;
+                        break;
+                    }
+                    items = grown;
+                    capacity = new_capacity;
+                }
+                __atomic_fetch_add(&entry->refcount, 1, __ATOMIC_RELAXED);
+                items[count].entry = entry;
+                items[count].expire_at = entry->expire_at;
+                count++;
+            }
+        }
+    }
+    InfraxSyncClass.rwlock_read_unlock(stripe->lock);
+
+    section->offset = (uint64_t)ftello(f);
+    section->count = count;
+    for (size_t i = 0; i < count; i++) {
+        if (ok && !snapshot_write_item(f, &items[i])) {
+            ok = false;
+        }
+        entry_release(items[i].entry);
+    }
+    if (items) {
+        free(items);
+    }
+    return ok;
+}
+
+static void* snapshot_thread(void* arg) {
+    PeerxMemKVPrivate* private = arg;
+    infrax_error_t err = INFRAX_OK;
+
+    size_t path_len = strlen(private->snapshot_path);
+    char* tmp_path = malloc(path_len + 5);
+    if (!tmp_path) {
+        private->snapshot_result = INFRAX_ERROR_NO_MEMORY;
+        return NULL;
+    }
+    memcpy(tmp_path, private->snapshot_path, path_len);
+    memcpy(tmp_path + path_len, ".tmp", 5);
+
+    FILE* f = fopen(tmp_path, "wb");
+    if (!f) {
+        free(tmp_path);
+        private->snapshot_result = INFRAX_ERROR_FILE_ACCESS;
+        return NULL;
+    }
+    setvbuf(f, NULL, _IOFBF, SNAPSHOT_BUFFER_SIZE);
+
+    peerx_memkv_snap_header_t header = {
+        .magic = SNAPSHOT_MAGIC,
+        .version = SNAPSHOT_VERSION,
+        .sections = LOCK_STRIPES,
+        .count = 0,
+        .created_at = time(NULL) * 1000
+    };
+    peerx_memkv_snap_section_t sections[LOCK_STRIPES];
+    memset(sections, 0, sizeof(sections));
+
+    // Placeholders, rewritten once the counts are known
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+              fwrite(sections, sizeof(sections), 1, f) == 1;
+    for (size_t s = 0; s < LOCK_STRIPES && ok; s++) {
+        ok = snapshot_write_stripe(private, s, f, &sections[s]);
+        header.count += sections[s].count;
+    }
+    ok = ok && fseeko(f, 0, SEEK_SET) == 0 &&
+         fwrite(&header, sizeof(header), 1, f) == 1 &&
+         fwrite(sections, sizeof(sections), 1, f) == 1 &&
+         fflush(f) == 0 && fsync(fileno(f)) == 0;
+    if (fclose(f) != 0) {
+        ok = false;
+    }
+
+    // Replace the previous snapshot only with a complete one
+    if (ok && rename(tmp_path, private->snapshot_path) != 0) {
+        ok = false;
+    }
+    if (!ok) {
+        unlink(tmp_path);
+        err = INFRAX_ERROR_FILE_ACCESS;
+    }
+
+    free(tmp_path);
+    private->snapshot_result = err;
+    return NULL;
+}
+
+static infrax_error_t snapshot_wait(PeerxMemKVPrivate* private) {
+    if (!private->snapshot_thread) {
+        return INFRAX_OK;
+    }
+
+    InfraxThreadClass.join(private->snapshot_thread, NULL);
+    InfraxThreadClass.free(private->snapshot_thread);
+    private->snapshot_thread = NULL;
+    free(private->snapshot_path);
+    private->snapshot_path = NULL;
+    return private->snapshot_result;
 }
 
 // Global class instance
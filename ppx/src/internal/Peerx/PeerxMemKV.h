@@ -36,6 +36,25 @@ typedef struct {
     int64_t expire_at;  // Unix timestamp in milliseconds, 0 for no expiration
 } peerx_memkv_pair_t;
 
+// Borrowed read-only view of a stored value, no copy is made.
+// The view stays valid, even if the key is overwritten or deleted meanwhile,
+// until it is handed back with release()
+typedef struct {
+    peerx_memkv_type_t type;
+    const char* key;     // NUL-terminated
+    size_t key_len;
+    const void* data;    // STRING: NUL-terminated text, BINARY: bytes, NULL if none
+    size_t size;         // Bytes at data, excluding the terminator
+    int64_t i;           // INT
+    double f;            // FLOAT
+    int64_t expire_at;   // Unix timestamp in milliseconds, 0 for no expiration
+    const void* entry;   // Internal
+} peerx_memkv_ref_t;
+
+// Scan callback, called once per matching key with the key's stripe read-locked:
+// it must not call back into the same PeerxMemKV instance
+typedef void (*peerx_memkv_scan_fn)(void* ctx, const char* key, size_t key_len);
+
 // MemKV service instance
 struct PeerxMemKV {
     // Base service
@@ -48,6 +67,10 @@ struct PeerxMemKV {
     infrax_error_t (*get)(PeerxMemKV* self, const char* key, peerx_memkv_value_t* value);
     infrax_error_t (*del)(PeerxMemKV* self, const char* key);
     bool (*exists)(PeerxMemKV* self, const char* key);
+
+    // Zero-copy reads: borrow pins the entry, release unpins it
+    infrax_error_t (*borrow)(PeerxMemKV* self, const char* key, peerx_memkv_ref_t* ref);
+    void (*release)(PeerxMemKV* self, peerx_memkv_ref_t* ref);
     
     // Batch operations
     infrax_error_t (*multi_set)(PeerxMemKV* self, const peerx_memkv_pair_t* pairs, size_t count);
@@ -57,9 +80,27 @@ struct PeerxMemKV {
     
     // Key operations
     infrax_error_t (*keys)(PeerxMemKV* self, const char* pattern, char** keys, size_t* count);
+
+    // Incremental iteration: start with cursor 0 and pass back *next_cursor until it is 0.
+    // Each call visits roughly count keys (count buckets at least) matching the glob
+    // pattern (* ? [a-z] [^a] \x, NULL for all). No state is kept between calls; every key
+    // present for the whole iteration is reported at least once, even across a rehash
+    infrax_error_t (*scan)(PeerxMemKV* self, uint64_t cursor, const char* pattern, size_t count,
+                           peerx_memkv_scan_fn fn, void* ctx, uint64_t* next_cursor);
     infrax_error_t (*expire)(PeerxMemKV* self, const char* key, int64_t ttl_ms);
     infrax_error_t (*ttl)(PeerxMemKV* self, const char* key, int64_t* ttl_ms);
     
+    // Persistence
+    // snapshot writes every live key with its expiry to path from a background thread
+    // (path.tmp, renamed when complete); writers only wait for one stripe's entries to
+    // be pinned, not for the I/O. Fails with INFRAX_ERROR_INVALID_STATE until snapshot_wait
+    // has collected the previous one
+    infrax_error_t (*snapshot)(PeerxMemKV* self, const char* path);
+    // Wait for the running snapshot, returns its result (INFRAX_OK if none ran)
+    infrax_error_t (*snapshot_wait)(PeerxMemKV* self);
+    // mmap a snapshot into an empty instance, keys that expired meanwhile are skipped
+    infrax_error_t (*load)(PeerxMemKV* self, const char* path);
+
     // Server operations
     infrax_error_t (*flush)(PeerxMemKV* self);
     infrax_error_t (*info)(PeerxMemKV* self, char* info, size_t size);
@@ -0,0 +1,288 @@
+#include "internal/Peerx/PeerxMemKV.h"
+#include "internal/infrax/InfraxCore.h"
+#include "internal/infrax/InfraxThread.h"
+
+static InfraxCore* core = NULL;
+
+#define TEST_THREADS 8
+#define TEST_KEYS_PER_THREAD 50000
+
+typedef struct {
+    PeerxMemKV* kv;
+    int id;
+} test_worker_t;
+
+static InfraxThread* start_worker(InfraxThreadFunc func, test_worker_t* arg) {
+    InfraxThreadConfig config = {
+        .name = "memkv_test",
+        .func = func,
+        .arg = arg
+    };
+    InfraxThread* thread = InfraxThreadClass.new(&config);
+    INFRAX_ASSERT(core, thread != NULL);
+    INFRAX_ASSERT(core, InfraxThreadClass.start(thread, func, arg).code == INFRAX_ERROR_OK);
+    return thread;
+}
+
+static void run_workers(PeerxMemKV* kv, InfraxThreadFunc func) {
+    test_worker_t args[TEST_THREADS];
+    InfraxThread* threads[TEST_THREADS];
+    for (int i = 0; i < TEST_THREADS; i++) {
+        args[i].kv = kv;
+        args[i].id = i;
+        threads[i] = start_worker(func, &args[i]);
+    }
+    for (int i = 0; i < TEST_THREADS; i++) {
+        InfraxThreadClass.join(threads[i], NULL);
+        InfraxThreadClass.free(threads[i]);
+    }
+}
+
+// Each thread owns its keys; the table starts small, so it rehashes many times
+// while every stripe is allocating and freeing entries
+static void* rehash_worker(void* arg) {
+    test_worker_t* w = arg;
+    char key[64];
+    peerx_memkv_value_t value = {.type = PEERX_MEMKV_TYPE_INT};
+    peerx_memkv_value_t out;
+    peerx_memkv_value_init(&out);
+
+    for (int i = 0; i < TEST_KEYS_PER_THREAD; i++) {
+        snprintf(key, sizeof(key), "t%d-%d", w->id, i);
+        value.value.i = i;
+        INFRAX_ASSERT(core, w->kv->set(w->kv, key, &value) == INFRAX_OK);
+        INFRAX_ASSERT(core, w->kv->get(w->kv, key, &out) == INFRAX_OK && out.value.i == i);
+        if (i % 3 == 0) {
+            INFRAX_ASSERT(core, w->kv->del(w->kv, key) == INFRAX_OK);
+        }
+    }
+    return NULL;
+}
+
+static void test_concurrent_rehash(void) {
+    PeerxMemKV* kv = PeerxMemKVClass.new();
+    INFRAX_ASSERT(core, kv != NULL);
+
+    run_workers(kv, rehash_worker);
+
+    char key[64];
+    peerx_memkv_value_t out;
+    peerx_memkv_value_init(&out);
+    for (int t = 0; t < TEST_THREADS; t++) {
+        for (int i = 0; i < TEST_KEYS_PER_THREAD; i++) {
+            snprintf(key, sizeof(key), "t%d-%d", t, i);
+            infrax_error_t err = kv->get(kv, key, &out);
+            if (i % 3 == 0) {
+                INFRAX_ASSERT(core, err == INFRAX_ERROR_NOT_FOUND);
+            } else {
+                INFRAX_ASSERT(core, err == INFRAX_OK && out.value.i == i);
+            }
+        }
+    }
+
+    PeerxMemKVClass.free(kv);
+    core->printf(core, "Concurrent rehash test passed\n");
+}
+
+#define TEST_SHARED_KEYS 16
+#define TEST_SHARED_ROUNDS 50000
+
+// Writers keep overwriting and deleting a few shared keys, so every borrowed
+// entry is usually replaced before it is released
+static void* borrow_worker(void* arg) {
+    test_worker_t* w = arg;
+    char key[32];
+    char text[64];
+    peerx_memkv_value_t value = {.type = PEERX_MEMKV_TYPE_STRING, .value.str = text};
+    peerx_memkv_ref_t ref;
+
+    for (int i = 0; i < TEST_SHARED_ROUNDS; i++) {
+        int k = (i * 7 + w->id) % TEST_SHARED_KEYS;
+        snprintf(key, sizeof(key), "shared-%d", k);
+        if (w->id % 2 == 0) {
+            if (i % 5 == 0) {
+                INFRAX_ASSERT(core, w->kv->del(w->kv, key) != INFRAX_ERROR_NO_MEMORY);
+            } else {
+                snprintf(text, sizeof(text), "%s=%d", key, i);
+                INFRAX_ASSERT(core, w->kv->set(w->kv, key, &value) == INFRAX_OK);
+            }
+        } else if (w->kv->borrow(w->kv, key, &ref) == INFRAX_OK) {
+            // The view must still describe this key, whatever the writers did meanwhile
+            INFRAX_ASSERT(core, ref.type == PEERX_MEMKV_TYPE_STRING);
+            INFRAX_ASSERT(core, strcmp(ref.key, key) == 0);
+            INFRAX_ASSERT(core, strncmp(ref.data, key, strlen(key)) == 0);
+            INFRAX_ASSERT(core, ref.size == strlen(ref.data));
+            w->kv->release(w->kv, &ref);
+        }
+    }
+    return NULL;
+}
+
+static void test_concurrent_borrow(void) {
+    PeerxMemKV* kv = PeerxMemKVClass.new();
+    INFRAX_ASSERT(core, kv != NULL);
+
+    run_workers(kv, borrow_worker);
+
+    PeerxMemKVClass.free(kv);
+    core->printf(core, "Concurrent borrow test passed\n");
+}
+
+#define TEST_SNAPSHOT_PATH "./test_memkv.snap"
+#define TEST_SNAPSHOT_BAD_PATH "./test_memkv_bad.snap"
+#define TEST_SNAPSHOT_KEYS 20000
+// Offset of the record count in the snapshot file header
+#define TEST_SNAPSHOT_COUNT_OFFSET 16
+
+static size_t read_file(const char* path, char** data) {
+    FILE* f = fopen(path, "rb");
+    INFRAX_ASSERT(core, f != NULL);
+    fseek(f, 0, SEEK_END);
+    size_t size = (size_t)ftell(f);
+    fseek(f, 0, SEEK_SET);
+    *data = malloc(size);
+    INFRAX_ASSERT(core, *data != NULL && fread(*data, 1, size, f) == size);
+    fclose(f);
+    return size;
+}
+
+static void write_file(const char* path, const char* data, size_t size) {
+    FILE* f = fopen(path, "wb");
+    INFRAX_ASSERT(core, f != NULL);
+    INFRAX_ASSERT(core, fwrite(data, 1, size, f) == size);
+    fclose(f);
+}
+
+// A bad snapshot must be rejected and leave the instance empty
+static void assert_load_fails(const char* data, size_t size) {
+    write_file(TEST_SNAPSHOT_BAD_PATH, data, size);
+    PeerxMemKV* kv = PeerxMemKVClass.new();
+    INFRAX_ASSERT(core, kv != NULL);
+    INFRAX_ASSERT(core, kv->load(kv, TEST_SNAPSHOT_BAD_PATH) != INFRAX_OK);
+    INFRAX_ASSERT(core, !kv->exists(kv, "key-1"));
+    PeerxMemKVClass.free(kv);
+}
+
+static void test_snapshot_load(void) {
+    PeerxMemKV* kv = PeerxMemKVClass.new();
+    INFRAX_ASSERT(core, kv != NULL);
+
+    char key[64];
+    char text[64];
+    peerx_memkv_value_t value;
+    for (int i = 0; i < TEST_SNAPSHOT_KEYS; i++) {
+        snprintf(key, sizeof(key), "key-%d", i);
+        switch (i % 4) {
+            case 0:
+                value.type = PEERX_MEMKV_TYPE_INT;
+                value.value.i = -i;
+                break;
+            case 1:
+                value.type = PEERX_MEMKV_TYPE_FLOAT;
+                value.value.f = i + 0.5;
+                break;
+            case 2:
+                snprintf(text, sizeof(text), "value-%d", i);
+                value.type = PEERX_MEMKV_TYPE_STRING;
+                value.value.str = text;
+                break;
+            default:
+                value.type = PEERX_MEMKV_TYPE_BINARY;
+                value.value.bin.data = &i;
+                value.value.bin.size = sizeof(i);
+                break;
+        }
+        INFRAX_ASSERT(core, kv->set(kv, key, &value) == INFRAX_OK);
+    }
+    value.type = PEERX_MEMKV_TYPE_INT;
+    value.value.i = 1;
+    INFRAX_ASSERT(core, kv->set_ex(kv, "expiring", &value, 3600 * 1000) == INFRAX_OK);
+    INFRAX_ASSERT(core, kv->snapshot(kv, TEST_SNAPSHOT_PATH) == INFRAX_OK);
+    INFRAX_ASSERT(core, kv->snapshot_wait(kv) == INFRAX_OK);
+    PeerxMemKVClass.free(kv);
+
+    // Round trip
+    kv = PeerxMemKVClass.new();
+    INFRAX_ASSERT(core, kv != NULL);
+    INFRAX_ASSERT(core, kv->load(kv, TEST_SNAPSHOT_PATH) == INFRAX_OK);
+    peerx_memkv_ref_t ref;
+    for (int i = 0; i < TEST_SNAPSHOT_KEYS; i++) {
+        snprintf(key, sizeof(key), "key-%d", i);
+        INFRAX_ASSERT(core, kv->borrow(kv, key, &ref) == INFRAX_OK);
+        switch (i % 4) {
+            case 0:
+                INFRAX_ASSERT(core, ref.type == PEERX_MEMKV_TYPE_INT && ref.i == -i);
+                break;
+            case 1:
+                INFRAX_ASSERT(core, ref.type == PEERX_MEMKV_TYPE_FLOAT && ref.f == i + 0.5);
+                break;
+            case 2:
+                snprintf(text, sizeof(text), "value-%d", i);
+                INFRAX_ASSERT(core, ref.type == PEERX_MEMKV_TYPE_STRING && strcmp(ref.data, text) == 0);
+                break;
+            default:
+                INFRAX_ASSERT(core, ref.type == PEERX_MEMKV_TYPE_BINARY && ref.size == sizeof(i));
+                INFRAX_ASSERT(core, memcmp(ref.data, &i, sizeof(i)) == 0);
+                break;
+        }
+        kv->release(kv, &ref);
+    }
+    int64_t ttl = 0;
+    INFRAX_ASSERT(core, kv->ttl(kv, "expiring", &ttl) == INFRAX_OK && ttl > 0);
+    // Only an empty instance can load
+    INFRAX_ASSERT(core, kv->load(kv, TEST_SNAPSHOT_PATH) == INFRAX_ERROR_INVALID_STATE);
+    PeerxMemKVClass.free(kv);
+
+    char* data = NULL;
+    size_t size = read_file(TEST_SNAPSHOT_PATH, &data);
+
+    // Truncated: inside the header, inside the section table, inside the records
+    assert_load_fails(data, 8);
+    assert_load_fails(data, TEST_SNAPSHOT_COUNT_OFFSET + 40);
+    assert_load_fails(data, size / 2);
+    assert_load_fails(data, size - 1);
+
+    // Corrupt magic
+    data[0] ^= 0xff;
+    assert_load_fails(data, size);
+    data[0] ^= 0xff;
+
+    // A record count the file cannot hold, including one whose bucket sizing used to overflow
+    uint64_t count;
+    memcpy(&count, data + TEST_SNAPSHOT_COUNT_OFFSET, sizeof(count));
+    uint64_t bad_counts[] = {UINT64_MAX, (uint64_t)1 << 62, size, count + 1, count - 1};
+    for (size_t i = 0; i < sizeof(bad_counts) / sizeof(bad_counts[0]); i++) {
+        memcpy(data + TEST_SNAPSHOT_COUNT_OFFSET, &bad_counts[i], sizeof(count));
+        assert_load_fails(data, size);
+    }
+    memcpy(data + TEST_SNAPSHOT_COUNT_OFFSET, &count, sizeof(count));
+
+    // The untouched copy still loads
+    write_file(TEST_SNAPSHOT_BAD_PATH, data, size);
+    kv = PeerxMemKVClass.new();
+    INFRAX_ASSERT(core, kv != NULL);
+    INFRAX_ASSERT(core, kv->load(kv, TEST_SNAPSHOT_BAD_PATH) == INFRAX_OK);
+    INFRAX_ASSERT(core, kv->exists(kv, "key-1"));
+    PeerxMemKVClass.free(kv);
+
+    free(data);
+    remove(TEST_SNAPSHOT_PATH);
+    remove(TEST_SNAPSHOT_BAD_PATH);
+    core->printf(core, "Snapshot load test passed\n");
+}
+
+int main() {
+    core = InfraxCoreClass.singleton();
+    INFRAX_ASSERT(core, core != NULL);
+
+    core->printf(core, "===================\n");
+    core->printf(core, "Starting PeerxMemKV tests...\n");
+
+    test_concurrent_rehash();
+    test_concurrent_borrow();
+    test_snapshot_load();
+
+    core->printf(core, "All PeerxMemKV tests passed!\n");
+    core->printf(core, "===================\n");
+    return 0;
+}